@@ -0,0 +1,269 @@
+/**
+ * \file PLCompletionRanking.h
+ *
+ * \brief Liasis Python IDE completion ranking.
+ *
+ * \details This file includes the completions offered for a prefix and the
+ *          bounded, time limited ranking that selects them.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief Where a completion comes from.
+ */
+typedef NS_ENUM(uint8_t, PLCompletionSource) {
+        /**
+         * \brief A Python keyword.
+         */
+        PLCompletionSourceKeyword,
+
+        /**
+         * \brief A builtin function, type, exception, or constant.
+         */
+        PLCompletionSourceBuiltin,
+
+        /**
+         * \brief A name defined in the project's symbol index.
+         */
+        PLCompletionSourceProject,
+
+        /**
+         * \brief A module or top level name of an installed package.
+         */
+        PLCompletionSourcePackage,
+
+        /**
+         * \brief A name of the live namespace of the interpreter.
+         */
+        PLCompletionSourceNamespace,
+
+        /**
+         * \brief The number of completion sources.
+         */
+        PLCompletionSourceCount
+};
+
+/**
+ * \brief The largest score a ranking adds to the weight of a name.
+ *
+ * \details A name's score is its weight plus a bonus for matching the case of
+ *          the prefix and for being short, so no name whose weight is at most
+ *          `minimumScore - PLCompletionMaximumBonus` can enter a full
+ *          ranking.
+ */
+extern const NSUInteger PLCompletionMaximumBonus;
+
+/**
+ * \class PLCompletion \headerfile \headerfile
+ *
+ * \brief A completion of a prefix.
+ */
+@interface PLCompletion : NSObject
+
+/**
+ * \brief The completed name.
+ */
+@property (retain, readonly) NSString * name;
+
+/**
+ * \brief Where the name comes from.
+ */
+@property (readonly) PLCompletionSource source;
+
+/**
+ * \brief The score of the name. Completions with higher scores are better.
+ */
+@property (readonly) NSUInteger score;
+
+/**
+ * \brief Create a completion.
+ *
+ * \param name The completed name.
+ *
+ * \param source Where the name comes from.
+ *
+ * \param score The score of the name.
+ *
+ * \return A completion on the autorelease pool.
+ */
++(instancetype)completionWithName:(NSString *)name source:(PLCompletionSource)source score:(NSUInteger)score;
+
+@end
+
+/**
+ * \class PLCompletionRanking \headerfile \headerfile
+ *
+ * \brief Keeps the best scoring names offered for a prefix until a deadline.
+ *
+ * \details Names are offered as UTF-8 bytes and an object is only created for
+ *          a name that ranks among the best, so offering the thousands of
+ *          names matching a short prefix allocates nothing. A name offered
+ *          twice, for example by the project and the live namespace, is kept
+ *          once with its best score.
+ *
+ *          Whoever offers names must call `shouldStop` regularly and stop
+ *          when it returns YES: once the deadline passes, the ranking is
+ *          marked partial, and its best names so far are the result. A
+ *          ranking may be cancelled from any thread, but names must only be
+ *          offered from one thread at a time.
+ */
+@interface PLCompletionRanking : NSObject
+{
+        /**
+         * \brief The UTF-8 bytes of the prefix.
+         */
+        NSData * prefixData;
+
+        /**
+         * \brief The best names so far, unordered.
+         */
+        struct PLCompletionRankingMatch * matches;
+
+        /**
+         * \brief The number of best names so far.
+         */
+        NSUInteger matchCount;
+
+        /**
+         * \brief The index of the lowest scoring of the best names, once the
+         *        ranking is full.
+         */
+        NSUInteger lowest;
+}
+
+/**
+ * \brief The prefix.
+ */
+@property (retain, readonly) NSString * prefix;
+
+/**
+ * \brief The number of names kept.
+ */
+@property (readonly) NSUInteger capacity;
+
+/**
+ * \brief The time, in `CACurrentMediaTime` seconds, after which `shouldStop`
+ *        returns YES.
+ */
+@property CFTimeInterval deadline;
+
+/**
+ * \brief YES if the deadline passed before all names were offered.
+ */
+@property (readonly, getter=isPartial) BOOL partial;
+
+/**
+ * \brief YES if the ranking was cancelled.
+ */
+@property (readonly, getter=isCancelled) BOOL cancelled;
+
+/**
+ * \brief Create a ranking.
+ *
+ * \param prefix The prefix names must begin with, ignoring the case of ASCII
+ *               letters.
+ *
+ * \param capacity The number of names kept.
+ *
+ * \param deadline The time, in `CACurrentMediaTime` seconds, after which no
+ *                 more names should be offered.
+ *
+ * \return A ranking on the autorelease pool.
+ */
++(instancetype)rankingWithPrefix:(NSString *)prefix capacity:(NSUInteger)capacity deadline:(CFTimeInterval)deadline;
+
+/**
+ * \brief The UTF-8 bytes of the prefix.
+ *
+ * \return The bytes, valid as long as the ranking.
+ */
+-(const char *)prefixBytes;
+
+/**
+ * \brief The number of UTF-8 bytes of the prefix.
+ *
+ * \return The number of bytes.
+ */
+-(size_t)prefixLength;
+
+/**
+ * \brief The score a name must exceed to be kept.
+ *
+ * \return The lowest score of the best names if the ranking is full, or 0.
+ */
+-(NSUInteger)minimumScore;
+
+/**
+ * \brief Determine if names should no longer be offered.
+ *
+ * \details Marks the ranking partial if the deadline has passed.
+ *
+ * \return YES if the ranking was cancelled or the deadline has passed.
+ */
+-(BOOL)shouldStop;
+
+/**
+ * \brief Cancel the ranking, so `shouldStop` returns YES.
+ */
+-(void)cancel;
+
+/**
+ * \brief Offer a name known to begin with the prefix.
+ *
+ * \param name The UTF-8 bytes of the name.
+ *
+ * \param length The number of bytes.
+ *
+ * \param source Where the name comes from.
+ *
+ * \param weight The weight of the name, to which the ranking adds at most
+ *               `PLCompletionMaximumBonus`.
+ */
+-(void)offerName:(const char *)name length:(size_t)length source:(PLCompletionSource)source weight:(NSUInteger)weight;
+
+/**
+ * \brief Offer the names of an array that begin with the prefix.
+ *
+ * \details Stops early if `shouldStop` returns YES.
+ *
+ * \param names An array of `NSString`s.
+ *
+ * \param source Where the names come from.
+ *
+ * \param weight The weight of each name.
+ *
+ * \return NO if the ranking stopped before all names were offered.
+ */
+-(BOOL)offerNames:(NSArray *)names source:(PLCompletionSource)source weight:(NSUInteger)weight;
+
+/**
+ * \brief The best names so far.
+ *
+ * \return An array of `PLCompletion`s, best first, names with equal scores
+ *         in alphabetical order.
+ */
+-(NSArray *)completions;
+
+@end
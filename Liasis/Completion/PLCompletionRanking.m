@@ -0,0 +1,344 @@
+/**
+ * \file PLCompletionRanking.m
+ *
+ * \brief Liasis Python IDE completion ranking.
+ *
+ * \details This file includes the completions offered for a prefix and the
+ *          bounded, time limited ranking that selects them.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <QuartzCore/QuartzCore.h>
+#import "PLCompletionRanking.h"
+
+/**
+ * \brief The bonus of a name beginning with the prefix in the same case.
+ */
+static const NSUInteger PLCompletionRankingExactCaseBonus = 64;
+
+/**
+ * \brief The bonus of a name no longer than the prefix, decreasing by one for
+ *        each additional byte.
+ */
+static const NSUInteger PLCompletionRankingShortnessBonus = 32;
+
+const NSUInteger PLCompletionMaximumBonus = PLCompletionRankingExactCaseBonus + PLCompletionRankingShortnessBonus;
+
+/**
+ * \brief The number of names of an array offered between checks of the
+ *        deadline.
+ */
+static const NSUInteger PLCompletionRankingCheckInterval = 64;
+
+/**
+ * \brief One of the best names of a ranking.
+ */
+struct PLCompletionRankingMatch {
+        NSUInteger score;
+        NSString * name;
+        char * bytes;
+        size_t length;
+        PLCompletionSource source;
+};
+
+typedef struct PLCompletionRankingMatch PLCompletionRankingMatch;
+
+/**
+ * \brief Lowercase an ASCII letter.
+ */
+static inline uint8_t PLCompletionRankingLowercase(uint8_t character)
+{
+        return (character >= 'A' && character <= 'Z') ? (uint8_t)(character + ('a' - 'A')) : character;
+}
+
+/**
+ * \brief Find the lowest scoring of some matches.
+ *
+ * \return The index of the match.
+ */
+static NSUInteger PLCompletionRankingLowestMatch(const PLCompletionRankingMatch * matches, NSUInteger count)
+{
+        NSUInteger i = 0, lowest = 0;
+
+        for (i = 1; i < count; i++) {
+                if (matches[i].score < matches[lowest].score) {
+                        lowest = i;
+                }
+        }
+        return lowest;
+}
+
+#pragma mark -
+
+@implementation PLCompletion
+
+-(instancetype)initWithName:(NSString *)name source:(PLCompletionSource)source score:(NSUInteger)score
+{
+        self = [super init];
+        if (self) {
+                _name = [name retain];
+                _source = source;
+                _score = score;
+        }
+        return self;
+}
+
++(instancetype)completionWithName:(NSString *)name source:(PLCompletionSource)source score:(NSUInteger)score
+{
+        return [[[self alloc] initWithName:name source:source score:score] autorelease];
+}
+
+-(void)dealloc
+{
+        [_name release];
+        [super dealloc];
+}
+
+-(NSString *)description
+{
+        return [NSString stringWithFormat:@"<%@ %@ (%lu)>", [self class], self.name, (unsigned long)self.score];
+}
+
+@end
+
+#pragma mark -
+
+@interface PLCompletionRanking ()
+
+@property (readwrite, getter=isPartial) BOOL partial;
+
+@property (readwrite, getter=isCancelled) BOOL cancelled;
+
+@end
+
+@implementation PLCompletionRanking
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Initialize a ranking.
+ *
+ * \param prefix The prefix names must begin with.
+ *
+ * \param capacity The number of names kept.
+ *
+ * \param deadline The time after which no more names should be offered.
+ *
+ * \return The initialized ranking.
+ */
+-(instancetype)initWithPrefix:(NSString *)prefix capacity:(NSUInteger)capacity deadline:(CFTimeInterval)deadline
+{
+        self = [super init];
+        if (self) {
+                _prefix = [prefix copy];
+                _capacity = MAX(capacity, 1);
+                _deadline = deadline;
+                prefixData = [[prefix dataUsingEncoding:NSUTF8StringEncoding] retain];
+                matches = calloc(_capacity, sizeof(PLCompletionRankingMatch));
+        }
+        return self;
+}
+
++(instancetype)rankingWithPrefix:(NSString *)prefix capacity:(NSUInteger)capacity deadline:(CFTimeInterval)deadline
+{
+        return [[[self alloc] initWithPrefix:prefix capacity:capacity deadline:deadline] autorelease];
+}
+
+-(void)dealloc
+{
+        NSUInteger i = 0;
+
+        for (i = 0; i < matchCount; i++) {
+                [matches[i].name release];
+                free(matches[i].bytes);
+        }
+        free(matches);
+        [prefixData release];
+        [_prefix release];
+        [super dealloc];
+}
+
+#pragma mark - Budget
+
+-(const char *)prefixBytes
+{
+        return [prefixData bytes];
+}
+
+-(size_t)prefixLength
+{
+        return [prefixData length];
+}
+
+-(NSUInteger)minimumScore
+{
+        return (matchCount == _capacity) ? matches[lowest].score : 0;
+}
+
+-(BOOL)shouldStop
+{
+        if (self.cancelled == NO && self.partial == NO && CACurrentMediaTime() > self.deadline) {
+                self.partial = YES;
+        }
+        return self.cancelled || self.partial;
+}
+
+-(void)cancel
+{
+        self.cancelled = YES;
+}
+
+#pragma mark - Ranking
+
+/**
+ * \brief Find a kept name.
+ *
+ * \return The index of the match of the name, or `NSNotFound`.
+ */
+-(NSUInteger)indexOfMatchWithName:(const char *)name length:(size_t)length
+{
+        NSUInteger i = 0, index = NSNotFound;
+
+        for (i = 0; i < matchCount; i++) {
+                if (matches[i].length == length && memcmp(matches[i].bytes, name, length) == 0) {
+                        index = i;
+                        break;
+                }
+        }
+        return index;
+}
+
+-(void)offerName:(const char *)name length:(size_t)length source:(PLCompletionSource)source weight:(NSUInteger)weight
+{
+        size_t prefixLength = [prefixData length];
+        NSUInteger score = weight, index = 0;
+        PLCompletionRankingMatch * match = NULL;
+
+        if (memcmp(name, [prefixData bytes], prefixLength) == 0) {
+                score += PLCompletionRankingExactCaseBonus;
+        }
+        score += PLCompletionRankingShortnessBonus - MIN(length - prefixLength, PLCompletionRankingShortnessBonus);
+        if (matchCount == _capacity && score <= matches[lowest].score) {
+                goto exit;
+        }
+
+        index = [self indexOfMatchWithName:name length:length];
+        if (index != NSNotFound) {
+                match = &matches[index];
+                if (score > match->score) {
+                        match->score = score;
+                        match->source = source;
+                }
+        } else {
+                if (matchCount < _capacity) {
+                        match = &matches[matchCount];
+                        matchCount++;
+                } else {
+                        match = &matches[lowest];
+                        [match->name release];
+                        free(match->bytes);
+                }
+                match->score = score;
+                match->source = source;
+                match->length = length;
+                match->bytes = malloc(MAX(length, 1));
+                memcpy(match->bytes, name, length);
+                match->name = [[NSString alloc] initWithBytes:name length:length encoding:NSUTF8StringEncoding];
+        }
+        if (matchCount == _capacity) {
+                lowest = PLCompletionRankingLowestMatch(matches, matchCount);
+        }
+
+exit:
+        return;
+}
+
+-(BOOL)offerNames:(NSArray *)names source:(PLCompletionSource)source weight:(NSUInteger)weight
+{
+        const uint8_t * prefix = [prefixData bytes];
+        size_t prefixLength = [prefixData length], length = 0, i = 0;
+        const char * name = NULL;
+        NSUInteger offered = 0;
+        BOOL complete = YES;
+
+        for (NSString * nameString in names) {
+                if (++offered % PLCompletionRankingCheckInterval == 0 && [self shouldStop]) {
+                        complete = NO;
+                        break;
+                }
+                name = [nameString UTF8String];
+                length = (name != NULL) ? strlen(name) : 0;
+                if (length < prefixLength) {
+                        continue;
+                }
+                for (i = 0; i < prefixLength; i++) {
+                        if (PLCompletionRankingLowercase((uint8_t)name[i]) != PLCompletionRankingLowercase(prefix[i])) {
+                                break;
+                        }
+                }
+                if (i == prefixLength) {
+                        [self offerName:name length:length source:source weight:weight];
+                }
+        }
+        return complete;
+}
+
+/**
+ * \brief Order matches best first, then alphabetically.
+ */
+static int PLCompletionRankingCompareMatches(const void * first, const void * second)
+{
+        const PLCompletionRankingMatch * firstMatch = first, * secondMatch = second;
+        int order = 0;
+
+        if (firstMatch->score != secondMatch->score) {
+                order = (firstMatch->score > secondMatch->score) ? -1 : 1;
+        } else {
+                order = memcmp(firstMatch->bytes, secondMatch->bytes, MIN(firstMatch->length, secondMatch->length));
+                if (order == 0 && firstMatch->length != secondMatch->length) {
+                        order = (firstMatch->length < secondMatch->length) ? -1 : 1;
+                }
+        }
+        return order;
+}
+
+-(NSArray *)completions
+{
+        NSMutableArray * completions = [NSMutableArray arrayWithCapacity:matchCount];
+        PLCompletionRankingMatch * sortedMatches = malloc(MAX(matchCount, 1) * sizeof(PLCompletionRankingMatch));
+        NSUInteger i = 0;
+
+        memcpy(sortedMatches, matches, matchCount * sizeof(PLCompletionRankingMatch));
+        qsort(sortedMatches, matchCount, sizeof(PLCompletionRankingMatch), PLCompletionRankingCompareMatches);
+        for (i = 0; i < matchCount; i++) {
+                if (sortedMatches[i].name != nil) {
+                        [completions addObject:[PLCompletion completionWithName:sortedMatches[i].name
+                                                                         source:sortedMatches[i].source
+                                                                          score:sortedMatches[i].score]];
+                }
+        }
+        free(sortedMatches);
+        return completions;
+}
+
+@end
@@ -0,0 +1,215 @@
+/**
+ * \file PLCompletionService.h
+ *
+ * \brief Liasis Python IDE completion service.
+ *
+ * \details This file includes the service completing Python names for the
+ *          editor and interpreter tabs without blocking the main thread.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+#import "PLCompletionRanking.h"
+#import "PLCompletionTrie.h"
+
+/**
+ * \brief The block called with the completions of a request.
+ *
+ * \param completions An array of `PLCompletion`s, best first.
+ *
+ * \param partial YES if the ranking ran out of time, so better completions
+ *                may exist.
+ *
+ * \param final YES if no more results follow for the request.
+ */
+typedef void (^PLCompletionHandler)(NSArray * completions, BOOL partial, BOOL final);
+
+/**
+ * \class PLCompletionRequest \headerfile \headerfile
+ *
+ * \brief A request for the completions of some text.
+ */
+@interface PLCompletionRequest : NSObject
+
+/**
+ * \brief The text completed.
+ */
+@property (retain, readonly) NSString * text;
+
+/**
+ * \brief The project directory whose symbols are completed, or nil.
+ */
+@property (retain, readonly) NSString * directoryPath;
+
+/**
+ * \brief Cancel the request, so its handler is not called again.
+ *
+ * \details Must be called on the main thread.
+ */
+-(void)cancel;
+
+/**
+ * \brief Determine if the request was cancelled.
+ *
+ * \return YES if the request was cancelled.
+ */
+-(BOOL)isCancelled;
+
+@end
+
+/**
+ * \class PLCompletionService \headerfile \headerfile
+ *
+ * \brief Completes Python names from prefix tries and the live namespace.
+ *
+ * \details Keywords, builtins, the modules of the `PLModuleIndex`, and the
+ *          names defined in each project's `PLSymbolIndex` are held in
+ *          `PLCompletionTrie`s, built on a background queue and rebuilt when
+ *          an index changes. A request ranks the tries on a serial queue under
+ *          a budget of a few milliseconds, adds the submodules and top level
+ *          names of the module being completed, if any, and calls its handler
+ *          with the best names found in time, marked partial if the budget ran
+ *          out.
+ *
+ *          If the interpreter is running, the names of its `__main__`
+ *          namespace, or the attributes of the dotted expression being
+ *          completed, are then read on another queue and merged into the
+ *          same ranking, and the handler is called again. The main thread
+ *          never waits for the interpreter.
+ *
+ *          Each request cancels the previous one, so the requests made while
+ *          typing never queue up behind each other: a stale request stops
+ *          ranking at its next check and never reaches the interpreter.
+ */
+@interface PLCompletionService : NSObject
+{
+        /**
+         * \brief The serial queue on which tries are built.
+         */
+        dispatch_queue_t buildQueue;
+
+        /**
+         * \brief The serial queue on which requests are ranked.
+         */
+        dispatch_queue_t rankingQueue;
+
+        /**
+         * \brief The serial queue on which the live namespace is read.
+         */
+        dispatch_queue_t namespaceQueue;
+
+        /**
+         * \brief The trie of the keywords, builtins, and modules, or nil until
+         *        built.
+         */
+        PLCompletionTrie * baseTrie;
+
+        /**
+         * \brief The tries of the names of the projects, by directory path.
+         */
+        NSMutableDictionary * projectTries;
+
+        /**
+         * \brief The directories prepared, whose symbol indexes are observed.
+         */
+        NSMutableSet * preparedDirectories;
+
+        /**
+         * \brief The directories whose tries are queued to be built.
+         */
+        NSMutableSet * pendingDirectories;
+
+        /**
+         * \brief The most recent request, until it is finished.
+         */
+        PLCompletionRequest * currentRequest;
+
+        /**
+         * \brief The latest latencies of first results, in seconds.
+         */
+        CFTimeInterval * latencies;
+
+        /**
+         * \brief The number of requests whose first results were delivered.
+         */
+        NSUInteger answeredCount;
+
+        /**
+         * \brief The number of those whose first results were partial.
+         */
+        NSUInteger partialCount;
+}
+
+/**
+ * \brief The shared service.
+ *
+ * \return The completion service of the application.
+ */
++(instancetype)sharedService;
+
+/**
+ * \brief Start building the trie of a project's names in the background.
+ *
+ * \details Requests for the directory complete its names once the trie is
+ *          built, and it is rebuilt whenever the project's symbol index is
+ *          updated, until the index is evicted. Does nothing if the trie is
+ *          built or being built.
+ *
+ * \param directoryPath The project directory.
+ */
+-(void)prepareForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Complete some text asynchronously.
+ *
+ * \details Must be called on the main thread. Cancels the previous request.
+ *          The handler is called on the main thread, once with the names of
+ *          the tries and, if the interpreter is running, once more with the
+ *          names of the live namespace merged in. It is not called after the
+ *          request is cancelled.
+ *
+ * \param text The name, or dotted name, before the insertion point.
+ *
+ * \param directoryPath The project directory whose names are completed, or
+ *                      nil.
+ *
+ * \param maximumCount The maximum number of completions.
+ *
+ * \param handler The block called with the completions.
+ *
+ * \return The request.
+ */
+-(PLCompletionRequest *)requestCompletionsOfText:(NSString *)text
+                               inDirectoryAtPath:(NSString *)directoryPath
+                                    maximumCount:(NSUInteger)maximumCount
+                                         handler:(PLCompletionHandler)handler;
+
+/**
+ * \brief Cancel the current request, for example when the insertion point
+ *        moves away.
+ *
+ * \details Must be called on the main thread.
+ */
+-(void)cancelCurrentRequest;
+
+@end
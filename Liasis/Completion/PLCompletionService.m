@@ -0,0 +1,734 @@
+/**
+ * \file PLCompletionService.m
+ *
+ * \brief Liasis Python IDE completion service.
+ *
+ * \details This file includes the service completing Python names for the
+ *          editor and interpreter tabs without blocking the main thread.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Python/Python.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLCompletionService.h"
+#import "PLUserDefaults.h"
+#import "PLModuleIndex.h"
+#import "PLPythonRuntime.h"
+#import "PLSymbolIndex.h"
+
+/**
+ * \brief The time a request may take to deliver its first results, from the
+ *        moment it is made, in seconds.
+ */
+static const CFTimeInterval PLCompletionServiceRankingBudget = 0.005;
+
+/**
+ * \brief The time the names of the live namespace may take to be merged into
+ *        the results, once they are read, in seconds.
+ */
+static const CFTimeInterval PLCompletionServiceNamespaceBudget = 0.005;
+
+/**
+ * \brief The number of latencies kept for the percentiles.
+ */
+static const NSUInteger PLCompletionServiceLatencyCount = 1000;
+
+/**
+ * \brief The number of requests between two logs of the percentiles.
+ */
+static const NSUInteger PLCompletionServiceLatencyLogInterval = 100;
+
+/**
+ * \brief The weights of the names of each source.
+ *
+ * \details Names of the live namespace come first, as they exist right now,
+ *          then the top level definitions of the project, then builtins, the
+ *          members of imported modules, keywords, and module names, then nested
+ *          definitions. A name of the project gains one
+ *          for each file using it, up to
+ *          `PLCompletionServiceMaximumReferenceWeight`, and names beginning
+ *          with an underscore, or modules with such a component, have half the
+ *          weight of their source.
+ */
+static const NSUInteger PLCompletionServiceNamespaceWeight = 400;
+static const NSUInteger PLCompletionServiceTopLevelDefinitionWeight = 320;
+static const NSUInteger PLCompletionServiceTopLevelVariableWeight = 300;
+static const NSUInteger PLCompletionServiceBuiltinWeight = 280;
+static const NSUInteger PLCompletionServiceModuleMemberWeight = 270;
+static const NSUInteger PLCompletionServiceKeywordWeight = 260;
+static const NSUInteger PLCompletionServiceModuleWeight = 240;
+static const NSUInteger PLCompletionServiceNestedDefinitionWeight = 200;
+static const NSUInteger PLCompletionServiceMaximumReferenceWeight = 63;
+
+/**
+ * \brief The keywords of Python 2 and 3.
+ */
+static const char * const PLCompletionServiceKeywords[] = {
+        "and", "as", "assert", "break", "class", "continue", "def", "del",
+        "elif", "else", "except", "exec", "finally", "for", "from", "global",
+        "if", "import", "in", "is", "lambda", "nonlocal", "not", "or", "pass",
+        "print", "raise", "return", "try", "while", "with", "yield"
+};
+
+/**
+ * \brief The builtin functions, types, exceptions, and constants of Python 2
+ *        and 3.
+ */
+static const char * const PLCompletionServiceBuiltins[] = {
+        "False", "None", "NotImplemented", "Ellipsis", "True", "__debug__",
+        "__import__", "abs", "all", "any", "apply", "ascii", "basestring",
+        "bin", "bool", "buffer", "bytearray", "bytes", "callable", "chr",
+        "classmethod", "cmp", "coerce", "compile", "complex", "delattr",
+        "dict", "dir", "divmod", "enumerate", "eval", "execfile", "exit",
+        "file", "filter", "float", "format", "frozenset", "getattr", "globals",
+        "hasattr", "hash", "help", "hex", "id", "input", "int", "intern",
+        "isinstance", "issubclass", "iter", "len", "list", "locals", "long",
+        "map", "max", "memoryview", "min", "next", "object", "oct", "open",
+        "ord", "pow", "property", "quit", "range", "raw_input", "reduce",
+        "reload", "repr", "reversed", "round", "set", "setattr", "slice",
+        "sorted", "staticmethod", "str", "sum", "super", "tuple", "type",
+        "unichr", "unicode", "vars", "xrange", "zip",
+        "ArithmeticError", "AssertionError", "AttributeError", "BaseException",
+        "BufferError", "BytesWarning", "DeprecationWarning", "EOFError",
+        "EnvironmentError", "Exception", "FloatingPointError", "FutureWarning",
+        "GeneratorExit", "IOError", "ImportError", "ImportWarning",
+        "IndentationError", "IndexError", "KeyError", "KeyboardInterrupt",
+        "LookupError", "MemoryError", "NameError", "NotImplementedError",
+        "OSError", "OverflowError", "PendingDeprecationWarning",
+        "ReferenceError", "RuntimeError", "RuntimeWarning", "StandardError",
+        "StopIteration", "SyntaxError", "SyntaxWarning", "SystemError",
+        "SystemExit", "TabError", "TypeError", "UnboundLocalError",
+        "UnicodeDecodeError", "UnicodeEncodeError", "UnicodeError",
+        "UnicodeTranslateError", "UnicodeWarning", "UserWarning", "ValueError",
+        "Warning", "ZeroDivisionError"
+};
+
+/**
+ * \brief The name of the module of the builtins.
+ */
+#if PY_MAJOR_VERSION >= 3
+static const char * const PLCompletionServiceBuiltinsModule = "builtins";
+#else
+static const char * const PLCompletionServiceBuiltinsModule = "__builtin__";
+#endif
+
+/**
+ * \brief The weight of a name of a project.
+ *
+ * \param name The UTF-8 bytes of the name.
+ *
+ * \param kind The kind of its first definition.
+ *
+ * \param topLevel YES if its first definition is at the top level.
+ *
+ * \param referenceCount The number of files using the name.
+ *
+ * \return The weight.
+ */
+static NSUInteger PLCompletionServiceProjectWeight(const char * name, PLPythonSymbolKind kind, BOOL topLevel, NSUInteger referenceCount)
+{
+        NSUInteger weight = PLCompletionServiceNestedDefinitionWeight;
+
+        if (topLevel) {
+                weight = (kind == PLPythonSymbolVariable) ? PLCompletionServiceTopLevelVariableWeight : PLCompletionServiceTopLevelDefinitionWeight;
+        }
+        weight += MIN(referenceCount, PLCompletionServiceMaximumReferenceWeight);
+        if (name[0] == '_') {
+                weight /= 2;
+        }
+        return weight;
+}
+
+/**
+ * \brief Determine if a dotted name has a component beginning with an
+ *        underscore.
+ */
+static BOOL PLCompletionServiceIsPrivateModule(const char * name, size_t length)
+{
+        size_t i = 0;
+        BOOL isPrivate = NO;
+
+        for (i = 0; i < length && isPrivate == NO; i++) {
+                isPrivate = (name[i] == '_' && (i == 0 || name[i - 1] == '.'));
+        }
+        return isPrivate;
+}
+
+/**
+ * \brief Prefix names with the dotted expression they are attributes of.
+ *
+ * \param qualifier The expression followed by a dot, or an empty string.
+ *
+ * \param names The names.
+ *
+ * \return An array of qualified names.
+ */
+static NSArray * PLCompletionServiceQualifiedNames(NSString * qualifier, NSArray * names)
+{
+        NSMutableArray * qualifiedNames = [NSMutableArray arrayWithCapacity:[names count]];
+
+        for (NSString * name in names) {
+                [qualifiedNames addObject:[qualifier stringByAppendingString:name]];
+        }
+        return qualifiedNames;
+}
+
+/**
+ * \brief Read the names of the live namespace.
+ *
+ * \details Must be called while holding the GIL. The object of a dotted
+ *          expression is found by looking up one attribute at a time, from
+ *          `__main__` or the builtins, so no code typed by the user is
+ *          evaluated.
+ *
+ * \param components The names of the dotted expression whose attributes are
+ *                   read, or an empty array for the names of `__main__`.
+ *
+ * \return An array of names, or nil if the expression could not be resolved.
+ */
+static NSArray * PLCompletionServiceNamespaceNames(NSArray * components)
+{
+        PyObject * object = PyImport_AddModule("__main__"), * attribute = NULL, * names = NULL, * name = NULL;
+        NSMutableArray * nameStrings = nil;
+        const char * nameBytes = NULL;
+        NSUInteger componentIndex = 0;
+        Py_ssize_t i = 0;
+
+        if (object == NULL) {
+                PyErr_Clear();
+                goto exit;
+        }
+        Py_INCREF(object);
+        for (NSString * component in components) {
+                attribute = PyObject_GetAttrString(object, [component UTF8String]);
+                if (attribute == NULL && componentIndex == 0) {
+                        PyErr_Clear();
+                        attribute = PyObject_GetAttrString(PyImport_AddModule(PLCompletionServiceBuiltinsModule), [component UTF8String]);
+                }
+                Py_DECREF(object);
+                object = attribute;
+                if (object == NULL) {
+                        PyErr_Clear();
+                        goto exit;
+                }
+                componentIndex++;
+        }
+        names = PyObject_Dir(object);
+        if (names == NULL || PyList_Check(names) == 0) {
+                PyErr_Clear();
+                goto exit;
+        }
+        nameStrings = [NSMutableArray arrayWithCapacity:PyList_Size(names)];
+        for (i = 0; i < PyList_Size(names); i++) {
+                name = PyList_GetItem(names, i);
+#if PY_MAJOR_VERSION >= 3
+                nameBytes = PyUnicode_Check(name) ? PyUnicode_AsUTF8(name) : NULL;
+#else
+                nameBytes = PyString_Check(name) ? PyString_AsString(name) : NULL;
+#endif
+                if (nameBytes == NULL) {
+                        PyErr_Clear();
+                        continue;
+                }
+                [nameStrings addObject:[NSString stringWithUTF8String:nameBytes]];
+        }
+
+exit:
+        Py_XDECREF(names);
+        Py_XDECREF(object);
+        return nameStrings;
+}
+
+/**
+ * \brief Order latencies.
+ */
+static int PLCompletionServiceCompareLatencies(const void * first, const void * second)
+{
+        CFTimeInterval firstLatency = *(const CFTimeInterval *)first, secondLatency = *(const CFTimeInterval *)second;
+
+        return (firstLatency > secondLatency) - (firstLatency < secondLatency);
+}
+
+#pragma mark -
+
+@interface PLCompletionRequest ()
+
+/**
+ * \brief The ranking of the request.
+ */
+@property (retain) PLCompletionRanking * ranking;
+
+/**
+ * \brief The block called with the completions.
+ */
+@property (copy) PLCompletionHandler handler;
+
+/**
+ * \brief The time the request was made, in `CACurrentMediaTime` seconds.
+ */
+@property CFTimeInterval startTime;
+
+/**
+ * \brief YES once the first results were delivered.
+ */
+@property BOOL answered;
+
+/**
+ * \brief YES once the request was cancelled.
+ */
+@property BOOL cancelled;
+
+@end
+
+@implementation PLCompletionRequest
+
+-(instancetype)initWithText:(NSString *)text directoryPath:(NSString *)directoryPath
+{
+        self = [super init];
+        if (self) {
+                _text = [text copy];
+                _directoryPath = [directoryPath copy];
+                _startTime = CACurrentMediaTime();
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [_text release];
+        [_directoryPath release];
+        [_ranking release];
+        [_handler release];
+        [super dealloc];
+}
+
+-(void)cancel
+{
+        self.cancelled = YES;
+        [self.ranking cancel];
+}
+
+-(BOOL)isCancelled
+{
+        return self.cancelled;
+}
+
+@end
+
+#pragma mark -
+
+@implementation PLCompletionService
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                buildQueue = dispatch_queue_create("org.liasis.completion.build", DISPATCH_QUEUE_SERIAL);
+                dispatch_set_target_queue(buildQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0));
+                rankingQueue = dispatch_queue_create("org.liasis.completion.ranking", DISPATCH_QUEUE_SERIAL);
+                dispatch_set_target_queue(rankingQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0));
+                namespaceQueue = dispatch_queue_create("org.liasis.completion.namespace", DISPATCH_QUEUE_SERIAL);
+                projectTries = [[NSMutableDictionary alloc] init];
+                preparedDirectories = [[NSMutableSet alloc] init];
+                pendingDirectories = [[NSMutableSet alloc] init];
+                latencies = calloc(PLCompletionServiceLatencyCount, sizeof(CFTimeInterval));
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(moduleIndexDidUpdate:)
+                                                             name:PLModuleIndexDidUpdateNotification
+                                                           object:[PLModuleIndex sharedIndex]];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(symbolIndexDidClose:)
+                                                             name:PLSymbolIndexDidCloseNotification
+                                                           object:nil];
+                [self buildBaseTrie];
+        }
+        return self;
+}
+
++(instancetype)sharedService
+{
+        static PLCompletionService * sharedService = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedService = [[self alloc] init];
+        });
+        return sharedService;
+}
+
+-(void)dealloc
+{
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [currentRequest cancel];
+        [currentRequest release];
+        dispatch_release(buildQueue);
+        dispatch_release(rankingQueue);
+        dispatch_release(namespaceQueue);
+        [baseTrie release];
+        [projectTries release];
+        [preparedDirectories release];
+        [pendingDirectories release];
+        free(latencies);
+        [super dealloc];
+}
+
+#pragma mark - Tries
+
+/**
+ * \brief Build the trie of the keywords, builtins, and importable modules on
+ *        the build queue.
+ */
+-(void)buildBaseTrie
+{
+        dispatch_async(buildQueue, ^{
+                PLCompletionTrieBuilder * builder = [PLCompletionTrieBuilder builder];
+                PLCompletionTrie * trie = nil;
+                CFTimeInterval startTime = CACurrentMediaTime();
+
+                [builder addNames:PLCompletionServiceKeywords
+                            count:sizeof(PLCompletionServiceKeywords) / sizeof(PLCompletionServiceKeywords[0])
+                           source:PLCompletionSourceKeyword
+                           weight:PLCompletionServiceKeywordWeight];
+                [builder addNames:PLCompletionServiceBuiltins
+                            count:sizeof(PLCompletionServiceBuiltins) / sizeof(PLCompletionServiceBuiltins[0])
+                           source:PLCompletionSourceBuiltin
+                           weight:PLCompletionServiceBuiltinWeight];
+                [[PLModuleIndex sharedIndex] enumerateModuleNamesUsingBlock:^(const char * name, size_t length) {
+                        [builder addName:name
+                                  length:length
+                                  source:PLCompletionSourcePackage
+                                  weight:(PLCompletionServiceIsPrivateModule(name, length) ? PLCompletionServiceModuleWeight / 2 : PLCompletionServiceModuleWeight)];
+                }];
+                trie = [builder trie];
+                @synchronized(self) {
+                        [baseTrie release];
+                        baseTrie = [trie retain];
+                }
+                if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                        NSLog(@"Completion: built trie of %lu keywords, builtins, and modules in %.2f ms",
+                              (unsigned long)[trie count],
+                              (CACurrentMediaTime() - startTime) * 1000.0);
+                }
+        });
+}
+
+/**
+ * \brief Rebuild the base trie when the importable modules changed.
+ *
+ * \param notification The `PLModuleIndexDidUpdateNotification`.
+ */
+-(void)moduleIndexDidUpdate:(NSNotification *)notification
+{
+        [self buildBaseTrie];
+}
+
+/**
+ * \brief Build the trie of the names of a project on the build queue.
+ *
+ * \details Does nothing if a build of the project is already queued, as it
+ *          reads the index when it starts. The index is looked up, and the
+ *          trie stored, on the main thread, which owns the shared symbol
+ *          indexes, so a trie finished after its index was evicted is
+ *          dropped.
+ *
+ * \param directoryPath The project directory.
+ */
+-(void)buildTrieOfDirectoryAtPath:(NSString *)directoryPath
+{
+        PLSymbolIndex * index = nil;
+
+        @synchronized(self) {
+                if ([pendingDirectories containsObject:directoryPath]) {
+                        goto exit;
+                }
+                [pendingDirectories addObject:directoryPath];
+        }
+        index = [PLSymbolIndex indexForDirectoryAtPath:directoryPath];
+        dispatch_async(buildQueue, ^{
+                PLCompletionTrieBuilder * builder = [PLCompletionTrieBuilder builder];
+                PLCompletionTrie * trie = nil;
+                CFTimeInterval startTime = CACurrentMediaTime();
+
+                @synchronized(self) {
+                        [pendingDirectories removeObject:directoryPath];
+                }
+                [index enumerateDefinedNamesUsingBlock:^(const char * name, size_t length, PLPythonSymbolKind kind, BOOL topLevel, NSUInteger referenceCount) {
+                        [builder addName:name
+                                  length:length
+                                  source:PLCompletionSourceProject
+                                  weight:PLCompletionServiceProjectWeight(name, kind, topLevel, referenceCount)];
+                }];
+                trie = [builder trie];
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        if ([preparedDirectories containsObject:directoryPath]) {
+                                @synchronized(self) {
+                                        [projectTries setObject:trie forKey:directoryPath];
+                                }
+                        }
+                });
+                if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                        NSLog(@"Completion: built trie of %lu names of %@ in %.2f ms",
+                              (unsigned long)[trie count],
+                              directoryPath,
+                              (CACurrentMediaTime() - startTime) * 1000.0);
+                }
+        });
+
+exit:
+        return;
+}
+
+-(void)prepareForDirectoryAtPath:(NSString *)directoryPath
+{
+        if (directoryPath == nil || [preparedDirectories containsObject:directoryPath]) {
+                goto exit;
+        }
+        [preparedDirectories addObject:directoryPath];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(symbolIndexDidUpdate:)
+                                                     name:PLSymbolIndexDidUpdateNotification
+                                                   object:[PLSymbolIndex indexForDirectoryAtPath:directoryPath]];
+        [self buildTrieOfDirectoryAtPath:directoryPath];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Rebuild the trie of a project whose symbol index changed.
+ *
+ * \param notification The `PLSymbolIndexDidUpdateNotification`.
+ */
+-(void)symbolIndexDidUpdate:(NSNotification *)notification
+{
+        [self buildTrieOfDirectoryAtPath:[(PLSymbolIndex *)[notification object] directoryPath]];
+}
+
+/**
+ * \brief Drop the trie of a project whose symbol index was evicted.
+ *
+ * \details The project is prepared again, with a new index, by the next
+ *          request for it.
+ *
+ * \param notification The `PLSymbolIndexDidCloseNotification`.
+ */
+-(void)symbolIndexDidClose:(NSNotification *)notification
+{
+        PLSymbolIndex * index = [notification object];
+
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:PLSymbolIndexDidUpdateNotification object:index];
+        [preparedDirectories removeObject:[index directoryPath]];
+        @synchronized(self) {
+                [projectTries removeObjectForKey:[index directoryPath]];
+        }
+}
+
+#pragma mark - Requests
+
+-(PLCompletionRequest *)requestCompletionsOfText:(NSString *)text
+                               inDirectoryAtPath:(NSString *)directoryPath
+                                    maximumCount:(NSUInteger)maximumCount
+                                         handler:(PLCompletionHandler)handler
+{
+        PLCompletionRequest * request = [[[PLCompletionRequest alloc] initWithText:text directoryPath:directoryPath] autorelease];
+        PLCompletionRanking * ranking = [PLCompletionRanking rankingWithPrefix:text
+                                                                      capacity:maximumCount
+                                                                      deadline:request.startTime + PLCompletionServiceRankingBudget];
+        NSMutableArray * tries = [NSMutableArray arrayWithCapacity:2];
+        NSRange lastDot = [text rangeOfString:@"." options:NSBackwardsSearch];
+        NSString * moduleName = (lastDot.location != NSNotFound) ? [text substringToIndex:lastDot.location] : nil;
+
+        request.ranking = ranking;
+        request.handler = handler;
+        [self cancelCurrentRequest];
+        currentRequest = [request retain];
+
+        [self prepareForDirectoryAtPath:directoryPath];
+        @synchronized(self) {
+                if (baseTrie != nil) {
+                        [tries addObject:baseTrie];
+                }
+                if (directoryPath != nil && [projectTries objectForKey:directoryPath] != nil) {
+                        [tries addObject:[projectTries objectForKey:directoryPath]];
+                }
+        }
+
+        dispatch_async(rankingQueue, ^{
+                NSArray * completions = nil;
+                BOOL partial = NO, live = NO, complete = YES;
+
+                for (PLCompletionTrie * trie in tries) {
+                        complete = [trie rankCompletionsWithRanking:ranking];
+                        if (complete == NO) {
+                                break;
+                        }
+                }
+                if (complete && [moduleName length] > 0) {
+                        [ranking offerNames:PLCompletionServiceQualifiedNames([moduleName stringByAppendingString:@"."],
+                                                                              [[PLModuleIndex sharedIndex] membersOfModuleNamed:moduleName])
+                                     source:PLCompletionSourcePackage
+                                     weight:PLCompletionServiceModuleMemberWeight];
+                }
+                if ([ranking isCancelled]) {
+                        return;
+                }
+                completions = [ranking completions];
+                partial = [ranking isPartial];
+                live = [[PLPythonRuntime sharedRuntime] isReady];
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        [self deliverCompletions:completions partial:partial final:(live == NO) ofRequest:request];
+                });
+                if (live) {
+                        [self mergeNamespaceIntoRequest:request];
+                }
+        });
+        return request;
+}
+
+/**
+ * \brief Read the live namespace for a request on the namespace queue, then
+ *        merge its names into the request's ranking on the ranking queue.
+ *
+ * \param request The request.
+ */
+-(void)mergeNamespaceIntoRequest:(PLCompletionRequest *)request
+{
+        dispatch_async(namespaceQueue, ^{
+                PLCompletionRanking * ranking = request.ranking;
+                NSArray * components = [request.text componentsSeparatedByString:@"."];
+                NSString * qualifier = nil;
+                NSArray * names = nil;
+                __block NSArray * namespaceNames = nil;
+
+                if ([ranking isCancelled]) {
+                        return;
+                }
+                components = [components subarrayWithRange:NSMakeRange(0, [components count] - 1)];
+                qualifier = ([components count] > 0) ? [[components componentsJoinedByString:@"."] stringByAppendingString:@"."] : @"";
+                if ([components containsObject:@""] == NO) {
+                        [[PLPythonRuntime sharedRuntime] performWithGIL:^{
+                                namespaceNames = [PLCompletionServiceNamespaceNames(components) retain];
+                        }];
+                }
+                names = namespaceNames;
+
+                dispatch_async(rankingQueue, ^{
+                        NSArray * completions = nil;
+                        BOOL partial = NO;
+
+                        if ([ranking isCancelled] == NO) {
+                                ranking.deadline = CACurrentMediaTime() + PLCompletionServiceNamespaceBudget;
+                                [ranking offerNames:PLCompletionServiceQualifiedNames(qualifier, names) source:PLCompletionSourceNamespace weight:PLCompletionServiceNamespaceWeight];
+                                completions = [ranking completions];
+                                partial = [ranking isPartial];
+                                dispatch_async(dispatch_get_main_queue(), ^{
+                                        [self deliverCompletions:completions partial:partial final:YES ofRequest:request];
+                                });
+                        }
+                        [names release];
+                });
+        });
+}
+
+/**
+ * \brief Call the handler of a request on the main thread, unless it was
+ *        cancelled.
+ *
+ * \param completions The completions.
+ *
+ * \param partial YES if the ranking ran out of time.
+ *
+ * \param final YES if no more results follow.
+ *
+ * \param request The request.
+ */
+-(void)deliverCompletions:(NSArray *)completions partial:(BOOL)partial final:(BOOL)final ofRequest:(PLCompletionRequest *)request
+{
+        if ([request isCancelled]) {
+                goto exit;
+        }
+        if (request.answered == NO) {
+                request.answered = YES;
+                [self recordLatency:CACurrentMediaTime() - request.startTime partial:partial];
+        }
+        if (final && currentRequest == request) {
+                [currentRequest autorelease];
+                currentRequest = nil;
+        }
+        request.handler(completions, partial, final);
+
+exit:
+        return;
+}
+
+-(void)cancelCurrentRequest
+{
+        [currentRequest cancel];
+        [currentRequest release];
+        currentRequest = nil;
+}
+
+#pragma mark - Latency
+
+/**
+ * \brief Record the latency of the first results of a request, and log the
+ *        percentiles of the latest latencies every
+ *        `PLCompletionServiceLatencyLogInterval` requests if
+ *        `PLUserDefaultLogPerformance` is set.
+ *
+ * \param latency The time from the request to its first results, in seconds.
+ *
+ * \param partial YES if the results were partial.
+ */
+-(void)recordLatency:(CFTimeInterval)latency partial:(BOOL)partial
+{
+        CFTimeInterval * sortedLatencies = NULL;
+        NSUInteger count = 0;
+
+        latencies[answeredCount % PLCompletionServiceLatencyCount] = latency;
+        answeredCount++;
+        if (partial) {
+                partialCount++;
+        }
+        if (answeredCount % PLCompletionServiceLatencyLogInterval != 0 ||
+            [[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance] == NO) {
+                goto exit;
+        }
+        count = MIN(answeredCount, PLCompletionServiceLatencyCount);
+        sortedLatencies = malloc(count * sizeof(CFTimeInterval));
+        memcpy(sortedLatencies, latencies, count * sizeof(CFTimeInterval));
+        qsort(sortedLatencies, count, sizeof(CFTimeInterval), PLCompletionServiceCompareLatencies);
+        NSLog(@"Completion: p50 %.2f ms, p99 %.2f ms over the last %lu requests, %lu of %lu requests partial",
+              sortedLatencies[count / 2] * 1000.0,
+              sortedLatencies[MIN(count * 99 / 100, count - 1)] * 1000.0,
+              (unsigned long)count,
+              (unsigned long)partialCount,
+              (unsigned long)answeredCount);
+
+exit:
+        free(sortedLatencies);
+        return;
+}
+
+@end
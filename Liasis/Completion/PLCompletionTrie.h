@@ -0,0 +1,171 @@
+/**
+ * \file PLCompletionTrie.h
+ *
+ * \brief Liasis Python IDE completion trie.
+ *
+ * \details This file includes the prefix trie of the names offered as
+ *          completions and its builder.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+#import "PLCompletionRanking.h"
+
+/**
+ * \class PLCompletionTrie \headerfile \headerfile
+ *
+ * \brief An immutable prefix trie of weighted names.
+ *
+ * \details Names are stored as UTF-8 bytes in a single pool, sorted ignoring
+ *          the case of ASCII letters, and the nodes of the trie are an array
+ *          in breadth first order whose children are contiguous. Each node
+ *          records the range of names below it and the largest weight among
+ *          them.
+ *
+ *          Finding the node of a prefix takes a binary search per byte of the
+ *          prefix. Ranking then visits the nodes below it best weight first
+ *          and stops as soon as no unvisited node can hold a name scoring
+ *          higher than the worst name kept, so a short prefix matching most of
+ *          the names visits only a few of them, and a ranking whose deadline
+ *          passes has already seen the heaviest names.
+ *
+ *          A trie may be used from any thread.
+ */
+@interface PLCompletionTrie : NSObject
+{
+        /**
+         * \brief The UTF-8 bytes of the names.
+         */
+        NSData * pool;
+
+        /**
+         * \brief The names, in trie order.
+         */
+        struct PLCompletionTrieName * names;
+
+        /**
+         * \brief The nodes, the root first.
+         */
+        struct PLCompletionTrieNode * nodes;
+
+        /**
+         * \brief The number of nodes.
+         */
+        uint32_t nodeCount;
+}
+
+/**
+ * \brief The number of names.
+ */
+@property (readonly) NSUInteger count;
+
+/**
+ * \brief Offer the names beginning with the prefix of a ranking to it.
+ *
+ * \details Names are offered until the ranking is full of names no name left
+ *          can beat, or `shouldStop` returns YES.
+ *
+ * \param ranking The ranking.
+ *
+ * \return NO if the ranking stopped before all the names it could keep were
+ *         offered.
+ */
+-(BOOL)rankCompletionsWithRanking:(PLCompletionRanking *)ranking;
+
+@end
+
+/**
+ * \class PLCompletionTrieBuilder \headerfile \headerfile
+ *
+ * \brief Accumulates weighted names and produces a trie.
+ *
+ * \details A name added more than once is kept once, with its largest weight.
+ *          A builder must only be used from one thread at a time.
+ */
+@interface PLCompletionTrieBuilder : NSObject
+{
+        /**
+         * \brief The UTF-8 bytes of the names.
+         */
+        NSMutableData * pool;
+
+        /**
+         * \brief The names, in the order they were added.
+         */
+        struct PLCompletionTrieName * names;
+
+        /**
+         * \brief The number of names.
+         */
+        uint32_t nameCount;
+
+        /**
+         * \brief The number of names `names` can hold.
+         */
+        uint32_t nameCapacity;
+}
+
+/**
+ * \brief Create a builder.
+ *
+ * \return A builder on the autorelease pool.
+ */
++(instancetype)builder;
+
+/**
+ * \brief Add a name.
+ *
+ * \details Empty names, names longer than 255 bytes, and names with a NUL
+ *          byte are ignored.
+ *
+ * \param name The UTF-8 bytes of the name.
+ *
+ * \param length The number of bytes.
+ *
+ * \param source Where the name comes from.
+ *
+ * \param weight The weight of the name, at most `UINT16_MAX`.
+ */
+-(void)addName:(const char *)name length:(size_t)length source:(PLCompletionSource)source weight:(NSUInteger)weight;
+
+/**
+ * \brief Add the names of a C string table.
+ *
+ * \param table The names.
+ *
+ * \param count The number of names.
+ *
+ * \param source Where the names come from.
+ *
+ * \param weight The weight of each name.
+ */
+-(void)addNames:(const char * const *)table count:(NSUInteger)count source:(PLCompletionSource)source weight:(NSUInteger)weight;
+
+/**
+ * \brief Build a trie of the names added.
+ *
+ * \return A trie on the autorelease pool.
+ */
+-(PLCompletionTrie *)trie;
+
+@end
@@ -0,0 +1,422 @@
+/**
+ * \file PLCompletionTrie.m
+ *
+ * \brief Liasis Python IDE completion trie.
+ *
+ * \details This file includes the prefix trie of the names offered as
+ *          completions and its builder.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLCompletionTrie.h"
+
+/**
+ * \brief The longest name in bytes.
+ */
+static const size_t PLCompletionTrieMaximumNameLength = 255;
+
+/**
+ * \brief The number of nodes visited between checks of the deadline.
+ */
+static const NSUInteger PLCompletionTrieCheckInterval = 64;
+
+/**
+ * \brief A name of a trie.
+ */
+struct PLCompletionTrieName {
+        uint32_t offset;
+        uint16_t weight;
+        uint8_t length;
+        uint8_t source;
+};
+
+typedef struct PLCompletionTrieName PLCompletionTrieName;
+
+/**
+ * \brief A node of a trie.
+ *
+ * \details The names below a node are `nameCount` consecutive names from
+ *          `firstName`, of which the first `terminalCount` end at the node.
+ *          The children are `childCount` consecutive nodes from `firstChild`,
+ *          ordered by byte.
+ */
+struct PLCompletionTrieNode {
+        uint32_t firstName;
+        uint32_t nameCount;
+        uint32_t terminalCount;
+        uint32_t firstChild;
+        uint16_t childCount;
+        uint16_t maximumWeight;
+        uint8_t byte;
+        uint8_t depth;
+};
+
+typedef struct PLCompletionTrieNode PLCompletionTrieNode;
+
+/**
+ * \brief A name being sorted.
+ */
+typedef struct {
+        const char * bytes;
+        uint32_t length;
+        uint32_t nameIndex;
+} PLCompletionTrieSortedName;
+
+/**
+ * \brief Lowercase an ASCII letter.
+ */
+static inline uint8_t PLCompletionTrieLowercase(uint8_t character)
+{
+        return (character >= 'A' && character <= 'Z') ? (uint8_t)(character + ('a' - 'A')) : character;
+}
+
+/**
+ * \brief Order names being sorted ignoring the case of ASCII letters, then by
+ *        their bytes.
+ */
+static int PLCompletionTrieCompareSortedNames(const void * first, const void * second)
+{
+        const PLCompletionTrieSortedName * firstName = first, * secondName = second;
+        size_t i = 0, commonLength = MIN(firstName->length, secondName->length);
+        int order = 0;
+
+        for (i = 0; i < commonLength && order == 0; i++) {
+                order = (int)PLCompletionTrieLowercase((uint8_t)firstName->bytes[i]) - (int)PLCompletionTrieLowercase((uint8_t)secondName->bytes[i]);
+        }
+        if (order == 0 && firstName->length != secondName->length) {
+                order = (firstName->length < secondName->length) ? -1 : 1;
+        }
+        if (order == 0) {
+                order = memcmp(firstName->bytes, secondName->bytes, firstName->length);
+        }
+        return order;
+}
+
+/**
+ * \brief Add a node to a heap ordered by the largest weight below the nodes.
+ */
+static void PLCompletionTriePushNode(const PLCompletionTrieNode * nodes, uint32_t ** heap, uint32_t * count, uint32_t * capacity, uint32_t nodeIndex)
+{
+        uint32_t position = 0, parent = 0;
+
+        if (*count == *capacity) {
+                *capacity = MAX(2 * *capacity, 64);
+                *heap = realloc(*heap, *capacity * sizeof(uint32_t));
+        }
+        position = (*count)++;
+        while (position > 0) {
+                parent = (position - 1) / 2;
+                if (nodes[(*heap)[parent]].maximumWeight >= nodes[nodeIndex].maximumWeight) {
+                        break;
+                }
+                (*heap)[position] = (*heap)[parent];
+                position = parent;
+        }
+        (*heap)[position] = nodeIndex;
+}
+
+/**
+ * \brief Remove the node with the largest weight below it from a heap.
+ *
+ * \return The index of the node.
+ */
+static uint32_t PLCompletionTriePopNode(const PLCompletionTrieNode * nodes, uint32_t * heap, uint32_t * count)
+{
+        uint32_t top = heap[0], last = heap[--(*count)], position = 0, child = 0;
+
+        while ((child = 2 * position + 1) < *count) {
+                if (child + 1 < *count && nodes[heap[child + 1]].maximumWeight > nodes[heap[child]].maximumWeight) {
+                        child++;
+                }
+                if (nodes[last].maximumWeight >= nodes[heap[child]].maximumWeight) {
+                        break;
+                }
+                heap[position] = heap[child];
+                position = child;
+        }
+        heap[position] = last;
+        return top;
+}
+
+#pragma mark -
+
+@implementation PLCompletionTrie
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Initialize a trie with sorted names.
+ *
+ * \details The nodes are built breadth first, so the children of a node are
+ *          appended together and every node is built before its children. A
+ *          trie has at most one node per byte of its names plus the root.
+ *
+ * \param namePool The UTF-8 bytes of the names.
+ *
+ * \param sortedNames The names in trie order, owned by the trie afterwards.
+ *
+ * \param count The number of names.
+ *
+ * \return The initialized trie.
+ */
+-(instancetype)initWithPool:(NSData *)namePool names:(PLCompletionTrieName *)sortedNames count:(uint32_t)count
+{
+        const uint8_t * bytes = [namePool bytes];
+        PLCompletionTrieNode * node = NULL, * child = NULL;
+        uint32_t nodeIndex = 0, nameIndex = 0, end = 0, groupEnd = 0, depth = 0;
+        uint8_t byte = 0;
+
+        self = [super init];
+        if (self == nil) {
+                free(sortedNames);
+                goto exit;
+        }
+        pool = [namePool retain];
+        names = sortedNames;
+        _count = count;
+        nodes = calloc([namePool length] + 1, sizeof(PLCompletionTrieNode));
+        nodes[0].nameCount = count;
+        nodeCount = 1;
+
+        for (nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+                node = &nodes[nodeIndex];
+                depth = node->depth;
+                end = node->firstName + node->nameCount;
+                for (nameIndex = node->firstName; nameIndex < end && names[nameIndex].length == depth; nameIndex++) {
+                        node->maximumWeight = MAX(node->maximumWeight, names[nameIndex].weight);
+                }
+                node->terminalCount = nameIndex - node->firstName;
+                node->firstChild = nodeCount;
+                while (nameIndex < end) {
+                        byte = PLCompletionTrieLowercase(bytes[names[nameIndex].offset + depth]);
+                        for (groupEnd = nameIndex + 1; groupEnd < end; groupEnd++) {
+                                if (PLCompletionTrieLowercase(bytes[names[groupEnd].offset + depth]) != byte) {
+                                        break;
+                                }
+                        }
+                        child = &nodes[nodeCount];
+                        child->byte = byte;
+                        child->depth = (uint8_t)(depth + 1);
+                        child->firstName = nameIndex;
+                        child->nameCount = groupEnd - nameIndex;
+                        nodeCount++;
+                        nameIndex = groupEnd;
+                }
+                node->childCount = (uint16_t)(nodeCount - node->firstChild);
+        }
+
+        /* Children follow their parents, so one backward pass gives the maxima */
+        for (nodeIndex = nodeCount; nodeIndex > 0; nodeIndex--) {
+                node = &nodes[nodeIndex - 1];
+                for (child = &nodes[node->firstChild]; child < &nodes[node->firstChild + node->childCount]; child++) {
+                        node->maximumWeight = MAX(node->maximumWeight, child->maximumWeight);
+                }
+        }
+
+exit:
+        return self;
+}
+
+-(void)dealloc
+{
+        free(names);
+        free(nodes);
+        [pool release];
+        [super dealloc];
+}
+
+#pragma mark - Ranking
+
+/**
+ * \brief Find the child of a node for a byte.
+ *
+ * \param nodeIndex The node.
+ *
+ * \param byte The lowercased byte.
+ *
+ * \return The index of the child, or `UINT32_MAX` if no name continues with
+ *         the byte.
+ */
+-(uint32_t)childOfNode:(uint32_t)nodeIndex withByte:(uint8_t)byte
+{
+        uint32_t low = nodes[nodeIndex].firstChild, high = low + nodes[nodeIndex].childCount, middle = 0, childIndex = UINT32_MAX;
+
+        while (low < high) {
+                middle = low + (high - low) / 2;
+                if (nodes[middle].byte < byte) {
+                        low = middle + 1;
+                } else if (nodes[middle].byte > byte) {
+                        high = middle;
+                } else {
+                        childIndex = middle;
+                        break;
+                }
+        }
+        return childIndex;
+}
+
+-(BOOL)rankCompletionsWithRanking:(PLCompletionRanking *)ranking
+{
+        const uint8_t * prefix = (const uint8_t *)[ranking prefixBytes];
+        const char * poolBytes = [pool bytes];
+        const PLCompletionTrieNode * node = NULL;
+        const PLCompletionTrieName * name = NULL;
+        size_t prefixLength = [ranking prefixLength], i = 0;
+        uint32_t nodeIndex = 0, childIndex = 0, nameIndex = 0;
+        uint32_t * heap = NULL, heapCount = 0, heapCapacity = 0;
+        NSUInteger visited = 0;
+        BOOL complete = YES;
+
+        if (_count == 0 || prefixLength > PLCompletionTrieMaximumNameLength) {
+                goto exit;
+        }
+        for (i = 0; i < prefixLength && nodeIndex != UINT32_MAX; i++) {
+                nodeIndex = [self childOfNode:nodeIndex withByte:PLCompletionTrieLowercase(prefix[i])];
+        }
+        if (nodeIndex == UINT32_MAX) {
+                goto exit;
+        }
+
+        PLCompletionTriePushNode(nodes, &heap, &heapCount, &heapCapacity, nodeIndex);
+        while (heapCount > 0) {
+                if (++visited % PLCompletionTrieCheckInterval == 0 && [ranking shouldStop]) {
+                        complete = NO;
+                        break;
+                }
+                node = &nodes[PLCompletionTriePopNode(nodes, heap, &heapCount)];
+                if (node->maximumWeight + PLCompletionMaximumBonus <= [ranking minimumScore]) {
+                        break;
+                }
+                for (nameIndex = node->firstName; nameIndex < node->firstName + node->terminalCount; nameIndex++) {
+                        name = &names[nameIndex];
+                        [ranking offerName:poolBytes + name->offset length:name->length source:name->source weight:name->weight];
+                }
+                for (childIndex = node->firstChild; childIndex < node->firstChild + node->childCount; childIndex++) {
+                        if (nodes[childIndex].maximumWeight + PLCompletionMaximumBonus > [ranking minimumScore]) {
+                                PLCompletionTriePushNode(nodes, &heap, &heapCount, &heapCapacity, childIndex);
+                        }
+                }
+        }
+
+exit:
+        free(heap);
+        return complete;
+}
+
+@end
+
+#pragma mark -
+
+@implementation PLCompletionTrieBuilder
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                pool = [[NSMutableData alloc] init];
+        }
+        return self;
+}
+
++(instancetype)builder
+{
+        return [[[self alloc] init] autorelease];
+}
+
+-(void)dealloc
+{
+        free(names);
+        [pool release];
+        [super dealloc];
+}
+
+#pragma mark - Names
+
+-(void)addName:(const char *)name length:(size_t)length source:(PLCompletionSource)source weight:(NSUInteger)weight
+{
+        if (length == 0 || length > PLCompletionTrieMaximumNameLength || memchr(name, '\0', length) != NULL ||
+            [pool length] + length > UINT32_MAX) {
+                goto exit;
+        }
+        if (nameCount == nameCapacity) {
+                nameCapacity = MAX(2 * nameCapacity, 1024);
+                names = realloc(names, nameCapacity * sizeof(PLCompletionTrieName));
+        }
+        names[nameCount].offset = (uint32_t)[pool length];
+        names[nameCount].length = (uint8_t)length;
+        names[nameCount].source = source;
+        names[nameCount].weight = (uint16_t)MIN(weight, UINT16_MAX);
+        nameCount++;
+        [pool appendBytes:name length:length];
+
+exit:
+        return;
+}
+
+-(void)addNames:(const char * const *)table count:(NSUInteger)count source:(PLCompletionSource)source weight:(NSUInteger)weight
+{
+        NSUInteger i = 0;
+
+        for (i = 0; i < count; i++) {
+                [self addName:table[i] length:strlen(table[i]) source:source weight:weight];
+        }
+}
+
+-(PLCompletionTrie *)trie
+{
+        PLCompletionTrieSortedName * sortedNames = malloc(MAX(nameCount, 1) * sizeof(PLCompletionTrieSortedName));
+        PLCompletionTrieName * trieNames = malloc(MAX(nameCount, 1) * sizeof(PLCompletionTrieName));
+        const char * poolBytes = [pool bytes];
+        const PLCompletionTrieName * name = NULL;
+        PLCompletionTrieName * previous = NULL;
+        uint32_t nameIndex = 0, count = 0;
+
+        for (nameIndex = 0; nameIndex < nameCount; nameIndex++) {
+                sortedNames[nameIndex].bytes = poolBytes + names[nameIndex].offset;
+                sortedNames[nameIndex].length = names[nameIndex].length;
+                sortedNames[nameIndex].nameIndex = nameIndex;
+        }
+        qsort(sortedNames, nameCount, sizeof(PLCompletionTrieSortedName), PLCompletionTrieCompareSortedNames);
+
+        /* Equal names are adjacent once sorted, and keep their largest weight */
+        for (nameIndex = 0; nameIndex < nameCount; nameIndex++) {
+                name = &names[sortedNames[nameIndex].nameIndex];
+                if (previous != NULL && previous->length == name->length &&
+                    memcmp(poolBytes + previous->offset, poolBytes + name->offset, name->length) == 0) {
+                        if (name->weight > previous->weight) {
+                                previous->weight = name->weight;
+                                previous->source = name->source;
+                        }
+                        continue;
+                }
+                trieNames[count] = *name;
+                previous = &trieNames[count];
+                count++;
+        }
+        free(sortedNames);
+        return [[[PLCompletionTrie alloc] initWithPool:[[pool copy] autorelease] names:trieNames count:count] autorelease];
+}
+
+@end
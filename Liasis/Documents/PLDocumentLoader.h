@@ -0,0 +1,178 @@
+/**
+ * \file PLDocumentLoader.h
+ *
+ * \brief Liasis Python IDE document loader.
+ *
+ * \details This file includes the operations reading and decoding files on a
+ *          pool of worker threads before their documents are opened.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+#import <LiasisKit/LiasisKit.h>
+
+/**
+ * \brief The size from which files are memory mapped rather than read.
+ */
+extern const unsigned long long PLDocumentLoadMappingThreshold;
+
+@class PLDocumentLoad;
+
+/**
+ * \brief The block called on the main thread when a load finishes.
+ *
+ * \param load The load, whose `error` is nil if it succeeded.
+ */
+typedef void (^PLDocumentLoadCompletionHandler)(PLDocumentLoad * load);
+
+/**
+ * \class PLDocumentLoad \headerfile \headerfile
+ *
+ * \brief Reads, decodes, and normalizes the file of a document.
+ *
+ * \details A load runs in three stages, checking whether it was cancelled
+ *          before each one:
+ *
+ *          1. The file is read. Files of at least
+ *             `PLDocumentLoadMappingThreshold` bytes are memory mapped, so
+ *             only the pages that are decoded are read from disk.
+ *          2. The encoding is detected from a byte order mark, then from a
+ *             Python `coding` declaration in the first two lines, and
+ *             otherwise is UTF-8, falling back to ISO Latin 1 if the file is
+ *             not valid UTF-8.
+ *          3. Line endings are normalized to line feeds, and the line ending
+ *             found first is recorded so it can be written back on save.
+ *
+ *          Memory mapped UTF-8 files skip decoding as a whole: their text is a
+ *          snapshot of a `PLPieceTable` whose pieces refer to the mapping,
+ *          decoding and normalizing only the chunks that are not plain ASCII.
+ *
+ *          The completion handler is called on the main thread, unless the
+ *          load was cancelled first.
+ */
+@interface PLDocumentLoad : NSOperation
+{
+        /**
+         * \brief The block called when the load finishes.
+         */
+        PLDocumentLoadCompletionHandler completionHandler;
+}
+
+/**
+ * \brief The URL of the file.
+ */
+@property (retain, readonly) NSURL * fileURL;
+
+/**
+ * \brief The decoded text with line feed line endings, or nil if the load
+ *        failed or has not finished.
+ *
+ * \details A `PLPieceTableString` for memory mapped UTF-8 files, which a
+ *          `PLPieceTableTextStorage` can adopt without copying.
+ */
+@property (retain, readonly) NSString * text;
+
+/**
+ * \brief The encoding of the file.
+ */
+@property (readonly) NSStringEncoding encoding;
+
+/**
+ * \brief The line ending used by the file: `\n`, `\r\n`, or `\r`.
+ */
+@property (retain, readonly) NSString * lineEnding;
+
+/**
+ * \brief The size of the file in bytes.
+ */
+@property (readonly) unsigned long long fileSize;
+
+/**
+ * \brief The error that made the load fail, or nil.
+ */
+@property (retain, readonly) NSError * error;
+
+/**
+ * \brief Initialize a load.
+ *
+ * \param fileURL The URL of the file.
+ *
+ * \param handler The block called on the main thread when the load finishes.
+ *
+ * \return The initialized load.
+ */
+-(instancetype)initWithURL:(NSURL *)fileURL completionHandler:(PLDocumentLoadCompletionHandler)handler;
+
+/**
+ * \brief Detect the encoding of the contents of a file.
+ *
+ * \param data The contents of the file.
+ *
+ * \param preambleLength On return, the length of the byte order mark, or 0.
+ *
+ * \param declared On return, YES if the encoding was given by a byte order
+ *                 mark or `coding` declaration rather than assumed.
+ *
+ * \return The encoding.
+ */
++(NSStringEncoding)encodingOfData:(NSData *)data preambleLength:(NSUInteger *)preambleLength declared:(BOOL *)declared;
+
+@end
+
+/**
+ * \class PLDocumentLoader \headerfile \headerfile
+ *
+ * \brief Runs `PLDocumentLoad` operations on a pool of worker threads.
+ *
+ * \details Several files are loaded at a time, as many as there are active
+ *          processors and at least two, so opening many files at once does
+ *          not wait on each file in turn.
+ */
+@interface PLDocumentLoader : NSObject
+{
+        /**
+         * \brief The queue running the loads.
+         */
+        NSOperationQueue * queue;
+}
+
+/**
+ * \brief The shared document loader.
+ *
+ * \return The document loader of the application.
+ */
++(instancetype)sharedLoader;
+
+/**
+ * \brief Start loading a file.
+ *
+ * \param fileURL The URL of the file.
+ *
+ * \param handler The block called on the main thread when the load finishes.
+ *                It is not called if the load is cancelled first.
+ *
+ * \return The load, which may be cancelled.
+ */
+-(PLDocumentLoad *)loadDocumentAtURL:(NSURL *)fileURL completionHandler:(PLDocumentLoadCompletionHandler)handler;
+
+@end
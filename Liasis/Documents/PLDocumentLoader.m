@@ -0,0 +1,376 @@
+/**
+ * \file PLDocumentLoader.m
+ *
+ * \brief Liasis Python IDE document loader.
+ *
+ * \details This file includes the operations reading and decoding files on a
+ *          pool of worker threads before their documents are opened.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLDocumentLoader.h"
+#import "PLPieceTable.h"
+
+const unsigned long long PLDocumentLoadMappingThreshold = 1024 * 1024;
+
+/**
+ * \brief The number of bytes searched for a `coding` declaration.
+ */
+static const NSUInteger PLDocumentLoadDeclarationLength = 512;
+
+@implementation PLDocumentLoad
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithURL:(NSURL *)fileURL completionHandler:(PLDocumentLoadCompletionHandler)handler
+{
+        self = [super init];
+        if (self) {
+                _fileURL = [fileURL copy];
+                _encoding = NSUTF8StringEncoding;
+                _lineEnding = @"\n";
+                completionHandler = [handler copy];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [_fileURL release];
+        [_text release];
+        [_lineEnding release];
+        [_error release];
+        [completionHandler release];
+        [super dealloc];
+}
+
+#pragma mark - Stages
+
+/**
+ * \brief Record the error that made the load fail.
+ *
+ * \param underlyingError The error reported by the stage that failed, or nil.
+ */
+-(void)failWithUnderlyingError:(NSError *)underlyingError
+{
+        NSMutableDictionary * userInfo = [NSMutableDictionary dictionary];
+
+        [userInfo setObject:@"File could not be opened." forKey:NSLocalizedDescriptionKey];
+        [userInfo setObject:_fileURL forKey:NSURLErrorKey];
+        if (underlyingError) {
+                [userInfo setObject:underlyingError forKey:NSUnderlyingErrorKey];
+        }
+        [_error release];
+        _error = [[NSError errorWithDomain:PLLiasisErrorDomain code:PLErrorCodeModal userInfo:userInfo] retain];
+}
+
+/**
+ * \brief Read the file, memory mapping it if it is large.
+ *
+ * \return The contents of the file, or nil if it could not be read.
+ */
+-(NSData *)readFile
+{
+        NSData * data = nil;
+        NSNumber * fileSize = nil;
+        NSDataReadingOptions options = 0;
+        NSError * readError = nil;
+
+        if ([_fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:&readError] == NO) {
+                [self failWithUnderlyingError:readError];
+                goto exit;
+        }
+        _fileSize = [fileSize unsignedLongLongValue];
+        if (_fileSize >= PLDocumentLoadMappingThreshold) {
+                options = NSDataReadingMappedIfSafe;
+        }
+        data = [NSData dataWithContentsOfURL:_fileURL options:options error:&readError];
+        if (data == nil) {
+                [self failWithUnderlyingError:readError];
+        }
+
+exit:
+        return data;
+}
+
++(NSStringEncoding)encodingOfData:(NSData *)data preambleLength:(NSUInteger *)preambleLength declared:(BOOL *)declared
+{
+        static NSRegularExpression * declarationExpression = nil;
+        static dispatch_once_t onceToken;
+        const unsigned char * bytes = [data bytes];
+        NSUInteger length = [data length], lineCount = 0, index = 0;
+        NSStringEncoding encoding = NSUTF8StringEncoding;
+        NSString * header = nil;
+        NSTextCheckingResult * match = nil;
+        CFStringEncoding declaredEncoding = kCFStringEncodingInvalidId;
+
+        dispatch_once(&onceToken, ^{
+                declarationExpression = [[NSRegularExpression alloc] initWithPattern:@"^[ \\t\\f]*#.*?coding[:=][ \\t]*([-\\w.]+)"
+                                                                             options:NSRegularExpressionAnchorsMatchLines
+                                                                               error:NULL];
+        });
+        *preambleLength = 0;
+        *declared = YES;
+
+        /* Byte order marks */
+        if (length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+                *preambleLength = 3;
+                goto exit;
+        }
+        if (length >= 4 && bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[2] == 0x00 && bytes[3] == 0x00) {
+                *preambleLength = 4;
+                encoding = NSUTF32LittleEndianStringEncoding;
+                goto exit;
+        }
+        if (length >= 4 && bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0xFE && bytes[3] == 0xFF) {
+                *preambleLength = 4;
+                encoding = NSUTF32BigEndianStringEncoding;
+                goto exit;
+        }
+        if (length >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) {
+                *preambleLength = 2;
+                encoding = NSUTF16LittleEndianStringEncoding;
+                goto exit;
+        }
+        if (length >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF) {
+                *preambleLength = 2;
+                encoding = NSUTF16BigEndianStringEncoding;
+                goto exit;
+        }
+
+        /* Python coding declaration in the first two lines */
+        for (index = 0; index < MIN(length, PLDocumentLoadDeclarationLength) && lineCount < 2; index++) {
+                if (bytes[index] == '\n') {
+                        lineCount++;
+                }
+        }
+        header = [[[NSString alloc] initWithBytes:bytes length:index encoding:NSISOLatin1StringEncoding] autorelease];
+        match = [declarationExpression firstMatchInString:header options:0 range:NSMakeRange(0, [header length])];
+        if (match) {
+                declaredEncoding = CFStringConvertIANACharSetNameToEncoding((CFStringRef)[header substringWithRange:[match rangeAtIndex:1]]);
+        }
+        if (declaredEncoding != kCFStringEncodingInvalidId) {
+                encoding = CFStringConvertEncodingToNSStringEncoding(declaredEncoding);
+                goto exit;
+        }
+        *declared = NO;
+
+exit:
+        return encoding;
+}
+
+/**
+ * \brief Decode the contents of the file.
+ *
+ * \param data The contents of the file.
+ *
+ * \return The decoded text, or nil if the file could not be decoded.
+ */
+-(NSString *)decodeData:(NSData *)data
+{
+        NSString * text = nil;
+        NSUInteger preambleLength = 0;
+        BOOL declared = NO;
+
+        _encoding = [[self class] encodingOfData:data preambleLength:&preambleLength declared:&declared];
+        text = [[[NSString alloc] initWithBytes:(const char *)[data bytes] + preambleLength
+                                         length:[data length] - preambleLength
+                                       encoding:_encoding] autorelease];
+        if (text == nil && declared == NO) {
+                _encoding = NSISOLatin1StringEncoding;
+                text = [[[NSString alloc] initWithBytes:[data bytes]
+                                                 length:[data length]
+                                               encoding:_encoding] autorelease];
+        }
+        if (text == nil) {
+                [self failWithUnderlyingError:[NSError errorWithDomain:NSCocoaErrorDomain
+                                                                  code:NSFileReadInapplicableStringEncodingError
+                                                              userInfo:@{NSStringEncodingErrorKey: @(_encoding)}]];
+        }
+        return text;
+}
+
+/**
+ * \brief Normalize the line endings of the text to line feeds.
+ *
+ * \details The line ending found first is recorded in `lineEnding`.
+ *
+ * \param text The decoded text.
+ *
+ * \return The normalized text.
+ */
+-(NSString *)normalizeLineEndingsOfText:(NSString *)text
+{
+        NSMutableString * normalized = nil;
+        NSRange returnRange = [text rangeOfString:@"\r"];
+        NSRange newlineRange = [text rangeOfString:@"\n"];
+
+        if (returnRange.location == NSNotFound) {
+                goto exit;
+        }
+        if (newlineRange.location == NSNotFound || returnRange.location < newlineRange.location) {
+                [_lineEnding release];
+                if (NSMaxRange(returnRange) < [text length] && [text characterAtIndex:NSMaxRange(returnRange)] == '\n') {
+                        _lineEnding = [@"\r\n" retain];
+                } else {
+                        _lineEnding = [@"\r" retain];
+                }
+        }
+        normalized = [[text mutableCopy] autorelease];
+        [normalized replaceOccurrencesOfString:@"\r\n" withString:@"\n" options:NSLiteralSearch range:NSMakeRange(0, [normalized length])];
+        [normalized replaceOccurrencesOfString:@"\r" withString:@"\n" options:NSLiteralSearch range:NSMakeRange(0, [normalized length])];
+        text = normalized;
+
+exit:
+        return text;
+}
+
+/**
+ * \brief Make the text of a memory mapped UTF-8 file a snapshot of a piece
+ *        table over the mapping, rather than decoding the whole file.
+ *
+ * \details The line ending found first is recorded in `lineEnding`.
+ *
+ * \param data The memory mapped contents of the file.
+ *
+ * \return The text, or nil if the file is not UTF-8.
+ */
+-(NSString *)pieceTableTextOfData:(NSData *)data
+{
+        PLPieceTable * pieceTable = nil;
+        NSString * text = nil;
+        const unsigned char * bytes = [data bytes];
+        NSUInteger length = [data length], preambleLength = 0, index = 0;
+        BOOL declared = NO;
+
+        _encoding = [[self class] encodingOfData:data preambleLength:&preambleLength declared:&declared];
+        if (_encoding != NSUTF8StringEncoding) {
+                goto exit;
+        }
+        pieceTable = [[[PLPieceTable alloc] initWithUTF8Data:data preambleLength:preambleLength] autorelease];
+        if (pieceTable == nil) {
+                goto exit;
+        }
+        index = preambleLength;
+        while (index < length && bytes[index] != '\n' && bytes[index] != '\r') {
+                index++;
+        }
+        if (index < length && bytes[index] == '\r') {
+                [_lineEnding release];
+                if (index + 1 < length && bytes[index + 1] == '\n') {
+                        _lineEnding = [@"\r\n" retain];
+                } else {
+                        _lineEnding = [@"\r" retain];
+                }
+        }
+        text = [pieceTable snapshot];
+
+exit:
+        return text;
+}
+
+#pragma mark - Operation
+
+-(void)main
+{
+        NSData * data = nil;
+        NSString * text = nil;
+
+        @autoreleasepool {
+                if ([self isCancelled]) {
+                        goto exit;
+                }
+                data = [self readFile];
+                if (data == nil || [self isCancelled]) {
+                        goto exit;
+                }
+                if (_fileSize >= PLDocumentLoadMappingThreshold) {
+                        text = [self pieceTableTextOfData:data];
+                }
+                if (text == nil) {
+                        text = [self decodeData:data];
+                        if (text == nil || [self isCancelled]) {
+                                goto exit;
+                        }
+                        text = [self normalizeLineEndingsOfText:text];
+                }
+                _text = [text copy];
+
+exit:
+                if ([self isCancelled] == NO) {
+                        dispatch_async(dispatch_get_main_queue(), ^{
+                                if ([self isCancelled] == NO) {
+                                        completionHandler(self);
+                                }
+                                [completionHandler release];
+                                completionHandler = nil;
+                        });
+                }
+        }
+}
+
+@end
+
+@implementation PLDocumentLoader
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                queue = [[NSOperationQueue alloc] init];
+                [queue setName:@"PLDocumentLoader"];
+                [queue setMaxConcurrentOperationCount:MAX([[NSProcessInfo processInfo] activeProcessorCount], 2)];
+        }
+        return self;
+}
+
++(instancetype)sharedLoader
+{
+        static PLDocumentLoader * sharedLoader = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedLoader = [[self alloc] init];
+        });
+        return sharedLoader;
+}
+
+-(void)dealloc
+{
+        [queue cancelAllOperations];
+        [queue release];
+        [super dealloc];
+}
+
+#pragma mark - Loading
+
+-(PLDocumentLoad *)loadDocumentAtURL:(NSURL *)fileURL completionHandler:(PLDocumentLoadCompletionHandler)handler
+{
+        PLDocumentLoad * load = [[[PLDocumentLoad alloc] initWithURL:fileURL completionHandler:handler] autorelease];
+
+        [queue addOperation:load];
+        return load;
+}
+
+@end
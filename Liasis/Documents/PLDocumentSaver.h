@@ -0,0 +1,262 @@
+/**
+ * \file PLDocumentSaver.h
+ *
+ * \brief Liasis Python IDE document saver.
+ *
+ * \details This file includes the background saves of the documents of tabs.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+#import <LiasisKit/LiasisKit.h>
+
+@class PLDocumentSave;
+
+/**
+ * \brief The block called on the main thread as a save writes its file.
+ *
+ * \param save The save.
+ *
+ * \param progress The fraction of the text written, from 0 to 1.
+ */
+typedef void (^PLDocumentSaveProgressHandler)(PLDocumentSave * save, double progress);
+
+/**
+ * \brief The block called on the main thread when a save finishes.
+ *
+ * \param save The save, whose `error` is nil if it succeeded.
+ */
+typedef void (^PLDocumentSaveCompletionHandler)(PLDocumentSave * save);
+
+/**
+ * \protocol PLDocumentSaving \headerfile \headerfile
+ *
+ * \brief Adopted by tab subview controllers that create the saves of their
+ *        own documents.
+ *
+ * \details `PLTabViewController` saves the text view of any other subview
+ *          controller through the `PLDocumentSaver`, so only subview
+ *          controllers whose text is not the string of their text view, or
+ *          that mark their documents saved themselves, need to adopt it.
+ */
+@protocol PLDocumentSaving <NSObject>
+
+/**
+ * \brief Return a save of the current text of the document.
+ *
+ * \details Called on the main thread. The save copies the text, which is
+ *          constant time for the string of a `PLPieceTableTextStorage`.
+ *
+ * \return The save, or nil if the document has no file yet, in which case
+ *         the subview controller is sent `saveFile:` instead.
+ */
+-(PLDocumentSave *)documentSave;
+
+/**
+ * \brief Called on the main thread when a save of the document finishes.
+ *
+ * \details If the save succeeded, the document should be marked saved at the
+ *          text of the save, which may be older than the current text.
+ *
+ * \param save The save returned by `documentSave`.
+ */
+-(void)documentSaveDidFinish:(PLDocumentSave *)save;
+
+@end
+
+/**
+ * \class PLDocumentSave \headerfile \headerfile
+ *
+ * \brief Writes a snapshot of the text of a document to its file.
+ *
+ * \details The text is encoded and written in chunks to a temporary file next
+ *          to the document's file, which takes the permissions, access control
+ *          list, and extended attributes of the file it replaces. Once the
+ *          temporary file is flushed to disk, it is renamed over the file, so
+ *          the file is either entirely old or entirely new, whenever the
+ *          application or system stops, and the directory holding the file
+ *          is flushed so the rename lasts too. A symbolic link is followed,
+ *          so the file it points to is replaced and the link kept.
+ *
+ *          A file with other hard links is written in place instead, as
+ *          renaming over it would separate it from its links. The text is
+ *          checked to be encodable before the file is opened, but the file
+ *          is partly written if the system stops during the save.
+ *
+ *          Line feeds are written as `lineEnding`. UTF-16 and UTF-32 text is
+ *          written after a byte order mark.
+ */
+@interface PLDocumentSave : NSObject
+{
+        /**
+         * \brief The path of the file written, with symbolic links
+         *        resolved, or NULL.
+         */
+        char * filePath;
+
+        /**
+         * \brief The path of the temporary file, or NULL.
+         */
+        char * temporaryPath;
+
+        /**
+         * \brief The descriptor of the file written, or -1.
+         */
+        int fileDescriptor;
+
+        /**
+         * \brief The device of the file written.
+         */
+        dev_t device;
+
+        /**
+         * \brief YES if the file is written in place.
+         */
+        BOOL writesInPlace;
+}
+
+/**
+ * \brief The URL of the file.
+ */
+@property (retain, readonly) NSURL * fileURL;
+
+/**
+ * \brief The immutable text written.
+ */
+@property (retain, readonly) NSString * text;
+
+/**
+ * \brief The encoding of the file.
+ */
+@property (readonly) NSStringEncoding encoding;
+
+/**
+ * \brief The line ending written for each line feed.
+ */
+@property (retain, readonly) NSString * lineEnding;
+
+/**
+ * \brief The block called as the file is written, or nil.
+ */
+@property (copy) PLDocumentSaveProgressHandler progressHandler;
+
+/**
+ * \brief The block called when the save finishes, or nil.
+ */
+@property (copy) PLDocumentSaveCompletionHandler completionHandler;
+
+/**
+ * \brief The error that made the save fail, or nil.
+ */
+@property (retain, readonly) NSError * error;
+
+/**
+ * \brief Create a save.
+ *
+ * \param text The text, which is copied.
+ *
+ * \param fileURL The URL of the file.
+ *
+ * \param encoding The encoding of the file.
+ *
+ * \param lineEnding The line ending of the file, or nil for line feeds.
+ *
+ * \return A save on the autorelease pool.
+ */
++(instancetype)saveWithText:(NSString *)text fileURL:(NSURL *)fileURL encoding:(NSStringEncoding)encoding lineEnding:(NSString *)lineEnding;
+
+@end
+
+/**
+ * \class PLDocumentSaver \headerfile \headerfile
+ *
+ * \brief Runs `PLDocumentSave`s one batch at a time on a background queue.
+ *
+ * \details The saves of a batch write their temporary files and write each
+ *          out to its disk with `fsync`, then flush the cache of each disk
+ *          they are on once with `F_FULLFSYNC`, then rename their files into
+ *          place and flush each directory renamed into once. Saving several
+ *          documents at once therefore waits on one flush of each disk's
+ *          cache rather than one per document, and no file is replaced before
+ *          the data of every file of the batch is on disk.
+ *
+ *          Must be used from the main thread.
+ */
+@interface PLDocumentSaver : NSObject
+{
+        /**
+         * \brief The queue running one batch at a time.
+         */
+        NSOperationQueue * queue;
+
+        /**
+         * \brief The saves of the batch being collected.
+         */
+        NSMutableArray * pendingSaves;
+
+        /**
+         * \brief The nesting depth of `performBatchSaves:`.
+         */
+        NSUInteger batchDepth;
+
+        /**
+         * \brief The file creation mask of the process, applied to new files.
+         */
+        mode_t creationMask;
+}
+
+/**
+ * \brief The shared document saver.
+ *
+ * \return The document saver of the application.
+ */
++(instancetype)sharedSaver;
+
+/**
+ * \brief Save a document.
+ *
+ * \details The save starts at once, or when the outermost
+ *          `performBatchSaves:` block returns.
+ *
+ * \param save The save.
+ */
+-(void)saveDocument:(PLDocumentSave *)save;
+
+/**
+ * \brief Batch the saves started in a block.
+ *
+ * \details The saves started by the block, and by the blocks it calls, are
+ *          written as one batch when it returns. Calls may be nested.
+ *
+ * \param saves The block starting saves.
+ */
+-(void)performBatchSaves:(void (^)(void))saves;
+
+/**
+ * \brief Block until every save started has been written.
+ *
+ * \details Called before the application terminates, so no write is cut off.
+ */
+-(void)waitUntilAllSavesAreFinished;
+
+@end
@@ -0,0 +1,578 @@
+/**
+ * \file PLDocumentSaver.m
+ *
+ * \brief Liasis Python IDE document saver.
+ *
+ * \details This file includes the background saves of the documents of tabs.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLDocumentSaver.h"
+#include <copyfile.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * \brief The number of characters encoded and written at a time.
+ */
+static const NSUInteger PLDocumentSaveChunkLength = 256 * 1024;
+
+/**
+ * \brief The permissions of new files, before the file creation mask.
+ */
+static const mode_t PLDocumentSaveNewFileMode = 0666;
+
+/**
+ * \brief Return the encoding each chunk of text is written in.
+ *
+ * \details Encoding a chunk in UTF-16 or UTF-32 without an explicit byte order
+ *          would start each chunk with a byte order mark, so these encodings
+ *          are written in an explicit byte order after one byte order mark.
+ *
+ * \param encoding The encoding of the file.
+ *
+ * \param writesByteOrderMark On return, YES if a byte order mark starts the
+ *                            file.
+ *
+ * \return The encoding of the chunks.
+ */
+static NSStringEncoding PLDocumentSaveChunkEncoding(NSStringEncoding encoding, BOOL * writesByteOrderMark)
+{
+        *writesByteOrderMark = YES;
+        switch (encoding) {
+                case NSUTF16StringEncoding:
+                        return NSUTF16LittleEndianStringEncoding;
+                case NSUTF32StringEncoding:
+                        return NSUTF32LittleEndianStringEncoding;
+                case NSUTF16LittleEndianStringEncoding:
+                case NSUTF16BigEndianStringEncoding:
+                case NSUTF32LittleEndianStringEncoding:
+                case NSUTF32BigEndianStringEncoding:
+                        return encoding;
+                default:
+                        *writesByteOrderMark = NO;
+                        return encoding;
+        }
+}
+
+/**
+ * \brief Flush the entries of a directory, so a rename into it lasts.
+ *
+ * \details The rename has replaced the file by then, so a failure is not the
+ *          save's.
+ *
+ * \param path The path of the directory.
+ */
+static void PLDocumentSaveFlushDirectory(NSString * path)
+{
+        int directoryDescriptor = open([path fileSystemRepresentation], O_RDONLY);
+
+        if (directoryDescriptor < 0) {
+                return;
+        }
+        if (fcntl(directoryDescriptor, F_FULLFSYNC) == -1) {
+                fsync(directoryDescriptor);
+        }
+        close(directoryDescriptor);
+}
+
+/**
+ * \brief The stages of a save, run by the `PLDocumentSaver` on its queue.
+ */
+@interface PLDocumentSave ()
+
+-(void)writeTemporaryFileWithCreationMask:(mode_t)creationMask;
+
+-(void)flushDevice;
+
+-(void)flushFile;
+
+-(void)commit;
+
+-(dev_t)device;
+
+-(NSString *)directoryPath;
+
+@end
+
+@implementation PLDocumentSave
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithText:(NSString *)text fileURL:(NSURL *)fileURL encoding:(NSStringEncoding)encoding lineEnding:(NSString *)lineEnding
+{
+        self = [super init];
+        if (self) {
+                _text = [text copy];
+                _fileURL = [fileURL copy];
+                _encoding = encoding;
+                _lineEnding = [(lineEnding ?: @"\n") copy];
+                fileDescriptor = -1;
+        }
+        return self;
+}
+
++(instancetype)saveWithText:(NSString *)text fileURL:(NSURL *)fileURL encoding:(NSStringEncoding)encoding lineEnding:(NSString *)lineEnding
+{
+        return [[[self alloc] initWithText:text fileURL:fileURL encoding:encoding lineEnding:lineEnding] autorelease];
+}
+
+-(void)dealloc
+{
+        if (fileDescriptor >= 0) {
+                close(fileDescriptor);
+        }
+        if (temporaryPath) {
+                unlink(temporaryPath);
+                free(temporaryPath);
+        }
+        free(filePath);
+        [_text release];
+        [_fileURL release];
+        [_lineEnding release];
+        [_progressHandler release];
+        [_completionHandler release];
+        [_error release];
+        [super dealloc];
+}
+
+#pragma mark - Stages
+
+/**
+ * \brief Record the error that made the save fail.
+ *
+ * \param underlyingError The error reported by the stage that failed.
+ */
+-(void)failWithUnderlyingError:(NSError *)underlyingError
+{
+        if (_error == nil) {
+                _error = [[NSError errorWithDomain:PLLiasisErrorDomain
+                                              code:PLErrorCodeModal
+                                          userInfo:@{NSLocalizedDescriptionKey: @"File could not be saved.",
+                                                     NSURLErrorKey: _fileURL,
+                                                     NSUnderlyingErrorKey: underlyingError}] retain];
+        }
+}
+
+/**
+ * \brief Record the error in `errno` as the one that made the save fail.
+ */
+-(void)failWithPOSIXError
+{
+        [self failWithUnderlyingError:[NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil]];
+}
+
+/**
+ * \brief Call the progress handler on the main thread.
+ *
+ * \param progress The fraction of the text written.
+ */
+-(void)reportProgress:(double)progress
+{
+        PLDocumentSaveProgressHandler handler = [[self.progressHandler retain] autorelease];
+
+        if (handler) {
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        handler(self, progress);
+                });
+        }
+}
+
+/**
+ * \brief Write all of a buffer to the temporary file.
+ *
+ * \param bytes The buffer.
+ *
+ * \param length The length of the buffer.
+ *
+ * \return YES if the buffer was written.
+ */
+-(BOOL)writeBytes:(const void *)bytes length:(NSUInteger)length
+{
+        ssize_t written = 0;
+
+        while (length > 0) {
+                written = write(fileDescriptor, bytes, length);
+                if (written < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (written < 0) {
+                        [self failWithPOSIXError];
+                        return NO;
+                }
+                bytes = (const char *)bytes + written;
+                length -= (NSUInteger)written;
+        }
+        return YES;
+}
+
+/**
+ * \brief Resolve the symbolic links of the path of the file.
+ *
+ * \details A file that does not exist yet keeps its path.
+ */
+-(void)resolveFilePath
+{
+        const char * path = [[_fileURL path] fileSystemRepresentation];
+
+        filePath = realpath(path, NULL);
+        if (filePath == NULL) {
+                filePath = strdup(path);
+        }
+}
+
+/**
+ * \brief Open a file with other hard links to be written in place.
+ *
+ * \details The text is checked to be encodable first, so an encoding error
+ *          does not leave the file partly written.
+ *
+ * \return YES if the file was opened.
+ */
+-(BOOL)openFileInPlace
+{
+        if ([_text canBeConvertedToEncoding:_encoding] == NO) {
+                [self failWithUnderlyingError:[NSError errorWithDomain:NSCocoaErrorDomain
+                                                                  code:NSFileWriteInapplicableStringEncodingError
+                                                              userInfo:@{NSStringEncodingErrorKey: @(_encoding)}]];
+                return NO;
+        }
+        fileDescriptor = open(filePath, O_WRONLY);
+        if (fileDescriptor < 0) {
+                [self failWithPOSIXError];
+                return NO;
+        }
+        writesInPlace = YES;
+        return YES;
+}
+
+/**
+ * \brief Create the temporary file next to the file with the file's
+ *        permissions and extended attributes, or open the file itself if it
+ *        has other hard links.
+ *
+ * \param creationMask The file creation mask of the process, applied to new
+ *                     files.
+ *
+ * \return YES if the file to write was opened.
+ */
+-(BOOL)createTemporaryFileWithCreationMask:(mode_t)creationMask
+{
+        NSString * path = nil;
+        NSString * template = nil;
+        struct stat status;
+        BOOL exists = NO;
+
+        [self resolveFilePath];
+        exists = (stat(filePath, &status) == 0);
+        if (exists && status.st_nlink > 1) {
+                if ([self openFileInPlace] == NO) {
+                        return NO;
+                }
+                goto exit;
+        }
+        path = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:filePath length:strlen(filePath)];
+        template = [[path stringByDeletingLastPathComponent] stringByAppendingPathComponent:[NSString stringWithFormat:@".%@.XXXXXX", [path lastPathComponent]]];
+        temporaryPath = strdup([template fileSystemRepresentation]);
+        fileDescriptor = mkstemp(temporaryPath);
+        if (fileDescriptor < 0) {
+                [self failWithPOSIXError];
+                free(temporaryPath);
+                temporaryPath = NULL;
+                return NO;
+        }
+        if (exists) {
+                copyfile(filePath, temporaryPath, NULL, COPYFILE_SECURITY | COPYFILE_XATTR);
+        } else {
+                fchmod(fileDescriptor, PLDocumentSaveNewFileMode & ~creationMask);
+        }
+
+exit:
+        if (fstat(fileDescriptor, &status) == 0) {
+                device = status.st_dev;
+        }
+        return YES;
+}
+
+/**
+ * \brief Write the text to a temporary file, or to the file itself if it is
+ *        written in place.
+ *
+ * \details The file is written out to its disk with `fsync` once written,
+ *          though it may still be held in the disk's own cache until the
+ *          batch flushes the disk.
+ *
+ * \param creationMask The file creation mask of the process.
+ */
+-(void)writeTemporaryFileWithCreationMask:(mode_t)creationMask
+{
+        NSUInteger length = [_text length], location = 0;
+        NSStringEncoding chunkEncoding = NSUTF8StringEncoding;
+        NSString * chunk = nil;
+        NSData * data = nil;
+        NSRange range = NSMakeRange(0, 0);
+        BOOL writesByteOrderMark = NO, lineFeeds = [_lineEnding isEqualToString:@"\n"];
+
+        if ([self createTemporaryFileWithCreationMask:creationMask] == NO) {
+                goto exit;
+        }
+        chunkEncoding = PLDocumentSaveChunkEncoding(_encoding, &writesByteOrderMark);
+        if (writesByteOrderMark) {
+                data = [@"\uFEFF" dataUsingEncoding:chunkEncoding];
+                if ([self writeBytes:[data bytes] length:[data length]] == NO) {
+                        goto exit;
+                }
+        }
+        while (location < length) {
+                @autoreleasepool {
+                        range = NSMakeRange(location, MIN(PLDocumentSaveChunkLength, length - location));
+                        if (NSMaxRange(range) < length && CFStringIsSurrogateHighCharacter([_text characterAtIndex:NSMaxRange(range) - 1])) {
+                                range.length--;
+                        }
+                        chunk = [_text substringWithRange:range];
+                        if (lineFeeds == NO) {
+                                chunk = [chunk stringByReplacingOccurrencesOfString:@"\n" withString:_lineEnding];
+                        }
+                        data = [chunk dataUsingEncoding:chunkEncoding allowLossyConversion:NO];
+                        if (data == nil) {
+                                [self failWithUnderlyingError:[NSError errorWithDomain:NSCocoaErrorDomain
+                                                                                  code:NSFileWriteInapplicableStringEncodingError
+                                                                              userInfo:@{NSStringEncodingErrorKey: @(_encoding)}]];
+                                goto exit;
+                        }
+                        if ([self writeBytes:[data bytes] length:[data length]] == NO) {
+                                goto exit;
+                        }
+                        location = NSMaxRange(range);
+                        [self reportProgress:(double)location / (double)length];
+                }
+        }
+        if (writesInPlace && ftruncate(fileDescriptor, lseek(fileDescriptor, 0, SEEK_CUR)) != 0) {
+                [self failWithPOSIXError];
+                goto exit;
+        }
+        [self flushFile];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Flush the cache of the disk of the file written to permanent
+ *        storage.
+ *
+ * \details `F_FULLFSYNC` writes out the data of this file only, then flushes
+ *          the disk's cache, which holds the data every other file of the
+ *          batch wrote out with `fsync`. It is therefore called once per
+ *          device of a batch, after each file was flushed. Volumes that do not
+ *          support `F_FULLFSYNC` keep the guarantee of `fsync` alone.
+ */
+-(void)flushDevice
+{
+        fcntl(fileDescriptor, F_FULLFSYNC);
+}
+
+/**
+ * \brief Write the data of the file written out to its disk.
+ */
+-(void)flushFile
+{
+        if (fsync(fileDescriptor) != 0) {
+                [self failWithPOSIXError];
+        }
+}
+
+/**
+ * \brief Rename the temporary file over the file, or remove it if the save
+ *        failed.
+ *
+ * \details The file the path of the document links to is replaced, so a
+ *          symbolic link stays a link.
+ */
+-(void)commit
+{
+        if (fileDescriptor >= 0) {
+                close(fileDescriptor);
+                fileDescriptor = -1;
+        }
+        if (temporaryPath == NULL) {
+                goto exit;
+        }
+        if (_error == nil && rename(temporaryPath, filePath) != 0) {
+                [self failWithPOSIXError];
+        }
+        if (_error) {
+                unlink(temporaryPath);
+        }
+        free(temporaryPath);
+        temporaryPath = NULL;
+
+exit:
+        return;
+}
+
+-(dev_t)device
+{
+        return device;
+}
+
+/**
+ * \brief Return the directory a temporary file was renamed into.
+ *
+ * \return The path of the directory, or nil if the save failed or wrote its
+ *         file in place.
+ */
+-(NSString *)directoryPath
+{
+        if (_error || writesInPlace || filePath == NULL) {
+                return nil;
+        }
+        return [[[NSFileManager defaultManager] stringWithFileSystemRepresentation:filePath length:strlen(filePath)] stringByDeletingLastPathComponent];
+}
+
+@end
+
+@implementation PLDocumentSaver
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                queue = [[NSOperationQueue alloc] init];
+                [queue setName:@"PLDocumentSaver"];
+                [queue setMaxConcurrentOperationCount:1];
+                pendingSaves = [[NSMutableArray alloc] init];
+                creationMask = umask(0);
+                umask(creationMask);
+        }
+        return self;
+}
+
++(instancetype)sharedSaver
+{
+        static PLDocumentSaver * sharedSaver = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedSaver = [[self alloc] init];
+        });
+        return sharedSaver;
+}
+
+-(void)dealloc
+{
+        [queue release];
+        [pendingSaves release];
+        [super dealloc];
+}
+
+#pragma mark - Saving
+
+-(void)saveDocument:(PLDocumentSave *)save
+{
+        [pendingSaves addObject:save];
+        if (batchDepth == 0) {
+                [self commitPendingSaves];
+        }
+}
+
+-(void)performBatchSaves:(void (^)(void))saves
+{
+        batchDepth++;
+        saves();
+        batchDepth--;
+        if (batchDepth == 0) {
+                [self commitPendingSaves];
+        }
+}
+
+/**
+ * \brief Write the pending saves as one batch on the background queue.
+ *
+ * \details Each save writes and flushes its temporary file, then the cache of
+ *          each device written to is flushed once, then the files are renamed
+ *          into place and each directory renamed into is flushed once. No file
+ *          is renamed before the data of every file of the batch is on disk.
+ *          The completion handlers are called on the main thread.
+ */
+-(void)commitPendingSaves
+{
+        NSArray * saves = nil;
+        mode_t mask = creationMask;
+
+        if ([pendingSaves count] == 0) {
+                goto exit;
+        }
+        saves = [[pendingSaves copy] autorelease];
+        [pendingSaves removeAllObjects];
+        [queue addOperationWithBlock:^{
+                NSMutableSet * flushedDevices = [NSMutableSet set];
+                NSMutableSet * directoryPaths = [NSMutableSet set];
+                NSNumber * device = nil;
+
+                for (PLDocumentSave * save in saves) {
+                        [save writeTemporaryFileWithCreationMask:mask];
+                }
+                for (PLDocumentSave * save in saves) {
+                        device = @([save device]);
+                        if (save.error || [flushedDevices containsObject:device]) {
+                                continue;
+                        }
+                        [save flushDevice];
+                        [flushedDevices addObject:device];
+                }
+                for (PLDocumentSave * save in saves) {
+                        [save commit];
+                        if ([save directoryPath]) {
+                                [directoryPaths addObject:[save directoryPath]];
+                        }
+                }
+                for (NSString * directoryPath in directoryPaths) {
+                        PLDocumentSaveFlushDirectory(directoryPath);
+                }
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        for (PLDocumentSave * save in saves) {
+                                if (save.completionHandler) {
+                                        save.completionHandler(save);
+                                }
+                                save.progressHandler = nil;
+                                save.completionHandler = nil;
+                        }
+                });
+        }];
+
+exit:
+        return;
+}
+
+-(void)waitUntilAllSavesAreFinished
+{
+        [self commitPendingSaves];
+        [queue waitUntilAllOperationsAreFinished];
+}
+
+@end
@@ -0,0 +1,347 @@
+/**
+ * \file PLEditJournal.h
+ *
+ * \brief Liasis Python IDE edit journal.
+ *
+ * \details This file includes the journals recording the unsaved edits of
+ *          documents, so they can be recovered after a crash.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+#import <LiasisKit/LiasisKit.h>
+
+/**
+ * \brief The time an edit may take to append to its journal, in nanoseconds.
+ *
+ * \details Appends over the budget are counted in `PLEditJournalStatistics`
+ *          and logged when `PLUserDefaultLogPerformance` is YES.
+ */
+extern const uint64_t PLEditJournalAppendBudget;
+
+/**
+ * \brief Counters of the work done by all edit journals.
+ *
+ * \see PLEditJournalManager
+ */
+typedef struct {
+        /**
+         * \brief The number of edits appended.
+         */
+        NSUInteger appends;
+
+        /**
+         * \brief The number of appends that took longer than
+         *        `PLEditJournalAppendBudget`.
+         */
+        NSUInteger appendsOverBudget;
+
+        /**
+         * \brief The time spent appending edits, in nanoseconds.
+         */
+        uint64_t appendTime;
+
+        /**
+         * \brief The longest append, in nanoseconds.
+         */
+        uint64_t longestAppendTime;
+
+        /**
+         * \brief The number of journals compacted.
+         */
+        NSUInteger compactions;
+} PLEditJournalStatistics;
+
+/**
+ * \class PLEditJournal \headerfile \headerfile
+ *
+ * \brief An append only log of the edits of one document since it was last
+ *        saved.
+ *
+ * \details The journal records each edit of the text storage it is attached
+ *          to as an operation, the replaced range and the characters replacing
+ *          it, rather than as a copy of the text. Records are copied into a
+ *          shared memory mapping of the journal file, so an edit costs a copy
+ *          of its characters and no system call, and a record is in the file
+ *          as soon as it is appended, whenever the application stops. Each
+ *          record has a checksum, and the header's end offset is only moved
+ *          past a record once it is complete, so a torn record is ignored.
+ *          The mapping is flushed to disk at most a second after an edit.
+ *
+ *          The journal starts from the document's file, whose size and
+ *          modification date are kept in the header. Once the records pass a
+ *          megabyte, the journal is compacted in the background: it is
+ *          rewritten as a single record of a snapshot of the text, followed by
+ *          the records appended meanwhile. When the document is saved, the
+ *          journal starts over from the saved file.
+ *
+ *          A journal left by a crash is replayed into the document once it is
+ *          loaded again, if its file has not changed since or the journal was
+ *          compacted. The journal must only be used from the main thread.
+ */
+@interface PLEditJournal : NSObject
+{
+        /**
+         * \brief The path of the journal file.
+         */
+        NSString * path;
+
+        /**
+         * \brief The descriptor of the journal file, or -1.
+         */
+        int fileDescriptor;
+
+        /**
+         * \brief The shared mapping of the journal file, or NULL.
+         */
+        void * mapping;
+
+        /**
+         * \brief The length of the mapping and the journal file.
+         */
+        size_t capacity;
+
+        /**
+         * \brief The offset of the first record.
+         */
+        uint64_t recordsOffset;
+
+        /**
+         * \brief The end offset of the records when the journal was last
+         *        rewritten.
+         */
+        uint64_t rewrittenEnd;
+
+        /**
+         * \brief Incremented whenever the journal is rewritten, so a
+         *        compaction finishing after the journal started over is
+         *        dropped.
+         */
+        NSUInteger generation;
+
+        /**
+         * \brief YES while a compaction is scheduled or running.
+         */
+        BOOL compacting;
+
+        /**
+         * \brief YES while a flush of the mapping is scheduled.
+         */
+        BOOL flushScheduled;
+
+        /**
+         * \brief The text storage whose edits are appended, or nil.
+         */
+        NSTextStorage * textStorage;
+
+        /**
+         * \brief The view controller of the document, or nil.
+         */
+        NSViewController <PLTabSubviewController> * viewController;
+}
+
+/**
+ * \brief The URL of the document's file, or nil for an untitled document.
+ */
+@property (readonly) NSURL * fileURL;
+
+/**
+ * \brief YES if the journal was left by an earlier launch and has not been
+ *        replayed.
+ */
+@property (readonly, getter=isRecovered) BOOL recovered;
+
+/**
+ * \brief Create a journal for a document that has no unsaved edits.
+ *
+ * \param fileURL The URL of the document's file, or nil if it is untitled.
+ *
+ * \return A journal on the autorelease pool, or nil if its file could not be
+ *         created.
+ */
++(instancetype)journalWithFileURL:(NSURL *)fileURL;
+
+/**
+ * \brief Open a journal file left by an earlier launch.
+ *
+ * \param path The path of the journal file.
+ *
+ * \return A recovered journal on the autorelease pool, or nil if the file is
+ *         not a journal.
+ */
++(instancetype)journalWithContentsOfFile:(NSString *)path;
+
+/**
+ * \brief Apply the edits of a recovered journal to the document they were
+ *        made to.
+ *
+ * \details The edits are applied to a piece table, and the range they changed
+ *          replaces the same range of the text view's text as one edit that
+ *          can be undone, which marks the document edited.
+ *
+ * \param textView The text view of the document, holding the text of its file.
+ *
+ * \return YES if the edits were applied, or NO if the file has changed since
+ *         they were made or the journal does not fit the text.
+ */
+-(BOOL)replayIntoTextView:(NSTextView *)textView;
+
+/**
+ * \brief Start appending the edits of a text view's text.
+ *
+ * \details The journal starts over when the view controller's document is
+ *          saved.
+ *
+ * \param textView The text view of the document.
+ *
+ * \param aViewController The view controller of the document.
+ */
+-(void)attachToTextView:(NSTextView *)textView viewController:(NSViewController <PLTabSubviewController> *)aViewController;
+
+/**
+ * \brief Start the journal over from the document's file, after the document
+ *        was saved.
+ *
+ * \details If the document was edited after the text that was saved, the
+ *          journal starts with a record of its whole text.
+ */
+-(void)rebase;
+
+/**
+ * \brief Stop appending edits and remove the journal file.
+ *
+ * \details Called when the document is closed, with or without saving.
+ */
+-(void)discard;
+
+@end
+
+#pragma mark -
+
+/**
+ * \class PLEditJournalManager \headerfile \headerfile
+ *
+ * \brief Keeps the journals of the application in the application support
+ *        directory and hands those left by a crash to the documents they
+ *        belong to.
+ *
+ * \details The journals left by the last launch are read when the manager is
+ *          first used. Each is claimed once, by the tab loading its document or
+ *          by a new tab for an untitled document.
+ *
+ *          The manager must only be used from the main thread.
+ */
+@interface PLEditJournalManager : NSObject
+{
+        /**
+         * \brief The recovered journals of files not yet claimed, by path.
+         */
+        NSMutableDictionary * recoveredJournals;
+
+        /**
+         * \brief The recovered journals of untitled documents not yet claimed.
+         */
+        NSMutableArray * recoveredUntitledJournals;
+
+        /**
+         * \brief The counters of all journals.
+         */
+        PLEditJournalStatistics statistics;
+}
+
+/**
+ * \brief The shared journal manager.
+ *
+ * \return The journal manager of the application.
+ */
++(instancetype)sharedJournalManager;
+
+/**
+ * \brief The directory holding the journal files.
+ *
+ * \return The path of the directory.
+ */
+-(NSString *)journalDirectoryPath;
+
+/**
+ * \brief Return if a recovered journal for a file has not been claimed.
+ *
+ * \param fileURL The URL of the file.
+ *
+ * \return YES if `claimJournalForFileURL:` would return a journal.
+ */
+-(BOOL)hasJournalForFileURL:(NSURL *)fileURL;
+
+/**
+ * \brief Take the recovered journal of a file.
+ *
+ * \param fileURL The URL of the file, or nil.
+ *
+ * \return The journal, or nil if there is none.
+ */
+-(PLEditJournal *)claimJournalForFileURL:(NSURL *)fileURL;
+
+/**
+ * \brief The URLs of the files whose recovered journals have not been
+ *        claimed.
+ *
+ * \return An array of `NSURL` objects.
+ */
+-(NSArray *)fileURLsOfRecoveredJournals;
+
+/**
+ * \brief Take the recovered journals of untitled documents.
+ *
+ * \return An array of `PLEditJournal` objects.
+ */
+-(NSArray *)claimUntitledJournals;
+
+/**
+ * \brief Return the counters of all journals.
+ *
+ * \return The statistics since launch.
+ */
+-(PLEditJournalStatistics)statistics;
+
+/**
+ * \brief Count an append.
+ *
+ * \details Called by the journals.
+ *
+ * \param duration The time the append took, in nanoseconds.
+ */
+-(void)recordAppendDuration:(uint64_t)duration;
+
+/**
+ * \brief Count a compaction.
+ *
+ * \details Called by the journals.
+ *
+ * \param duration The time the compaction took on the main thread, in
+ *                 nanoseconds.
+ *
+ * \param length The length of the compacted journal, in bytes.
+ */
+-(void)recordCompactionDuration:(uint64_t)duration length:(uint64_t)length;
+
+@end
@@ -0,0 +1,1032 @@
+/**
+ * \file PLEditJournal.m
+ *
+ * \brief Liasis Python IDE edit journal.
+ *
+ * \details This file includes the journals recording the unsaved edits of
+ *          documents, so they can be recovered after a crash.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLEditJournal.h"
+#import "PLUserDefaults.h"
+#import "PLPieceTable.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <libkern/OSAtomic.h>
+#include <mach/mach_time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const uint64_t PLEditJournalAppendBudget = 20000;
+
+/**
+ * \brief The first word of a journal file, "PLJL".
+ */
+static const uint32_t PLEditJournalMagic = 0x4c4a4c50;
+
+/**
+ * \brief The version of the journal file format.
+ */
+static const uint32_t PLEditJournalVersion = 1;
+
+/**
+ * \brief The header flag of the journal of an untitled document, which starts
+ *        from empty text.
+ */
+static const uint32_t PLEditJournalUntitled = 1 << 0;
+
+/**
+ * \brief The replaced length of a record replacing the whole text.
+ */
+static const uint64_t PLEditJournalWholeText = UINT64_MAX;
+
+/**
+ * \brief The length a journal file is created with, and the least it grows by.
+ */
+static const size_t PLEditJournalInitialCapacity = 64 * 1024;
+
+/**
+ * \brief The length of the records appended since the journal was rewritten
+ *        that makes it compact.
+ */
+static const uint64_t PLEditJournalCompactionLength = 1024 * 1024;
+
+/**
+ * \brief The longest time an appended record stays unflushed, in seconds.
+ */
+static const NSTimeInterval PLEditJournalFlushDelay = 1.0;
+
+/**
+ * \brief The time between passing the compaction length and compacting, in
+ *        seconds.
+ */
+static const NSTimeInterval PLEditJournalCompactionDelay = 1.0;
+
+/**
+ * \brief The number of appends between two logged summaries.
+ */
+static const NSUInteger PLEditJournalLogInterval = 1000;
+
+/**
+ * \brief The extension of journal files.
+ */
+static NSString * const PLEditJournalExtension = @"pljournal";
+
+/**
+ * \brief The header at the start of a journal file, followed by the path of
+ *        the document's file padded to 8 bytes, then the records.
+ */
+typedef struct {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t end;                   /* offset past the last complete record */
+        uint64_t baseSize;              /* size of the file the journal starts from */
+        int64_t baseModificationTime;   /* its modification time, in nanoseconds */
+        uint32_t flags;
+        uint32_t pathLength;            /* bytes of the path, unpadded */
+} PLEditJournalHeader;
+
+/**
+ * \brief The header of a record, followed by its UTF-16 characters padded to
+ *        8 bytes.
+ */
+typedef struct {
+        uint32_t checksum;              /* of the rest of the record */
+        uint32_t reserved;
+        uint64_t location;
+        uint64_t replacedLength;        /* or PLEditJournalWholeText */
+        uint64_t length;                /* characters replacing the range */
+} PLEditJournalRecord;
+
+#pragma mark - Journal Files
+
+/**
+ * \brief Round a length up to a multiple of 8.
+ */
+static uint64_t PLEditJournalPadded(uint64_t length)
+{
+        return (length + 7) & ~(uint64_t)7;
+}
+
+/**
+ * \brief Return the length of a record of characters, padded.
+ */
+static uint64_t PLEditJournalRecordSize(uint64_t length)
+{
+        return sizeof(PLEditJournalRecord) + PLEditJournalPadded(length * sizeof(unichar));
+}
+
+/**
+ * \brief Continue an FNV-1a checksum over bytes.
+ */
+static uint32_t PLEditJournalChecksum(uint32_t checksum, const void * bytes, size_t length)
+{
+        const uint8_t * byte = bytes, * end = byte + length;
+
+        while (byte < end) {
+                checksum = (checksum ^ *byte++) * 16777619u;
+        }
+        return checksum;
+}
+
+/**
+ * \brief Return the checksum of a record's header, before its characters.
+ */
+static uint32_t PLEditJournalRecordChecksum(const PLEditJournalRecord * record)
+{
+        return PLEditJournalChecksum(2166136261u, &record->reserved, sizeof(PLEditJournalRecord) - offsetof(PLEditJournalRecord, reserved));
+}
+
+/**
+ * \brief Return the current time in nanoseconds.
+ */
+static uint64_t PLEditJournalNow(void)
+{
+        static mach_timebase_info_data_t timebase;
+
+        if (timebase.denom == 0) {
+                mach_timebase_info(&timebase);
+        }
+        return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
+/**
+ * \brief Read the size and modification time of a file.
+ *
+ * \return YES if the file exists.
+ */
+static BOOL PLEditJournalStatFile(NSURL * fileURL, uint64_t * size, int64_t * modificationTime)
+{
+        struct stat status;
+
+        if (fileURL == nil || stat([[fileURL path] fileSystemRepresentation], &status) != 0) {
+                return NO;
+        }
+        *size = (uint64_t)status.st_size;
+        *modificationTime = (int64_t)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec;
+        return YES;
+}
+
+/**
+ * \brief Return the header and path starting a journal of a file.
+ *
+ * \param fileURL The URL of the file, or nil for an untitled document.
+ *
+ * \return The bytes preceding the records, with the end offset set past them.
+ */
+static NSData * PLEditJournalHeaderData(NSURL * fileURL)
+{
+        PLEditJournalHeader header = {0};
+        NSMutableData * data = nil;
+        const char * filePath = fileURL ? [[fileURL path] fileSystemRepresentation] : "";
+
+        header.magic = PLEditJournalMagic;
+        header.version = PLEditJournalVersion;
+        header.flags = fileURL ? 0 : PLEditJournalUntitled;
+        header.pathLength = (uint32_t)strlen(filePath);
+        PLEditJournalStatFile(fileURL, &header.baseSize, &header.baseModificationTime);
+        header.end = sizeof(header) + PLEditJournalPadded(header.pathLength);
+
+        data = [NSMutableData dataWithBytes:&header length:sizeof(header)];
+        [data appendBytes:filePath length:header.pathLength];
+        [data setLength:header.end];
+        return data;
+}
+
+/**
+ * \brief Write a new journal file, optionally starting with a record of a
+ *        whole text.
+ *
+ * \details Runs on any thread.
+ *
+ * \param filePath The path of the new file.
+ *
+ * \param headerData The header, from `PLEditJournalHeaderData`.
+ *
+ * \param text The text, or nil.
+ *
+ * \return The end offset of the file, or 0 if it could not be written.
+ */
+static uint64_t PLEditJournalWriteFile(NSString * filePath, NSData * headerData, NSString * text)
+{
+        PLEditJournalRecord record = {0};
+        PLEditJournalHeader header;
+        unichar * buffer = NULL;
+        NSUInteger location = 0, length = 0, bufferLength = 64 * 1024;
+        uint64_t end = 0, offset = 0;
+        int fileDescriptor = -1;
+        BOOL written = NO;
+
+        fileDescriptor = open([filePath fileSystemRepresentation], O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fileDescriptor < 0) {
+                goto exit;
+        }
+        memcpy(&header, [headerData bytes], sizeof(header));
+        end = header.end;
+        if (text) {
+                /* Write the characters after the record's header, then the header */
+                record.location = 0;
+                record.replacedLength = PLEditJournalWholeText;
+                record.length = [text length];
+                record.checksum = PLEditJournalRecordChecksum(&record);
+                buffer = malloc(bufferLength * sizeof(unichar));
+                offset = end + sizeof(record);
+                for (location = 0; location < record.length; location += length) {
+                        length = MIN(bufferLength, (NSUInteger)record.length - location);
+                        [text getCharacters:buffer range:NSMakeRange(location, length)];
+                        record.checksum = PLEditJournalChecksum(record.checksum, buffer, length * sizeof(unichar));
+                        if (pwrite(fileDescriptor, buffer, length * sizeof(unichar), (off_t)offset) != (ssize_t)(length * sizeof(unichar))) {
+                                goto exit;
+                        }
+                        offset += length * sizeof(unichar);
+                }
+                if (pwrite(fileDescriptor, &record, sizeof(record), (off_t)end) != sizeof(record)) {
+                        goto exit;
+                }
+                end += PLEditJournalRecordSize(record.length);
+        }
+        header.end = end;
+        if (pwrite(fileDescriptor, &header, sizeof(header), 0) != sizeof(header) ||
+            pwrite(fileDescriptor, (const char *)[headerData bytes] + sizeof(header), [headerData length] - sizeof(header), sizeof(header)) < 0 ||
+            ftruncate(fileDescriptor, (off_t)MAX(end, PLEditJournalInitialCapacity)) != 0) {
+                goto exit;
+        }
+        written = YES;
+
+exit:
+        free(buffer);
+        if (fileDescriptor >= 0) {
+                close(fileDescriptor);
+        }
+        if (written == NO) {
+                unlink([filePath fileSystemRepresentation]);
+        }
+        return written ? end : 0;
+}
+
+#pragma mark -
+
+@interface PLEditJournal ()
+
+/**
+ * \brief Return if the journal has no records.
+ *
+ * \return YES if the journal holds no edits.
+ */
+-(BOOL)isEmpty;
+
+@end
+
+@implementation PLEditJournal
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithPath:(NSString *)aPath
+{
+        self = [super init];
+        if (self) {
+                path = [aPath copy];
+                fileDescriptor = -1;
+                if ([self openFile] == NO) {
+                        [self release];
+                        self = nil;
+                }
+        }
+        return self;
+}
+
++(instancetype)journalWithFileURL:(NSURL *)fileURL
+{
+        NSString * directoryPath = [[PLEditJournalManager sharedJournalManager] journalDirectoryPath];
+        NSString * filePath = nil;
+        PLEditJournal * journal = nil;
+
+        filePath = [[directoryPath stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]]
+                    stringByAppendingPathExtension:PLEditJournalExtension];
+        if (PLEditJournalWriteFile(filePath, PLEditJournalHeaderData(fileURL), nil) == 0) {
+                NSLog(@"Error: the edit journal %@ could not be created.", filePath);
+                goto exit;
+        }
+        journal = [[[self alloc] initWithPath:filePath] autorelease];
+
+exit:
+        return journal;
+}
+
++(instancetype)journalWithContentsOfFile:(NSString *)filePath
+{
+        PLEditJournal * journal = [[[self alloc] initWithPath:filePath] autorelease];
+
+        if (journal) {
+                journal->_recovered = YES;
+        }
+        return journal;
+}
+
+-(void)dealloc
+{
+        [NSObject cancelPreviousPerformRequestsWithTarget:self];
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [self closeFile];
+        [textStorage release];
+        [path release];
+        [_fileURL release];
+        [super dealloc];
+}
+
+#pragma mark - Mapping
+
+/**
+ * \brief Map the journal file and read its header.
+ *
+ * \return YES if the file is a journal.
+ */
+-(BOOL)openFile
+{
+        PLEditJournalHeader * header = NULL;
+        struct stat status;
+        BOOL opened = NO;
+
+        fileDescriptor = open([path fileSystemRepresentation], O_RDWR);
+        if (fileDescriptor < 0 || fstat(fileDescriptor, &status) != 0 || (size_t)status.st_size < sizeof(PLEditJournalHeader)) {
+                goto exit;
+        }
+        capacity = MAX((size_t)status.st_size, PLEditJournalInitialCapacity);
+        if ((size_t)status.st_size < capacity && ftruncate(fileDescriptor, (off_t)capacity) != 0) {
+                goto exit;
+        }
+        mapping = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+        if (mapping == MAP_FAILED) {
+                mapping = NULL;
+                goto exit;
+        }
+        header = mapping;
+        recordsOffset = sizeof(PLEditJournalHeader) + PLEditJournalPadded(header->pathLength);
+        if (header->magic != PLEditJournalMagic ||
+            header->version != PLEditJournalVersion ||
+            recordsOffset > capacity ||
+            header->end < recordsOffset ||
+            header->end > capacity) {
+                goto exit;
+        }
+        [_fileURL release];
+        _fileURL = nil;
+        if ((header->flags & PLEditJournalUntitled) == 0) {
+                _fileURL = [[NSURL fileURLWithPath:[[NSFileManager defaultManager] stringWithFileSystemRepresentation:(const char *)(header + 1)
+                                                                                                              length:header->pathLength]] retain];
+        }
+        rewrittenEnd = header->end;
+        opened = YES;
+
+exit:
+        if (opened == NO) {
+                [self closeFile];
+        }
+        return opened;
+}
+
+/**
+ * \brief Unmap and close the journal file.
+ */
+-(BOOL)isEmpty
+{
+        return mapping == NULL || ((PLEditJournalHeader *)mapping)->end == recordsOffset;
+}
+
+-(void)closeFile
+{
+        if (mapping) {
+                munmap(mapping, capacity);
+                mapping = NULL;
+        }
+        if (fileDescriptor >= 0) {
+                close(fileDescriptor);
+                fileDescriptor = -1;
+        }
+        capacity = 0;
+}
+
+/**
+ * \brief Grow the journal file and its mapping.
+ *
+ * \param length The least length of the file.
+ *
+ * \return YES if the file was grown.
+ */
+-(BOOL)growToLength:(uint64_t)length
+{
+        size_t newCapacity = MAX(2 * capacity, PLEditJournalInitialCapacity);
+        void * newMapping = NULL;
+
+        while (newCapacity < length) {
+                newCapacity *= 2;
+        }
+        if (ftruncate(fileDescriptor, (off_t)newCapacity) != 0) {
+                return NO;
+        }
+        newMapping = mmap(NULL, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+        if (newMapping == MAP_FAILED) {
+                return NO;
+        }
+        munmap(mapping, capacity);
+        mapping = newMapping;
+        capacity = newCapacity;
+        return YES;
+}
+
+/**
+ * \brief Schedule the written part of the mapping to be written to disk.
+ */
+-(void)flush
+{
+        flushScheduled = NO;
+        if (mapping) {
+                msync(mapping, (size_t)((PLEditJournalHeader *)mapping)->end, MS_ASYNC);
+        }
+}
+
+#pragma mark - Appending
+
+/**
+ * \brief Append a record of an edit.
+ *
+ * \param range The range of the text replaced.
+ *
+ * \param text The text after the edit.
+ *
+ * \param insertedRange The range of `text` replacing `range`.
+ *
+ * \return YES if the record was appended.
+ */
+-(BOOL)appendRecordReplacingRange:(NSRange)range withCharactersOfText:(NSString *)text inRange:(NSRange)insertedRange
+{
+        PLEditJournalHeader * header = mapping;
+        PLEditJournalRecord * record = NULL;
+        uint64_t end = header->end, size = PLEditJournalRecordSize(insertedRange.length);
+
+        if (end + size > capacity && [self growToLength:end + size] == NO) {
+                return NO;
+        }
+        header = mapping;
+        record = (PLEditJournalRecord *)((char *)mapping + end);
+        record->reserved = 0;
+        record->location = range.location;
+        record->replacedLength = range.length;
+        record->length = insertedRange.length;
+        [text getCharacters:(unichar *)(record + 1) range:insertedRange];
+        record->checksum = PLEditJournalChecksum(PLEditJournalRecordChecksum(record), record + 1, insertedRange.length * sizeof(unichar));
+
+        /* The record must be complete before the end moves past it */
+        OSMemoryBarrier();
+        header->end = end + size;
+        return YES;
+}
+
+/**
+ * \brief Append the edit of the text storage that was just processed.
+ *
+ * \details The edited range and change in length of the text storage give the
+ *          range replaced and the characters replacing it. Edits made between
+ *          `beginEditing` and `endEditing` are appended as one record.
+ *
+ * \param notification The `NSTextStorageDidProcessEditingNotification`.
+ */
+-(void)textStorageDidProcessEditing:(NSNotification *)notification
+{
+        NSRange editedRange = NSMakeRange(0, 0), replacedRange = NSMakeRange(0, 0);
+        uint64_t startTime = PLEditJournalNow();
+
+        if (mapping == NULL || ([textStorage editedMask] & NSTextStorageEditedCharacters) == 0) {
+                goto exit;
+        }
+        editedRange = [textStorage editedRange];
+        replacedRange = NSMakeRange(editedRange.location, (NSUInteger)((NSInteger)editedRange.length - [textStorage changeInLength]));
+        if ([self appendRecordReplacingRange:replacedRange withCharactersOfText:[textStorage string] inRange:editedRange] == NO) {
+                NSLog(@"Error: the edit journal %@ could not grow; unsaved edits are no longer recorded.", path);
+                [self closeFile];
+                goto exit;
+        }
+        if (flushScheduled == NO) {
+                flushScheduled = YES;
+                [self performSelector:@selector(flush) withObject:nil afterDelay:PLEditJournalFlushDelay];
+        }
+        if (compacting == NO && ((PLEditJournalHeader *)mapping)->end - rewrittenEnd > PLEditJournalCompactionLength) {
+                compacting = YES;
+                [self performSelector:@selector(compact) withObject:nil afterDelay:PLEditJournalCompactionDelay];
+        }
+        [[PLEditJournalManager sharedJournalManager] recordAppendDuration:PLEditJournalNow() - startTime];
+
+exit:
+        return;
+}
+
+#pragma mark - Rewriting
+
+/**
+ * \brief Rewrite the journal from the document's file, starting with a record
+ *        of a whole text.
+ *
+ * \details A journal without a text is rewritten at once. Otherwise the new
+ *          file is written on a background queue, and the records appended
+ *          meanwhile are copied to it before it replaces the journal file.
+ *
+ * \param text The text the journal starts from, or nil if it starts from the
+ *             file itself.
+ *
+ * \param fileURL The URL of the document's file, or nil if it is untitled.
+ */
+-(void)rewriteWithText:(NSString *)text fileURL:(NSURL *)fileURL
+{
+        NSString * rewritePath = nil;
+        NSData * headerData = nil;
+        NSUInteger rewriteGeneration = 0;
+        uint64_t capturedEnd = 0, end = 0, startTime = PLEditJournalNow();
+
+        if (mapping == NULL) {
+                goto exit;
+        }
+        rewriteGeneration = ++generation;
+        rewritePath = [path stringByAppendingFormat:@".%lu", (unsigned long)rewriteGeneration];
+        headerData = PLEditJournalHeaderData(fileURL);
+        capturedEnd = ((PLEditJournalHeader *)mapping)->end;
+        if (text == nil) {
+                end = PLEditJournalWriteFile(rewritePath, headerData, nil);
+                [self finishRewriteAtPath:rewritePath end:end capturedEnd:capturedEnd generation:rewriteGeneration startTime:startTime];
+                goto exit;
+        }
+        compacting = YES;
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+                uint64_t writtenEnd = PLEditJournalWriteFile(rewritePath, headerData, text);
+
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        [self finishRewriteAtPath:rewritePath
+                                              end:writtenEnd
+                                      capturedEnd:capturedEnd
+                                       generation:rewriteGeneration
+                                        startTime:PLEditJournalNow()];
+                });
+        });
+
+exit:
+        return;
+}
+
+/**
+ * \brief Replace the journal file with a rewritten one.
+ *
+ * \details The records appended since the rewrite started are copied to the
+ *          new file, which is then renamed over the journal file and mapped.
+ *          A rewrite that failed or was overtaken by a later one is removed.
+ *
+ * \param rewritePath The path of the new file.
+ *
+ * \param end The end offset of the new file, or 0 if it could not be written.
+ *
+ * \param capturedEnd The end offset of the journal when the rewrite started.
+ *
+ * \param rewriteGeneration The generation of the rewrite.
+ *
+ * \param startTime The time the main thread started its part of the rewrite.
+ */
+-(void)finishRewriteAtPath:(NSString *)rewritePath end:(uint64_t)end capturedEnd:(uint64_t)capturedEnd generation:(NSUInteger)rewriteGeneration startTime:(uint64_t)startTime
+{
+        PLEditJournalHeader * header = mapping;
+        uint64_t tailLength = 0;
+        int rewriteDescriptor = -1;
+        BOOL replaced = NO;
+
+        if (rewriteGeneration != generation) {
+                goto exit;
+        }
+        compacting = NO;
+        if (end == 0 || mapping == NULL) {
+                goto exit;
+        }
+        rewriteDescriptor = open([rewritePath fileSystemRepresentation], O_RDWR);
+        if (rewriteDescriptor < 0) {
+                goto exit;
+        }
+        tailLength = header->end - capturedEnd;
+        if (tailLength > 0 && pwrite(rewriteDescriptor, (char *)mapping + capturedEnd, tailLength, (off_t)end) != (ssize_t)tailLength) {
+                goto exit;
+        }
+        end += tailLength;
+        if (pwrite(rewriteDescriptor, &end, sizeof(end), offsetof(PLEditJournalHeader, end)) != sizeof(end) ||
+            rename([rewritePath fileSystemRepresentation], [path fileSystemRepresentation]) != 0) {
+                goto exit;
+        }
+        replaced = YES;
+        [self closeFile];
+        if ([self openFile] == NO) {
+                NSLog(@"Error: the edit journal %@ could not be reopened; unsaved edits are no longer recorded.", path);
+                goto exit;
+        }
+        rewrittenEnd = end - tailLength;
+        [[PLEditJournalManager sharedJournalManager] recordCompactionDuration:PLEditJournalNow() - startTime length:end];
+
+exit:
+        if (rewriteDescriptor >= 0) {
+                close(rewriteDescriptor);
+        }
+        if (replaced == NO) {
+                unlink([rewritePath fileSystemRepresentation]);
+        }
+        return;
+}
+
+/**
+ * \brief Compact the journal into a record of the current text.
+ */
+-(void)compact
+{
+        compacting = NO;
+        if (mapping == NULL || textStorage == nil) {
+                goto exit;
+        }
+        [self rewriteWithText:[[[textStorage string] copy] autorelease] fileURL:_fileURL];
+
+exit:
+        return;
+}
+
+-(void)rebase
+{
+        id document = [viewController document];
+        NSString * text = nil;
+
+        if (document && [[PLDocumentManager sharedDocumentManager] documentIsEdited:document]) {
+                text = [[[textStorage string] copy] autorelease];
+        }
+        [self rewriteWithText:text fileURL:document ? [document fileURL] : _fileURL];
+}
+
+/**
+ * \brief Start over when the document is no longer edited.
+ *
+ * \param notification The `PLTabSubviewDocumentChangedSavedSateNotification`.
+ */
+-(void)documentSavedStateChanged:(NSNotification *)notification
+{
+        id document = [viewController document];
+
+        if (document && [[PLDocumentManager sharedDocumentManager] documentIsEdited:document] == NO) {
+                [self rebase];
+        }
+}
+
+#pragma mark - Attaching
+
+-(void)attachToTextView:(NSTextView *)textView viewController:(NSViewController <PLTabSubviewController> *)aViewController
+{
+        NSNotificationCenter * defaultCenter = [NSNotificationCenter defaultCenter];
+
+        [defaultCenter removeObserver:self];
+        [textStorage release];
+        textStorage = [[textView textStorage] retain];
+        viewController = aViewController;
+        _recovered = NO;
+        [defaultCenter addObserver:self
+                          selector:@selector(textStorageDidProcessEditing:)
+                              name:NSTextStorageDidProcessEditingNotification
+                            object:textStorage];
+        [defaultCenter addObserver:self
+                          selector:@selector(documentSavedStateChanged:)
+                              name:PLTabSubviewDocumentChangedSavedSateNotification
+                            object:viewController];
+}
+
+-(void)discard
+{
+        [NSObject cancelPreviousPerformRequestsWithTarget:self];
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [textStorage release];
+        textStorage = nil;
+        viewController = nil;
+        generation++;
+        [self closeFile];
+        unlink([path fileSystemRepresentation]);
+}
+
+#pragma mark - Recovery
+
+/**
+ * \brief Check that a record lies within the journal and is intact.
+ *
+ * \param offset The offset of the record.
+ *
+ * \param end The end offset of the records.
+ *
+ * \return The offset of the next record, or 0 if the record is not intact.
+ */
+-(uint64_t)validateRecordAtOffset:(uint64_t)offset end:(uint64_t)end
+{
+        const PLEditJournalRecord * record = (const PLEditJournalRecord *)((const char *)mapping + offset);
+        uint32_t checksum = 0;
+
+        if (end - offset < sizeof(PLEditJournalRecord) ||
+            record->length > (end - offset - sizeof(PLEditJournalRecord)) / sizeof(unichar)) {
+                return 0;
+        }
+        checksum = PLEditJournalChecksum(PLEditJournalRecordChecksum(record), record + 1, record->length * sizeof(unichar));
+        if (checksum != record->checksum) {
+                return 0;
+        }
+        return offset + PLEditJournalRecordSize(record->length);
+}
+
+-(BOOL)replayIntoTextView:(NSTextView *)textView
+{
+        PLEditJournalHeader * header = mapping;
+        const PLEditJournalRecord * record = NULL;
+        NSTextStorage * storage = [textView textStorage];
+        PLPieceTable * pieceTable = nil;
+        NSString * characters = nil, * text = nil, * replacement = nil;
+        NSRange range = NSMakeRange(0, 0), replacedRange = NSMakeRange(0, 0);
+        NSUInteger originalLength = [storage length], length = 0, head = 0, tail = 0, recordCount = 0;
+        uint64_t offset = 0, next = 0, firstOffset = 0, validEnd = 0, baseSize = 0, startTime = PLEditJournalNow();
+        int64_t baseModificationTime = 0;
+        BOOL replayed = NO;
+
+        if (mapping == NULL || storage == nil) {
+                goto exit;
+        }
+
+        /* Find the intact records and the last one holding the whole text */
+        firstOffset = recordsOffset;
+        for (offset = recordsOffset; offset < header->end; offset = next) {
+                next = [self validateRecordAtOffset:offset end:header->end];
+                if (next == 0) {
+                        break;
+                }
+                record = (const PLEditJournalRecord *)((const char *)mapping + offset);
+                if (record->replacedLength == PLEditJournalWholeText) {
+                        firstOffset = offset;
+                }
+        }
+        validEnd = offset;
+
+        /* Edits of the file itself only apply to the file they were made to */
+        if (firstOffset == recordsOffset && (header->flags & PLEditJournalUntitled) == 0) {
+                if (PLEditJournalStatFile(_fileURL, &baseSize, &baseModificationTime) == NO ||
+                    baseSize != header->baseSize ||
+                    baseModificationTime != header->baseModificationTime) {
+                        NSLog(@"Error: %@ changed since its unsaved edits were recorded; they are not recovered.", [_fileURL path]);
+                        goto exit;
+                }
+        }
+
+        /* Apply the records to a piece table, tracking the range they change */
+        pieceTable = [[[PLPieceTable alloc] initWithString:[storage string]] autorelease];
+        head = originalLength;
+        tail = originalLength;
+        for (offset = firstOffset; offset < validEnd; offset += PLEditJournalRecordSize(record->length)) {
+                record = (const PLEditJournalRecord *)((const char *)mapping + offset);
+                length = [pieceTable length];
+                if (record->replacedLength == PLEditJournalWholeText) {
+                        range = NSMakeRange(0, length);
+                } else if (record->location > length || record->replacedLength > length - record->location) {
+                        NSLog(@"Error: the unsaved edits of %@ do not fit its text; they are not recovered.", [_fileURL path] ?: @"an untitled document");
+                        goto exit;
+                } else {
+                        range = NSMakeRange((NSUInteger)record->location, (NSUInteger)record->replacedLength);
+                }
+                head = MIN(head, range.location);
+                tail = MIN(tail, length - NSMaxRange(range));
+                characters = [[NSString alloc] initWithCharactersNoCopy:(unichar *)(record + 1)
+                                                                 length:(NSUInteger)record->length
+                                                           freeWhenDone:NO];
+                [pieceTable replaceCharactersInRange:range withString:characters];
+                [characters release];
+                recordCount++;
+        }
+        header->end = validEnd;
+        if (recordCount == 0) {
+                replayed = YES;
+                goto exit;
+        }
+
+        /* Replace the changed range as one edit of the text view */
+        text = [pieceTable snapshot];
+        length = [text length];
+        if (head + tail > originalLength || head + tail > length) {
+                head = 0;
+                tail = 0;
+        }
+        replacedRange = NSMakeRange(head, originalLength - head - tail);
+        replacement = [text substringWithRange:NSMakeRange(head, length - head - tail)];
+        if ([textView shouldChangeTextInRange:replacedRange replacementString:replacement] == NO) {
+                goto exit;
+        }
+        [storage replaceCharactersInRange:replacedRange withString:replacement];
+        [textView didChangeText];
+        [[textView undoManager] setActionName:@"Recover Unsaved Changes"];
+        replayed = YES;
+
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Edit journal: recovered %lu edits of %@ in %.2f ms",
+                      (unsigned long)recordCount,
+                      [_fileURL path] ?: @"an untitled document",
+                      (PLEditJournalNow() - startTime) / 1e6);
+        }
+
+exit:
+        return replayed;
+}
+
+@end
+
+#pragma mark -
+
+@implementation PLEditJournalManager
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                recoveredJournals = [[NSMutableDictionary alloc] init];
+                recoveredUntitledJournals = [[NSMutableArray alloc] init];
+                [[NSFileManager defaultManager] createDirectoryAtPath:[self journalDirectoryPath]
+                                          withIntermediateDirectories:YES
+                                                           attributes:nil
+                                                                error:NULL];
+                [self readRecoveredJournals];
+        }
+        return self;
+}
+
++(instancetype)sharedJournalManager
+{
+        static PLEditJournalManager * sharedJournalManager = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedJournalManager = [[self alloc] init];
+        });
+        return sharedJournalManager;
+}
+
+-(void)dealloc
+{
+        [recoveredJournals release];
+        [recoveredUntitledJournals release];
+        [super dealloc];
+}
+
+-(NSString *)journalDirectoryPath
+{
+        NSString * applicationSupportPath = [NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES) firstObject];
+        NSString * bundleIdentifier = [[NSBundle mainBundle] bundleIdentifier] ?: @"Liasis";
+
+        return [[applicationSupportPath stringByAppendingPathComponent:bundleIdentifier]
+                stringByAppendingPathComponent:@"Journals"];
+}
+
+#pragma mark - Recovery
+
+/**
+ * \brief Return the key of a file in `recoveredJournals`.
+ */
+-(NSString *)keyForFileURL:(NSURL *)fileURL
+{
+        return [[[fileURL URLByResolvingSymlinksInPath] URLByStandardizingPath] path];
+}
+
+/**
+ * \brief Read the journals left by the last launch.
+ *
+ * \details Files that are not journals, journals without edits, and all but
+ *          the first journal of a file are removed.
+ */
+-(void)readRecoveredJournals
+{
+        NSString * directoryPath = [self journalDirectoryPath], * filePath = nil, * key = nil;
+        PLEditJournal * journal = nil;
+
+        for (NSString * fileName in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directoryPath error:NULL]) {
+                filePath = [directoryPath stringByAppendingPathComponent:fileName];
+                if ([[fileName pathExtension] isEqualToString:PLEditJournalExtension] == NO) {
+                        /* A rewrite cut off by the crash */
+                        if ([[[fileName stringByDeletingPathExtension] pathExtension] isEqualToString:PLEditJournalExtension]) {
+                                unlink([filePath fileSystemRepresentation]);
+                        }
+                        continue;
+                }
+                journal = [PLEditJournal journalWithContentsOfFile:filePath];
+                key = [self keyForFileURL:journal.fileURL];
+                if (journal == nil) {
+                        unlink([filePath fileSystemRepresentation]);
+                } else if ([journal isEmpty] || (key && recoveredJournals[key])) {
+                        [journal discard];
+                } else if (key) {
+                        recoveredJournals[key] = journal;
+                } else {
+                        [recoveredUntitledJournals addObject:journal];
+                }
+        }
+}
+
+-(BOOL)hasJournalForFileURL:(NSURL *)fileURL
+{
+        return fileURL && recoveredJournals[[self keyForFileURL:fileURL]] != nil;
+}
+
+-(PLEditJournal *)claimJournalForFileURL:(NSURL *)fileURL
+{
+        PLEditJournal * journal = nil;
+        NSString * key = nil;
+
+        if (fileURL == nil) {
+                goto exit;
+        }
+        key = [self keyForFileURL:fileURL];
+        journal = [[recoveredJournals[key] retain] autorelease];
+        [recoveredJournals removeObjectForKey:key];
+
+exit:
+        return journal;
+}
+
+-(NSArray *)fileURLsOfRecoveredJournals
+{
+        NSMutableArray * fileURLs = [NSMutableArray array];
+
+        for (PLEditJournal * journal in [recoveredJournals objectEnumerator]) {
+                [fileURLs addObject:journal.fileURL];
+        }
+        return fileURLs;
+}
+
+-(NSArray *)claimUntitledJournals
+{
+        NSArray * journals = [[recoveredUntitledJournals copy] autorelease];
+
+        [recoveredUntitledJournals removeAllObjects];
+        return journals;
+}
+
+#pragma mark - Statistics
+
+-(PLEditJournalStatistics)statistics
+{
+        return statistics;
+}
+
+-(void)recordAppendDuration:(uint64_t)duration
+{
+        BOOL overBudget = duration > PLEditJournalAppendBudget;
+
+        statistics.appends++;
+        statistics.appendTime += duration;
+        statistics.longestAppendTime = MAX(statistics.longestAppendTime, duration);
+        if (overBudget) {
+                statistics.appendsOverBudget++;
+        }
+        if ((overBudget || statistics.appends % PLEditJournalLogInterval == 0) &&
+            [[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                if (overBudget) {
+                        NSLog(@"Edit journal: append took %.1f us, over the %.1f us budget",
+                              duration / 1e3,
+                              PLEditJournalAppendBudget / 1e3);
+                }
+                NSLog(@"Edit journal: %lu appends, mean %.1f us, longest %.1f us, %lu over budget",
+                      (unsigned long)statistics.appends,
+                      statistics.appendTime / 1e3 / statistics.appends,
+                      statistics.longestAppendTime / 1e3,
+                      (unsigned long)statistics.appendsOverBudget);
+        }
+}
+
+-(void)recordCompactionDuration:(uint64_t)duration length:(uint64_t)length
+{
+        statistics.compactions++;
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Edit journal: rewritten to %llu KB, %.2f ms on the main thread",
+                      (unsigned long long)(length / 1024),
+                      duration / 1e6);
+        }
+}
+
+@end
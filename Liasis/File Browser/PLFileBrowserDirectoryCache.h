@@ -0,0 +1,154 @@
+/**
+ * \file PLFileBrowserDirectoryCache.h
+ *
+ * \brief Liasis Python IDE file browser directory cache.
+ *
+ * \details This file includes the object that enumerates directories for the
+ *          file browser in the background and caches their contents.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \class PLFileBrowserDirectoryRecord \headerfile \headerfile
+ *
+ * \brief An immutable record of a directory entry shown by the file browser.
+ *
+ * \details Records, rather than tree nodes, are cached and published so that
+ *          every file browser builds its own `PLFileBrowserItem` nodes, with
+ *          their own parents and expansion state, from a shared listing.
+ */
+@interface PLFileBrowserDirectoryRecord : NSObject
+
+/**
+ * \brief The name of the entry in its directory.
+ */
+@property (copy, readonly) NSString * name;
+
+/**
+ * \brief YES if the entry is a directory.
+ */
+@property (readonly) BOOL isDirectory;
+
+/**
+ * \brief Initialize a directory record.
+ *
+ * \param name The name of the entry in its directory.
+ *
+ * \param isDirectory YES if the entry is a directory.
+ *
+ * \return A `PLFileBrowserDirectoryRecord`.
+ */
+-(instancetype)initWithName:(NSString *)name isDirectory:(BOOL)isDirectory;
+
+@end
+
+/**
+ * \brief The block called on the main queue with each batch of enumerated
+ *        directory records.
+ *
+ * \param records An array of `PLFileBrowserDirectoryRecord` objects in the
+ *                batch.
+ *
+ * \param firstBatch YES if this is the first batch of the enumeration. Any
+ *                   previously displayed contents of the directory should be
+ *                   discarded before adding `records`.
+ *
+ * \param lastBatch YES if this is the last batch of the enumeration.
+ */
+typedef void (^PLFileBrowserDirectoryBatchHandler)(NSArray * records, BOOL firstBatch, BOOL lastBatch);
+
+/**
+ * \class PLFileBrowserDirectoryCache \headerfile \headerfile
+ *
+ * \brief Enumerates directories in the background and caches their contents.
+ *
+ * \details Directories are read with a single `readdir` pass. The type of each
+ *          entry is taken from the directory entry itself, so children are only
+ *          stat'ed when the file system does not report their type (e.g.
+ *          symbolic links). The contents of each directory are cached by path
+ *          along with the directory's modification date, which is checked in
+ *          the background before a cached listing is enumerated again.
+ *
+ *          Only entries shown by the file browser are cached: directories and
+ *          Python source files whose names do not begin with a dot. The cache
+ *          holds `PLFileBrowserDirectoryRecord` objects, never tree nodes.
+ */
+@interface PLFileBrowserDirectoryCache : NSObject
+{
+        /**
+         * \brief The cache of directory listings keyed by directory path.
+         */
+        NSCache * entries;
+
+        /**
+         * \brief The concurrent queue on which directories are enumerated.
+         */
+        dispatch_queue_t enumerationQueue;
+}
+
+/**
+ * \brief The shared directory cache.
+ *
+ * \return The directory cache used by all file browsers.
+ */
++(instancetype)sharedDirectoryCache;
+
+/**
+ * \brief Return the cached contents of a directory without touching the disk.
+ *
+ * \details The returned listing may be stale. Use
+ *          `loadContentsOfDirectoryAtPath:batchHandler:` to refresh it.
+ *
+ * \param path The path of the directory.
+ *
+ * \return An array of `PLFileBrowserDirectoryRecord` objects or nil if the
+ *         directory is not cached.
+ */
+-(NSArray *)cachedContentsOfDirectoryAtPath:(NSString *)path;
+
+/**
+ * \brief Enumerate a directory in the background.
+ *
+ * \details If the cached listing of the directory is still current, as
+ *          determined by the directory's modification date, `batchHandler` is
+ *          called once with the cached records. Otherwise, the directory is
+ *          enumerated and `batchHandler` is called on the main queue with each
+ *          batch of records as they are read. A directory that cannot be read
+ *          yields a single, empty batch.
+ *
+ * \param path The path of the directory.
+ *
+ * \param batchHandler The block called with each batch of items.
+ */
+-(void)loadContentsOfDirectoryAtPath:(NSString *)path batchHandler:(PLFileBrowserDirectoryBatchHandler)batchHandler;
+
+/**
+ * \brief Discard the cached contents of a directory.
+ *
+ * \param path The path of the directory.
+ */
+-(void)removeContentsOfDirectoryAtPath:(NSString *)path;
+
+@end
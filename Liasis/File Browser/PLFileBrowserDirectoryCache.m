@@ -0,0 +1,303 @@
+/**
+ * \file PLFileBrowserDirectoryCache.m
+ *
+ * \brief Liasis Python IDE file browser directory cache.
+ *
+ * \details This file includes the object that enumerates directories for the
+ *          file browser in the background and caches their contents.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLFileBrowserDirectoryCache.h"
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * \brief The number of records published to the file browser at a time.
+ */
+static const NSUInteger PLFileBrowserDirectoryBatchSize = 128;
+
+/**
+ * \brief The maximum number of directory listings kept in the cache.
+ */
+static const NSUInteger PLFileBrowserDirectoryCacheCountLimit = 1024;
+
+#pragma mark -
+
+/**
+ * \class PLFileBrowserDirectoryCacheEntry
+ *
+ * \brief A cached directory listing and the modification date of the directory
+ *        when it was read.
+ */
+@interface PLFileBrowserDirectoryCacheEntry : NSObject
+
+@property (assign) struct timespec modificationDate;
+
+@property (retain) NSArray * records;
+
+@end
+
+@implementation PLFileBrowserDirectoryCacheEntry
+
+-(void)dealloc
+{
+        [_records release];
+        [super dealloc];
+}
+
+@end
+
+#pragma mark -
+
+@implementation PLFileBrowserDirectoryRecord
+
+-(instancetype)initWithName:(NSString *)name isDirectory:(BOOL)isDirectory
+{
+        self = [super init];
+        if (self) {
+                _name = [name copy];
+                _isDirectory = isDirectory;
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [_name release];
+        [super dealloc];
+}
+
+@end
+
+#pragma mark -
+
+@implementation PLFileBrowserDirectoryCache
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                entries = [[NSCache alloc] init];
+                [entries setCountLimit:PLFileBrowserDirectoryCacheCountLimit];
+                enumerationQueue = dispatch_queue_create("org.liasis.filebrowser.enumeration", DISPATCH_QUEUE_CONCURRENT);
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [entries release];
+        dispatch_release(enumerationQueue);
+        [super dealloc];
+}
+
++(instancetype)sharedDirectoryCache
+{
+        static PLFileBrowserDirectoryCache * sharedDirectoryCache = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedDirectoryCache = [[self alloc] init];
+        });
+        return sharedDirectoryCache;
+}
+
+#pragma mark - Cache
+
+-(NSArray *)cachedContentsOfDirectoryAtPath:(NSString *)path
+{
+        return [[entries objectForKey:path] records];
+}
+
+-(void)loadContentsOfDirectoryAtPath:(NSString *)path batchHandler:(PLFileBrowserDirectoryBatchHandler)batchHandler
+{
+        NSString * directoryPath = [[path copy] autorelease];
+
+        dispatch_async(enumerationQueue, ^{
+                @autoreleasepool {
+                        [self enumerateDirectoryAtPath:directoryPath batchHandler:batchHandler];
+                }
+        });
+}
+
+-(void)removeContentsOfDirectoryAtPath:(NSString *)path
+{
+        [entries removeObjectForKey:path];
+}
+
+#pragma mark - Enumeration
+
+/**
+ * \brief Send a batch of records to a batch handler on the main queue.
+ *
+ * \param records The records in the batch.
+ *
+ * \param batchHandler The batch handler.
+ *
+ * \param firstBatch YES if this is the first batch of the enumeration.
+ *
+ * \param lastBatch YES if this is the last batch of the enumeration.
+ */
+-(void)publishRecords:(NSArray *)records toBatchHandler:(PLFileBrowserDirectoryBatchHandler)batchHandler firstBatch:(BOOL)firstBatch lastBatch:(BOOL)lastBatch
+{
+        NSArray * batch = [[records copy] autorelease];
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+                batchHandler(batch, firstBatch, lastBatch);
+        });
+}
+
+/**
+ * \brief Determine if a directory entry should be shown in the file browser.
+ *
+ * \details Entries whose names begin with a dot are never shown. Directories
+ *          are always shown and regular files are shown if they have a .py
+ *          extension. The entry is only stat'ed if its type is not reported by
+ *          `readdir`, which is the case for symbolic links and some network
+ *          file systems.
+ *
+ * \param entry The directory entry.
+ *
+ * \param directoryPath The file system representation of the path of the
+ *                      directory containing the entry.
+ *
+ * \param isDirectory On return, YES if the entry is a directory.
+ *
+ * \return YES if the entry should be shown.
+ */
+-(BOOL)shouldShowEntry:(struct dirent *)entry inDirectory:(const char *)directoryPath isDirectory:(BOOL *)isDirectory
+{
+        BOOL shouldShow = NO;
+        size_t nameLength = strlen(entry->d_name);
+        char entryPath[PATH_MAX];
+        struct stat entryInfo;
+
+        if (entry->d_name[0] == '.') {
+                goto exit;
+        }
+
+        switch (entry->d_type) {
+                case DT_DIR:
+                        *isDirectory = YES;
+                        break;
+                case DT_REG:
+                        *isDirectory = NO;
+                        break;
+                case DT_LNK:
+                case DT_UNKNOWN:
+                        if (snprintf(entryPath, sizeof(entryPath), "%s/%s", directoryPath, entry->d_name) >= (int)sizeof(entryPath) ||
+                            stat(entryPath, &entryInfo) != 0) {
+                                goto exit;
+                        }
+                        *isDirectory = S_ISDIR(entryInfo.st_mode);
+                        break;
+                default:
+                        goto exit;
+        }
+
+        shouldShow = *isDirectory || (nameLength > 3 && strcmp(entry->d_name + nameLength - 3, ".py") == 0);
+
+exit:
+        return shouldShow;
+}
+
+/**
+ * \brief Enumerate a directory and cache its contents.
+ *
+ * \details This method runs on `enumerationQueue`. The directory is opened and
+ *          its modification date compared to the cached listing, publishing
+ *          the cached records as a single batch if the listing is current.
+ *          Otherwise, the entries are read and published to `batchHandler`
+ *          every `PLFileBrowserDirectoryBatchSize` records before caching the
+ *          full listing.
+ *
+ * \param path The path of the directory.
+ *
+ * \param batchHandler The block called with each batch of records.
+ */
+-(void)enumerateDirectoryAtPath:(NSString *)path batchHandler:(PLFileBrowserDirectoryBatchHandler)batchHandler
+{
+        DIR * directory = NULL;
+        struct dirent * entry = NULL;
+        struct stat directoryInfo;
+        const char * directoryPath = [path fileSystemRepresentation];
+        PLFileBrowserDirectoryCacheEntry * cacheEntry = nil;
+        PLFileBrowserDirectoryRecord * record = nil;
+        NSMutableArray * records = nil, * batch = nil;
+        NSString * name = nil;
+        BOOL isDirectory = NO, firstBatch = YES;
+
+        directory = opendir(directoryPath);
+        if (directory == NULL || fstat(dirfd(directory), &directoryInfo) != 0) {
+                [entries removeObjectForKey:path];
+                [self publishRecords:@[] toBatchHandler:batchHandler firstBatch:YES lastBatch:YES];
+                goto exit;
+        }
+
+        /* The directory is not read again if the cached listing is current */
+        cacheEntry = [entries objectForKey:path];
+        if (cacheEntry &&
+            cacheEntry.modificationDate.tv_sec == directoryInfo.st_mtimespec.tv_sec &&
+            cacheEntry.modificationDate.tv_nsec == directoryInfo.st_mtimespec.tv_nsec) {
+                [self publishRecords:cacheEntry.records toBatchHandler:batchHandler firstBatch:YES lastBatch:YES];
+                goto exit;
+        }
+
+        records = [NSMutableArray array];
+        batch = [NSMutableArray arrayWithCapacity:PLFileBrowserDirectoryBatchSize];
+        while ((entry = readdir(directory)) != NULL) {
+                if ([self shouldShowEntry:entry inDirectory:directoryPath isDirectory:&isDirectory] == NO) {
+                        continue;
+                }
+                name = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:entry->d_name
+                                                                                   length:strlen(entry->d_name)];
+                record = [[PLFileBrowserDirectoryRecord alloc] initWithName:name isDirectory:isDirectory];
+                [batch addObject:record];
+                [record release];
+                if ([batch count] == PLFileBrowserDirectoryBatchSize) {
+                        [self publishRecords:batch toBatchHandler:batchHandler firstBatch:firstBatch lastBatch:NO];
+                        [records addObjectsFromArray:batch];
+                        [batch removeAllObjects];
+                        firstBatch = NO;
+                }
+        }
+        [records addObjectsFromArray:batch];
+
+        cacheEntry = [[PLFileBrowserDirectoryCacheEntry alloc] init];
+        cacheEntry.modificationDate = directoryInfo.st_mtimespec;
+        cacheEntry.records = records;
+        [entries setObject:cacheEntry forKey:path];
+        [cacheEntry release];
+        [self publishRecords:batch toBatchHandler:batchHandler firstBatch:firstBatch lastBatch:YES];
+
+exit:
+        if (directory) {
+                closedir(directory);
+        }
+        return;
+}
+
+@end
@@ -0,0 +1,160 @@
+/**
+ * \file PLFileBrowserIconCache.h
+ *
+ * \brief Liasis Python IDE file browser icon cache.
+ *
+ * \details This file includes the cache of the small icons displayed by the
+ *          file browser outline view and directory pop up button.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+
+/**
+ * \brief Posted on the main queue after icons that were returned as
+ *        placeholders have been loaded.
+ *
+ * \details Notifications are coalesced, so a single notification may follow
+ *          many loaded icons. The notification object is the icon cache.
+ */
+extern NSString * const PLFileBrowserIconCacheDidLoadIconsNotification;
+
+/**
+ * \brief The width and height of the cached icons in points.
+ */
+extern const CGFloat PLFileBrowserIconCacheIconWidth;
+
+/**
+ * \class PLFileBrowserIconCache \headerfile \headerfile
+ *
+ * \brief Caches small, pre-rasterized file and folder icons.
+ *
+ * \details Icons are shared by file type rather than stored per path: files
+ *          are keyed by their extension, and folders by their kind, i.e. a
+ *          plain folder or a package with a given extension. Only folders with
+ *          an icon of their own, such as folders with custom icons, volumes,
+ *          applications, and the standard user and system folders, keep an
+ *          icon per path.
+ *
+ *          Each icon is drawn once into a bitmap of `PLFileBrowserIconCacheIconWidth`
+ *          points at the backing scale factor of the main screen, so drawing a
+ *          row never resamples the full-size icon. Icons not yet in the cache
+ *          are loaded in the background, and a generic file or folder icon is
+ *          returned in the meantime. Cached icons are discarded when the
+ *          backing scale factor changes.
+ *
+ *          The cache must only be used from the main thread.
+ */
+@interface PLFileBrowserIconCache : NSObject
+{
+        /**
+         * \brief The cached icons keyed by file type, folder kind, or folder
+         *        path.
+         */
+        NSCache * icons;
+
+        /**
+         * \brief The icon keys of the folders that have been classified,
+         *        keyed by path.
+         */
+        NSCache * folderKeys;
+
+        /**
+         * \brief The keys and folder paths being loaded in the background.
+         */
+        NSMutableSet * pendingLoads;
+
+        /**
+         * \brief The generic file icon returned while an icon is loaded.
+         */
+        NSImage * placeholderFileIcon;
+
+        /**
+         * \brief The generic folder icon returned while an icon is loaded.
+         */
+        NSImage * placeholderFolderIcon;
+
+        /**
+         * \brief The backing scale factor the cached icons were drawn at.
+         */
+        CGFloat backingScaleFactor;
+
+        /**
+         * \brief The serial queue on which icons are loaded.
+         */
+        dispatch_queue_t loadQueue;
+
+        /**
+         * \brief The number of lookups answered from the cache.
+         */
+        NSUInteger hitCount;
+
+        /**
+         * \brief The number of lookups answered with a placeholder.
+         */
+        NSUInteger missCount;
+}
+
+/**
+ * \brief The shared icon cache.
+ *
+ * \return The icon cache used by all file browsers.
+ */
++(instancetype)sharedIconCache;
+
+/**
+ * \brief Get the icon of a file or folder.
+ *
+ * \details If the icon is not cached, a placeholder is returned and the icon is
+ *          loaded in the background. The returned image is shared and must not
+ *          be modified.
+ *
+ * \param path The path of the file or folder.
+ *
+ * \param isDirectory YES if the path is a folder.
+ *
+ * \return The icon, `PLFileBrowserIconCacheIconWidth` points wide.
+ */
+-(NSImage *)iconForPath:(NSString *)path isDirectory:(BOOL)isDirectory;
+
+/**
+ * \brief Discard all cached icons.
+ */
+-(void)removeAllIcons;
+
+/**
+ * \brief The number of lookups answered from the cache.
+ *
+ * \return The hit count.
+ */
+-(NSUInteger)hitCount;
+
+/**
+ * \brief The number of lookups answered with a placeholder while the icon was
+ *        loaded.
+ *
+ * \return The miss count.
+ */
+-(NSUInteger)missCount;
+
+@end
@@ -0,0 +1,414 @@
+/**
+ * \file PLFileBrowserIconCache.m
+ *
+ * \brief Liasis Python IDE file browser icon cache.
+ *
+ * \details This file includes the cache of the small icons displayed by the
+ *          file browser outline view and directory pop up button.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLFileBrowserIconCache.h"
+#include <libkern/OSByteOrder.h>
+#include <string.h>
+#include <sys/attr.h>
+#include <unistd.h>
+
+NSString * const PLFileBrowserIconCacheDidLoadIconsNotification = @"PLFileBrowserIconCacheDidLoadIconsNotification";
+
+const CGFloat PLFileBrowserIconCacheIconWidth = 16.0f;
+
+/**
+ * \brief The maximum number of icons kept in the cache.
+ */
+static const NSUInteger PLFileBrowserIconCacheCountLimit = 512;
+
+/**
+ * \brief The maximum number of classified folders kept in the cache.
+ */
+static const NSUInteger PLFileBrowserIconCacheFolderCountLimit = 4096;
+
+/**
+ * \brief The icon key shared by all plain folders.
+ */
+static NSString * const PLFileBrowserIconCacheFolderKey = @"folder";
+
+/**
+ * \brief Determine if a folder has a custom icon set in the Finder.
+ *
+ * \details The custom icon bit is read from the Finder flags in the folder's
+ *          Finder info.
+ *
+ * \param path The file system representation of the path of the folder.
+ *
+ * \return YES if the folder has a custom icon.
+ */
+static BOOL PLFileBrowserFolderHasCustomIcon(const char * path)
+{
+        struct attrlist attributes;
+        struct {
+                uint32_t length;
+                uint8_t finderInfo[32];
+        } __attribute__((aligned(4), packed)) attributeBuffer;
+
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.bitmapcount = ATTR_BIT_MAP_COUNT;
+        attributes.commonattr = ATTR_CMN_FINDERINFO;
+        if (getattrlist(path, &attributes, &attributeBuffer, sizeof(attributeBuffer), FSOPT_NOFOLLOW) != 0) {
+                return NO;
+        }
+        return (OSReadBigInt16(attributeBuffer.finderInfo, 8) & kHasCustomIcon) != 0;
+}
+
+@implementation PLFileBrowserIconCache
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                icons = [[NSCache alloc] init];
+                [icons setCountLimit:PLFileBrowserIconCacheCountLimit];
+                folderKeys = [[NSCache alloc] init];
+                [folderKeys setCountLimit:PLFileBrowserIconCacheFolderCountLimit];
+                pendingLoads = [[NSMutableSet alloc] init];
+                loadQueue = dispatch_queue_create("org.liasis.filebrowser.icons", DISPATCH_QUEUE_SERIAL);
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [icons release];
+        [folderKeys release];
+        [pendingLoads release];
+        [placeholderFileIcon release];
+        [placeholderFolderIcon release];
+        dispatch_release(loadQueue);
+        [super dealloc];
+}
+
++(instancetype)sharedIconCache
+{
+        static PLFileBrowserIconCache * sharedIconCache = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedIconCache = [[self alloc] init];
+        });
+        return sharedIconCache;
+}
+
+#pragma mark - Icons
+
+-(NSImage *)iconForPath:(NSString *)path isDirectory:(BOOL)isDirectory
+{
+        NSImage * icon = nil;
+        NSString * key = nil;
+        CGFloat scale = [[NSScreen mainScreen] backingScaleFactor];
+
+        if (scale != backingScaleFactor) {
+                [self resetForBackingScaleFactor:scale];
+        }
+
+        if (isDirectory) {
+                key = [folderKeys objectForKey:path];
+        } else {
+                key = [@"type:" stringByAppendingString:[[path pathExtension] lowercaseString]];
+        }
+        icon = key ? [icons objectForKey:key] : nil;
+        if (icon) {
+                hitCount++;
+                goto exit;
+        }
+
+        missCount++;
+        if (isDirectory) {
+                [self loadIconForFolderAtPath:path];
+                icon = placeholderFolderIcon;
+        } else {
+                [self loadIconForKey:key fileType:[[path pathExtension] lowercaseString]];
+                icon = placeholderFileIcon;
+        }
+
+exit:
+        return icon;
+}
+
+-(void)removeAllIcons
+{
+        [icons removeAllObjects];
+        [folderKeys removeAllObjects];
+}
+
+-(NSUInteger)hitCount
+{
+        return hitCount;
+}
+
+-(NSUInteger)missCount
+{
+        return missCount;
+}
+
+/**
+ * \brief Discard the cached icons and draw new placeholders for a backing
+ *        scale factor.
+ *
+ * \param scale The new backing scale factor.
+ */
+-(void)resetForBackingScaleFactor:(CGFloat)scale
+{
+        NSWorkspace * workspace = [NSWorkspace sharedWorkspace];
+
+        [self removeAllIcons];
+        backingScaleFactor = scale;
+        [placeholderFileIcon release];
+        [placeholderFolderIcon release];
+        placeholderFileIcon = [[[self class] rasterizedIcon:[workspace iconForFileType:NSFileTypeForHFSTypeCode(kGenericDocumentIcon)]
+                                                      scale:scale] retain];
+        placeholderFolderIcon = [[[self class] rasterizedIcon:[workspace iconForFileType:NSFileTypeForHFSTypeCode(kGenericFolderIcon)]
+                                                        scale:scale] retain];
+}
+
+#pragma mark - Loading
+
+/**
+ * \brief Load the icon of a file type in the background.
+ *
+ * \param key The key of the icon.
+ *
+ * \param fileType The file extension.
+ */
+-(void)loadIconForKey:(NSString *)key fileType:(NSString *)fileType
+{
+        CGFloat scale = backingScaleFactor;
+
+        if ([pendingLoads containsObject:key]) {
+                goto exit;
+        }
+        [pendingLoads addObject:key];
+
+        dispatch_async(loadQueue, ^{
+                NSImage * icon = nil;
+
+                @autoreleasepool {
+                        icon = [[[self class] rasterizedIcon:[[NSWorkspace sharedWorkspace] iconForFileType:fileType]
+                                                       scale:scale] retain];
+                }
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        [self didLoadIcon:icon forKey:key folderPath:nil scale:scale pendingLoad:key];
+                        [icon release];
+                });
+        });
+
+exit:
+        return;
+}
+
+/**
+ * \brief Classify a folder and load its icon in the background.
+ *
+ * \details The icon is only drawn if the folder has an icon of its own or the
+ *          icon of its kind is not cached yet.
+ *
+ * \param path The path of the folder.
+ */
+-(void)loadIconForFolderAtPath:(NSString *)path
+{
+        NSString * pendingLoad = [@"folder:" stringByAppendingString:path];
+        CGFloat scale = backingScaleFactor;
+
+        if ([pendingLoads containsObject:pendingLoad]) {
+                goto exit;
+        }
+        [pendingLoads addObject:pendingLoad];
+
+        dispatch_async(loadQueue, ^{
+                NSString * key = nil;
+                NSImage * icon = nil, * fullSizeIcon = nil;
+
+                @autoreleasepool {
+                        key = [[[self class] iconKeyForFolderAtPath:path] retain];
+                        if ([icons objectForKey:key] == nil) {
+                                if ([key isEqualToString:PLFileBrowserIconCacheFolderKey]) {
+                                        fullSizeIcon = [[NSWorkspace sharedWorkspace] iconForFileType:NSFileTypeForHFSTypeCode(kGenericFolderIcon)];
+                                } else {
+                                        fullSizeIcon = [[NSWorkspace sharedWorkspace] iconForFile:path];
+                                }
+                                icon = [[[self class] rasterizedIcon:fullSizeIcon scale:scale] retain];
+                        }
+                }
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        [self didLoadIcon:icon forKey:key folderPath:path scale:scale pendingLoad:pendingLoad];
+                        [key release];
+                        [icon release];
+                });
+        });
+
+exit:
+        return;
+}
+
+/**
+ * \brief Store a loaded icon and notify observers.
+ *
+ * \details Icons drawn for a different backing scale factor are discarded.
+ *
+ * \param icon The icon, or nil if the icon of the key was already cached.
+ *
+ * \param key The key of the icon.
+ *
+ * \param folderPath The path of the classified folder, or nil for a file type.
+ *
+ * \param scale The backing scale factor the icon was drawn at.
+ *
+ * \param pendingLoad The entry of the load in `pendingLoads`.
+ */
+-(void)didLoadIcon:(NSImage *)icon forKey:(NSString *)key folderPath:(NSString *)folderPath scale:(CGFloat)scale pendingLoad:(NSString *)pendingLoad
+{
+        [pendingLoads removeObject:pendingLoad];
+        if (scale != backingScaleFactor) {
+                goto exit;
+        }
+
+        if (icon) {
+                [icons setObject:icon forKey:key];
+        }
+        if (folderPath) {
+                [folderKeys setObject:key forKey:folderPath];
+        }
+        [[NSNotificationQueue defaultQueue] enqueueNotification:[NSNotification notificationWithName:PLFileBrowserIconCacheDidLoadIconsNotification
+                                                                                              object:self]
+                                                   postingStyle:NSPostASAP
+                                                   coalesceMask:(NSNotificationCoalescingOnName | NSNotificationCoalescingOnSender)
+                                                       forModes:nil];
+
+exit:
+        return;
+}
+
+#pragma mark - Classification and Drawing
+
+/**
+ * \brief The paths of the standard folders, which have icons of their own.
+ *
+ * \return A set of paths.
+ */
++(NSSet *)standardFolderPaths
+{
+        static NSMutableSet * standardFolderPaths = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                NSSearchPathDirectory directories[] = {NSApplicationDirectory, NSLibraryDirectory, NSUserDirectory,
+                                                       NSDesktopDirectory, NSDocumentDirectory, NSDownloadsDirectory,
+                                                       NSMoviesDirectory, NSMusicDirectory, NSPicturesDirectory,
+                                                       NSSharedPublicDirectory, NSDeveloperDirectory};
+                size_t i = 0;
+
+                standardFolderPaths = [[NSMutableSet alloc] initWithObjects:NSHomeDirectory(), @"/System", nil];
+                for (i = 0; i < sizeof(directories) / sizeof(directories[0]); i++) {
+                        [standardFolderPaths addObjectsFromArray:NSSearchPathForDirectoriesInDomains(directories[i], NSAllDomainsMask, YES)];
+                }
+        });
+        return standardFolderPaths;
+}
+
+/**
+ * \brief Determine the icon key of a folder.
+ *
+ * \details This method touches the disk and runs on `loadQueue`. Plain folders
+ *          share a key, as do packages with the same extension. Folders with
+ *          an icon of their own are keyed by path.
+ *
+ * \param path The path of the folder.
+ *
+ * \return The icon key.
+ */
++(NSString *)iconKeyForFolderAtPath:(NSString *)path
+{
+        NSURL * folderURL = [NSURL fileURLWithPath:path isDirectory:YES];
+        NSString * extension = [[path pathExtension] lowercaseString];
+        NSNumber * isVolume = nil, * isPackage = nil;
+        NSString * key = PLFileBrowserIconCacheFolderKey;
+
+        if ([[self standardFolderPaths] containsObject:path] ||
+            PLFileBrowserFolderHasCustomIcon([path fileSystemRepresentation]) ||
+            ([folderURL getResourceValue:&isVolume forKey:NSURLIsVolumeKey error:NULL] && [isVolume boolValue])) {
+                key = [@"path:" stringByAppendingString:path];
+        } else if ([folderURL getResourceValue:&isPackage forKey:NSURLIsPackageKey error:NULL] && [isPackage boolValue]) {
+                if ([extension isEqualToString:@"app"]) {
+                        key = [@"path:" stringByAppendingString:path];
+                } else {
+                        key = [@"package:" stringByAppendingString:extension];
+                }
+        }
+        return key;
+}
+
+/**
+ * \brief Draw an icon into a bitmap of `PLFileBrowserIconCacheIconWidth`
+ *        points.
+ *
+ * \details The bitmap has `scale` pixels per point, so it is drawn without
+ *          resampling on a screen with that backing scale factor.
+ *
+ * \param icon The full-size icon.
+ *
+ * \param scale The backing scale factor.
+ *
+ * \return An image on the autorelease pool containing only the bitmap.
+ */
++(NSImage *)rasterizedIcon:(NSImage *)icon scale:(CGFloat)scale
+{
+        NSInteger pixelWidth = (NSInteger)ceil(PLFileBrowserIconCacheIconWidth * scale);
+        NSSize iconSize = NSMakeSize(PLFileBrowserIconCacheIconWidth, PLFileBrowserIconCacheIconWidth);
+        NSBitmapImageRep * bitmap = nil;
+        NSImage * rasterizedIcon = nil;
+
+        bitmap = [[[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+                                                          pixelsWide:pixelWidth
+                                                          pixelsHigh:pixelWidth
+                                                       bitsPerSample:8
+                                                     samplesPerPixel:4
+                                                            hasAlpha:YES
+                                                            isPlanar:NO
+                                                      colorSpaceName:NSCalibratedRGBColorSpace
+                                                         bytesPerRow:0
+                                                        bitsPerPixel:0] autorelease];
+        [NSGraphicsContext saveGraphicsState];
+        [NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:bitmap]];
+        [[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationHigh];
+        [icon drawInRect:NSMakeRect(0.0, 0.0, pixelWidth, pixelWidth)
+                fromRect:NSZeroRect
+               operation:NSCompositeCopy
+                fraction:1.0];
+        [NSGraphicsContext restoreGraphicsState];
+        [bitmap setSize:iconSize];
+
+        rasterizedIcon = [[[NSImage alloc] initWithSize:iconSize] autorelease];
+        [rasterizedIcon addRepresentation:bitmap];
+        return rasterizedIcon;
+}
+
+@end
@@ -29,6 +29,30 @@
 
 #import <Foundation/Foundation.h>
 
+/**
+ * \brief Posted before a directory item merges a new listing into its
+ *        children.
+ *
+ * \details The notification object is the `PLFileBrowserItem`. It is only
+ *          posted when the listing changed.
+ */
+extern NSString * const PLFileBrowserItemWillUpdateChildNodesNotification;
+
+/**
+ * \brief Posted after a directory item merged a new listing into its children.
+ *
+ * \details The notification object is the `PLFileBrowserItem`.
+ */
+extern NSString * const PLFileBrowserItemDidUpdateChildNodesNotification;
+
+/**
+ * \brief Posted after a directory item added a batch of children while loading
+ *        them for the first time.
+ *
+ * \details The notification object is the `PLFileBrowserItem`.
+ */
+extern NSString * const PLFileBrowserItemDidAddChildNodesNotification;
+
 /**
  * \class PLFileBrowserItem \headerfile \headerfile
  * \brief A `NSTreeNode` subclass representing an item in the file browser.
@@ -37,8 +61,33 @@
  *          the superclass children methods to return items in the directory.
  *          Its `representedObject` will be the last path component of the full
  *          path, which is exposed as a property.
+ *
+ *          The children of a directory are loaded in the background by the
+ *          `PLFileBrowserDirectoryCache` the first time they are requested and
+ *          are added to the `childNodes` array in batches. Each batch posts a
+ *          key-value observing insertion for the `childNodes` key, so a tree
+ *          controller bound to the items displays children as they arrive.
+ *
+ *          When a directory changes on disk, `reloadChildNodes` reads it again
+ *          and merges the new listing into the existing children, removing
+ *          and inserting only the items that changed.
  */
 @interface PLFileBrowserItem : NSTreeNode
+{
+        /**
+         * \brief The children of the item.
+         *
+         * \details This is nil until the children are first requested.
+         */
+        NSMutableArray * children;
+
+        /**
+         * \brief The number of times the children were loaded.
+         *
+         * \details Batches of a load are ignored once a newer load started.
+         */
+        NSUInteger loadGeneration;
+}
 
 /**
  * \brief The full path to the item in the file browser.
@@ -48,12 +97,18 @@
  */
 @property (retain, readonly) NSString * fullPath;
 
+/**
+ * \brief YES if the item is a directory.
+ */
+@property (readonly) BOOL isDirectory;
+
 /**
  * \brief Initialize a tree node.
  *
  * \details This method creates a new tree node whose `representedObject` is
  *          the last path component of `fullPath`. It stores the full path to
- *          this component as the `fullPath` property.
+ *          this component as the `fullPath` property. The file system is
+ *          queried to determine if the item is a directory.
  *
  * \param fullPath The path to the file browser item.
  *
@@ -61,6 +116,20 @@
  */
 -(instancetype)initWithRepresentedObject:(NSString *)fullPath;
 
+/**
+ * \brief Initialize a tree node whose type is already known.
+ *
+ * \details This is the designated initializer. It is used when enumerating
+ *          directories to avoid querying the file system for each child.
+ *
+ * \param fullPath The path to the file browser item.
+ *
+ * \param isDirectory YES if the item is a directory.
+ *
+ * \return A `PLFileBrowserItem`.
+ */
+-(instancetype)initWithPath:(NSString *)fullPath isDirectory:(BOOL)isDirectory;
+
 /**
  * \brief Factory method to create a new tree node.
  *
@@ -73,4 +142,50 @@
  */
 +(instancetype)treeNodeWithRepresentedObject:(NSString *)fullPath;
 
+/**
+ * \brief Factory method to create a new tree node whose type is already known.
+ *
+ * \param fullPath The path to the file browser item.
+ *
+ * \param isDirectory YES if the item is a directory.
+ *
+ * \return A `PLFileBrowserItem` on the autorelease pool.
+ */
++(instancetype)treeNodeWithPath:(NSString *)fullPath isDirectory:(BOOL)isDirectory;
+
+/**
+ * \brief Determine if the children of the item have been requested.
+ *
+ * \return YES if `childNodes` has been called on a directory item.
+ */
+-(BOOL)hasLoadedChildNodes;
+
+/**
+ * \brief Find a descendant among the children that have been loaded.
+ *
+ * \details This method never touches the disk or loads children.
+ *
+ * \param path The full path of the descendant.
+ *
+ * \return The item whose full path is `path`, which may be the receiver, or
+ *         nil if it is not below the receiver or has not been loaded.
+ */
+-(PLFileBrowserItem *)loadedDescendantAtPath:(NSString *)path;
+
+/**
+ * \brief Read the directory again and merge the changes into the children.
+ *
+ * \details The cached listing of the directory is discarded. Nothing happens
+ *          if the children have not been loaded.
+ */
+-(void)reloadChildNodes;
+
+/**
+ * \brief Reload the children of the item and of every loaded directory below
+ *        it.
+ *
+ * \details Directories whose children have not been loaded are not read.
+ */
+-(void)reloadChildNodesRecursively;
+
 @end
@@ -28,16 +28,31 @@
  */
 
 #import "PLFileBrowserItem.h"
+#import "PLFileBrowserDirectoryCache.h"
+#import "PLFileSystemWatcher.h"
+
+NSString * const PLFileBrowserItemWillUpdateChildNodesNotification = @"PLFileBrowserItemWillUpdateChildNodesNotification";
+NSString * const PLFileBrowserItemDidUpdateChildNodesNotification = @"PLFileBrowserItemDidUpdateChildNodesNotification";
+NSString * const PLFileBrowserItemDidAddChildNodesNotification = @"PLFileBrowserItemDidAddChildNodesNotification";
 
 @implementation PLFileBrowserItem
 
 #pragma mark - Object Lifecycle
 
 -(instancetype)initWithRepresentedObject:(NSString *)fullPath
+{
+        BOOL isDirectory = NO;
+
+        [[NSFileManager defaultManager] fileExistsAtPath:fullPath isDirectory:&isDirectory];
+        return [self initWithPath:fullPath isDirectory:isDirectory];
+}
+
+-(instancetype)initWithPath:(NSString *)fullPath isDirectory:(BOOL)isDirectory
 {
         self = [super initWithRepresentedObject:[fullPath lastPathComponent]];
         if (self) {
                 _fullPath = [fullPath retain];
+                _isDirectory = isDirectory;
         }
         return self;
 }
@@ -47,48 +62,267 @@
         return [super treeNodeWithRepresentedObject:fullPath];
 }
 
++(instancetype)treeNodeWithPath:(NSString *)fullPath isDirectory:(BOOL)isDirectory
+{
+        return [[[self alloc] initWithPath:fullPath isDirectory:isDirectory] autorelease];
+}
+
 /**
- * \brief Release the `fullPath` property and call the superclass method.
+ * \brief Release the `fullPath` property and children and call the superclass
+ *        method.
  */
 -(void)dealloc
 {
         [_fullPath release];
+        [children release];
         [super dealloc];
 }
 
+#pragma mark - Children
+
+/**
+ * \brief Determine if the item is a leaf in the file browser tree.
+ *
+ * \details Without this override, `NSTreeNode` determines if it is a leaf by
+ *          requesting its children, which would read every directory displayed
+ *          in the file browser.
+ *
+ * \return YES if the item is not a directory.
+ */
+-(BOOL)isLeaf
+{
+        return self.isDirectory == NO;
+}
+
 /**
  * \brief Get the children of the object.
  *
  * \details Children are all items within a directory with a .py extension that
- *          do not begin with a dot or are directories themselves.
+ *          do not begin with a dot or are directories themselves. The first
+ *          time this method is called, it returns the cached contents of the
+ *          directory (or an empty array) and starts loading the directory in
+ *          the background. Loaded children are added to the returned array in
+ *          batches.
  *
  * \return An array of `PLFileBrowserItem` objects or nil if the item is not a
  *         directory.
  */
 -(NSArray *)childNodes
 {
-        NSMutableArray * children = nil;
-        NSFileManager * fileManager = nil;
-        NSArray * fileContents = nil;
-        PLFileBrowserItem * newChild = nil;
-        BOOL isDir = NO, fileExists = NO, childIsDir = NO;
-        
-        fileManager = [NSFileManager defaultManager];
-        fileExists = [fileManager fileExistsAtPath:self.fullPath isDirectory:&isDir];
-        
-        if (fileExists && isDir) {
-                fileContents = [fileManager contentsOfDirectoryAtPath:self.fullPath error:NULL];
-                children = [NSMutableArray array];
-                for (NSString * name in fileContents) {
-                        [fileManager fileExistsAtPath:[self.fullPath stringByAppendingPathComponent:name]
-                                          isDirectory:&childIsDir];
-                        if ([name characterAtIndex:0] != '.' && (childIsDir || [[name pathExtension] isEqualToString:@"py"])) {
-                                newChild = [PLFileBrowserItem treeNodeWithRepresentedObject:[self.fullPath stringByAppendingPathComponent:name]];
-                                [children addObject:newChild];
+        NSArray * cachedRecords = nil;
+
+        if (self.isDirectory == NO) {
+                goto exit;
+        }
+
+        if (children == nil) {
+                cachedRecords = [[PLFileBrowserDirectoryCache sharedDirectoryCache] cachedContentsOfDirectoryAtPath:self.fullPath];
+                children = [[NSMutableArray alloc] initWithArray:[self childNodesWithRecords:cachedRecords]];
+                [self loadChildNodes];
+        }
+
+exit:
+        return children;
+}
+
+/**
+ * \brief Create new child items from directory records.
+ *
+ * \details The items are owned by the receiver's tree alone. Cached records
+ *          are shared between file browsers, but their items never are.
+ *
+ * \param records The `PLFileBrowserDirectoryRecord` objects of the directory.
+ *
+ * \return An array of `PLFileBrowserItem` objects.
+ */
+-(NSArray *)childNodesWithRecords:(NSArray *)records
+{
+        NSMutableArray * items = [NSMutableArray arrayWithCapacity:[records count]];
+
+        for (PLFileBrowserDirectoryRecord * record in records) {
+                [items addObject:[PLFileBrowserItem treeNodeWithPath:[self.fullPath stringByAppendingPathComponent:record.name]
+                                                         isDirectory:record.isDirectory]];
+        }
+        return items;
+}
+
+/**
+ * \brief Load the children of the item in the background.
+ *
+ * \details The first time the children are loaded, batches are appended as
+ *          they arrive. If the item already displays children, either from the
+ *          cache or a previous load, the batches are collected and the full
+ *          listing is merged into the children with `updateChildNodes:` so
+ *          unchanged items are kept.
+ *
+ *          Starting a load supersedes any load still running, whose remaining
+ *          batches are ignored, so two loads started before the first batch
+ *          arrives never both append the same items.
+ */
+-(void)loadChildNodes
+{
+        NSMutableArray * loadedItems = [NSMutableArray array];
+        BOOL mergesChildren = ([children count] > 0);
+        NSUInteger generation = ++loadGeneration;
+
+        [[PLFileBrowserDirectoryCache sharedDirectoryCache] loadContentsOfDirectoryAtPath:self.fullPath batchHandler:^(NSArray * records, BOOL firstBatch, BOOL lastBatch) {
+                NSArray * items = nil;
+
+                if (generation != loadGeneration) {
+                        return;
+                }
+                items = [self childNodesWithRecords:records];
+                if (mergesChildren == NO) {
+                        [self addChildNodes:items];
+                } else {
+                        [loadedItems addObjectsFromArray:items];
+                        if (lastBatch) {
+                                [self updateChildNodes:loadedItems];
                         }
                 }
+        }];
+}
+
+-(void)reloadChildNodes
+{
+        if (children == nil) {
+                goto exit;
         }
-        return children;
+        [[PLFileBrowserDirectoryCache sharedDirectoryCache] removeContentsOfDirectoryAtPath:self.fullPath];
+        [self loadChildNodes];
+
+exit:
+        return;
+}
+
+-(void)reloadChildNodesRecursively
+{
+        [self reloadChildNodes];
+        for (PLFileBrowserItem * child in children) {
+                if (child.isDirectory) {
+                        [child reloadChildNodesRecursively];
+                }
+        }
+}
+
+-(BOOL)hasLoadedChildNodes
+{
+        return children != nil;
+}
+
+-(PLFileBrowserItem *)loadedDescendantAtPath:(NSString *)path
+{
+        PLFileBrowserItem * item = nil, * child = nil;
+        NSArray * pathComponents = [path pathComponents];
+        NSUInteger index = [[self.fullPath pathComponents] count];
+
+        if (PLPathIsWithinDirectory(path, self.fullPath) == NO) {
+                goto exit;
+        }
+
+        item = self;
+        for (; item && index < [pathComponents count]; index++) {
+                child = nil;
+                for (PLFileBrowserItem * candidate in item->children) {
+                        if ([[candidate representedObject] isEqualToString:[pathComponents objectAtIndex:index]]) {
+                                child = candidate;
+                                break;
+                        }
+                }
+                item = child;
+        }
+
+exit:
+        return item;
+}
+
+/**
+ * \brief Merge a new listing of the directory into the children.
+ *
+ * \details Children that are no longer in the listing, or whose type changed,
+ *          are removed, and items that are new to the listing are appended.
+ *          Each change posts a single key-value observing removal or insertion
+ *          for the affected indexes, so a tree controller keeps the nodes of
+ *          unchanged children and their expansion state. Nothing is posted if
+ *          the listing is unchanged.
+ *
+ * \param items The `PLFileBrowserItem` objects in the new listing.
+ */
+-(void)updateChildNodes:(NSArray *)items
+{
+        NSMutableDictionary * currentItems = [NSMutableDictionary dictionaryWithCapacity:[children count]];
+        NSMutableIndexSet * removedIndexes = [NSMutableIndexSet indexSet];
+        NSMutableArray * insertedItems = [NSMutableArray array];
+        NSMutableSet * listedPaths = [NSMutableSet setWithCapacity:[items count]];
+        PLFileBrowserItem * currentItem = nil;
+        NSIndexSet * insertedIndexes = nil;
+
+        [children enumerateObjectsUsingBlock:^(PLFileBrowserItem * child, NSUInteger index, BOOL * stop) {
+                [currentItems setObject:child forKey:child.fullPath];
+        }];
+        for (PLFileBrowserItem * item in items) {
+                currentItem = [currentItems objectForKey:item.fullPath];
+                [listedPaths addObject:item.fullPath];
+                if (currentItem == nil || currentItem.isDirectory != item.isDirectory) {
+                        [insertedItems addObject:item];
+                }
+        }
+        [children enumerateObjectsUsingBlock:^(PLFileBrowserItem * child, NSUInteger index, BOOL * stop) {
+                if ([listedPaths containsObject:child.fullPath] == NO) {
+                        [removedIndexes addIndex:index];
+                }
+        }];
+        for (PLFileBrowserItem * item in insertedItems) {
+                currentItem = [currentItems objectForKey:item.fullPath];
+                if (currentItem) {
+                        [removedIndexes addIndex:[children indexOfObjectIdenticalTo:currentItem]];
+                }
+        }
+
+        if ([removedIndexes count] == 0 && [insertedItems count] == 0) {
+                goto exit;
+        }
+
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLFileBrowserItemWillUpdateChildNodesNotification object:self];
+        if ([removedIndexes count] > 0) {
+                [self willChange:NSKeyValueChangeRemoval valuesAtIndexes:removedIndexes forKey:@"childNodes"];
+                [children removeObjectsAtIndexes:removedIndexes];
+                [self didChange:NSKeyValueChangeRemoval valuesAtIndexes:removedIndexes forKey:@"childNodes"];
+        }
+        if ([insertedItems count] > 0) {
+                insertedIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange([children count], [insertedItems count])];
+                [self willChange:NSKeyValueChangeInsertion valuesAtIndexes:insertedIndexes forKey:@"childNodes"];
+                [children addObjectsFromArray:insertedItems];
+                [self didChange:NSKeyValueChangeInsertion valuesAtIndexes:insertedIndexes forKey:@"childNodes"];
+        }
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLFileBrowserItemDidUpdateChildNodesNotification object:self];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Append items to the children, posting a key-value observing insertion
+ *        and a `PLFileBrowserItemDidAddChildNodesNotification`.
+ *
+ * \param items The `PLFileBrowserItem` objects to add.
+ */
+-(void)addChildNodes:(NSArray *)items
+{
+        NSIndexSet * indexes = nil;
+
+        if ([items count] == 0) {
+                goto exit;
+        }
+
+        indexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange([children count], [items count])];
+        [self willChange:NSKeyValueChangeInsertion valuesAtIndexes:indexes forKey:@"childNodes"];
+        [children addObjectsFromArray:items];
+        [self didChange:NSKeyValueChangeInsertion valuesAtIndexes:indexes forKey:@"childNodes"];
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLFileBrowserItemDidAddChildNodesNotification object:self];
+
+exit:
+        return;
 }
 
 @end
@@ -29,6 +29,7 @@
  */
 
 #import "PLFileBrowserOutlineView.h"
+#import "PLThemeTable.h"
 
 @implementation PLFileBrowserOutlineView
 
@@ -36,8 +37,8 @@
  * \brief Delegate method for highlighting selections in the outline view.
  *
  * \details This method highlights the rect of the selected item in the outline
- *          view. It specifies a gradient based on the color returned from a
- *          PLThemeManager to highlight the selection. Highlighting only occurs
+ *          view. It specifies a gradient based on the color returned from the
+ *          PLThemeTable to highlight the selection. Highlighting only occurs
  *          if the outline view is in focus.
  */
 -(void)highlightSelectionInClipRect:(NSRect)clipRect
@@ -49,7 +50,7 @@
         
         if ([self isInFocus]) {
                 NSRect aRowRect = NSInsetRect([self rectOfRow:selectedRowIndex], 1, 1);
-                NSGradient * gradient = [[PLThemeManager defaultThemeManager] selectionGradient];
+                NSGradient * gradient = [[PLThemeTable sharedThemeTable] selectionGradient];
                 [gradient drawInRect:aRowRect angle:90];
         }
 }
@@ -33,6 +33,15 @@
 #import "PLFileBrowserOutlineView.h"
 #import "PLFileBrowserImageAndTextCell.h"
 #import "PLFileBrowserMainView.h"
+#import "PLFileSystemWatcher.h"
+
+/**
+ * \brief Posted when the root directory of a file browser changes or one of
+ *        its items is expanded or collapsed.
+ *
+ * \details The notification object is the `PLFileBrowserViewController`.
+ */
+extern NSString * const PLFileBrowserViewControllerDidChangeStateNotification;
 
 /**
  * \class PLFileBrowserViewController \headerfile \headerfile
@@ -44,6 +53,11 @@
  *          selections in the outline view, and responding to when a user
  *          double clicks items in the file browser. To allow for opening these
  *          files, it exposes an `openDocumentHandler` property.
+ *
+ *          The root directory is watched for changes. Only directories whose
+ *          children are displayed are read again when they change, and their
+ *          new contents are merged into the tree while preserving the expanded
+ *          and selected items.
  */
 @interface PLFileBrowserViewController : NSViewController <NSOutlineViewDelegate, PLThemeable>
 {
@@ -71,6 +85,37 @@
          * \brief The root directory of the file browser.
          */
         NSString * directoryPath;
+
+        /**
+         * \brief The item representing the root directory.
+         *
+         * \details The content array of `treeController` is bound to the
+         *          children of this item.
+         */
+        PLFileBrowserItem * rootItem;
+
+        /**
+         * \brief The watcher reporting changes below the root directory.
+         */
+        PLFileSystemWatcher * watcher;
+
+        /**
+         * \brief The paths of the expanded items, recorded before an item
+         *        merges changes into its children.
+         */
+        NSSet * expandedItemPaths;
+
+        /**
+         * \brief The paths of the selected items, recorded before an item
+         *        merges changes into its children.
+         */
+        NSSet * selectedItemPaths;
+
+        /**
+         * \brief The paths of the items passed to `expandItemsAtPaths:` that
+         *        have not been loaded and expanded yet.
+         */
+        NSMutableSet * pendingExpandedItemPaths;
         
         /**
          * \brief The menu item used in the directory pop up button to select
@@ -96,4 +141,39 @@
  */
 +(instancetype)viewController;
 
+/**
+ * \brief The root directory of the file browser.
+ *
+ * \return The path of the root directory.
+ */
+-(NSString *)directoryRootPath;
+
+/**
+ * \brief Set the root directory of the file browser.
+ *
+ * \param path The path of the new root directory.
+ */
+-(void)setDirectoryRootPath:(NSString *)path;
+
+/**
+ * \brief The paths of the expanded items.
+ *
+ * \details Includes the paths passed to `expandItemsAtPaths:` that are still
+ *          waiting for their parents to load.
+ *
+ * \return An array of paths, parents before their children.
+ */
+-(NSArray *)expandedPaths;
+
+/**
+ * \brief Expand the items at paths below the root directory.
+ *
+ * \details Directories are loaded in the background, so each item is expanded
+ *          once it appears in the outline view. Items whose parents are not
+ *          expanded are not shown, and paths that do not exist are ignored.
+ *
+ * \param paths The paths of the items to expand.
+ */
+-(void)expandItemsAtPaths:(NSArray *)paths;
+
 @end
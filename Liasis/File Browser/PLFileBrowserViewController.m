@@ -28,12 +28,16 @@
  */
 
 #import "PLFileBrowserViewController.h"
+#import "PLFileBrowserIconCache.h"
+#import "PLThemeTable.h"
+
+NSString * const PLFileBrowserViewControllerDidChangeStateNotification = @"PLFileBrowserViewControllerDidChangeStateNotification";
 
 /**
- * \brief The size of icon images used in the directory popup button and file
- *        browser outline view.
+ * \brief The time in seconds that file system changes are coalesced before the
+ *        file browser is updated.
  */
-static const CGFloat PLFileBrowserIconWidth = 16.0f;
+static const NSTimeInterval PLFileBrowserWatcherLatency = 0.25;
 
 @implementation PLFileBrowserViewController
 
@@ -76,6 +80,26 @@ static const CGFloat PLFileBrowserIconWidth = 16.0f;
                                                     keyEquivalent:@""];
                 [directoryPopUpButton setTarget:self];
                 [directoryPopUpButton setAction:@selector(clickedDirectoryPopUpButton:)];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(fileBrowserItemWillUpdate:)
+                                                             name:PLFileBrowserItemWillUpdateChildNodesNotification
+                                                           object:nil];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(fileBrowserItemDidUpdate:)
+                                                             name:PLFileBrowserItemDidUpdateChildNodesNotification
+                                                           object:nil];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(expandPendingItems:)
+                                                             name:PLFileBrowserItemDidUpdateChildNodesNotification
+                                                           object:nil];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(expandPendingItems:)
+                                                             name:PLFileBrowserItemDidAddChildNodesNotification
+                                                           object:nil];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(iconCacheDidLoadIcons:)
+                                                             name:PLFileBrowserIconCacheDidLoadIconsNotification
+                                                           object:[PLFileBrowserIconCache sharedIconCache]];
                 [self setDirectoryRootPath:NSHomeDirectory()];
                 [self updateThemeManager];
         }
@@ -84,6 +108,15 @@ static const CGFloat PLFileBrowserIconWidth = 16.0f;
 
 -(void)dealloc
 {
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [watcher stop];
+        [watcher release];
+        [expandedItemPaths release];
+        [selectedItemPaths release];
+        [pendingExpandedItemPaths release];
+        [treeController unbind:NSContentArrayBinding];
+        [rootItem release];
+        [directoryPath release];
         [otherMenuItem release];
         [super dealloc];
 }
@@ -111,7 +144,8 @@ static const CGFloat PLFileBrowserIconWidth = 16.0f;
  *          the PLOutlineView.
  *
  *          Set the image of the cell if it is a `PLFileBrowserImageAndTextCell`
- *          to the image associated with its file path.
+ *          to the icon of its file type from the shared
+ *          `PLFileBrowserIconCache`.
  *
  * \param anOutlineView The outline view delegate.
  *
@@ -125,28 +159,25 @@ static const CGFloat PLFileBrowserIconWidth = 16.0f;
  */
 -(void)outlineView:(NSOutlineView *)anOutlineView willDisplayCell:(id)cell forTableColumn:(NSTableColumn *)tableColumn item:(id)item
 {
-        NSColor * textColor = nil, * selectionColor = nil;
-        NSImage * cellImage = nil;
+        NSColor * textColor = nil;
+        PLFileBrowserItem * fileBrowserItem = nil;
         
         if ([outlineView isInFocus] == NO) {
                 [cell setHighlighted:NO];
         }
         
         if ([cell isHighlighted]) {
-                selectionColor = [[PLThemeManager defaultThemeManager] getThemeProperty:PLThemeManagerSelection
-                                                                              fromGroup:PLThemeManagerSettings];
-                textColor = [NSColor colorWithInvertedRedGreenBlueComponents:selectionColor];
+                textColor = [[PLThemeTable sharedThemeTable] color:PLThemeColorSelectionText];
                 [cell setHighlighted:NO];
         } else {
-                textColor = [[PLThemeManager defaultThemeManager] getThemeProperty:PLThemeManagerForeground
-                                                                         fromGroup:PLThemeManagerSettings];
+                textColor = [[PLThemeTable sharedThemeTable] color:PLThemeColorForeground];
         }
         [cell setTextColor:textColor];
         
         if ([cell isKindOfClass:[PLFileBrowserImageAndTextCell class]] && [[item representedObject] isKindOfClass:[PLFileBrowserItem class]]) {
-                cellImage = [[NSWorkspace sharedWorkspace] iconForFile:[(PLFileBrowserItem *)[item representedObject] fullPath]];
-                [cellImage setSize:NSMakeSize(PLFileBrowserIconWidth, PLFileBrowserIconWidth)];
-                [(PLFileBrowserImageAndTextCell *)cell setImage:cellImage];
+                fileBrowserItem = [item representedObject];
+                [(PLFileBrowserImageAndTextCell *)cell setImage:[[PLFileBrowserIconCache sharedIconCache] iconForPath:fileBrowserItem.fullPath
+                                                                                                          isDirectory:fileBrowserItem.isDirectory]];
         }
 }
 
@@ -154,7 +185,7 @@ static const CGFloat PLFileBrowserIconWidth = 16.0f;
  * \brief Set the root directory or open a file when the user double clicks an
  *        entry in the file browser outline view.
  *
- * \details If the user double clicks an entry with no children (a file), this
+ * \details If the user double clicks an entry that is not a directory, this
  *          method calls the `openDocumentHandler` with the URL of the file.
  *          If the user double clicks a directory, set it as the new root
  *          directory for the file browser.
@@ -169,7 +200,7 @@ static const CGFloat PLFileBrowserIconWidth = 16.0f;
                 goto exit;
         }
 
-        if ([clickedItem childNodes]) {
+        if (clickedItem.isDirectory) {
                 [self setDirectoryRootPath:clickedItem.fullPath];
         } else if (self.openDocumentHandler) {
                 self.openDocumentHandler([NSURL fileURLWithPath:clickedItem.fullPath]);
@@ -187,12 +218,235 @@ exit:
  */
 -(void)updateThemeManager
 {
-        NSColor * backgroundColor = [[PLThemeManager defaultThemeManager] getThemeProperty:PLThemeManagerBackground
-                                                                                 fromGroup:PLThemeManagerSettings];
+        NSColor * backgroundColor = [[PLThemeTable sharedThemeTable] color:PLThemeColorBackground];
         [(PLFileBrowserMainView *)[self view] setBackgroundColor:backgroundColor];
         [outlineView setBackgroundColor:backgroundColor];
 }
 
+/**
+ * \brief Post a `PLFileBrowserViewControllerDidChangeStateNotification` after
+ *        an item was expanded.
+ *
+ * \param notification The `NSOutlineViewItemDidExpandNotification`.
+ */
+-(void)outlineViewItemDidExpand:(NSNotification *)notification
+{
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLFileBrowserViewControllerDidChangeStateNotification
+                                                            object:self];
+}
+
+/**
+ * \brief Post a `PLFileBrowserViewControllerDidChangeStateNotification` after
+ *        an item was collapsed.
+ *
+ * \param notification The `NSOutlineViewItemDidCollapseNotification`.
+ */
+-(void)outlineViewItemDidCollapse:(NSNotification *)notification
+{
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLFileBrowserViewControllerDidChangeStateNotification
+                                                            object:self];
+}
+
+#pragma mark - File System Changes
+
+/**
+ * \brief Reload the displayed directories that changed on disk.
+ *
+ * \details This method is called by `watcher`. Only directories whose children
+ *          have been loaded are read again; changes to any other directory are
+ *          picked up when it is first expanded.
+ *
+ * \param changedDirectories The paths of the changed directories.
+ *
+ * \param rescannedDirectories The paths of the directories whose descendants
+ *                             must also be treated as changed.
+ */
+-(void)directoriesDidChange:(NSSet *)changedDirectories rescannedDirectories:(NSSet *)rescannedDirectories
+{
+        for (NSString * path in changedDirectories) {
+                [[rootItem loadedDescendantAtPath:path] reloadChildNodes];
+        }
+        for (NSString * path in rescannedDirectories) {
+                if (PLPathIsWithinDirectory(directoryPath, path)) {
+                        [rootItem reloadChildNodesRecursively];
+                } else {
+                        [[rootItem loadedDescendantAtPath:path] reloadChildNodesRecursively];
+                }
+        }
+}
+
+/**
+ * \brief Determine if an item belongs to the tree displayed by this file
+ *        browser.
+ *
+ * \param item The item.
+ *
+ * \return YES if the item is `rootItem` or one of its loaded descendants.
+ */
+-(BOOL)displaysItem:(PLFileBrowserItem *)item
+{
+        return [rootItem loadedDescendantAtPath:item.fullPath] == item;
+}
+
+/**
+ * \brief Record the expanded and selected items before an item in the tree
+ *        merges changes into its children.
+ *
+ * \details Items are recorded by path, since the rows of the outline view
+ *          change when children are removed and inserted.
+ *
+ * \param notification The `PLFileBrowserItemWillUpdateChildNodesNotification`
+ *                     notification.
+ */
+-(void)fileBrowserItemWillUpdate:(NSNotification *)notification
+{
+        NSMutableSet * expandedPaths = nil, * selectedPaths = nil;
+        NSIndexSet * selectedRows = [outlineView selectedRowIndexes];
+        NSInteger row = 0;
+        id node = nil;
+
+        if ([self displaysItem:[notification object]] == NO) {
+                goto exit;
+        }
+
+        expandedPaths = [NSMutableSet set];
+        selectedPaths = [NSMutableSet set];
+        for (row = 0; row < [outlineView numberOfRows]; row++) {
+                node = [outlineView itemAtRow:row];
+                if ([outlineView isItemExpanded:node]) {
+                        [expandedPaths addObject:[[node representedObject] fullPath]];
+                }
+                if ([selectedRows containsIndex:row]) {
+                        [selectedPaths addObject:[[node representedObject] fullPath]];
+                }
+        }
+        [expandedItemPaths release];
+        expandedItemPaths = [expandedPaths copy];
+        [selectedItemPaths release];
+        selectedItemPaths = [selectedPaths copy];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Restore the expanded and selected items after an item in the tree
+ *        merged changes into its children.
+ *
+ * \details Rows are visited in order, so the children of an item expanded
+ *          here are visited as well. Selected items that were removed are
+ *          dropped from the selection.
+ *
+ * \param notification The `PLFileBrowserItemDidUpdateChildNodesNotification`
+ *                     notification.
+ */
+-(void)fileBrowserItemDidUpdate:(NSNotification *)notification
+{
+        NSMutableIndexSet * selectedRows = nil;
+        NSString * path = nil;
+        NSInteger row = 0;
+        id node = nil;
+
+        if (expandedItemPaths == nil || [self displaysItem:[notification object]] == NO) {
+                goto exit;
+        }
+
+        selectedRows = [NSMutableIndexSet indexSet];
+        for (row = 0; row < [outlineView numberOfRows]; row++) {
+                node = [outlineView itemAtRow:row];
+                path = [[node representedObject] fullPath];
+                if ([expandedItemPaths containsObject:path] && [outlineView isItemExpanded:node] == NO) {
+                        [outlineView expandItem:node];
+                }
+                if ([selectedItemPaths containsObject:path]) {
+                        [selectedRows addIndex:row];
+                }
+        }
+        if ([selectedRows isEqualToIndexSet:[outlineView selectedRowIndexes]] == NO) {
+                [outlineView selectRowIndexes:selectedRows byExtendingSelection:NO];
+        }
+        [expandedItemPaths release];
+        expandedItemPaths = nil;
+        [selectedItemPaths release];
+        selectedItemPaths = nil;
+
+exit:
+        return;
+}
+
+#pragma mark - Expanded Items
+
+-(NSArray *)expandedPaths
+{
+        NSMutableArray * paths = [NSMutableArray array];
+        NSInteger row = 0;
+        id node = nil;
+
+        for (row = 0; row < [outlineView numberOfRows]; row++) {
+                node = [outlineView itemAtRow:row];
+                if ([outlineView isItemExpanded:node]) {
+                        [paths addObject:[[node representedObject] fullPath]];
+                }
+        }
+        for (NSString * path in pendingExpandedItemPaths) {
+                if ([paths containsObject:path] == NO) {
+                        [paths addObject:path];
+                }
+        }
+        return paths;
+}
+
+-(void)expandItemsAtPaths:(NSArray *)paths
+{
+        [pendingExpandedItemPaths release];
+        pendingExpandedItemPaths = nil;
+        for (NSString * path in paths) {
+                if (PLPathIsWithinDirectory(path, directoryPath) && [path isEqualToString:directoryPath] == NO) {
+                        if (pendingExpandedItemPaths == nil) {
+                                pendingExpandedItemPaths = [[NSMutableSet alloc] init];
+                        }
+                        [pendingExpandedItemPaths addObject:path];
+                }
+        }
+        [self expandPendingItems:nil];
+}
+
+/**
+ * \brief Expand the displayed items whose paths were passed to
+ *        `expandItemsAtPaths:`.
+ *
+ * \details Called whenever an item in the tree added or merged children.
+ *          Expanding an item loads its children, which calls this method again
+ *          for their descendants. Rows are visited in order, so the children of
+ *          an item expanded here are visited as well.
+ *
+ * \param notification The notification of the item whose children changed, or
+ *                     nil.
+ */
+-(void)expandPendingItems:(NSNotification *)notification
+{
+        NSString * path = nil;
+        NSInteger row = 0;
+        id node = nil;
+
+        if ([pendingExpandedItemPaths count] == 0 ||
+            (notification && [self displaysItem:[notification object]] == NO)) {
+                goto exit;
+        }
+
+        for (row = 0; row < [outlineView numberOfRows] && [pendingExpandedItemPaths count] > 0; row++) {
+                node = [outlineView itemAtRow:row];
+                path = [[node representedObject] fullPath];
+                if ([pendingExpandedItemPaths containsObject:path]) {
+                        [pendingExpandedItemPaths removeObject:path];
+                        [outlineView expandItem:node];
+                }
+        }
+
+exit:
+        return;
+}
+
 #pragma mark - Directory Pop Up Button
 
 /**
@@ -242,12 +496,12 @@ exit:
 -(void)updateDirectoryPopUpButton
 {
         NSMenuItem * menuItem = nil, * titleMenuItem = nil;
-        NSImage * menuImage = nil;
+        NSImage * titleImage = nil;
         NSDictionary * attributes = nil;
         NSMutableParagraphStyle * titleParagraphStyle = nil;
         NSArray * pathComponents = [[NSFileManager defaultManager] componentsToDisplayForPath:directoryPath];
         NSString * currentPath = [NSString stringWithString:directoryPath];
-        CGFloat titleImageWidth = PLFileBrowserIconWidth + 2.0f;
+        CGFloat titleImageWidth = PLFileBrowserIconCacheIconWidth + 2.0f;
         
         [directoryPopUpButton removeAllItems];
         
@@ -256,9 +510,8 @@ exit:
                 menuItem = [[NSMenuItem alloc] initWithTitle:pathComponent
                                                       action:NULL
                                                keyEquivalent:@""];
-                menuImage = [[NSWorkspace sharedWorkspace] iconForFile:currentPath];
-                [menuImage setSize:NSMakeSize(PLFileBrowserIconWidth, PLFileBrowserIconWidth)];
-                [menuItem setImage:menuImage];
+                [menuItem setRepresentedObject:currentPath];
+                [menuItem setImage:[[PLFileBrowserIconCache sharedIconCache] iconForPath:currentPath isDirectory:YES]];
                 [[directoryPopUpButton menu] addItem:menuItem];
                 [menuItem release];
                 currentPath = [currentPath stringByDeletingLastPathComponent];
@@ -269,24 +522,59 @@ exit:
         /* Set font for title cell */
         titleParagraphStyle = [[NSParagraphStyle defaultParagraphStyle] mutableCopy];
         [titleParagraphStyle setLineBreakMode:NSLineBreakByTruncatingMiddle];
-        attributes = @{NSForegroundColorAttributeName: [[PLThemeManager defaultThemeManager] getThemeProperty:PLThemeManagerForeground
-                                                                                                    fromGroup:PLThemeManagerSettings],
+        attributes = @{NSForegroundColorAttributeName: [[PLThemeTable sharedThemeTable] color:PLThemeColorForeground],
                        NSFontAttributeName: [NSFont menuFontOfSize:[NSFont systemFontSize] + 1],
                        NSParagraphStyleAttributeName: titleParagraphStyle};
         titleMenuItem = [directoryPopUpButton itemAtIndex:0];
         [titleMenuItem setAttributedTitle:[[[NSAttributedString alloc] initWithString:[titleMenuItem title]
                                                                            attributes:attributes] autorelease]];
         [titleParagraphStyle release];
-        titleMenuItem.image.size = NSMakeSize(titleImageWidth, titleImageWidth);
+        titleImage = [[titleMenuItem.image copy] autorelease];
+        titleImage.size = NSMakeSize(titleImageWidth, titleImageWidth);
+        titleMenuItem.image = titleImage;
+}
+
+/**
+ * \brief Redraw the icons that were displayed as placeholders.
+ *
+ * \details Redisplay the outline view and reset the images of the directory
+ *          pop up button items from the icon cache.
+ *
+ * \param notification The notification.
+ */
+-(void)iconCacheDidLoadIcons:(NSNotification *)notification
+{
+        NSMenuItem * titleMenuItem = nil;
+        NSImage * titleImage = nil;
+        CGFloat titleImageWidth = PLFileBrowserIconCacheIconWidth + 2.0f;
+
+        [outlineView setNeedsDisplay:YES];
+        for (NSMenuItem * menuItem in [directoryPopUpButton itemArray]) {
+                if ([menuItem representedObject]) {
+                        [menuItem setImage:[[PLFileBrowserIconCache sharedIconCache] iconForPath:[menuItem representedObject] isDirectory:YES]];
+                }
+        }
+        if ([directoryPopUpButton numberOfItems] > 0) {
+                titleMenuItem = [directoryPopUpButton itemAtIndex:0];
+                titleImage = [[titleMenuItem.image copy] autorelease];
+                titleImage.size = NSMakeSize(titleImageWidth, titleImageWidth);
+                titleMenuItem.image = titleImage;
+        }
+}
+
+-(NSString *)directoryRootPath
+{
+        return directoryPath;
 }
 
 /**
  * \brief Set the new root path for the directory pop up button.
  *
- * \details Stores the new path as `directoryPath` and updates `treeController`
- *          to use the children of the new path as its `content`. With this, the
- *          outline view displays the children of the root node. Finally,
- *          call `updateDirectoryPopUpButton` to refresh.
+ * \details Stores the new path as `directoryPath` and binds the content array
+ *          of `treeController` to the children of a new root item. With this,
+ *          the outline view displays the children of the root node as they are
+ *          loaded in the background. A new `watcher` is started for the root
+ *          directory. Finally, call `updateDirectoryPopUpButton` to refresh.
  *
  * \param path The new root path.
  *
@@ -294,20 +582,34 @@ exit:
  */
 -(void)setDirectoryRootPath:(NSString *)path
 {
-        PLFileBrowserItem * rootNode = nil;
-        NSMutableArray * nodes = nil;
-        
+        __block PLFileBrowserViewController * blockSelf = self;
+
         [path retain];
         [directoryPath release];
         directoryPath = path;
-        
-        rootNode = [PLFileBrowserItem treeNodeWithRepresentedObject:directoryPath];
-        nodes = [NSMutableArray array];
-        for (PLFileBrowserItem * child in [rootNode childNodes]) {
-                [nodes addObject:[PLFileBrowserItem treeNodeWithRepresentedObject:child.fullPath]];
-        }
-        [treeController setContent:nodes];
+        [pendingExpandedItemPaths release];
+        pendingExpandedItemPaths = nil;
+
+        [treeController unbind:NSContentArrayBinding];
+        [rootItem release];
+        rootItem = [[PLFileBrowserItem alloc] initWithPath:directoryPath isDirectory:YES];
+        [treeController bind:NSContentArrayBinding
+                    toObject:rootItem
+                 withKeyPath:@"childNodes"
+                     options:nil];
+
+        [watcher stop];
+        [watcher release];
+        watcher = [[PLFileSystemWatcher watcherWithPath:directoryPath
+                                                latency:PLFileBrowserWatcherLatency
+                                           eventHandler:^(NSSet * changedDirectories, NSSet * rescannedDirectories) {
+                                                   [blockSelf directoriesDidChange:changedDirectories
+                                                              rescannedDirectories:rescannedDirectories];
+                                           }] retain];
+        [watcher start];
         [self updateDirectoryPopUpButton];
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLFileBrowserViewControllerDidChangeStateNotification
+                                                            object:self];
 }
 
 @end
@@ -0,0 +1,70 @@
+/**
+ * \file PLFSEventsFileSystemWatcher.h
+ *
+ * \brief Liasis Python IDE FSEvents file system watcher.
+ *
+ * \details This file includes the file system watcher backed by the FSEvents
+ *          API on OS X.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLFileSystemWatcher.h"
+
+#if !defined(__linux__)
+
+#import <CoreServices/CoreServices.h>
+
+/**
+ * \class PLFSEventsFileSystemWatcher \headerfile \headerfile
+ *
+ * \brief A `PLFileSystemWatcher` backed by an FSEvents stream.
+ *
+ * \details FSEvents reports changes at directory granularity for the whole
+ *          tree below the root path with a single stream, and coalesces them
+ *          for the watcher's latency itself. Events the operating system could
+ *          not deliver individually are reported as rescans. FSEvents keeps
+ *          a history of changes per volume, so a watcher can replay the
+ *          changes made while the application was not running.
+ */
+@interface PLFSEventsFileSystemWatcher : PLFileSystemWatcher
+{
+        /**
+         * \brief The event stream, or NULL if the watcher is not running.
+         */
+        FSEventStreamRef eventStream;
+
+        /**
+         * \brief The serial queue on which the event stream delivers events.
+         */
+        dispatch_queue_t eventQueue;
+
+        /**
+         * \brief The root path with symbolic links resolved, as reported by
+         *        FSEvents.
+         */
+        NSString * resolvedPath;
+}
+
+@end
+
+#endif
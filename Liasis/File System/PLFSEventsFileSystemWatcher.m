@@ -0,0 +1,249 @@
+/**
+ * \file PLFSEventsFileSystemWatcher.m
+ *
+ * \brief Liasis Python IDE FSEvents file system watcher.
+ *
+ * \details This file includes the file system watcher backed by the FSEvents
+ *          API on OS X.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLFSEventsFileSystemWatcher.h"
+
+#if !defined(__linux__)
+
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+/**
+ * \brief The event flags indicating that changes below a directory were not
+ *        reported individually.
+ */
+static const FSEventStreamEventFlags PLFSEventsRescanFlags = (kFSEventStreamEventFlagMustScanSubDirs |
+                                                              kFSEventStreamEventFlagUserDropped |
+                                                              kFSEventStreamEventFlagKernelDropped);
+
+@interface PLFSEventsFileSystemWatcher ()
+
+-(void)handleEventPaths:(char **)eventPaths
+                  flags:(const FSEventStreamEventFlags *)eventFlags
+            identifiers:(const FSEventStreamEventId *)eventIdentifiers
+                  count:(size_t)count;
+
+@end
+
+/**
+ * \brief The FSEvents stream callback.
+ *
+ * \details Forward the events to the watcher stored in the stream context.
+ */
+static void PLFSEventsStreamCallback(ConstFSEventStreamRef streamRef,
+                                     void * info,
+                                     size_t numEvents,
+                                     void * eventPaths,
+                                     const FSEventStreamEventFlags eventFlags[],
+                                     const FSEventStreamEventId eventIds[])
+{
+        @autoreleasepool {
+                [(PLFSEventsFileSystemWatcher *)info handleEventPaths:(char **)eventPaths
+                                                                flags:eventFlags
+                                                          identifiers:eventIds
+                                                                count:numEvents];
+        }
+}
+
+@implementation PLFSEventsFileSystemWatcher
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithPath:(NSString *)path latency:(NSTimeInterval)latency eventHandler:(PLFileSystemWatcherEventHandler)eventHandler
+{
+        self = [super initWithPath:path latency:latency eventHandler:eventHandler];
+        if (self) {
+                eventQueue = dispatch_queue_create("org.liasis.filesystem.fsevents", DISPATCH_QUEUE_SERIAL);
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [resolvedPath release];
+        dispatch_release(eventQueue);
+        [super dealloc];
+}
+
+#pragma mark - Watching
+
+/**
+ * \brief Create and start the event stream.
+ *
+ * \details The stream retains the watcher through its context until it is
+ *          released by `stop`. The stream does not defer the first event of a
+ *          burst, so a single change is reported without waiting for the
+ *          latency to expire. If the events after `eventIdentifier` have been
+ *          purged from the history, FSEvents reports a rescan of the root.
+ *
+ * \param eventIdentifier The identifier of the last event already handled.
+ *
+ * \return YES if the stream started.
+ */
+-(BOOL)startSinceEventIdentifier:(uint64_t)eventIdentifier
+{
+        FSEventStreamContext context = {0, self, CFRetain, CFRelease, NULL};
+        char resolvedPathBuffer[PATH_MAX];
+        BOOL started = NO;
+
+        if (self.isRunning) {
+                started = YES;
+                goto exit;
+        }
+
+        [resolvedPath release];
+        if (realpath([self.path fileSystemRepresentation], resolvedPathBuffer)) {
+                resolvedPath = [[[NSFileManager defaultManager] stringWithFileSystemRepresentation:resolvedPathBuffer
+                                                                                            length:strlen(resolvedPathBuffer)] retain];
+        } else {
+                resolvedPath = [self.path retain];
+        }
+
+        eventStream = FSEventStreamCreate(kCFAllocatorDefault,
+                                          &PLFSEventsStreamCallback,
+                                          &context,
+                                          (CFArrayRef)@[resolvedPath],
+                                          (eventIdentifier == PLFileSystemWatcherSinceNow ? kFSEventStreamEventIdSinceNow : eventIdentifier),
+                                          self.latency,
+                                          kFSEventStreamCreateFlagWatchRoot | kFSEventStreamCreateFlagNoDefer);
+        if (eventStream == NULL) {
+                goto exit;
+        }
+        FSEventStreamSetDispatchQueue(eventStream, eventQueue);
+        if (FSEventStreamStart(eventStream) == false) {
+                FSEventStreamInvalidate(eventStream);
+                FSEventStreamRelease(eventStream);
+                eventStream = NULL;
+                goto exit;
+        }
+        started = [super startSinceEventIdentifier:eventIdentifier];
+
+exit:
+        return started;
+}
+
+-(void)stop
+{
+        if (eventStream) {
+                FSEventStreamStop(eventStream);
+                FSEventStreamInvalidate(eventStream);
+                FSEventStreamRelease(eventStream);
+                eventStream = NULL;
+        }
+        [super stop];
+}
+
+/**
+ * \brief FSEvents coalesces events for the latency of the stream, so changes
+ *        are delivered as soon as they arrive.
+ */
+-(NSTimeInterval)coalescingInterval
+{
+        return 0.0;
+}
+
+/**
+ * \brief Identify the FSEvents database of the volume containing the root.
+ *
+ * \return The UUID of the volume's event database as a string, or nil if the
+ *         volume does not keep one.
+ */
+-(NSString *)eventHistoryIdentifier
+{
+        struct stat pathInfo;
+        CFUUIDRef historyUUID = NULL;
+        NSString * historyIdentifier = nil;
+
+        if (stat([self.path fileSystemRepresentation], &pathInfo) != 0) {
+                goto exit;
+        }
+        historyUUID = FSEventsCopyUUIDForDevice(pathInfo.st_dev);
+        if (historyUUID == NULL) {
+                goto exit;
+        }
+        historyIdentifier = [(NSString *)CFUUIDCreateString(kCFAllocatorDefault, historyUUID) autorelease];
+        CFRelease(historyUUID);
+
+exit:
+        return historyIdentifier;
+}
+
+#pragma mark - Events
+
+/**
+ * \brief Report the directories in a list of FSEvents events.
+ *
+ * \details This method runs on `eventQueue`. Event paths are translated from
+ *          `resolvedPath` back to the watcher's path. A change to the root
+ *          directory itself (e.g. it was moved or deleted) is reported as a
+ *          rescan of the root.
+ *
+ * \param eventPaths The file system representations of the event paths.
+ *
+ * \param eventFlags The flags of each event.
+ *
+ * \param eventIdentifiers The identifiers of each event.
+ *
+ * \param count The number of events.
+ */
+-(void)handleEventPaths:(char **)eventPaths
+                  flags:(const FSEventStreamEventFlags *)eventFlags
+            identifiers:(const FSEventStreamEventId *)eventIdentifiers
+                  count:(size_t)count
+{
+        NSString * eventPath = nil;
+        size_t i;
+
+        for (i = 0; i < count; i++) {
+                [self noteEventIdentifier:eventIdentifiers[i]];
+                if (eventFlags[i] & kFSEventStreamEventFlagHistoryDone) {
+                        continue;
+                }
+                if (eventFlags[i] & kFSEventStreamEventFlagRootChanged) {
+                        [self addChangedDirectory:self.path recursive:YES];
+                        continue;
+                }
+                eventPath = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:eventPaths[i]
+                                                                                        length:strlen(eventPaths[i])];
+                if ([eventPath length] > 1 && [eventPath hasSuffix:@"/"]) {
+                        eventPath = [eventPath substringToIndex:[eventPath length] - 1];
+                }
+                if (PLPathIsWithinDirectory(eventPath, resolvedPath) == NO) {
+                        continue;
+                }
+                eventPath = [self.path stringByAppendingString:[eventPath substringFromIndex:[resolvedPath length]]];
+                [self addChangedDirectory:eventPath recursive:(eventFlags[i] & PLFSEventsRescanFlags) != 0];
+        }
+}
+
+@end
+
+#endif
@@ -0,0 +1,256 @@
+/**
+ * \file PLFileSystemWatcher.h
+ *
+ * \brief Liasis Python IDE file system watcher.
+ *
+ * \details This file includes the object that reports changes to the
+ *          directories below a root path.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief The event identifier used to start a watcher without replaying any
+ *        past changes.
+ */
+extern const uint64_t PLFileSystemWatcherSinceNow;
+
+/**
+ * \brief The block called on the main queue with the directories that changed
+ *        since the last time it was called.
+ *
+ * \param changedDirectories The paths of directories whose entries changed. A
+ *                           directory is reported when an item is created,
+ *                           removed, renamed, or written within it.
+ *
+ * \param rescannedDirectories The paths of directories whose changes could not
+ *                             be tracked individually, for example because the
+ *                             operating system dropped events. These
+ *                             directories and every directory below them must
+ *                             be treated as changed.
+ */
+typedef void (^PLFileSystemWatcherEventHandler)(NSSet * changedDirectories, NSSet * rescannedDirectories);
+
+/**
+ * \brief Determine if a path is a directory or lies below it.
+ *
+ * \param path The path to test.
+ *
+ * \param directoryPath The path of the directory.
+ *
+ * \return YES if `path` is equal to `directoryPath` or is a descendant of it.
+ */
+extern BOOL PLPathIsWithinDirectory(NSString * path, NSString * directoryPath);
+
+/**
+ * \class PLFileSystemWatcher \headerfile \headerfile
+ *
+ * \brief Reports changes to the directories below a root path.
+ *
+ * \details This is an abstract class. The `watcherWithPath:latency:eventHandler:`
+ *          factory method returns an instance of the subclass backed by the
+ *          native change notification API of the operating system: FSEvents on
+ *          OS X and inotify on Linux.
+ *
+ *          Subclasses report each change with `addChangedDirectory:recursive:`
+ *          from any thread. Changes are coalesced for `latency` seconds and
+ *          delivered to the event handler on the main queue as sets of
+ *          directory paths, so a burst of changes to one directory (e.g.
+ *          checking out a branch) is delivered once.
+ *
+ *          Paths are always reported relative to the path given to the watcher,
+ *          even if the operating system reports them with symbolic links
+ *          resolved.
+ *
+ *          Backends that keep a persistent history of changes (FSEvents) can
+ *          be started from an event identifier recorded in a previous session,
+ *          replaying every change since then. Clients store
+ *          `lastEventIdentifier` together with `eventHistoryIdentifier`, and
+ *          only replay history if the history identifier still matches.
+ *
+ *          A running watcher is retained by the operating system callbacks.
+ *          Send `stop` before releasing the watcher.
+ */
+@interface PLFileSystemWatcher : NSObject
+{
+        /**
+         * \brief The directories reported since the event handler was last
+         *        called.
+         */
+        NSMutableSet * pendingChangedDirectories;
+
+        /**
+         * \brief The directories reported for a recursive rescan since the
+         *        event handler was last called.
+         */
+        NSMutableSet * pendingRescannedDirectories;
+
+        /**
+         * \brief YES if the event handler is scheduled to be called.
+         */
+        BOOL flushScheduled;
+
+        /**
+         * \brief The identifier of the most recent event reported by the
+         *        operating system.
+         */
+        uint64_t latestEventIdentifier;
+}
+
+/**
+ * \brief The root directory being watched.
+ */
+@property (retain, readonly) NSString * path;
+
+/**
+ * \brief The time in seconds that changes are coalesced before they are
+ *        delivered.
+ */
+@property (readonly) NSTimeInterval latency;
+
+/**
+ * \brief The block called with coalesced changes.
+ */
+@property (copy, readonly) PLFileSystemWatcherEventHandler eventHandler;
+
+/**
+ * \brief YES if the watcher has been started and not stopped.
+ */
+@property (readonly, getter=isRunning) BOOL running;
+
+/**
+ * \brief Factory method to create a watcher for the running operating system.
+ *
+ * \details The watcher is not started.
+ *
+ * \param path The root directory to watch.
+ *
+ * \param latency The time in seconds that changes are coalesced.
+ *
+ * \param eventHandler The block called on the main queue with changes.
+ *
+ * \return A `PLFileSystemWatcher` subclass on the autorelease pool.
+ */
++(instancetype)watcherWithPath:(NSString *)path latency:(NSTimeInterval)latency eventHandler:(PLFileSystemWatcherEventHandler)eventHandler;
+
+/**
+ * \brief Initialize a watcher.
+ *
+ * \details This is the designated initializer.
+ *
+ * \param path The root directory to watch.
+ *
+ * \param latency The time in seconds that changes are coalesced.
+ *
+ * \param eventHandler The block called on the main queue with changes.
+ *
+ * \return A `PLFileSystemWatcher`.
+ */
+-(instancetype)initWithPath:(NSString *)path latency:(NSTimeInterval)latency eventHandler:(PLFileSystemWatcherEventHandler)eventHandler;
+
+/**
+ * \brief Start watching the root directory without replaying past changes.
+ *
+ * \return YES if the watcher started.
+ */
+-(BOOL)start;
+
+/**
+ * \brief Start watching the root directory, replaying the changes that
+ *        occurred after an event.
+ *
+ * \details Backends without an event history ignore `eventIdentifier`.
+ *          Subclasses override this method and must call the superclass
+ *          implementation.
+ *
+ * \param eventIdentifier The identifier of the last event already handled, or
+ *                        `PLFileSystemWatcherSinceNow`.
+ *
+ * \return YES if the watcher started.
+ */
+-(BOOL)startSinceEventIdentifier:(uint64_t)eventIdentifier;
+
+/**
+ * \brief The identifier of the most recent event reported by the operating
+ *        system.
+ *
+ * \return The event identifier, or 0 if the backend has no event history or
+ *         no event has been reported.
+ */
+-(uint64_t)lastEventIdentifier;
+
+/**
+ * \brief Identify the event history that event identifiers refer to.
+ *
+ * \details Event identifiers are only meaningful within one history, e.g. one
+ *          FSEvents database of a volume.
+ *
+ * \return A string identifying the event history of the root directory, or
+ *         nil if the backend has no event history.
+ */
+-(NSString *)eventHistoryIdentifier;
+
+/**
+ * \brief Record the identifier of an event reported by the operating system.
+ *
+ * \details This method is called by subclasses and may be called from any
+ *          thread.
+ *
+ * \param eventIdentifier The event identifier.
+ */
+-(void)noteEventIdentifier:(uint64_t)eventIdentifier;
+
+/**
+ * \brief Stop watching the root directory.
+ *
+ * \details Pending changes are discarded. Subclasses must call the superclass
+ *          implementation.
+ */
+-(void)stop;
+
+/**
+ * \brief Report a changed directory.
+ *
+ * \details This method is called by subclasses and may be called from any
+ *          thread. A rescan of a directory subsumes changes to the directories
+ *          below it.
+ *
+ * \param directoryPath The path of the directory.
+ *
+ * \param recursive YES if every directory below `directoryPath` must be
+ *                  treated as changed.
+ */
+-(void)addChangedDirectory:(NSString *)directoryPath recursive:(BOOL)recursive;
+
+/**
+ * \brief The delay before coalesced changes are delivered.
+ *
+ * \details The default is `latency`. Subclasses whose operating system API
+ *          already coalesces events may return a shorter delay.
+ *
+ * \return The delay in seconds.
+ */
+-(NSTimeInterval)coalescingInterval;
+
+@end
@@ -0,0 +1,211 @@
+/**
+ * \file PLFileSystemWatcher.m
+ *
+ * \brief Liasis Python IDE file system watcher.
+ *
+ * \details This file includes the object that reports changes to the
+ *          directories below a root path.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLFileSystemWatcher.h"
+#if defined(__linux__)
+#import "PLInotifyFileSystemWatcher.h"
+#else
+#import "PLFSEventsFileSystemWatcher.h"
+#endif
+
+const uint64_t PLFileSystemWatcherSinceNow = UINT64_MAX;
+
+BOOL PLPathIsWithinDirectory(NSString * path, NSString * directoryPath)
+{
+        BOOL isWithin = NO;
+
+        if ([path hasPrefix:directoryPath] == NO) {
+                goto exit;
+        }
+
+        isWithin = ([path length] == [directoryPath length] ||
+                    [directoryPath hasSuffix:@"/"] ||
+                    [path characterAtIndex:[directoryPath length]] == '/');
+
+exit:
+        return isWithin;
+}
+
+@interface PLFileSystemWatcher ()
+
+@property (readwrite, getter=isRunning) BOOL running;
+
+@end
+
+@implementation PLFileSystemWatcher
+
+#pragma mark - Object Lifecycle
+
++(instancetype)watcherWithPath:(NSString *)path latency:(NSTimeInterval)latency eventHandler:(PLFileSystemWatcherEventHandler)eventHandler
+{
+        Class watcherClass = Nil;
+
+#if defined(__linux__)
+        watcherClass = [PLInotifyFileSystemWatcher class];
+#else
+        watcherClass = [PLFSEventsFileSystemWatcher class];
+#endif
+        return [[[watcherClass alloc] initWithPath:path latency:latency eventHandler:eventHandler] autorelease];
+}
+
+-(instancetype)initWithPath:(NSString *)path latency:(NSTimeInterval)latency eventHandler:(PLFileSystemWatcherEventHandler)eventHandler
+{
+        self = [super init];
+        if (self) {
+                _path = [path copy];
+                _latency = latency;
+                _eventHandler = [eventHandler copy];
+                pendingChangedDirectories = [[NSMutableSet alloc] init];
+                pendingRescannedDirectories = [[NSMutableSet alloc] init];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [_path release];
+        [_eventHandler release];
+        [pendingChangedDirectories release];
+        [pendingRescannedDirectories release];
+        [super dealloc];
+}
+
+#pragma mark - Watching
+
+-(BOOL)start
+{
+        return [self startSinceEventIdentifier:PLFileSystemWatcherSinceNow];
+}
+
+-(BOOL)startSinceEventIdentifier:(uint64_t)eventIdentifier
+{
+        self.running = YES;
+        return YES;
+}
+
+-(void)stop
+{
+        self.running = NO;
+        @synchronized(self) {
+                [pendingChangedDirectories removeAllObjects];
+                [pendingRescannedDirectories removeAllObjects];
+        }
+}
+
+-(NSTimeInterval)coalescingInterval
+{
+        return self.latency;
+}
+
+#pragma mark - Event History
+
+-(uint64_t)lastEventIdentifier
+{
+        uint64_t eventIdentifier = 0;
+
+        @synchronized(self) {
+                eventIdentifier = latestEventIdentifier;
+        }
+        return eventIdentifier;
+}
+
+-(NSString *)eventHistoryIdentifier
+{
+        return nil;
+}
+
+-(void)noteEventIdentifier:(uint64_t)eventIdentifier
+{
+        @synchronized(self) {
+                if (eventIdentifier > latestEventIdentifier) {
+                        latestEventIdentifier = eventIdentifier;
+                }
+        }
+}
+
+#pragma mark - Changes
+
+-(void)addChangedDirectory:(NSString *)directoryPath recursive:(BOOL)recursive
+{
+        @synchronized(self) {
+                if (recursive) {
+                        [pendingRescannedDirectories addObject:directoryPath];
+                } else {
+                        [pendingChangedDirectories addObject:directoryPath];
+                }
+                if (flushScheduled == NO) {
+                        flushScheduled = YES;
+                        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)([self coalescingInterval] * NSEC_PER_SEC)),
+                                       dispatch_get_main_queue(), ^{
+                                               [self flushChanges];
+                                       });
+                }
+        }
+}
+
+/**
+ * \brief Deliver the pending changes to the event handler.
+ *
+ * \details This method runs on the main queue. Changed directories that lie
+ *          within a rescanned directory are dropped, since the rescan covers
+ *          them.
+ */
+-(void)flushChanges
+{
+        NSMutableSet * changedDirectories = nil;
+        NSSet * rescannedDirectories = nil;
+        NSString * changedDirectory = nil;
+
+        @synchronized(self) {
+                flushScheduled = NO;
+                changedDirectories = [[pendingChangedDirectories mutableCopy] autorelease];
+                rescannedDirectories = [[pendingRescannedDirectories copy] autorelease];
+                [pendingChangedDirectories removeAllObjects];
+                [pendingRescannedDirectories removeAllObjects];
+        }
+
+        if (self.isRunning == NO || ([changedDirectories count] == 0 && [rescannedDirectories count] == 0)) {
+                goto exit;
+        }
+
+        for (NSString * rescannedDirectory in rescannedDirectories) {
+                for (changedDirectory in [changedDirectories allObjects]) {
+                        if (PLPathIsWithinDirectory(changedDirectory, rescannedDirectory)) {
+                                [changedDirectories removeObject:changedDirectory];
+                        }
+                }
+        }
+        self.eventHandler(changedDirectories, rescannedDirectories);
+
+exit:
+        return;
+}
+
+@end
@@ -0,0 +1,76 @@
+/**
+ * \file PLInotifyFileSystemWatcher.h
+ *
+ * \brief Liasis Python IDE inotify file system watcher.
+ *
+ * \details This file includes the file system watcher backed by the inotify
+ *          API on Linux.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLFileSystemWatcher.h"
+
+#if defined(__linux__)
+
+/**
+ * \class PLInotifyFileSystemWatcher \headerfile \headerfile
+ *
+ * \brief A `PLFileSystemWatcher` backed by inotify.
+ *
+ * \details inotify watches are not recursive, so a watch is added for every
+ *          directory below the root path whose name does not begin with a dot
+ *          when the watcher starts, and for every directory created or moved
+ *          into the tree afterwards. An overflow of the kernel event queue is
+ *          reported as a rescan of the root.
+ */
+@interface PLInotifyFileSystemWatcher : PLFileSystemWatcher
+{
+        /**
+         * \brief The inotify file descriptor, or -1 if the watcher is not
+         *        running.
+         *
+         * \details This is only accessed on `eventQueue`.
+         */
+        int inotifyDescriptor;
+
+        /**
+         * \brief The dispatch source reading events from `inotifyDescriptor`.
+         */
+        dispatch_source_t readSource;
+
+        /**
+         * \brief The serial queue on which watches are added and events are
+         *        read.
+         */
+        dispatch_queue_t eventQueue;
+
+        /**
+         * \brief The path of each watched directory keyed by its watch
+         *        descriptor.
+         */
+        NSMutableDictionary * watchedDirectories;
+}
+
+@end
+
+#endif
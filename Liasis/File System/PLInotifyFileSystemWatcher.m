@@ -0,0 +1,329 @@
+/**
+ * \file PLInotifyFileSystemWatcher.m
+ *
+ * \brief Liasis Python IDE inotify file system watcher.
+ *
+ * \details This file includes the file system watcher backed by the inotify
+ *          API on Linux.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLInotifyFileSystemWatcher.h"
+
+#if defined(__linux__)
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * \brief The events watched in each directory.
+ */
+static const uint32_t PLInotifyWatchMask = (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE |
+                                            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW);
+
+/**
+ * \brief The size of the buffer events are read into.
+ */
+#define PLInotifyEventBufferSize 16384
+
+@implementation PLInotifyFileSystemWatcher
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithPath:(NSString *)path latency:(NSTimeInterval)latency eventHandler:(PLFileSystemWatcherEventHandler)eventHandler
+{
+        self = [super initWithPath:path latency:latency eventHandler:eventHandler];
+        if (self) {
+                inotifyDescriptor = -1;
+                eventQueue = dispatch_queue_create("org.liasis.filesystem.inotify", DISPATCH_QUEUE_SERIAL);
+                watchedDirectories = [[NSMutableDictionary alloc] init];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        dispatch_release(eventQueue);
+        [watchedDirectories release];
+        [super dealloc];
+}
+
+#pragma mark - Watching
+
+/**
+ * \brief Create the inotify descriptor and start reading events.
+ *
+ * \details The watches for the directory tree are added on `eventQueue`, so
+ *          this method returns without walking the tree. `inotifyDescriptor`
+ *          is only set and read on `eventQueue`, and the descriptor is closed
+ *          by the cancel handler of the dispatch source, which also runs on
+ *          that queue. The dispatch source retains the watcher until it is
+ *          cancelled by `stop`. inotify keeps no event history, so
+ *          `eventIdentifier` is ignored.
+ *
+ * \param eventIdentifier The identifier of the last event already handled.
+ *
+ * \return YES if the watcher started.
+ */
+-(BOOL)startSinceEventIdentifier:(uint64_t)eventIdentifier
+{
+        BOOL started = NO;
+        int descriptor = -1;
+
+        if (self.isRunning) {
+                started = YES;
+                goto exit;
+        }
+
+        descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (descriptor < 0) {
+                goto exit;
+        }
+        readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, descriptor, 0, eventQueue);
+        dispatch_source_set_event_handler(readSource, ^{
+                @autoreleasepool {
+                        [self readEvents];
+                }
+        });
+        dispatch_source_set_cancel_handler(readSource, ^{
+                close(descriptor);
+        });
+        dispatch_async(eventQueue, ^{
+                @autoreleasepool {
+                        inotifyDescriptor = descriptor;
+                        [watchedDirectories removeAllObjects];
+                        [self addWatchesForDirectoryAtPath:self.path];
+                }
+        });
+        dispatch_resume(readSource);
+        started = [super startSinceEventIdentifier:eventIdentifier];
+
+exit:
+        return started;
+}
+
+/**
+ * \brief Stop reading events.
+ *
+ * \details The dispatch source is cancelled and `inotifyDescriptor` reset on
+ *          `eventQueue`, so no event handler or pending watch runs against the
+ *          descriptor once it is closed, or against a reused descriptor.
+ */
+-(void)stop
+{
+        dispatch_source_t source = readSource;
+
+        if (source) {
+                readSource = NULL;
+                dispatch_sync(eventQueue, ^{
+                        dispatch_source_cancel(source);
+                        inotifyDescriptor = -1;
+                        [watchedDirectories removeAllObjects];
+                });
+                dispatch_release(source);
+        }
+        [super stop];
+}
+
+/**
+ * \brief Add watches for a directory and every directory below it.
+ *
+ * \details This method runs on `eventQueue`. The tree is walked iteratively.
+ *          Directories whose names begin with a dot and symbolic links to
+ *          directories are not watched.
+ *
+ * \param directoryPath The path of the directory.
+ */
+-(void)addWatchesForDirectoryAtPath:(NSString *)directoryPath
+{
+        NSMutableArray * pendingDirectories = [NSMutableArray arrayWithObject:directoryPath];
+        NSString * currentPath = nil;
+
+        while ([pendingDirectories count] > 0) {
+                @autoreleasepool {
+                        currentPath = [[pendingDirectories lastObject] retain];
+                        [pendingDirectories removeLastObject];
+                        [self addWatchForDirectoryAtPath:currentPath subdirectories:pendingDirectories];
+                        [currentPath release];
+                }
+        }
+}
+
+/**
+ * \brief Add a watch for a single directory and collect its subdirectories.
+ *
+ * \param directoryPath The path of the directory.
+ *
+ * \param subdirectories The array the paths of the subdirectories are added
+ *                       to.
+ */
+-(void)addWatchForDirectoryAtPath:(NSString *)directoryPath subdirectories:(NSMutableArray *)subdirectories
+{
+        const char * directoryRepresentation = [directoryPath fileSystemRepresentation];
+        DIR * directory = NULL;
+        struct dirent * entry = NULL;
+        int watchDescriptor = -1;
+        NSString * name = nil;
+        char entryPath[PATH_MAX];
+        struct stat entryInfo;
+
+        watchDescriptor = inotify_add_watch(inotifyDescriptor, directoryRepresentation, PLInotifyWatchMask);
+        if (watchDescriptor < 0) {
+                goto exit;
+        }
+        [watchedDirectories setObject:directoryPath forKey:@(watchDescriptor)];
+
+        directory = opendir(directoryRepresentation);
+        if (directory == NULL) {
+                goto exit;
+        }
+        while ((entry = readdir(directory)) != NULL) {
+                if (entry->d_name[0] == '.') {
+                        continue;
+                }
+                if (entry->d_type == DT_UNKNOWN) {
+                        /* The file system does not report entry types */
+                        if (snprintf(entryPath, sizeof(entryPath), "%s/%s", directoryRepresentation, entry->d_name) >= (int)sizeof(entryPath) ||
+                            lstat(entryPath, &entryInfo) != 0 || S_ISDIR(entryInfo.st_mode) == 0) {
+                                continue;
+                        }
+                } else if (entry->d_type != DT_DIR) {
+                        continue;
+                }
+                name = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:entry->d_name
+                                                                                   length:strlen(entry->d_name)];
+                [subdirectories addObject:[directoryPath stringByAppendingPathComponent:name]];
+        }
+
+exit:
+        if (directory) {
+                closedir(directory);
+        }
+        return;
+}
+
+/**
+ * \brief Remove the watches for a directory and every directory below it.
+ *
+ * \details This method runs on `eventQueue` and is used when a directory is
+ *          moved, since its watch descriptors would otherwise keep reporting
+ *          the old path.
+ *
+ * \param directoryPath The path of the directory.
+ */
+-(void)removeWatchesForDirectoryAtPath:(NSString *)directoryPath
+{
+        for (NSNumber * watchDescriptor in [watchedDirectories allKeys]) {
+                if (PLPathIsWithinDirectory([watchedDirectories objectForKey:watchDescriptor], directoryPath)) {
+                        inotify_rm_watch(inotifyDescriptor, [watchDescriptor intValue]);
+                        [watchedDirectories removeObjectForKey:watchDescriptor];
+                }
+        }
+}
+
+#pragma mark - Events
+
+/**
+ * \brief Read and handle all available events.
+ *
+ * \details This method runs on `eventQueue` when the inotify descriptor is
+ *          readable.
+ */
+-(void)readEvents
+{
+        char buffer[PLInotifyEventBufferSize] __attribute__((aligned(__alignof__(struct inotify_event))));
+        const struct inotify_event * event = NULL;
+        ssize_t length = 0;
+        char * position = NULL;
+
+        while ((length = read(inotifyDescriptor, buffer, sizeof(buffer))) > 0) {
+                for (position = buffer; position < buffer + length; position += sizeof(struct inotify_event) + event->len) {
+                        event = (const struct inotify_event *)position;
+                        [self handleEvent:event];
+                }
+        }
+}
+
+/**
+ * \brief Report the directory changed by an inotify event.
+ *
+ * \details Directories created or moved into the tree are watched and reported
+ *          as rescans, since entries may have been added to them before their
+ *          watches existed. Changes to entries whose names begin with a dot are
+ *          ignored.
+ *
+ * \param event The inotify event.
+ */
+-(void)handleEvent:(const struct inotify_event *)event
+{
+        NSString * directoryPath = nil, * childPath = nil, * name = nil;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+                [self addChangedDirectory:self.path recursive:YES];
+                goto exit;
+        }
+
+        directoryPath = [watchedDirectories objectForKey:@(event->wd)];
+        if (directoryPath == nil) {
+                goto exit;
+        }
+        if (event->mask & IN_IGNORED) {
+                [watchedDirectories removeObjectForKey:@(event->wd)];
+                goto exit;
+        }
+        if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                if ([directoryPath isEqualToString:self.path]) {
+                        [self addChangedDirectory:self.path recursive:YES];
+                }
+                goto exit;
+        }
+        if (event->len == 0 || event->name[0] == '.') {
+                goto exit;
+        }
+
+        name = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:event->name
+                                                                           length:strlen(event->name)];
+        childPath = [directoryPath stringByAppendingPathComponent:name];
+        if (event->mask & IN_ISDIR) {
+                if (event->mask & IN_MOVED_FROM) {
+                        [self removeWatchesForDirectoryAtPath:childPath];
+                }
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        [self addWatchesForDirectoryAtPath:childPath];
+                        [self addChangedDirectory:childPath recursive:YES];
+                }
+        }
+        [self addChangedDirectory:directoryPath recursive:NO];
+
+exit:
+        return;
+}
+
+@end
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * \file PLLargeFileView.h
+ *
+ * \brief Liasis Python IDE large file view.
+ *
+ * \details This file includes the view drawing the visible lines of a file
+ *          too large to be opened as a document.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+#import "PLLineIndex.h"
+#import "PLLineHeightTree.h"
+#import "PLLineLayoutCache.h"
+
+/**
+ * \brief The number of lines whose layouts a `PLLargeFileView` keeps.
+ */
+extern const NSUInteger PLLargeFileViewLayoutCapacity;
+
+/**
+ * \brief The number of lines laid out past the bottom of the drawn rectangle.
+ */
+extern const NSUInteger PLLargeFileViewOverscan;
+
+/**
+ * \brief The estimated or measured heights of the lines of one block of
+ *        `PLLineIndexStride` lines.
+ */
+struct PLLargeFileBlock;
+
+/**
+ * \class PLLargeFileView \headerfile \headerfile
+ *
+ * \brief Lays out and draws the lines of a `PLLineIndex` that are visible.
+ *
+ * \details The view is as tall as all the lines scanned so far, and is meant
+ *          to be the document view of a scroll view. Lines are wrapped to the
+ *          width of the view, and only the lines intersecting the drawn
+ *          rectangle, and `PLLargeFileViewOverscan` lines below it, are laid
+ *          out, so the cost of drawing does not depend on the size of the
+ *          file.
+ *
+ *          The lines are grouped in blocks of `PLLineIndexStride` lines, whose
+ *          heights are kept in a `PLLineHeightTree`, so any vertical position
+ *          is mapped to its line in logarithmic time. A block is first
+ *          estimated as one row per line, then, when one of its lines is
+ *          located, as the rows its line lengths fill, and each line is
+ *          measured exactly when it is laid out. The layouts of the lines are
+ *          kept in a `PLLineLayoutCache` of `PLLargeFileViewLayoutCapacity`
+ *          lines, so scrolling back over lines drawn recently does not lay
+ *          them out again.
+ */
+@interface PLLargeFileView : NSView
+{
+        /**
+         * \brief The height of a row of text in the font.
+         */
+        CGFloat lineHeight;
+
+        /**
+         * \brief The ascent of the font, from the top of a row to its
+         *        baseline.
+         */
+        CGFloat ascent;
+
+        /**
+         * \brief The width of a character in the font.
+         */
+        CGFloat characterWidth;
+
+        /**
+         * \brief The width lines are wrapped to.
+         */
+        CGFloat wrapWidth;
+
+        /**
+         * \brief The attributes of the laid out text.
+         */
+        NSDictionary * textAttributes;
+
+        /**
+         * \brief The blocks of lines scanned so far.
+         */
+        struct PLLargeFileBlock * blocks;
+
+        /**
+         * \brief The number of blocks.
+         */
+        NSUInteger blockCount;
+
+        /**
+         * \brief The number of blocks `blocks` can hold.
+         */
+        NSUInteger blockCapacity;
+
+        /**
+         * \brief The heights of the blocks.
+         */
+        PLLineHeightTree * heightTree;
+
+        /**
+         * \brief The layouts of the lines drawn most recently.
+         */
+        PLLineLayoutCache * layoutCache;
+
+        /**
+         * \brief The time the view was created.
+         */
+        CFTimeInterval creationTime;
+
+        /**
+         * \brief YES once the view has drawn lines.
+         */
+        BOOL drawnLines;
+}
+
+/**
+ * \brief The index of the file.
+ */
+@property (nonatomic, retain) PLLineIndex * lineIndex;
+
+/**
+ * \brief The font of the text.
+ */
+@property (nonatomic, retain) NSFont * font;
+
+/**
+ * \brief The color of the text.
+ */
+@property (nonatomic, retain) NSColor * textColor;
+
+/**
+ * \brief The color of the background.
+ */
+@property (nonatomic, retain) NSColor * backgroundColor;
+
+/**
+ * \brief The color of the background of the highlighted line.
+ */
+@property (nonatomic, retain) NSColor * highlightColor;
+
+/**
+ * \brief The highlighted line, or `NSNotFound` for none.
+ */
+@property (nonatomic) NSUInteger highlightedLine;
+
+/**
+ * \brief Resize the view to the lines scanned so far.
+ *
+ * \details Called whenever the index is updated. The heights of the lines
+ *          found since the last call are estimated.
+ */
+-(void)updateSize;
+
+/**
+ * \brief Scroll a line to the middle of the visible rectangle.
+ *
+ * \param line The line number.
+ */
+-(void)scrollLineToVisible:(NSUInteger)line;
+
+/**
+ * \brief Return the first line visible.
+ *
+ * \return The line number.
+ */
+-(NSUInteger)firstVisibleLine;
+
+@end
@@ -0,0 +1,604 @@
+/**
+ * \file PLLargeFileView.m
+ *
+ * \brief Liasis Python IDE large file view.
+ *
+ * \details This file includes the view drawing the visible lines of a file
+ *          too large to be opened as a document.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <CoreText/CoreText.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLLargeFileView.h"
+#import "PLUserDefaults.h"
+
+const NSUInteger PLLargeFileViewLayoutCapacity = 4096;
+
+const NSUInteger PLLargeFileViewOverscan = 32;
+
+/**
+ * \brief The margin to the left of the text.
+ */
+static const CGFloat PLLargeFileViewMargin = 4.0;
+
+struct PLLargeFileBlock {
+        /**
+         * \brief The number of rows of each line, or NULL while the block is
+         *        estimated as one row per line.
+         */
+        uint16_t * rows;
+
+        /**
+         * \brief The number of lines of the block scanned so far.
+         */
+        NSUInteger lineCount;
+};
+
+typedef struct PLLargeFileBlock PLLargeFileBlock;
+
+@implementation PLLargeFileView
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithFrame:(NSRect)frameRect
+{
+        self = [super initWithFrame:frameRect];
+        if (self) {
+                _highlightedLine = NSNotFound;
+                _textColor = [[NSColor textColor] retain];
+                _backgroundColor = [[NSColor textBackgroundColor] retain];
+                _highlightColor = [[NSColor selectedTextBackgroundColor] retain];
+                heightTree = [[PLLineHeightTree alloc] init];
+                layoutCache = [[PLLineLayoutCache cacheWithCapacity:PLLargeFileViewLayoutCapacity] retain];
+                creationTime = CACurrentMediaTime();
+                [self setAutoresizingMask:NSViewWidthSizable];
+                self.font = [NSFont userFixedPitchFontOfSize:11.0];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        NSUInteger block = 0;
+
+        [NSObject cancelPreviousPerformRequestsWithTarget:self];
+        for (block = 0; block < blockCount; block++) {
+                free(blocks[block].rows);
+        }
+        free(blocks);
+        [heightTree release];
+        [layoutCache release];
+        [_lineIndex release];
+        [_font release];
+        [_textColor release];
+        [_backgroundColor release];
+        [_highlightColor release];
+        [textAttributes release];
+        [super dealloc];
+}
+
+#pragma mark - Properties
+
+-(void)setLineIndex:(PLLineIndex *)lineIndex
+{
+        [lineIndex retain];
+        [_lineIndex release];
+        _lineIndex = lineIndex;
+        [self invalidateLayout];
+        [self updateSize];
+}
+
+-(void)setFont:(NSFont *)font
+{
+        [font retain];
+        [_font release];
+        _font = font;
+        lineHeight = ceil([font ascender] - [font descender] + [font leading]);
+        ascent = ceil([font ascender]);
+        characterWidth = [font maximumAdvancement].width;
+        [self updateTextAttributes];
+        [self updateSize];
+}
+
+-(void)setTextColor:(NSColor *)textColor
+{
+        [textColor retain];
+        [_textColor release];
+        _textColor = textColor;
+        [self setNeedsDisplay:YES];
+}
+
+-(void)setBackgroundColor:(NSColor *)backgroundColor
+{
+        [backgroundColor retain];
+        [_backgroundColor release];
+        _backgroundColor = backgroundColor;
+        [self setNeedsDisplay:YES];
+}
+
+-(void)setHighlightedLine:(NSUInteger)highlightedLine
+{
+        if (_highlightedLine != NSNotFound) {
+                [self setNeedsDisplayInRect:[self rectOfLine:_highlightedLine]];
+        }
+        _highlightedLine = highlightedLine;
+        if (_highlightedLine != NSNotFound) {
+                [self setNeedsDisplayInRect:[self rectOfLine:_highlightedLine]];
+        }
+}
+
+/**
+ * \brief Cache the attributes of the laid out text, and lay the lines out
+ *        again.
+ *
+ * \details The text is drawn in the fill color of the context, so changing
+ *          the text color does not need a new layout.
+ */
+-(void)updateTextAttributes
+{
+        [textAttributes release];
+        textAttributes = [@{NSFontAttributeName: _font,
+                            (id)kCTForegroundColorFromContextAttributeName: @YES} retain];
+        [self invalidateLayout];
+}
+
+#pragma mark - Line Heights
+
+/**
+ * \brief Drop the layouts and the heights of all lines, and estimate them
+ *        again.
+ *
+ * \details Called when the index, the font, or the wrapping width changes.
+ */
+-(void)invalidateLayout
+{
+        NSUInteger block = 0;
+
+        for (block = 0; block < blockCount; block++) {
+                free(blocks[block].rows);
+        }
+        blockCount = 0;
+        [heightTree removeAllHeights];
+        [layoutCache removeAllLayouts];
+        wrapWidth = MAX(NSWidth([self bounds]) - 2.0 * PLLargeFileViewMargin, characterWidth);
+        [self updateBlocks];
+        [self setNeedsDisplay:YES];
+}
+
+/**
+ * \brief Return the height of a block from the rows of its lines.
+ *
+ * \param block The index of the block.
+ *
+ * \return The height.
+ */
+-(CGFloat)heightOfBlock:(NSUInteger)block
+{
+        NSUInteger line = 0, rows = 0;
+
+        if (blocks[block].rows == NULL) {
+                rows = blocks[block].lineCount;
+        } else {
+                for (line = 0; line < blocks[block].lineCount; line++) {
+                        rows += blocks[block].rows[line];
+                }
+        }
+        return rows * lineHeight;
+}
+
+/**
+ * \brief Estimate the rows of lines of a block from their lengths.
+ *
+ * \param block The index of the block, whose rows are allocated.
+ *
+ * \param firstLine The index in the block of the first line estimated.
+ */
+-(void)estimateRowsOfBlock:(NSUInteger)block fromLine:(NSUInteger)firstLine
+{
+        NSUInteger * lengths = malloc(PLLineIndexStride * sizeof(NSUInteger));
+        NSUInteger count = 0, line = 0;
+        uint16_t * rows = blocks[block].rows;
+
+        count = [_lineIndex getLengths:lengths
+                        ofLinesInRange:NSMakeRange(block * PLLineIndexStride + firstLine, blocks[block].lineCount - firstLine)];
+        for (line = firstLine; line < blocks[block].lineCount; line++) {
+                rows[line] = 1;
+                if (line - firstLine < count && lengths[line - firstLine] > 0) {
+                        rows[line] = (uint16_t)MIN(ceil(lengths[line - firstLine] * characterWidth / wrapWidth), (double)UINT16_MAX);
+                }
+        }
+        free(lengths);
+}
+
+/**
+ * \brief Replace the estimate of one row per line of a block by the rows its
+ *        line lengths fill.
+ *
+ * \param block The index of the block.
+ */
+-(void)estimateBlockIfNeeded:(NSUInteger)block
+{
+        if (blocks[block].rows) {
+                goto exit;
+        }
+        blocks[block].rows = malloc(PLLineIndexStride * sizeof(uint16_t));
+        [self estimateRowsOfBlock:block fromLine:0];
+        [heightTree setHeight:[self heightOfBlock:block] atIndex:block];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Add the lines scanned since the last update to the blocks.
+ */
+-(void)updateBlocks
+{
+        NSUInteger lineCount = [_lineIndex lineCount], block = 0, blockLines = 0, firstLine = 0;
+
+        for (block = (blockCount > 0) ? blockCount - 1 : 0; block * PLLineIndexStride < lineCount; block++) {
+                if (block == blockCount) {
+                        if (blockCount == blockCapacity) {
+                                blockCapacity = MAX(2 * blockCapacity, 64);
+                                blocks = realloc(blocks, blockCapacity * sizeof(PLLargeFileBlock));
+                        }
+                        blocks[block] = (PLLargeFileBlock){NULL, 0};
+                        blockCount++;
+                        [heightTree appendHeight:0.0];
+                }
+                blockLines = MIN(PLLineIndexStride, lineCount - block * PLLineIndexStride);
+                if (blocks[block].lineCount != blockLines) {
+                        firstLine = blocks[block].lineCount;
+                        blocks[block].lineCount = blockLines;
+                        if (blocks[block].rows) {
+                                [self estimateRowsOfBlock:block fromLine:firstLine];
+                        }
+                        [heightTree setHeight:[self heightOfBlock:block] atIndex:block];
+                }
+        }
+}
+
+/**
+ * \brief Return the number of lines in the blocks.
+ *
+ * \return The number of lines scanned at the last update.
+ */
+-(NSUInteger)blockLineCount
+{
+        return (blockCount > 0) ? (blockCount - 1) * PLLineIndexStride + blocks[blockCount - 1].lineCount : 0;
+}
+
+/**
+ * \brief Record the measured rows of a line.
+ *
+ * \param rowCount The number of rows the line is wrapped into.
+ *
+ * \param line The line number.
+ *
+ * \return YES if the height of the line changed.
+ */
+-(BOOL)setRowCount:(NSUInteger)rowCount ofLine:(NSUInteger)line
+{
+        NSUInteger block = line / PLLineIndexStride;
+        uint16_t * rows = NULL;
+        BOOL changed = NO;
+
+        rowCount = MIN(rowCount, UINT16_MAX);
+        [self estimateBlockIfNeeded:block];
+        rows = blocks[block].rows;
+        if (rows[line % PLLineIndexStride] != rowCount) {
+                [heightTree setHeight:[heightTree heightAtIndex:block] + ((CGFloat)rowCount - rows[line % PLLineIndexStride]) * lineHeight
+                              atIndex:block];
+                rows[line % PLLineIndexStride] = (uint16_t)rowCount;
+                changed = YES;
+        }
+        return changed;
+}
+
+/**
+ * \brief Return the rectangle of a line.
+ *
+ * \param line The line number.
+ *
+ * \return The rectangle, as wide as the view, or a row below the last line if
+ *         the line is not in the blocks.
+ */
+-(NSRect)rectOfLine:(NSUInteger)line
+{
+        NSUInteger block = line / PLLineIndexStride, index = 0;
+        NSRect rect = NSMakeRect(0.0, [heightTree totalHeight], NSWidth([self bounds]), lineHeight);
+
+        if (line >= [self blockLineCount]) {
+                goto exit;
+        }
+        [self estimateBlockIfNeeded:block];
+        rect.origin.y = [heightTree offsetOfIndex:block];
+        for (index = 0; index < line % PLLineIndexStride; index++) {
+                rect.origin.y += blocks[block].rows[index] * lineHeight;
+        }
+        rect.size.height = blocks[block].rows[index] * lineHeight;
+
+exit:
+        return rect;
+}
+
+/**
+ * \brief Return the line at a vertical position.
+ *
+ * \details The block at the position is estimated from its line lengths
+ *          first, which may move the position to another block.
+ *
+ * \param y The vertical position.
+ *
+ * \return The line number, clamped to the lines scanned so far.
+ */
+-(NSUInteger)lineAtY:(CGFloat)y
+{
+        NSUInteger block = 0, line = 0;
+        CGFloat offset = 0.0;
+
+        if (blockCount == 0) {
+                goto exit;
+        }
+        block = [heightTree indexAtOffset:y];
+        while (blocks[block].rows == NULL) {
+                [self estimateBlockIfNeeded:block];
+                block = [heightTree indexAtOffset:y];
+        }
+        offset = y - [heightTree offsetOfIndex:block];
+        while (line + 1 < blocks[block].lineCount && offset >= blocks[block].rows[line] * lineHeight) {
+                offset -= blocks[block].rows[line] * lineHeight;
+                line++;
+        }
+        line += block * PLLineIndexStride;
+
+exit:
+        return line;
+}
+
+#pragma mark - Layout
+
+-(BOOL)isFlipped
+{
+        return YES;
+}
+
+-(BOOL)isOpaque
+{
+        return YES;
+}
+
+/**
+ * \brief Wrap the lines to the new width, keeping the first visible line at
+ *        the top.
+ *
+ * \param newSize The new size.
+ */
+-(void)setFrameSize:(NSSize)newSize
+{
+        CGFloat previousWidth = NSWidth([self frame]);
+        NSUInteger firstVisibleLine = 0;
+
+        if (newSize.width == previousWidth) {
+                [super setFrameSize:newSize];
+                goto exit;
+        }
+        firstVisibleLine = [self firstVisibleLine];
+        [super setFrameSize:newSize];
+        [self invalidateLayout];
+        [self updateSize];
+        if (firstVisibleLine > 0) {
+                [self scrollPoint:NSMakePoint(0.0, NSMinY([self rectOfLine:firstVisibleLine]))];
+        }
+
+exit:
+        return;
+}
+
+-(void)updateSize
+{
+        NSSize size = [self frame].size;
+        NSSize visibleSize = [[self enclosingScrollView] contentSize];
+
+        [self updateBlocks];
+        if (visibleSize.width > 0.0) {
+                size.width = visibleSize.width;
+        }
+        size.height = MAX(visibleSize.height, [heightTree totalHeight]);
+        if (NSEqualSizes(size, [self frame].size) == NO) {
+                [self setFrameSize:size];
+        }
+}
+
+-(void)scrollLineToVisible:(NSUInteger)line
+{
+        NSRect visibleRect = [self visibleRect];
+        NSRect lineRect = [self rectOfLine:line];
+
+        if (NSContainsRect(visibleRect, lineRect) == NO) {
+                [self scrollPoint:NSMakePoint(NSMinX(visibleRect), MAX(0.0, NSMidY(lineRect) - NSHeight(visibleRect) / 2.0))];
+        }
+}
+
+-(NSUInteger)firstVisibleLine
+{
+        return [self lineAtY:NSMinY([self visibleRect])];
+}
+
+/**
+ * \brief Wrap a line into rows.
+ *
+ * \param text The text of the line.
+ *
+ * \return An array of `CTLine`s.
+ */
+-(NSArray *)layoutOfText:(NSString *)text
+{
+        NSAttributedString * string = [[NSAttributedString alloc] initWithString:text attributes:textAttributes];
+        CTTypesetterRef typesetter = CTTypesetterCreateWithAttributedString((CFAttributedStringRef)string);
+        NSMutableArray * rows = [NSMutableArray arrayWithCapacity:1];
+        CFIndex start = 0, length = (CFIndex)[text length], count = 0;
+        CTLineRef row = NULL;
+
+        do {
+                count = CTTypesetterSuggestLineBreak(typesetter, start, wrapWidth);
+                if (count <= 0) {
+                        count = length - start;
+                }
+                row = CTTypesetterCreateLine(typesetter, CFRangeMake(start, count));
+                [rows addObject:(id)row];
+                CFRelease(row);
+                start += count;
+        } while (start < length);
+        CFRelease(typesetter);
+        [string release];
+        return rows;
+}
+
+/**
+ * \brief Lay out the lines of a range that are not cached.
+ *
+ * \param range The range of line numbers.
+ *
+ * \param heightsChanged Set to YES if the height of a line changed.
+ *
+ * \return The number of lines laid out.
+ */
+-(NSUInteger)layOutLinesInRange:(NSRange)range heightsChanged:(BOOL *)heightsChanged
+{
+        NSArray * texts = nil, * layout = nil;
+        NSUInteger line = 0, textsStart = 0, count = 0;
+
+        for (line = range.location; line < NSMaxRange(range); line++) {
+                if ([layoutCache layoutOfLine:line]) {
+                        continue;
+                }
+                if (texts == nil) {
+                        texts = [_lineIndex linesInRange:NSMakeRange(line, NSMaxRange(range) - line)];
+                        textsStart = line;
+                }
+                if (line - textsStart >= [texts count]) {
+                        break;
+                }
+                layout = [self layoutOfText:texts[line - textsStart]];
+                [layoutCache setLayout:layout ofLine:line];
+                if ([self setRowCount:[layout count] ofLine:line]) {
+                        *heightsChanged = YES;
+                }
+                count++;
+        }
+        return count;
+}
+
+/**
+ * \brief Resize and redraw the view after lines were measured while drawing.
+ */
+-(void)heightsDidChange
+{
+        [self updateSize];
+        [self setNeedsDisplay:YES];
+}
+
+#pragma mark - Drawing
+
+/**
+ * \brief Draw the lines intersecting the dirty rectangle.
+ *
+ * \details The lines are laid out first, with an overscan below them, and
+ *          their measured heights replace the estimates. If a height changed,
+ *          the view is resized and redrawn when the run loop is next free.
+ *
+ *          If the `PLUserDefaultLogPerformance` user default is YES, the time
+ *          of each draw is logged, and the time from the creation of the view
+ *          to its first lines drawn.
+ *
+ * \param dirtyRect The rectangle to draw.
+ */
+-(void)drawRect:(NSRect)dirtyRect
+{
+        CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+        CFTimeInterval startTime = CACurrentMediaTime();
+        NSUInteger lineCount = [self blockLineCount], firstLine = 0, line = 0, laidOutLines = 0, drawnLineCount = 0;
+        NSArray * layout = nil;
+        NSRange range;
+        CGFloat y = 0.0;
+        BOOL heightsChanged = NO;
+
+        [_backgroundColor setFill];
+        NSRectFill(dirtyRect);
+        if (_lineIndex == nil || lineHeight <= 0.0 || blockCount == 0) {
+                goto exit;
+        }
+
+        /* Lay out the lines that may be drawn, each at least one row high */
+        firstLine = [self lineAtY:NSMinY(dirtyRect)];
+        range = NSMakeRange(firstLine, MIN(lineCount - firstLine, (NSUInteger)ceil(NSHeight(dirtyRect) / lineHeight) + 1 + PLLargeFileViewOverscan));
+        laidOutLines = [self layOutLinesInRange:range heightsChanged:&heightsChanged];
+
+        /* Draw them */
+        firstLine = [self lineAtY:NSMinY(dirtyRect)];
+        y = NSMinY([self rectOfLine:firstLine]);
+        CGContextSetTextMatrix(context, CGAffineTransformMakeScale(1.0, -1.0));
+        for (line = firstLine; line < lineCount && y < NSMaxY(dirtyRect); line++) {
+                layout = [layoutCache layoutOfLine:line];
+                if (layout == nil) {
+                        heightsChanged = YES;
+                        break;
+                }
+                if (line == _highlightedLine) {
+                        [_highlightColor setFill];
+                        NSRectFill(NSMakeRect(NSMinX(dirtyRect), y, NSWidth(dirtyRect), [layout count] * lineHeight));
+                }
+                [_textColor setFill];
+                for (id row in layout) {
+                        CGContextSetTextPosition(context, PLLargeFileViewMargin, y + ascent);
+                        CTLineDraw((CTLineRef)row, context);
+                        y += lineHeight;
+                }
+                drawnLineCount++;
+        }
+        if (heightsChanged) {
+                [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(heightsDidChange) object:nil];
+                [self performSelector:@selector(heightsDidChange) withObject:nil afterDelay:0.0];
+        }
+
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                if (drawnLines == NO && drawnLineCount > 0) {
+                        NSLog(@"Large file view: first lines drawn %.2f ms after the view was created",
+                              (CACurrentMediaTime() - creationTime) * 1000.0);
+                }
+                NSLog(@"Large file view: drew %lu lines in %.2f ms, %lu laid out, layout cache %lu hits, %lu misses",
+                      (unsigned long)drawnLineCount,
+                      (CACurrentMediaTime() - startTime) * 1000.0,
+                      (unsigned long)laidOutLines,
+                      (unsigned long)layoutCache.hits,
+                      (unsigned long)layoutCache.misses);
+        }
+        drawnLines = drawnLines || drawnLineCount > 0;
+
+exit:
+        return;
+}
+
+@end
@@ -0,0 +1,118 @@
+/**
+ * \file PLLargeFileViewController.h
+ *
+ * \brief Liasis Python IDE large file viewer.
+ *
+ * \details This file includes the view controller of the read only tab that
+ *          shows files too large to be opened as documents.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+#import <LiasisKit/LiasisKit.h>
+#import "PLLineIndex.h"
+#import "PLLargeFileView.h"
+#import "PLUserDefaults.h"
+
+/**
+ * \brief The default file size from which files are shown in a
+ *        `PLLargeFileViewController`.
+ */
+extern const unsigned long long PLLargeFileDefaultThreshold;
+
+/**
+ * \class PLLargeFileViewController \headerfile \headerfile
+ *
+ * \brief The view controller of the read only tab showing a file too large to
+ *        be opened as a document.
+ *
+ * \details The file is memory mapped by a `PLLineIndex`, which is built in
+ *          the background while the lines scanned so far are shown by a
+ *          `PLLargeFileView`. The search field finds the next occurrence of a
+ *          string after the highlighted line, streaming through the file in
+ *          the background. The status field shows the progress of the index
+ *          and of searches.
+ *
+ *          The tab is owned by the application rather than an add on, so it
+ *          has no document.
+ */
+@interface PLLargeFileViewController : NSViewController <PLTabSubviewController>
+{
+        /**
+         * \brief The index of the file, or nil if it could not be mapped.
+         */
+        PLLineIndex * lineIndex;
+
+        /**
+         * \brief The view drawing the lines.
+         */
+        PLLargeFileView * fileView;
+
+        /**
+         * \brief The field the searched string is typed in.
+         */
+        NSSearchField * searchField;
+
+        /**
+         * \brief The field describing the progress of the index or search.
+         */
+        NSTextField * statusField;
+
+        /**
+         * \brief The offset at which the next search starts.
+         */
+        unsigned long long searchOffset;
+
+        /**
+         * \brief The font last passed to `updateFont:`, or nil.
+         */
+        NSFont * font;
+}
+
+/**
+ * \brief The URL of the file.
+ */
+@property (retain, readonly) NSURL * fileURL;
+
+/**
+ * \brief Check if a file should be shown in a large file viewer.
+ *
+ * \param fileURL The URL of the file.
+ *
+ * \return YES if the file is at least as large as the
+ *         `PLUserDefaultLargeFileThreshold` user default.
+ */
++(BOOL)shouldViewFileAtURL:(NSURL *)fileURL;
+
+/**
+ * \brief Create a viewer of a file.
+ *
+ * \details The file is mapped and its index started when the view is loaded.
+ *
+ * \param fileURL The URL of the file.
+ *
+ * \return A view controller on the autorelease pool.
+ */
++(instancetype)viewControllerWithURL:(NSURL *)fileURL;
+
+@end
@@ -0,0 +1,309 @@
+/**
+ * \file PLLargeFileViewController.m
+ *
+ * \brief Liasis Python IDE large file viewer.
+ *
+ * \details This file includes the view controller of the read only tab that
+ *          shows files too large to be opened as documents.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLLargeFileViewController.h"
+#import "PLThemeTable.h"
+
+const unsigned long long PLLargeFileDefaultThreshold = 64 * 1024 * 1024;
+
+@implementation PLLargeFileViewController
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithURL:(NSURL *)fileURL
+{
+        self = [super initWithNibName:nil bundle:nil];
+        if (self) {
+                _fileURL = [fileURL copy];
+                [self setTitle:[fileURL lastPathComponent]];
+        }
+        return self;
+}
+
++(instancetype)viewControllerWithURL:(NSURL *)fileURL
+{
+        return [[[self alloc] initWithURL:fileURL] autorelease];
+}
+
++(BOOL)shouldViewFileAtURL:(NSURL *)fileURL
+{
+        NSNumber * fileSize = nil;
+        unsigned long long threshold = [[[NSUserDefaults standardUserDefaults] objectForKey:PLUserDefaultLargeFileThreshold] unsignedLongLongValue];
+
+        if (threshold == 0) {
+                threshold = PLLargeFileDefaultThreshold;
+        }
+        [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+        return [fileSize unsignedLongLongValue] >= threshold;
+}
+
+-(void)dealloc
+{
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [lineIndex cancel];
+        [lineIndex release];
+        [fileView release];
+        [searchField release];
+        [statusField release];
+        [font release];
+        [_fileURL release];
+        [super dealloc];
+}
+
+/**
+ * \brief Create the search field, the scrolled file view, and the status
+ *        field, and start building the index of the file.
+ */
+-(void)loadView
+{
+        NSRect bounds = NSMakeRect(0.0, 0.0, 600.0, 400.0);
+        NSView * view = [[[NSView alloc] initWithFrame:bounds] autorelease];
+        NSScrollView * scrollView = nil;
+        NSError * error = nil;
+        CGFloat margin = 8.0, searchFieldHeight = 22.0, statusFieldHeight = 17.0;
+        CGFloat topRow = NSHeight(bounds) - margin - searchFieldHeight;
+
+        [view setAutoresizingMask:(NSViewWidthSizable | NSViewHeightSizable)];
+
+        searchField = [[NSSearchField alloc] initWithFrame:NSMakeRect(margin, topRow, NSWidth(bounds) - 2.0 * margin, searchFieldHeight)];
+        [searchField setAutoresizingMask:(NSViewWidthSizable | NSViewMinYMargin)];
+        [[searchField cell] setPlaceholderString:@"Find in File"];
+        [[searchField cell] setSendsWholeSearchString:YES];
+        [searchField setTarget:self];
+        [searchField setAction:@selector(findNext:)];
+        [view addSubview:searchField];
+
+        statusField = [[NSTextField alloc] initWithFrame:NSMakeRect(margin, margin / 2.0, NSWidth(bounds) - 2.0 * margin, statusFieldHeight)];
+        [statusField setAutoresizingMask:(NSViewWidthSizable | NSViewMaxYMargin)];
+        [statusField setEditable:NO];
+        [statusField setBordered:NO];
+        [statusField setDrawsBackground:NO];
+        [statusField setFont:[NSFont systemFontOfSize:[NSFont smallSystemFontSize]]];
+        [view addSubview:statusField];
+
+        scrollView = [[[NSScrollView alloc] initWithFrame:NSMakeRect(0.0,
+                                                                     margin + statusFieldHeight,
+                                                                     NSWidth(bounds),
+                                                                     topRow - margin - margin - statusFieldHeight)] autorelease];
+        [scrollView setAutoresizingMask:(NSViewWidthSizable | NSViewHeightSizable)];
+        [scrollView setHasVerticalScroller:YES];
+        [scrollView setHasHorizontalScroller:YES];
+        [scrollView setBorderType:NSNoBorder];
+        fileView = [[PLLargeFileView alloc] initWithFrame:NSMakeRect(0.0, 0.0, [scrollView contentSize].width, [scrollView contentSize].height)];
+        if (font) {
+                fileView.font = font;
+        }
+        [scrollView setDocumentView:fileView];
+        [view addSubview:scrollView];
+        [self setView:view];
+
+        lineIndex = [[PLLineIndex lineIndexWithContentsOfURL:_fileURL error:&error] retain];
+        if (lineIndex == nil) {
+                [statusField setStringValue:[NSString stringWithFormat:@"The file could not be mapped: %@", [error localizedDescription]]];
+                goto exit;
+        }
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(lineIndexDidUpdate:)
+                                                     name:PLLineIndexDidUpdateNotification
+                                                   object:lineIndex];
+        fileView.lineIndex = lineIndex;
+        [lineIndex buildInBackground];
+        [self updateStatus];
+
+exit:
+        [self updateThemeManager];
+}
+
+#pragma mark - Index
+
+/**
+ * \brief Grow the file view to the lines scanned so far.
+ *
+ * \param notification The `PLLineIndexDidUpdateNotification`.
+ */
+-(void)lineIndexDidUpdate:(NSNotification *)notification
+{
+        [fileView updateSize];
+        [fileView setNeedsDisplay:YES];
+        [self updateStatus];
+}
+
+/**
+ * \brief Describe the size of the file and the progress of the index.
+ */
+-(void)updateStatus
+{
+        if ([lineIndex isComplete]) {
+                [statusField setStringValue:[NSString stringWithFormat:@"%lu lines · %.1f MB · read only",
+                                             (unsigned long)[lineIndex lineCount],
+                                             (double)[lineIndex length] / 1.0e6]];
+        } else {
+                [statusField setStringValue:[NSString stringWithFormat:@"Indexing… %lu lines · %.0f%% of %.1f MB",
+                                             (unsigned long)[lineIndex lineCount],
+                                             [lineIndex progress] * 100.0,
+                                             (double)[lineIndex length] / 1.0e6]];
+        }
+}
+
+#pragma mark - Searching
+
+/**
+ * \brief Find the next occurrence of the string in the search field.
+ *
+ * \details The search starts after the highlighted line, or at the first
+ *          visible line if no line is highlighted. The line of the match is
+ *          highlighted and scrolled to the middle of the view.
+ *
+ * \param sender The object sending the message.
+ */
+-(IBAction)findNext:(id)sender
+{
+        __block PLLargeFileViewController * blockSelf = self;
+        NSString * string = [searchField stringValue];
+        unsigned long long startOffset = 0;
+
+        if (lineIndex == nil || [string length] == 0) {
+                goto exit;
+        }
+        if (fileView.highlightedLine == NSNotFound) {
+                startOffset = [lineIndex offsetOfLine:[fileView firstVisibleLine]];
+                searchOffset = (startOffset == PLLineIndexNotFound) ? 0 : startOffset;
+        }
+        [statusField setStringValue:@"Searching…"];
+        [lineIndex findString:string fromOffset:searchOffset completionHandler:^(unsigned long long matchOffset) {
+                [blockSelf showMatchAtOffset:matchOffset];
+        }];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Highlight the line of a match.
+ *
+ * \param matchOffset The offset of the match, or `PLLineIndexNotFound`.
+ */
+-(void)showMatchAtOffset:(unsigned long long)matchOffset
+{
+        NSUInteger line = 0;
+
+        if (matchOffset == PLLineIndexNotFound) {
+                [statusField setStringValue:@"Not found"];
+                goto exit;
+        }
+        line = [lineIndex lineContainingOffset:matchOffset];
+        searchOffset = matchOffset + 1;
+        fileView.highlightedLine = line;
+        [fileView updateSize];
+        [fileView scrollLineToVisible:line];
+        [statusField setStringValue:[NSString stringWithFormat:@"Line %lu", (unsigned long)line + 1]];
+
+exit:
+        return;
+}
+
+#pragma mark - Tab Subview Controller
+
+/**
+ * \brief The large file viewer has no document.
+ *
+ * \return nil.
+ */
+-(id)document
+{
+        return nil;
+}
+
+/**
+ * \brief Stop building the index and searching when the tab closes.
+ *
+ * \return YES.
+ */
+-(BOOL)tabSubviewShouldClose:(id)sender
+{
+        [lineIndex cancel];
+        return YES;
+}
+
+/**
+ * \brief Does nothing, as the file is read only.
+ */
+-(IBAction)saveFile:(id)sender
+{
+        return;
+}
+
+/**
+ * \brief Does nothing, as the file is read only.
+ */
+-(IBAction)saveFileAs:(id)sender
+{
+        return;
+}
+
+/**
+ * \brief Focus the search field.
+ *
+ * \return YES if the search field became first responder.
+ */
+-(BOOL)becomeFirstResponder
+{
+        return [[[self view] window] makeFirstResponder:searchField];
+}
+
+#pragma mark - Themeable
+
+/**
+ * \brief Apply the theme's colors to the file view.
+ */
+-(void)updateThemeManager
+{
+        PLThemeTable * themeTable = [PLThemeTable sharedThemeTable];
+
+        fileView.textColor = [themeTable color:PLThemeColorForeground];
+        fileView.backgroundColor = [themeTable color:PLThemeColorBackground];
+        fileView.highlightColor = [themeTable color:PLThemeColorSelection];
+        [statusField setTextColor:[[themeTable color:PLThemeColorForeground] colorWithAlphaComponent:0.6]];
+}
+
+/**
+ * \brief Display the file with a new font.
+ *
+ * \param newFont The font.
+ */
+-(void)updateFont:(NSFont *)newFont
+{
+        [newFont retain];
+        [font release];
+        font = newFont;
+        fileView.font = font;
+}
+
+@end
@@ -0,0 +1,127 @@
+/**
+ * \file PLLineHeightTree.h
+ *
+ * \brief Liasis Python IDE line height tree.
+ *
+ * \details This file includes the prefix sums of the heights of the lines of a
+ *          view, mapping lines to vertical positions and back.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \class PLLineHeightTree \headerfile \headerfile
+ *
+ * \brief The heights of a sequence of lines, or of blocks of lines, with their
+ *        prefix sums.
+ *
+ * \details The heights are kept in a binary indexed tree, so changing a
+ *          height, finding the offset of an item, and finding the item at an
+ *          offset each take logarithmic time in the number of items. A view
+ *          can therefore start with estimated heights and refine them as it
+ *          lays its lines out, and still scroll to any position without
+ *          summing the heights before it.
+ *
+ *          Heights must not be negative.
+ */
+@interface PLLineHeightTree : NSObject
+{
+        /**
+         * \brief The tree, indexed from 1, where element i holds the sum of
+         *        the heights of the items i - (i & -i) to i - 1.
+         */
+        CGFloat * tree;
+
+        /**
+         * \brief The height of each item.
+         */
+        CGFloat * heights;
+
+        /**
+         * \brief The number of items the arrays can hold.
+         */
+        NSUInteger capacity;
+}
+
+/**
+ * \brief The number of items.
+ */
+@property (readonly) NSUInteger count;
+
+/**
+ * \brief The sum of the heights of all items.
+ */
+@property (readonly) CGFloat totalHeight;
+
+/**
+ * \brief Append an item.
+ *
+ * \param height The height of the item.
+ */
+-(void)appendHeight:(CGFloat)height;
+
+/**
+ * \brief Change the height of an item.
+ *
+ * \param height The new height.
+ *
+ * \param index The index of the item, less than `count`.
+ */
+-(void)setHeight:(CGFloat)height atIndex:(NSUInteger)index;
+
+/**
+ * \brief Return the height of an item.
+ *
+ * \param index The index of the item, less than `count`.
+ *
+ * \return The height.
+ */
+-(CGFloat)heightAtIndex:(NSUInteger)index;
+
+/**
+ * \brief Return the offset of an item.
+ *
+ * \param index The index of the item, up to `count`.
+ *
+ * \return The sum of the heights of the items before it.
+ */
+-(CGFloat)offsetOfIndex:(NSUInteger)index;
+
+/**
+ * \brief Return the item at an offset.
+ *
+ * \param offset The offset.
+ *
+ * \return The index of the item spanning the offset, 0 if the offset is
+ *         negative, or `count - 1` if it is past the last item. 0 if there
+ *         are no items.
+ */
+-(NSUInteger)indexAtOffset:(CGFloat)offset;
+
+/**
+ * \brief Remove all items.
+ */
+-(void)removeAllHeights;
+
+@end
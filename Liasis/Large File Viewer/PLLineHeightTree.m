@@ -0,0 +1,120 @@
+/**
+ * \file PLLineHeightTree.m
+ *
+ * \brief Liasis Python IDE line height tree.
+ *
+ * \details This file includes the prefix sums of the heights of the lines of a
+ *          view, mapping lines to vertical positions and back.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLLineHeightTree.h"
+
+@implementation PLLineHeightTree
+
+#pragma mark - Object Lifecycle
+
+-(void)dealloc
+{
+        free(tree);
+        free(heights);
+        [super dealloc];
+}
+
+#pragma mark - Heights
+
+-(CGFloat)totalHeight
+{
+        return [self offsetOfIndex:_count];
+}
+
+-(void)appendHeight:(CGFloat)height
+{
+        NSUInteger index = 0;
+
+        if (_count == capacity) {
+                capacity = MAX(2 * capacity, 64);
+                tree = realloc(tree, (capacity + 1) * sizeof(CGFloat));
+                heights = realloc(heights, capacity * sizeof(CGFloat));
+        }
+        heights[_count] = height;
+        _count++;
+        index = _count;
+        tree[index] = height + [self offsetOfIndex:index - 1] - [self offsetOfIndex:index - (index & -index)];
+}
+
+-(void)setHeight:(CGFloat)height atIndex:(NSUInteger)index
+{
+        CGFloat delta = height - heights[index];
+        NSUInteger node = 0;
+
+        heights[index] = height;
+        for (node = index + 1; node <= _count; node += node & -node) {
+                tree[node] += delta;
+        }
+}
+
+-(CGFloat)heightAtIndex:(NSUInteger)index
+{
+        return heights[index];
+}
+
+-(CGFloat)offsetOfIndex:(NSUInteger)index
+{
+        CGFloat offset = 0.0;
+        NSUInteger node = 0;
+
+        for (node = index; node > 0; node -= node & -node) {
+                offset += tree[node];
+        }
+        return offset;
+}
+
+-(NSUInteger)indexAtOffset:(CGFloat)offset
+{
+        NSUInteger position = 0, step = 1;
+
+        if (_count == 0) {
+                goto exit;
+        }
+        while (step * 2 <= _count) {
+                step *= 2;
+        }
+        for (; step > 0; step /= 2) {
+                if (position + step <= _count && tree[position + step] <= offset) {
+                        position += step;
+                        offset -= tree[position];
+                }
+        }
+        position = MIN(position, _count - 1);
+
+exit:
+        return position;
+}
+
+-(void)removeAllHeights
+{
+        _count = 0;
+}
+
+@end
@@ -0,0 +1,234 @@
+/**
+ * \file PLLineIndex.h
+ *
+ * \brief Liasis Python IDE line index of a memory mapped file.
+ *
+ * \details This file includes the sparse index of the line offsets of a file
+ *          too large to be opened as a document.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief Posted on the main thread, at most once per pass of the run loop,
+ *        while the index is being built and when it is complete.
+ *
+ * \details The notification object is the `PLLineIndex`.
+ */
+extern NSString * const PLLineIndexDidUpdateNotification;
+
+/**
+ * \brief The number of lines between two recorded line offsets.
+ */
+extern const NSUInteger PLLineIndexStride;
+
+/**
+ * \brief The number of bytes of a line that are decoded for display.
+ */
+extern const NSUInteger PLLineIndexMaximumLineLength;
+
+/**
+ * \brief The offset returned when a line or match is not found.
+ */
+extern const unsigned long long PLLineIndexNotFound;
+
+/**
+ * \class PLLineIndex \headerfile \headerfile
+ *
+ * \brief Locates the lines of a memory mapped file.
+ *
+ * \details The file is memory mapped, so only the pages that are read are
+ *          brought into memory, and the system can drop them again at will.
+ *
+ *          `buildInBackground` scans the file for line feeds on a background
+ *          queue and records the offset of every `PLLineIndexStride`th line,
+ *          so the index of a file with a hundred million lines takes under a
+ *          megabyte. Line feeds are counted sixteen bytes at a time with
+ *          vector comparisons, and blocks without a recorded line are skipped
+ *          after being counted. A line is found from the nearest recorded
+ *          offset before it, scanning forward at most `PLLineIndexStride`
+ *          lines.
+ *
+ *          The lines scanned so far may be read while the index is being
+ *          built. The index must be read from the main thread.
+ */
+@interface PLLineIndex : NSObject
+{
+        /**
+         * \brief The memory mapped contents of the file.
+         */
+        NSData * data;
+
+        /**
+         * \brief The offset of every `PLLineIndexStride`th line, starting with
+         *        line 0.
+         */
+        unsigned long long * checkpoints;
+
+        /**
+         * \brief The number of recorded offsets.
+         */
+        NSUInteger checkpointCount;
+
+        /**
+         * \brief The number of offsets `checkpoints` can hold.
+         */
+        NSUInteger checkpointCapacity;
+
+        /**
+         * \brief The number of line feeds found so far.
+         */
+        NSUInteger newlineCount;
+
+        /**
+         * \brief The number of bytes scanned so far.
+         */
+        unsigned long long indexedLength;
+
+        /**
+         * \brief The generation of the most recent search, incremented to
+         *        cancel the searches before it.
+         */
+        volatile int32_t searchGeneration;
+
+        /**
+         * \brief YES once the index should stop being built.
+         */
+        volatile BOOL cancelled;
+}
+
+/**
+ * \brief The length of the file in bytes.
+ */
+@property (readonly) unsigned long long length;
+
+/**
+ * \brief The number of lines found so far, including the last line once the
+ *        index is complete.
+ */
+@property (readonly) NSUInteger lineCount;
+
+/**
+ * \brief The fraction of the file scanned, from 0 to 1.
+ */
+@property (readonly) double progress;
+
+/**
+ * \brief YES once the whole file has been scanned.
+ */
+@property (readonly, getter=isComplete) BOOL complete;
+
+/**
+ * \brief Create an index of a file.
+ *
+ * \param fileURL The URL of the file.
+ *
+ * \param error On return, the error if the file could not be mapped.
+ *
+ * \return An index on the autorelease pool, or nil if the file could not be
+ *         mapped.
+ */
++(instancetype)lineIndexWithContentsOfURL:(NSURL *)fileURL error:(NSError **)error;
+
+/**
+ * \brief Start scanning the file on a background queue.
+ */
+-(void)buildInBackground;
+
+/**
+ * \brief Stop building the index and cancel any search.
+ */
+-(void)cancel;
+
+/**
+ * \brief Return consecutive lines of the file.
+ *
+ * \details Each line is decoded as UTF-8, or ISO Latin 1 if it is not valid
+ *          UTF-8, without its line ending and cut to
+ *          `PLLineIndexMaximumLineLength` bytes.
+ *
+ * \param range The range of line numbers. Lines not scanned yet are omitted.
+ *
+ * \return An array of strings.
+ */
+-(NSArray *)linesInRange:(NSRange)range;
+
+/**
+ * \brief Return the lengths of consecutive lines of the file.
+ *
+ * \details The lines are not decoded, so this is much cheaper than
+ *          `linesInRange:` and serves to estimate the size of lines not yet
+ *          drawn.
+ *
+ * \param lengths An array of at least `range.length` lengths, filled with the
+ *                length in bytes of each line, without its line ending and cut
+ *                to `PLLineIndexMaximumLineLength`.
+ *
+ * \param range The range of line numbers.
+ *
+ * \return The number of lengths filled. Lines not scanned yet are omitted.
+ */
+-(NSUInteger)getLengths:(NSUInteger *)lengths ofLinesInRange:(NSRange)range;
+
+/**
+ * \brief Return the offset of the start of a line.
+ *
+ * \param line The line number.
+ *
+ * \return The offset, or `PLLineIndexNotFound` if the line has not been
+ *         scanned.
+ */
+-(unsigned long long)offsetOfLine:(NSUInteger)line;
+
+/**
+ * \brief Return the line containing an offset.
+ *
+ * \details The line feeds are counted from the nearest recorded offset, so an
+ *          offset past the part of the file scanned so far costs a count of
+ *          the bytes in between.
+ *
+ * \param offset An offset in the file.
+ *
+ * \return The line number.
+ */
+-(NSUInteger)lineContainingOffset:(unsigned long long)offset;
+
+/**
+ * \brief Search the file for a string, streaming through it in chunks on a
+ *        background queue.
+ *
+ * \details The search starts at `offset`, wraps around to the start of the
+ *          file, and stops at the first match. Starting another search, or
+ *          cancelling the index, cancels it, and its handler is not called.
+ *
+ * \param string The string, matched against the UTF-8 bytes of the file.
+ *
+ * \param offset The offset to start at.
+ *
+ * \param handler The block called on the main thread with the offset of the
+ *                match, or `PLLineIndexNotFound`.
+ */
+-(void)findString:(NSString *)string fromOffset:(unsigned long long)offset completionHandler:(void (^)(unsigned long long matchOffset))handler;
+
+@end
@@ -0,0 +1,456 @@
+/**
+ * \file PLLineIndex.m
+ *
+ * \brief Liasis Python IDE line index of a memory mapped file.
+ *
+ * \details This file includes the sparse index of the line offsets of a file
+ *          too large to be opened as a document.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLLineIndex.h"
+#import <libkern/OSAtomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+NSString * const PLLineIndexDidUpdateNotification = @"PLLineIndexDidUpdateNotification";
+
+const NSUInteger PLLineIndexStride = 1024;
+
+const NSUInteger PLLineIndexMaximumLineLength = 4096;
+
+const unsigned long long PLLineIndexNotFound = ULLONG_MAX;
+
+/**
+ * \brief The number of bytes scanned between two updates of the index.
+ */
+static const NSUInteger PLLineIndexChunkLength = 4 * 1024 * 1024;
+
+/**
+ * \brief The number of bytes counted at once before looking for the lines to
+ *        record in them.
+ */
+static const NSUInteger PLLineIndexBlockLength = 4096;
+
+/**
+ * \brief The number of bytes searched between two checks for cancellation.
+ */
+static const NSUInteger PLLineIndexSearchChunkLength = 16 * 1024 * 1024;
+
+/**
+ * \brief Sixteen bytes compared at once.
+ */
+typedef char PLLineIndexVector __attribute__((vector_size(16)));
+
+/**
+ * \brief Count the line feeds in a buffer.
+ *
+ * \details Sixteen bytes are compared to a line feed at a time, each matching
+ *          lane adding one to a vector of byte counters. The counters are
+ *          summed every 255 vectors, before any of them can overflow.
+ *
+ * \param bytes The buffer.
+ *
+ * \param length The length of the buffer.
+ *
+ * \return The number of line feeds.
+ */
+static NSUInteger PLLineIndexCountNewlines(const char * bytes, NSUInteger length)
+{
+        const PLLineIndexVector newlines = {'\n', '\n', '\n', '\n', '\n', '\n', '\n', '\n',
+                                            '\n', '\n', '\n', '\n', '\n', '\n', '\n', '\n'};
+        PLLineIndexVector block, counters;
+        NSUInteger count = 0, index = 0, lane = 0, vectors = 0;
+
+        while (index + sizeof(PLLineIndexVector) <= length) {
+                counters = (PLLineIndexVector){0};
+                for (vectors = 0; vectors < 255 && index + sizeof(PLLineIndexVector) <= length; vectors++) {
+                        memcpy(&block, bytes + index, sizeof(PLLineIndexVector));
+                        counters -= (PLLineIndexVector)(block == newlines);
+                        index += sizeof(PLLineIndexVector);
+                }
+                for (lane = 0; lane < sizeof(PLLineIndexVector); lane++) {
+                        count += (unsigned char)counters[lane];
+                }
+        }
+        for (; index < length; index++) {
+                count += (bytes[index] == '\n');
+        }
+        return count;
+}
+
+/**
+ * \brief Decode a line for display.
+ *
+ * \param bytes The start of the line.
+ *
+ * \param length The length of the line without its line feed.
+ *
+ * \return The line, cut to `PLLineIndexMaximumLineLength` bytes.
+ */
+static NSString * PLLineIndexDecodeLine(const char * bytes, NSUInteger length)
+{
+        NSString * line = nil;
+
+        if (length > 0 && bytes[length - 1] == '\r') {
+                length--;
+        }
+        length = MIN(length, PLLineIndexMaximumLineLength);
+        line = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+        if (line == nil) {
+                line = [[NSString alloc] initWithBytes:bytes length:length encoding:NSISOLatin1StringEncoding];
+        }
+        return [line autorelease];
+}
+
+@implementation PLLineIndex
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithData:(NSData *)mappedData
+{
+        self = [super init];
+        if (self) {
+                data = [mappedData retain];
+                _length = [data length];
+                checkpointCapacity = 64;
+                checkpoints = malloc(checkpointCapacity * sizeof(unsigned long long));
+                checkpoints[0] = 0;
+                checkpointCount = 1;
+        }
+        return self;
+}
+
++(instancetype)lineIndexWithContentsOfURL:(NSURL *)fileURL error:(NSError **)error
+{
+        NSData * mappedData = [NSData dataWithContentsOfURL:fileURL options:NSDataReadingMappedAlways error:error];
+        PLLineIndex * lineIndex = nil;
+
+        if (mappedData) {
+                lineIndex = [[[self alloc] initWithData:mappedData] autorelease];
+        }
+        return lineIndex;
+}
+
+-(void)dealloc
+{
+        [data release];
+        free(checkpoints);
+        [super dealloc];
+}
+
+-(void)cancel
+{
+        cancelled = YES;
+        OSAtomicIncrement32Barrier(&searchGeneration);
+}
+
+#pragma mark - Building
+
+/**
+ * \brief Post a `PLLineIndexDidUpdateNotification` from the main thread,
+ *        coalesced with any that is still queued.
+ */
+-(void)postUpdate
+{
+        dispatch_async(dispatch_get_main_queue(), ^{
+                [[NSNotificationQueue defaultQueue] enqueueNotification:[NSNotification notificationWithName:PLLineIndexDidUpdateNotification
+                                                                                                      object:self]
+                                                           postingStyle:NSPostASAP
+                                                           coalesceMask:(NSNotificationCoalescingOnName | NSNotificationCoalescingOnSender)
+                                                               forModes:nil];
+        });
+}
+
+/**
+ * \brief Record the offsets of the lines starting in a range of the file.
+ *
+ * \details Only called on the background queue. Recorded offsets are added
+ *          under the lock, so the main thread sees whole chunks.
+ *
+ * \param start The offset to start at, which is `indexedLength`.
+ *
+ * \param end The offset to stop at.
+ */
+-(void)scanFrom:(unsigned long long)start to:(unsigned long long)end
+{
+        const char * bytes = [data bytes];
+        const char * newline = NULL;
+        unsigned long long offset = start, blockEnd = 0;
+        NSUInteger lines = newlineCount, count = 0;
+        NSMutableData * found = [NSMutableData data];
+        unsigned long long checkpoint = 0;
+
+        while (offset < end) {
+                blockEnd = MIN(offset + PLLineIndexBlockLength, end);
+                count = PLLineIndexCountNewlines(bytes + offset, (NSUInteger)(blockEnd - offset));
+                if (lines % PLLineIndexStride + count < PLLineIndexStride) {
+                        lines += count;
+                        offset = blockEnd;
+                        continue;
+                }
+                while ((newline = memchr(bytes + offset, '\n', (size_t)(blockEnd - offset)))) {
+                        offset = (newline - bytes) + 1;
+                        lines++;
+                        if (lines % PLLineIndexStride == 0) {
+                                checkpoint = offset;
+                                [found appendBytes:&checkpoint length:sizeof(checkpoint)];
+                        }
+                }
+                offset = blockEnd;
+        }
+
+        @synchronized(self) {
+                count = [found length] / sizeof(unsigned long long);
+                if (checkpointCount + count > checkpointCapacity) {
+                        while (checkpointCount + count > checkpointCapacity) {
+                                checkpointCapacity *= 2;
+                        }
+                        checkpoints = reallocf(checkpoints, checkpointCapacity * sizeof(unsigned long long));
+                        if (checkpoints == NULL) {
+                                [NSException raise:NSMallocException format:@"Could not allocate the line index."];
+                        }
+                }
+                memcpy(checkpoints + checkpointCount, [found bytes], [found length]);
+                checkpointCount += count;
+                newlineCount = lines;
+                indexedLength = end;
+        }
+}
+
+-(void)buildInBackground
+{
+        const char * bytes = [data bytes];
+
+        if (_length > 0 && (uintptr_t)bytes % getpagesize() == 0) {
+                posix_madvise((void *)bytes, (size_t)_length, POSIX_MADV_SEQUENTIAL);
+        }
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+                unsigned long long offset = 0;
+
+                while (offset < _length && cancelled == NO) {
+                        @autoreleasepool {
+                                [self scanFrom:offset to:MIN(offset + PLLineIndexChunkLength, _length)];
+                                offset = MIN(offset + PLLineIndexChunkLength, _length);
+                                [self postUpdate];
+                        }
+                }
+                if (_length > 0 && (uintptr_t)bytes % getpagesize() == 0) {
+                        posix_madvise((void *)bytes, (size_t)_length, POSIX_MADV_NORMAL);
+                }
+                if (_length == 0) {
+                        [self postUpdate];
+                }
+        });
+}
+
+#pragma mark - Properties
+
+-(NSUInteger)lineCount
+{
+        NSUInteger lineCount = 0;
+
+        @synchronized(self) {
+                lineCount = newlineCount;
+                if (indexedLength == _length && _length > 0 && ((const char *)[data bytes])[_length - 1] != '\n') {
+                        lineCount++;
+                }
+        }
+        return lineCount;
+}
+
+-(double)progress
+{
+        double progress = 1.0;
+
+        @synchronized(self) {
+                if (_length > 0) {
+                        progress = (double)indexedLength / _length;
+                }
+        }
+        return progress;
+}
+
+-(BOOL)isComplete
+{
+        BOOL complete = NO;
+
+        @synchronized(self) {
+                complete = (indexedLength == _length);
+        }
+        return complete;
+}
+
+#pragma mark - Reading Lines
+
+-(unsigned long long)offsetOfLine:(NSUInteger)line
+{
+        const char * bytes = [data bytes];
+        const char * newline = NULL;
+        unsigned long long offset = PLLineIndexNotFound, limit = 0;
+        NSUInteger remaining = 0;
+
+        @synchronized(self) {
+                if (line / PLLineIndexStride < checkpointCount && line <= newlineCount) {
+                        offset = checkpoints[line / PLLineIndexStride];
+                        limit = indexedLength;
+                }
+        }
+        if (offset == PLLineIndexNotFound) {
+                goto exit;
+        }
+        for (remaining = line % PLLineIndexStride; remaining > 0; remaining--) {
+                newline = memchr(bytes + offset, '\n', (size_t)(limit - offset));
+                if (newline == NULL) {
+                        offset = PLLineIndexNotFound;
+                        goto exit;
+                }
+                offset = (newline - bytes) + 1;
+        }
+
+exit:
+        return offset;
+}
+
+-(NSArray *)linesInRange:(NSRange)range
+{
+        NSMutableArray * lines = [NSMutableArray arrayWithCapacity:range.length];
+        const char * bytes = [data bytes];
+        const char * newline = NULL;
+        unsigned long long offset = [self offsetOfLine:range.location], limit = 0, end = 0;
+        NSUInteger lineCount = [self lineCount], line = 0;
+
+        if (offset == PLLineIndexNotFound) {
+                goto exit;
+        }
+        @synchronized(self) {
+                limit = indexedLength;
+        }
+        for (line = range.location; line < NSMaxRange(range) && line < lineCount && offset < limit; line++) {
+                newline = memchr(bytes + offset, '\n', (size_t)(limit - offset));
+                end = newline ? (unsigned long long)(newline - bytes) : limit;
+                [lines addObject:PLLineIndexDecodeLine(bytes + offset, (NSUInteger)(end - offset))];
+                offset = end + 1;
+        }
+
+exit:
+        return lines;
+}
+
+-(NSUInteger)getLengths:(NSUInteger *)lengths ofLinesInRange:(NSRange)range
+{
+        const char * bytes = [data bytes];
+        const char * newline = NULL;
+        unsigned long long offset = [self offsetOfLine:range.location], limit = 0, end = 0;
+        NSUInteger lineCount = [self lineCount], line = 0, count = 0;
+
+        if (offset == PLLineIndexNotFound) {
+                goto exit;
+        }
+        @synchronized(self) {
+                limit = indexedLength;
+        }
+        for (line = range.location; line < NSMaxRange(range) && line < lineCount && offset < limit; line++) {
+                newline = memchr(bytes + offset, '\n', (size_t)(limit - offset));
+                end = newline ? (unsigned long long)(newline - bytes) : limit;
+                if (end > offset && bytes[end - 1] == '\r') {
+                        lengths[count] = MIN((NSUInteger)(end - offset - 1), PLLineIndexMaximumLineLength);
+                } else {
+                        lengths[count] = MIN((NSUInteger)(end - offset), PLLineIndexMaximumLineLength);
+                }
+                count++;
+                offset = end + 1;
+        }
+
+exit:
+        return count;
+}
+
+-(NSUInteger)lineContainingOffset:(unsigned long long)offset
+{
+        NSUInteger low = 0, high = 0, middle = 0;
+        unsigned long long start = 0;
+
+        @synchronized(self) {
+                high = checkpointCount;
+                while (low + 1 < high) {
+                        middle = low + (high - low) / 2;
+                        if (checkpoints[middle] <= offset) {
+                                low = middle;
+                        } else {
+                                high = middle;
+                        }
+                }
+                start = checkpoints[low];
+        }
+        return low * PLLineIndexStride + PLLineIndexCountNewlines((const char *)[data bytes] + start, (NSUInteger)(offset - start));
+}
+
+#pragma mark - Searching
+
+-(void)findString:(NSString *)string fromOffset:(unsigned long long)offset completionHandler:(void (^)(unsigned long long matchOffset))handler
+{
+        NSData * pattern = [string dataUsingEncoding:NSUTF8StringEncoding];
+        int32_t generation = OSAtomicIncrement32Barrier(&searchGeneration);
+
+        handler = [[handler copy] autorelease];
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                const char * bytes = [data bytes];
+                const char * match = NULL;
+                unsigned long long start = MIN(offset, _length), position = start, end = _length, chunkEnd = 0;
+                unsigned long long matchOffset = PLLineIndexNotFound;
+                BOOL wrapped = NO;
+
+                if ([pattern length] == 0 || [pattern length] > _length) {
+                        goto finish;
+                }
+                while (generation == searchGeneration) {
+                        if (position >= end) {
+                                if (wrapped || start == 0) {
+                                        break;
+                                }
+                                wrapped = YES;
+                                position = 0;
+                                end = MIN(start + [pattern length] - 1, _length);
+                                continue;
+                        }
+                        chunkEnd = MIN(position + PLLineIndexSearchChunkLength + [pattern length] - 1, end);
+                        match = memmem(bytes + position, (size_t)(chunkEnd - position), [pattern bytes], [pattern length]);
+                        if (match) {
+                                matchOffset = match - bytes;
+                                break;
+                        }
+                        position = MIN(position + PLLineIndexSearchChunkLength, end);
+                }
+
+        finish:
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        if (generation == searchGeneration) {
+                                handler(matchOffset);
+                        }
+                });
+        });
+}
+
+@end
@@ -0,0 +1,113 @@
+/**
+ * \file PLLineLayoutCache.h
+ *
+ * \brief Liasis Python IDE line layout cache.
+ *
+ * \details This file includes the cache of the laid out glyph runs of the
+ *          lines most recently drawn by a view.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class PLLineLayoutCacheEntry;
+
+/**
+ * \class PLLineLayoutCache \headerfile \headerfile
+ *
+ * \brief Keeps the layouts of a bounded number of lines, evicting the least
+ *        recently used.
+ *
+ * \details Each layout is the array of `CTLine`s a line is wrapped into. The
+ *          entries are in a dictionary by line number and in a list ordered by
+ *          use, so a lookup, an insertion, and an eviction each take constant
+ *          time. The memory held by the cache therefore depends on its
+ *          capacity, not on the number of lines of the file.
+ */
+@interface PLLineLayoutCache : NSObject
+{
+        /**
+         * \brief The entries, by line number.
+         */
+        NSMutableDictionary * entries;
+
+        /**
+         * \brief The most recently used entry, or nil.
+         */
+        PLLineLayoutCacheEntry * mostRecentlyUsed;
+
+        /**
+         * \brief The least recently used entry, or nil.
+         */
+        PLLineLayoutCacheEntry * leastRecentlyUsed;
+}
+
+/**
+ * \brief The number of layouts kept.
+ */
+@property (readonly) NSUInteger capacity;
+
+/**
+ * \brief The number of lookups that found a layout.
+ */
+@property (readonly) NSUInteger hits;
+
+/**
+ * \brief The number of lookups that did not.
+ */
+@property (readonly) NSUInteger misses;
+
+/**
+ * \brief Create a cache.
+ *
+ * \param capacity The number of layouts kept.
+ *
+ * \return A cache on the autorelease pool.
+ */
++(instancetype)cacheWithCapacity:(NSUInteger)capacity;
+
+/**
+ * \brief Return the layout of a line, and mark it most recently used.
+ *
+ * \param line The line number.
+ *
+ * \return An array of `CTLine`s, or nil if the line is not cached.
+ */
+-(NSArray *)layoutOfLine:(NSUInteger)line;
+
+/**
+ * \brief Cache the layout of a line, evicting the least recently used layout
+ *        if the cache is full.
+ *
+ * \param layout An array of `CTLine`s.
+ *
+ * \param line The line number.
+ */
+-(void)setLayout:(NSArray *)layout ofLine:(NSUInteger)line;
+
+/**
+ * \brief Remove all layouts.
+ */
+-(void)removeAllLayouts;
+
+@end
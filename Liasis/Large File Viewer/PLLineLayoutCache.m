@@ -0,0 +1,192 @@
+/**
+ * \file PLLineLayoutCache.m
+ *
+ * \brief Liasis Python IDE line layout cache.
+ *
+ * \details This file includes the cache of the laid out glyph runs of the
+ *          lines most recently drawn by a view.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLLineLayoutCache.h"
+
+/**
+ * \class PLLineLayoutCacheEntry
+ *
+ * \brief The layout of a line, linked into the list of entries ordered by
+ *        use.
+ */
+@interface PLLineLayoutCacheEntry : NSObject
+
+/**
+ * \brief The line number.
+ */
+@property NSUInteger line;
+
+/**
+ * \brief The array of `CTLine`s of the line.
+ */
+@property (retain) NSArray * layout;
+
+/**
+ * \brief The entry used more recently, or nil. Not retained.
+ */
+@property (assign) PLLineLayoutCacheEntry * previous;
+
+/**
+ * \brief The entry used less recently, or nil. Not retained.
+ */
+@property (assign) PLLineLayoutCacheEntry * next;
+
+@end
+
+@implementation PLLineLayoutCacheEntry
+
+-(void)dealloc
+{
+        [_layout release];
+        [super dealloc];
+}
+
+@end
+
+#pragma mark -
+
+@implementation PLLineLayoutCache
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Initialize a cache.
+ *
+ * \param capacity The number of layouts kept.
+ *
+ * \return The initialized cache.
+ */
+-(instancetype)initWithCapacity:(NSUInteger)capacity
+{
+        self = [super init];
+        if (self) {
+                _capacity = MAX(capacity, 1);
+                entries = [[NSMutableDictionary alloc] initWithCapacity:_capacity];
+        }
+        return self;
+}
+
++(instancetype)cacheWithCapacity:(NSUInteger)capacity
+{
+        return [[[self alloc] initWithCapacity:capacity] autorelease];
+}
+
+-(void)dealloc
+{
+        [entries release];
+        [super dealloc];
+}
+
+#pragma mark - Use List
+
+/**
+ * \brief Unlink an entry from the use list.
+ *
+ * \param entry The entry.
+ */
+-(void)unlinkEntry:(PLLineLayoutCacheEntry *)entry
+{
+        if (entry.previous) {
+                entry.previous.next = entry.next;
+        } else {
+                mostRecentlyUsed = entry.next;
+        }
+        if (entry.next) {
+                entry.next.previous = entry.previous;
+        } else {
+                leastRecentlyUsed = entry.previous;
+        }
+        entry.previous = nil;
+        entry.next = nil;
+}
+
+/**
+ * \brief Link an entry at the head of the use list.
+ *
+ * \param entry The entry, not in the list.
+ */
+-(void)linkEntryAsMostRecentlyUsed:(PLLineLayoutCacheEntry *)entry
+{
+        entry.next = mostRecentlyUsed;
+        mostRecentlyUsed.previous = entry;
+        mostRecentlyUsed = entry;
+        if (leastRecentlyUsed == nil) {
+                leastRecentlyUsed = entry;
+        }
+}
+
+#pragma mark - Layouts
+
+-(NSArray *)layoutOfLine:(NSUInteger)line
+{
+        PLLineLayoutCacheEntry * entry = entries[@(line)];
+
+        if (entry == nil) {
+                _misses++;
+                goto exit;
+        }
+        _hits++;
+        if (entry != mostRecentlyUsed) {
+                [self unlinkEntry:entry];
+                [self linkEntryAsMostRecentlyUsed:entry];
+        }
+
+exit:
+        return entry.layout;
+}
+
+-(void)setLayout:(NSArray *)layout ofLine:(NSUInteger)line
+{
+        PLLineLayoutCacheEntry * entry = entries[@(line)];
+
+        if (entry) {
+                [self unlinkEntry:entry];
+        } else {
+                if ([entries count] == _capacity) {
+                        entry = leastRecentlyUsed;
+                        [self unlinkEntry:entry];
+                        [entries removeObjectForKey:@(entry.line)];
+                }
+                entry = [[[PLLineLayoutCacheEntry alloc] init] autorelease];
+                entry.line = line;
+                entries[@(line)] = entry;
+        }
+        entry.layout = layout;
+        [self linkEntryAsMostRecentlyUsed:entry];
+}
+
+-(void)removeAllLayouts
+{
+        mostRecentlyUsed = nil;
+        leastRecentlyUsed = nil;
+        [entries removeAllObjects];
+}
+
+@end
@@ -0,0 +1,157 @@
+/**
+ * \file PLAddOnLoader.h
+ *
+ * \brief Liasis Python IDE built in add on loader.
+ *
+ * \details This file includes the object deciding when each built in add on is
+ *          loaded.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief The Info.plist key of an add on declaring whether it must be loaded
+ *        before the first window is created.
+ *
+ * \details The value is a boolean. Add ons that do not declare it use the
+ *          value of the same key in their `PLBuiltInAddOns` entry of the
+ *          application's Info.plist, and are deferred if neither declares it.
+ */
+extern NSString * const PLAddOnNeededAtLaunchKey;
+
+/**
+ * \brief The Info.plist key of an add on declaring whether it calls into the
+ *        embedded Python interpreter while it is loaded.
+ *
+ * \details The value is a boolean, looked up like `PLAddOnNeededAtLaunchKey`.
+ *          Such add ons are loaded on the main thread once the interpreter is
+ *          ready, holding the GIL.
+ */
+extern NSString * const PLAddOnRequiresPythonKey;
+
+/**
+ * \brief The Info.plist key of the application listing the built in add ons.
+ *
+ * \details The value is an array of dictionaries, in load order, each with the
+ *          add on's file name under `PLAddOnNameKey` and optionally
+ *          `PLAddOnNeededAtLaunchKey` and `PLAddOnRequiresPythonKey`.
+ */
+extern NSString * const PLBuiltInAddOnsKey;
+
+/**
+ * \brief The key of the file name of an add on in a `PLBuiltInAddOns` entry.
+ */
+extern NSString * const PLAddOnNameKey;
+
+/**
+ * \class PLAddOnLoader \headerfile \headerfile
+ *
+ * \brief Loads the built in add ons through `PLAddOnManager`, deferring those
+ *        not needed at launch.
+ *
+ * \details Add ons needed at launch are loaded before the first window is
+ *          created. The others are loaded after the first window has been
+ *          drawn, or earlier on first use, e.g. when opening a file whose type
+ *          only a deferred add on handles. The load of each add on is recorded
+ *          in the `PLLaunchTimeline`.
+ *
+ *          Add ons requiring Python are loaded while holding the GIL with
+ *          `PLPythonRuntime`'s `performWithGIL:`. After the first frame they
+ *          wait for the interpreter without blocking the main thread; on first
+ *          use the main thread waits for it.
+ *
+ *          The loader must only be used from the main thread.
+ */
+@interface PLAddOnLoader : NSObject
+{
+        /**
+         * \brief The file names of the add ons needed at launch, in load order.
+         */
+        NSMutableArray * launchAddOnNames;
+
+        /**
+         * \brief The file names of the deferred add ons not loaded yet, in load
+         *        order.
+         */
+        NSMutableArray * deferredAddOnNames;
+
+        /**
+         * \brief The file names of the add ons requiring Python.
+         */
+        NSMutableSet * pythonAddOnNames;
+}
+
+/**
+ * \brief Initialize a loader of the add ons listed in an Info.plist.
+ *
+ * \details This is the designated initializer. Only the Info.plist of each
+ *          add on is read; no code is loaded.
+ *
+ * \param builtInAddOns The `PLBuiltInAddOns` entries, in load order.
+ *
+ * \param plugInsPath The directory containing the add on bundles.
+ *
+ * \return A `PLAddOnLoader`.
+ */
+-(instancetype)initWithBuiltInAddOns:(NSArray *)builtInAddOns plugInsPath:(NSString *)plugInsPath;
+
+/**
+ * \brief The shared add on loader.
+ *
+ * \return The loader of the application's built in add ons.
+ */
++(instancetype)sharedLoader;
+
+/**
+ * \brief Load the add ons needed before the first window is created.
+ */
+-(void)loadAddOnsNeededAtLaunch;
+
+/**
+ * \brief Load the deferred add ons in the background of the run loop.
+ *
+ * \details The deferred add ons not requiring Python are loaded immediately.
+ *          Those requiring Python are loaded once the interpreter is ready,
+ *          starting it if needed.
+ */
+-(void)beginLoadingDeferredAddOns;
+
+/**
+ * \brief Load the deferred add ons.
+ *
+ * \details Blocks until the interpreter is ready if an add on requiring
+ *          Python has not been loaded yet. Does nothing once every deferred
+ *          add on has been loaded, so it is cheap to call before any use of an
+ *          add on that may be deferred.
+ */
+-(void)loadDeferredAddOns;
+
+/**
+ * \brief Determine if the deferred add ons have been loaded.
+ *
+ * \return YES once every deferred add on has been loaded.
+ */
+-(BOOL)areDeferredAddOnsLoaded;
+
+@end
@@ -0,0 +1,196 @@
+/**
+ * \file PLAddOnLoader.m
+ *
+ * \brief Liasis Python IDE built in add on loader.
+ *
+ * \details This file includes the object deciding when each built in add on is
+ *          loaded.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLAddOnLoader.h"
+#import <LiasisKit/LiasisKit.h>
+#import "PLLaunchTimeline.h"
+#import "PLPythonRuntime.h"
+
+NSString * const PLAddOnNeededAtLaunchKey = @"PLAddOnNeededAtLaunch";
+NSString * const PLAddOnRequiresPythonKey = @"PLAddOnRequiresPython";
+NSString * const PLBuiltInAddOnsKey = @"PLBuiltInAddOns";
+NSString * const PLAddOnNameKey = @"PLAddOnName";
+
+@implementation PLAddOnLoader
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Initialize a loader of the application's built in add ons.
+ */
+-(instancetype)init
+{
+        return [self initWithBuiltInAddOns:[[NSBundle mainBundle] objectForInfoDictionaryKey:PLBuiltInAddOnsKey]
+                               plugInsPath:[[NSBundle mainBundle] builtInPlugInsPath]];
+}
+
+/**
+ * \brief Sort the add ons into those needed at launch and deferred ones, and
+ *        note those requiring Python.
+ */
+-(instancetype)initWithBuiltInAddOns:(NSArray *)builtInAddOns plugInsPath:(NSString *)plugInsPath
+{
+        NSString * name = nil;
+        NSBundle * addOnBundle = nil;
+        id neededAtLaunch = nil, requiresPython = nil;
+
+        self = [super init];
+        if (self) {
+                launchAddOnNames = [[NSMutableArray alloc] init];
+                deferredAddOnNames = [[NSMutableArray alloc] init];
+                pythonAddOnNames = [[NSMutableSet alloc] init];
+                for (NSDictionary * entry in builtInAddOns) {
+                        name = [entry objectForKey:PLAddOnNameKey];
+                        if (name == nil) {
+                                continue;
+                        }
+                        addOnBundle = [NSBundle bundleWithPath:[plugInsPath stringByAppendingPathComponent:name]];
+                        neededAtLaunch = [addOnBundle objectForInfoDictionaryKey:PLAddOnNeededAtLaunchKey];
+                        if (neededAtLaunch == nil) {
+                                neededAtLaunch = [entry objectForKey:PLAddOnNeededAtLaunchKey];
+                        }
+                        requiresPython = [addOnBundle objectForInfoDictionaryKey:PLAddOnRequiresPythonKey];
+                        if (requiresPython == nil) {
+                                requiresPython = [entry objectForKey:PLAddOnRequiresPythonKey];
+                        }
+                        if ([requiresPython boolValue]) {
+                                [pythonAddOnNames addObject:name];
+                        }
+                        if ([neededAtLaunch boolValue]) {
+                                [launchAddOnNames addObject:name];
+                        } else {
+                                [deferredAddOnNames addObject:name];
+                        }
+                }
+        }
+        return self;
+}
+
++(instancetype)sharedLoader
+{
+        static PLAddOnLoader * sharedLoader = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedLoader = [[self alloc] init];
+        });
+        return sharedLoader;
+}
+
+-(void)dealloc
+{
+        [launchAddOnNames release];
+        [deferredAddOnNames release];
+        [pythonAddOnNames release];
+        [super dealloc];
+}
+
+#pragma mark - Loading
+
+/**
+ * \brief Load a single add on through the `PLAddOnManager`.
+ *
+ * \param name The file name of the add on.
+ */
+-(void)loadAddOnNamed:(NSString *)name
+{
+        [[PLAddOnManager defaultManager] loadAddOnNamed:name];
+}
+
+/**
+ * \brief Load add ons, recording each load as a phase of the launch timeline.
+ *
+ * \details Add ons requiring Python are loaded holding the GIL, waiting for
+ *          the interpreter if needed. They are not loaded if the runtime shut
+ *          down first.
+ *
+ * \param names The file names of the add ons.
+ */
+-(void)loadAddOnsNamed:(NSArray *)names
+{
+        NSString * phase = nil;
+
+        for (NSString * name in names) {
+                phase = [@"load " stringByAppendingString:name];
+                [[PLLaunchTimeline sharedTimeline] beginPhase:phase];
+                if ([pythonAddOnNames containsObject:name]) {
+                        [[PLPythonRuntime sharedRuntime] performWithGIL:^{
+                                [self loadAddOnNamed:name];
+                        }];
+                } else {
+                        [self loadAddOnNamed:name];
+                }
+                [[PLLaunchTimeline sharedTimeline] endPhase:phase];
+        }
+}
+
+/**
+ * \brief Load the deferred add ons not loaded yet, in load order.
+ *
+ * \param includingPython YES to also load the add ons requiring Python.
+ */
+-(void)loadDeferredAddOnsIncludingPython:(BOOL)includingPython
+{
+        NSMutableArray * names = [NSMutableArray arrayWithCapacity:[deferredAddOnNames count]];
+
+        for (NSString * name in deferredAddOnNames) {
+                if (includingPython || [pythonAddOnNames containsObject:name] == NO) {
+                        [names addObject:name];
+                }
+        }
+        [deferredAddOnNames removeObjectsInArray:names];
+        [self loadAddOnsNamed:names];
+}
+
+-(void)loadAddOnsNeededAtLaunch
+{
+        [self loadAddOnsNamed:launchAddOnNames];
+}
+
+-(void)beginLoadingDeferredAddOns
+{
+        [self loadDeferredAddOnsIncludingPython:NO];
+        if ([deferredAddOnNames count] > 0) {
+                [[PLPythonRuntime sharedRuntime] whenReady:^{
+                        [self loadDeferredAddOnsIncludingPython:YES];
+                }];
+        }
+}
+
+-(void)loadDeferredAddOns
+{
+        [self loadDeferredAddOnsIncludingPython:YES];
+}
+
+-(BOOL)areDeferredAddOnsLoaded
+{
+        return [deferredAddOnNames count] == 0;
+}
+
+@end
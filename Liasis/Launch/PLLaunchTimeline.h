@@ -0,0 +1,142 @@
+/**
+ * \file PLLaunchTimeline.h
+ *
+ * \brief Liasis Python IDE launch timeline.
+ *
+ * \details This file includes the recorder of the phases of application
+ *          launch.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \class PLLaunchTimeline \headerfile \headerfile
+ *
+ * \brief Records the phases of application launch and writes them to a log.
+ *
+ * \details Phases and events are timed in milliseconds since the process
+ *          started, as reported by the kernel, so the time spent before `main`
+ *          is included. Phases may be recorded from any thread.
+ *
+ *          Recording stops at the first keystroke, or 30 seconds after
+ *          launch finishes if the user does not type. The timeline of each
+ *          launch is then appended as one line of JSON to `~/Library/Logs/<bundle identifier>/LaunchTimeline.jsonl`:
+ *
+ *              {"version": 1, "date": <seconds since 1970>,
+ *               "appVersion": "0.3", "complete": true,
+ *               "entries": [{"name": "...", "start": <ms>, "end": <ms>,
+ *                            "mainThread": true}, ...]}
+ *
+ *          An event is an entry whose start and end are equal. `complete` is
+ *          false if recording stopped before a first keystroke.
+ */
+@interface PLLaunchTimeline : NSObject
+{
+        /**
+         * \brief The recorded entries, in the order they started.
+         */
+        NSMutableArray * entries;
+
+        /**
+         * \brief The indexes in `entries` of the phases that have not ended,
+         *        keyed by name.
+         */
+        NSMutableDictionary * openPhases;
+
+        /**
+         * \brief The time the process started.
+         */
+        CFAbsoluteTime processStartTime;
+
+        /**
+         * \brief YES until recording stops.
+         */
+        BOOL recording;
+}
+
+/**
+ * \brief The shared timeline.
+ *
+ * \return The timeline of the current launch.
+ */
++(instancetype)sharedTimeline;
+
+/**
+ * \brief Start timing a phase.
+ *
+ * \param name The name of the phase. A phase with the same name must not be
+ *             running.
+ */
+-(void)beginPhase:(NSString *)name;
+
+/**
+ * \brief Stop timing a phase.
+ *
+ * \param name The name of the phase.
+ */
+-(void)endPhase:(NSString *)name;
+
+/**
+ * \brief Record an instantaneous event.
+ *
+ * \param name The name of the event.
+ */
+-(void)recordEvent:(NSString *)name;
+
+/**
+ * \brief Stop recording after a delay if recording has not stopped by then.
+ *
+ * \details Called once launch has otherwise finished.
+ */
+-(void)scheduleStopRecording;
+
+/**
+ * \brief Record the first keystroke and stop recording.
+ *
+ * \details Does nothing after recording has stopped.
+ */
+-(void)recordFirstKeystroke;
+
+/**
+ * \brief Stop recording and append the timeline to the log in the background.
+ *
+ * \details Does nothing after recording has stopped.
+ */
+-(void)stopRecording;
+
+/**
+ * \brief Determine if the timeline is still recording.
+ *
+ * \return YES until recording stops.
+ */
+-(BOOL)isRecording;
+
+/**
+ * \brief Get the entries recorded so far.
+ *
+ * \return An array of dictionaries with the keys of the entries in the log.
+ */
+-(NSArray *)recordedEntries;
+
+@end
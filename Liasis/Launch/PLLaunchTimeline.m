@@ -0,0 +1,253 @@
+/**
+ * \file PLLaunchTimeline.m
+ *
+ * \brief Liasis Python IDE launch timeline.
+ *
+ * \details This file includes the recorder of the phases of application
+ *          launch.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLLaunchTimeline.h"
+#include <sys/sysctl.h>
+#include <unistd.h>
+
+/**
+ * \brief The version of the log format.
+ */
+static const NSInteger PLLaunchTimelineVersion = 1;
+
+/**
+ * \brief The time in seconds after launch finishes that recording stops if the
+ *        user does not type.
+ */
+static const NSTimeInterval PLLaunchTimelineRecordingDuration = 30.0;
+
+/**
+ * \brief Get the time the current process started.
+ *
+ * \return The start time, or the current time if it can not be determined.
+ */
+static CFAbsoluteTime PLLaunchTimelineProcessStartTime(void)
+{
+        int name[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid()};
+        struct kinfo_proc info;
+        size_t length = sizeof(info);
+
+        if (sysctl(name, 4, &info, &length, NULL, 0) != 0 || length == 0) {
+                return CFAbsoluteTimeGetCurrent();
+        }
+        return (CFAbsoluteTime)info.kp_proc.p_starttime.tv_sec + (CFAbsoluteTime)info.kp_proc.p_starttime.tv_usec / 1.0e6 - kCFAbsoluteTimeIntervalSince1970;
+}
+
+@implementation PLLaunchTimeline
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                entries = [[NSMutableArray alloc] init];
+                openPhases = [[NSMutableDictionary alloc] init];
+                processStartTime = PLLaunchTimelineProcessStartTime();
+                recording = YES;
+        }
+        return self;
+}
+
++(instancetype)sharedTimeline
+{
+        static PLLaunchTimeline * sharedTimeline = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedTimeline = [[self alloc] init];
+        });
+        return sharedTimeline;
+}
+
+-(void)dealloc
+{
+        [entries release];
+        [openPhases release];
+        [super dealloc];
+}
+
+#pragma mark - Recording
+
+/**
+ * \brief The number of milliseconds since the process started.
+ */
+-(double)currentTime
+{
+        return (CFAbsoluteTimeGetCurrent() - processStartTime) * 1000.0;
+}
+
+-(void)beginPhase:(NSString *)name
+{
+        NSDictionary * entry = nil;
+
+        @synchronized(self) {
+                if (recording) {
+                        entry = @{@"name": name, @"start": @([self currentTime]), @"mainThread": @([NSThread isMainThread])};
+                        [openPhases setObject:@([entries count]) forKey:name];
+                        [entries addObject:[[entry mutableCopy] autorelease]];
+                }
+        }
+}
+
+-(void)endPhase:(NSString *)name
+{
+        NSNumber * index = nil;
+
+        @synchronized(self) {
+                index = [openPhases objectForKey:name];
+                if (recording && index) {
+                        [[entries objectAtIndex:[index unsignedIntegerValue]] setObject:@([self currentTime]) forKey:@"end"];
+                        [openPhases removeObjectForKey:name];
+                }
+        }
+}
+
+-(void)recordEvent:(NSString *)name
+{
+        NSNumber * time = nil;
+
+        @synchronized(self) {
+                if (recording) {
+                        time = @([self currentTime]);
+                        [entries addObject:@{@"name": name, @"start": time, @"end": time, @"mainThread": @([NSThread isMainThread])}];
+                }
+        }
+}
+
+-(BOOL)isRecording
+{
+        BOOL isRecording = NO;
+
+        @synchronized(self) {
+                isRecording = recording;
+        }
+        return isRecording;
+}
+
+-(NSArray *)recordedEntries
+{
+        NSMutableArray * recordedEntries = nil;
+
+        @synchronized(self) {
+                recordedEntries = [NSMutableArray arrayWithCapacity:[entries count]];
+                for (NSDictionary * entry in entries) {
+                        [recordedEntries addObject:[[entry copy] autorelease]];
+                }
+        }
+        return recordedEntries;
+}
+
+#pragma mark - Writing
+
+-(void)scheduleStopRecording
+{
+        [self performSelector:@selector(stopRecording) withObject:nil afterDelay:PLLaunchTimelineRecordingDuration];
+}
+
+-(void)recordFirstKeystroke
+{
+        [self recordEvent:@"first keystroke"];
+        [self stopRecordingAfterKeystroke:YES];
+}
+
+-(void)stopRecording
+{
+        [self stopRecordingAfterKeystroke:NO];
+}
+
+/**
+ * \brief The path of the log the timeline is appended to.
+ *
+ * \return `~/Library/Logs/<bundle identifier>/LaunchTimeline.jsonl`.
+ */
+-(NSString *)logPath
+{
+        NSString * directoryPath = nil;
+
+        directoryPath = [[NSSearchPathForDirectoriesInDomains(NSLibraryDirectory, NSUserDomainMask, YES) firstObject] stringByAppendingPathComponent:@"Logs"];
+        directoryPath = [directoryPath stringByAppendingPathComponent:[[NSBundle mainBundle] bundleIdentifier] ?: @"Liasis"];
+        return [directoryPath stringByAppendingPathComponent:@"LaunchTimeline.jsonl"];
+}
+
+/**
+ * \brief Stop recording and append the timeline to the log.
+ *
+ * \details Phases that have not ended are written without an end.
+ *
+ * \param complete YES if the timeline ends with the first keystroke.
+ */
+-(void)stopRecordingAfterKeystroke:(BOOL)complete
+{
+        NSDictionary * timeline = nil;
+        NSString * path = nil;
+
+        @synchronized(self) {
+                if (recording) {
+                        recording = NO;
+                        timeline = @{@"version": @(PLLaunchTimelineVersion),
+                                     @"date": @(processStartTime + kCFAbsoluteTimeIntervalSince1970),
+                                     @"appVersion": [[NSBundle mainBundle] objectForInfoDictionaryKey:@"CFBundleShortVersionString"] ?: @"",
+                                     @"complete": @(complete),
+                                     @"entries": [[entries copy] autorelease]};
+                }
+        }
+        if (timeline == nil) {
+                goto exit;
+        }
+        [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(stopRecording) object:nil];
+
+        path = [self logPath];
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+                NSMutableData * line = nil;
+                NSFileHandle * fileHandle = nil;
+
+                line = [[[NSJSONSerialization dataWithJSONObject:timeline options:0 error:NULL] mutableCopy] autorelease];
+                if (line == nil ||
+                    [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                                              withIntermediateDirectories:YES
+                                                               attributes:nil
+                                                                    error:NULL] == NO) {
+                        return;
+                }
+                [line appendBytes:"\n" length:1];
+                if ([[NSFileManager defaultManager] fileExistsAtPath:path] == NO) {
+                        [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+                }
+                fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+                [fileHandle seekToEndOfFile];
+                [fileHandle writeData:line];
+                [fileHandle closeFile];
+        });
+
+exit:
+        return;
+}
+
+@end
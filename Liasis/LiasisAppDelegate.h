@@ -29,10 +29,14 @@
  */
 
 #import <Cocoa/Cocoa.h>
-#import <Python/Python.h>
 #import <LiasisKit/LiasisKit.h>
 #import "PLWindowController.h"
 #import "PLCreditWindowController.h"
+#import "PLPythonRuntime.h"
+#import "PLModuleIndex.h"
+#import "PLAddOnLoader.h"
+#import "PLLaunchTimeline.h"
+#import "PLSessionManager.h"
 
 /**
  * \class LiasisAppDelegate \headerfile \headerfile
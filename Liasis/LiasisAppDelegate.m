@@ -29,35 +29,38 @@
  */
 
 #import "LiasisAppDelegate.h"
+#import "PLTabRegistry.h"
+#import "PLDocumentSaver.h"
 
 @implementation LiasisAppDelegate
 
 #pragma mark - Object Lifecycle
 
 /**
- * \brief Release instance variables and end the internal Python interpreter.
+ * \brief Release instance variables.
  */
 -(void)dealloc
 {
         [openWindowControllers release];
         [applicationFont release];
-        Py_Finalize();
         [super dealloc];
 }
 
 /**
- * \brief Initialize the internal Python interpreter.
+ * \brief Record that the main menu nib has been loaded.
  */
 -(void)awakeFromNib
 {
-        Py_Initialize();
+        [[PLLaunchTimeline sharedTimeline] recordEvent:@"main menu nib loaded"];
 }
 
 /**
- * \brief Set the application font and load the builtin bundles.
+ * \brief Set the application font and load the builtin bundles needed at
+ *        launch.
  *
  * \details Windows are launched in `applicationDidFinishLaunching:` or one of
- *          the open file delegate methods.
+ *          the open file delegate methods. The remaining builtin bundles are
+ *          loaded once the first window has been drawn.
  *
  * \param aNotification The notification object.
  */
@@ -72,27 +75,78 @@
         [[NSFontManager sharedFontManager] setTarget:self];
 
         /* Load bundles */
-        [[PLAddOnManager defaultManager] loadAddOnNamed:@"Introspector.plugin"];
-        [[PLAddOnManager defaultManager] loadAddOnNamed:@"Editor.plugin"];
-        [[PLAddOnManager defaultManager] loadAddOnNamed:@"Interpreter.plugin"];
+        [[PLAddOnLoader sharedLoader] loadAddOnsNeededAtLaunch];
 }
 
 /**
- * \brief Launch a window with an empty tab if no windows have been launched and
- *        register user defaults.
- *
- * \details Windows launched by opening a file will already have an open tab so
- *          this method launches a window and adds a tab with an empty document.
+ * \brief Restore the last session or launch a window with an empty tab if no
+ *        windows have been launched, register user defaults, and finish
+ *        launching in the background.
+ *
+ * \details Windows launched by opening a file will already have an open tab.
+ *          Otherwise, the windows of the last session are restored, and a
+ *          window with an empty document is launched if there were none.
+ *          Documents left with unsaved edits by a crash are then reopened.
+ *
+ *          The Python interpreter is started and the deferred builtin bundles
+ *          are loaded once the first frame of the window has been drawn, and
+ *          therefore always after the bundles needed at launch. The
+ *          interpreter initializes on its own thread; the bundles requiring it
+ *          are loaded holding the GIL once it is ready. The module index is
+ *          opened from its cache at the same time and updated once the
+ *          interpreter is ready.
  *
  * \param aNotification The notification object.
  */
 -(void)applicationDidFinishLaunching:(NSNotification *)notification
 {
+        PLLaunchTimeline * timeline = [PLLaunchTimeline sharedTimeline];
+
+        if ([[NSApp windows] count] == 0) {
+                [timeline beginPhase:@"restore session"];
+                [self restoreSession];
+                [timeline endPhase:@"restore session"];
+        }
         if ([[NSApp windows] count] == 0) {
+                [timeline beginPhase:@"first newWindowWithEmptyDocument"];
                 [self newWindowWithEmptyDocument];
+                [timeline endPhase:@"first newWindowWithEmptyDocument"];
         }
+        [timeline beginPhase:@"recover edit journals"];
+        [self recoverEditJournals];
+        [timeline endPhase:@"recover edit journals"];
         
         [[NSUserDefaults standardUserDefaults] registerDefaults:@{PLUserDefaultUniqueDocuments: @NO}];
+        [self afterFirstFrame:^{
+                [timeline recordEvent:@"first frame"];
+                [[PLPythonRuntime sharedRuntime] start];
+                [[PLModuleIndex sharedIndex] open];
+                [[PLAddOnLoader sharedLoader] beginLoadingDeferredAddOns];
+                [timeline recordEvent:@"launch finished"];
+                [timeline scheduleStopRecording];
+        }];
+}
+
+/**
+ * \brief Call a block once the windows have been drawn for the first time.
+ *
+ * \details AppKit displays the windows and commits their layers when the main
+ *          run loop is about to wait. A block dispatched to the main queue may
+ *          run before that, so the block is instead called by a one shot
+ *          observer ordered after those of AppKit and Core Animation.
+ *
+ * \param block The block to call on the main thread.
+ */
+-(void)afterFirstFrame:(void (^)(void))block
+{
+        CFRunLoopObserverRef observer = NULL;
+
+        observer = CFRunLoopObserverCreateWithHandler(kCFAllocatorDefault, kCFRunLoopBeforeWaiting, false, LONG_MAX,
+                                                      ^(CFRunLoopObserverRef firstFrameObserver, CFRunLoopActivity activity) {
+                                                              block();
+                                                      });
+        CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+        CFRelease(observer);
 }
 
 /**
@@ -102,6 +156,10 @@
  *          `performClose:` message. If the window is still visible, cancel the
  *          termination.
  *
+ *          The session snapshot is saved first and suspended while the windows
+ *          close, so that it records the windows that were open. It resumes if
+ *          the termination is cancelled.
+ *
  * \param sender The application object that is about to be terminated.
  *
  * \return NSTerminateNow if the application should terminate or
@@ -110,6 +168,9 @@
 -(NSApplicationTerminateReply)applicationShouldTerminate:(NSApplication *)sender
 {
         NSApplicationTerminateReply reply = NSTerminateNow;
+
+        [[PLSessionManager sharedSessionManager] saveSession];
+        [[PLSessionManager sharedSessionManager] suspend];
         for (NSWindow * window in [NSApp windows]) {
                 [window performClose:self];
                 if ([window isVisible]) {
@@ -117,11 +178,29 @@
                         break;
                 }
         }
+        if (reply == NSTerminateCancel) {
+                [[PLSessionManager sharedSessionManager] resume];
+        }
         
 exit:
         return reply;
 }
 
+/**
+ * \brief Finish writing the documents being saved, then finalize the Python
+ *        interpreter on its own thread.
+ *
+ * \details Termination waits at most two seconds for the interpreter to
+ *          finalize.
+ *
+ * \param notification The notification object.
+ */
+-(void)applicationWillTerminate:(NSNotification *)notification
+{
+        [[PLDocumentSaver sharedSaver] waitUntilAllSavesAreFinished];
+        [[PLPythonRuntime sharedRuntime] shutdownBeforeDate:[NSDate dateWithTimeIntervalSinceNow:2.0]];
+}
+
 #pragma mark - Window Management
 
 /**
@@ -136,6 +215,9 @@ exit:
  *          launch" unchecked in the xib file so `makeKeyAndOrderFront:` is used
  *          here.
  *
+ *          `PLWindowController` windows are recorded in the session snapshot
+ *          and get the application font.
+ *
  * \param windowController The window controller to add.
  */
 -(void)addWindowController:(NSWindowController *)windowController
@@ -145,14 +227,19 @@ exit:
                                                      name:NSWindowWillCloseNotification
                                                    object:[windowController window]];
         [openWindowControllers addObject:windowController];
+        if ([windowController isKindOfClass:[PLWindowController class]]) {
+                [(PLWindowController *)windowController updateFont:applicationFont];
+                [[PLSessionManager sharedSessionManager] addWindowController:(PLWindowController *)windowController];
+        }
         [[windowController window] makeKeyAndOrderFront:self];
 }
 
 /**
  * \brief Stop tracking the associated window controller.
  *
- * \details Remove the window controller from `openWindowControllers` and stop
- *          observing the `NSWindowWillCloseNotification`.
+ * \details Remove the window controller from `openWindowControllers` and the
+ *          session snapshot, and stop observing the
+ *          `NSWindowWillCloseNotification`.
  *
  * \param notification The notification.
  */
@@ -163,6 +250,9 @@ exit:
                 [[NSNotificationCenter defaultCenter] removeObserver:self
                                                                 name:NSWindowWillCloseNotification
                                                               object:[windowController window]];
+                if ([windowController isKindOfClass:[PLWindowController class]]) {
+                        [[PLSessionManager sharedSessionManager] removeWindowController:(PLWindowController *)windowController];
+                }
                 [openWindowControllers removeObject:windowController];
                 if (windowController == creditWindowController) {
                         creditWindowController = nil;
@@ -179,11 +269,69 @@ exit:
 -(void)newWindowWithEmptyDocument
 {
         PLWindowController * windowController = [PLWindowController windowController];
+        [[PLLaunchTimeline sharedTimeline] beginPhase:@"window nib"];
         [windowController window];
+        [[PLLaunchTimeline sharedTimeline] endPhase:@"window nib"];
         [windowController newDocument];
         [self addWindowController:windowController];
 }
 
+/**
+ * \brief Restore the windows of the last session snapshot.
+ *
+ * \details Each window is shown as soon as its tabs have been added, before
+ *          their documents are loaded. Windows without restorable tabs get a
+ *          tab with an empty document.
+ */
+-(void)restoreSession
+{
+        PLWindowController * windowController = nil;
+
+        for (PLSessionWindow * sessionWindow in [[PLSessionManager sharedSessionManager] restoredWindows]) {
+                windowController = [PLWindowController windowController];
+                [windowController window];
+                [windowController restoreSessionWindow:sessionWindow];
+                if ([windowController numberOfTabs] == 0) {
+                        [windowController newDocument];
+                }
+                [self addWindowController:windowController];
+        }
+}
+
+/**
+ * \brief Reopen the documents left with unsaved edits by a crash.
+ *
+ * \details Files whose tabs were not restored are opened in background tabs,
+ *          and untitled documents get new background tabs, in the most
+ *          recently used window. The recovered edits are replayed as each
+ *          document loads, so restored tabs show them from their first frame.
+ */
+-(void)recoverEditJournals
+{
+        PLEditJournalManager * journalManager = [PLEditJournalManager sharedJournalManager];
+        PLTabRegistry * registry = [PLTabRegistry sharedRegistry];
+        PLWindowController * windowController = nil;
+
+        for (NSURL * fileURL in [journalManager fileURLsOfRecoveredJournals]) {
+                if ([registry tabItemForURL:fileURL inTabViewController:nil] == nil) {
+                        [self openFileWithURL:fileURL inBackground:YES];
+                }
+        }
+        for (NSWindow * window in [NSApp orderedWindows]) {
+                if ([[window windowController] isKindOfClass:[PLWindowController class]]) {
+                        windowController = [window windowController];
+                        break;
+                }
+        }
+        for (PLEditJournal * journal in [journalManager claimUntitledJournals]) {
+                if (windowController) {
+                        [windowController addTabWithRecoveredJournal:journal];
+                } else {
+                        [journal discard];
+                }
+        }
+}
+
 /**
  * \brief Create a new window with a tab that opens a file at a URL.
  *
@@ -276,6 +424,25 @@ exit:
         }
 }
 
+/**
+ * \brief Action to save the edited files of all windows.
+ *
+ * \details The files of all `PLWindowController` windows are saved as one
+ *          batch of the `PLDocumentSaver`.
+ *
+ * \param sender The object sending the action message.
+ */
+-(IBAction)saveAllFiles:(id)sender
+{
+        [[PLDocumentSaver sharedSaver] performBatchSaves:^{
+                for (NSWindowController * windowController in openWindowControllers) {
+                        if ([windowController isKindOfClass:[PLWindowController class]]) {
+                                [(PLWindowController *)windowController saveAllDocuments];
+                        }
+                }
+        }];
+}
+
 /**
  * \brief Action to open a file in the key window.
  *
@@ -292,6 +459,7 @@ exit:
         
         keyWindowController = [[NSApp keyWindow] windowController];
         if ([keyWindowController isKindOfClass:[PLWindowController class]]) {
+                [[PLAddOnLoader sharedLoader] loadDeferredAddOns];
                 openPanel = [NSOpenPanel openPanel];
                 [openPanel setAllowedFileTypes:[[PLAddOnManager defaultManager] allAllowedFileTypes]];
                 [openPanel setAllowsOtherFileTypes:YES];
@@ -308,6 +476,52 @@ exit:
         }
 }
 
+/**
+ * \brief Action to show the Open Quickly panel in the key window.
+ *
+ * \details Does nothing if the key window's controller is not a
+ *          `PLWindowController`.
+ *
+ * \param sender The object sending the action message.
+ */
+-(IBAction)openQuickly:(id)sender
+{
+        if ([[[NSApp keyWindow] windowController] isKindOfClass:[PLWindowController class]]) {
+                [(PLWindowController *)[[NSApp keyWindow] windowController] openQuickly];
+        }
+}
+
+/**
+ * \brief Action to show the project search tab in the key window.
+ *
+ * \details Does nothing if the key window's controller is not a
+ *          `PLWindowController`.
+ *
+ * \param sender The object sending the action message.
+ */
+-(IBAction)findInProject:(id)sender
+{
+        if ([[[NSApp keyWindow] windowController] isKindOfClass:[PLWindowController class]]) {
+                [(PLWindowController *)[[NSApp keyWindow] windowController] findInProject];
+        }
+}
+
+/**
+ * \brief Action to jump to the definition of the name selected in the key
+ *        window.
+ *
+ * \details Does nothing if the key window's controller is not a
+ *          `PLWindowController`.
+ *
+ * \param sender The object sending the action message.
+ */
+-(IBAction)jumpToDefinition:(id)sender
+{
+        if ([[[NSApp keyWindow] windowController] isKindOfClass:[PLWindowController class]]) {
+                [(PLWindowController *)[[NSApp keyWindow] windowController] jumpToDefinition];
+        }
+}
+
 /**
  * \brief Open a single file.
  *
@@ -327,11 +541,14 @@ exit:
 /**
  * \brief Open multiple files.
  *
- * \details Forward the message to `openFileWithURL:` for each filename in
- *          `filenames`. Sends `NSApp` the `replyToOpenOrPrint:` message for
- *          each file with the `NSApplicationDelegateReplySuccess` value if
- *          opening was successful and `NSApplicationDelegateReplyFailure`
- *          otherwise.
+ * \details Forward the message to `openFileWithURL:inBackground:` for each
+ *          filename in `filenames`. All but the last file are opened in
+ *          background tabs, so only the last one creates its editor right away.
+ *          The files are read by the shared `PLDocumentLoader`, several at a
+ *          time, after their tabs have been added. Sends `NSApp` the
+ *          `replyToOpenOrPrint:` message for each file with the
+ *          `NSApplicationDelegateReplySuccess` value if its tab was added and
+ *          `NSApplicationDelegateReplyFailure` otherwise.
  *
  * \param sender The application opening the file.
  *
@@ -346,7 +563,7 @@ exit:
         
         for (NSString * filename in filenames) {
                 fileURL = [NSURL fileURLWithPath:filename];
-                successful = [self openFileWithURL:fileURL];
+                successful = [self openFileWithURL:fileURL inBackground:(filename != [filenames lastObject])];
                 if (successful) {
                         [NSApp replyToOpenOrPrint:NSApplicationDelegateReplySuccess];
                 } else {
@@ -359,7 +576,8 @@ exit:
  * \brief Open a single file.
  *
  * \details If the document is open and the user requests unique instances of
- *          documents, find the window containing the document and open it.
+ *          documents, find the window containing the document through the
+ *          shared `PLTabRegistry` and open it.
  *          Otherwise, open the document in the most recently used window whose
  *          controller is a `PLWindowController`. If no windows meet these
  *          criteria, create a new window to open the file in.
@@ -369,30 +587,47 @@ exit:
  * \return YES if opening was successful.
  */
 -(BOOL)openFileWithURL:(NSURL *)fileURL
+{
+        return [self openFileWithURL:fileURL inBackground:NO];
+}
+
+/**
+ * \brief Open a single file, optionally in a background tab.
+ *
+ * \details Like `openFileWithURL:`, except that if `inBackground` is YES the
+ *          file is opened without changing the active tab of the window.
+ *
+ * \param fileURL The URL to the file to open.
+ *
+ * \param inBackground YES to leave the active tab unchanged.
+ *
+ * \return YES if opening was successful.
+ */
+-(BOOL)openFileWithURL:(NSURL *)fileURL inBackground:(BOOL)inBackground
 {
         PLWindowController * windowController = nil;
+        PLTabRegistry * registry = [PLTabRegistry sharedRegistry];
         BOOL successful = NO;
 
-        if ([[PLDocumentManager sharedDocumentManager] documentIsOpen:fileURL] &&
-            [[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultUniqueDocuments]) {
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultUniqueDocuments]) {
                 /* Find window with document open */
-                for (NSWindow * window in [NSApp windows]) {
-                        windowController = [window windowController];
-                        if ([windowController isKindOfClass:[PLWindowController class]] && [windowController containsDocumentWithURL:fileURL]) {
-                                successful = [windowController openDocumentWithURL:fileURL];
-                                goto exit;
-                        }
+                windowController = [[[[registry tabViewControllerForTabItem:[registry tabItemForURL:fileURL inTabViewController:nil]] view] window] windowController];
+                if ([windowController isKindOfClass:[PLWindowController class]]) {
+                        successful = [windowController openDocumentWithURL:fileURL inBackground:inBackground];
+                        goto exit;
                 }
-        } else {
-                /* Find window to open document in */
-                for (NSWindow * window in [NSApp orderedWindows]) {
-                        windowController = [window windowController];
-                        if ([windowController isKindOfClass:[PLWindowController class]]) {
-                                successful = [windowController openDocumentWithURL:fileURL];
-                                goto exit;
-                        }
+                windowController = nil;
+        }
+
+        /* Find window to open document in */
+        for (NSWindow * window in [NSApp orderedWindows]) {
+                windowController = [window windowController];
+                if ([windowController isKindOfClass:[PLWindowController class]]) {
+                        successful = [windowController openDocumentWithURL:fileURL inBackground:inBackground];
+                        goto exit;
                 }
         }
+        windowController = nil;
 
         /* If reached here, create a new window and open the document */
         [self newWindowWithURL:fileURL];
@@ -436,7 +671,8 @@ exit:
  * \brief Validate menu items in the main menu.
  *
  * \details Creating a new window is always valid. Closing a window is only
- *          valid if there are any windows present. Otherwise, the menu item is
+ *          valid if there are any windows present, and saving all files if
+ *          there are any document windows. Otherwise, the menu item is
  *          only validated if the key window is a `PLWindowController`.
  *
  * \param menuItem The menu item.
@@ -451,6 +687,8 @@ exit:
                 validate = YES;
         } else if ([menuItem action] == @selector(closeFile:)) {
                 validate = [[NSApp windows] count] > 0;
+        } else if ([menuItem action] == @selector(saveAllFiles:)) {
+                validate = [openWindowControllers count] > 0;
         } else if ([[[NSApp keyWindow] windowController] isKindOfClass:[PLWindowController class]]) {
                 if ([menuItem action] == @selector(nextTab:) || [menuItem action] == @selector(previousTab:)) {
                         validate = [(PLWindowController *)[[NSApp keyWindow] windowController] numberOfTabs] > 1;
@@ -488,15 +726,19 @@ exit:
  *
  * \details Convert the existing font to the new font and send the updateFont:
  *          message to the tab view controller and file browser view controller,
- *          if they implement it.
+ *          if they implement it. The key window is updated first, since its
+ *          active tab is what the user is looking at.
  */
 -(void)changeFont:(id)sender
 {
         NSFont * newFont = [sender convertFont:applicationFont];
         [applicationFont release];
         applicationFont = [newFont retain];
+        if ([[[NSApp keyWindow] windowController] respondsToSelector:@selector(updateFont:)]) {
+                [[[NSApp keyWindow] windowController] updateFont:applicationFont];
+        }
         for (NSWindow * window in [NSApp windows]) {
-                if ([[window windowController] respondsToSelector:@selector(updateFont:)]) {
+                if (window != [NSApp keyWindow] && [[window windowController] respondsToSelector:@selector(updateFont:)]) {
                         [[window windowController] updateFont:applicationFont];
                 }
         }
@@ -0,0 +1,96 @@
+/**
+ * \file PLOpenQuicklyWindowController.h
+ *
+ * \brief Liasis Python IDE Open Quickly panel.
+ *
+ * \details This file includes the controller of the panel used to find and
+ *          open files in the project directory by name.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+#import "PLProjectIndex.h"
+
+/**
+ * \class PLOpenQuicklyWindowController \headerfile \headerfile
+ *
+ * \brief A `NSWindowController` subclass that manages the Open Quickly panel.
+ *
+ * \details The panel contains a search field and a list of the files in a
+ *          `PLProjectIndex` matching its contents. The list is updated on every
+ *          keystroke. The arrow keys change the selected file while the search
+ *          field has focus, return opens it, and escape closes the panel. The
+ *          panel also closes when it is no longer the key window.
+ */
+@interface PLOpenQuicklyWindowController : NSWindowController <NSTableViewDataSource, NSTableViewDelegate, NSTextFieldDelegate, NSWindowDelegate>
+{
+        /**
+         * \brief The field the query is typed in.
+         */
+        NSSearchField * searchField;
+
+        /**
+         * \brief The table view listing the matching files.
+         */
+        NSTableView * resultsTableView;
+
+        /**
+         * \brief The field describing the state of the index.
+         */
+        NSTextField * statusField;
+
+        /**
+         * \brief The full paths of the matching files, best match first.
+         */
+        NSArray * results;
+
+        /**
+         * \brief The index searched by the panel.
+         */
+        PLProjectIndex * projectIndex;
+}
+
+/**
+ * \brief The block that is called when the user chooses a file.
+ */
+@property (copy) void (^openDocumentHandler)(NSURL * fileURL);
+
+/**
+ * \brief Create a new Open Quickly window controller.
+ *
+ * \return A window controller on the autorelease pool.
+ */
++(instancetype)windowController;
+
+/**
+ * \brief Show the panel over a window.
+ *
+ * \details The previous query is kept and selected, so typing replaces it.
+ *
+ * \param index The index to search.
+ *
+ * \param parentWindow The window the panel is positioned over.
+ */
+-(void)showWithProjectIndex:(PLProjectIndex *)index relativeToWindow:(NSWindow *)parentWindow;
+
+@end
@@ -0,0 +1,363 @@
+/**
+ * \file PLOpenQuicklyWindowController.m
+ *
+ * \brief Liasis Python IDE Open Quickly panel.
+ *
+ * \details This file includes the controller of the panel used to find and
+ *          open files in the project directory by name.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLOpenQuicklyWindowController.h"
+
+/**
+ * \brief The maximum number of files listed.
+ */
+static const NSUInteger PLOpenQuicklyMaximumResultCount = 100;
+
+/**
+ * \brief The size of the panel.
+ */
+static const NSSize PLOpenQuicklyPanelSize = {560.0, 360.0};
+
+/**
+ * \brief The distance between the top of the parent window and the panel.
+ */
+static const CGFloat PLOpenQuicklyPanelTopInset = 60.0;
+
+@implementation PLOpenQuicklyWindowController
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Create the panel and its views.
+ */
+-(instancetype)init
+{
+        NSPanel * panel = nil;
+        NSView * contentView = nil;
+        NSScrollView * scrollView = nil;
+        NSTableColumn * column = nil;
+        CGFloat margin = 8.0, searchFieldHeight = 22.0, statusFieldHeight = 17.0;
+
+        panel = [[[NSPanel alloc] initWithContentRect:NSMakeRect(0.0, 0.0, PLOpenQuicklyPanelSize.width, PLOpenQuicklyPanelSize.height)
+                                            styleMask:(NSTitledWindowMask | NSClosableWindowMask)
+                                              backing:NSBackingStoreBuffered
+                                                defer:YES] autorelease];
+        [panel setTitle:@"Open Quickly"];
+        [panel setHidesOnDeactivate:YES];
+        [panel setReleasedWhenClosed:NO];
+
+        self = [super initWithWindow:panel];
+        if (self) {
+                [panel setDelegate:self];
+                contentView = [panel contentView];
+
+                searchField = [[NSSearchField alloc] initWithFrame:NSMakeRect(margin,
+                                                                              PLOpenQuicklyPanelSize.height - margin - searchFieldHeight,
+                                                                              PLOpenQuicklyPanelSize.width - 2.0 * margin,
+                                                                              searchFieldHeight)];
+                [searchField setAutoresizingMask:(NSViewWidthSizable | NSViewMinYMargin)];
+                [[searchField cell] setSendsSearchStringImmediately:YES];
+                [searchField setDelegate:self];
+                [contentView addSubview:searchField];
+
+                statusField = [[NSTextField alloc] initWithFrame:NSMakeRect(margin, margin / 2.0,
+                                                                            PLOpenQuicklyPanelSize.width - 2.0 * margin,
+                                                                            statusFieldHeight)];
+                [statusField setAutoresizingMask:(NSViewWidthSizable | NSViewMaxYMargin)];
+                [statusField setEditable:NO];
+                [statusField setBordered:NO];
+                [statusField setDrawsBackground:NO];
+                [statusField setTextColor:[NSColor disabledControlTextColor]];
+                [statusField setFont:[NSFont systemFontOfSize:[NSFont smallSystemFontSize]]];
+                [contentView addSubview:statusField];
+
+                column = [[[NSTableColumn alloc] initWithIdentifier:@"path"] autorelease];
+                [column setEditable:NO];
+                [column setResizingMask:NSTableColumnAutoresizingMask];
+                resultsTableView = [[NSTableView alloc] initWithFrame:NSZeroRect];
+                [resultsTableView addTableColumn:column];
+                [resultsTableView setHeaderView:nil];
+                [resultsTableView setRowHeight:20.0];
+                [resultsTableView setColumnAutoresizingStyle:NSTableViewUniformColumnAutoresizingStyle];
+                [resultsTableView setDataSource:self];
+                [resultsTableView setDelegate:self];
+                [resultsTableView setTarget:self];
+                [resultsTableView setDoubleAction:@selector(openSelectedResult:)];
+                [resultsTableView setRefusesFirstResponder:YES];
+
+                scrollView = [[[NSScrollView alloc] initWithFrame:NSMakeRect(margin,
+                                                                             margin / 2.0 + statusFieldHeight + margin / 2.0,
+                                                                             PLOpenQuicklyPanelSize.width - 2.0 * margin,
+                                                                             PLOpenQuicklyPanelSize.height - 2.0 * margin - searchFieldHeight - statusFieldHeight - margin)] autorelease];
+                [scrollView setAutoresizingMask:(NSViewWidthSizable | NSViewHeightSizable)];
+                [scrollView setHasVerticalScroller:YES];
+                [scrollView setBorderType:NSBezelBorder];
+                [scrollView setDocumentView:resultsTableView];
+                [column setWidth:[scrollView contentSize].width];
+                [contentView addSubview:scrollView];
+        }
+        return self;
+}
+
++(instancetype)windowController
+{
+        return [[[self alloc] init] autorelease];
+}
+
+/**
+ * \brief Stop observing the index and release the views.
+ */
+-(void)dealloc
+{
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [[self window] setDelegate:nil];
+        [resultsTableView setDataSource:nil];
+        [resultsTableView setDelegate:nil];
+        [searchField setDelegate:nil];
+        [searchField release];
+        [resultsTableView release];
+        [statusField release];
+        [results release];
+        [projectIndex release];
+        [_openDocumentHandler release];
+        [super dealloc];
+}
+
+#pragma mark - Showing
+
+-(void)showWithProjectIndex:(PLProjectIndex *)index relativeToWindow:(NSWindow *)parentWindow
+{
+        NSRect parentFrame = [parentWindow frame];
+        NSRect panelFrame = [[self window] frame];
+
+        if (index != projectIndex) {
+                [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                                name:PLProjectIndexDidUpdateNotification
+                                                              object:projectIndex];
+                [projectIndex release];
+                projectIndex = [index retain];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(projectIndexDidUpdate:)
+                                                             name:PLProjectIndexDidUpdateNotification
+                                                           object:projectIndex];
+        }
+
+        panelFrame.origin.x = NSMidX(parentFrame) - NSWidth(panelFrame) / 2.0;
+        panelFrame.origin.y = NSMaxY(parentFrame) - PLOpenQuicklyPanelTopInset - NSHeight(panelFrame);
+        [[self window] setFrame:panelFrame display:NO];
+        [[self window] makeKeyAndOrderFront:self];
+        [[self window] makeFirstResponder:searchField];
+        [searchField selectText:self];
+
+        [self updateStatus];
+        [self search];
+}
+
+/**
+ * \brief Close the panel when it is no longer the key window.
+ *
+ * \param notification The notification.
+ */
+-(void)windowDidResignKey:(NSNotification *)notification
+{
+        [self close];
+}
+
+#pragma mark - Searching
+
+/**
+ * \brief Search the index for the contents of the search field.
+ *
+ * \details Results arrive asynchronously; results of a query superseded by a
+ *          later keystroke are never delivered.
+ */
+-(void)search
+{
+        NSString * query = [searchField stringValue];
+
+        if ([query length] == 0 || projectIndex == nil) {
+                [self setResults:nil];
+                goto exit;
+        }
+        [projectIndex searchForQuery:query
+                        maximumCount:PLOpenQuicklyMaximumResultCount
+                   completionHandler:^(NSArray * paths) {
+                           [self setResults:paths];
+                   }];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Display new results, selecting the best match.
+ *
+ * \param paths The full paths of the matching files.
+ */
+-(void)setResults:(NSArray *)paths
+{
+        [paths retain];
+        [results release];
+        results = paths;
+        [resultsTableView reloadData];
+        if ([results count] > 0) {
+                [resultsTableView selectRowIndexes:[NSIndexSet indexSetWithIndex:0] byExtendingSelection:NO];
+                [resultsTableView scrollRowToVisible:0];
+        }
+}
+
+/**
+ * \brief Describe the number of indexed files, or that the index is not ready.
+ */
+-(void)updateStatus
+{
+        if ([projectIndex isReady]) {
+                [statusField setStringValue:[NSString stringWithFormat:@"%lu files in %@",
+                                             (unsigned long)[projectIndex numberOfFiles],
+                                             [[projectIndex directoryPath] lastPathComponent]]];
+        } else {
+                [statusField setStringValue:@"Indexing…"];
+        }
+}
+
+/**
+ * \brief Search again when the contents of the index change while the panel
+ *        is visible.
+ *
+ * \param notification The notification.
+ */
+-(void)projectIndexDidUpdate:(NSNotification *)notification
+{
+        if ([[self window] isVisible]) {
+                [self updateStatus];
+                [self search];
+        }
+}
+
+/**
+ * \brief Search when the query changes.
+ *
+ * \param notification The notification.
+ */
+-(void)controlTextDidChange:(NSNotification *)notification
+{
+        [self search];
+}
+
+/**
+ * \brief Handle the keys that control the results while the search field has
+ *        focus.
+ *
+ * \details The up and down arrow keys move the selection, return opens the
+ *          selected file, and escape closes the panel.
+ *
+ * \return YES if the command was handled.
+ */
+-(BOOL)control:(NSControl *)control textView:(NSTextView *)textView doCommandBySelector:(SEL)commandSelector
+{
+        NSInteger selectedRow = [resultsTableView selectedRow];
+        NSInteger rowCount = (NSInteger)[results count];
+        BOOL handled = YES;
+
+        if (commandSelector == @selector(moveUp:)) {
+                selectedRow = MAX(selectedRow - 1, 0);
+        } else if (commandSelector == @selector(moveDown:)) {
+                selectedRow = MIN(selectedRow + 1, rowCount - 1);
+        } else if (commandSelector == @selector(insertNewline:)) {
+                [self openSelectedResult:self];
+                goto exit;
+        } else if (commandSelector == @selector(cancelOperation:)) {
+                [self close];
+                goto exit;
+        } else {
+                handled = NO;
+                goto exit;
+        }
+
+        if (rowCount > 0) {
+                [resultsTableView selectRowIndexes:[NSIndexSet indexSetWithIndex:selectedRow] byExtendingSelection:NO];
+                [resultsTableView scrollRowToVisible:selectedRow];
+        }
+
+exit:
+        return handled;
+}
+
+/**
+ * \brief Close the panel and open the selected file with the
+ *        `openDocumentHandler`.
+ *
+ * \param sender The object sending the message.
+ */
+-(void)openSelectedResult:(id)sender
+{
+        NSInteger selectedRow = [resultsTableView selectedRow];
+        NSURL * fileURL = nil;
+
+        if (selectedRow < 0 || selectedRow >= (NSInteger)[results count]) {
+                goto exit;
+        }
+        fileURL = [NSURL fileURLWithPath:[results objectAtIndex:selectedRow]];
+        [self close];
+        if (self.openDocumentHandler) {
+                self.openDocumentHandler(fileURL);
+        }
+
+exit:
+        return;
+}
+
+#pragma mark - Table View Data Source
+
+-(NSInteger)numberOfRowsInTableView:(NSTableView *)tableView
+{
+        return (NSInteger)[results count];
+}
+
+/**
+ * \brief Display the name of a file followed by its directory relative to the
+ *        project directory, dimmed.
+ */
+-(id)tableView:(NSTableView *)tableView objectValueForTableColumn:(NSTableColumn *)tableColumn row:(NSInteger)row
+{
+        NSString * path = [results objectAtIndex:row];
+        NSString * directory = [[path stringByDeletingLastPathComponent] substringFromIndex:MIN([[projectIndex directoryPath] length],
+                                                                                               [[path stringByDeletingLastPathComponent] length])];
+        NSMutableAttributedString * value = nil;
+
+        if ([directory hasPrefix:@"/"]) {
+                directory = [directory substringFromIndex:1];
+        }
+        value = [[[NSMutableAttributedString alloc] initWithString:[path lastPathComponent]
+                                                        attributes:@{NSFontAttributeName: [NSFont systemFontOfSize:[NSFont systemFontSize]]}] autorelease];
+        if ([directory length] > 0) {
+                [value appendAttributedString:[[[NSAttributedString alloc] initWithString:[@"  " stringByAppendingString:directory]
+                                                                               attributes:@{NSFontAttributeName: [NSFont systemFontOfSize:[NSFont smallSystemFontSize]],
+                                                                                            NSForegroundColorAttributeName: [NSColor disabledControlTextColor]}] autorelease]];
+        }
+        return value;
+}
+
+@end
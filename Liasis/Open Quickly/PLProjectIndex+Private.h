@@ -0,0 +1,82 @@
+/**
+ * \file PLProjectIndex+Private.h
+ *
+ * \brief Liasis Python IDE project file index private interface.
+ *
+ * \details This file declares the snapshot and builder of the index, and the
+ *          methods of the index used by its implementation and unit tests.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLProjectIndex.h"
+
+/**
+ * \class PLProjectIndexSnapshot
+ *
+ * \brief An immutable index, either memory mapped from an index file or built
+ *        in memory in the same format.
+ */
+@interface PLProjectIndexSnapshot : NSObject
+
+-(instancetype)initWithData:(NSData *)indexData rootPath:(NSString *)rootPath;
+
+-(NSString *)relativePathOfDirectoryAtIndex:(uint32_t)directoryIndex;
+
+-(NSString *)pathOfFileAtIndex:(uint32_t)fileIndex rootPath:(NSString *)rootPath;
+
+@end
+
+/**
+ * \class PLProjectIndexBuilder
+ *
+ * \brief Accumulates directories and files and produces index data.
+ */
+@interface PLProjectIndexBuilder : NSObject
+
+-(instancetype)initWithRootPath:(NSString *)path;
+
+-(uint32_t)indexOfDirectoryAtPath:(NSString *)relativePath;
+
+-(BOOL)addFileNamed:(const char *)name length:(size_t)length directoryIndex:(uint32_t)directoryIndex characterMask:(uint64_t)characterMask;
+
+-(BOOL)readDirectoryAtPath:(NSString *)relativePath subdirectories:(NSMutableArray *)subdirectories;
+
+-(void)addDirectoryTreeAtPath:(NSString *)relativePath;
+
+-(NSData *)dataWithLastEventIdentifier:(uint64_t)lastEventIdentifier eventHistoryIdentifier:(NSString *)eventHistoryIdentifier;
+
+@end
+
+@interface PLProjectIndex ()
+
+/**
+ * \brief Initialize an index of a project directory without opening it.
+ */
+-(instancetype)initWithDirectoryPath:(NSString *)path;
+
+/**
+ * \brief Replace the contents of the index.
+ */
+-(void)setSnapshot:(PLProjectIndexSnapshot *)newSnapshot;
+
+@end
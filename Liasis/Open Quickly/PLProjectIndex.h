@@ -0,0 +1,202 @@
+/**
+ * \file PLProjectIndex.h
+ *
+ * \brief Liasis Python IDE project file index.
+ *
+ * \details This file includes the persistent index of the files below a
+ *          project directory used by Open Quickly.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+#import "PLFileSystemWatcher.h"
+
+@class PLProjectIndexSnapshot;
+
+/**
+ * \brief Posted on the main queue when the contents of a project index change.
+ *
+ * \details The notification object is the `PLProjectIndex`.
+ */
+extern NSString * const PLProjectIndexDidUpdateNotification;
+
+/**
+ * \class PLProjectIndex \headerfile \headerfile
+ *
+ * \brief A persistent, incrementally updated index of the files below a
+ *        project directory.
+ *
+ * \details The index is stored in a single file in the user's caches directory
+ *          and is memory mapped when it is opened, so an index built in a
+ *          previous session is searchable immediately. Directory paths are
+ *          interned: each file is stored as a directory index and a name in a
+ *          shared string pool, along with a bit mask of the characters in the
+ *          name that lets most files be rejected without being scored.
+ *
+ *          The index is built in the background the first time a directory is
+ *          indexed and kept current by a `PLFileSystemWatcher`. Only the
+ *          directories reported by the watcher are read again. Where the
+ *          watcher keeps an event history, the changes made while the
+ *          application was not running are replayed when the index is opened;
+ *          otherwise, the index is rebuilt in the background while the
+ *          persisted copy is searched.
+ *
+ *          Searches score every file with a fuzzy subsequence match in
+ *          parallel and return the best matches.
+ */
+@interface PLProjectIndex : NSObject
+{
+        /**
+         * \brief The current contents of the index.
+         *
+         * \details Snapshots are immutable. Updates build a new snapshot and
+         *          replace this one.
+         */
+        PLProjectIndexSnapshot * snapshot;
+
+        /**
+         * \brief The serial queue on which the index is built and updated.
+         */
+        dispatch_queue_t indexQueue;
+
+        /**
+         * \brief The serial queue on which searches run.
+         */
+        dispatch_queue_t searchQueue;
+
+        /**
+         * \brief The watcher reporting changes below the project directory.
+         */
+        PLFileSystemWatcher * watcher;
+
+        /**
+         * \brief Incremented for every search so that stale searches can be
+         *        skipped.
+         */
+        volatile int64_t searchGeneration;
+
+        /**
+         * \brief YES if the index is scheduled to be written to disk.
+         */
+        BOOL saveScheduled;
+
+        /**
+         * \brief YES once the index was evicted, so it is not watched again.
+         */
+        BOOL closed;
+}
+
+/**
+ * \brief The project directory.
+ */
+@property (retain, readonly) NSString * directoryPath;
+
+/**
+ * \brief Get the index of a project directory.
+ *
+ * \details Indexes are shared by all windows. The first call for a directory
+ *          opens the persisted index, if any, and starts building or updating
+ *          it in the background. The index is kept until the last client
+ *          registered with `retainIndexForDirectoryAtPath:` releases it.
+ *
+ * \param directoryPath The project directory.
+ *
+ * \return The project index.
+ */
++(instancetype)indexForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Register a client of the index of a project directory, such as a
+ *        window showing the directory.
+ *
+ * \details Does not open the index.
+ *
+ * \param directoryPath The project directory.
+ */
++(void)retainIndexForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Unregister a client of the index of a project directory.
+ *
+ * \details When the last client is unregistered, the index stops watching the
+ *          directory and is dropped from the shared indexes, so its memory
+ *          mapped file is unmapped once the searches holding it finish. Must be
+ *          called on the main thread.
+ *
+ * \param directoryPath The project directory.
+ */
++(void)releaseIndexForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Determine if an index of a directory was persisted in a previous
+ *        session.
+ *
+ * \param directoryPath The project directory.
+ *
+ * \return YES if an index file exists for the directory.
+ */
++(BOOL)hasPersistentIndexForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Determine if the index can be searched.
+ *
+ * \return YES if the index has been opened or built.
+ */
+-(BOOL)isReady;
+
+/**
+ * \brief The number of files in the index.
+ *
+ * \return The number of files.
+ */
+-(NSUInteger)numberOfFiles;
+
+/**
+ * \brief Search the index for files matching a query.
+ *
+ * \details The search runs in the background and `completionHandler` is called
+ *          on the main queue. If another search is started before this one
+ *          runs, this search is skipped and `completionHandler` is not called.
+ *
+ * \param query The query. Its characters must appear in order in the relative
+ *              path of a matching file, ignoring case.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \param completionHandler The block called with an array of the full paths of
+ *                          the matching files, best match first.
+ */
+-(void)searchForQuery:(NSString *)query maximumCount:(NSUInteger)maximumCount completionHandler:(void (^)(NSArray * paths))completionHandler;
+
+/**
+ * \brief Search the index for files matching a query on the calling thread.
+ *
+ * \param query The query.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \return An array of the full paths of the matching files, best match first.
+ */
+-(NSArray *)pathsMatchingQuery:(NSString *)query maximumCount:(NSUInteger)maximumCount;
+
+@end
@@ -0,0 +1,1289 @@
+/**
+ * \file PLProjectIndex.m
+ *
+ * \brief Liasis Python IDE project file index.
+ *
+ * \details This file includes the persistent index of the files below a
+ *          project directory used by Open Quickly.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLProjectIndex.h"
+#import "PLProjectIndex+Private.h"
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+NSString * const PLProjectIndexDidUpdateNotification = @"PLProjectIndexDidUpdateNotification";
+
+/**
+ * \brief The first four bytes of an index file ("PLIX").
+ */
+static const uint32_t PLProjectIndexMagic = 0x58494C50;
+
+/**
+ * \brief The version of the index file format.
+ */
+static const uint32_t PLProjectIndexVersion = 1;
+
+/**
+ * \brief The maximum number of files indexed below a directory.
+ *
+ * \details This bounds the size of the index if a very large directory, such
+ *          as the home directory, is indexed.
+ */
+static const NSUInteger PLProjectIndexMaximumFileCount = 2000000;
+
+/**
+ * \brief The time in seconds that file system changes are coalesced before the
+ *        index is updated.
+ */
+static const NSTimeInterval PLProjectIndexWatcherLatency = 1.0;
+
+/**
+ * \brief The time in seconds after an update before the index is written to
+ *        disk.
+ */
+static const NSTimeInterval PLProjectIndexSaveDelay = 5.0;
+
+/**
+ * \brief The number of files scored by each parallel search task.
+ */
+static const size_t PLProjectIndexSearchChunkSize = 16384;
+
+/**
+ * \brief The maximum number of results returned by a search.
+ */
+static const NSUInteger PLProjectIndexMaximumResultCount = 256;
+
+/**
+ * \brief The score of a match whose query is entirely within the file name.
+ *
+ * \details Matches within the name always rank above matches spanning the
+ *          directory path.
+ */
+static const int32_t PLProjectIndexNameMatchScore = 1000;
+
+#pragma mark - File Format
+
+/**
+ * \brief The header of an index file.
+ *
+ * \details The header is followed by the directory table, the file table, and
+ *          the string pool. The string pool begins with the root path.
+ */
+typedef struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t directoryCount;
+        uint32_t fileCount;
+        uint32_t poolLength;
+        uint32_t rootPathLength;
+        uint64_t lastEventIdentifier;
+        char eventHistoryIdentifier[48];
+} PLProjectIndexHeader;
+
+/**
+ * \brief An interned directory path relative to the root, stored in the pool.
+ */
+typedef struct {
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint64_t characterMask;
+} PLProjectIndexDirectory;
+
+/**
+ * \brief A file in the index: the index of its directory and its name, stored
+ *        in the pool.
+ */
+typedef struct {
+        uint32_t directoryIndex;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t reserved;
+        uint64_t characterMask;
+} PLProjectIndexFile;
+
+/**
+ * \brief A scored file.
+ */
+typedef struct {
+        int32_t score;
+        uint32_t fileIndex;
+} PLProjectIndexMatch;
+
+#pragma mark - Matching
+
+/**
+ * \brief Lowercase an ASCII character, leaving other bytes unchanged.
+ */
+static inline uint8_t PLProjectIndexLowercase(uint8_t character)
+{
+        return (character >= 'A' && character <= 'Z') ? (uint8_t)(character + ('a' - 'A')) : character;
+}
+
+/**
+ * \brief Compute the bit mask of the characters in a string.
+ *
+ * \details Letters and digits have a bit each, ignoring case. Other bytes
+ *          share the remaining bits. If a query's mask is not a subset of a
+ *          path's mask, the query cannot match the path.
+ *
+ * \param characters The characters.
+ *
+ * \param length The number of characters.
+ *
+ * \return The character mask.
+ */
+static uint64_t PLProjectIndexCharacterMask(const char * characters, size_t length)
+{
+        uint64_t mask = 0;
+        uint8_t character = 0;
+        size_t i = 0;
+
+        for (i = 0; i < length; i++) {
+                character = PLProjectIndexLowercase((uint8_t)characters[i]);
+                if (character >= 'a' && character <= 'z') {
+                        mask |= 1ULL << (character - 'a');
+                } else if (character >= '0' && character <= '9') {
+                        mask |= 1ULL << (26 + character - '0');
+                } else {
+                        mask |= 1ULL << (36 + character % 28);
+                }
+        }
+        return mask;
+}
+
+/**
+ * \brief Determine if a character begins a word.
+ *
+ * \details Words begin at the start of the string, after a separator, and at a
+ *          lowercase to uppercase transition.
+ */
+static inline BOOL PLProjectIndexIsWordStart(uint8_t previous, uint8_t character)
+{
+        return (previous == '\0' || previous == '/' || previous == '_' || previous == '-' || previous == '.' || previous == ' ' ||
+                (previous >= 'a' && previous <= 'z' && character >= 'A' && character <= 'Z'));
+}
+
+/**
+ * \brief Score a file against a lowercased query.
+ *
+ * \details The query is matched greedily as a subsequence, first against the
+ *          file name alone and then against the relative path. Each matched
+ *          character scores a point, with bonuses for consecutive characters
+ *          and characters that begin words. Shorter names and paths score
+ *          higher.
+ *
+ * \return The score, or -1 if the query does not match.
+ */
+static int32_t PLProjectIndexScore(const uint8_t * query, size_t queryLength,
+                                   const char * directory, size_t directoryLength,
+                                   const char * name, size_t nameLength)
+{
+        size_t pathLength = directoryLength + (directoryLength > 0 ? 1 : 0) + nameLength;
+        size_t queryIndex = 0, i = 0, previousMatch = SIZE_MAX;
+        uint8_t character = 0, previous = '\0';
+        int32_t score = 0;
+
+        /* Match within the name */
+        for (i = 0; i < nameLength && queryIndex < queryLength; i++) {
+                character = (uint8_t)name[i];
+                if (PLProjectIndexLowercase(character) == query[queryIndex]) {
+                        score += 1;
+                        if (previousMatch != SIZE_MAX && previousMatch + 1 == i) {
+                                score += 5;
+                        }
+                        if (PLProjectIndexIsWordStart(i > 0 ? (uint8_t)name[i - 1] : '\0', character)) {
+                                score += 8;
+                        }
+                        previousMatch = i;
+                        queryIndex++;
+                }
+        }
+        if (queryIndex == queryLength) {
+                return PLProjectIndexNameMatchScore + score * 4 - (int32_t)nameLength;
+        }
+
+        /* Match across the relative path */
+        score = 0;
+        queryIndex = 0;
+        previousMatch = SIZE_MAX;
+        for (i = 0; i < pathLength && queryIndex < queryLength; i++) {
+                if (i < directoryLength) {
+                        character = (uint8_t)directory[i];
+                } else if (i == directoryLength && directoryLength > 0) {
+                        character = '/';
+                } else {
+                        character = (uint8_t)name[i - (pathLength - nameLength)];
+                }
+                if (PLProjectIndexLowercase(character) == query[queryIndex]) {
+                        score += 1;
+                        if (previousMatch != SIZE_MAX && previousMatch + 1 == i) {
+                                score += 5;
+                        }
+                        if (PLProjectIndexIsWordStart(previous, character)) {
+                                score += 8;
+                        }
+                        previousMatch = i;
+                        queryIndex++;
+                }
+                previous = character;
+        }
+        if (queryIndex == queryLength) {
+                score -= (int32_t)(pathLength / 8);
+                return score > 0 ? score : 0;
+        }
+        return -1;
+}
+
+/**
+ * \brief Find the lowest scoring match in an array.
+ */
+static size_t PLProjectIndexLowestMatch(const PLProjectIndexMatch * matches, size_t count)
+{
+        size_t lowest = 0, i = 0;
+
+        for (i = 1; i < count; i++) {
+                if (matches[i].score < matches[lowest].score) {
+                        lowest = i;
+                }
+        }
+        return lowest;
+}
+
+/**
+ * \brief Order matches by descending score.
+ */
+static int PLProjectIndexCompareMatches(const void * first, const void * second)
+{
+        const PLProjectIndexMatch * firstMatch = first, * secondMatch = second;
+
+        if (firstMatch->score != secondMatch->score) {
+                return firstMatch->score > secondMatch->score ? -1 : 1;
+        }
+        return firstMatch->fileIndex < secondMatch->fileIndex ? -1 : (firstMatch->fileIndex > secondMatch->fileIndex);
+}
+
+#pragma mark -
+
+/**
+ * \brief The tables of the snapshot, read directly by the index.
+ */
+@interface PLProjectIndexSnapshot ()
+{
+@public
+        NSData * data;
+        const PLProjectIndexHeader * header;
+        const PLProjectIndexDirectory * directories;
+        const PLProjectIndexFile * files;
+        const char * pool;
+}
+
+@end
+
+@implementation PLProjectIndexSnapshot
+
+/**
+ * \brief Initialize a snapshot with index data.
+ *
+ * \details The data is validated so that a truncated or corrupt index file is
+ *          never searched.
+ *
+ * \param indexData The index data.
+ *
+ * \param rootPath The directory the index must belong to.
+ *
+ * \return The snapshot, or nil if the data is not a valid index of `rootPath`.
+ */
+-(instancetype)initWithData:(NSData *)indexData rootPath:(NSString *)rootPath
+{
+        const char * rootRepresentation = [rootPath fileSystemRepresentation];
+        const uint8_t * bytes = [indexData bytes];
+        uint64_t expectedLength = 0;
+        uint32_t i = 0;
+
+        self = [super init];
+        if (self == nil) {
+                goto exit;
+        }
+
+        if ([indexData length] < sizeof(PLProjectIndexHeader)) {
+                goto fail;
+        }
+        header = (const PLProjectIndexHeader *)bytes;
+        expectedLength = (sizeof(PLProjectIndexHeader) +
+                          (uint64_t)header->directoryCount * sizeof(PLProjectIndexDirectory) +
+                          (uint64_t)header->fileCount * sizeof(PLProjectIndexFile) +
+                          header->poolLength);
+        if (header->magic != PLProjectIndexMagic || header->version != PLProjectIndexVersion ||
+            expectedLength != [indexData length] || header->rootPathLength > header->poolLength) {
+                goto fail;
+        }
+        directories = (const PLProjectIndexDirectory *)(bytes + sizeof(PLProjectIndexHeader));
+        files = (const PLProjectIndexFile *)(directories + header->directoryCount);
+        pool = (const char *)(files + header->fileCount);
+        if (strlen(rootRepresentation) != header->rootPathLength ||
+            memcmp(pool, rootRepresentation, header->rootPathLength) != 0) {
+                goto fail;
+        }
+        for (i = 0; i < header->directoryCount; i++) {
+                if ((uint64_t)directories[i].pathOffset + directories[i].pathLength > header->poolLength) {
+                        goto fail;
+                }
+        }
+        for (i = 0; i < header->fileCount; i++) {
+                if (files[i].directoryIndex >= header->directoryCount ||
+                    (uint64_t)files[i].nameOffset + files[i].nameLength > header->poolLength) {
+                        goto fail;
+                }
+        }
+        data = [indexData retain];
+
+exit:
+        return self;
+
+fail:
+        [self release];
+        return nil;
+}
+
+-(void)dealloc
+{
+        [data release];
+        [super dealloc];
+}
+
+-(NSString *)relativePathOfDirectoryAtIndex:(uint32_t)directoryIndex
+{
+        const PLProjectIndexDirectory * directory = &directories[directoryIndex];
+
+        return [[NSFileManager defaultManager] stringWithFileSystemRepresentation:pool + directory->pathOffset
+                                                                           length:directory->pathLength];
+}
+
+-(NSString *)pathOfFileAtIndex:(uint32_t)fileIndex rootPath:(NSString *)rootPath
+{
+        const PLProjectIndexFile * file = &files[fileIndex];
+        NSString * name = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:pool + file->nameOffset
+                                                                                      length:file->nameLength];
+
+        return [[rootPath stringByAppendingPathComponent:[self relativePathOfDirectoryAtIndex:file->directoryIndex]]
+                stringByAppendingPathComponent:name];
+}
+
+@end
+
+#pragma mark -
+
+/**
+ * \brief The tables being built.
+ */
+@interface PLProjectIndexBuilder ()
+{
+        NSString * rootPath;
+        NSMutableData * directoryTable;
+        NSMutableData * fileTable;
+        NSMutableData * pool;
+        NSMutableDictionary * directoryIndexes;
+        uint32_t fileCount;
+}
+
+@end
+
+@implementation PLProjectIndexBuilder
+
+-(instancetype)initWithRootPath:(NSString *)path
+{
+        const char * rootRepresentation = [path fileSystemRepresentation];
+
+        self = [super init];
+        if (self) {
+                rootPath = [path copy];
+                directoryTable = [[NSMutableData alloc] init];
+                fileTable = [[NSMutableData alloc] init];
+                pool = [[NSMutableData alloc] initWithBytes:rootRepresentation length:strlen(rootRepresentation)];
+                directoryIndexes = [[NSMutableDictionary alloc] init];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [rootPath release];
+        [directoryTable release];
+        [fileTable release];
+        [pool release];
+        [directoryIndexes release];
+        [super dealloc];
+}
+
+/**
+ * \brief Intern a directory path.
+ *
+ * \param relativePath The path relative to the root, or an empty string for
+ *                     the root.
+ *
+ * \return The index of the directory.
+ */
+-(uint32_t)indexOfDirectoryAtPath:(NSString *)relativePath
+{
+        NSNumber * existingIndex = [directoryIndexes objectForKey:relativePath];
+        const char * pathRepresentation = nil;
+        PLProjectIndexDirectory directory;
+        uint32_t directoryIndex = 0;
+
+        if (existingIndex) {
+                directoryIndex = [existingIndex unsignedIntValue];
+                goto exit;
+        }
+
+        pathRepresentation = [relativePath length] > 0 ? [relativePath fileSystemRepresentation] : "";
+        directory.pathOffset = (uint32_t)[pool length];
+        directory.pathLength = (uint32_t)strlen(pathRepresentation);
+        directory.characterMask = PLProjectIndexCharacterMask(pathRepresentation, directory.pathLength);
+        if (directory.pathLength > 0) {
+                directory.characterMask |= PLProjectIndexCharacterMask("/", 1);
+        }
+        [pool appendBytes:pathRepresentation length:directory.pathLength];
+        directoryIndex = (uint32_t)([directoryTable length] / sizeof(PLProjectIndexDirectory));
+        [directoryTable appendBytes:&directory length:sizeof(directory)];
+        [directoryIndexes setObject:@(directoryIndex) forKey:relativePath];
+
+exit:
+        return directoryIndex;
+}
+
+/**
+ * \brief Add a file.
+ *
+ * \param characterMask The character mask of the name, or 0 to compute it.
+ *
+ * \return NO if the index is full.
+ */
+-(BOOL)addFileNamed:(const char *)name length:(size_t)length directoryIndex:(uint32_t)directoryIndex characterMask:(uint64_t)characterMask
+{
+        PLProjectIndexFile file;
+
+        if (fileCount >= PLProjectIndexMaximumFileCount) {
+                return NO;
+        }
+        file.directoryIndex = directoryIndex;
+        file.nameOffset = (uint32_t)[pool length];
+        file.nameLength = (uint32_t)length;
+        file.reserved = 0;
+        file.characterMask = characterMask ?: PLProjectIndexCharacterMask(name, length);
+        [pool appendBytes:name length:length];
+        [fileTable appendBytes:&file length:sizeof(file)];
+        fileCount++;
+        return YES;
+}
+
+/**
+ * \brief Add a directory and the files directly within it.
+ *
+ * \details Entries whose names begin with a dot are skipped, as are
+ *          directories hidden in the Finder. Symbolic links to files are
+ *          indexed, but symbolic links to directories are not followed.
+ *
+ * \param relativePath The path of the directory relative to the root.
+ *
+ * \param subdirectories The array the relative paths of the subdirectories are
+ *                       added to.
+ *
+ * \return NO if the directory could not be read.
+ */
+-(BOOL)readDirectoryAtPath:(NSString *)relativePath subdirectories:(NSMutableArray *)subdirectories
+{
+        NSString * fullPath = [relativePath length] > 0 ? [rootPath stringByAppendingPathComponent:relativePath] : rootPath;
+        const char * directoryRepresentation = [fullPath fileSystemRepresentation];
+        char entryPath[PATH_MAX];
+        DIR * directory = NULL;
+        struct dirent * entry = NULL;
+        struct stat entryInfo;
+        uint32_t directoryIndex = 0;
+        size_t nameLength = 0;
+        BOOL isDirectory = NO, isFile = NO, successful = NO;
+        NSString * name = nil;
+
+        directory = opendir(directoryRepresentation);
+        if (directory == NULL) {
+                goto exit;
+        }
+        successful = YES;
+        directoryIndex = [self indexOfDirectoryAtPath:relativePath];
+
+        while ((entry = readdir(directory)) != NULL) {
+                if (entry->d_name[0] == '.') {
+                        continue;
+                }
+                nameLength = strlen(entry->d_name);
+                isDirectory = (entry->d_type == DT_DIR);
+                isFile = (entry->d_type == DT_REG);
+                if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+                        if (snprintf(entryPath, sizeof(entryPath), "%s/%s", directoryRepresentation, entry->d_name) >= (int)sizeof(entryPath) ||
+                            (entry->d_type == DT_LNK ? stat(entryPath, &entryInfo) : lstat(entryPath, &entryInfo)) != 0) {
+                                continue;
+                        }
+                        isFile = S_ISREG(entryInfo.st_mode);
+                        isDirectory = (entry->d_type == DT_UNKNOWN && S_ISDIR(entryInfo.st_mode));
+                }
+#if defined(UF_HIDDEN)
+                if (isDirectory) {
+                        if (snprintf(entryPath, sizeof(entryPath), "%s/%s", directoryRepresentation, entry->d_name) >= (int)sizeof(entryPath) ||
+                            lstat(entryPath, &entryInfo) != 0 || (entryInfo.st_flags & UF_HIDDEN)) {
+                                continue;
+                        }
+                }
+#endif
+                if (isDirectory) {
+                        name = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:entry->d_name length:nameLength];
+                        [subdirectories addObject:([relativePath length] > 0 ? [relativePath stringByAppendingPathComponent:name] : name)];
+                } else if (isFile) {
+                        if ([self addFileNamed:entry->d_name
+                                        length:nameLength
+                                directoryIndex:directoryIndex
+                                 characterMask:PLProjectIndexCharacterMask(entry->d_name, nameLength)] == NO) {
+                                break;
+                        }
+                }
+        }
+
+exit:
+        if (directory) {
+                closedir(directory);
+        }
+        return successful;
+}
+
+/**
+ * \brief Add a directory and everything below it.
+ *
+ * \param relativePath The path of the directory relative to the root.
+ */
+-(void)addDirectoryTreeAtPath:(NSString *)relativePath
+{
+        NSMutableArray * pendingDirectories = [NSMutableArray arrayWithObject:relativePath];
+        NSString * currentPath = nil;
+
+        while ([pendingDirectories count] > 0 && fileCount < PLProjectIndexMaximumFileCount) {
+                @autoreleasepool {
+                        currentPath = [[pendingDirectories lastObject] retain];
+                        [pendingDirectories removeLastObject];
+                        [self readDirectoryAtPath:currentPath subdirectories:pendingDirectories];
+                        [currentPath release];
+                }
+        }
+}
+
+/**
+ * \brief Produce the index data.
+ *
+ * \param lastEventIdentifier The identifier of the last file system event
+ *                            reflected in the index.
+ *
+ * \param eventHistoryIdentifier The history `lastEventIdentifier` refers to.
+ *
+ * \return The index data in the index file format.
+ */
+-(NSData *)dataWithLastEventIdentifier:(uint64_t)lastEventIdentifier eventHistoryIdentifier:(NSString *)eventHistoryIdentifier
+{
+        NSMutableData * indexData = nil;
+        PLProjectIndexHeader header;
+
+        memset(&header, 0, sizeof(header));
+        header.magic = PLProjectIndexMagic;
+        header.version = PLProjectIndexVersion;
+        header.directoryCount = (uint32_t)([directoryTable length] / sizeof(PLProjectIndexDirectory));
+        header.fileCount = fileCount;
+        header.poolLength = (uint32_t)[pool length];
+        header.rootPathLength = (uint32_t)strlen([rootPath fileSystemRepresentation]);
+        header.lastEventIdentifier = lastEventIdentifier;
+        if (eventHistoryIdentifier) {
+                strncpy(header.eventHistoryIdentifier, [eventHistoryIdentifier UTF8String], sizeof(header.eventHistoryIdentifier) - 1);
+        }
+
+        indexData = [NSMutableData dataWithCapacity:sizeof(header) + [directoryTable length] + [fileTable length] + [pool length]];
+        [indexData appendBytes:&header length:sizeof(header)];
+        [indexData appendData:directoryTable];
+        [indexData appendData:fileTable];
+        [indexData appendData:pool];
+        return indexData;
+}
+
+@end
+
+#pragma mark -
+
+/**
+ * \brief Determine if a relative path is a directory or lies below it.
+ *
+ * \details The empty path is the root, which contains every path.
+ */
+static BOOL PLProjectIndexRelativePathIsWithin(NSString * relativePath, NSString * directoryPath)
+{
+        return [directoryPath length] == 0 || PLPathIsWithinDirectory(relativePath, directoryPath);
+}
+
+/**
+ * \brief Determine if a relative path lies within any directory in a set.
+ */
+static BOOL PLProjectIndexRelativePathIsWithinAny(NSString * relativePath, NSSet * directoryPaths)
+{
+        for (NSString * directoryPath in directoryPaths) {
+                if (PLProjectIndexRelativePathIsWithin(relativePath, directoryPath)) {
+                        return YES;
+                }
+        }
+        return NO;
+}
+
+@interface PLProjectIndex ()
+
+@property (retain, readwrite) NSString * directoryPath;
+
+@end
+
+@implementation PLProjectIndex
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Initialize an index of a directory.
+ *
+ * \details The index is not opened. Use `indexForDirectoryAtPath:` to get the
+ *          shared index of a directory.
+ *
+ * \param path The project directory.
+ *
+ * \return The project index.
+ */
+-(instancetype)initWithDirectoryPath:(NSString *)path
+{
+        __block PLProjectIndex * blockSelf = self;
+
+        self = [super init];
+        if (self) {
+                _directoryPath = [path copy];
+                indexQueue = dispatch_queue_create("org.liasis.projectindex.index", DISPATCH_QUEUE_SERIAL);
+                searchQueue = dispatch_queue_create("org.liasis.projectindex.search", DISPATCH_QUEUE_SERIAL);
+                blockSelf = self;
+                watcher = [[PLFileSystemWatcher watcherWithPath:path
+                                                        latency:PLProjectIndexWatcherLatency
+                                                   eventHandler:^(NSSet * changedDirectories, NSSet * rescannedDirectories) {
+                                                           [blockSelf directoriesDidChange:changedDirectories
+                                                                      rescannedDirectories:rescannedDirectories];
+                                                   }] retain];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [watcher stop];
+        [watcher release];
+        [snapshot release];
+        [_directoryPath release];
+        dispatch_release(indexQueue);
+        dispatch_release(searchQueue);
+        [super dealloc];
+}
+
++(NSMutableDictionary *)sharedIndexes
+{
+        static NSMutableDictionary * sharedIndexes = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedIndexes = [[NSMutableDictionary alloc] init];
+        });
+        return sharedIndexes;
+}
+
++(instancetype)indexForDirectoryAtPath:(NSString *)directoryPath
+{
+        PLProjectIndex * index = [[self sharedIndexes] objectForKey:directoryPath];
+
+        if (index == nil) {
+                index = [[[self alloc] initWithDirectoryPath:directoryPath] autorelease];
+                [[self sharedIndexes] setObject:index forKey:directoryPath];
+                [index open];
+        }
+        return index;
+}
+
+/**
+ * \brief The number of clients of each project directory.
+ */
++(NSCountedSet *)sharedClients
+{
+        static NSCountedSet * sharedClients = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedClients = [[NSCountedSet alloc] init];
+        });
+        return sharedClients;
+}
+
++(void)retainIndexForDirectoryAtPath:(NSString *)directoryPath
+{
+        if (directoryPath) {
+                [[self sharedClients] addObject:directoryPath];
+        }
+}
+
++(void)releaseIndexForDirectoryAtPath:(NSString *)directoryPath
+{
+        if (directoryPath == nil || [[self sharedClients] countForObject:directoryPath] == 0) {
+                goto exit;
+        }
+        [[self sharedClients] removeObject:directoryPath];
+        if ([[self sharedClients] countForObject:directoryPath] == 0) {
+                [[[self sharedIndexes] objectForKey:directoryPath] close];
+                [[self sharedIndexes] removeObjectForKey:directoryPath];
+        }
+
+exit:
+        return;
+}
+
++(BOOL)hasPersistentIndexForDirectoryAtPath:(NSString *)directoryPath
+{
+        return [[NSFileManager defaultManager] fileExistsAtPath:[self indexFilePathForDirectoryAtPath:directoryPath]];
+}
+
+/**
+ * \brief The path of the index file of a directory.
+ *
+ * \details Index files are stored in the application's caches directory and
+ *          named by a hash of the directory path.
+ *
+ * \param directoryPath The project directory.
+ *
+ * \return The path of the index file.
+ */
++(NSString *)indexFilePathForDirectoryAtPath:(NSString *)directoryPath
+{
+        NSString * cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+        NSString * bundleIdentifier = [[NSBundle mainBundle] bundleIdentifier] ?: @"Liasis";
+        const char * pathRepresentation = [directoryPath fileSystemRepresentation];
+        uint64_t hash = 14695981039346656037ULL;
+
+        /* 64-bit FNV-1a */
+        for (; *pathRepresentation; pathRepresentation++) {
+                hash ^= (uint8_t)*pathRepresentation;
+                hash *= 1099511628211ULL;
+        }
+        return [[[cachesPath stringByAppendingPathComponent:bundleIdentifier]
+                 stringByAppendingPathComponent:@"ProjectIndex"]
+                stringByAppendingPathComponent:[NSString stringWithFormat:@"%016llx.plindex", hash]];
+}
+
+#pragma mark - Snapshots
+
+-(PLProjectIndexSnapshot *)currentSnapshot
+{
+        PLProjectIndexSnapshot * currentSnapshot = nil;
+
+        @synchronized(self) {
+                currentSnapshot = [[snapshot retain] autorelease];
+        }
+        return currentSnapshot;
+}
+
+/**
+ * \brief Replace the contents of the index.
+ *
+ * \details This method may be called from any thread. The
+ *          `PLProjectIndexDidUpdateNotification` notification is posted on the
+ *          main queue.
+ *
+ * \param newSnapshot The new snapshot.
+ */
+-(void)setSnapshot:(PLProjectIndexSnapshot *)newSnapshot
+{
+        @synchronized(self) {
+                [newSnapshot retain];
+                [snapshot release];
+                snapshot = newSnapshot;
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+                [[NSNotificationCenter defaultCenter] postNotificationName:PLProjectIndexDidUpdateNotification object:self];
+        });
+}
+
+-(BOOL)isReady
+{
+        return [self currentSnapshot] != nil;
+}
+
+-(NSUInteger)numberOfFiles
+{
+        PLProjectIndexSnapshot * currentSnapshot = [self currentSnapshot];
+
+        return currentSnapshot ? currentSnapshot->header->fileCount : 0;
+}
+
+#pragma mark - Building and Updating
+
+/**
+ * \brief Open the persisted index and start keeping it current.
+ *
+ * \details The index file is memory mapped on `indexQueue`. If the watcher's
+ *          event history covers the persisted index, the watcher replays the
+ *          changes made since it was written. Otherwise the index is rebuilt in
+ *          the background, while the persisted copy, if any, stays searchable.
+ */
+-(void)open
+{
+        NSString * indexFilePath = [[self class] indexFilePathForDirectoryAtPath:self.directoryPath];
+
+        dispatch_async(indexQueue, ^{
+                NSData * indexData = nil;
+                PLProjectIndexSnapshot * persistedSnapshot = nil;
+
+                @autoreleasepool {
+                        indexData = [NSData dataWithContentsOfFile:indexFilePath options:NSDataReadingMappedAlways error:NULL];
+                        if (indexData) {
+                                persistedSnapshot = [[[PLProjectIndexSnapshot alloc] initWithData:indexData rootPath:self.directoryPath] autorelease];
+                        }
+                        if (persistedSnapshot) {
+                                [self setSnapshot:persistedSnapshot];
+                        }
+                        dispatch_async(dispatch_get_main_queue(), ^{
+                                [self startWatchingFromSnapshot:persistedSnapshot];
+                        });
+                }
+        });
+}
+
+/**
+ * \brief Stop watching the project directory.
+ *
+ * \details Called when the index is evicted. Queued updates and the pending
+ *          save still complete.
+ */
+-(void)close
+{
+        closed = YES;
+        [watcher stop];
+}
+
+/**
+ * \brief Start the watcher, replaying history if possible.
+ *
+ * \details Does nothing if the index was closed while it was being opened.
+ *
+ * \param persistedSnapshot The snapshot read from the index file, or nil.
+ */
+-(void)startWatchingFromSnapshot:(PLProjectIndexSnapshot *)persistedSnapshot
+{
+        NSString * eventHistoryIdentifier = [watcher eventHistoryIdentifier];
+        BOOL replaysHistory = NO;
+
+        if (closed) {
+                goto exit;
+        }
+        replaysHistory = (persistedSnapshot != nil &&
+                          eventHistoryIdentifier != nil &&
+                          persistedSnapshot->header->lastEventIdentifier != 0 &&
+                          strncmp(persistedSnapshot->header->eventHistoryIdentifier,
+                                  [eventHistoryIdentifier UTF8String],
+                                  sizeof(persistedSnapshot->header->eventHistoryIdentifier)) == 0);
+        if (replaysHistory) {
+                [watcher startSinceEventIdentifier:persistedSnapshot->header->lastEventIdentifier];
+        } else {
+                [watcher start];
+                dispatch_async(indexQueue, ^{
+                        @autoreleasepool {
+                                [self rebuildWithLastEventIdentifier:[watcher lastEventIdentifier]
+                                              eventHistoryIdentifier:eventHistoryIdentifier];
+                        }
+                });
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Build the index from scratch.
+ *
+ * \details This method runs on `indexQueue`.
+ */
+-(void)rebuildWithLastEventIdentifier:(uint64_t)lastEventIdentifier eventHistoryIdentifier:(NSString *)eventHistoryIdentifier
+{
+        PLProjectIndexBuilder * builder = [[[PLProjectIndexBuilder alloc] initWithRootPath:self.directoryPath] autorelease];
+        NSData * indexData = nil;
+
+        [builder addDirectoryTreeAtPath:@""];
+        indexData = [builder dataWithLastEventIdentifier:lastEventIdentifier eventHistoryIdentifier:eventHistoryIdentifier];
+        [self setSnapshot:[[[PLProjectIndexSnapshot alloc] initWithData:indexData rootPath:self.directoryPath] autorelease]];
+        [self scheduleSave];
+}
+
+/**
+ * \brief Queue an update of the directories reported by the watcher.
+ *
+ * \details The paths are made relative to the project directory. A rescan of
+ *          a directory above the project directory rebuilds the index.
+ *
+ * \param changedDirectories The paths of the changed directories.
+ *
+ * \param rescannedDirectories The paths of the directories whose descendants
+ *                             also changed.
+ */
+-(void)directoriesDidChange:(NSSet *)changedDirectories rescannedDirectories:(NSSet *)rescannedDirectories
+{
+        NSMutableSet * relativeChangedDirectories = [NSMutableSet setWithCapacity:[changedDirectories count]];
+        NSMutableSet * relativeRescannedDirectories = [NSMutableSet setWithCapacity:[rescannedDirectories count]];
+        uint64_t lastEventIdentifier = [watcher lastEventIdentifier];
+        NSString * eventHistoryIdentifier = [watcher eventHistoryIdentifier];
+
+        for (NSString * path in changedDirectories) {
+                if (PLPathIsWithinDirectory(path, self.directoryPath)) {
+                        [relativeChangedDirectories addObject:[self relativePathForPath:path]];
+                }
+        }
+        for (NSString * path in rescannedDirectories) {
+                if (PLPathIsWithinDirectory(path, self.directoryPath)) {
+                        [relativeRescannedDirectories addObject:[self relativePathForPath:path]];
+                } else if (PLPathIsWithinDirectory(self.directoryPath, path)) {
+                        [relativeRescannedDirectories addObject:@""];
+                }
+        }
+
+        dispatch_async(indexQueue, ^{
+                @autoreleasepool {
+                        [self updateChangedDirectories:relativeChangedDirectories
+                                  rescannedDirectories:relativeRescannedDirectories
+                                   lastEventIdentifier:lastEventIdentifier
+                                eventHistoryIdentifier:eventHistoryIdentifier];
+                }
+        });
+}
+
+/**
+ * \brief Make a path within the project directory relative to it.
+ */
+-(NSString *)relativePathForPath:(NSString *)path
+{
+        NSString * relativePath = [path substringFromIndex:[self.directoryPath length]];
+
+        while ([relativePath hasPrefix:@"/"]) {
+                relativePath = [relativePath substringFromIndex:1];
+        }
+        return relativePath;
+}
+
+/**
+ * \brief Build a new snapshot from the current one and the directories that
+ *        changed.
+ *
+ * \details This method runs on `indexQueue`. Each changed directory is read
+ *          again without descending into it: its files replace the files
+ *          previously indexed in it, subdirectories that disappeared are
+ *          dropped with everything below them, and new subdirectories are
+ *          walked. Rescanned directories are walked in full. Every other
+ *          directory and file is copied from the current snapshot without
+ *          touching the disk.
+ *
+ * \param changedDirectories The relative paths of the changed directories.
+ *
+ * \param rescannedDirectories The relative paths of the directories to walk.
+ *
+ * \param lastEventIdentifier The identifier of the last event reflected in the
+ *                            update.
+ *
+ * \param eventHistoryIdentifier The history `lastEventIdentifier` refers to.
+ */
+-(void)updateChangedDirectories:(NSSet *)changedDirectories
+           rescannedDirectories:(NSSet *)rescannedDirectories
+            lastEventIdentifier:(uint64_t)lastEventIdentifier
+         eventHistoryIdentifier:(NSString *)eventHistoryIdentifier
+{
+        PLProjectIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        PLProjectIndexBuilder * builder = nil;
+        NSMutableSet * walkedDirectories = [[rescannedDirectories mutableCopy] autorelease];
+        NSMutableSet * removedDirectories = [NSMutableSet set];
+        NSMutableSet * relistedDirectories = [NSMutableSet set];
+        NSMutableSet * currentSubdirectories = [NSMutableSet set];
+        NSMutableArray * subdirectories = [NSMutableArray array];
+        NSMutableArray * indexedDirectoryPaths = nil;
+        NSSet * indexedDirectories = nil;
+        NSString * indexedPath = nil;
+        uint32_t * directoryMap = NULL;
+        uint32_t i = 0;
+        const PLProjectIndexFile * file = NULL;
+
+        if (currentSnapshot == nil) {
+                [self rebuildWithLastEventIdentifier:lastEventIdentifier eventHistoryIdentifier:eventHistoryIdentifier];
+                goto exit;
+        }
+
+        builder = [[[PLProjectIndexBuilder alloc] initWithRootPath:self.directoryPath] autorelease];
+        indexedDirectoryPaths = [NSMutableArray arrayWithCapacity:currentSnapshot->header->directoryCount];
+        for (i = 0; i < currentSnapshot->header->directoryCount; i++) {
+                [indexedDirectoryPaths addObject:[currentSnapshot relativePathOfDirectoryAtIndex:i]];
+        }
+        indexedDirectories = [NSSet setWithArray:indexedDirectoryPaths];
+
+        /* Read the changed directories */
+        for (NSString * directoryPath in changedDirectories) {
+                if (PLProjectIndexRelativePathIsWithinAny(directoryPath, walkedDirectories)) {
+                        continue;
+                }
+                if ([indexedDirectories containsObject:directoryPath] == NO) {
+                        [walkedDirectories addObject:directoryPath];
+                        continue;
+                }
+                [subdirectories removeAllObjects];
+                if ([builder readDirectoryAtPath:directoryPath subdirectories:subdirectories] == NO) {
+                        [removedDirectories addObject:directoryPath];
+                        continue;
+                }
+                [relistedDirectories addObject:directoryPath];
+                for (NSString * subdirectory in subdirectories) {
+                        [currentSubdirectories addObject:subdirectory];
+                        if ([indexedDirectories containsObject:subdirectory] == NO) {
+                                [walkedDirectories addObject:subdirectory];
+                        }
+                }
+        }
+
+        /* Drop the subdirectories of read directories that no longer exist */
+        for (indexedPath in indexedDirectoryPaths) {
+                if ([indexedPath length] > 0 &&
+                    [relistedDirectories containsObject:[indexedPath stringByDeletingLastPathComponent]] &&
+                    [currentSubdirectories containsObject:indexedPath] == NO) {
+                        [removedDirectories addObject:indexedPath];
+                }
+        }
+
+        /* Copy everything else from the current snapshot */
+        directoryMap = malloc(sizeof(uint32_t) * MAX(currentSnapshot->header->directoryCount, 1));
+        for (i = 0; i < currentSnapshot->header->directoryCount; i++) {
+                indexedPath = [indexedDirectoryPaths objectAtIndex:i];
+                if (PLProjectIndexRelativePathIsWithinAny(indexedPath, removedDirectories) ||
+                    PLProjectIndexRelativePathIsWithinAny(indexedPath, walkedDirectories) ||
+                    [relistedDirectories containsObject:indexedPath]) {
+                        directoryMap[i] = UINT32_MAX;
+                } else {
+                        directoryMap[i] = [builder indexOfDirectoryAtPath:indexedPath];
+                }
+        }
+        for (i = 0; i < currentSnapshot->header->fileCount; i++) {
+                file = &currentSnapshot->files[i];
+                if (directoryMap[file->directoryIndex] == UINT32_MAX) {
+                        continue;
+                }
+                if ([builder addFileNamed:currentSnapshot->pool + file->nameOffset
+                                   length:file->nameLength
+                           directoryIndex:directoryMap[file->directoryIndex]
+                            characterMask:file->characterMask] == NO) {
+                        break;
+                }
+        }
+        free(directoryMap);
+
+        /* Walk new and rescanned directories */
+        for (NSString * directoryPath in walkedDirectories) {
+                [builder addDirectoryTreeAtPath:directoryPath];
+        }
+
+        [self setSnapshot:[[[PLProjectIndexSnapshot alloc] initWithData:[builder dataWithLastEventIdentifier:lastEventIdentifier
+                                                                                     eventHistoryIdentifier:eventHistoryIdentifier]
+                                                               rootPath:self.directoryPath] autorelease]];
+        [self scheduleSave];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Write the index to disk after a delay.
+ *
+ * \details This method runs on `indexQueue`. Updates made before the index is
+ *          written are coalesced into a single write. The file is replaced
+ *          atomically, so a snapshot mapping the previous file stays valid.
+ */
+-(void)scheduleSave
+{
+        NSString * indexFilePath = [[self class] indexFilePathForDirectoryAtPath:self.directoryPath];
+
+        if (saveScheduled) {
+                goto exit;
+        }
+        saveScheduled = YES;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(PLProjectIndexSaveDelay * NSEC_PER_SEC)), indexQueue, ^{
+                @autoreleasepool {
+                        saveScheduled = NO;
+                        [[NSFileManager defaultManager] createDirectoryAtPath:[indexFilePath stringByDeletingLastPathComponent]
+                                                  withIntermediateDirectories:YES
+                                                                   attributes:nil
+                                                                        error:NULL];
+                        [[self currentSnapshot]->data writeToFile:indexFilePath atomically:YES];
+                }
+        });
+
+exit:
+        return;
+}
+
+#pragma mark - Searching
+
+-(void)searchForQuery:(NSString *)query maximumCount:(NSUInteger)maximumCount completionHandler:(void (^)(NSArray * paths))completionHandler
+{
+        int64_t generation = __sync_add_and_fetch(&searchGeneration, 1);
+        NSString * searchQuery = [[query copy] autorelease];
+        void (^handler)(NSArray *) = [[completionHandler copy] autorelease];
+
+        dispatch_async(searchQueue, ^{
+                NSArray * paths = nil;
+
+                if (generation != searchGeneration) {
+                        return;
+                }
+                @autoreleasepool {
+                        paths = [[self pathsMatchingQuery:searchQuery maximumCount:maximumCount] retain];
+                }
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        if (generation == searchGeneration) {
+                                handler(paths);
+                        }
+                        [paths release];
+                });
+        });
+}
+
+/**
+ * \brief Search the index for files matching a query on the calling thread.
+ *
+ * \details Files are scored in chunks of `PLProjectIndexSearchChunkSize` in
+ *          parallel. Each chunk keeps its best `maximumCount` matches, which
+ *          are merged and sorted. Files whose character masks do not contain
+ *          every character of the query are rejected before they are scored.
+ *
+ * \param query The query.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \return An array of the full paths of the matching files, best match first.
+ */
+-(NSArray *)pathsMatchingQuery:(NSString *)query maximumCount:(NSUInteger)maximumCount
+{
+        PLProjectIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        NSMutableArray * paths = [NSMutableArray array];
+        const char * queryRepresentation = [query UTF8String];
+        NSMutableData * queryData = [NSMutableData dataWithCapacity:strlen(queryRepresentation)];
+        const uint8_t * lowercaseQuery = NULL;
+        PLProjectIndexMatch * matches = NULL;
+        size_t * matchCounts = NULL;
+        size_t queryLength = 0, fileCount = 0, chunkCount = 0, capacity = 0, mergedCount = 0, chunk = 0, i = 0;
+        uint64_t queryMask = 0;
+        uint8_t character = 0;
+
+        if (currentSnapshot == nil || maximumCount == 0) {
+                goto exit;
+        }
+
+        for (; *queryRepresentation; queryRepresentation++) {
+                character = PLProjectIndexLowercase((uint8_t)*queryRepresentation);
+                if (character != ' ') {
+                        [queryData appendBytes:&character length:1];
+                }
+        }
+        lowercaseQuery = [queryData bytes];
+        queryLength = [queryData length];
+        if (queryLength == 0) {
+                goto exit;
+        }
+        queryMask = PLProjectIndexCharacterMask((const char *)lowercaseQuery, queryLength);
+
+        capacity = MIN(maximumCount, PLProjectIndexMaximumResultCount);
+        fileCount = currentSnapshot->header->fileCount;
+        chunkCount = (fileCount + PLProjectIndexSearchChunkSize - 1) / PLProjectIndexSearchChunkSize;
+        if (chunkCount == 0) {
+                goto exit;
+        }
+        matches = malloc(sizeof(PLProjectIndexMatch) * capacity * chunkCount);
+        matchCounts = calloc(chunkCount, sizeof(size_t));
+
+        dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t chunkIndex) {
+                const PLProjectIndexDirectory * directories = currentSnapshot->directories;
+                const PLProjectIndexFile * files = currentSnapshot->files;
+                const char * pool = currentSnapshot->pool;
+                PLProjectIndexMatch * chunkMatches = matches + chunkIndex * capacity;
+                size_t begin = chunkIndex * PLProjectIndexSearchChunkSize;
+                size_t end = MIN(begin + PLProjectIndexSearchChunkSize, fileCount);
+                size_t count = 0, lowest = 0, fileIndex = 0;
+                const PLProjectIndexFile * file = NULL;
+                const PLProjectIndexDirectory * directory = NULL;
+                int32_t score = 0;
+
+                for (fileIndex = begin; fileIndex < end; fileIndex++) {
+                        file = &files[fileIndex];
+                        directory = &directories[file->directoryIndex];
+                        if (((file->characterMask | directory->characterMask) & queryMask) != queryMask) {
+                                continue;
+                        }
+                        score = PLProjectIndexScore(lowercaseQuery, queryLength,
+                                                    pool + directory->pathOffset, directory->pathLength,
+                                                    pool + file->nameOffset, file->nameLength);
+                        if (score < 0) {
+                                continue;
+                        }
+                        if (count < capacity) {
+                                chunkMatches[count].score = score;
+                                chunkMatches[count].fileIndex = (uint32_t)fileIndex;
+                                count++;
+                                if (count == capacity) {
+                                        lowest = PLProjectIndexLowestMatch(chunkMatches, count);
+                                }
+                        } else if (score > chunkMatches[lowest].score) {
+                                chunkMatches[lowest].score = score;
+                                chunkMatches[lowest].fileIndex = (uint32_t)fileIndex;
+                                lowest = PLProjectIndexLowestMatch(chunkMatches, count);
+                        }
+                }
+                matchCounts[chunkIndex] = count;
+        });
+
+        /* Merge the chunks in place */
+        for (chunk = 0; chunk < chunkCount; chunk++) {
+                memmove(matches + mergedCount, matches + chunk * capacity, sizeof(PLProjectIndexMatch) * matchCounts[chunk]);
+                mergedCount += matchCounts[chunk];
+        }
+        qsort(matches, mergedCount, sizeof(PLProjectIndexMatch), PLProjectIndexCompareMatches);
+        for (i = 0; i < mergedCount && i < capacity; i++) {
+                [paths addObject:[currentSnapshot pathOfFileAtIndex:matches[i].fileIndex rootPath:self.directoryPath]];
+        }
+
+exit:
+        free(matches);
+        free(matchCounts);
+        return paths;
+}
+
+@end
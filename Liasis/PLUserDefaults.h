@@ -0,0 +1,50 @@
+/**
+ * \file PLUserDefaults.h
+ *
+ * \brief Liasis Python IDE user defaults.
+ *
+ * \details This file includes the keys of the user defaults read by the
+ *          application, rather than by LiasisKit.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief The user default that, when YES, makes the application log the cost
+ *        of its performance sensitive work.
+ *
+ * \details One switch covers every subsystem, so a single default collects
+ *          the timings of a session, e.g.
+ *          `defaults write <bundle identifier> PLUserDefaultLogPerformance -bool YES`.
+ */
+extern NSString * const PLUserDefaultLogPerformance;
+
+/**
+ * \brief User default key of the file size, in bytes, from which files are
+ *        shown in a `PLLargeFileViewController` rather than opened as
+ *        documents.
+ *
+ * \details Defaults to `PLLargeFileDefaultThreshold` if not set.
+ */
+extern NSString * const PLUserDefaultLargeFileThreshold;
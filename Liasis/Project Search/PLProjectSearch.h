@@ -0,0 +1,281 @@
+/**
+ * \file PLProjectSearch.h
+ *
+ * \brief Liasis Python IDE project search.
+ *
+ * \details This file includes the engine that searches the text of every file
+ *          below a project directory.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief Options controlling how a project search matches text.
+ */
+typedef NS_OPTIONS(NSUInteger, PLProjectSearchOptions) {
+        /**
+         * \brief Ignore case when matching.
+         */
+        PLProjectSearchCaseInsensitive = 1 << 0,
+
+        /**
+         * \brief Treat the pattern as an `NSRegularExpression` pattern rather
+         *        than literal text.
+         */
+        PLProjectSearchRegularExpression = 1 << 1
+};
+
+/**
+ * \brief The block called on the main queue with each batch of matches.
+ *
+ * \param matches An array of `PLProjectSearchMatch` objects, or nil when
+ *                `finished` is YES.
+ *
+ * \param finished YES if the search has finished. No further batches follow.
+ */
+typedef void (^PLProjectSearchResultHandler)(NSArray * matches, BOOL finished);
+
+/**
+ * \class PLProjectSearchMatch \headerfile \headerfile
+ *
+ * \brief A line of a file matching a project search.
+ */
+@interface PLProjectSearchMatch : NSObject
+
+/**
+ * \brief The full path of the file.
+ */
+@property (retain) NSString * path;
+
+/**
+ * \brief The line number of the match, starting at 1.
+ */
+@property (assign) NSUInteger lineNumber;
+
+/**
+ * \brief The text of the line, without its line terminator.
+ */
+@property (retain) NSString * lineText;
+
+/**
+ * \brief The range of the first match within `lineText`.
+ */
+@property (assign) NSRange matchRange;
+
+@end
+
+/**
+ * \class PLProjectSearch \headerfile \headerfile
+ *
+ * \brief Searches the text of the files below a directory in parallel.
+ *
+ * \details A single walker enumerates the directory tree, skipping entries
+ *          whose names begin with a dot and the directories in
+ *          `ignoredDirectoryNames`, and hands batches of files to a pool of
+ *          workers on the global concurrent queue. The number of batches in
+ *          flight is bounded by the number of processors, so the walker never
+ *          runs far ahead of the workers.
+ *
+ *          Each worker memory maps its files and skips those that contain a
+ *          NUL byte near their start. Candidate lines are located with a
+ *          vectorized scan for a literal that every match must contain: the
+ *          whole pattern for a literal search, or the longest literal run of a
+ *          regular expression. Only the candidate lines are decoded and, when
+ *          needed, confirmed with the regular expression. Regular expressions
+ *          without a required literal are matched line by line.
+ *
+ *          Matches are delivered in batches on the main queue while the search
+ *          runs. Once cancelled, a search stops reading files and delivers
+ *          nothing more.
+ */
+@interface PLProjectSearch : NSObject
+{
+        /**
+         * \brief The regular expression confirming candidate lines, or nil if
+         *        the literal alone decides a match.
+         */
+        NSRegularExpression * regularExpression;
+
+        /**
+         * \brief The literal every match contains, lowercased for a case
+         *        insensitive search, or nil if there is none.
+         */
+        NSData * literal;
+
+        /**
+         * \brief The serial queue on which the directory tree is walked.
+         */
+        dispatch_queue_t walkQueue;
+
+        /**
+         * \brief The group of the worker batches.
+         */
+        dispatch_group_t workGroup;
+
+        /**
+         * \brief Bounds the number of worker batches in flight.
+         */
+        dispatch_semaphore_t workSlots;
+
+        /**
+         * \brief Nonzero once the search is cancelled.
+         */
+        volatile int32_t cancelled;
+
+        /**
+         * \brief Nonzero once the search should stop reading files, either
+         *        because it was cancelled or because enough matches were found.
+         */
+        volatile int32_t stopped;
+
+        /**
+         * \brief The number of bytes searched.
+         */
+        volatile int64_t bytesSearched;
+
+        /**
+         * \brief The number of files searched.
+         */
+        volatile int64_t filesSearched;
+
+        /**
+         * \brief The number of matches found.
+         */
+        volatile int64_t matchCount;
+
+        /**
+         * \brief The time the search started.
+         */
+        CFAbsoluteTime startTime;
+}
+
+/**
+ * \brief The directory searched.
+ */
+@property (retain, readonly) NSString * directoryPath;
+
+/**
+ * \brief The search pattern.
+ */
+@property (retain, readonly) NSString * pattern;
+
+/**
+ * \brief The search options.
+ */
+@property (readonly) PLProjectSearchOptions options;
+
+/**
+ * \brief The time in seconds the search took, or 0 if it has not finished.
+ */
+@property (readonly) NSTimeInterval duration;
+
+/**
+ * \brief YES if the search stopped at the maximum number of matches.
+ */
+@property (readonly, getter=isTruncated) BOOL truncated;
+
+/**
+ * \brief The names of the directories that are never searched.
+ *
+ * \return A set of directory names.
+ */
++(NSSet *)ignoredDirectoryNames;
+
+/**
+ * \brief Create a search.
+ *
+ * \param directoryPath The directory to search.
+ *
+ * \param pattern The text or regular expression to search for.
+ *
+ * \param options The search options.
+ *
+ * \param error On return, the reason the search could not be created if the
+ *              pattern is not a valid regular expression.
+ *
+ * \return A search on the autorelease pool, or nil if the pattern is invalid.
+ */
++(instancetype)searchWithDirectoryPath:(NSString *)directoryPath
+                               pattern:(NSString *)pattern
+                               options:(PLProjectSearchOptions)options
+                                 error:(NSError **)error;
+
+/**
+ * \brief Start searching in the background.
+ *
+ * \details The search retains itself until it finishes.
+ *
+ * \param resultHandler The block called on the main queue with each batch of
+ *                      matches and when the search finishes.
+ */
+-(void)startWithResultHandler:(PLProjectSearchResultHandler)resultHandler;
+
+/**
+ * \brief Stop the search.
+ *
+ * \details The result handler is not called again once this method returns.
+ *          This method must be called on the main thread.
+ */
+-(void)cancel;
+
+/**
+ * \brief Determine if the search was cancelled.
+ *
+ * \return YES if `cancel` was called.
+ */
+-(BOOL)isCancelled;
+
+/**
+ * \brief The number of files searched so far.
+ *
+ * \return The number of files.
+ */
+-(NSUInteger)numberOfFilesSearched;
+
+/**
+ * \brief The number of matches found so far.
+ *
+ * \return The number of matches.
+ */
+-(NSUInteger)numberOfMatches;
+
+/**
+ * \brief The number of bytes searched so far.
+ *
+ * \return The number of bytes.
+ */
+-(uint64_t)numberOfBytesSearched;
+
+/**
+ * \brief The search throughput.
+ *
+ * \details Used to measure the engine on real trees. The throughput of a
+ *          finished search is reported by the project search results tab.
+ *
+ * \return The number of bytes searched per second, or 0 if the search has not
+ *         finished.
+ */
+-(double)throughput;
+
+@end
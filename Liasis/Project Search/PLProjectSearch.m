@@ -0,0 +1,980 @@
+/**
+ * \file PLProjectSearch.m
+ *
+ * \brief Liasis Python IDE project search.
+ *
+ * \details This file includes the engine that searches the text of every file
+ *          below a project directory.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLProjectSearch.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * \brief The number of files handed to a worker at a time.
+ */
+static const NSUInteger PLProjectSearchBatchSize = 32;
+
+/**
+ * \brief The maximum number of matches a search reports.
+ */
+static const int64_t PLProjectSearchMaximumMatchCount = 10000;
+
+/**
+ * \brief Files larger than this many bytes are not searched.
+ */
+static const off_t PLProjectSearchMaximumFileSize = 256 * 1024 * 1024;
+
+/**
+ * \brief The number of leading bytes checked for a NUL byte to detect binary
+ *        files.
+ */
+static const size_t PLProjectSearchBinaryCheckLength = 8192;
+
+/**
+ * \brief The maximum number of bytes of a line kept for display.
+ */
+static const size_t PLProjectSearchMaximumLineLength = 1024;
+
+/**
+ * \brief The maximum length of a literal extracted from a pattern.
+ */
+#define PLProjectSearchMaximumLiteralLength 256
+
+#pragma mark - Literal Scanning
+
+/**
+ * \brief Compare bytes to a literal, folding ASCII uppercase letters in the
+ *        bytes if `foldCase` is YES. The literal is already lowercase.
+ */
+static inline BOOL PLProjectSearchEqualBytes(const uint8_t * bytes, const uint8_t * literal, size_t length, BOOL foldCase)
+{
+        size_t i = 0;
+        uint8_t byte = 0;
+
+        if (foldCase == NO) {
+                return memcmp(bytes, literal, length) == 0;
+        }
+        for (i = 0; i < length; i++) {
+                byte = bytes[i];
+                if (byte >= 'A' && byte <= 'Z') {
+                        byte += 'a' - 'A';
+                }
+                if (byte != literal[i]) {
+                        return NO;
+                }
+        }
+        return YES;
+}
+
+/**
+ * \brief The bits to set in a byte so that it compares equal to an ASCII
+ *        letter of either case.
+ */
+static inline uint8_t PLProjectSearchFoldMask(uint8_t byte, BOOL foldCase)
+{
+        return (foldCase && byte >= 'a' && byte <= 'z') ? 0x20 : 0x00;
+}
+
+/**
+ * \brief Find the first occurrence of a literal.
+ *
+ * \details Sixteen positions are tested at a time by comparing the first and
+ *          last bytes of the literal against two overlapping vector loads. A
+ *          letter compares equal in either case by setting bit 5 of the loaded
+ *          bytes. Only positions where both bytes match are compared in full.
+ *          The tail is scanned one byte at a time.
+ *
+ * \param bytes The bytes to search.
+ *
+ * \param length The number of bytes.
+ *
+ * \param literal The literal, lowercase if `foldCase` is YES.
+ *
+ * \param literalLength The length of the literal, at least 1.
+ *
+ * \param foldCase YES to ignore the case of ASCII letters.
+ *
+ * \return A pointer to the first occurrence or NULL.
+ */
+static const uint8_t * PLProjectSearchFindLiteral(const uint8_t * bytes, size_t length,
+                                                  const uint8_t * literal, size_t literalLength,
+                                                  BOOL foldCase)
+{
+        const uint8_t first = literal[0], last = literal[literalLength - 1];
+        const uint8_t firstFold = PLProjectSearchFoldMask(first, foldCase), lastFold = PLProjectSearchFoldMask(last, foldCase);
+        size_t i = 0;
+
+        if (length < literalLength) {
+                return NULL;
+        }
+
+#if defined(__SSE2__)
+        {
+                const __m128i firstVector = _mm_set1_epi8((char)first), lastVector = _mm_set1_epi8((char)last);
+                const __m128i firstFoldVector = _mm_set1_epi8((char)firstFold), lastFoldVector = _mm_set1_epi8((char)lastFold);
+                __m128i firstBlock, lastBlock;
+                unsigned int mask = 0, bit = 0;
+
+                for (; i + literalLength - 1 + 16 <= length; i += 16) {
+                        firstBlock = _mm_or_si128(_mm_loadu_si128((const __m128i *)(bytes + i)), firstFoldVector);
+                        lastBlock = _mm_or_si128(_mm_loadu_si128((const __m128i *)(bytes + i + literalLength - 1)), lastFoldVector);
+                        mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstBlock, firstVector),
+                                                                             _mm_cmpeq_epi8(lastBlock, lastVector)));
+                        while (mask) {
+                                bit = (unsigned int)__builtin_ctz(mask);
+                                if (PLProjectSearchEqualBytes(bytes + i + bit, literal, literalLength, foldCase)) {
+                                        return bytes + i + bit;
+                                }
+                                mask &= mask - 1;
+                        }
+                }
+        }
+#elif defined(__ARM_NEON)
+        {
+                const uint8x16_t firstVector = vdupq_n_u8(first), lastVector = vdupq_n_u8(last);
+                const uint8x16_t firstFoldVector = vdupq_n_u8(firstFold), lastFoldVector = vdupq_n_u8(lastFold);
+                uint8x16_t matches;
+                uint8_t lanes[16];
+                unsigned int lane = 0;
+
+                for (; i + literalLength - 1 + 16 <= length; i += 16) {
+                        matches = vandq_u8(vceqq_u8(vorrq_u8(vld1q_u8(bytes + i), firstFoldVector), firstVector),
+                                           vceqq_u8(vorrq_u8(vld1q_u8(bytes + i + literalLength - 1), lastFoldVector), lastVector));
+                        if (vmaxvq_u8(matches) == 0) {
+                                continue;
+                        }
+                        vst1q_u8(lanes, matches);
+                        for (lane = 0; lane < 16; lane++) {
+                                if (lanes[lane] && PLProjectSearchEqualBytes(bytes + i + lane, literal, literalLength, foldCase)) {
+                                        return bytes + i + lane;
+                                }
+                        }
+                }
+        }
+#endif
+
+        for (; i + literalLength <= length; i++) {
+                if ((bytes[i] | firstFold) == first &&
+                    (bytes[i + literalLength - 1] | lastFold) == last &&
+                    PLProjectSearchEqualBytes(bytes + i, literal, literalLength, foldCase)) {
+                        return bytes + i;
+                }
+        }
+        return NULL;
+}
+
+/**
+ * \brief Skip characters of a pattern up to and including a terminator.
+ *
+ * \return The index after the terminator, or of the end of the pattern.
+ */
+static size_t PLProjectSearchSkipPast(const char * pattern, size_t i, const char * terminator)
+{
+        const char * end = strstr(pattern + i, terminator);
+
+        return end ? (size_t)(end - pattern) + strlen(terminator) : strlen(pattern);
+}
+
+/**
+ * \brief Skip up to a number of characters of a pattern from a set.
+ *
+ * \return The index after the last character skipped.
+ */
+static size_t PLProjectSearchSkipCharacters(const char * pattern, size_t i, const char * characters, size_t maximumCount)
+{
+        size_t count = 0;
+
+        while (count < maximumCount && pattern[i] != '\0' && strchr(characters, pattern[i])) {
+                i++;
+                count++;
+        }
+        return i;
+}
+
+/**
+ * \brief Find the end of an ICU escape sequence that is not a literal
+ *        character.
+ *
+ * \details The escape is a backslash followed by a letter or digit. Its
+ *          operand is skipped with it: the hexadecimal digits of `\x`, `\u`
+ *          and `\U`, the octal digits of `\0`, the control character of
+ *          `\c`, the braces of `\N`, `\p` and `\P`, the name of `\k`, the
+ *          digits of a back reference, and the quoted text of `\Q`.
+ *
+ * \param pattern The UTF-8 pattern.
+ *
+ * \param i The index of the backslash.
+ *
+ * \return The index after the escape sequence.
+ */
+static size_t PLProjectSearchSkipEscape(const char * pattern, size_t i)
+{
+        static const char * const hexadecimalDigits = "0123456789abcdefABCDEF";
+        char escape = pattern[i + 1];
+
+        i += 2;
+        switch (escape) {
+                case 'x':
+                        if (pattern[i] == '{') {
+                                i = PLProjectSearchSkipPast(pattern, i, "}");
+                        } else {
+                                i = PLProjectSearchSkipCharacters(pattern, i, hexadecimalDigits, 2);
+                        }
+                        break;
+                case 'u':
+                        i = PLProjectSearchSkipCharacters(pattern, i, hexadecimalDigits, 4);
+                        break;
+                case 'U':
+                        i = PLProjectSearchSkipCharacters(pattern, i, hexadecimalDigits, 8);
+                        break;
+                case '0':
+                        i = PLProjectSearchSkipCharacters(pattern, i, "01234567", 3);
+                        break;
+                case 'c':
+                        if (pattern[i] != '\0') {
+                                i++;
+                        }
+                        break;
+                case 'N':
+                case 'p':
+                case 'P':
+                        if (pattern[i] == '{') {
+                                i = PLProjectSearchSkipPast(pattern, i, "}");
+                        } else if (pattern[i] != '\0') {
+                                i++;
+                        }
+                        break;
+                case 'k':
+                        if (pattern[i] == '<') {
+                                i = PLProjectSearchSkipPast(pattern, i, ">");
+                        }
+                        break;
+                case 'Q':
+                        i = PLProjectSearchSkipPast(pattern, i, "\\E");
+                        break;
+                default:
+                        if (escape >= '1' && escape <= '9') {
+                                i = PLProjectSearchSkipCharacters(pattern, i, "0123456789", SIZE_MAX);
+                        }
+                        break;
+        }
+        return i;
+}
+
+/**
+ * \brief Extract the longest literal every match of a regular expression must
+ *        contain.
+ *
+ * \details Only runs of plain characters outside groups are considered, and a
+ *          character followed by a quantifier allowing zero repetitions ends
+ *          the run before it, including every byte of a non-ASCII
+ *          character. An escape of a letter or digit, such as a character
+ *          class or a code point, ends the run together with its operand. Patterns with alternation or inline options have no
+ *          required literal.
+ *
+ * \param pattern The UTF-8 pattern.
+ *
+ * \param asciiOnly YES to end runs at non-ASCII bytes.
+ *
+ * \param literal The buffer the literal is copied to, of
+ *                `PLProjectSearchMaximumLiteralLength` bytes.
+ *
+ * \return The length of the literal, or 0 if there is none.
+ */
+static size_t PLProjectSearchRequiredLiteral(const char * pattern, BOOL asciiOnly, uint8_t * literal)
+{
+        uint8_t run[PLProjectSearchMaximumLiteralLength];
+        size_t runLength = 0, literalLength = 0, i = 0;
+        int depth = 0;
+        uint8_t character = 0;
+        BOOL isLiteral = NO;
+
+        if (strchr(pattern, '|') || strstr(pattern, "(?")) {
+                return 0;
+        }
+
+        while (pattern[i] != '\0') {
+                character = (uint8_t)pattern[i];
+                isLiteral = NO;
+                switch (character) {
+                        case '\\':
+                                if (pattern[i + 1] == '\0') {
+                                        i++;
+                                } else if (isalnum((unsigned char)pattern[i + 1])) {
+                                        i = PLProjectSearchSkipEscape(pattern, i);
+                                } else {
+                                        character = (uint8_t)pattern[i + 1];
+                                        isLiteral = YES;
+                                        i += 2;
+                                }
+                                break;
+                        case '[':
+                                i++;
+                                if (pattern[i] == '^') {
+                                        i++;
+                                }
+                                if (pattern[i] == ']') {
+                                        i++;
+                                }
+                                while (pattern[i] != '\0' && pattern[i] != ']') {
+                                        i += (pattern[i] == '\\' && pattern[i + 1] != '\0') ? 2 : 1;
+                                }
+                                if (pattern[i] == ']') {
+                                        i++;
+                                }
+                                break;
+                        case '(':
+                                depth++;
+                                i++;
+                                break;
+                        case ')':
+                                depth--;
+                                i++;
+                                break;
+                        case '*':
+                        case '?':
+                        case '{':
+                                /* The previous character may not occur, so every byte of
+                                   its UTF-8 sequence is removed from the run */
+                                while (runLength > 0 && (run[runLength - 1] & 0xC0) == 0x80) {
+                                        runLength--;
+                                }
+                                if (runLength > 0) {
+                                        runLength--;
+                                }
+                                if (character == '{') {
+                                        while (pattern[i] != '\0' && pattern[i] != '}') {
+                                                i++;
+                                        }
+                                }
+                                if (pattern[i] != '\0') {
+                                        i++;
+                                }
+                                break;
+                        case '+':
+                        case '.':
+                        case '^':
+                        case '$':
+                                i++;
+                                break;
+                        default:
+                                isLiteral = YES;
+                                i++;
+                                break;
+                }
+
+                /* Anything other than a literal ends the run, including a '+',
+                   which keeps the character before it */
+                if (isLiteral && depth == 0 && (asciiOnly == NO || character < 0x80) && runLength < sizeof(run)) {
+                        run[runLength++] = character;
+                        continue;
+                }
+                if (runLength > literalLength) {
+                        memcpy(literal, run, runLength);
+                        literalLength = runLength;
+                }
+                runLength = 0;
+        }
+        if (runLength > literalLength) {
+                memcpy(literal, run, runLength);
+                literalLength = runLength;
+        }
+        return literalLength;
+}
+
+/**
+ * \brief Find the longest run of ASCII bytes in a string.
+ */
+static size_t PLProjectSearchLongestASCIIRun(const char * string, uint8_t * literal)
+{
+        size_t runStart = 0, literalLength = 0, i = 0;
+
+        for (i = 0; ; i++) {
+                if (string[i] == '\0' || (uint8_t)string[i] >= 0x80) {
+                        if (i - runStart > literalLength) {
+                                literalLength = MIN(i - runStart, (size_t)PLProjectSearchMaximumLiteralLength);
+                                memcpy(literal, string + runStart, literalLength);
+                        }
+                        runStart = i + 1;
+                        if (string[i] == '\0') {
+                                break;
+                        }
+                }
+        }
+        return literalLength;
+}
+
+/**
+ * \brief Decode bytes as UTF-8, falling back to Latin-1.
+ */
+static NSString * PLProjectSearchString(const uint8_t * bytes, size_t length)
+{
+        NSString * string = [[[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding] autorelease];
+
+        if (string == nil) {
+                string = [[[NSString alloc] initWithBytes:bytes length:length encoding:NSISOLatin1StringEncoding] autorelease];
+        }
+        return string;
+}
+
+#pragma mark -
+
+@implementation PLProjectSearchMatch
+
+-(void)dealloc
+{
+        [_path release];
+        [_lineText release];
+        [super dealloc];
+}
+
+@end
+
+#pragma mark -
+
+@interface PLProjectSearch ()
+
+@property (readwrite) NSTimeInterval duration;
+
+@property (readwrite, getter=isTruncated) BOOL truncated;
+
+@end
+
+@implementation PLProjectSearch
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Initialize a search.
+ *
+ * \details Determine the literal used to find candidate lines and whether
+ *          candidate lines must be confirmed with a regular expression.
+ *
+ * \see searchWithDirectoryPath:pattern:options:error:
+ */
+-(instancetype)initWithDirectoryPath:(NSString *)directoryPath
+                             pattern:(NSString *)pattern
+                             options:(PLProjectSearchOptions)options
+                               error:(NSError **)error
+{
+        BOOL foldCase = (options & PLProjectSearchCaseInsensitive) != 0;
+        BOOL isASCII = [pattern canBeConvertedToEncoding:NSASCIIStringEncoding];
+        NSRegularExpressionOptions expressionOptions = foldCase ? NSRegularExpressionCaseInsensitive : 0;
+        uint8_t literalBytes[PLProjectSearchMaximumLiteralLength];
+        size_t literalLength = 0, i = 0;
+
+        self = [super init];
+        if (self == nil) {
+                goto exit;
+        }
+        _directoryPath = [directoryPath copy];
+        _pattern = [pattern copy];
+        _options = options;
+
+        if (options & PLProjectSearchRegularExpression) {
+                regularExpression = [[NSRegularExpression alloc] initWithPattern:pattern options:expressionOptions error:error];
+                if (regularExpression == nil) {
+                        [self release];
+                        self = nil;
+                        goto exit;
+                }
+                literalLength = PLProjectSearchRequiredLiteral([pattern UTF8String], foldCase, literalBytes);
+        } else if (foldCase && isASCII == NO) {
+                regularExpression = [[NSRegularExpression alloc] initWithPattern:[NSRegularExpression escapedPatternForString:pattern]
+                                                                         options:expressionOptions
+                                                                           error:error];
+                literalLength = PLProjectSearchLongestASCIIRun([pattern UTF8String], literalBytes);
+        } else {
+                literalLength = MIN(strlen([pattern UTF8String]), (size_t)PLProjectSearchMaximumLiteralLength);
+                memcpy(literalBytes, [pattern UTF8String], literalLength);
+                if (literalLength < strlen([pattern UTF8String])) {
+                        regularExpression = [[NSRegularExpression alloc] initWithPattern:[NSRegularExpression escapedPatternForString:pattern]
+                                                                                 options:expressionOptions
+                                                                                   error:error];
+                }
+        }
+
+        if (literalLength > 0) {
+                if (foldCase) {
+                        for (i = 0; i < literalLength; i++) {
+                                if (literalBytes[i] >= 'A' && literalBytes[i] <= 'Z') {
+                                        literalBytes[i] += 'a' - 'A';
+                                }
+                        }
+                }
+                literal = [[NSData alloc] initWithBytes:literalBytes length:literalLength];
+        }
+
+        walkQueue = dispatch_queue_create("org.liasis.projectsearch.walk", DISPATCH_QUEUE_SERIAL);
+        workGroup = dispatch_group_create();
+        workSlots = dispatch_semaphore_create((long)[[NSProcessInfo processInfo] activeProcessorCount] * 2);
+
+exit:
+        return self;
+}
+
++(instancetype)searchWithDirectoryPath:(NSString *)directoryPath
+                               pattern:(NSString *)pattern
+                               options:(PLProjectSearchOptions)options
+                                 error:(NSError **)error
+{
+        return [[[self alloc] initWithDirectoryPath:directoryPath pattern:pattern options:options error:error] autorelease];
+}
+
+-(void)dealloc
+{
+        [_directoryPath release];
+        [_pattern release];
+        [regularExpression release];
+        [literal release];
+        if (walkQueue) {
+                dispatch_release(walkQueue);
+                dispatch_release(workGroup);
+                dispatch_release(workSlots);
+        }
+        [super dealloc];
+}
+
++(NSSet *)ignoredDirectoryNames
+{
+        static NSSet * ignoredDirectoryNames = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                ignoredDirectoryNames = [[NSSet alloc] initWithObjects:@"__pycache__", @"node_modules", @"DerivedData", @"venv", nil];
+        });
+        return ignoredDirectoryNames;
+}
+
+#pragma mark - Searching
+
+-(void)startWithResultHandler:(PLProjectSearchResultHandler)resultHandler
+{
+        PLProjectSearchResultHandler handler = [[resultHandler copy] autorelease];
+
+        startTime = CFAbsoluteTimeGetCurrent();
+        dispatch_async(walkQueue, ^{
+                [self walkWithResultHandler:handler];
+        });
+}
+
+-(void)cancel
+{
+        cancelled = 1;
+        stopped = 1;
+}
+
+-(BOOL)isCancelled
+{
+        return cancelled != 0;
+}
+
+-(NSUInteger)numberOfFilesSearched
+{
+        return (NSUInteger)filesSearched;
+}
+
+-(NSUInteger)numberOfMatches
+{
+        return (NSUInteger)MIN(matchCount, PLProjectSearchMaximumMatchCount);
+}
+
+-(uint64_t)numberOfBytesSearched
+{
+        return (uint64_t)bytesSearched;
+}
+
+-(double)throughput
+{
+        return self.duration > 0.0 ? (double)bytesSearched / self.duration : 0.0;
+}
+
+/**
+ * \brief Walk the directory tree and hand batches of files to the workers.
+ *
+ * \details This method runs on `walkQueue`. Once every batch has been
+ *          searched, the result handler is called on the main queue with
+ *          `finished` set to YES.
+ *
+ * \param resultHandler The result handler.
+ */
+-(void)walkWithResultHandler:(PLProjectSearchResultHandler)resultHandler
+{
+        NSMutableArray * pendingDirectories = [[NSMutableArray alloc] initWithObjects:self.directoryPath, nil];
+        NSMutableArray * batch = [[NSMutableArray alloc] initWithCapacity:PLProjectSearchBatchSize];
+        NSString * directoryPath = nil;
+
+        while ([pendingDirectories count] > 0 && stopped == 0) {
+                @autoreleasepool {
+                        directoryPath = [[pendingDirectories lastObject] retain];
+                        [pendingDirectories removeLastObject];
+                        [self readDirectoryAtPath:directoryPath subdirectories:pendingDirectories files:batch];
+                        [directoryPath release];
+                        if ([batch count] >= PLProjectSearchBatchSize) {
+                                [self searchBatch:batch resultHandler:resultHandler];
+                        }
+                }
+        }
+        if ([batch count] > 0 && stopped == 0) {
+                [self searchBatch:batch resultHandler:resultHandler];
+        }
+        [pendingDirectories release];
+        [batch release];
+
+        dispatch_group_notify(workGroup, dispatch_get_main_queue(), ^{
+                self.duration = CFAbsoluteTimeGetCurrent() - startTime;
+                if (cancelled == 0) {
+                        resultHandler(nil, YES);
+                }
+        });
+}
+
+/**
+ * \brief Collect the searchable files and subdirectories of a directory.
+ *
+ * \param directoryPath The path of the directory.
+ *
+ * \param subdirectories The array the paths of the subdirectories are added
+ *                       to.
+ *
+ * \param files The array the paths of the regular files are added to.
+ */
+-(void)readDirectoryAtPath:(NSString *)directoryPath subdirectories:(NSMutableArray *)subdirectories files:(NSMutableArray *)files
+{
+        const char * directoryRepresentation = [directoryPath fileSystemRepresentation];
+        NSSet * ignoredDirectoryNames = [[self class] ignoredDirectoryNames];
+        char entryPath[PATH_MAX];
+        DIR * directory = NULL;
+        struct dirent * entry = NULL;
+        struct stat entryInfo;
+        NSString * name = nil;
+        BOOL isDirectory = NO, isFile = NO;
+
+        directory = opendir(directoryRepresentation);
+        if (directory == NULL) {
+                goto exit;
+        }
+        while ((entry = readdir(directory)) != NULL) {
+                if (entry->d_name[0] == '.') {
+                        continue;
+                }
+                isDirectory = (entry->d_type == DT_DIR);
+                isFile = (entry->d_type == DT_REG);
+                if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+                        if (snprintf(entryPath, sizeof(entryPath), "%s/%s", directoryRepresentation, entry->d_name) >= (int)sizeof(entryPath) ||
+                            (entry->d_type == DT_LNK ? stat(entryPath, &entryInfo) : lstat(entryPath, &entryInfo)) != 0) {
+                                continue;
+                        }
+                        isFile = S_ISREG(entryInfo.st_mode);
+                        isDirectory = (entry->d_type == DT_UNKNOWN && S_ISDIR(entryInfo.st_mode));
+                }
+                if (isDirectory == NO && isFile == NO) {
+                        continue;
+                }
+                name = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:entry->d_name length:strlen(entry->d_name)];
+                if (isDirectory) {
+                        if ([ignoredDirectoryNames containsObject:name] == NO && [name hasSuffix:@".egg-info"] == NO) {
+                                [subdirectories addObject:[directoryPath stringByAppendingPathComponent:name]];
+                        }
+                } else {
+                        [files addObject:[directoryPath stringByAppendingPathComponent:name]];
+                }
+        }
+
+exit:
+        if (directory) {
+                closedir(directory);
+        }
+        return;
+}
+
+/**
+ * \brief Search a batch of files on the worker pool.
+ *
+ * \details Blocks while all worker slots are in use. The batch is emptied.
+ *
+ * \param batch The paths of the files.
+ *
+ * \param resultHandler The result handler.
+ */
+-(void)searchBatch:(NSMutableArray *)batch resultHandler:(PLProjectSearchResultHandler)resultHandler
+{
+        NSArray * paths = [[batch copy] autorelease];
+
+        [batch removeAllObjects];
+        dispatch_semaphore_wait(workSlots, DISPATCH_TIME_FOREVER);
+        dispatch_group_async(workGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                NSMutableArray * matches = [[NSMutableArray alloc] init];
+
+                @autoreleasepool {
+                        for (NSString * path in paths) {
+                                if (stopped) {
+                                        break;
+                                }
+                                @autoreleasepool {
+                                        [self searchFileAtPath:path matches:matches];
+                                }
+                        }
+                }
+                if ([matches count] > 0) {
+                        dispatch_async(dispatch_get_main_queue(), ^{
+                                if (cancelled == 0) {
+                                        resultHandler(matches, NO);
+                                }
+                        });
+                }
+                [matches release];
+                dispatch_semaphore_signal(workSlots);
+        });
+}
+
+/**
+ * \brief Search a file.
+ *
+ * \details The file is memory mapped. Files that are empty, too large, or
+ *          contain a NUL byte in their first
+ *          `PLProjectSearchBinaryCheckLength` bytes are skipped.
+ *
+ * \param path The path of the file.
+ *
+ * \param matches The array matches are added to.
+ */
+-(void)searchFileAtPath:(NSString *)path matches:(NSMutableArray *)matches
+{
+        int descriptor = -1;
+        struct stat fileInfo;
+        const uint8_t * bytes = MAP_FAILED;
+        size_t length = 0;
+
+        descriptor = open([path fileSystemRepresentation], O_RDONLY | O_CLOEXEC);
+        if (descriptor < 0 || fstat(descriptor, &fileInfo) != 0 || S_ISREG(fileInfo.st_mode) == 0 ||
+            fileInfo.st_size == 0 || fileInfo.st_size > PLProjectSearchMaximumFileSize) {
+                goto exit;
+        }
+        length = (size_t)fileInfo.st_size;
+        bytes = mmap(NULL, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (bytes == MAP_FAILED) {
+                goto exit;
+        }
+        madvise((void *)bytes, length, MADV_SEQUENTIAL);
+        if (memchr(bytes, '\0', MIN(length, PLProjectSearchBinaryCheckLength))) {
+                goto exit;
+        }
+
+        __sync_add_and_fetch(&filesSearched, 1);
+        __sync_add_and_fetch(&bytesSearched, (int64_t)length);
+        if (literal) {
+                [self searchLiteralInBytes:bytes length:length path:path matches:matches];
+        } else {
+                [self searchLinesInBytes:bytes length:length path:path matches:matches];
+        }
+
+exit:
+        if (bytes != MAP_FAILED) {
+                munmap((void *)bytes, length);
+        }
+        if (descriptor >= 0) {
+                close(descriptor);
+        }
+        return;
+}
+
+/**
+ * \brief Search a file for lines containing the literal.
+ *
+ * \details Each candidate line is reported at most once. Line numbers are
+ *          counted only up to each candidate.
+ */
+-(void)searchLiteralInBytes:(const uint8_t *)bytes length:(size_t)length path:(NSString *)path matches:(NSMutableArray *)matches
+{
+        const uint8_t * end = bytes + length, * position = bytes, * counted = bytes;
+        const uint8_t * candidate = NULL, * lineStart = NULL, * lineEnd = NULL, * newline = NULL;
+        BOOL foldCase = (self.options & PLProjectSearchCaseInsensitive) != 0;
+        NSUInteger lineNumber = 1;
+
+        while (stopped == 0 && position < end) {
+                candidate = PLProjectSearchFindLiteral(position, (size_t)(end - position), [literal bytes], [literal length], foldCase);
+                if (candidate == NULL) {
+                        break;
+                }
+                lineStart = candidate;
+                while (lineStart > position && lineStart[-1] != '\n') {
+                        lineStart--;
+                }
+                lineEnd = memchr(candidate, '\n', (size_t)(end - candidate));
+                if (lineEnd == NULL) {
+                        lineEnd = end;
+                }
+                while ((newline = memchr(counted, '\n', (size_t)(lineStart - counted))) != NULL) {
+                        lineNumber++;
+                        counted = newline + 1;
+                }
+                counted = lineStart;
+
+                [self addMatchInLine:lineStart
+                              length:(size_t)(lineEnd - lineStart)
+                          lineNumber:lineNumber
+                       literalOffset:(size_t)(candidate - lineStart)
+                                path:path
+                             matches:matches];
+                position = lineEnd + 1;
+        }
+}
+
+/**
+ * \brief Search a file line by line with the regular expression.
+ *
+ * \details Used for regular expressions without a required literal.
+ */
+-(void)searchLinesInBytes:(const uint8_t *)bytes length:(size_t)length path:(NSString *)path matches:(NSMutableArray *)matches
+{
+        NSString * contents = PLProjectSearchString(bytes, length);
+        __block NSUInteger lineNumber = 0;
+
+        [contents enumerateSubstringsInRange:NSMakeRange(0, [contents length])
+                                     options:NSStringEnumerationByLines
+                                  usingBlock:^(NSString * line, NSRange lineRange, NSRange enclosingRange, BOOL * stop) {
+                                          NSTextCheckingResult * result = nil;
+
+                                          lineNumber++;
+                                          if (stopped) {
+                                                  *stop = YES;
+                                                  return;
+                                          }
+                                          result = [regularExpression firstMatchInString:line options:0 range:NSMakeRange(0, [line length])];
+                                          if (result) {
+                                                  [self addMatchWithPath:path
+                                                              lineNumber:lineNumber
+                                                                lineText:line
+                                                              matchRange:[result range]
+                                                                 matches:matches];
+                                          }
+                                  }];
+}
+
+/**
+ * \brief Decode a candidate line and confirm it if needed.
+ *
+ * \details Lines longer than `PLProjectSearchMaximumLineLength` are cut to a
+ *          window around the literal.
+ *
+ * \param line The first byte of the line.
+ *
+ * \param length The length of the line without its newline.
+ *
+ * \param lineNumber The line number.
+ *
+ * \param literalOffset The offset of the literal within the line.
+ *
+ * \param path The path of the file.
+ *
+ * \param matches The array the match is added to.
+ */
+-(void)addMatchInLine:(const uint8_t *)line
+               length:(size_t)length
+           lineNumber:(NSUInteger)lineNumber
+        literalOffset:(size_t)literalOffset
+                 path:(NSString *)path
+              matches:(NSMutableArray *)matches
+{
+        size_t windowStart = 0;
+        NSString * lineText = nil;
+        NSTextCheckingResult * result = nil;
+        NSRange matchRange;
+
+        if (length > 0 && line[length - 1] == '\r') {
+                length--;
+        }
+        if (length > PLProjectSearchMaximumLineLength) {
+                windowStart = literalOffset > 64 ? literalOffset - 64 : 0;
+                while (windowStart > 0 && (line[windowStart] & 0xC0) == 0x80) {
+                        windowStart--;
+                }
+                length = MIN(length - windowStart, PLProjectSearchMaximumLineLength);
+                while (length > 0 && (line[windowStart + length] & 0xC0) == 0x80) {
+                        length--;
+                }
+        }
+        lineText = PLProjectSearchString(line + windowStart, length);
+
+        if (regularExpression) {
+                result = [regularExpression firstMatchInString:lineText options:0 range:NSMakeRange(0, [lineText length])];
+                if (result == nil) {
+                        goto exit;
+                }
+                matchRange = [result range];
+        } else {
+                matchRange.location = [PLProjectSearchString(line + windowStart, literalOffset - windowStart) length];
+                matchRange.length = [self.pattern length];
+                if (NSMaxRange(matchRange) > [lineText length]) {
+                        matchRange.length = [lineText length] - matchRange.location;
+                }
+        }
+        [self addMatchWithPath:path lineNumber:lineNumber lineText:lineText matchRange:matchRange matches:matches];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Add a match, stopping the search at the maximum number of matches.
+ */
+-(void)addMatchWithPath:(NSString *)path
+             lineNumber:(NSUInteger)lineNumber
+               lineText:(NSString *)lineText
+             matchRange:(NSRange)matchRange
+                matches:(NSMutableArray *)matches
+{
+        PLProjectSearchMatch * match = nil;
+
+        if (__sync_add_and_fetch(&matchCount, 1) > PLProjectSearchMaximumMatchCount) {
+                self.truncated = YES;
+                stopped = 1;
+                goto exit;
+        }
+        match = [[PLProjectSearchMatch alloc] init];
+        match.path = path;
+        match.lineNumber = lineNumber;
+        match.lineText = lineText;
+        match.matchRange = matchRange;
+        [matches addObject:match];
+        [match release];
+
+exit:
+        return;
+}
+
+@end
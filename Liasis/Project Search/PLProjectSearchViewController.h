@@ -0,0 +1,125 @@
+/**
+ * \file PLProjectSearchViewController.h
+ *
+ * \brief Liasis Python IDE project search results tab.
+ *
+ * \details This file includes the view controller of the tab that searches a
+ *          project and lists the matching lines.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+#import <LiasisKit/LiasisKit.h>
+#import "PLProjectSearch.h"
+
+/**
+ * \class PLProjectSearchViewController \headerfile \headerfile
+ *
+ * \brief The view controller of the tab that searches the text of a project.
+ *
+ * \details The view contains a search field, options for regular expressions
+ *          and case, and a list of the matching lines. A new `PLProjectSearch`
+ *          is started whenever the query or the options change, cancelling the
+ *          previous one, and matches are appended to the list as they arrive.
+ *          Once a search finishes, the number of bytes searched per second is
+ *          shown below the list. Double clicking a match opens its file.
+ *
+ *          The tab is owned by the application rather than an add on, so it
+ *          has no document.
+ */
+@interface PLProjectSearchViewController : NSViewController <PLTabSubviewController, NSTableViewDataSource, NSTableViewDelegate>
+{
+        /**
+         * \brief The field the query is typed in.
+         */
+        NSSearchField * searchField;
+
+        /**
+         * \brief The check box enabling regular expressions.
+         */
+        NSButton * regularExpressionButton;
+
+        /**
+         * \brief The check box enabling case insensitive matching.
+         */
+        NSButton * ignoreCaseButton;
+
+        /**
+         * \brief The table view listing the matches.
+         */
+        NSTableView * resultsTableView;
+
+        /**
+         * \brief The field describing the progress of the search.
+         */
+        NSTextField * statusField;
+
+        /**
+         * \brief The running or finished search, or nil if the query is empty.
+         */
+        PLProjectSearch * search;
+
+        /**
+         * \brief The `PLProjectSearchMatch` objects of the search in the order
+         *        they arrived.
+         */
+        NSMutableArray * matches;
+
+        /**
+         * \brief The font of the matching lines.
+         */
+        NSFont * font;
+
+        /**
+         * \brief The theme color of the text.
+         */
+        NSColor * foregroundColor;
+
+        /**
+         * \brief The theme color highlighting the matched text.
+         */
+        NSColor * selectionColor;
+}
+
+/**
+ * \brief The directory searched.
+ *
+ * \details Setting a different directory searches it again.
+ */
+@property (nonatomic, copy) NSString * directoryPath;
+
+/**
+ * \brief The block that is called when the user opens a match.
+ */
+@property (copy) void (^openDocumentHandler)(NSURL * fileURL);
+
+/**
+ * \brief Create a new project search view controller.
+ *
+ * \param directoryPath The directory to search.
+ *
+ * \return A view controller on the autorelease pool.
+ */
++(instancetype)viewControllerWithDirectoryPath:(NSString *)directoryPath;
+
+@end
@@ -0,0 +1,432 @@
+/**
+ * \file PLProjectSearchViewController.m
+ *
+ * \brief Liasis Python IDE project search results tab.
+ *
+ * \details This file includes the view controller of the tab that searches a
+ *          project and lists the matching lines.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLProjectSearchViewController.h"
+#import "PLThemeTable.h"
+
+/**
+ * \brief The title of the tab before a query is entered.
+ */
+static NSString * const PLProjectSearchDefaultTitle = @"Find in Project";
+
+@implementation PLProjectSearchViewController
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super initWithNibName:nil bundle:nil];
+        if (self) {
+                matches = [[NSMutableArray alloc] init];
+                font = [[NSFont userFixedPitchFontOfSize:11.0] retain];
+                foregroundColor = [[NSColor textColor] retain];
+                selectionColor = [[NSColor selectedTextBackgroundColor] retain];
+                [self setTitle:PLProjectSearchDefaultTitle];
+        }
+        return self;
+}
+
++(instancetype)viewControllerWithDirectoryPath:(NSString *)directoryPath
+{
+        PLProjectSearchViewController * viewController = [[[self alloc] init] autorelease];
+        viewController.directoryPath = directoryPath;
+        return viewController;
+}
+
+-(void)dealloc
+{
+        [search cancel];
+        [search release];
+        [resultsTableView setDataSource:nil];
+        [resultsTableView setDelegate:nil];
+        [searchField release];
+        [regularExpressionButton release];
+        [ignoreCaseButton release];
+        [resultsTableView release];
+        [statusField release];
+        [matches release];
+        [font release];
+        [foregroundColor release];
+        [selectionColor release];
+        [_directoryPath release];
+        [_openDocumentHandler release];
+        [super dealloc];
+}
+
+/**
+ * \brief Create a check box sending `startSearch:`.
+ */
+-(NSButton *)createCheckBoxWithTitle:(NSString *)title
+{
+        NSButton * checkBox = [[NSButton alloc] initWithFrame:NSZeroRect];
+
+        [checkBox setButtonType:NSSwitchButton];
+        [checkBox setTitle:title];
+        [[checkBox cell] setControlSize:NSSmallControlSize];
+        [checkBox setFont:[NSFont systemFontOfSize:[NSFont smallSystemFontSize]]];
+        [checkBox sizeToFit];
+        [checkBox setAutoresizingMask:(NSViewMinXMargin | NSViewMinYMargin)];
+        [checkBox setTarget:self];
+        [checkBox setAction:@selector(startSearch:)];
+        return checkBox;
+}
+
+/**
+ * \brief Create the search field, options, results list, and status field.
+ */
+-(void)loadView
+{
+        NSRect bounds = NSMakeRect(0.0, 0.0, 600.0, 400.0);
+        NSView * view = [[[NSView alloc] initWithFrame:bounds] autorelease];
+        NSScrollView * scrollView = nil;
+        NSTableColumn * column = nil;
+        CGFloat margin = 8.0, searchFieldHeight = 22.0, statusFieldHeight = 17.0;
+        CGFloat topRow = NSHeight(bounds) - margin - searchFieldHeight, optionsX = NSWidth(bounds) - margin;
+
+        [view setAutoresizingMask:(NSViewWidthSizable | NSViewHeightSizable)];
+
+        ignoreCaseButton = [self createCheckBoxWithTitle:@"Ignore Case"];
+        optionsX -= NSWidth([ignoreCaseButton frame]);
+        [ignoreCaseButton setFrameOrigin:NSMakePoint(optionsX, topRow + 2.0)];
+        [view addSubview:ignoreCaseButton];
+
+        regularExpressionButton = [self createCheckBoxWithTitle:@"Regular Expression"];
+        optionsX -= NSWidth([regularExpressionButton frame]) + margin;
+        [regularExpressionButton setFrameOrigin:NSMakePoint(optionsX, topRow + 2.0)];
+        [view addSubview:regularExpressionButton];
+
+        searchField = [[NSSearchField alloc] initWithFrame:NSMakeRect(margin, topRow, optionsX - 2.0 * margin, searchFieldHeight)];
+        [searchField setAutoresizingMask:(NSViewWidthSizable | NSViewMinYMargin)];
+        [[searchField cell] setPlaceholderString:@"Find in Project"];
+        [[searchField cell] setSendsWholeSearchString:NO];
+        [searchField setTarget:self];
+        [searchField setAction:@selector(startSearch:)];
+        [view addSubview:searchField];
+
+        statusField = [[NSTextField alloc] initWithFrame:NSMakeRect(margin, margin / 2.0, NSWidth(bounds) - 2.0 * margin, statusFieldHeight)];
+        [statusField setAutoresizingMask:(NSViewWidthSizable | NSViewMaxYMargin)];
+        [statusField setEditable:NO];
+        [statusField setBordered:NO];
+        [statusField setDrawsBackground:NO];
+        [statusField setFont:[NSFont systemFontOfSize:[NSFont smallSystemFontSize]]];
+        [view addSubview:statusField];
+
+        column = [[[NSTableColumn alloc] initWithIdentifier:@"match"] autorelease];
+        [column setEditable:NO];
+        [column setResizingMask:NSTableColumnAutoresizingMask];
+        resultsTableView = [[NSTableView alloc] initWithFrame:NSZeroRect];
+        [resultsTableView addTableColumn:column];
+        [resultsTableView setHeaderView:nil];
+        [resultsTableView setColumnAutoresizingStyle:NSTableViewUniformColumnAutoresizingStyle];
+        [resultsTableView setDataSource:self];
+        [resultsTableView setDelegate:self];
+        [resultsTableView setTarget:self];
+        [resultsTableView setDoubleAction:@selector(openClickedMatch:)];
+
+        scrollView = [[[NSScrollView alloc] initWithFrame:NSMakeRect(0.0,
+                                                                     margin + statusFieldHeight,
+                                                                     NSWidth(bounds),
+                                                                     topRow - margin - margin - statusFieldHeight)] autorelease];
+        [scrollView setAutoresizingMask:(NSViewWidthSizable | NSViewHeightSizable)];
+        [scrollView setHasVerticalScroller:YES];
+        [scrollView setBorderType:NSNoBorder];
+        [scrollView setDocumentView:resultsTableView];
+        [column setWidth:[scrollView contentSize].width];
+        [view addSubview:scrollView];
+
+        [self setView:view];
+        [self updateTableAppearance];
+}
+
+#pragma mark - Searching
+
+-(void)setDirectoryPath:(NSString *)directoryPath
+{
+        if ([directoryPath isEqualToString:_directoryPath]) {
+                goto exit;
+        }
+        [_directoryPath release];
+        _directoryPath = [directoryPath copy];
+        if (searchField) {
+                [self startSearch:self];
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Cancel the running search and start a new one with the current query
+ *        and options.
+ *
+ * \param sender The object sending the message.
+ */
+-(IBAction)startSearch:(id)sender
+{
+        NSString * query = [searchField stringValue];
+        PLProjectSearchOptions options = 0;
+        NSError * error = nil;
+        __block PLProjectSearchViewController * blockSelf = self;
+        PLProjectSearch * newSearch = nil;
+
+        [search cancel];
+        [search release];
+        search = nil;
+        [matches removeAllObjects];
+        [resultsTableView reloadData];
+        [self setTabTitle:([query length] > 0) ? [NSString stringWithFormat:@"Find “%@”", query] : PLProjectSearchDefaultTitle];
+
+        if ([query length] == 0 || self.directoryPath == nil) {
+                [statusField setStringValue:@""];
+                goto exit;
+        }
+        if ([regularExpressionButton state] == NSOnState) {
+                options |= PLProjectSearchRegularExpression;
+        }
+        if ([ignoreCaseButton state] == NSOnState) {
+                options |= PLProjectSearchCaseInsensitive;
+        }
+        newSearch = [PLProjectSearch searchWithDirectoryPath:self.directoryPath pattern:query options:options error:&error];
+        if (newSearch == nil) {
+                [statusField setStringValue:[error localizedDescription] ?: @"Invalid regular expression."];
+                goto exit;
+        }
+
+        search = [newSearch retain];
+        [statusField setStringValue:@"Searching…"];
+        [search startWithResultHandler:^(NSArray * newMatches, BOOL finished) {
+                if (newSearch != blockSelf->search) {
+                        return;
+                }
+                if (finished) {
+                        [blockSelf searchDidFinish];
+                } else {
+                        [blockSelf appendMatches:newMatches];
+                }
+        }];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Append a batch of matches to the list.
+ *
+ * \param newMatches The matches.
+ */
+-(void)appendMatches:(NSArray *)newMatches
+{
+        [matches addObjectsFromArray:newMatches];
+        [resultsTableView noteNumberOfRowsChanged];
+        [statusField setStringValue:[NSString stringWithFormat:@"Searching… %lu matches", (unsigned long)[matches count]]];
+}
+
+/**
+ * \brief Describe the finished search and its throughput.
+ */
+-(void)searchDidFinish
+{
+        [statusField setStringValue:[NSString stringWithFormat:@"%@%lu matches in %lu files · %.1f MB in %.2f s · %.2f GB/s",
+                                     [search isTruncated] ? @"First " : @"",
+                                     (unsigned long)[matches count],
+                                     (unsigned long)[search numberOfFilesSearched],
+                                     (double)[search numberOfBytesSearched] / 1.0e6,
+                                     [search duration],
+                                     [search throughput] / 1.0e9]];
+}
+
+/**
+ * \brief Open the file of the double clicked match with the
+ *        `openDocumentHandler`.
+ *
+ * \param sender The object sending the message.
+ */
+-(void)openClickedMatch:(id)sender
+{
+        NSInteger clickedRow = [resultsTableView clickedRow];
+
+        if (clickedRow < 0 || clickedRow >= (NSInteger)[matches count] || self.openDocumentHandler == nil) {
+                goto exit;
+        }
+        self.openDocumentHandler([NSURL fileURLWithPath:[[matches objectAtIndex:clickedRow] path]]);
+
+exit:
+        return;
+}
+
+#pragma mark - Table View Data Source
+
+-(NSInteger)numberOfRowsInTableView:(NSTableView *)tableView
+{
+        return (NSInteger)[matches count];
+}
+
+/**
+ * \brief Display the path of a match relative to the project directory and its
+ *        line number, dimmed, followed by the line with the match highlighted.
+ */
+-(id)tableView:(NSTableView *)tableView objectValueForTableColumn:(NSTableColumn *)tableColumn row:(NSInteger)row
+{
+        PLProjectSearchMatch * match = [matches objectAtIndex:row];
+        NSString * path = [match path];
+        NSString * lineText = [match lineText];
+        NSRange matchRange = [match matchRange];
+        NSUInteger indentation = 0;
+        NSMutableAttributedString * value = nil;
+        NSMutableAttributedString * line = nil;
+
+        if ([path hasPrefix:self.directoryPath]) {
+                path = [path substringFromIndex:MIN([self.directoryPath length] + 1, [path length])];
+        }
+        value = [[[NSMutableAttributedString alloc] initWithString:[NSString stringWithFormat:@"%@:%lu  ", path, (unsigned long)[match lineNumber]]
+                                                        attributes:@{NSFontAttributeName: font,
+                                                                     NSForegroundColorAttributeName: [foregroundColor colorWithAlphaComponent:0.5]}] autorelease];
+
+        /* Drop the indentation so the match is visible */
+        while (indentation < matchRange.location && [[NSCharacterSet whitespaceCharacterSet] characterIsMember:[lineText characterAtIndex:indentation]]) {
+                indentation++;
+        }
+        line = [[[NSMutableAttributedString alloc] initWithString:[lineText substringFromIndex:indentation]
+                                                       attributes:@{NSFontAttributeName: font,
+                                                                    NSForegroundColorAttributeName: foregroundColor}] autorelease];
+        if (NSMaxRange(matchRange) <= [lineText length] && matchRange.length > 0) {
+                [line addAttribute:NSBackgroundColorAttributeName
+                              value:selectionColor
+                              range:NSMakeRange(matchRange.location - indentation, matchRange.length)];
+        }
+        [value appendAttributedString:line];
+        return value;
+}
+
+#pragma mark - Tab Subview Controller
+
+/**
+ * \brief Set the title of the tab and notify the tab view controller.
+ *
+ * \param title The new title.
+ */
+-(void)setTabTitle:(NSString *)title
+{
+        [self setTitle:title];
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLTabSubviewTitleDidChangeNotification object:self];
+}
+
+/**
+ * \brief The project search tab has no document.
+ *
+ * \return nil.
+ */
+-(id)document
+{
+        return nil;
+}
+
+/**
+ * \brief Cancel the running search when the tab closes.
+ *
+ * \return YES.
+ */
+-(BOOL)tabSubviewShouldClose:(id)sender
+{
+        [search cancel];
+        return YES;
+}
+
+/**
+ * \brief Does nothing, as there is no document to save.
+ */
+-(IBAction)saveFile:(id)sender
+{
+        return;
+}
+
+/**
+ * \brief Does nothing, as there is no document to save.
+ */
+-(IBAction)saveFileAs:(id)sender
+{
+        return;
+}
+
+/**
+ * \brief Focus the search field, selecting the query so typing replaces it.
+ *
+ * \return YES if the search field became first responder.
+ */
+-(BOOL)becomeFirstResponder
+{
+        BOOL accepted = [[[self view] window] makeFirstResponder:searchField];
+        [searchField selectText:self];
+        return accepted;
+}
+
+#pragma mark - Themeable
+
+/**
+ * \brief Apply the theme's foreground, background, and selection colors to the
+ *        list of matches.
+ */
+-(void)updateThemeManager
+{
+        PLThemeTable * themeTable = [PLThemeTable sharedThemeTable];
+
+        [foregroundColor release];
+        foregroundColor = [[themeTable color:PLThemeColorForeground] retain];
+        [selectionColor release];
+        selectionColor = [[themeTable color:PLThemeColorSelection] retain];
+        [self updateTableAppearance];
+        [resultsTableView setBackgroundColor:[themeTable color:PLThemeColorBackground]];
+        [resultsTableView reloadData];
+}
+
+/**
+ * \brief Display the matching lines with a new font.
+ *
+ * \param newFont The font.
+ */
+-(void)updateFont:(NSFont *)newFont
+{
+        [newFont retain];
+        [font release];
+        font = newFont;
+        [self updateTableAppearance];
+        [resultsTableView reloadData];
+}
+
+/**
+ * \brief Size the rows of the list to the font.
+ */
+-(void)updateTableAppearance
+{
+        [resultsTableView setRowHeight:ceil([font ascender] - [font descender] + [font leading]) + 4.0];
+        [statusField setTextColor:[foregroundColor colorWithAlphaComponent:0.6]];
+}
+
+@end
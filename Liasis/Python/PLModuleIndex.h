@@ -0,0 +1,181 @@
+/**
+ * \file PLModuleIndex.h
+ *
+ * \brief Liasis Python IDE module index.
+ *
+ * \details This file includes the persistent index of the modules importable
+ *          by the embedded interpreter and their top level names.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class PLModuleIndexSnapshot;
+
+/**
+ * \brief Posted on the main queue when the contents of the module index
+ *        change.
+ *
+ * \details The notification object is the `PLModuleIndex`.
+ */
+extern NSString * const PLModuleIndexDidUpdateNotification;
+
+/**
+ * \class PLModuleIndex \headerfile \headerfile
+ *
+ * \brief A persistent index of the modules on the interpreter's `sys.path`,
+ *        their submodules, and their top level names.
+ *
+ * \details Once the interpreter is ready, `sys.path` is read and its entries
+ *          are scanned in parallel on background queues. Modules, packages,
+ *          extension modules, and namespace packages are found from the names
+ *          of the files and directories alone, and the top level classes,
+ *          functions, and variables of each Python source are found with
+ *          `PLPythonScanSymbols`, so nothing is imported.
+ *
+ *          The index is stored in a single file per environment, identified
+ *          by `sys.prefix` and the interpreter version, in the user's caches
+ *          directory, and the index of the last environment is memory mapped
+ *          as soon as the index is opened, so it is queryable at launch before
+ *          the interpreter starts. The file records the modification time of
+ *          every directory scanned. Installing or removing packages changes
+ *          the directories holding them, so an update only lists and reads
+ *          the directories whose modification time changed, and copies
+ *          everything else from the previous index.
+ *
+ *          Queries binary search the module names and may be made from any
+ *          thread.
+ */
+@interface PLModuleIndex : NSObject
+{
+        /**
+         * \brief The current contents of the index.
+         */
+        PLModuleIndexSnapshot * snapshot;
+
+        /**
+         * \brief The serial queue on which the index is opened and updated.
+         */
+        dispatch_queue_t indexQueue;
+
+        /**
+         * \brief YES once the index has been opened.
+         */
+        BOOL opened;
+}
+
+/**
+ * \brief The shared module index.
+ *
+ * \return The module index of the embedded interpreter.
+ */
++(instancetype)sharedIndex;
+
+/**
+ * \brief Open the index of the last environment and update it once the
+ *        interpreter is ready.
+ *
+ * \details Must be called on the main thread. Does nothing if the index was
+ *          already opened. The update starts the interpreter if needed.
+ */
+-(void)open;
+
+/**
+ * \brief Scan `sys.path` again in the background, reading only the
+ *        directories that changed.
+ *
+ * \details Waits for the interpreter to be ready first.
+ */
+-(void)update;
+
+/**
+ * \brief Determine if the index can be queried.
+ *
+ * \return YES if the index has been opened or built.
+ */
+-(BOOL)isReady;
+
+/**
+ * \brief The number of modules in the index.
+ *
+ * \return The number of importable modules and packages.
+ */
+-(NSUInteger)numberOfModules;
+
+/**
+ * \brief Determine if a module can be imported.
+ *
+ * \param moduleName The dotted name of the module.
+ *
+ * \return YES if the module is in the index.
+ */
+-(BOOL)hasModuleNamed:(NSString *)moduleName;
+
+/**
+ * \brief Find the file of a module.
+ *
+ * \param moduleName The dotted name of the module.
+ *
+ * \return The full path of the source, `__init__.py`, or extension of the
+ *         module, the directory of a namespace package, or nil if the module
+ *         is not in the index.
+ */
+-(NSString *)pathOfModuleNamed:(NSString *)moduleName;
+
+/**
+ * \brief Find the modules whose names begin with a prefix, for import
+ *        completion.
+ *
+ * \param prefix The prefix, matched exactly.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \return An array of dotted module names in alphabetical order.
+ */
+-(NSArray *)modulesWithPrefix:(NSString *)prefix maximumCount:(NSUInteger)maximumCount;
+
+/**
+ * \brief Find the names a module makes available as attributes.
+ *
+ * \param moduleName The dotted name of the module.
+ *
+ * \return An array of the names of the submodules of the module and of the
+ *         public top level definitions of its source, or an empty array if
+ *         the module is not in the index.
+ */
+-(NSArray *)membersOfModuleNamed:(NSString *)moduleName;
+
+/**
+ * \brief Call a block with the name of each module in the index, for building
+ *        other indexes from it.
+ *
+ * \details The names are enumerated on the calling thread from the current
+ *          contents of the index, in alphabetical order, without creating
+ *          objects.
+ *
+ * \param block The block, called with the UTF-8 bytes of the dotted name and
+ *              their number. The bytes are only valid during the call.
+ */
+-(void)enumerateModuleNamesUsingBlock:(void (^)(const char * name, size_t length))block;
+
+@end
@@ -0,0 +1,1528 @@
+/**
+ * \file PLModuleIndex.m
+ *
+ * \brief Liasis Python IDE module index.
+ *
+ * \details This file includes the persistent index of the modules importable
+ *          by the embedded interpreter and their top level names.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Python/Python.h>
+#import <QuartzCore/QuartzCore.h>
+#import <dirent.h>
+#import <sys/stat.h>
+#import "PLModuleIndex.h"
+#import "PLUserDefaults.h"
+#import "PLPythonRuntime.h"
+#import "PLPythonSymbolScanner.h"
+
+NSString * const PLModuleIndexDidUpdateNotification = @"PLModuleIndexDidUpdateNotification";
+
+/**
+ * \brief The user default holding the environment hash of the index opened at
+ *        launch, as 16 hexadecimal digits.
+ */
+static NSString * const PLModuleIndexEnvironmentDefault = @"PLModuleIndexEnvironment";
+
+/**
+ * \brief The magic number at the start of an index file, "PLMX".
+ */
+static const uint32_t PLModuleIndexMagic = 0x584D4C50;
+
+/**
+ * \brief The version of the index file format.
+ */
+static const uint32_t PLModuleIndexVersion = 1;
+
+/**
+ * \brief The largest source whose top level names are indexed, in bytes.
+ */
+static const off_t PLModuleIndexMaximumFileSize = 2 * 1024 * 1024;
+
+/**
+ * \brief The deepest package nesting scanned below a path entry.
+ */
+static const NSUInteger PLModuleIndexMaximumDepth = 16;
+
+/**
+ * \brief The longest dotted module name, in bytes.
+ */
+static const size_t PLModuleIndexMaximumNameLength = 1023;
+
+/**
+ * \brief Flags of a module.
+ */
+static const uint8_t PLModuleIndexModulePackage = 1 << 0;
+static const uint8_t PLModuleIndexModuleExtension = 1 << 1;
+static const uint8_t PLModuleIndexModuleCompiled = 1 << 2;
+static const uint8_t PLModuleIndexModuleNamespace = 1 << 3;
+
+#pragma mark - File Format
+
+/**
+ * \brief The header of an index file.
+ *
+ * \details The header is followed by the path entry table, the directory
+ *          table, the module table, the export table, and the pool of the
+ *          bytes of all paths and names.
+ */
+typedef struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t pathEntryCount;
+        uint32_t directoryCount;
+        uint32_t moduleCount;
+        uint32_t exportCount;
+        uint32_t poolLength;
+        uint32_t reserved;
+        uint64_t environmentHash;
+} PLModuleIndexHeader;
+
+/**
+ * \brief An entry of `sys.path`, in order.
+ */
+typedef struct {
+        uint32_t pathOffset;
+        uint32_t pathLength;
+} PLModuleIndexPathEntry;
+
+/**
+ * \brief A directory scanned, a path entry or a package.
+ *
+ * \details Directories are ordered by full path with
+ *          `PLModuleIndexCompareBytes`, so the subdirectories of a directory
+ *          follow it.
+ */
+typedef struct {
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint32_t pathEntryIndex;
+        uint32_t reserved;
+        int64_t modificationTime;
+} PLModuleIndexDirectory;
+
+/**
+ * \brief A module.
+ *
+ * \details Modules are ordered by dotted name with
+ *          `PLModuleIndexCompareBytes`, and only the first module of a name on
+ *          `sys.path` is kept. A module belongs to the directory its file is
+ *          in, so a package belongs to its own directory, and its file name is
+ *          relative to that directory.
+ */
+typedef struct {
+        uint32_t nameOffset;
+        uint32_t fileOffset;
+        uint32_t directoryIndex;
+        uint32_t firstExport;
+        uint32_t exportCount;
+        uint16_t nameLength;
+        uint16_t fileLength;
+        uint8_t flags;
+        uint8_t reserved[3];
+} PLModuleIndexModule;
+
+/**
+ * \brief A public top level name of a module, ordered by name within the
+ *        module.
+ */
+typedef struct {
+        uint32_t nameOffset;
+        uint16_t nameLength;
+        uint8_t kind;
+        uint8_t reserved;
+} PLModuleIndexExport;
+
+#pragma mark - Names
+
+/**
+ * \brief Compute the 64-bit FNV-1a hash of bytes, continuing from a hash.
+ */
+static uint64_t PLModuleIndexHash(uint64_t hash, const void * bytes, size_t length)
+{
+        const uint8_t * characters = bytes;
+        size_t i = 0;
+
+        for (i = 0; i < length; i++) {
+                hash ^= characters[i];
+                hash *= 1099511628211ULL;
+        }
+        return hash;
+}
+
+/**
+ * \brief Order two byte strings, a prefix before the strings it begins.
+ *
+ * \return A negative number, zero, or a positive number if `bytes` is ordered
+ *         before, the same as, or after `otherBytes`.
+ */
+static int PLModuleIndexCompareBytes(const char * bytes, size_t length, const char * otherBytes, size_t otherLength)
+{
+        int order = memcmp(bytes, otherBytes, MIN(length, otherLength));
+
+        if (order == 0 && length != otherLength) {
+                order = (length < otherLength) ? -1 : 1;
+        }
+        return order;
+}
+
+/**
+ * \brief Determine if bytes are a Python identifier. Bytes of non-ASCII
+ *        characters are accepted.
+ */
+static BOOL PLModuleIndexIsIdentifier(const char * bytes, size_t length)
+{
+        size_t i = 0;
+        uint8_t character = 0;
+        BOOL identifier = (length > 0 && !(bytes[0] >= '0' && bytes[0] <= '9'));
+
+        for (i = 0; i < length && identifier; i++) {
+                character = (uint8_t)bytes[i];
+                identifier = ((character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') ||
+                              (character >= '0' && character <= '9') || character == '_' || character >= 0x80);
+        }
+        return identifier;
+}
+
+/**
+ * \brief Determine if a file name ends with a suffix.
+ */
+static BOOL PLModuleIndexHasSuffix(const char * name, size_t length, const char * suffix)
+{
+        size_t suffixLength = strlen(suffix);
+
+        return length > suffixLength && memcmp(name + length - suffixLength, suffix, suffixLength) == 0;
+}
+
+/**
+ * \brief Find the public top level definitions of a Python source.
+ *
+ * \param contents The contents of the source.
+ *
+ * \return The definitions, each a kind byte, a length byte, and the UTF-8
+ *         bytes of the name, in the order of the source.
+ */
+static NSData * PLModuleIndexScanExports(NSData * contents)
+{
+        NSString * source = [[NSString alloc] initWithData:contents encoding:NSUTF8StringEncoding];
+        NSMutableData * exports = [NSMutableData data];
+        unichar * characters = NULL;
+        NSUInteger length = 0;
+
+        if (source == nil) {
+                source = [[NSString alloc] initWithData:contents encoding:NSISOLatin1StringEncoding];
+        }
+        length = [source length];
+        characters = malloc(MAX(length, 1) * sizeof(unichar));
+        [source getCharacters:characters range:NSMakeRange(0, length)];
+        PLPythonScanSymbols(characters, length, ^(const unichar * sourceCharacters, const PLPythonSymbol * symbol) {
+                NSString * name = nil;
+                const char * nameBytes = NULL;
+                uint8_t record[2];
+
+                if (symbol->topLevel == NO || symbol->kind > PLPythonSymbolVariable || sourceCharacters[symbol->range.location] == '_') {
+                        return;
+                }
+                name = [[NSString alloc] initWithCharacters:sourceCharacters + symbol->range.location length:symbol->range.length];
+                nameBytes = [name UTF8String];
+                if (nameBytes != NULL && strlen(nameBytes) <= UINT8_MAX) {
+                        record[0] = symbol->kind;
+                        record[1] = (uint8_t)strlen(nameBytes);
+                        [exports appendBytes:record length:sizeof(record)];
+                        [exports appendBytes:nameBytes length:record[1]];
+                }
+                [name release];
+        });
+        free(characters);
+        [source release];
+        return exports;
+}
+
+/**
+ * \brief A name being sorted.
+ */
+typedef struct {
+        const char * bytes;
+        uint32_t length;
+        uint32_t rank;
+        uint32_t index;
+        uint8_t kind;
+} PLModuleIndexSortedName;
+
+/**
+ * \brief Order names being sorted by their bytes, then by rank, then by
+ *        index, so sorting is stable.
+ */
+static int PLModuleIndexCompareSortedNames(const void * first, const void * second)
+{
+        const PLModuleIndexSortedName * firstName = first, * secondName = second;
+        int order = PLModuleIndexCompareBytes(firstName->bytes, firstName->length, secondName->bytes, secondName->length);
+
+        if (order == 0 && firstName->rank != secondName->rank) {
+                order = (firstName->rank < secondName->rank) ? -1 : 1;
+        }
+        if (order == 0 && firstName->index != secondName->index) {
+                order = (firstName->index < secondName->index) ? -1 : 1;
+        }
+        return order;
+}
+
+#pragma mark -
+
+/**
+ * \class PLModuleIndexSnapshot
+ *
+ * \brief The immutable contents of a module index, read from index data.
+ */
+@interface PLModuleIndexSnapshot : NSObject
+{
+@public
+        NSData * data;
+        const PLModuleIndexHeader * header;
+        const PLModuleIndexPathEntry * pathEntries;
+        const PLModuleIndexDirectory * directories;
+        const PLModuleIndexModule * modules;
+        const PLModuleIndexExport * exports;
+        const char * pool;
+
+        /**
+         * \brief The indexes of the modules grouped by directory, once
+         *        prepared.
+         */
+        uint32_t * directoryModules;
+
+        /**
+         * \brief The index in `directoryModules` of the first module of each
+         *        directory, and of the end.
+         */
+        uint32_t * directoryModuleStarts;
+}
+
+-(instancetype)initWithData:(NSData *)indexData;
+
+-(uint32_t)indexOfModuleNamed:(const char *)name length:(size_t)length;
+
+-(uint32_t)indexOfFirstModuleWithPrefix:(const char *)prefix length:(size_t)length;
+
+-(uint32_t)indexOfFirstDirectoryWithPrefix:(const char *)prefix length:(size_t)length;
+
+-(void)prepareDirectoryModules;
+
+@end
+
+@implementation PLModuleIndexSnapshot
+
+/**
+ * \brief Initialize a snapshot with index data.
+ *
+ * \details The data is validated so that a truncated or corrupt index file is
+ *          never queried.
+ *
+ * \param indexData The index data.
+ *
+ * \return The snapshot, or nil if the data is not a valid index.
+ */
+-(instancetype)initWithData:(NSData *)indexData
+{
+        const uint8_t * bytes = [indexData bytes];
+        uint64_t expectedLength = 0;
+        uint32_t i = 0;
+
+        self = [super init];
+        if (self == nil) {
+                goto exit;
+        }
+
+        if ([indexData length] < sizeof(PLModuleIndexHeader)) {
+                goto fail;
+        }
+        header = (const PLModuleIndexHeader *)bytes;
+        expectedLength = (sizeof(PLModuleIndexHeader) +
+                          (uint64_t)header->pathEntryCount * sizeof(PLModuleIndexPathEntry) +
+                          (uint64_t)header->directoryCount * sizeof(PLModuleIndexDirectory) +
+                          (uint64_t)header->moduleCount * sizeof(PLModuleIndexModule) +
+                          (uint64_t)header->exportCount * sizeof(PLModuleIndexExport) +
+                          header->poolLength);
+        if (header->magic != PLModuleIndexMagic || header->version != PLModuleIndexVersion || expectedLength != [indexData length]) {
+                goto fail;
+        }
+        pathEntries = (const PLModuleIndexPathEntry *)(bytes + sizeof(PLModuleIndexHeader));
+        directories = (const PLModuleIndexDirectory *)(pathEntries + header->pathEntryCount);
+        modules = (const PLModuleIndexModule *)(directories + header->directoryCount);
+        exports = (const PLModuleIndexExport *)(modules + header->moduleCount);
+        pool = (const char *)(exports + header->exportCount);
+
+        for (i = 0; i < header->pathEntryCount; i++) {
+                if ((uint64_t)pathEntries[i].pathOffset + pathEntries[i].pathLength > header->poolLength) {
+                        goto fail;
+                }
+        }
+        for (i = 0; i < header->directoryCount; i++) {
+                if ((uint64_t)directories[i].pathOffset + directories[i].pathLength > header->poolLength ||
+                    directories[i].pathEntryIndex >= header->pathEntryCount) {
+                        goto fail;
+                }
+        }
+        for (i = 0; i < header->moduleCount; i++) {
+                if ((uint64_t)modules[i].nameOffset + modules[i].nameLength > header->poolLength ||
+                    (uint64_t)modules[i].fileOffset + modules[i].fileLength > header->poolLength ||
+                    modules[i].directoryIndex >= header->directoryCount ||
+                    (uint64_t)modules[i].firstExport + modules[i].exportCount > header->exportCount) {
+                        goto fail;
+                }
+        }
+        for (i = 0; i < header->exportCount; i++) {
+                if ((uint64_t)exports[i].nameOffset + exports[i].nameLength > header->poolLength) {
+                        goto fail;
+                }
+        }
+        data = [indexData retain];
+
+exit:
+        return self;
+
+fail:
+        [self release];
+        return nil;
+}
+
+-(void)dealloc
+{
+        free(directoryModules);
+        free(directoryModuleStarts);
+        [data release];
+        [super dealloc];
+}
+
+/**
+ * \brief Find a module.
+ *
+ * \return The index of the module, or `UINT32_MAX` if it is not indexed.
+ */
+-(uint32_t)indexOfModuleNamed:(const char *)name length:(size_t)length
+{
+        uint32_t moduleIndex = [self indexOfFirstModuleWithPrefix:name length:length];
+
+        if (moduleIndex == header->moduleCount ||
+            PLModuleIndexCompareBytes(pool + modules[moduleIndex].nameOffset, modules[moduleIndex].nameLength, name, length) != 0) {
+                moduleIndex = UINT32_MAX;
+        }
+        return moduleIndex;
+}
+
+/**
+ * \brief Find the first module whose name is not ordered before a prefix.
+ *
+ * \return The index of the module, or the number of modules.
+ */
+-(uint32_t)indexOfFirstModuleWithPrefix:(const char *)prefix length:(size_t)length
+{
+        uint32_t low = 0, high = header->moduleCount, middle = 0;
+
+        while (low < high) {
+                middle = low + (high - low) / 2;
+                if (PLModuleIndexCompareBytes(pool + modules[middle].nameOffset, modules[middle].nameLength, prefix, length) < 0) {
+                        low = middle + 1;
+                } else {
+                        high = middle;
+                }
+        }
+        return low;
+}
+
+/**
+ * \brief Find the first directory whose path is not ordered before a prefix.
+ *
+ * \return The index of the directory, or the number of directories.
+ */
+-(uint32_t)indexOfFirstDirectoryWithPrefix:(const char *)prefix length:(size_t)length
+{
+        uint32_t low = 0, high = header->directoryCount, middle = 0;
+
+        while (low < high) {
+                middle = low + (high - low) / 2;
+                if (PLModuleIndexCompareBytes(pool + directories[middle].pathOffset, directories[middle].pathLength, prefix, length) < 0) {
+                        low = middle + 1;
+                } else {
+                        high = middle;
+                }
+        }
+        return low;
+}
+
+/**
+ * \brief Group the modules by directory, so the modules of an unchanged
+ *        directory can be copied to a new index.
+ *
+ * \details Must be called before the snapshot is shared by the threads of an
+ *          update.
+ */
+-(void)prepareDirectoryModules
+{
+        uint32_t * placedCounts = NULL;
+        uint32_t moduleIndex = 0, directoryIndex = 0;
+
+        if (directoryModules != NULL) {
+                goto exit;
+        }
+        directoryModules = malloc(MAX(header->moduleCount, 1) * sizeof(uint32_t));
+        directoryModuleStarts = calloc(header->directoryCount + 1, sizeof(uint32_t));
+        placedCounts = calloc(MAX(header->directoryCount, 1), sizeof(uint32_t));
+        for (moduleIndex = 0; moduleIndex < header->moduleCount; moduleIndex++) {
+                directoryModuleStarts[modules[moduleIndex].directoryIndex + 1]++;
+        }
+        for (directoryIndex = 0; directoryIndex < header->directoryCount; directoryIndex++) {
+                directoryModuleStarts[directoryIndex + 1] += directoryModuleStarts[directoryIndex];
+        }
+        for (moduleIndex = 0; moduleIndex < header->moduleCount; moduleIndex++) {
+                directoryIndex = modules[moduleIndex].directoryIndex;
+                directoryModules[directoryModuleStarts[directoryIndex] + placedCounts[directoryIndex]] = moduleIndex;
+                placedCounts[directoryIndex]++;
+        }
+        free(placedCounts);
+
+exit:
+        return;
+}
+
+@end
+
+#pragma mark -
+
+/**
+ * \class PLModuleIndexBuilder
+ *
+ * \brief Accumulates the directories and modules of one path entry.
+ *
+ * \details Every path entry is scanned into its own builder on its own
+ *          thread, and the builders are combined into index data once all
+ *          path entries are scanned.
+ */
+@interface PLModuleIndexBuilder : NSObject
+{
+        NSMutableData * pool;
+        NSMutableData * directoryTable;
+        NSMutableData * moduleTable;
+        NSMutableData * exportTable;
+}
+
+/**
+ * \brief The number of directories listed.
+ */
+@property NSUInteger listedDirectoryCount;
+
+/**
+ * \brief The number of directories copied from the previous index.
+ */
+@property NSUInteger reusedDirectoryCount;
+
+-(uint32_t)addDirectoryAtPath:(const char *)path length:(size_t)length pathEntryIndex:(uint32_t)pathEntryIndex modificationTime:(int64_t)modificationTime;
+
+-(void)addModuleNamed:(const char *)name
+               length:(size_t)length
+             fileName:(const char *)fileName
+       fileNameLength:(size_t)fileNameLength
+                flags:(uint8_t)flags
+       directoryIndex:(uint32_t)directoryIndex
+              exports:(NSData *)exportRecords;
+
+-(void)addModulesOfDirectoryAtIndex:(uint32_t)previousIndex
+                         ofSnapshot:(PLModuleIndexSnapshot *)previousSnapshot
+                 toDirectoryAtIndex:(uint32_t)directoryIndex;
+
++(NSData *)dataWithBuilders:(NSArray *)builders paths:(NSArray *)paths environmentHash:(uint64_t)environmentHash;
+
+@end
+
+@implementation PLModuleIndexBuilder
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                pool = [[NSMutableData alloc] init];
+                directoryTable = [[NSMutableData alloc] init];
+                moduleTable = [[NSMutableData alloc] init];
+                exportTable = [[NSMutableData alloc] init];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [pool release];
+        [directoryTable release];
+        [moduleTable release];
+        [exportTable release];
+        [super dealloc];
+}
+
+/**
+ * \brief Add bytes to the pool.
+ *
+ * \return The offset of the bytes.
+ */
+-(uint32_t)addBytes:(const void *)bytes length:(size_t)length
+{
+        uint32_t offset = (uint32_t)[pool length];
+
+        [pool appendBytes:bytes length:length];
+        return offset;
+}
+
+/**
+ * \brief Add a directory.
+ *
+ * \return The index of the directory in the builder.
+ */
+-(uint32_t)addDirectoryAtPath:(const char *)path length:(size_t)length pathEntryIndex:(uint32_t)pathEntryIndex modificationTime:(int64_t)modificationTime
+{
+        PLModuleIndexDirectory directory;
+
+        memset(&directory, 0, sizeof(directory));
+        directory.pathOffset = [self addBytes:path length:length];
+        directory.pathLength = (uint32_t)length;
+        directory.pathEntryIndex = pathEntryIndex;
+        directory.modificationTime = modificationTime;
+        [directoryTable appendBytes:&directory length:sizeof(directory)];
+        return (uint32_t)([directoryTable length] / sizeof(PLModuleIndexDirectory) - 1);
+}
+
+/**
+ * \brief Add a scanned module.
+ *
+ * \param exportRecords The records returned by `PLModuleIndexScanExports`, or
+ *                      nil. They are sorted, and repeated names kept once.
+ */
+-(void)addModuleNamed:(const char *)name
+               length:(size_t)length
+             fileName:(const char *)fileName
+       fileNameLength:(size_t)fileNameLength
+                flags:(uint8_t)flags
+       directoryIndex:(uint32_t)directoryIndex
+              exports:(NSData *)exportRecords
+{
+        const uint8_t * records = [exportRecords bytes];
+        size_t recordsLength = [exportRecords length], offset = 0;
+        PLModuleIndexSortedName * names = malloc(MAX(recordsLength / 2, 1) * sizeof(PLModuleIndexSortedName));
+        PLModuleIndexModule module;
+        PLModuleIndexExport export;
+        uint32_t nameCount = 0, i = 0;
+
+        for (offset = 0; offset + 2 <= recordsLength && offset + 2 + records[offset + 1] <= recordsLength; offset += 2 + records[offset + 1]) {
+                names[nameCount].bytes = (const char *)records + offset + 2;
+                names[nameCount].length = records[offset + 1];
+                names[nameCount].kind = records[offset];
+                names[nameCount].rank = 0;
+                names[nameCount].index = nameCount;
+                nameCount++;
+        }
+        qsort(names, nameCount, sizeof(PLModuleIndexSortedName), PLModuleIndexCompareSortedNames);
+
+        memset(&module, 0, sizeof(module));
+        module.nameOffset = [self addBytes:name length:length];
+        module.nameLength = (uint16_t)length;
+        module.fileOffset = [self addBytes:fileName length:fileNameLength];
+        module.fileLength = (uint16_t)fileNameLength;
+        module.flags = flags;
+        module.directoryIndex = directoryIndex;
+        module.firstExport = (uint32_t)([exportTable length] / sizeof(PLModuleIndexExport));
+        for (i = 0; i < nameCount; i++) {
+                if (i > 0 && PLModuleIndexCompareBytes(names[i].bytes, names[i].length, names[i - 1].bytes, names[i - 1].length) == 0) {
+                        continue;
+                }
+                memset(&export, 0, sizeof(export));
+                export.nameOffset = [self addBytes:names[i].bytes length:names[i].length];
+                export.nameLength = (uint16_t)names[i].length;
+                export.kind = names[i].kind;
+                [exportTable appendBytes:&export length:sizeof(export)];
+                module.exportCount++;
+        }
+        [moduleTable appendBytes:&module length:sizeof(module)];
+        free(names);
+}
+
+/**
+ * \brief Copy the modules of a directory that did not change from the
+ *        previous index, with their exports.
+ */
+-(void)addModulesOfDirectoryAtIndex:(uint32_t)previousIndex
+                         ofSnapshot:(PLModuleIndexSnapshot *)previousSnapshot
+                 toDirectoryAtIndex:(uint32_t)directoryIndex
+{
+        const PLModuleIndexModule * previousModule = NULL;
+        const PLModuleIndexExport * previousExport = NULL;
+        PLModuleIndexModule module;
+        PLModuleIndexExport export;
+        uint32_t i = 0, j = 0;
+
+        for (i = previousSnapshot->directoryModuleStarts[previousIndex]; i < previousSnapshot->directoryModuleStarts[previousIndex + 1]; i++) {
+                previousModule = &previousSnapshot->modules[previousSnapshot->directoryModules[i]];
+                module = *previousModule;
+                module.nameOffset = [self addBytes:previousSnapshot->pool + previousModule->nameOffset length:previousModule->nameLength];
+                module.fileOffset = [self addBytes:previousSnapshot->pool + previousModule->fileOffset length:previousModule->fileLength];
+                module.directoryIndex = directoryIndex;
+                module.firstExport = (uint32_t)([exportTable length] / sizeof(PLModuleIndexExport));
+                for (j = 0; j < previousModule->exportCount; j++) {
+                        previousExport = &previousSnapshot->exports[previousModule->firstExport + j];
+                        export = *previousExport;
+                        export.nameOffset = [self addBytes:previousSnapshot->pool + previousExport->nameOffset length:previousExport->nameLength];
+                        [exportTable appendBytes:&export length:sizeof(export)];
+                }
+                [moduleTable appendBytes:&module length:sizeof(module)];
+        }
+}
+
+/**
+ * \brief Combine builders into index data.
+ *
+ * \details The directories are sorted by path, the modules by name with
+ *          those of earlier path entries first, and the modules shadowed by
+ *          an earlier module of the same name are dropped.
+ *
+ * \param builders The builders of the path entries, in the order of
+ *                 `sys.path`.
+ *
+ * \param paths The paths of the path entries.
+ *
+ * \param environmentHash The hash identifying the environment.
+ *
+ * \return The index data.
+ */
++(NSData *)dataWithBuilders:(NSArray *)builders paths:(NSArray *)paths environmentHash:(uint64_t)environmentHash
+{
+        NSMutableData * indexData = nil, * combinedPool = [NSMutableData data];
+        NSMutableData * pathEntryTable = [NSMutableData data];
+        PLModuleIndexDirectory * directoryTable = NULL, * sortedDirectories = NULL;
+        PLModuleIndexModule * moduleTable = NULL, * sortedModules = NULL;
+        PLModuleIndexExport * exportTable = NULL, * sortedExports = NULL;
+        PLModuleIndexSortedName * sortedNames = NULL;
+        PLModuleIndexPathEntry pathEntry;
+        PLModuleIndexHeader header;
+        const char * pathRepresentation = NULL;
+        uint32_t directoryCount = 0, moduleCount = 0, exportCount = 0, keptCount = 0, keptExportCount = 0;
+        uint32_t directoryBase = 0, moduleBase = 0, exportBase = 0, poolBase = 0, i = 0, rank = 0;
+        uint32_t * directoryRanks = NULL;
+
+        for (PLModuleIndexBuilder * builder in builders) {
+                directoryCount += [builder->directoryTable length] / sizeof(PLModuleIndexDirectory);
+                moduleCount += [builder->moduleTable length] / sizeof(PLModuleIndexModule);
+                exportCount += [builder->exportTable length] / sizeof(PLModuleIndexExport);
+        }
+        directoryTable = malloc(MAX(directoryCount, 1) * sizeof(PLModuleIndexDirectory));
+        sortedDirectories = malloc(MAX(directoryCount, 1) * sizeof(PLModuleIndexDirectory));
+        directoryRanks = malloc(MAX(directoryCount, 1) * sizeof(uint32_t));
+        moduleTable = malloc(MAX(moduleCount, 1) * sizeof(PLModuleIndexModule));
+        sortedModules = malloc(MAX(moduleCount, 1) * sizeof(PLModuleIndexModule));
+        exportTable = malloc(MAX(exportCount, 1) * sizeof(PLModuleIndexExport));
+        sortedExports = malloc(MAX(exportCount, 1) * sizeof(PLModuleIndexExport));
+        sortedNames = malloc(MAX(MAX(directoryCount, moduleCount), 1) * sizeof(PLModuleIndexSortedName));
+
+        for (NSString * path in paths) {
+                pathRepresentation = [path fileSystemRepresentation];
+                pathEntry.pathOffset = (uint32_t)[combinedPool length];
+                pathEntry.pathLength = (uint32_t)strlen(pathRepresentation);
+                [combinedPool appendBytes:pathRepresentation length:pathEntry.pathLength];
+                [pathEntryTable appendBytes:&pathEntry length:sizeof(pathEntry)];
+        }
+
+        /* Concatenate the builders, rebasing their offsets and indexes */
+        for (PLModuleIndexBuilder * builder in builders) {
+                poolBase = (uint32_t)[combinedPool length];
+                [combinedPool appendData:builder->pool];
+                memcpy(directoryTable + directoryBase, [builder->directoryTable bytes], [builder->directoryTable length]);
+                memcpy(moduleTable + moduleBase, [builder->moduleTable bytes], [builder->moduleTable length]);
+                memcpy(exportTable + exportBase, [builder->exportTable bytes], [builder->exportTable length]);
+                for (i = directoryBase; i < directoryBase + [builder->directoryTable length] / sizeof(PLModuleIndexDirectory); i++) {
+                        directoryTable[i].pathOffset += poolBase;
+                }
+                for (i = moduleBase; i < moduleBase + [builder->moduleTable length] / sizeof(PLModuleIndexModule); i++) {
+                        moduleTable[i].nameOffset += poolBase;
+                        moduleTable[i].fileOffset += poolBase;
+                        moduleTable[i].directoryIndex += directoryBase;
+                        moduleTable[i].firstExport += exportBase;
+                }
+                for (i = exportBase; i < exportBase + [builder->exportTable length] / sizeof(PLModuleIndexExport); i++) {
+                        exportTable[i].nameOffset += poolBase;
+                }
+                directoryBase += [builder->directoryTable length] / sizeof(PLModuleIndexDirectory);
+                moduleBase += [builder->moduleTable length] / sizeof(PLModuleIndexModule);
+                exportBase += [builder->exportTable length] / sizeof(PLModuleIndexExport);
+        }
+
+        /* Sort the directories by path */
+        for (i = 0; i < directoryCount; i++) {
+                sortedNames[i].bytes = (const char *)[combinedPool bytes] + directoryTable[i].pathOffset;
+                sortedNames[i].length = directoryTable[i].pathLength;
+                sortedNames[i].rank = 0;
+                sortedNames[i].index = i;
+        }
+        qsort(sortedNames, directoryCount, sizeof(PLModuleIndexSortedName), PLModuleIndexCompareSortedNames);
+        for (rank = 0; rank < directoryCount; rank++) {
+                sortedDirectories[rank] = directoryTable[sortedNames[rank].index];
+                directoryRanks[sortedNames[rank].index] = rank;
+        }
+
+        /* Sort the modules by name, earlier path entries first, and keep the first of each name */
+        for (i = 0; i < moduleCount; i++) {
+                sortedNames[i].bytes = (const char *)[combinedPool bytes] + moduleTable[i].nameOffset;
+                sortedNames[i].length = moduleTable[i].nameLength;
+                sortedNames[i].rank = directoryTable[moduleTable[i].directoryIndex].pathEntryIndex;
+                sortedNames[i].index = i;
+        }
+        qsort(sortedNames, moduleCount, sizeof(PLModuleIndexSortedName), PLModuleIndexCompareSortedNames);
+        for (rank = 0; rank < moduleCount; rank++) {
+                if (rank > 0 && PLModuleIndexCompareBytes(sortedNames[rank].bytes, sortedNames[rank].length,
+                                                          sortedNames[rank - 1].bytes, sortedNames[rank - 1].length) == 0) {
+                        continue;
+                }
+                sortedModules[keptCount] = moduleTable[sortedNames[rank].index];
+                sortedModules[keptCount].directoryIndex = directoryRanks[sortedModules[keptCount].directoryIndex];
+                memcpy(sortedExports + keptExportCount,
+                       exportTable + sortedModules[keptCount].firstExport,
+                       sortedModules[keptCount].exportCount * sizeof(PLModuleIndexExport));
+                sortedModules[keptCount].firstExport = keptExportCount;
+                keptExportCount += sortedModules[keptCount].exportCount;
+                keptCount++;
+        }
+
+        memset(&header, 0, sizeof(header));
+        header.magic = PLModuleIndexMagic;
+        header.version = PLModuleIndexVersion;
+        header.pathEntryCount = (uint32_t)[paths count];
+        header.directoryCount = directoryCount;
+        header.moduleCount = keptCount;
+        header.exportCount = keptExportCount;
+        header.poolLength = (uint32_t)[combinedPool length];
+        header.environmentHash = environmentHash;
+
+        indexData = [NSMutableData dataWithCapacity:sizeof(header) + [pathEntryTable length] +
+                     directoryCount * sizeof(PLModuleIndexDirectory) + keptCount * sizeof(PLModuleIndexModule) +
+                     keptExportCount * sizeof(PLModuleIndexExport) + [combinedPool length]];
+        [indexData appendBytes:&header length:sizeof(header)];
+        [indexData appendData:pathEntryTable];
+        [indexData appendBytes:sortedDirectories length:directoryCount * sizeof(PLModuleIndexDirectory)];
+        [indexData appendBytes:sortedModules length:keptCount * sizeof(PLModuleIndexModule)];
+        [indexData appendBytes:sortedExports length:keptExportCount * sizeof(PLModuleIndexExport)];
+        [indexData appendData:combinedPool];
+
+        free(directoryTable);
+        free(sortedDirectories);
+        free(directoryRanks);
+        free(moduleTable);
+        free(sortedModules);
+        free(exportTable);
+        free(sortedExports);
+        free(sortedNames);
+        return indexData;
+}
+
+@end
+
+#pragma mark - Scanning
+
+/**
+ * \brief Add a file of a listed directory as a module.
+ *
+ * \param builder The builder.
+ *
+ * \param path The path of the directory, followed by room for the file name.
+ *
+ * \param pathLength The length of the path of the directory.
+ *
+ * \param moduleName The dotted name of the module.
+ *
+ * \param moduleNameLength The length of the name.
+ *
+ * \param fileName The name of the file, or an empty string for a namespace
+ *                 package.
+ *
+ * \param flags The flags of the module.
+ *
+ * \param directoryIndex The index of the directory in the builder.
+ */
+static void PLModuleIndexAddModule(PLModuleIndexBuilder * builder, char * path, size_t pathLength,
+                                   const char * moduleName, size_t moduleNameLength, const char * fileName,
+                                   uint8_t flags, uint32_t directoryIndex)
+{
+        NSData * contents = nil, * exports = nil;
+        struct stat fileInfo;
+
+        if ((flags & (PLModuleIndexModuleExtension | PLModuleIndexModuleCompiled | PLModuleIndexModuleNamespace)) == 0 &&
+            snprintf(path + pathLength, PATH_MAX - pathLength, "/%s", fileName) < (int)(PATH_MAX - pathLength) &&
+            stat(path, &fileInfo) == 0 && S_ISREG(fileInfo.st_mode) && fileInfo.st_size <= PLModuleIndexMaximumFileSize) {
+                contents = [[NSData alloc] initWithContentsOfFile:[[NSFileManager defaultManager] stringWithFileSystemRepresentation:path
+                                                                                                                              length:strlen(path)]];
+                if (contents) {
+                        exports = PLModuleIndexScanExports(contents);
+                }
+                [contents release];
+        }
+        path[pathLength] = '\0';
+        [builder addModuleNamed:moduleName
+                         length:moduleNameLength
+                       fileName:fileName
+                 fileNameLength:strlen(fileName)
+                          flags:flags
+                 directoryIndex:directoryIndex
+                        exports:exports];
+}
+
+/**
+ * \brief Scan a directory of a path entry and the packages below it.
+ *
+ * \details If the directory has the modification time recorded by the
+ *          previous index, its modules are copied and only the packages the
+ *          previous index found in it are visited. Otherwise it is listed:
+ *          `.py` files, extension modules, and, without a source, compiled
+ *          files are modules; `__init__` makes the directory a package; and
+ *          subdirectories with an `__init__` are scanned as packages. Below
+ *          the path entry itself and namespace packages, subdirectories
+ *          without one are scanned as namespace packages.
+ *
+ * \param builder The builder of the path entry.
+ *
+ * \param previousSnapshot The previous index, prepared with
+ *                         `prepareDirectoryModules`, or nil.
+ *
+ * \param path A buffer of `PATH_MAX` bytes holding the path of the directory.
+ *
+ * \param pathLength The length of the path.
+ *
+ * \param packageName A buffer of `PLModuleIndexMaximumNameLength + 1` bytes
+ *                    holding the dotted name of the package followed by a
+ *                    dot, empty for the path entry.
+ *
+ * \param packageNameLength The length of the package name.
+ *
+ * \param pathEntryIndex The index of the path entry.
+ *
+ * \param depth The number of packages above the directory.
+ */
+static void PLModuleIndexScanDirectory(PLModuleIndexBuilder * builder, PLModuleIndexSnapshot * previousSnapshot,
+                                       char * path, size_t pathLength, char * packageName, size_t packageNameLength,
+                                       uint32_t pathEntryIndex, NSUInteger depth)
+{
+        NSMutableArray * subdirectories = [NSMutableArray array];
+        NSMutableDictionary * moduleFiles = [NSMutableDictionary dictionary];
+        NSMutableDictionary * moduleFlags = [NSMutableDictionary dictionary];
+        const PLModuleIndexDirectory * previousDirectory = NULL;
+        const char * childPath = NULL, * childName = NULL, * fileName = NULL;
+        DIR * directory = NULL;
+        struct dirent * entry = NULL;
+        struct stat directoryInfo, entryInfo;
+        int64_t modificationTime = 0;
+        uint32_t directoryIndex = 0, previousIndex = UINT32_MAX, childIndex = 0;
+        size_t nameLength = 0, stemLength = 0, childNameLength = 0;
+        uint8_t flags = 0, previousFlags = 0;
+        BOOL isPackage = (packageNameLength == 0), isNamespace = NO, childrenMayBeNamespaces = NO;
+        NSString * stem = nil;
+
+        if (depth > PLModuleIndexMaximumDepth || stat(path, &directoryInfo) != 0 || S_ISDIR(directoryInfo.st_mode) == NO) {
+                goto exit;
+        }
+        modificationTime = (int64_t)directoryInfo.st_mtimespec.tv_sec * 1000000000 + directoryInfo.st_mtimespec.tv_nsec;
+        directoryIndex = [builder addDirectoryAtPath:path length:pathLength pathEntryIndex:pathEntryIndex modificationTime:modificationTime];
+
+        if (previousSnapshot != nil) {
+                previousIndex = [previousSnapshot indexOfFirstDirectoryWithPrefix:path length:pathLength];
+                if (previousIndex < previousSnapshot->header->directoryCount &&
+                    PLModuleIndexCompareBytes(previousSnapshot->pool + previousSnapshot->directories[previousIndex].pathOffset,
+                                              previousSnapshot->directories[previousIndex].pathLength, path, pathLength) == 0) {
+                        previousDirectory = &previousSnapshot->directories[previousIndex];
+                }
+        }
+
+        if (previousDirectory != NULL && previousDirectory->modificationTime == modificationTime) {
+                builder.reusedDirectoryCount++;
+                [builder addModulesOfDirectoryAtIndex:previousIndex ofSnapshot:previousSnapshot toDirectoryAtIndex:directoryIndex];
+
+                /* The subdirectories follow the directory, and an unchanged directory has the same ones */
+                path[pathLength] = '/';
+                for (childIndex = previousIndex + 1; childIndex < previousSnapshot->header->directoryCount; childIndex++) {
+                        childPath = previousSnapshot->pool + previousSnapshot->directories[childIndex].pathOffset;
+                        if (previousSnapshot->directories[childIndex].pathLength <= pathLength + 1 || memcmp(childPath, path, pathLength + 1) != 0) {
+                                break;
+                        }
+                        childName = childPath + pathLength + 1;
+                        childNameLength = previousSnapshot->directories[childIndex].pathLength - pathLength - 1;
+                        if (memchr(childName, '/', childNameLength) != NULL ||
+                            pathLength + 1 + childNameLength >= PATH_MAX ||
+                            packageNameLength + childNameLength + 1 > PLModuleIndexMaximumNameLength) {
+                                continue;
+                        }
+                        memcpy(path + pathLength + 1, childName, childNameLength);
+                        path[pathLength + 1 + childNameLength] = '\0';
+                        memcpy(packageName + packageNameLength, childName, childNameLength);
+                        packageName[packageNameLength + childNameLength] = '.';
+                        packageName[packageNameLength + childNameLength + 1] = '\0';
+                        PLModuleIndexScanDirectory(builder, previousSnapshot, path, pathLength + 1 + childNameLength,
+                                                   packageName, packageNameLength + childNameLength + 1, pathEntryIndex, depth + 1);
+                }
+                path[pathLength] = '\0';
+                packageName[packageNameLength] = '\0';
+                goto exit;
+        }
+
+        builder.listedDirectoryCount++;
+        directory = opendir(path);
+        if (directory == NULL) {
+                goto exit;
+        }
+        while ((entry = readdir(directory)) != NULL) {
+                if (entry->d_name[0] == '.' || strcmp(entry->d_name, "__pycache__") == 0) {
+                        continue;
+                }
+                nameLength = strlen(entry->d_name);
+                if (entry->d_type == DT_DIR || entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+                        if (PLModuleIndexIsIdentifier(entry->d_name, nameLength) &&
+                            snprintf(path + pathLength, PATH_MAX - pathLength, "/%s", entry->d_name) < (int)(PATH_MAX - pathLength) &&
+                            stat(path, &entryInfo) == 0 && S_ISDIR(entryInfo.st_mode)) {
+                                [subdirectories addObject:[NSString stringWithUTF8String:entry->d_name]];
+                        }
+                        path[pathLength] = '\0';
+                        if (entry->d_type == DT_DIR) {
+                                continue;
+                        }
+                }
+                flags = 0;
+                stemLength = 0;
+                if (PLModuleIndexHasSuffix(entry->d_name, nameLength, ".py")) {
+                        stemLength = nameLength - 3;
+                } else if (PLModuleIndexHasSuffix(entry->d_name, nameLength, ".so") || PLModuleIndexHasSuffix(entry->d_name, nameLength, ".pyd")) {
+                        stemLength = strcspn(entry->d_name, ".");
+                        flags = PLModuleIndexModuleExtension;
+                } else if (PLModuleIndexHasSuffix(entry->d_name, nameLength, ".pyc")) {
+                        stemLength = nameLength - 4;
+                        flags = PLModuleIndexModuleCompiled;
+                }
+                if (stemLength == 0 || PLModuleIndexIsIdentifier(entry->d_name, stemLength) == NO) {
+                        continue;
+                }
+
+                /* A source is preferred to an extension, and an extension to a compiled file */
+                stem = [[[NSString alloc] initWithBytes:entry->d_name length:stemLength encoding:NSUTF8StringEncoding] autorelease];
+                if (stem == nil) {
+                        continue;
+                }
+                previousFlags = [[moduleFlags objectForKey:stem] unsignedCharValue];
+                if ([moduleFlags objectForKey:stem] == nil || flags < previousFlags) {
+                        [moduleFiles setObject:[NSString stringWithUTF8String:entry->d_name] forKey:stem];
+                        [moduleFlags setObject:@(flags) forKey:stem];
+                }
+        }
+        closedir(directory);
+
+        /* The directory is a package if it has an __init__, or a namespace package if it may be one */
+        if (packageNameLength > 0) {
+                isPackage = ([moduleFiles objectForKey:@"__init__"] != nil);
+                isNamespace = (isPackage == NO);
+                fileName = isPackage ? [[moduleFiles objectForKey:@"__init__"] UTF8String] : "";
+                flags = isPackage ? ([[moduleFlags objectForKey:@"__init__"] unsignedCharValue] | PLModuleIndexModulePackage) : PLModuleIndexModuleNamespace;
+                PLModuleIndexAddModule(builder, path, pathLength, packageName, packageNameLength - 1, fileName, flags, directoryIndex);
+        }
+        [moduleFiles removeObjectForKey:@"__init__"];
+        for (NSString * name in moduleFiles) {
+                nameLength = strlen([name UTF8String]);
+                if (packageNameLength + nameLength > PLModuleIndexMaximumNameLength) {
+                        continue;
+                }
+                memcpy(packageName + packageNameLength, [name UTF8String], nameLength);
+                PLModuleIndexAddModule(builder, path, pathLength, packageName, packageNameLength + nameLength,
+                                       [[moduleFiles objectForKey:name] UTF8String], [[moduleFlags objectForKey:name] unsignedCharValue], directoryIndex);
+        }
+        packageName[packageNameLength] = '\0';
+
+        /* Packages need an __init__, unless namespace packages may be here */
+        childrenMayBeNamespaces = (packageNameLength == 0 || isNamespace);
+        for (NSString * name in subdirectories) {
+                nameLength = strlen([name UTF8String]);
+                if (pathLength + 1 + nameLength + strlen("/__init__.pyc") >= PATH_MAX ||
+                    packageNameLength + nameLength + 1 > PLModuleIndexMaximumNameLength) {
+                        continue;
+                }
+                snprintf(path + pathLength, PATH_MAX - pathLength, "/%s/__init__.py", [name UTF8String]);
+                isPackage = (childrenMayBeNamespaces || access(path, F_OK) == 0);
+                if (isPackage == NO) {
+                        strlcat(path, "c", PATH_MAX);
+                        isPackage = (access(path, F_OK) == 0);
+                }
+                path[pathLength + 1 + nameLength] = '\0';
+                if (isPackage) {
+                        memcpy(packageName + packageNameLength, [name UTF8String], nameLength);
+                        packageName[packageNameLength + nameLength] = '.';
+                        packageName[packageNameLength + nameLength + 1] = '\0';
+                        @autoreleasepool {
+                                PLModuleIndexScanDirectory(builder, previousSnapshot, path, pathLength + 1 + nameLength,
+                                                           packageName, packageNameLength + nameLength + 1, pathEntryIndex, depth + 1);
+                        }
+                }
+                path[pathLength] = '\0';
+                packageName[packageNameLength] = '\0';
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Convert a Python string to an `NSString`.
+ *
+ * \details Must be called while holding the GIL.
+ *
+ * \return The string, or nil if the object is not a string.
+ */
+static NSString * PLModuleIndexStringFromObject(PyObject * object)
+{
+        const char * bytes = NULL;
+
+#if PY_MAJOR_VERSION >= 3
+        bytes = (object != NULL && PyUnicode_Check(object)) ? PyUnicode_AsUTF8(object) : NULL;
+#else
+        bytes = (object != NULL && PyString_Check(object)) ? PyString_AsString(object) : NULL;
+#endif
+        if (bytes == NULL) {
+                PyErr_Clear();
+        }
+        return bytes ? [NSString stringWithUTF8String:bytes] : nil;
+}
+
+/**
+ * \brief Read the path entries and the identity of the environment of the
+ *        interpreter.
+ *
+ * \details Must be called while holding the GIL. Empty and relative entries
+ *          are skipped, as they depend on the current directory, and repeated
+ *          entries are kept once.
+ *
+ * \param environmentHash Set to the hash of `sys.prefix` and the interpreter
+ *                        version.
+ *
+ * \return An array of standardized paths in the order of `sys.path`.
+ */
+static NSArray * PLModuleIndexReadSysPath(uint64_t * environmentHash)
+{
+        PyObject * sysPath = PySys_GetObject((char *)"path");
+        NSString * prefix = PLModuleIndexStringFromObject(PySys_GetObject((char *)"prefix")) ?: @"";
+        NSMutableOrderedSet * paths = [NSMutableOrderedSet orderedSet];
+        const char * version = Py_GetVersion();
+        NSString * path = nil;
+        Py_ssize_t i = 0;
+
+        *environmentHash = PLModuleIndexHash(14695981039346656037ULL, [prefix UTF8String], strlen([prefix UTF8String]) + 1);
+        *environmentHash = PLModuleIndexHash(*environmentHash, version, strlen(version));
+        for (i = 0; sysPath != NULL && PyList_Check(sysPath) && i < PyList_Size(sysPath); i++) {
+                path = PLModuleIndexStringFromObject(PyList_GetItem(sysPath, i));
+                if ([path isAbsolutePath]) {
+                        [paths addObject:[path stringByStandardizingPath]];
+                }
+        }
+        return [paths array];
+}
+
+#pragma mark -
+
+@implementation PLModuleIndex
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                indexQueue = dispatch_queue_create("org.liasis.moduleindex.index", DISPATCH_QUEUE_SERIAL);
+                dispatch_set_target_queue(indexQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0));
+        }
+        return self;
+}
+
++(instancetype)sharedIndex
+{
+        static PLModuleIndex * sharedIndex = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedIndex = [[self alloc] init];
+        });
+        return sharedIndex;
+}
+
+-(void)dealloc
+{
+        [snapshot release];
+        dispatch_release(indexQueue);
+        [super dealloc];
+}
+
+/**
+ * \brief The path of the index file of an environment.
+ *
+ * \details Index files are stored in the application's caches directory and
+ *          named by the environment hash.
+ *
+ * \param environmentHash The hash of `sys.prefix` and the interpreter version.
+ *
+ * \return The path of the index file.
+ */
++(NSString *)indexFilePathForEnvironmentHash:(uint64_t)environmentHash
+{
+        NSString * cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+        NSString * bundleIdentifier = [[NSBundle mainBundle] bundleIdentifier] ?: @"Liasis";
+
+        return [[[cachesPath stringByAppendingPathComponent:bundleIdentifier]
+                 stringByAppendingPathComponent:@"ModuleIndex"]
+                stringByAppendingPathComponent:[NSString stringWithFormat:@"%016llx.plmodules", environmentHash]];
+}
+
+#pragma mark - Snapshots
+
+-(PLModuleIndexSnapshot *)currentSnapshot
+{
+        PLModuleIndexSnapshot * currentSnapshot = nil;
+
+        @synchronized(self) {
+                currentSnapshot = [[snapshot retain] autorelease];
+        }
+        return currentSnapshot;
+}
+
+/**
+ * \brief Replace the current snapshot and notify observers on the main queue.
+ *
+ * \param newSnapshot The new snapshot.
+ */
+-(void)setSnapshot:(PLModuleIndexSnapshot *)newSnapshot
+{
+        @synchronized(self) {
+                [newSnapshot retain];
+                [snapshot release];
+                snapshot = newSnapshot;
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+                [[NSNotificationCenter defaultCenter] postNotificationName:PLModuleIndexDidUpdateNotification object:self];
+        });
+}
+
+/**
+ * \brief Memory map the index file of an environment.
+ *
+ * \param environmentHash The environment hash.
+ *
+ * \return The snapshot of the file, or nil if it does not exist or is not a
+ *         valid index of the environment.
+ */
+-(PLModuleIndexSnapshot *)snapshotOfEnvironmentHash:(uint64_t)environmentHash
+{
+        NSData * indexData = [NSData dataWithContentsOfFile:[[self class] indexFilePathForEnvironmentHash:environmentHash]
+                                                    options:NSDataReadingMappedAlways
+                                                      error:NULL];
+        PLModuleIndexSnapshot * persistedSnapshot = nil;
+
+        if (indexData) {
+                persistedSnapshot = [[[PLModuleIndexSnapshot alloc] initWithData:indexData] autorelease];
+        }
+        if (persistedSnapshot != nil && persistedSnapshot->header->environmentHash != environmentHash) {
+                persistedSnapshot = nil;
+        }
+        return persistedSnapshot;
+}
+
+-(BOOL)isReady
+{
+        return [self currentSnapshot] != nil;
+}
+
+-(NSUInteger)numberOfModules
+{
+        PLModuleIndexSnapshot * currentSnapshot = [self currentSnapshot];
+
+        return currentSnapshot ? currentSnapshot->header->moduleCount : 0;
+}
+
+#pragma mark - Building and Updating
+
+-(void)open
+{
+        NSString * environment = [[NSUserDefaults standardUserDefaults] stringForKey:PLModuleIndexEnvironmentDefault];
+
+        if (opened) {
+                goto exit;
+        }
+        opened = YES;
+        if (environment != nil) {
+                dispatch_async(indexQueue, ^{
+                        PLModuleIndexSnapshot * persistedSnapshot = nil;
+                        CFTimeInterval startTime = CACurrentMediaTime();
+
+                        @autoreleasepool {
+                                persistedSnapshot = [self snapshotOfEnvironmentHash:strtoull([environment UTF8String], NULL, 16)];
+                                if (persistedSnapshot != nil && [self currentSnapshot] == nil) {
+                                        [self setSnapshot:persistedSnapshot];
+                                }
+                                if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                                        NSLog(@"Module index: opened %u modules in %.2f ms",
+                                              persistedSnapshot ? persistedSnapshot->header->moduleCount : 0,
+                                              (CACurrentMediaTime() - startTime) * 1000.0);
+                                }
+                        }
+                });
+        }
+        [self update];
+
+exit:
+        return;
+}
+
+-(void)update
+{
+        [[PLPythonRuntime sharedRuntime] whenReady:^{
+                dispatch_async(indexQueue, ^{
+                        __block NSArray * paths = nil;
+                        __block uint64_t environmentHash = 0;
+
+                        @autoreleasepool {
+                                [[PLPythonRuntime sharedRuntime] performWithGIL:^{
+                                        paths = [PLModuleIndexReadSysPath(&environmentHash) retain];
+                                }];
+                                if (paths) {
+                                        [self updateWithPaths:paths environmentHash:environmentHash];
+                                }
+                                [paths release];
+                        }
+                });
+        }];
+}
+
+/**
+ * \brief Scan the path entries of an environment, reusing the directories
+ *        that did not change since its index was written.
+ *
+ * \details This method runs on `indexQueue`. The path entries are scanned
+ *          concurrently. If nothing changed, the index file is left as it is.
+ *
+ * \param paths The path entries, in order.
+ *
+ * \param environmentHash The environment hash.
+ */
+-(void)updateWithPaths:(NSArray *)paths environmentHash:(uint64_t)environmentHash
+{
+        PLModuleIndexSnapshot * previousSnapshot = [self currentSnapshot], * newSnapshot = nil;
+        NSMutableArray * builders = [NSMutableArray arrayWithCapacity:[paths count]];
+        NSString * indexFilePath = [[self class] indexFilePathForEnvironmentHash:environmentHash];
+        NSData * indexData = nil;
+        CFTimeInterval startTime = CACurrentMediaTime();
+        NSUInteger listedCount = 0, reusedCount = 0, i = 0;
+        const PLModuleIndexPathEntry * pathEntry = NULL;
+        const char * pathRepresentation = NULL;
+        BOOL changed = NO;
+
+        if (previousSnapshot == nil || previousSnapshot->header->environmentHash != environmentHash) {
+                previousSnapshot = [self snapshotOfEnvironmentHash:environmentHash];
+                if (previousSnapshot != nil) {
+                        [self setSnapshot:previousSnapshot];
+                }
+        }
+        [previousSnapshot prepareDirectoryModules];
+        for (i = 0; i < [paths count]; i++) {
+                [builders addObject:[[[PLModuleIndexBuilder alloc] init] autorelease]];
+        }
+
+        dispatch_apply([paths count], dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t pathIndex) {
+                char path[PATH_MAX], packageName[PLModuleIndexMaximumNameLength + 1];
+
+                @autoreleasepool {
+                        if (strlcpy(path, [[paths objectAtIndex:pathIndex] fileSystemRepresentation], sizeof(path)) < sizeof(path)) {
+                                packageName[0] = '\0';
+                                PLModuleIndexScanDirectory([builders objectAtIndex:pathIndex], previousSnapshot,
+                                                           path, strlen(path), packageName, 0, (uint32_t)pathIndex, 0);
+                        }
+                }
+        });
+
+        for (PLModuleIndexBuilder * builder in builders) {
+                listedCount += builder.listedDirectoryCount;
+                reusedCount += builder.reusedDirectoryCount;
+        }
+        changed = (previousSnapshot == nil || listedCount > 0 ||
+                   reusedCount != previousSnapshot->header->directoryCount ||
+                   [paths count] != previousSnapshot->header->pathEntryCount);
+        for (i = 0; changed == NO && i < [paths count]; i++) {
+                pathEntry = &previousSnapshot->pathEntries[i];
+                pathRepresentation = [[paths objectAtIndex:i] fileSystemRepresentation];
+                changed = (PLModuleIndexCompareBytes(previousSnapshot->pool + pathEntry->pathOffset, pathEntry->pathLength,
+                                                     pathRepresentation, strlen(pathRepresentation)) != 0);
+        }
+
+        if (changed) {
+                indexData = [PLModuleIndexBuilder dataWithBuilders:builders paths:paths environmentHash:environmentHash];
+                newSnapshot = [[[PLModuleIndexSnapshot alloc] initWithData:indexData] autorelease];
+                [self setSnapshot:newSnapshot];
+                [[NSFileManager defaultManager] createDirectoryAtPath:[indexFilePath stringByDeletingLastPathComponent]
+                                          withIntermediateDirectories:YES
+                                                           attributes:nil
+                                                                error:NULL];
+                [indexData writeToFile:indexFilePath atomically:YES];
+        }
+        [[NSUserDefaults standardUserDefaults] setObject:[NSString stringWithFormat:@"%016llx", environmentHash]
+                                                  forKey:PLModuleIndexEnvironmentDefault];
+
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Module index: scanned %lu path entries in %.2f ms, listing %lu directories and reusing %lu, %u modules",
+                      (unsigned long)[paths count],
+                      (CACurrentMediaTime() - startTime) * 1000.0,
+                      (unsigned long)listedCount,
+                      (unsigned long)reusedCount,
+                      [self currentSnapshot] ? [self currentSnapshot]->header->moduleCount : 0);
+        }
+}
+
+#pragma mark - Queries
+
+-(BOOL)hasModuleNamed:(NSString *)moduleName
+{
+        PLModuleIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        const char * name = [moduleName UTF8String];
+
+        return (currentSnapshot != nil && name != NULL &&
+                [currentSnapshot indexOfModuleNamed:name length:strlen(name)] != UINT32_MAX);
+}
+
+-(NSString *)pathOfModuleNamed:(NSString *)moduleName
+{
+        PLModuleIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        const char * name = [moduleName UTF8String];
+        const PLModuleIndexModule * module = NULL;
+        const PLModuleIndexDirectory * directory = NULL;
+        NSString * path = nil;
+        uint32_t moduleIndex = UINT32_MAX;
+
+        if (currentSnapshot == nil || name == NULL) {
+                goto exit;
+        }
+        moduleIndex = [currentSnapshot indexOfModuleNamed:name length:strlen(name)];
+        if (moduleIndex == UINT32_MAX) {
+                goto exit;
+        }
+        module = &currentSnapshot->modules[moduleIndex];
+        directory = &currentSnapshot->directories[module->directoryIndex];
+        path = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:currentSnapshot->pool + directory->pathOffset
+                                                                           length:directory->pathLength];
+        if (module->fileLength > 0) {
+                path = [path stringByAppendingPathComponent:[[NSFileManager defaultManager] stringWithFileSystemRepresentation:currentSnapshot->pool + module->fileOffset
+                                                                                                                       length:module->fileLength]];
+        }
+
+exit:
+        return path;
+}
+
+-(NSArray *)modulesWithPrefix:(NSString *)prefix maximumCount:(NSUInteger)maximumCount
+{
+        PLModuleIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        NSMutableArray * moduleNames = [NSMutableArray array];
+        const char * prefixBytes = [prefix UTF8String];
+        const PLModuleIndexModule * module = NULL;
+        size_t prefixLength = 0;
+        uint32_t moduleIndex = 0;
+
+        if (currentSnapshot == nil || prefixBytes == NULL) {
+                goto exit;
+        }
+        prefixLength = strlen(prefixBytes);
+        for (moduleIndex = [currentSnapshot indexOfFirstModuleWithPrefix:prefixBytes length:prefixLength];
+             moduleIndex < currentSnapshot->header->moduleCount && [moduleNames count] < maximumCount;
+             moduleIndex++) {
+                module = &currentSnapshot->modules[moduleIndex];
+                if (module->nameLength < prefixLength || memcmp(currentSnapshot->pool + module->nameOffset, prefixBytes, prefixLength) != 0) {
+                        break;
+                }
+                [moduleNames addObject:[[[NSString alloc] initWithBytes:currentSnapshot->pool + module->nameOffset
+                                                                 length:module->nameLength
+                                                               encoding:NSUTF8StringEncoding] autorelease]];
+        }
+
+exit:
+        return moduleNames;
+}
+
+-(NSArray *)membersOfModuleNamed:(NSString *)moduleName
+{
+        PLModuleIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        NSMutableOrderedSet * members = [NSMutableOrderedSet orderedSet];
+        NSString * submodulePrefix = [moduleName stringByAppendingString:@"."];
+        const char * name = [moduleName UTF8String], * prefix = [submodulePrefix UTF8String], * memberName = NULL;
+        const PLModuleIndexModule * module = NULL;
+        const PLModuleIndexExport * export = NULL;
+        size_t prefixLength = 0, memberLength = 0;
+        uint32_t moduleIndex = UINT32_MAX, i = 0;
+
+        if (currentSnapshot == nil || name == NULL || prefix == NULL) {
+                goto exit;
+        }
+        moduleIndex = [currentSnapshot indexOfModuleNamed:name length:strlen(name)];
+        if (moduleIndex == UINT32_MAX) {
+                goto exit;
+        }
+        module = &currentSnapshot->modules[moduleIndex];
+        for (i = 0; i < module->exportCount; i++) {
+                export = &currentSnapshot->exports[module->firstExport + i];
+                [members addObject:[[[NSString alloc] initWithBytes:currentSnapshot->pool + export->nameOffset
+                                                             length:export->nameLength
+                                                           encoding:NSUTF8StringEncoding] autorelease] ?: @""];
+        }
+
+        /* The submodules follow the module, their own submodules among them */
+        prefixLength = strlen(prefix);
+        for (moduleIndex = [currentSnapshot indexOfFirstModuleWithPrefix:prefix length:prefixLength];
+             moduleIndex < currentSnapshot->header->moduleCount;
+             moduleIndex++) {
+                module = &currentSnapshot->modules[moduleIndex];
+                if (module->nameLength <= prefixLength || memcmp(currentSnapshot->pool + module->nameOffset, prefix, prefixLength) != 0) {
+                        break;
+                }
+                memberName = currentSnapshot->pool + module->nameOffset + prefixLength;
+                memberLength = module->nameLength - prefixLength;
+                if (memchr(memberName, '.', memberLength) == NULL) {
+                        [members addObject:[[[NSString alloc] initWithBytes:memberName
+                                                                     length:memberLength
+                                                                   encoding:NSUTF8StringEncoding] autorelease] ?: @""];
+                }
+        }
+        [members removeObject:@""];
+
+exit:
+        return [members array];
+}
+
+-(void)enumerateModuleNamesUsingBlock:(void (^)(const char * name, size_t length))block
+{
+        PLModuleIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        uint32_t moduleIndex = 0;
+
+        for (moduleIndex = 0; currentSnapshot != nil && moduleIndex < currentSnapshot->header->moduleCount; moduleIndex++) {
+                block(currentSnapshot->pool + currentSnapshot->modules[moduleIndex].nameOffset,
+                      currentSnapshot->modules[moduleIndex].nameLength);
+        }
+}
+
+@end
@@ -0,0 +1,195 @@
+/**
+ * \file PLPythonRuntime.h
+ *
+ * \brief Liasis Python IDE embedded Python runtime.
+ *
+ * \details This file includes the object that owns the lifetime of the
+ *          embedded Python interpreter.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief Posted on the main queue once the interpreter has been initialized.
+ *
+ * \details The notification object is the runtime.
+ */
+extern NSString * const PLPythonRuntimeDidBecomeReadyNotification;
+
+/**
+ * \brief The states of the embedded interpreter.
+ */
+typedef NS_ENUM(NSInteger, PLPythonRuntimeState) {
+        /**
+         * \brief The interpreter has not been started.
+         */
+        PLPythonRuntimeStateStopped = 0,
+
+        /**
+         * \brief The interpreter is being initialized on the runtime thread.
+         */
+        PLPythonRuntimeStateStarting,
+
+        /**
+         * \brief The interpreter is initialized and the GIL is free.
+         */
+        PLPythonRuntimeStateReady,
+
+        /**
+         * \brief The interpreter has been finalized, or the runtime was shut
+         *        down before it was started.
+         */
+        PLPythonRuntimeStateFinished
+};
+
+/**
+ * \class PLPythonRuntime \headerfile \headerfile
+ *
+ * \brief Owns the embedded Python interpreter.
+ *
+ * \details The interpreter is initialized lazily on a dedicated thread, so
+ *          neither launching the application nor the first window waits for
+ *          interpreter startup and the site imports. The thread initializes the
+ *          interpreter, releases the GIL, and then sleeps until shutdown, when
+ *          it reacquires the GIL and finalizes the interpreter. Initialization
+ *          and finalization therefore always happen on the same thread, off
+ *          the main thread.
+ *
+ *          Code using the interpreter must first wait for it to become ready
+ *          with `whenReady:` or `waitUntilReady`, and must hold the GIL while
+ *          calling into Python, for example with `performWithGIL:`. Both
+ *          start the interpreter if it was not started yet.
+ */
+@interface PLPythonRuntime : NSObject
+{
+        /**
+         * \brief The thread that initializes and finalizes the interpreter.
+         */
+        NSThread * runtimeThread;
+
+        /**
+         * \brief Guards `state` and wakes the runtime thread for shutdown.
+         */
+        NSCondition * condition;
+
+        /**
+         * \brief Entered when the interpreter is started and left once it is
+         *        ready, serving as the ready future.
+         */
+        dispatch_group_t readyGroup;
+
+        /**
+         * \brief YES once shutdown has been requested.
+         */
+        BOOL shutdownRequested;
+
+        /**
+         * \brief The time it took to initialize the interpreter in seconds.
+         */
+        NSTimeInterval initializationDuration;
+}
+
+/**
+ * \brief The state of the interpreter.
+ */
+@property (readonly) PLPythonRuntimeState state;
+
+/**
+ * \brief The shared runtime.
+ *
+ * \return The runtime of the application.
+ */
++(instancetype)sharedRuntime;
+
+/**
+ * \brief Start initializing the interpreter in the background.
+ *
+ * \details Does nothing if the interpreter was already started or has been
+ *          shut down.
+ */
+-(void)start;
+
+/**
+ * \brief Determine if the interpreter is ready.
+ *
+ * \return YES if the interpreter is initialized and not shut down.
+ */
+-(BOOL)isReady;
+
+/**
+ * \brief Call a block on the main queue once the interpreter is ready.
+ *
+ * \details Starts the interpreter if needed. The block is called
+ *          asynchronously even if the interpreter is already ready. The block
+ *          is never called if the runtime is shut down before it becomes ready.
+ *
+ * \param block The block to call.
+ */
+-(void)whenReady:(void (^)(void))block;
+
+/**
+ * \brief Block the calling thread until the interpreter is ready.
+ *
+ * \details Starts the interpreter if needed. Must not be called from the
+ *          runtime thread.
+ *
+ * \return YES if the interpreter is ready, or NO if it was shut down.
+ */
+-(BOOL)waitUntilReady;
+
+/**
+ * \brief Call a block on the calling thread while holding the GIL.
+ *
+ * \details Waits until the interpreter is ready first. The GIL is acquired
+ *          with `PyGILState_Ensure`, so the block may be called from any
+ *          thread, including one that already holds the GIL.
+ *
+ * \param block The block to call.
+ *
+ * \return YES if the block was called, or NO if the interpreter was shut down.
+ */
+-(BOOL)performWithGIL:(void (^)(void))block;
+
+/**
+ * \brief Finalize the interpreter on the runtime thread.
+ *
+ * \details The calling thread waits until the interpreter is finalized or the
+ *          limit passes, so shutdown can not hang application termination.
+ *          Afterwards, the runtime can not be started again.
+ *
+ * \param limit The latest date to wait until.
+ *
+ * \return YES if the interpreter was finalized, or was never started, before
+ *         `limit`.
+ */
+-(BOOL)shutdownBeforeDate:(NSDate *)limit;
+
+/**
+ * \brief The time it took to initialize the interpreter.
+ *
+ * \return The duration in seconds, or 0 if the interpreter is not ready.
+ */
+-(NSTimeInterval)initializationDuration;
+
+@end
@@ -0,0 +1,221 @@
+/**
+ * \file PLPythonRuntime.m
+ *
+ * \brief Liasis Python IDE embedded Python runtime.
+ *
+ * \details This file includes the object that owns the lifetime of the
+ *          embedded Python interpreter.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Python/Python.h>
+#import "PLPythonRuntime.h"
+#import "PLLaunchTimeline.h"
+
+NSString * const PLPythonRuntimeDidBecomeReadyNotification = @"PLPythonRuntimeDidBecomeReadyNotification";
+
+/**
+ * \brief The stack size of the runtime thread in bytes.
+ *
+ * \details The default stack of secondary threads is too small for the
+ *          recursion limit of the interpreter.
+ */
+static const NSUInteger PLPythonRuntimeThreadStackSize = 8 * 1024 * 1024;
+
+@interface PLPythonRuntime ()
+
+@property (readwrite) PLPythonRuntimeState state;
+
+@end
+
+@implementation PLPythonRuntime
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                condition = [[NSCondition alloc] init];
+                readyGroup = dispatch_group_create();
+                _state = PLPythonRuntimeStateStopped;
+        }
+        return self;
+}
+
++(instancetype)sharedRuntime
+{
+        static PLPythonRuntime * sharedRuntime = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedRuntime = [[self alloc] init];
+        });
+        return sharedRuntime;
+}
+
+-(void)dealloc
+{
+        [runtimeThread release];
+        [condition release];
+        dispatch_release(readyGroup);
+        [super dealloc];
+}
+
+#pragma mark - Starting
+
+-(void)start
+{
+        [condition lock];
+        if (_state == PLPythonRuntimeStateStopped && shutdownRequested == NO) {
+                _state = PLPythonRuntimeStateStarting;
+                dispatch_group_enter(readyGroup);
+                runtimeThread = [[NSThread alloc] initWithTarget:self selector:@selector(runInterpreter) object:nil];
+                [runtimeThread setName:@"org.liasis.python"];
+                [runtimeThread setStackSize:PLPythonRuntimeThreadStackSize];
+                [runtimeThread start];
+        }
+        [condition unlock];
+}
+
+/**
+ * \brief The body of the runtime thread.
+ *
+ * \details Initialize the interpreter without installing signal handlers,
+ *          release the GIL, and wait for shutdown. On shutdown, reacquire the
+ *          GIL and finalize the interpreter.
+ */
+-(void)runInterpreter
+{
+        PyThreadState * threadState = NULL;
+        CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+
+        @autoreleasepool {
+                [[PLLaunchTimeline sharedTimeline] beginPhase:@"python interpreter"];
+                Py_InitializeEx(0);
+                PyEval_InitThreads();
+                threadState = PyEval_SaveThread();
+                [[PLLaunchTimeline sharedTimeline] endPhase:@"python interpreter"];
+
+                [condition lock];
+                initializationDuration = CFAbsoluteTimeGetCurrent() - startTime;
+                self.state = PLPythonRuntimeStateReady;
+                [condition broadcast];
+                [condition unlock];
+                dispatch_group_leave(readyGroup);
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        [[NSNotificationCenter defaultCenter] postNotificationName:PLPythonRuntimeDidBecomeReadyNotification
+                                                                            object:self];
+                });
+
+                [condition lock];
+                while (shutdownRequested == NO) {
+                        [condition wait];
+                }
+                [condition unlock];
+
+                PyEval_RestoreThread(threadState);
+                Py_Finalize();
+
+                [condition lock];
+                self.state = PLPythonRuntimeStateFinished;
+                [condition broadcast];
+                [condition unlock];
+        }
+}
+
+#pragma mark - Waiting
+
+-(BOOL)isReady
+{
+        return self.state == PLPythonRuntimeStateReady;
+}
+
+-(void)whenReady:(void (^)(void))block
+{
+        [self start];
+        dispatch_group_notify(readyGroup, dispatch_get_main_queue(), ^{
+                if ([self isReady]) {
+                        block();
+                }
+        });
+}
+
+-(BOOL)waitUntilReady
+{
+        [self start];
+        dispatch_group_wait(readyGroup, DISPATCH_TIME_FOREVER);
+        return [self isReady];
+}
+
+-(BOOL)performWithGIL:(void (^)(void))block
+{
+        PyGILState_STATE gilState;
+        BOOL performed = NO;
+
+        if ([self waitUntilReady] == NO) {
+                goto exit;
+        }
+        gilState = PyGILState_Ensure();
+        block();
+        PyGILState_Release(gilState);
+        performed = YES;
+
+exit:
+        return performed;
+}
+
+-(NSTimeInterval)initializationDuration
+{
+        NSTimeInterval duration = 0.0;
+
+        [condition lock];
+        if (_state == PLPythonRuntimeStateReady) {
+                duration = initializationDuration;
+        }
+        [condition unlock];
+        return duration;
+}
+
+#pragma mark - Shutdown
+
+-(BOOL)shutdownBeforeDate:(NSDate *)limit
+{
+        BOOL finished = NO;
+
+        [condition lock];
+        shutdownRequested = YES;
+        if (_state == PLPythonRuntimeStateStopped) {
+                _state = PLPythonRuntimeStateFinished;
+        }
+        [condition broadcast];
+        while (_state != PLPythonRuntimeStateFinished) {
+                if ([condition waitUntilDate:limit] == NO) {
+                        break;
+                }
+        }
+        finished = (_state == PLPythonRuntimeStateFinished);
+        [condition unlock];
+        return finished;
+}
+
+@end
@@ -0,0 +1,155 @@
+/**
+ * \file PLSessionManager.h
+ *
+ * \brief Liasis Python IDE session manager.
+ *
+ * \details This file includes the object that records the open windows and
+ *          tabs so they can be restored on the next launch.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+#import "PLSessionWindow.h"
+
+@class PLWindowController;
+
+/**
+ * \class PLSessionManager \headerfile \headerfile
+ *
+ * \brief Records a snapshot of the open windows so that they can be restored
+ *        on the next launch.
+ *
+ * \details The snapshot is a compact binary file in the application support
+ *          directory holding a `PLSessionWindow` for each registered
+ *          `PLWindowController`, in registration order.
+ *
+ *          Changes are coalesced for a second. Only the windows that changed
+ *          are captured and encoded again; the encodings of the others are
+ *          reused. The file is then written atomically on a background queue,
+ *          so a crash never leaves a partial snapshot.
+ *
+ *          The manager must only be used from the main thread.
+ */
+@interface PLSessionManager : NSObject
+{
+        /**
+         * \brief The registered window controllers, in registration order.
+         */
+        NSMutableArray * windowControllers;
+
+        /**
+         * \brief The encoded `PLSessionWindow` of each registered window
+         *        controller, keyed by the window controller wrapped in a
+         *        nonretained `NSValue`.
+         */
+        NSMutableDictionary * encodedWindows;
+
+        /**
+         * \brief The window controllers that changed since they were last
+         *        encoded, wrapped in nonretained `NSValue` objects.
+         */
+        NSMutableSet * changedWindowControllers;
+
+        /**
+         * \brief The serial queue writing the snapshot file.
+         */
+        dispatch_queue_t writeQueue;
+
+        /**
+         * \brief YES while a coalesced save is scheduled.
+         */
+        BOOL saveScheduled;
+
+        /**
+         * \brief YES while saving is suspended.
+         */
+        BOOL suspended;
+}
+
+/**
+ * \brief The shared session manager.
+ *
+ * \return The session manager of the application.
+ */
++(instancetype)sharedSessionManager;
+
+/**
+ * \brief The path of the snapshot file.
+ *
+ * \return The path of the snapshot file in the application support directory.
+ */
++(NSString *)sessionFilePath;
+
+/**
+ * \brief Read the windows of the last snapshot.
+ *
+ * \return An array of `PLSessionWindow` objects, empty if there is no
+ *         snapshot or it could not be read.
+ */
+-(NSArray *)restoredWindows;
+
+/**
+ * \brief Start recording a window controller.
+ *
+ * \param windowController The window controller.
+ */
+-(void)addWindowController:(PLWindowController *)windowController;
+
+/**
+ * \brief Stop recording a window controller and schedule a save.
+ *
+ * \param windowController The window controller.
+ */
+-(void)removeWindowController:(PLWindowController *)windowController;
+
+/**
+ * \brief Schedule a save after the state of a window controller changed.
+ *
+ * \details Does nothing if the window controller is not registered.
+ *
+ * \param windowController The window controller.
+ */
+-(void)windowControllerDidChange:(PLWindowController *)windowController;
+
+/**
+ * \brief Capture every registered window controller and write the snapshot
+ *        before returning.
+ *
+ * \details Does nothing while saving is suspended.
+ */
+-(void)saveSession;
+
+/**
+ * \brief Stop saving the snapshot.
+ *
+ * \details Used while the application terminates, so that closing its windows
+ *          does not remove them from the snapshot.
+ */
+-(void)suspend;
+
+/**
+ * \brief Resume saving the snapshot and schedule a save.
+ */
+-(void)resume;
+
+@end
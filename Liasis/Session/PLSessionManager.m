@@ -0,0 +1,465 @@
+/**
+ * \file PLSessionManager.m
+ *
+ * \brief Liasis Python IDE session manager.
+ *
+ * \details This file includes the object that records the open windows and
+ *          tabs so they can be restored on the next launch.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLSessionManager.h"
+#import "PLWindowController.h"
+
+/**
+ * \brief The first four bytes of a snapshot file ("PLSS").
+ */
+static const uint32_t PLSessionManagerMagic = 0x53534C50;
+
+/**
+ * \brief The version of the snapshot file format.
+ */
+static const uint32_t PLSessionManagerVersion = 1;
+
+/**
+ * \brief The time in seconds that changes are coalesced before the snapshot is
+ *        written.
+ */
+static const NSTimeInterval PLSessionManagerSaveDelay = 1.0;
+
+#pragma mark - File Format
+
+/*
+ * A snapshot file is the header followed by the windows. All values are in
+ * host byte order, and strings are a 32-bit byte count followed by UTF-8.
+ *
+ *      header: magic, version, window count (32-bit each)
+ *      window: frame (4 doubles), file browser root (string),
+ *              expanded path count (32-bit), expanded paths (strings),
+ *              tab count (32-bit), active tab index (32-bit, UINT32_MAX if
+ *              none), tabs
+ *      tab:    file path (string), selection location and length (64-bit
+ *              each, location UINT64_MAX if none), scroll position (2 doubles)
+ */
+
+/**
+ * \brief The position of a decoder in the bytes of a snapshot.
+ */
+typedef struct {
+        const uint8_t * bytes;
+        NSUInteger length;
+        NSUInteger offset;
+        BOOL failed;
+} PLSessionReader;
+
+static void PLSessionAppendUInt32(NSMutableData * data, uint32_t value)
+{
+        [data appendBytes:&value length:sizeof(value)];
+}
+
+static void PLSessionAppendUInt64(NSMutableData * data, uint64_t value)
+{
+        [data appendBytes:&value length:sizeof(value)];
+}
+
+static void PLSessionAppendDouble(NSMutableData * data, double value)
+{
+        [data appendBytes:&value length:sizeof(value)];
+}
+
+static void PLSessionAppendString(NSMutableData * data, NSString * string)
+{
+        const char * utf8 = [string UTF8String] ?: "";
+        uint32_t length = (uint32_t)strlen(utf8);
+
+        PLSessionAppendUInt32(data, length);
+        [data appendBytes:utf8 length:length];
+}
+
+/**
+ * \brief Copy bytes out of a snapshot, marking the reader as failed if the
+ *        snapshot is too short.
+ *
+ * \return YES if the bytes were copied.
+ */
+static BOOL PLSessionRead(PLSessionReader * reader, void * value, NSUInteger length)
+{
+        if (reader->failed || reader->length - reader->offset < length) {
+                reader->failed = YES;
+                memset(value, 0, length);
+                goto exit;
+        }
+        memcpy(value, reader->bytes + reader->offset, length);
+        reader->offset += length;
+
+exit:
+        return reader->failed == NO;
+}
+
+static uint32_t PLSessionReadUInt32(PLSessionReader * reader)
+{
+        uint32_t value = 0;
+        PLSessionRead(reader, &value, sizeof(value));
+        return value;
+}
+
+static uint64_t PLSessionReadUInt64(PLSessionReader * reader)
+{
+        uint64_t value = 0;
+        PLSessionRead(reader, &value, sizeof(value));
+        return value;
+}
+
+static double PLSessionReadDouble(PLSessionReader * reader)
+{
+        double value = 0.0;
+        PLSessionRead(reader, &value, sizeof(value));
+        return value;
+}
+
+static NSString * PLSessionReadString(PLSessionReader * reader)
+{
+        NSString * string = nil;
+        uint32_t length = PLSessionReadUInt32(reader);
+
+        if (reader->failed || reader->length - reader->offset < length) {
+                reader->failed = YES;
+                goto exit;
+        }
+        string = [[[NSString alloc] initWithBytes:reader->bytes + reader->offset
+                                           length:length
+                                         encoding:NSUTF8StringEncoding] autorelease];
+        reader->offset += length;
+        if (string == nil) {
+                reader->failed = YES;
+        }
+
+exit:
+        return string;
+}
+
+/**
+ * \brief Read a count, failing if it could not fit in the rest of the
+ *        snapshot.
+ *
+ * \param minimumSize The minimum encoded size of each counted element.
+ */
+static uint32_t PLSessionReadCount(PLSessionReader * reader, NSUInteger minimumSize)
+{
+        uint32_t count = PLSessionReadUInt32(reader);
+
+        if (reader->failed == NO && (uint64_t)count * minimumSize > reader->length - reader->offset) {
+                reader->failed = YES;
+                count = 0;
+        }
+        return count;
+}
+
+static NSData * PLSessionEncodeWindow(PLSessionWindow * window)
+{
+        NSMutableData * data = [NSMutableData data];
+
+        PLSessionAppendDouble(data, window.frame.origin.x);
+        PLSessionAppendDouble(data, window.frame.origin.y);
+        PLSessionAppendDouble(data, window.frame.size.width);
+        PLSessionAppendDouble(data, window.frame.size.height);
+        PLSessionAppendString(data, window.directoryRootPath);
+        PLSessionAppendUInt32(data, (uint32_t)[window.expandedPaths count]);
+        for (NSString * path in window.expandedPaths) {
+                PLSessionAppendString(data, path);
+        }
+        PLSessionAppendUInt32(data, (uint32_t)[window.tabs count]);
+        PLSessionAppendUInt32(data, window.activeTabIndex == NSNotFound ? UINT32_MAX : (uint32_t)window.activeTabIndex);
+        for (PLSessionTab * tab in window.tabs) {
+                PLSessionAppendString(data, [tab.fileURL path]);
+                PLSessionAppendUInt64(data, tab.selectedRange.location == NSNotFound ? UINT64_MAX : tab.selectedRange.location);
+                PLSessionAppendUInt64(data, tab.selectedRange.length);
+                PLSessionAppendDouble(data, tab.scrollPosition.x);
+                PLSessionAppendDouble(data, tab.scrollPosition.y);
+        }
+        return data;
+}
+
+static PLSessionWindow * PLSessionDecodeWindow(PLSessionReader * reader)
+{
+        PLSessionWindow * window = [PLSessionWindow window];
+        NSMutableArray * expandedPaths = [NSMutableArray array], * tabs = [NSMutableArray array];
+        PLSessionTab * tab = nil;
+        NSString * path = nil;
+        NSRect frame = NSZeroRect;
+        NSPoint scrollPosition = NSZeroPoint;
+        uint64_t location = 0, length = 0;
+        uint32_t count = 0, index = 0, activeTabIndex = 0;
+
+        frame.origin.x = PLSessionReadDouble(reader);
+        frame.origin.y = PLSessionReadDouble(reader);
+        frame.size.width = PLSessionReadDouble(reader);
+        frame.size.height = PLSessionReadDouble(reader);
+        window.frame = frame;
+        window.directoryRootPath = PLSessionReadString(reader);
+
+        count = PLSessionReadCount(reader, sizeof(uint32_t));
+        for (index = 0; index < count && reader->failed == NO; index++) {
+                path = PLSessionReadString(reader);
+                if (path) {
+                        [expandedPaths addObject:path];
+                }
+        }
+        window.expandedPaths = expandedPaths;
+
+        count = PLSessionReadCount(reader, sizeof(uint32_t) + 2 * sizeof(uint64_t) + 2 * sizeof(double));
+        activeTabIndex = PLSessionReadUInt32(reader);
+        for (index = 0; index < count && reader->failed == NO; index++) {
+                path = PLSessionReadString(reader);
+                location = PLSessionReadUInt64(reader);
+                length = PLSessionReadUInt64(reader);
+                tab = [PLSessionTab tabWithFileURL:path ? [NSURL fileURLWithPath:path] : nil];
+                tab.selectedRange = location == UINT64_MAX ? NSMakeRange(NSNotFound, 0) : NSMakeRange((NSUInteger)location, (NSUInteger)length);
+                scrollPosition.x = PLSessionReadDouble(reader);
+                scrollPosition.y = PLSessionReadDouble(reader);
+                tab.scrollPosition = scrollPosition;
+                [tabs addObject:tab];
+        }
+        window.tabs = tabs;
+        window.activeTabIndex = activeTabIndex < [tabs count] ? activeTabIndex : NSNotFound;
+
+        return reader->failed ? nil : window;
+}
+
+#pragma mark -
+
+@implementation PLSessionManager
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                windowControllers = [[NSMutableArray alloc] init];
+                encodedWindows = [[NSMutableDictionary alloc] init];
+                changedWindowControllers = [[NSMutableSet alloc] init];
+                writeQueue = dispatch_queue_create("org.liasis.session.write", DISPATCH_QUEUE_SERIAL);
+        }
+        return self;
+}
+
++(instancetype)sharedSessionManager
+{
+        static PLSessionManager * sharedSessionManager = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedSessionManager = [[self alloc] init];
+        });
+        return sharedSessionManager;
+}
+
+-(void)dealloc
+{
+        [windowControllers release];
+        [encodedWindows release];
+        [changedWindowControllers release];
+        dispatch_release(writeQueue);
+        [super dealloc];
+}
+
++(NSString *)sessionFilePath
+{
+        NSString * applicationSupportPath = [NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES) firstObject];
+        NSString * bundleIdentifier = [[NSBundle mainBundle] bundleIdentifier] ?: @"Liasis";
+
+        return [[applicationSupportPath stringByAppendingPathComponent:bundleIdentifier]
+                stringByAppendingPathComponent:@"Session.plsession"];
+}
+
+#pragma mark - Restoring
+
+-(NSArray *)restoredWindows
+{
+        NSMutableArray * windows = [NSMutableArray array];
+        NSData * data = nil;
+        PLSessionReader reader;
+        PLSessionWindow * window = nil;
+        uint32_t windowCount = 0, index = 0;
+
+        data = [NSData dataWithContentsOfFile:[[self class] sessionFilePath]
+                                      options:NSDataReadingMappedIfSafe
+                                        error:NULL];
+        if (data == nil) {
+                goto exit;
+        }
+
+        reader.bytes = [data bytes];
+        reader.length = [data length];
+        reader.offset = 0;
+        reader.failed = NO;
+        if (PLSessionReadUInt32(&reader) != PLSessionManagerMagic ||
+            PLSessionReadUInt32(&reader) != PLSessionManagerVersion) {
+                goto exit;
+        }
+        windowCount = PLSessionReadCount(&reader, 4 * sizeof(double) + 4 * sizeof(uint32_t));
+        for (index = 0; index < windowCount; index++) {
+                window = PLSessionDecodeWindow(&reader);
+                if (window == nil) {
+                        NSLog(@"Error: the session snapshot is damaged; %lu of %u windows were restored.",
+                              (unsigned long)[windows count], windowCount);
+                        break;
+                }
+                [windows addObject:window];
+        }
+
+exit:
+        return windows;
+}
+
+#pragma mark - Recording
+
+-(void)addWindowController:(PLWindowController *)windowController
+{
+        if ([windowControllers containsObject:windowController] == NO) {
+                [windowControllers addObject:windowController];
+                [self windowControllerDidChange:windowController];
+        }
+}
+
+-(void)removeWindowController:(PLWindowController *)windowController
+{
+        NSValue * key = [NSValue valueWithNonretainedObject:windowController];
+
+        if ([windowControllers containsObject:windowController]) {
+                [encodedWindows removeObjectForKey:key];
+                [changedWindowControllers removeObject:key];
+                [windowControllers removeObject:windowController];
+                [self scheduleSave];
+        }
+}
+
+-(void)windowControllerDidChange:(PLWindowController *)windowController
+{
+        if ([windowControllers containsObject:windowController]) {
+                [changedWindowControllers addObject:[NSValue valueWithNonretainedObject:windowController]];
+                [self scheduleSave];
+        }
+}
+
+#pragma mark - Saving
+
+/**
+ * \brief Write the snapshot after `PLSessionManagerSaveDelay` seconds unless a
+ *        save is already scheduled.
+ */
+-(void)scheduleSave
+{
+        if (saveScheduled || suspended) {
+                goto exit;
+        }
+        saveScheduled = YES;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(PLSessionManagerSaveDelay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+                saveScheduled = NO;
+                [self writeSnapshotAndWait:NO];
+        });
+
+exit:
+        return;
+}
+
+/**
+ * \brief Capture the changed windows and write the snapshot.
+ *
+ * \details Capturing reads the state of the windows, so it happens on the main
+ *          thread. Assembling and writing the file happen on `writeQueue`.
+ *
+ * \param wait YES to return only after the file was written.
+ */
+-(void)writeSnapshotAndWait:(BOOL)wait
+{
+        NSMutableArray * windowData = nil;
+        NSString * sessionFilePath = [[self class] sessionFilePath];
+        NSValue * key = nil;
+        NSData * encodedWindow = nil;
+        dispatch_block_t writeBlock = nil;
+
+        if (suspended) {
+                goto exit;
+        }
+
+        windowData = [NSMutableArray arrayWithCapacity:[windowControllers count]];
+        for (PLWindowController * windowController in windowControllers) {
+                key = [NSValue valueWithNonretainedObject:windowController];
+                encodedWindow = [encodedWindows objectForKey:key];
+                if (encodedWindow == nil || [changedWindowControllers containsObject:key]) {
+                        encodedWindow = PLSessionEncodeWindow([windowController sessionWindow]);
+                        [encodedWindows setObject:encodedWindow forKey:key];
+                }
+                [windowData addObject:encodedWindow];
+        }
+        [changedWindowControllers removeAllObjects];
+
+        writeBlock = ^{
+                NSMutableData * data = [NSMutableData data];
+                NSError * error = nil;
+
+                PLSessionAppendUInt32(data, PLSessionManagerMagic);
+                PLSessionAppendUInt32(data, PLSessionManagerVersion);
+                PLSessionAppendUInt32(data, (uint32_t)[windowData count]);
+                for (NSData * windowBytes in windowData) {
+                        [data appendData:windowBytes];
+                }
+                if ([[NSFileManager defaultManager] createDirectoryAtPath:[sessionFilePath stringByDeletingLastPathComponent]
+                                              withIntermediateDirectories:YES
+                                                               attributes:nil
+                                                                    error:&error] == NO ||
+                    [data writeToFile:sessionFilePath options:NSDataWritingAtomic error:&error] == NO) {
+                        NSLog(@"Error: the session snapshot could not be written: %@", [error localizedDescription]);
+                }
+        };
+        if (wait) {
+                dispatch_sync(writeQueue, writeBlock);
+        } else {
+                dispatch_async(writeQueue, writeBlock);
+        }
+
+exit:
+        return;
+}
+
+-(void)saveSession
+{
+        for (PLWindowController * windowController in windowControllers) {
+                [changedWindowControllers addObject:[NSValue valueWithNonretainedObject:windowController]];
+        }
+        [self writeSnapshotAndWait:YES];
+}
+
+-(void)suspend
+{
+        suspended = YES;
+}
+
+-(void)resume
+{
+        suspended = NO;
+        [self scheduleSave];
+}
+
+@end
@@ -0,0 +1,112 @@
+/**
+ * \file PLSessionWindow.h
+ *
+ * \brief Liasis Python IDE session windows and tabs.
+ *
+ * \details This file includes the objects describing the windows and tabs
+ *          recorded in a session snapshot.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+
+/**
+ * \class PLSessionTab \headerfile \headerfile
+ *
+ * \brief A tab of a document recorded in a session snapshot.
+ */
+@interface PLSessionTab : NSObject
+
+/**
+ * \brief The URL of the tab's document.
+ */
+@property (copy) NSURL * fileURL;
+
+/**
+ * \brief The selected range of the tab's text, with a location of `NSNotFound`
+ *        if the tab has no text selection.
+ */
+@property NSRange selectedRange;
+
+/**
+ * \brief The origin of the visible rectangle of the tab's scrolled text.
+ */
+@property NSPoint scrollPosition;
+
+/**
+ * \brief Create a tab without a selection or scroll position.
+ *
+ * \param fileURL The URL of the tab's document.
+ *
+ * \return A tab on the autorelease pool.
+ */
++(instancetype)tabWithFileURL:(NSURL *)fileURL;
+
+@end
+
+/**
+ * \class PLSessionWindow \headerfile \headerfile
+ *
+ * \brief A window recorded in a session snapshot.
+ *
+ * \details Only tabs whose documents are saved to a file are recorded; tabs of
+ *          untitled documents and tabs owned by the application, such as the
+ *          project search results, are not.
+ */
+@interface PLSessionWindow : NSObject
+
+/**
+ * \brief The frame of the window in screen coordinates.
+ */
+@property NSRect frame;
+
+/**
+ * \brief The root directory of the window's file browser.
+ */
+@property (copy) NSString * directoryRootPath;
+
+/**
+ * \brief The paths of the expanded items of the file browser, parents before
+ *        their children.
+ */
+@property (copy) NSArray * expandedPaths;
+
+/**
+ * \brief The `PLSessionTab` objects of the window, in tab bar order.
+ */
+@property (copy) NSArray * tabs;
+
+/**
+ * \brief The index of the active tab in `tabs`, or `NSNotFound` if none of the
+ *        recorded tabs is active.
+ */
+@property NSUInteger activeTabIndex;
+
+/**
+ * \brief Create an empty window.
+ *
+ * \return A window on the autorelease pool.
+ */
++(instancetype)window;
+
+@end
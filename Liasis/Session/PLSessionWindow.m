@@ -0,0 +1,87 @@
+/**
+ * \file PLSessionWindow.m
+ *
+ * \brief Liasis Python IDE session windows and tabs.
+ *
+ * \details This file includes the objects describing the windows and tabs
+ *          recorded in a session snapshot.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLSessionWindow.h"
+
+@implementation PLSessionTab
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                _selectedRange = NSMakeRange(NSNotFound, 0);
+                _scrollPosition = NSZeroPoint;
+        }
+        return self;
+}
+
++(instancetype)tabWithFileURL:(NSURL *)fileURL
+{
+        PLSessionTab * tab = [[self alloc] init];
+        tab.fileURL = fileURL;
+        return [tab autorelease];
+}
+
+-(void)dealloc
+{
+        [_fileURL release];
+        [super dealloc];
+}
+
+@end
+
+@implementation PLSessionWindow
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                _frame = NSZeroRect;
+                _expandedPaths = [[NSArray alloc] init];
+                _tabs = [[NSArray alloc] init];
+                _activeTabIndex = NSNotFound;
+        }
+        return self;
+}
+
++(instancetype)window
+{
+        return [[[self alloc] init] autorelease];
+}
+
+-(void)dealloc
+{
+        [_directoryRootPath release];
+        [_expandedPaths release];
+        [_tabs release];
+        [super dealloc];
+}
+
+@end
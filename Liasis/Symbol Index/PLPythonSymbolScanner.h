@@ -0,0 +1,122 @@
+/**
+ * \file PLPythonSymbolScanner.h
+ *
+ * \brief Liasis Python IDE Python symbol scanner.
+ *
+ * \details This file includes the scanner extracting the definitions, imports,
+ *          and references of Python source for the symbol index.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief The kind of a symbol.
+ */
+typedef NS_ENUM(uint8_t, PLPythonSymbolKind) {
+        /**
+         * \brief The name of a class statement.
+         */
+        PLPythonSymbolClass,
+
+        /**
+         * \brief The name of a def statement.
+         */
+        PLPythonSymbolFunction,
+
+        /**
+         * \brief A name assigned at the start of a top level statement.
+         */
+        PLPythonSymbolVariable,
+
+        /**
+         * \brief The dotted name of a module imported by an import or from
+         *        statement, with the leading dots of a relative import.
+         */
+        PLPythonSymbolImport,
+
+        /**
+         * \brief Any other name used in code, including attribute names.
+         */
+        PLPythonSymbolReference,
+
+        /**
+         * \brief The number of symbol kinds.
+         */
+        PLPythonSymbolKindCount
+};
+
+/**
+ * \brief A symbol of Python source.
+ */
+typedef struct {
+        /**
+         * \brief The range of the name in the source.
+         */
+        NSRange range;
+
+        /**
+         * \brief The number of the line of the name, starting at 1.
+         */
+        NSUInteger line;
+
+        /**
+         * \brief The kind of the symbol.
+         */
+        PLPythonSymbolKind kind;
+
+        /**
+         * \brief YES if the symbol is in an unindented statement, that is, a
+         *        definition or import of the module itself.
+         */
+        BOOL topLevel;
+} PLPythonSymbol;
+
+/**
+ * \brief The block called with each symbol of the source.
+ *
+ * \param characters The characters of the source.
+ *
+ * \param symbol The symbol. Only valid during the call.
+ */
+typedef void (^PLPythonSymbolHandler)(const unichar * characters, const PLPythonSymbol * symbol);
+
+/**
+ * \brief Extract the symbols of Python source.
+ *
+ * \details The source is lexed line by line with `PLPythonLexLine`, so names
+ *          in strings and comments are never reported, and the names between
+ *          the tokens of each line are classified with a few rules rather
+ *          than a parse: a definition is the name after `class` or `def`, a
+ *          variable is a name followed by `=` at the start of an unindented
+ *          statement, and an import is the module of an import or from
+ *          statement. This is enough to index a project without running the
+ *          interpreter, and may be called from any thread.
+ *
+ * \param characters The characters of the source.
+ *
+ * \param length The number of characters.
+ *
+ * \param handler The block called with each symbol, in order.
+ */
+void PLPythonScanSymbols(const unichar * characters, NSUInteger length, PLPythonSymbolHandler handler);
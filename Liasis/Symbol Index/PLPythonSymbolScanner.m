@@ -0,0 +1,213 @@
+/**
+ * \file PLPythonSymbolScanner.m
+ *
+ * \brief Liasis Python IDE Python symbol scanner.
+ *
+ * \details This file includes the scanner extracting the definitions, imports,
+ *          and references of Python source for the symbol index.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLPythonSymbolScanner.h"
+#import "PLPythonLexer.h"
+
+/**
+ * \brief The part of an import statement a line is in.
+ */
+typedef NS_ENUM(uint8_t, PLPythonImportMode) {
+        /**
+         * \brief The line is not an import statement.
+         */
+        PLPythonImportNone,
+
+        /**
+         * \brief After `import`, where modules are separated by commas.
+         */
+        PLPythonImportModules,
+
+        /**
+         * \brief After the `from` of a from statement, before its `import`.
+         */
+        PLPythonImportFromModule,
+
+        /**
+         * \brief After the `import` of a from statement, among the imported
+         *        names.
+         */
+        PLPythonImportFromNames
+};
+
+/**
+ * \brief Return if a character may start a name.
+ *
+ * \details Characters outside ASCII are accepted, as in the lexer.
+ */
+static inline BOOL PLPythonSymbolIsNameStart(unichar character)
+{
+        return character == '_' || (unichar)((character | 0x20) - 'a') < 26 || character >= 0x80;
+}
+
+/**
+ * \brief Return if a character may continue a name.
+ */
+static inline BOOL PLPythonSymbolIsNameCharacter(unichar character)
+{
+        return PLPythonSymbolIsNameStart(character) || (unichar)(character - '0') < 10;
+}
+
+/**
+ * \brief Return if a range of characters is an ASCII word.
+ */
+static BOOL PLPythonSymbolIsWord(const unichar * characters, NSRange range, const char * word)
+{
+        NSUInteger index = 0;
+        BOOL equal = (strlen(word) == range.length);
+
+        for (index = 0; equal && index < range.length; index++) {
+                equal = (characters[range.location + index] == (unichar)word[index]);
+        }
+        return equal;
+}
+
+/**
+ * \brief Return if the name ending at an index is followed by an assignment.
+ *
+ * \details Augmented assignments and comparisons are not assignments.
+ */
+static BOOL PLPythonSymbolIsAssigned(const unichar * characters, NSUInteger index, NSUInteger end)
+{
+        while (index < end && (characters[index] == ' ' || characters[index] == '\t')) {
+                index++;
+        }
+        return index < end && characters[index] == '=' && (index + 1 == end || characters[index + 1] != '=');
+}
+
+void PLPythonScanSymbols(const unichar * characters, NSUInteger length, PLPythonSymbolHandler handler)
+{
+        PLPythonLexerState state = PLPythonLexerInitialState;
+        PLPythonImportMode importMode = PLPythonImportNone;
+        PLPythonToken * tokens = NULL;
+        PLPythonToken token;
+        PLPythonSymbol symbol;
+        NSUInteger tokenCapacity = 0, tokenCount = 0, tokenIndex = 0;
+        NSUInteger lineStart = 0, lineEnd = 0, contentEnd = 0, indentEnd = 0, index = 0, gapEnd = 0, start = 0;
+        BOOL startsStatement = NO, continued = NO, first = NO, expectsModule = NO, skipsAlias = NO;
+        unichar character = 0;
+
+        memset(&symbol, 0, sizeof(symbol));
+        while (lineStart < length) {
+                symbol.line++;
+                for (lineEnd = lineStart; lineEnd < length && characters[lineEnd] != '\n'; lineEnd++);
+                contentEnd = (lineEnd > lineStart && characters[lineEnd - 1] == '\r') ? lineEnd - 1 : lineEnd;
+                if (contentEnd - lineStart > tokenCapacity) {
+                        tokenCapacity = MAX(contentEnd - lineStart, 2 * tokenCapacity);
+                        tokens = realloc(tokens, tokenCapacity * sizeof(PLPythonToken));
+                }
+                startsStatement = (state.string == PLPythonStringNone && state.nesting == 0 && continued == NO);
+                state = PLPythonLexLine(characters + lineStart, contentEnd - lineStart, state, tokens, &tokenCount);
+                for (indentEnd = lineStart; indentEnd < contentEnd && (characters[indentEnd] == ' ' || characters[indentEnd] == '\t'); indentEnd++);
+                symbol.topLevel = (startsStatement && indentEnd == lineStart);
+                importMode = PLPythonImportNone;
+                expectsModule = NO;
+                skipsAlias = NO;
+                continued = NO;
+                first = startsStatement;
+                tokenIndex = 0;
+                index = lineStart;
+
+                while (index < contentEnd) {
+                        gapEnd = (tokenIndex < tokenCount) ? lineStart + tokens[tokenIndex].location : contentEnd;
+
+                        /* Keywords and definitions are tokens */
+                        if (index == gapEnd) {
+                                token = tokens[tokenIndex];
+                                token.location += lineStart;
+                                if (token.kind == PLPythonTokenKeyword) {
+                                        if (first && PLPythonSymbolIsWord(characters, NSMakeRange(token.location, token.length), "import")) {
+                                                importMode = PLPythonImportModules;
+                                                expectsModule = YES;
+                                        } else if (first && PLPythonSymbolIsWord(characters, NSMakeRange(token.location, token.length), "from")) {
+                                                importMode = PLPythonImportFromModule;
+                                                expectsModule = YES;
+                                        } else if (importMode == PLPythonImportFromModule &&
+                                                   PLPythonSymbolIsWord(characters, NSMakeRange(token.location, token.length), "import")) {
+                                                importMode = PLPythonImportFromNames;
+                                                expectsModule = NO;
+                                        } else if (importMode != PLPythonImportNone &&
+                                                   PLPythonSymbolIsWord(characters, NSMakeRange(token.location, token.length), "as")) {
+                                                skipsAlias = YES;
+                                        }
+                                } else if (token.kind == PLPythonTokenClassName || token.kind == PLPythonTokenFunctionName) {
+                                        symbol.range = NSMakeRange(token.location, token.length);
+                                        symbol.kind = (token.kind == PLPythonTokenClassName) ? PLPythonSymbolClass : PLPythonSymbolFunction;
+                                        handler(characters, &symbol);
+                                }
+                                first = NO;
+                                index = token.location + token.length;
+                                tokenIndex++;
+                                continue;
+                        }
+
+                        /* Names, modules, and punctuation are between them */
+                        character = characters[index];
+                        if (expectsModule && (character == '.' || PLPythonSymbolIsNameStart(character))) {
+                                start = index;
+                                while (index < gapEnd && (characters[index] == '.' || PLPythonSymbolIsNameCharacter(characters[index]))) {
+                                        index++;
+                                }
+                                symbol.range = NSMakeRange(start, index - start);
+                                symbol.kind = PLPythonSymbolImport;
+                                handler(characters, &symbol);
+                                expectsModule = NO;
+                                first = NO;
+                        } else if (PLPythonSymbolIsNameStart(character)) {
+                                start = index;
+                                while (index < gapEnd && PLPythonSymbolIsNameCharacter(characters[index])) {
+                                        index++;
+                                }
+                                if (skipsAlias) {
+                                        skipsAlias = NO;
+                                } else if (importMode != PLPythonImportFromNames) {
+                                        symbol.range = NSMakeRange(start, index - start);
+                                        symbol.kind = PLPythonSymbolReference;
+                                        if (first && symbol.topLevel && PLPythonSymbolIsAssigned(characters, index, contentEnd)) {
+                                                symbol.kind = PLPythonSymbolVariable;
+                                        }
+                                        handler(characters, &symbol);
+                                }
+                                first = NO;
+                        } else {
+                                if (character == ',' && importMode == PLPythonImportModules) {
+                                        expectsModule = YES;
+                                } else if (character == '\\' && index + 1 == contentEnd) {
+                                        continued = YES;
+                                } else if (character != ' ' && character != '\t') {
+                                        first = NO;
+                                }
+                                index++;
+                        }
+                }
+                lineStart = lineEnd + 1;
+        }
+        free(tokens);
+}
@@ -0,0 +1,100 @@
+/**
+ * \file PLSymbolIndex+Private.h
+ *
+ * \brief Liasis Python IDE project symbol index private interface.
+ *
+ * \details This file declares the snapshot and builder of the index, and the
+ *          methods of the index used by its implementation and unit tests.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLSymbolIndex.h"
+
+/**
+ * \class PLSymbolIndexSnapshot
+ *
+ * \brief An immutable symbol index, either memory mapped from an index file or
+ *        built in memory in the same format.
+ */
+@interface PLSymbolIndexSnapshot : NSObject
+
+-(instancetype)initWithData:(NSData *)indexData rootPath:(NSString *)rootPath;
+
+-(NSString *)relativePathOfFileAtIndex:(uint32_t)fileIndex;
+
+-(NSString *)nameAtIndex:(uint32_t)nameIndex;
+
+-(uint32_t)indexOfName:(const char *)name length:(size_t)length;
+
+-(uint32_t)indexOfFirstNameWithPrefix:(const char *)prefix length:(size_t)length;
+
+@end
+
+/**
+ * \class PLSymbolIndexBuilder
+ *
+ * \brief Accumulates files and their symbols and produces index data.
+ *
+ * \details Names are interned in an open addressing hash table over the pool,
+ *          so adding the millions of symbols of a large project creates no
+ *          objects.
+ */
+@interface PLSymbolIndexBuilder : NSObject
+
+-(instancetype)initWithRootPath:(NSString *)path;
+
+-(uint32_t)fileCount;
+
+-(uint32_t)addFileAtPath:(NSString *)relativePath contentHash:(uint64_t)contentHash modificationTime:(int64_t)modificationTime size:(uint64_t)size;
+
+-(void)addSymbolNamed:(const char *)name length:(size_t)length fileIndex:(uint32_t)fileIndex line:(uint32_t)line kind:(uint8_t)kind flags:(uint8_t)flags;
+
+-(void)addScannedSymbols:(NSData *)symbols fileIndex:(uint32_t)fileIndex;
+
+-(NSData *)dataWithLastEventIdentifier:(uint64_t)lastEventIdentifier eventHistoryIdentifier:(NSString *)eventHistoryIdentifier;
+
+@end
+
+@interface PLSymbolIndex ()
+
+/**
+ * \brief The open indexes, keyed by project directory.
+ */
++(NSMutableDictionary *)sharedIndexes;
+
+/**
+ * \brief The path of the index file of a project directory.
+ */
++(NSString *)indexFilePathForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Initialize an index of a project directory without opening it.
+ */
+-(instancetype)initWithDirectoryPath:(NSString *)path;
+
+/**
+ * \brief Replace the contents of the index.
+ */
+-(void)setSnapshot:(PLSymbolIndexSnapshot *)newSnapshot;
+
+@end
@@ -0,0 +1,296 @@
+/**
+ * \file PLSymbolIndex.h
+ *
+ * \brief Liasis Python IDE project symbol index.
+ *
+ * \details This file includes the persistent index of the definitions,
+ *          imports, and references of the Python files below a project
+ *          directory.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+#import "PLFileSystemWatcher.h"
+#import "PLPythonSymbolScanner.h"
+
+@class PLSymbolIndexSnapshot;
+
+/**
+ * \brief Posted on the main queue when the contents of a symbol index change.
+ *
+ * \details The notification object is the `PLSymbolIndex`.
+ */
+extern NSString * const PLSymbolIndexDidUpdateNotification;
+
+/**
+ * \brief Posted on the main queue when a symbol index is evicted, once the last
+ *        client of its directory released it.
+ *
+ * \details The notification object is the `PLSymbolIndex`.
+ */
+extern NSString * const PLSymbolIndexDidCloseNotification;
+
+/**
+ * \class PLSymbolLocation \headerfile \headerfile
+ *
+ * \brief A symbol found in a symbol index.
+ */
+@interface PLSymbolLocation : NSObject
+
+/**
+ * \brief The name of the symbol.
+ */
+@property (retain, readonly) NSString * name;
+
+/**
+ * \brief The full path of the file of the symbol.
+ */
+@property (retain, readonly) NSString * path;
+
+/**
+ * \brief The number of the line of the symbol, starting at 1. For references,
+ *        the first line of the file using the name.
+ */
+@property (readonly) NSUInteger line;
+
+/**
+ * \brief The kind of the symbol.
+ */
+@property (readonly) PLPythonSymbolKind kind;
+
+/**
+ * \brief YES if the symbol is in an unindented statement of its file.
+ */
+@property (readonly, getter=isTopLevel) BOOL topLevel;
+
+/**
+ * \brief Create a symbol location.
+ *
+ * \param name The name of the symbol.
+ *
+ * \param path The full path of the file of the symbol.
+ *
+ * \param line The line number of the symbol.
+ *
+ * \param kind The kind of the symbol.
+ *
+ * \param topLevel YES if the symbol is in an unindented statement.
+ *
+ * \return A symbol location on the autorelease pool.
+ */
++(instancetype)locationWithName:(NSString *)name path:(NSString *)path line:(NSUInteger)line kind:(PLPythonSymbolKind)kind topLevel:(BOOL)topLevel;
+
+@end
+
+/**
+ * \class PLSymbolIndex \headerfile \headerfile
+ *
+ * \brief A persistent, incrementally updated index of the symbols of the
+ *        Python files below a project directory.
+ *
+ * \details Files are scanned with `PLPythonScanSymbols` on a background
+ *          queue, many at a time, without the interpreter. The index records
+ *          each file with the hash of its contents, and every name with where
+ *          it is defined or imported and the files using it, grouped by name
+ *          in a case insensitive order. It is stored in a
+ *          single file in the user's caches directory and memory mapped when
+ *          it is opened, like a `PLProjectIndex`, so an index built in a
+ *          previous session is queried immediately and no symbol is held in
+ *          objects.
+ *
+ *          The index is kept current by a `PLFileSystemWatcher`. Only the
+ *          directories reported by the watcher are listed again, and of their
+ *          files only those whose size or modification time changed are read.
+ *          A file read again is only scanned if no indexed file had the same
+ *          contents, so touching, moving, or checking out unchanged files
+ *          reuses their symbols. The rest of the index is copied from the
+ *          previous snapshot.
+ *
+ *          Queries binary search the names, so their cost depends on the
+ *          number of results and not the size of the project, and may be made
+ *          from any thread.
+ */
+@interface PLSymbolIndex : NSObject
+{
+        /**
+         * \brief The current contents of the index.
+         *
+         * \details Snapshots are immutable. Updates build a new snapshot and
+         *          replace this one.
+         */
+        PLSymbolIndexSnapshot * snapshot;
+
+        /**
+         * \brief The serial queue on which the index is built and updated.
+         */
+        dispatch_queue_t indexQueue;
+
+        /**
+         * \brief The watcher reporting changes below the project directory.
+         */
+        PLFileSystemWatcher * watcher;
+
+        /**
+         * \brief YES if the index is scheduled to be written to disk.
+         */
+        BOOL saveScheduled;
+
+        /**
+         * \brief YES once the index was evicted, so it is not watched again.
+         */
+        BOOL closed;
+}
+
+/**
+ * \brief The project directory.
+ */
+@property (retain, readonly) NSString * directoryPath;
+
+/**
+ * \brief Get the symbol index of a project directory.
+ *
+ * \details Indexes are shared by all windows. The first call for a directory
+ *          opens the persisted index, if any, and starts building or updating
+ *          it in the background. The index is kept until the last client
+ *          registered with `retainIndexForDirectoryAtPath:` releases it.
+ *
+ * \param directoryPath The project directory.
+ *
+ * \return The symbol index.
+ */
++(instancetype)indexForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Register a client of the symbol index of a project directory, such as
+ *        a window showing the directory.
+ *
+ * \details Does not open the index.
+ *
+ * \param directoryPath The project directory.
+ */
++(void)retainIndexForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Unregister a client of the symbol index of a project directory.
+ *
+ * \details When the last client is unregistered, the index stops watching the
+ *          directory, is dropped from the shared indexes, and posts
+ *          `PLSymbolIndexDidCloseNotification`, so its memory mapped file is
+ *          unmapped once the queries holding it finish. Must be called on the
+ *          main thread.
+ *
+ * \param directoryPath The project directory.
+ */
++(void)releaseIndexForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Determine if a symbol index of a directory was persisted in a
+ *        previous session.
+ *
+ * \param directoryPath The project directory.
+ *
+ * \return YES if an index file exists for the directory.
+ */
++(BOOL)hasPersistentIndexForDirectoryAtPath:(NSString *)directoryPath;
+
+/**
+ * \brief Determine if the index can be queried.
+ *
+ * \return YES if the index has been opened or built.
+ */
+-(BOOL)isReady;
+
+/**
+ * \brief The number of files in the index.
+ *
+ * \return The number of Python files indexed.
+ */
+-(NSUInteger)numberOfFiles;
+
+/**
+ * \brief Find the classes, functions, and variables defined with a name.
+ *
+ * \param name The name, matched exactly.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \return An array of `PLSymbolLocation`s, classes first, then functions,
+ *         then variables, with top level definitions first in each.
+ */
+-(NSArray *)definitionsOfSymbolNamed:(NSString *)name maximumCount:(NSUInteger)maximumCount;
+
+/**
+ * \brief Find the files using a name.
+ *
+ * \param name The name, matched exactly.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \return An array of `PLSymbolLocation`s of the first use of the name in
+ *         each file.
+ */
+-(NSArray *)referencesToSymbolNamed:(NSString *)name maximumCount:(NSUInteger)maximumCount;
+
+/**
+ * \brief Find the import and from statements importing a module.
+ *
+ * \param moduleName The dotted name of the module as written in the
+ *                   statement, matched exactly.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \return An array of `PLSymbolLocation`s.
+ */
+-(NSArray *)importsOfModuleNamed:(NSString *)moduleName maximumCount:(NSUInteger)maximumCount;
+
+/**
+ * \brief Find the definitions whose names begin with a prefix, for workspace
+ *        symbol search.
+ *
+ * \param prefix The prefix, matched ignoring the case of ASCII letters.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \return An array of `PLSymbolLocation`s ordered by name, each name's
+ *         definitions in the order of
+ *         `definitionsOfSymbolNamed:maximumCount:`.
+ */
+-(NSArray *)definitionsWithPrefix:(NSString *)prefix maximumCount:(NSUInteger)maximumCount;
+
+/**
+ * \brief Call a block with each name defined in the index, for building
+ *        other indexes from it.
+ *
+ * \details The names are enumerated on the calling thread from the current
+ *          contents of the index, in the order of
+ *          `definitionsWithPrefix:maximumCount:`, without creating objects.
+ *
+ * \param block The block, called with the UTF-8 bytes of the name and their
+ *              number, the kind and scope of the first definition of the
+ *              name in the order of `definitionsOfSymbolNamed:maximumCount:`,
+ *              and the number of files using the name. The bytes are only
+ *              valid during the call.
+ */
+-(void)enumerateDefinedNamesUsingBlock:(void (^)(const char * name, size_t length, PLPythonSymbolKind kind, BOOL topLevel, NSUInteger referenceCount))block;
+
+@end
@@ -0,0 +1,1831 @@
+/**
+ * \file PLSymbolIndex.m
+ *
+ * \brief Liasis Python IDE project symbol index.
+ *
+ * \details This file includes the persistent index of the definitions,
+ *          imports, and references of the Python files below a project
+ *          directory.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <QuartzCore/QuartzCore.h>
+#import "PLSymbolIndex.h"
+#import "PLSymbolIndex+Private.h"
+#import "PLUserDefaults.h"
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+NSString * const PLSymbolIndexDidUpdateNotification = @"PLSymbolIndexDidUpdateNotification";
+
+NSString * const PLSymbolIndexDidCloseNotification = @"PLSymbolIndexDidCloseNotification";
+
+/**
+ * \brief The first four bytes of an index file ("PLSX").
+ */
+static const uint32_t PLSymbolIndexMagic = 0x58534C50;
+
+/**
+ * \brief The version of the index file format.
+ */
+static const uint32_t PLSymbolIndexVersion = 1;
+
+/**
+ * \brief The maximum number of files indexed below a directory.
+ */
+static const NSUInteger PLSymbolIndexMaximumFileCount = 200000;
+
+/**
+ * \brief The size above which a file is not indexed.
+ *
+ * \details Files this large are generated rather than written, and would
+ *          only add names no one looks up.
+ */
+static const off_t PLSymbolIndexMaximumFileSize = 4 * 1024 * 1024;
+
+/**
+ * \brief The length in bytes above which a name is not indexed.
+ */
+static const NSUInteger PLSymbolIndexMaximumNameLength = 255;
+
+/**
+ * \brief The number of files read and scanned in parallel before their
+ *        symbols are added to the index.
+ *
+ * \details This bounds the memory held by scanned symbols.
+ */
+static const NSUInteger PLSymbolIndexScanBatchSize = 256;
+
+/**
+ * \brief The time in seconds that file system changes are coalesced before the
+ *        index is updated.
+ */
+static const NSTimeInterval PLSymbolIndexWatcherLatency = 1.0;
+
+/**
+ * \brief The time in seconds after an update before the index is written to
+ *        disk.
+ */
+static const NSTimeInterval PLSymbolIndexSaveDelay = 5.0;
+
+/**
+ * \brief The flag of an entry in an unindented statement.
+ */
+static const uint8_t PLSymbolIndexEntryTopLevel = 1 << 0;
+
+#pragma mark - File Format
+
+/**
+ * \brief The header of an index file.
+ *
+ * \details The header is followed by the file table, the name table, the entry
+ *          table, and the string pool. The string pool begins with the root
+ *          path.
+ */
+typedef struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t fileCount;
+        uint32_t nameCount;
+        uint32_t entryCount;
+        uint32_t poolLength;
+        uint32_t rootPathLength;
+        uint32_t reserved;
+        uint64_t lastEventIdentifier;
+        char eventHistoryIdentifier[48];
+} PLSymbolIndexHeader;
+
+/**
+ * \brief A file in the index: its path relative to the root, stored in the
+ *        pool, and what it was indexed from.
+ */
+typedef struct {
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint64_t contentHash;
+        int64_t modificationTime;
+        uint64_t size;
+} PLSymbolIndexFile;
+
+/**
+ * \brief A name, stored in the pool, and the range of its entries.
+ *
+ * \details Names are ordered by `PLSymbolIndexCompareNames`.
+ */
+typedef struct {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t firstEntry;
+        uint32_t entryCount;
+} PLSymbolIndexName;
+
+/**
+ * \brief An occurrence of a name.
+ *
+ * \details The entries of a name are ordered by kind, then top level entries
+ *          first, then by file and line. A file has at most one reference
+ *          entry per name.
+ */
+typedef struct {
+        uint32_t fileIndex;
+        uint32_t line;
+        uint8_t kind;
+        uint8_t flags;
+        uint16_t reserved;
+} PLSymbolIndexEntry;
+
+/**
+ * \brief The record of a symbol of a scanned file, followed by the bytes of its
+ *        name.
+ */
+typedef struct {
+        uint32_t line;
+        uint8_t kind;
+        uint8_t flags;
+        uint8_t nameLength;
+        uint8_t reserved;
+} PLSymbolIndexScannedSymbol;
+
+#pragma mark - Names
+
+/**
+ * \brief Compute the 64-bit FNV-1a hash of bytes.
+ */
+static uint64_t PLSymbolIndexHash(const void * bytes, size_t length)
+{
+        const uint8_t * characters = bytes;
+        uint64_t hash = 14695981039346656037ULL;
+        size_t i = 0;
+
+        for (i = 0; i < length; i++) {
+                hash ^= characters[i];
+                hash *= 1099511628211ULL;
+        }
+        return hash;
+}
+
+/**
+ * \brief Lowercase an ASCII character, leaving other bytes unchanged.
+ */
+static inline uint8_t PLSymbolIndexLowercase(uint8_t character)
+{
+        return (character >= 'A' && character <= 'Z') ? (uint8_t)(character + ('a' - 'A')) : character;
+}
+
+/**
+ * \brief Order two names.
+ *
+ * \details Names are ordered ignoring the case of ASCII letters, and names
+ *          differing only in case by their bytes, so the names starting with
+ *          a prefix in any case are adjacent.
+ *
+ * \return A negative number, zero, or a positive number if `name` is ordered
+ *         before, the same as, or after `otherName`.
+ */
+static int PLSymbolIndexCompareNames(const char * name, size_t length, const char * otherName, size_t otherLength)
+{
+        size_t i = 0, commonLength = MIN(length, otherLength);
+        int order = 0;
+
+        for (i = 0; i < commonLength && order == 0; i++) {
+                order = (int)PLSymbolIndexLowercase((uint8_t)name[i]) - (int)PLSymbolIndexLowercase((uint8_t)otherName[i]);
+        }
+        if (order == 0 && length != otherLength) {
+                order = (length < otherLength) ? -1 : 1;
+        }
+        if (order == 0) {
+                order = memcmp(name, otherName, length);
+        }
+        return order;
+}
+
+/**
+ * \brief Order a name relative to the names starting with a prefix, ignoring
+ *        the case of ASCII letters.
+ *
+ * \return A negative number if `name` is ordered before the names starting with
+ *         `prefix`, zero if it starts with it, or a positive number.
+ */
+static int PLSymbolIndexComparePrefix(const char * name, size_t length, const char * prefix, size_t prefixLength)
+{
+        size_t i = 0, commonLength = MIN(length, prefixLength);
+        int order = 0;
+
+        for (i = 0; i < commonLength && order == 0; i++) {
+                order = (int)PLSymbolIndexLowercase((uint8_t)name[i]) - (int)PLSymbolIndexLowercase((uint8_t)prefix[i]);
+        }
+        if (order == 0 && length < prefixLength) {
+                order = -1;
+        }
+        return order;
+}
+
+/**
+ * \brief Order the entries of a name.
+ */
+static int PLSymbolIndexCompareEntries(const void * first, const void * second)
+{
+        const PLSymbolIndexEntry * firstEntry = first, * secondEntry = second;
+
+        if (firstEntry->kind != secondEntry->kind) {
+                return firstEntry->kind < secondEntry->kind ? -1 : 1;
+        }
+        if ((firstEntry->flags & PLSymbolIndexEntryTopLevel) != (secondEntry->flags & PLSymbolIndexEntryTopLevel)) {
+                return (firstEntry->flags & PLSymbolIndexEntryTopLevel) ? -1 : 1;
+        }
+        if (firstEntry->fileIndex != secondEntry->fileIndex) {
+                return firstEntry->fileIndex < secondEntry->fileIndex ? -1 : 1;
+        }
+        return firstEntry->line < secondEntry->line ? -1 : (firstEntry->line > secondEntry->line);
+}
+
+#pragma mark - Scanning
+
+/**
+ * \brief Append a symbol to the symbols of a file.
+ *
+ * \details Names longer than `PLSymbolIndexMaximumNameLength` bytes in UTF-8
+ *          are skipped.
+ *
+ * \param symbols The symbols of the file.
+ *
+ * \param characters The characters of the file.
+ *
+ * \param symbol The symbol.
+ */
+static void PLSymbolIndexAppendSymbol(NSMutableData * symbols, const unichar * characters, const PLPythonSymbol * symbol)
+{
+        PLSymbolIndexScannedSymbol record;
+        char asciiName[PLSymbolIndexMaximumNameLength];
+        const char * name = asciiName;
+        NSString * unicodeName = nil;
+        size_t nameLength = symbol->range.length, i = 0;
+
+        if (nameLength > PLSymbolIndexMaximumNameLength) {
+                goto exit;
+        }
+        for (i = 0; i < nameLength && name; i++) {
+                if (characters[symbol->range.location + i] >= 0x80) {
+                        name = NULL;
+                } else {
+                        asciiName[i] = (char)characters[symbol->range.location + i];
+                }
+        }
+        if (name == NULL) {
+                unicodeName = [[NSString alloc] initWithCharacters:characters + symbol->range.location length:nameLength];
+                name = [unicodeName UTF8String];
+                nameLength = name ? strlen(name) : 0;
+        }
+        if (nameLength > 0 && nameLength <= PLSymbolIndexMaximumNameLength) {
+                record.line = (uint32_t)MIN(symbol->line, UINT32_MAX);
+                record.kind = symbol->kind;
+                record.flags = symbol->topLevel ? PLSymbolIndexEntryTopLevel : 0;
+                record.nameLength = (uint8_t)nameLength;
+                record.reserved = 0;
+                [symbols appendBytes:&record length:sizeof(record)];
+                [symbols appendBytes:name length:nameLength];
+        }
+        [unicodeName release];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Scan the symbols of a Python file.
+ *
+ * \details The contents are decoded as UTF-8, or as Latin 1 if they are not
+ *          valid UTF-8. This function may be called from any thread.
+ *
+ * \param contents The contents of the file.
+ *
+ * \return The symbols, as `PLSymbolIndexScannedSymbol` records each followed by
+ *         the UTF-8 bytes of the name.
+ */
+static NSData * PLSymbolIndexScanContents(NSData * contents)
+{
+        NSString * source = [[NSString alloc] initWithData:contents encoding:NSUTF8StringEncoding];
+        NSMutableData * symbols = [NSMutableData dataWithCapacity:[contents length]];
+        unichar * characters = NULL;
+        NSUInteger length = 0;
+
+        if (source == nil) {
+                source = [[NSString alloc] initWithData:contents encoding:NSISOLatin1StringEncoding];
+        }
+        length = [source length];
+        characters = malloc(MAX(length, 1) * sizeof(unichar));
+        [source getCharacters:characters range:NSMakeRange(0, length)];
+        PLPythonScanSymbols(characters, length, ^(const unichar * sourceCharacters, const PLPythonSymbol * symbol) {
+                PLSymbolIndexAppendSymbol(symbols, sourceCharacters, symbol);
+        });
+        free(characters);
+        [source release];
+        return symbols;
+}
+
+#pragma mark -
+
+/**
+ * \class PLSymbolIndexListedFile
+ *
+ * \brief A Python file found below the project directory.
+ */
+@interface PLSymbolIndexListedFile : NSObject
+
+/**
+ * \brief The path relative to the root.
+ */
+@property (copy) NSString * relativePath;
+
+/**
+ * \brief The size of the file in bytes.
+ */
+@property uint64_t size;
+
+/**
+ * \brief The modification time of the file in nanoseconds.
+ */
+@property int64_t modificationTime;
+
+/**
+ * \brief The hash of the contents, once read.
+ */
+@property uint64_t contentHash;
+
+/**
+ * \brief YES once the contents have been read.
+ */
+@property BOOL read;
+
+/**
+ * \brief The scanned symbols, or nil if the file was not scanned.
+ */
+@property (retain) NSData * symbols;
+
+@end
+
+@implementation PLSymbolIndexListedFile
+
+-(void)dealloc
+{
+        [_relativePath release];
+        [_symbols release];
+        [super dealloc];
+}
+
+/**
+ * \brief Read the file and hash its contents, scanning them unless an indexed
+ *        file had the same contents.
+ *
+ * \details This method may be called from any thread.
+ *
+ * \param rootPath The project directory.
+ *
+ * \param indexedContents The indexes of the indexed files by content hash, or
+ *                        nil to always scan.
+ */
+-(void)readWithRootPath:(NSString *)rootPath indexedContents:(NSDictionary *)indexedContents
+{
+        NSData * contents = [NSData dataWithContentsOfFile:[rootPath stringByAppendingPathComponent:self.relativePath]
+                                                   options:NSDataReadingMappedIfSafe
+                                                     error:NULL];
+
+        if (contents == nil) {
+                goto exit;
+        }
+        self.read = YES;
+        self.contentHash = PLSymbolIndexHash([contents bytes], [contents length]);
+        if ([indexedContents objectForKey:@(self.contentHash)] == nil) {
+                self.symbols = PLSymbolIndexScanContents(contents);
+        }
+
+exit:
+        return;
+}
+
+@end
+
+#pragma mark -
+
+/**
+ * \brief The tables of the snapshot, read directly by the index.
+ */
+@interface PLSymbolIndexSnapshot ()
+{
+@public
+        NSData * data;
+        const PLSymbolIndexHeader * header;
+        const PLSymbolIndexFile * files;
+        const PLSymbolIndexName * names;
+        const PLSymbolIndexEntry * entries;
+        const char * pool;
+}
+
+@end
+
+@implementation PLSymbolIndexSnapshot
+
+/**
+ * \brief Initialize a snapshot with index data.
+ *
+ * \details The data is validated so that a truncated or corrupt index file is
+ *          never queried.
+ *
+ * \param indexData The index data.
+ *
+ * \param rootPath The directory the index must belong to.
+ *
+ * \return The snapshot, or nil if the data is not a valid index of `rootPath`.
+ */
+-(instancetype)initWithData:(NSData *)indexData rootPath:(NSString *)rootPath
+{
+        const char * rootRepresentation = [rootPath fileSystemRepresentation];
+        const uint8_t * bytes = [indexData bytes];
+        uint64_t expectedLength = 0;
+        uint32_t i = 0;
+
+        self = [super init];
+        if (self == nil) {
+                goto exit;
+        }
+
+        if ([indexData length] < sizeof(PLSymbolIndexHeader)) {
+                goto fail;
+        }
+        header = (const PLSymbolIndexHeader *)bytes;
+        expectedLength = (sizeof(PLSymbolIndexHeader) +
+                          (uint64_t)header->fileCount * sizeof(PLSymbolIndexFile) +
+                          (uint64_t)header->nameCount * sizeof(PLSymbolIndexName) +
+                          (uint64_t)header->entryCount * sizeof(PLSymbolIndexEntry) +
+                          header->poolLength);
+        if (header->magic != PLSymbolIndexMagic || header->version != PLSymbolIndexVersion ||
+            expectedLength != [indexData length] || header->rootPathLength > header->poolLength) {
+                goto fail;
+        }
+        files = (const PLSymbolIndexFile *)(bytes + sizeof(PLSymbolIndexHeader));
+        names = (const PLSymbolIndexName *)(files + header->fileCount);
+        entries = (const PLSymbolIndexEntry *)(names + header->nameCount);
+        pool = (const char *)(entries + header->entryCount);
+        if (strlen(rootRepresentation) != header->rootPathLength ||
+            memcmp(pool, rootRepresentation, header->rootPathLength) != 0) {
+                goto fail;
+        }
+        for (i = 0; i < header->fileCount; i++) {
+                if ((uint64_t)files[i].pathOffset + files[i].pathLength > header->poolLength) {
+                        goto fail;
+                }
+        }
+        for (i = 0; i < header->nameCount; i++) {
+                if ((uint64_t)names[i].nameOffset + names[i].nameLength > header->poolLength ||
+                    (uint64_t)names[i].firstEntry + names[i].entryCount > header->entryCount) {
+                        goto fail;
+                }
+        }
+        for (i = 0; i < header->entryCount; i++) {
+                if (entries[i].fileIndex >= header->fileCount || entries[i].kind >= PLPythonSymbolKindCount) {
+                        goto fail;
+                }
+        }
+        data = [indexData retain];
+
+exit:
+        return self;
+
+fail:
+        [self release];
+        return nil;
+}
+
+-(void)dealloc
+{
+        [data release];
+        [super dealloc];
+}
+
+-(NSString *)relativePathOfFileAtIndex:(uint32_t)fileIndex
+{
+        return [[NSFileManager defaultManager] stringWithFileSystemRepresentation:pool + files[fileIndex].pathOffset
+                                                                           length:files[fileIndex].pathLength];
+}
+
+-(NSString *)nameAtIndex:(uint32_t)nameIndex
+{
+        return [[[NSString alloc] initWithBytes:pool + names[nameIndex].nameOffset
+                                         length:names[nameIndex].nameLength
+                                       encoding:NSUTF8StringEncoding] autorelease];
+}
+
+/**
+ * \brief Find a name.
+ *
+ * \return The index of the name, or `UINT32_MAX` if it is not indexed.
+ */
+-(uint32_t)indexOfName:(const char *)name length:(size_t)length
+{
+        uint32_t low = 0, high = header->nameCount, middle = 0, nameIndex = UINT32_MAX;
+        int order = 0;
+
+        while (low < high) {
+                middle = low + (high - low) / 2;
+                order = PLSymbolIndexCompareNames(pool + names[middle].nameOffset, names[middle].nameLength, name, length);
+                if (order < 0) {
+                        low = middle + 1;
+                } else if (order > 0) {
+                        high = middle;
+                } else {
+                        nameIndex = middle;
+                        break;
+                }
+        }
+        return nameIndex;
+}
+
+/**
+ * \brief Find the first name starting with a prefix, ignoring case.
+ *
+ * \return The index of the first name not ordered before the names starting
+ *         with `prefix`, which may not start with it, or the number of names.
+ */
+-(uint32_t)indexOfFirstNameWithPrefix:(const char *)prefix length:(size_t)length
+{
+        uint32_t low = 0, high = header->nameCount, middle = 0;
+
+        while (low < high) {
+                middle = low + (high - low) / 2;
+                if (PLSymbolIndexComparePrefix(pool + names[middle].nameOffset, names[middle].nameLength, prefix, length) < 0) {
+                        low = middle + 1;
+                } else {
+                        high = middle;
+                }
+        }
+        return low;
+}
+
+@end
+
+#pragma mark -
+
+/**
+ * \brief A name added to a builder.
+ */
+typedef struct {
+        uint64_t hash;
+        uint32_t offset;
+        uint32_t length;
+        uint32_t entryCount;
+        uint32_t lastReferencingFile;
+} PLSymbolIndexBuilderName;
+
+/**
+ * \brief An entry added to a builder, with the index of its name.
+ */
+typedef struct {
+        uint32_t nameIndex;
+        PLSymbolIndexEntry entry;
+} PLSymbolIndexBuilderEntry;
+
+/**
+ * \brief A name being sorted.
+ */
+typedef struct {
+        const char * bytes;
+        uint32_t length;
+        uint32_t nameIndex;
+} PLSymbolIndexSortedName;
+
+/**
+ * \brief Order names being sorted with `PLSymbolIndexCompareNames`.
+ */
+static int PLSymbolIndexCompareSortedNames(const void * first, const void * second)
+{
+        const PLSymbolIndexSortedName * firstName = first, * secondName = second;
+
+        return PLSymbolIndexCompareNames(firstName->bytes, firstName->length, secondName->bytes, secondName->length);
+}
+
+/**
+ * \brief The tables and name table being built.
+ */
+@interface PLSymbolIndexBuilder ()
+{
+        NSString * rootPath;
+        NSMutableData * fileTable;
+        NSMutableData * pool;
+        PLSymbolIndexBuilderName * names;
+        uint32_t nameCount;
+        uint32_t nameCapacity;
+        uint32_t * slots;
+        uint32_t slotCount;
+        PLSymbolIndexBuilderEntry * entries;
+        NSUInteger entryCount;
+        NSUInteger entryCapacity;
+        uint32_t fileCount;
+}
+
+@end
+
+@implementation PLSymbolIndexBuilder
+
+-(instancetype)initWithRootPath:(NSString *)path
+{
+        const char * rootRepresentation = [path fileSystemRepresentation];
+
+        self = [super init];
+        if (self) {
+                rootPath = [path copy];
+                fileTable = [[NSMutableData alloc] init];
+                pool = [[NSMutableData alloc] initWithBytes:rootRepresentation length:strlen(rootRepresentation)];
+                [self growSlots];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [rootPath release];
+        [fileTable release];
+        [pool release];
+        free(names);
+        free(slots);
+        free(entries);
+        [super dealloc];
+}
+
+-(uint32_t)fileCount
+{
+        return fileCount;
+}
+
+/**
+ * \brief Double the number of slots of the name table and rehash the names.
+ */
+-(void)growSlots
+{
+        uint32_t nameIndex = 0, slot = 0;
+
+        free(slots);
+        slotCount = MAX(2 * slotCount, 1024);
+        slots = calloc(slotCount, sizeof(uint32_t));
+        for (nameIndex = 0; nameIndex < nameCount; nameIndex++) {
+                slot = (uint32_t)names[nameIndex].hash & (slotCount - 1);
+                while (slots[slot] != 0) {
+                        slot = (slot + 1) & (slotCount - 1);
+                }
+                slots[slot] = nameIndex + 1;
+        }
+}
+
+/**
+ * \brief Intern a name.
+ *
+ * \return The index of the name.
+ */
+-(uint32_t)indexOfName:(const char *)name length:(size_t)length
+{
+        uint64_t hash = PLSymbolIndexHash(name, length);
+        uint32_t slot = 0, nameIndex = 0;
+        const char * poolBytes = [pool bytes];
+
+        if (2 * (nameCount + 1) > slotCount) {
+                [self growSlots];
+        }
+        for (slot = (uint32_t)hash & (slotCount - 1); slots[slot] != 0; slot = (slot + 1) & (slotCount - 1)) {
+                nameIndex = slots[slot] - 1;
+                if (names[nameIndex].hash == hash && names[nameIndex].length == length &&
+                    memcmp(poolBytes + names[nameIndex].offset, name, length) == 0) {
+                        goto exit;
+                }
+        }
+
+        if (nameCount == nameCapacity) {
+                nameCapacity = MAX(2 * nameCapacity, 1024);
+                names = realloc(names, nameCapacity * sizeof(PLSymbolIndexBuilderName));
+        }
+        nameIndex = nameCount;
+        names[nameIndex].hash = hash;
+        names[nameIndex].offset = (uint32_t)[pool length];
+        names[nameIndex].length = (uint32_t)length;
+        names[nameIndex].entryCount = 0;
+        names[nameIndex].lastReferencingFile = UINT32_MAX;
+        [pool appendBytes:name length:length];
+        slots[slot] = nameIndex + 1;
+        nameCount++;
+
+exit:
+        return nameIndex;
+}
+
+/**
+ * \brief Add a file.
+ *
+ * \return The index of the file, or `UINT32_MAX` if the index is full.
+ */
+-(uint32_t)addFileAtPath:(NSString *)relativePath contentHash:(uint64_t)contentHash modificationTime:(int64_t)modificationTime size:(uint64_t)size
+{
+        const char * pathRepresentation = [relativePath fileSystemRepresentation];
+        PLSymbolIndexFile file;
+        uint32_t fileIndex = UINT32_MAX;
+
+        if (fileCount >= PLSymbolIndexMaximumFileCount) {
+                goto exit;
+        }
+        file.pathOffset = (uint32_t)[pool length];
+        file.pathLength = (uint32_t)strlen(pathRepresentation);
+        file.contentHash = contentHash;
+        file.modificationTime = modificationTime;
+        file.size = size;
+        [pool appendBytes:pathRepresentation length:file.pathLength];
+        [fileTable appendBytes:&file length:sizeof(file)];
+        fileIndex = fileCount++;
+
+exit:
+        return fileIndex;
+}
+
+/**
+ * \brief Add a symbol of a file.
+ *
+ * \details Only the first reference of a file to a name is added. The symbols
+ *          of a file must be added without adding references of another file
+ *          to the same names in between.
+ */
+-(void)addSymbolNamed:(const char *)name length:(size_t)length fileIndex:(uint32_t)fileIndex line:(uint32_t)line kind:(uint8_t)kind flags:(uint8_t)flags
+{
+        uint32_t nameIndex = [self indexOfName:name length:length];
+        PLSymbolIndexBuilderEntry * builderEntry = NULL;
+
+        if (kind == PLPythonSymbolReference) {
+                if (names[nameIndex].lastReferencingFile == fileIndex) {
+                        goto exit;
+                }
+                names[nameIndex].lastReferencingFile = fileIndex;
+        }
+        if (entryCount == entryCapacity) {
+                entryCapacity = MAX(2 * entryCapacity, 65536);
+                entries = realloc(entries, entryCapacity * sizeof(PLSymbolIndexBuilderEntry));
+        }
+        builderEntry = &entries[entryCount++];
+        builderEntry->nameIndex = nameIndex;
+        builderEntry->entry.fileIndex = fileIndex;
+        builderEntry->entry.line = line;
+        builderEntry->entry.kind = kind;
+        builderEntry->entry.flags = flags;
+        builderEntry->entry.reserved = 0;
+        names[nameIndex].entryCount++;
+
+exit:
+        return;
+}
+
+/**
+ * \brief Add the symbols scanned from a file.
+ *
+ * \param symbols The symbols returned by `PLSymbolIndexScanContents`.
+ *
+ * \param fileIndex The index of the file.
+ */
+-(void)addScannedSymbols:(NSData *)symbols fileIndex:(uint32_t)fileIndex
+{
+        const uint8_t * bytes = [symbols bytes];
+        NSUInteger offset = 0, length = [symbols length];
+        PLSymbolIndexScannedSymbol record;
+
+        while (offset + sizeof(record) <= length) {
+                memcpy(&record, bytes + offset, sizeof(record));
+                offset += sizeof(record);
+                if (offset + record.nameLength > length) {
+                        break;
+                }
+                [self addSymbolNamed:(const char *)bytes + offset
+                              length:record.nameLength
+                           fileIndex:fileIndex
+                                line:record.line
+                                kind:record.kind
+                               flags:record.flags];
+                offset += record.nameLength;
+        }
+}
+
+/**
+ * \brief Produce the index data.
+ *
+ * \details The names are sorted, and the entries are placed in the ranges of
+ *          their names by counting, then sorted within each name.
+ *
+ * \param lastEventIdentifier The identifier of the last file system event
+ *                            reflected in the index.
+ *
+ * \param eventHistoryIdentifier The history `lastEventIdentifier` refers to.
+ *
+ * \return The index data in the index file format.
+ */
+-(NSData *)dataWithLastEventIdentifier:(uint64_t)lastEventIdentifier eventHistoryIdentifier:(NSString *)eventHistoryIdentifier
+{
+        NSMutableData * indexData = nil;
+        PLSymbolIndexHeader header;
+        PLSymbolIndexSortedName * sortedNames = malloc(MAX(nameCount, 1) * sizeof(PLSymbolIndexSortedName));
+        PLSymbolIndexName * nameTable = malloc(MAX(nameCount, 1) * sizeof(PLSymbolIndexName));
+        PLSymbolIndexEntry * entryTable = malloc(MAX(entryCount, 1) * sizeof(PLSymbolIndexEntry));
+        uint32_t * ranks = malloc(MAX(nameCount, 1) * sizeof(uint32_t));
+        uint32_t * placedCounts = calloc(MAX(nameCount, 1), sizeof(uint32_t));
+        const char * poolBytes = [pool bytes];
+        uint32_t nameIndex = 0, rank = 0, firstEntry = 0;
+        NSUInteger i = 0;
+
+        for (nameIndex = 0; nameIndex < nameCount; nameIndex++) {
+                sortedNames[nameIndex].bytes = poolBytes + names[nameIndex].offset;
+                sortedNames[nameIndex].length = names[nameIndex].length;
+                sortedNames[nameIndex].nameIndex = nameIndex;
+        }
+        qsort(sortedNames, nameCount, sizeof(PLSymbolIndexSortedName), PLSymbolIndexCompareSortedNames);
+        for (rank = 0; rank < nameCount; rank++) {
+                nameIndex = sortedNames[rank].nameIndex;
+                ranks[nameIndex] = rank;
+                nameTable[rank].nameOffset = names[nameIndex].offset;
+                nameTable[rank].nameLength = names[nameIndex].length;
+                nameTable[rank].firstEntry = firstEntry;
+                nameTable[rank].entryCount = names[nameIndex].entryCount;
+                firstEntry += names[nameIndex].entryCount;
+        }
+        for (i = 0; i < entryCount; i++) {
+                rank = ranks[entries[i].nameIndex];
+                entryTable[nameTable[rank].firstEntry + placedCounts[rank]] = entries[i].entry;
+                placedCounts[rank]++;
+        }
+        for (rank = 0; rank < nameCount; rank++) {
+                if (nameTable[rank].entryCount > 1) {
+                        qsort(entryTable + nameTable[rank].firstEntry, nameTable[rank].entryCount, sizeof(PLSymbolIndexEntry), PLSymbolIndexCompareEntries);
+                }
+        }
+
+        memset(&header, 0, sizeof(header));
+        header.magic = PLSymbolIndexMagic;
+        header.version = PLSymbolIndexVersion;
+        header.fileCount = fileCount;
+        header.nameCount = nameCount;
+        header.entryCount = (uint32_t)entryCount;
+        header.poolLength = (uint32_t)[pool length];
+        header.rootPathLength = (uint32_t)strlen([rootPath fileSystemRepresentation]);
+        header.lastEventIdentifier = lastEventIdentifier;
+        if (eventHistoryIdentifier) {
+                strncpy(header.eventHistoryIdentifier, [eventHistoryIdentifier UTF8String], sizeof(header.eventHistoryIdentifier) - 1);
+        }
+
+        indexData = [NSMutableData dataWithCapacity:(sizeof(header) + [fileTable length] +
+                                                     nameCount * sizeof(PLSymbolIndexName) +
+                                                     entryCount * sizeof(PLSymbolIndexEntry) + [pool length])];
+        [indexData appendBytes:&header length:sizeof(header)];
+        [indexData appendData:fileTable];
+        [indexData appendBytes:nameTable length:nameCount * sizeof(PLSymbolIndexName)];
+        [indexData appendBytes:entryTable length:entryCount * sizeof(PLSymbolIndexEntry)];
+        [indexData appendData:pool];
+
+        free(sortedNames);
+        free(nameTable);
+        free(entryTable);
+        free(ranks);
+        free(placedCounts);
+        return indexData;
+}
+
+@end
+
+#pragma mark -
+
+/**
+ * \brief Determine if a relative path is a directory or lies below it.
+ *
+ * \details The empty path is the root, which contains every path.
+ */
+static BOOL PLSymbolIndexRelativePathIsWithin(NSString * relativePath, NSString * directoryPath)
+{
+        return [directoryPath length] == 0 || PLPathIsWithinDirectory(relativePath, directoryPath);
+}
+
+/**
+ * \brief Determine if a relative path lies within any directory in a set.
+ */
+static BOOL PLSymbolIndexRelativePathIsWithinAny(NSString * relativePath, NSSet * directoryPaths)
+{
+        for (NSString * directoryPath in directoryPaths) {
+                if (PLSymbolIndexRelativePathIsWithin(relativePath, directoryPath)) {
+                        return YES;
+                }
+        }
+        return NO;
+}
+
+@implementation PLSymbolLocation
+
+-(instancetype)initWithName:(NSString *)name path:(NSString *)path line:(NSUInteger)line kind:(PLPythonSymbolKind)kind topLevel:(BOOL)topLevel
+{
+        self = [super init];
+        if (self) {
+                _name = [name copy];
+                _path = [path copy];
+                _line = line;
+                _kind = kind;
+                _topLevel = topLevel;
+        }
+        return self;
+}
+
++(instancetype)locationWithName:(NSString *)name path:(NSString *)path line:(NSUInteger)line kind:(PLPythonSymbolKind)kind topLevel:(BOOL)topLevel
+{
+        return [[[self alloc] initWithName:name path:path line:line kind:kind topLevel:topLevel] autorelease];
+}
+
+-(void)dealloc
+{
+        [_name release];
+        [_path release];
+        [super dealloc];
+}
+
+-(NSString *)description
+{
+        return [NSString stringWithFormat:@"%@ (%@:%lu)", self.name, self.path, (unsigned long)self.line];
+}
+
+@end
+
+@interface PLSymbolIndex ()
+
+@property (retain, readwrite) NSString * directoryPath;
+
+@end
+
+@implementation PLSymbolIndex
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Initialize a symbol index of a directory.
+ *
+ * \details The index is not opened. Use `indexForDirectoryAtPath:` to get the
+ *          shared index of a directory.
+ *
+ * \param path The project directory.
+ *
+ * \return The symbol index.
+ */
+-(instancetype)initWithDirectoryPath:(NSString *)path
+{
+        __block PLSymbolIndex * blockSelf = self;
+
+        self = [super init];
+        if (self) {
+                _directoryPath = [path copy];
+                indexQueue = dispatch_queue_create("org.liasis.symbolindex.index", DISPATCH_QUEUE_SERIAL);
+                blockSelf = self;
+                watcher = [[PLFileSystemWatcher watcherWithPath:path
+                                                        latency:PLSymbolIndexWatcherLatency
+                                                   eventHandler:^(NSSet * changedDirectories, NSSet * rescannedDirectories) {
+                                                           [blockSelf directoriesDidChange:changedDirectories
+                                                                      rescannedDirectories:rescannedDirectories];
+                                                   }] retain];
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [watcher stop];
+        [watcher release];
+        [snapshot release];
+        [_directoryPath release];
+        dispatch_release(indexQueue);
+        [super dealloc];
+}
+
++(NSMutableDictionary *)sharedIndexes
+{
+        static NSMutableDictionary * sharedIndexes = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedIndexes = [[NSMutableDictionary alloc] init];
+        });
+        return sharedIndexes;
+}
+
++(instancetype)indexForDirectoryAtPath:(NSString *)directoryPath
+{
+        PLSymbolIndex * index = [[self sharedIndexes] objectForKey:directoryPath];
+
+        if (index == nil) {
+                index = [[[self alloc] initWithDirectoryPath:directoryPath] autorelease];
+                [[self sharedIndexes] setObject:index forKey:directoryPath];
+                [index open];
+        }
+        return index;
+}
+
+/**
+ * \brief The number of clients of each project directory.
+ */
++(NSCountedSet *)sharedClients
+{
+        static NSCountedSet * sharedClients = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedClients = [[NSCountedSet alloc] init];
+        });
+        return sharedClients;
+}
+
++(void)retainIndexForDirectoryAtPath:(NSString *)directoryPath
+{
+        if (directoryPath) {
+                [[self sharedClients] addObject:directoryPath];
+        }
+}
+
++(void)releaseIndexForDirectoryAtPath:(NSString *)directoryPath
+{
+        PLSymbolIndex * index = nil;
+
+        if (directoryPath == nil || [[self sharedClients] countForObject:directoryPath] == 0) {
+                goto exit;
+        }
+        [[self sharedClients] removeObject:directoryPath];
+        if ([[self sharedClients] countForObject:directoryPath] == 0) {
+                index = [[[[self sharedIndexes] objectForKey:directoryPath] retain] autorelease];
+                [[self sharedIndexes] removeObjectForKey:directoryPath];
+                [index close];
+        }
+
+exit:
+        return;
+}
+
++(BOOL)hasPersistentIndexForDirectoryAtPath:(NSString *)directoryPath
+{
+        return [[NSFileManager defaultManager] fileExistsAtPath:[self indexFilePathForDirectoryAtPath:directoryPath]];
+}
+
+/**
+ * \brief The path of the index file of a directory.
+ *
+ * \details Index files are stored in the application's caches directory and
+ *          named by a hash of the directory path.
+ *
+ * \param directoryPath The project directory.
+ *
+ * \return The path of the index file.
+ */
++(NSString *)indexFilePathForDirectoryAtPath:(NSString *)directoryPath
+{
+        NSString * cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+        NSString * bundleIdentifier = [[NSBundle mainBundle] bundleIdentifier] ?: @"Liasis";
+        const char * pathRepresentation = [directoryPath fileSystemRepresentation];
+
+        return [[[cachesPath stringByAppendingPathComponent:bundleIdentifier]
+                 stringByAppendingPathComponent:@"SymbolIndex"]
+                stringByAppendingPathComponent:[NSString stringWithFormat:@"%016llx.plsymbols",
+                                                PLSymbolIndexHash(pathRepresentation, strlen(pathRepresentation))]];
+}
+
+#pragma mark - Snapshots
+
+-(PLSymbolIndexSnapshot *)currentSnapshot
+{
+        PLSymbolIndexSnapshot * currentSnapshot = nil;
+
+        @synchronized(self) {
+                currentSnapshot = [[snapshot retain] autorelease];
+        }
+        return currentSnapshot;
+}
+
+/**
+ * \brief Replace the contents of the index.
+ *
+ * \details This method may be called from any thread. The
+ *          `PLSymbolIndexDidUpdateNotification` notification is posted on the
+ *          main queue.
+ *
+ * \param newSnapshot The new snapshot.
+ */
+-(void)setSnapshot:(PLSymbolIndexSnapshot *)newSnapshot
+{
+        @synchronized(self) {
+                [newSnapshot retain];
+                [snapshot release];
+                snapshot = newSnapshot;
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+                [[NSNotificationCenter defaultCenter] postNotificationName:PLSymbolIndexDidUpdateNotification object:self];
+        });
+}
+
+-(BOOL)isReady
+{
+        return [self currentSnapshot] != nil;
+}
+
+-(NSUInteger)numberOfFiles
+{
+        PLSymbolIndexSnapshot * currentSnapshot = [self currentSnapshot];
+
+        return currentSnapshot ? currentSnapshot->header->fileCount : 0;
+}
+
+#pragma mark - Listing Files
+
+/**
+ * \brief List the Python files and the subdirectories of a directory.
+ *
+ * \details Entries whose names begin with a dot are skipped, as are
+ *          `__pycache__` directories, directories hidden in the Finder, and
+ *          files larger than `PLSymbolIndexMaximumFileSize`. Symbolic links to
+ *          files are listed, but symbolic links to directories are not
+ *          followed.
+ *
+ * \param relativePath The path of the directory relative to the root.
+ *
+ * \param files The array the `PLSymbolIndexListedFile`s are added to.
+ *
+ * \param subdirectories The array the relative paths of the subdirectories are
+ *                       added to.
+ *
+ * \return NO if the directory could not be read.
+ */
+-(BOOL)listDirectoryAtPath:(NSString *)relativePath files:(NSMutableArray *)files subdirectories:(NSMutableArray *)subdirectories
+{
+        NSString * fullPath = [relativePath length] > 0 ? [self.directoryPath stringByAppendingPathComponent:relativePath] : self.directoryPath;
+        const char * directoryRepresentation = [fullPath fileSystemRepresentation];
+        char entryPath[PATH_MAX];
+        DIR * directory = NULL;
+        struct dirent * entry = NULL;
+        struct stat entryInfo;
+        size_t nameLength = 0;
+        BOOL isPython = NO, successful = NO;
+        NSString * name = nil;
+        PLSymbolIndexListedFile * file = nil;
+
+        directory = opendir(directoryRepresentation);
+        if (directory == NULL) {
+                goto exit;
+        }
+        successful = YES;
+
+        while ((entry = readdir(directory)) != NULL) {
+                if (entry->d_name[0] == '.' || strcmp(entry->d_name, "__pycache__") == 0) {
+                        continue;
+                }
+                nameLength = strlen(entry->d_name);
+                isPython = ((nameLength > 3 && strcmp(entry->d_name + nameLength - 3, ".py") == 0) ||
+                            (nameLength > 4 && strcmp(entry->d_name + nameLength - 4, ".pyw") == 0));
+                if (isPython == NO && entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) {
+                        continue;
+                }
+                if (snprintf(entryPath, sizeof(entryPath), "%s/%s", directoryRepresentation, entry->d_name) >= (int)sizeof(entryPath) ||
+                    (isPython ? stat(entryPath, &entryInfo) : lstat(entryPath, &entryInfo)) != 0) {
+                        continue;
+                }
+#if defined(UF_HIDDEN)
+                if (S_ISDIR(entryInfo.st_mode) && (entryInfo.st_flags & UF_HIDDEN)) {
+                        continue;
+                }
+#endif
+                name = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:entry->d_name length:nameLength];
+                if (S_ISDIR(entryInfo.st_mode) && isPython == NO) {
+                        [subdirectories addObject:([relativePath length] > 0 ? [relativePath stringByAppendingPathComponent:name] : name)];
+                } else if (S_ISREG(entryInfo.st_mode) && isPython && entryInfo.st_size <= PLSymbolIndexMaximumFileSize) {
+                        file = [[[PLSymbolIndexListedFile alloc] init] autorelease];
+                        file.relativePath = ([relativePath length] > 0 ? [relativePath stringByAppendingPathComponent:name] : name);
+                        file.size = (uint64_t)entryInfo.st_size;
+                        file.modificationTime = (int64_t)entryInfo.st_mtimespec.tv_sec * 1000000000 + entryInfo.st_mtimespec.tv_nsec;
+                        [files addObject:file];
+                }
+        }
+
+exit:
+        if (directory) {
+                closedir(directory);
+        }
+        return successful;
+}
+
+/**
+ * \brief List the Python files of a directory and everything below it.
+ *
+ * \param relativePath The path of the directory relative to the root.
+ *
+ * \param files The array the `PLSymbolIndexListedFile`s are added to.
+ */
+-(void)listDirectoryTreeAtPath:(NSString *)relativePath files:(NSMutableArray *)files
+{
+        NSMutableArray * pendingDirectories = [NSMutableArray arrayWithObject:relativePath];
+        NSString * currentPath = nil;
+
+        while ([pendingDirectories count] > 0 && [files count] < PLSymbolIndexMaximumFileCount) {
+                @autoreleasepool {
+                        currentPath = [[pendingDirectories lastObject] retain];
+                        [pendingDirectories removeLastObject];
+                        [self listDirectoryAtPath:currentPath files:files subdirectories:pendingDirectories];
+                        [currentPath release];
+                }
+        }
+}
+
+#pragma mark - Building and Updating
+
+/**
+ * \brief Open the persisted index and start keeping it current.
+ *
+ * \details The index file is memory mapped on `indexQueue`. If the watcher's
+ *          event history covers the persisted index, the watcher replays the
+ *          changes made since it was written. Otherwise the whole project is
+ *          listed again in the background, while the persisted copy, if any,
+ *          stays queryable; only the files that changed are read.
+ */
+-(void)open
+{
+        NSString * indexFilePath = [[self class] indexFilePathForDirectoryAtPath:self.directoryPath];
+
+        dispatch_async(indexQueue, ^{
+                NSData * indexData = nil;
+                PLSymbolIndexSnapshot * persistedSnapshot = nil;
+
+                @autoreleasepool {
+                        indexData = [NSData dataWithContentsOfFile:indexFilePath options:NSDataReadingMappedAlways error:NULL];
+                        if (indexData) {
+                                persistedSnapshot = [[[PLSymbolIndexSnapshot alloc] initWithData:indexData rootPath:self.directoryPath] autorelease];
+                        }
+                        if (persistedSnapshot) {
+                                [self setSnapshot:persistedSnapshot];
+                        }
+                        dispatch_async(dispatch_get_main_queue(), ^{
+                                [self startWatchingFromSnapshot:persistedSnapshot];
+                        });
+                }
+        });
+}
+
+/**
+ * \brief Stop watching the project directory.
+ *
+ * \details Called when the index is evicted. Queued updates and the pending
+ *          save still complete.
+ */
+-(void)close
+{
+        closed = YES;
+        [watcher stop];
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLSymbolIndexDidCloseNotification object:self];
+}
+
+/**
+ * \brief Start the watcher, replaying history if possible.
+ *
+ * \details Does nothing if the index was closed while it was being opened.
+ *
+ * \param persistedSnapshot The snapshot read from the index file, or nil.
+ */
+-(void)startWatchingFromSnapshot:(PLSymbolIndexSnapshot *)persistedSnapshot
+{
+        NSString * eventHistoryIdentifier = [watcher eventHistoryIdentifier];
+        BOOL replaysHistory = NO;
+
+        if (closed) {
+                goto exit;
+        }
+        replaysHistory = (persistedSnapshot != nil &&
+                          eventHistoryIdentifier != nil &&
+                          persistedSnapshot->header->lastEventIdentifier != 0 &&
+                          strncmp(persistedSnapshot->header->eventHistoryIdentifier,
+                                  [eventHistoryIdentifier UTF8String],
+                                  sizeof(persistedSnapshot->header->eventHistoryIdentifier)) == 0);
+        if (replaysHistory) {
+                [watcher startSinceEventIdentifier:persistedSnapshot->header->lastEventIdentifier];
+        } else {
+                [watcher start];
+                dispatch_async(indexQueue, ^{
+                        @autoreleasepool {
+                                [self updateChangedDirectories:[NSSet set]
+                                             walkedDirectories:[NSSet setWithObject:@""]
+                                           lastEventIdentifier:[watcher lastEventIdentifier]
+                                        eventHistoryIdentifier:eventHistoryIdentifier];
+                        }
+                });
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Queue an update of the directories reported by the watcher.
+ *
+ * \details The paths are made relative to the project directory. A rescan of
+ *          a directory above the project directory lists the whole project.
+ *
+ * \param changedDirectories The paths of the changed directories.
+ *
+ * \param rescannedDirectories The paths of the directories whose descendants
+ *                             also changed.
+ */
+-(void)directoriesDidChange:(NSSet *)changedDirectories rescannedDirectories:(NSSet *)rescannedDirectories
+{
+        NSMutableSet * relativeChangedDirectories = [NSMutableSet setWithCapacity:[changedDirectories count]];
+        NSMutableSet * relativeRescannedDirectories = [NSMutableSet setWithCapacity:[rescannedDirectories count]];
+        uint64_t lastEventIdentifier = [watcher lastEventIdentifier];
+        NSString * eventHistoryIdentifier = [watcher eventHistoryIdentifier];
+
+        for (NSString * path in changedDirectories) {
+                if (PLPathIsWithinDirectory(path, self.directoryPath)) {
+                        [relativeChangedDirectories addObject:[self relativePathForPath:path]];
+                }
+        }
+        for (NSString * path in rescannedDirectories) {
+                if (PLPathIsWithinDirectory(path, self.directoryPath)) {
+                        [relativeRescannedDirectories addObject:[self relativePathForPath:path]];
+                } else if (PLPathIsWithinDirectory(self.directoryPath, path)) {
+                        [relativeRescannedDirectories addObject:@""];
+                }
+        }
+
+        dispatch_async(indexQueue, ^{
+                @autoreleasepool {
+                        [self updateChangedDirectories:relativeChangedDirectories
+                                     walkedDirectories:relativeRescannedDirectories
+                                   lastEventIdentifier:lastEventIdentifier
+                                eventHistoryIdentifier:eventHistoryIdentifier];
+                }
+        });
+}
+
+/**
+ * \brief Make a path within the project directory relative to it.
+ */
+-(NSString *)relativePathForPath:(NSString *)path
+{
+        NSString * relativePath = [path substringFromIndex:[self.directoryPath length]];
+
+        while ([relativePath hasPrefix:@"/"]) {
+                relativePath = [relativePath substringFromIndex:1];
+        }
+        return relativePath;
+}
+
+/**
+ * \brief Build a new snapshot from the current one and the directories that
+ *        changed.
+ *
+ * \details This method runs on `indexQueue`. Changed directories are listed
+ *          again without descending into them: subdirectories that
+ *          disappeared are dropped with everything below them, and new
+ *          subdirectories are walked. Walked directories are listed in full.
+ *          Every other file keeps its symbols without touching the disk.
+ *
+ *          Of the listed files, those with the size and modification time
+ *          they were indexed with keep their symbols too. The others are read
+ *          and hashed in parallel, a batch at a time, and only scanned if no
+ *          indexed file had the same contents; otherwise they take the
+ *          symbols of that file. The symbols kept are copied from the current
+ *          snapshot by name. If nothing changed, the current snapshot is kept.
+ *
+ * \param changedDirectories The relative paths of the changed directories.
+ *
+ * \param walkedDirectories The relative paths of the directories to walk.
+ *
+ * \param lastEventIdentifier The identifier of the last event reflected in the
+ *                            update.
+ *
+ * \param eventHistoryIdentifier The history `lastEventIdentifier` refers to.
+ */
+-(void)updateChangedDirectories:(NSSet *)changedDirectories
+              walkedDirectories:(NSSet *)walkedDirectories
+            lastEventIdentifier:(uint64_t)lastEventIdentifier
+         eventHistoryIdentifier:(NSString *)eventHistoryIdentifier
+{
+        PLSymbolIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        PLSymbolIndexBuilder * builder = [[[PLSymbolIndexBuilder alloc] initWithRootPath:self.directoryPath] autorelease];
+        NSMutableSet * walked = [[walkedDirectories mutableCopy] autorelease];
+        NSMutableSet * removedDirectories = [NSMutableSet set];
+        NSMutableSet * relistedDirectories = [NSMutableSet set];
+        NSMutableSet * currentSubdirectories = [NSMutableSet set];
+        NSMutableSet * indexedDirectories = [NSMutableSet setWithObject:@""];
+        NSMutableSet * listedPaths = [NSMutableSet set];
+        NSMutableDictionary * indexedFiles = [NSMutableDictionary dictionary];
+        NSMutableDictionary * indexedContents = [NSMutableDictionary dictionary];
+        NSMutableArray * indexedPaths = [NSMutableArray array];
+        NSMutableArray * listedFiles = [NSMutableArray array];
+        NSMutableArray * changedFiles = [NSMutableArray array];
+        NSMutableArray * subdirectories = [NSMutableArray array];
+        NSString * rootPath = self.directoryPath;
+        NSString * directory = nil;
+        NSArray * batch = nil;
+        NSNumber * indexedFile = nil;
+        NSData * contents = nil;
+        const PLSymbolIndexFile * file = NULL;
+        const PLSymbolIndexName * name = NULL;
+        const PLSymbolIndexEntry * entry = NULL;
+        uint32_t * fileMap = NULL;
+        uint32_t indexedFileCount = 0, fileIndex = 0, nameIndex = 0, entryIndex = 0;
+        NSUInteger batchStart = 0, scannedCount = 0, reusedCount = 0;
+        CFTimeInterval startTime = CACurrentMediaTime();
+        BOOL modified = (currentSnapshot == nil);
+
+        if (currentSnapshot) {
+                indexedFileCount = currentSnapshot->header->fileCount;
+                for (fileIndex = 0; fileIndex < indexedFileCount; fileIndex++) {
+                        [indexedPaths addObject:[currentSnapshot relativePathOfFileAtIndex:fileIndex]];
+                        [indexedFiles setObject:@(fileIndex) forKey:[indexedPaths lastObject]];
+                        [indexedContents setObject:@(fileIndex) forKey:@(currentSnapshot->files[fileIndex].contentHash)];
+                        for (directory = [[indexedPaths lastObject] stringByDeletingLastPathComponent];
+                             [directory length] > 0 && [indexedDirectories containsObject:directory] == NO;
+                             directory = [directory stringByDeletingLastPathComponent]) {
+                                [indexedDirectories addObject:directory];
+                        }
+                }
+        } else {
+                [walked setSet:[NSSet setWithObject:@""]];
+        }
+        fileMap = malloc(sizeof(uint32_t) * MAX(indexedFileCount, 1));
+        memset(fileMap, 0xFF, sizeof(uint32_t) * MAX(indexedFileCount, 1));
+
+        /* List the changed directories */
+        for (NSString * directoryPath in changedDirectories) {
+                if (PLSymbolIndexRelativePathIsWithinAny(directoryPath, walked)) {
+                        continue;
+                }
+                if ([indexedDirectories containsObject:directoryPath] == NO) {
+                        [walked addObject:directoryPath];
+                        continue;
+                }
+                [subdirectories removeAllObjects];
+                if ([self listDirectoryAtPath:directoryPath files:listedFiles subdirectories:subdirectories] == NO) {
+                        [removedDirectories addObject:directoryPath];
+                        continue;
+                }
+                [relistedDirectories addObject:directoryPath];
+                for (NSString * subdirectory in subdirectories) {
+                        [currentSubdirectories addObject:subdirectory];
+                        if ([indexedDirectories containsObject:subdirectory] == NO) {
+                                [walked addObject:subdirectory];
+                        }
+                }
+        }
+
+        /* Drop the subdirectories of listed directories that no longer exist */
+        for (directory in indexedDirectories) {
+                if ([directory length] > 0 &&
+                    [relistedDirectories containsObject:[directory stringByDeletingLastPathComponent]] &&
+                    [currentSubdirectories containsObject:directory] == NO) {
+                        [removedDirectories addObject:directory];
+                }
+        }
+
+        /* Walk new and rescanned directories, skipping those within others */
+        for (NSString * directoryPath in walked) {
+                for (directory in walked) {
+                        if (directory != directoryPath && PLSymbolIndexRelativePathIsWithin(directoryPath, directory)) {
+                                break;
+                        }
+                }
+                if (directory == nil) {
+                        [self listDirectoryTreeAtPath:directoryPath files:listedFiles];
+                }
+        }
+
+        /* Keep the files of every other directory */
+        for (fileIndex = 0; fileIndex < indexedFileCount; fileIndex++) {
+                directory = [[indexedPaths objectAtIndex:fileIndex] stringByDeletingLastPathComponent];
+                if ([relistedDirectories containsObject:directory] ||
+                    PLSymbolIndexRelativePathIsWithinAny(directory, removedDirectories) ||
+                    PLSymbolIndexRelativePathIsWithinAny(directory, walked)) {
+                        continue;
+                }
+                file = &currentSnapshot->files[fileIndex];
+                fileMap[fileIndex] = [builder addFileAtPath:[indexedPaths objectAtIndex:fileIndex]
+                                                contentHash:file->contentHash
+                                           modificationTime:file->modificationTime
+                                                       size:file->size];
+        }
+
+        /* Keep the listed files that did not change */
+        for (PLSymbolIndexListedFile * listedFile in listedFiles) {
+                if ([listedPaths containsObject:listedFile.relativePath]) {
+                        continue;
+                }
+                [listedPaths addObject:listedFile.relativePath];
+                indexedFile = [indexedFiles objectForKey:listedFile.relativePath];
+                file = indexedFile ? &currentSnapshot->files[[indexedFile unsignedIntValue]] : NULL;
+                if (file && fileMap[[indexedFile unsignedIntValue]] == UINT32_MAX &&
+                    file->size == listedFile.size && file->modificationTime == listedFile.modificationTime) {
+                        fileMap[[indexedFile unsignedIntValue]] = [builder addFileAtPath:listedFile.relativePath
+                                                                            contentHash:file->contentHash
+                                                                       modificationTime:file->modificationTime
+                                                                                   size:file->size];
+                } else {
+                        [changedFiles addObject:listedFile];
+                }
+        }
+
+        /* Read and scan the others */
+        for (batchStart = 0; batchStart < [changedFiles count]; batchStart += PLSymbolIndexScanBatchSize) {
+                batch = [changedFiles subarrayWithRange:NSMakeRange(batchStart, MIN(PLSymbolIndexScanBatchSize, [changedFiles count] - batchStart))];
+                dispatch_apply([batch count], dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t batchIndex) {
+                        @autoreleasepool {
+                                [[batch objectAtIndex:batchIndex] readWithRootPath:rootPath indexedContents:indexedContents];
+                        }
+                });
+                for (PLSymbolIndexListedFile * listedFile in batch) {
+                        if (listedFile.read == NO) {
+                                continue;
+                        }
+                        modified = YES;
+                        indexedFile = [indexedContents objectForKey:@(listedFile.contentHash)];
+                        if (indexedFile && fileMap[[indexedFile unsignedIntValue]] == UINT32_MAX) {
+                                fileMap[[indexedFile unsignedIntValue]] = [builder addFileAtPath:listedFile.relativePath
+                                                                                    contentHash:listedFile.contentHash
+                                                                               modificationTime:listedFile.modificationTime
+                                                                                           size:listedFile.size];
+                                reusedCount++;
+                                continue;
+                        }
+                        if (listedFile.symbols == nil) {
+                                contents = [NSData dataWithContentsOfFile:[rootPath stringByAppendingPathComponent:listedFile.relativePath]
+                                                                  options:NSDataReadingMappedIfSafe
+                                                                    error:NULL];
+                                listedFile.symbols = contents ? PLSymbolIndexScanContents(contents) : [NSData data];
+                        }
+                        fileIndex = [builder addFileAtPath:listedFile.relativePath
+                                               contentHash:listedFile.contentHash
+                                          modificationTime:listedFile.modificationTime
+                                                      size:listedFile.size];
+                        if (fileIndex != UINT32_MAX) {
+                                [builder addScannedSymbols:listedFile.symbols fileIndex:fileIndex];
+                                scannedCount++;
+                        }
+                        listedFile.symbols = nil;
+                }
+        }
+
+        if (modified == NO && [builder fileCount] == indexedFileCount) {
+                goto exit;
+        }
+
+        /* Copy the symbols of the files kept */
+        for (nameIndex = 0; currentSnapshot && nameIndex < currentSnapshot->header->nameCount; nameIndex++) {
+                name = &currentSnapshot->names[nameIndex];
+                for (entryIndex = name->firstEntry; entryIndex < name->firstEntry + name->entryCount; entryIndex++) {
+                        entry = &currentSnapshot->entries[entryIndex];
+                        if (fileMap[entry->fileIndex] != UINT32_MAX) {
+                                [builder addSymbolNamed:currentSnapshot->pool + name->nameOffset
+                                                 length:name->nameLength
+                                              fileIndex:fileMap[entry->fileIndex]
+                                                   line:entry->line
+                                                   kind:entry->kind
+                                                  flags:entry->flags];
+                        }
+                }
+        }
+
+        [self setSnapshot:[[[PLSymbolIndexSnapshot alloc] initWithData:[builder dataWithLastEventIdentifier:lastEventIdentifier
+                                                                                    eventHistoryIdentifier:eventHistoryIdentifier]
+                                                              rootPath:self.directoryPath] autorelease]];
+        [self scheduleSave];
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Symbol index: updated %@ in %.2f ms, %u files, %lu scanned, %lu reused by content",
+                      self.directoryPath,
+                      (CACurrentMediaTime() - startTime) * 1000.0,
+                      [builder fileCount],
+                      (unsigned long)scannedCount,
+                      (unsigned long)reusedCount);
+        }
+
+exit:
+        free(fileMap);
+        return;
+}
+
+/**
+ * \brief Write the index to disk after a delay.
+ *
+ * \details This method runs on `indexQueue`. Updates made before the index is
+ *          written are coalesced into a single write. The file is replaced
+ *          atomically, so a snapshot mapping the previous file stays valid.
+ */
+-(void)scheduleSave
+{
+        NSString * indexFilePath = [[self class] indexFilePathForDirectoryAtPath:self.directoryPath];
+
+        if (saveScheduled) {
+                goto exit;
+        }
+        saveScheduled = YES;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(PLSymbolIndexSaveDelay * NSEC_PER_SEC)), indexQueue, ^{
+                @autoreleasepool {
+                        saveScheduled = NO;
+                        [[NSFileManager defaultManager] createDirectoryAtPath:[indexFilePath stringByDeletingLastPathComponent]
+                                                  withIntermediateDirectories:YES
+                                                                   attributes:nil
+                                                                        error:NULL];
+                        [[self currentSnapshot]->data writeToFile:indexFilePath atomically:YES];
+                }
+        });
+
+exit:
+        return;
+}
+
+#pragma mark - Queries
+
+/**
+ * \brief Add the entries of a name of some kinds to an array of locations.
+ *
+ * \param nameIndex The index of the name in the snapshot.
+ *
+ * \param firstKind The first kind added.
+ *
+ * \param lastKind The last kind added.
+ *
+ * \param currentSnapshot The snapshot.
+ *
+ * \param locations The array of `PLSymbolLocation`s added to.
+ *
+ * \param maximumCount The number of locations the array may hold.
+ */
+-(void)addEntriesOfNameAtIndex:(uint32_t)nameIndex
+                      fromKind:(PLPythonSymbolKind)firstKind
+                        toKind:(PLPythonSymbolKind)lastKind
+                    inSnapshot:(PLSymbolIndexSnapshot *)currentSnapshot
+                   toLocations:(NSMutableArray *)locations
+                  maximumCount:(NSUInteger)maximumCount
+{
+        const PLSymbolIndexName * name = &currentSnapshot->names[nameIndex];
+        const PLSymbolIndexEntry * entry = NULL;
+        NSString * nameString = nil;
+        uint32_t entryIndex = 0;
+
+        for (entryIndex = name->firstEntry; entryIndex < name->firstEntry + name->entryCount && [locations count] < maximumCount; entryIndex++) {
+                entry = &currentSnapshot->entries[entryIndex];
+                if (entry->kind < firstKind) {
+                        continue;
+                } else if (entry->kind > lastKind) {
+                        break;
+                }
+                if (nameString == nil) {
+                        nameString = [currentSnapshot nameAtIndex:nameIndex];
+                }
+                [locations addObject:[PLSymbolLocation locationWithName:nameString
+                                                                   path:[self.directoryPath stringByAppendingPathComponent:
+                                                                         [currentSnapshot relativePathOfFileAtIndex:entry->fileIndex]]
+                                                                   line:entry->line
+                                                                   kind:entry->kind
+                                                               topLevel:(entry->flags & PLSymbolIndexEntryTopLevel) != 0]];
+        }
+}
+
+/**
+ * \brief Find the entries of a name of some kinds.
+ *
+ * \param name The name, matched exactly.
+ *
+ * \param firstKind The first kind returned.
+ *
+ * \param lastKind The last kind returned.
+ *
+ * \param maximumCount The maximum number of results.
+ *
+ * \return An array of `PLSymbolLocation`s.
+ */
+-(NSArray *)locationsOfSymbolNamed:(NSString *)name
+                          fromKind:(PLPythonSymbolKind)firstKind
+                            toKind:(PLPythonSymbolKind)lastKind
+                      maximumCount:(NSUInteger)maximumCount
+{
+        PLSymbolIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        NSMutableArray * locations = [NSMutableArray array];
+        const char * nameRepresentation = [name UTF8String];
+        CFTimeInterval startTime = CACurrentMediaTime();
+        uint32_t nameIndex = UINT32_MAX;
+
+        if (currentSnapshot == nil || nameRepresentation == NULL) {
+                goto exit;
+        }
+        nameIndex = [currentSnapshot indexOfName:nameRepresentation length:strlen(nameRepresentation)];
+        if (nameIndex != UINT32_MAX) {
+                [self addEntriesOfNameAtIndex:nameIndex
+                                     fromKind:firstKind
+                                       toKind:lastKind
+                                   inSnapshot:currentSnapshot
+                                  toLocations:locations
+                                 maximumCount:maximumCount];
+        }
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Symbol index: found %lu locations of %@ in %.3f ms",
+                      (unsigned long)[locations count],
+                      name,
+                      (CACurrentMediaTime() - startTime) * 1000.0);
+        }
+
+exit:
+        return locations;
+}
+
+-(NSArray *)definitionsOfSymbolNamed:(NSString *)name maximumCount:(NSUInteger)maximumCount
+{
+        return [self locationsOfSymbolNamed:name fromKind:PLPythonSymbolClass toKind:PLPythonSymbolVariable maximumCount:maximumCount];
+}
+
+-(NSArray *)referencesToSymbolNamed:(NSString *)name maximumCount:(NSUInteger)maximumCount
+{
+        return [self locationsOfSymbolNamed:name fromKind:PLPythonSymbolReference toKind:PLPythonSymbolReference maximumCount:maximumCount];
+}
+
+-(NSArray *)importsOfModuleNamed:(NSString *)moduleName maximumCount:(NSUInteger)maximumCount
+{
+        return [self locationsOfSymbolNamed:moduleName fromKind:PLPythonSymbolImport toKind:PLPythonSymbolImport maximumCount:maximumCount];
+}
+
+-(NSArray *)definitionsWithPrefix:(NSString *)prefix maximumCount:(NSUInteger)maximumCount
+{
+        PLSymbolIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        NSMutableArray * locations = [NSMutableArray array];
+        const char * prefixRepresentation = [prefix UTF8String];
+        CFTimeInterval startTime = CACurrentMediaTime();
+        size_t prefixLength = 0;
+        uint32_t nameIndex = 0;
+
+        if (currentSnapshot == nil || prefixRepresentation == NULL) {
+                goto exit;
+        }
+        prefixLength = strlen(prefixRepresentation);
+        for (nameIndex = [currentSnapshot indexOfFirstNameWithPrefix:prefixRepresentation length:prefixLength];
+             nameIndex < currentSnapshot->header->nameCount && [locations count] < maximumCount &&
+             PLSymbolIndexComparePrefix(currentSnapshot->pool + currentSnapshot->names[nameIndex].nameOffset,
+                                        currentSnapshot->names[nameIndex].nameLength,
+                                        prefixRepresentation, prefixLength) == 0;
+             nameIndex++) {
+                [self addEntriesOfNameAtIndex:nameIndex
+                                     fromKind:PLPythonSymbolClass
+                                       toKind:PLPythonSymbolVariable
+                                   inSnapshot:currentSnapshot
+                                  toLocations:locations
+                                 maximumCount:maximumCount];
+        }
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Symbol index: found %lu definitions starting with %@ in %.3f ms",
+                      (unsigned long)[locations count],
+                      prefix,
+                      (CACurrentMediaTime() - startTime) * 1000.0);
+        }
+
+exit:
+        return locations;
+}
+
+-(void)enumerateDefinedNamesUsingBlock:(void (^)(const char * name, size_t length, PLPythonSymbolKind kind, BOOL topLevel, NSUInteger referenceCount))block
+{
+        PLSymbolIndexSnapshot * currentSnapshot = [self currentSnapshot];
+        const PLSymbolIndexName * name = NULL;
+        const PLSymbolIndexEntry * firstEntry = NULL, * entry = NULL;
+        NSUInteger referenceCount = 0;
+        uint32_t nameIndex = 0;
+
+        for (nameIndex = 0; currentSnapshot != nil && nameIndex < currentSnapshot->header->nameCount; nameIndex++) {
+                name = &currentSnapshot->names[nameIndex];
+                firstEntry = &currentSnapshot->entries[name->firstEntry];
+                if (name->entryCount == 0 || firstEntry->kind > PLPythonSymbolVariable) {
+                        continue;
+                }
+                referenceCount = 0;
+                for (entry = firstEntry + name->entryCount; entry > firstEntry && (entry - 1)->kind == PLPythonSymbolReference; entry--) {
+                        referenceCount++;
+                }
+                block(currentSnapshot->pool + name->nameOffset,
+                      name->nameLength,
+                      firstEntry->kind,
+                      (firstEntry->flags & PLSymbolIndexEntryTopLevel) != 0,
+                      referenceCount);
+        }
+}
+
+@end
@@ -0,0 +1,201 @@
+/**
+ * \file PLPythonLexer.h
+ *
+ * \brief Liasis Python IDE Python lexer.
+ *
+ * \details This file includes the line by line lexer of Python source used to
+ *          highlight documents.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief The string a line starts in.
+ */
+typedef NS_ENUM(uint8_t, PLPythonStringKind) {
+        /**
+         * \brief The line does not start in a string.
+         */
+        PLPythonStringNone,
+
+        /**
+         * \brief A single quoted string continued by a backslash.
+         */
+        PLPythonStringSingleQuote,
+
+        /**
+         * \brief A double quoted string continued by a backslash.
+         */
+        PLPythonStringDoubleQuote,
+
+        /**
+         * \brief A string between three single quotes.
+         */
+        PLPythonStringTripleSingleQuote,
+
+        /**
+         * \brief A string between three double quotes.
+         */
+        PLPythonStringTripleDoubleQuote
+};
+
+/**
+ * \brief The flag of a state that has not been computed.
+ */
+extern const uint8_t PLPythonLexerStateUnknown;
+
+/**
+ * \brief The state of the lexer at the start of a line.
+ *
+ * \details The state is all the lexer needs to lex a line without the lines
+ *          before it, so it is cached for each line, and lexing after an edit
+ *          can stop at the first line whose state did not change.
+ */
+typedef struct {
+        /**
+         * \brief The string the line starts in.
+         */
+        PLPythonStringKind string;
+
+        /**
+         * \brief `PLPythonLexerStateUnknown` or 0.
+         */
+        uint8_t flags;
+
+        /**
+         * \brief The number of brackets open at the start of the line.
+         */
+        uint16_t nesting;
+} PLPythonLexerState;
+
+/**
+ * \brief The kind of a token.
+ *
+ * \details Only the kinds that are colored are reported.
+ */
+typedef NS_ENUM(uint8_t, PLPythonTokenKind) {
+        /**
+         * \brief A comment.
+         */
+        PLPythonTokenComment,
+
+        /**
+         * \brief A single or double quoted string.
+         */
+        PLPythonTokenString,
+
+        /**
+         * \brief A string between triple quotes.
+         */
+        PLPythonTokenDocstring,
+
+        /**
+         * \brief A number.
+         */
+        PLPythonTokenNumber,
+
+        /**
+         * \brief A keyword.
+         */
+        PLPythonTokenKeyword,
+
+        /**
+         * \brief `True`, `False`, or `None`.
+         */
+        PLPythonTokenBuiltinConstant,
+
+        /**
+         * \brief The name following `class`.
+         */
+        PLPythonTokenClassName,
+
+        /**
+         * \brief The name following `def`.
+         */
+        PLPythonTokenFunctionName,
+
+        /**
+         * \brief The number of token kinds.
+         */
+        PLPythonTokenKindCount
+};
+
+/**
+ * \brief A token of a line.
+ */
+typedef struct {
+        /**
+         * \brief The index of the first character of the token in the line.
+         */
+        NSUInteger location;
+
+        /**
+         * \brief The number of characters of the token.
+         */
+        NSUInteger length;
+
+        /**
+         * \brief The kind of the token.
+         */
+        PLPythonTokenKind kind;
+} PLPythonToken;
+
+/**
+ * \brief The state of the lexer at the start of a document.
+ */
+extern const PLPythonLexerState PLPythonLexerInitialState;
+
+/**
+ * \brief Return if two lexer states are equal.
+ *
+ * \details An unknown state is not equal to any state.
+ *
+ * \param state The first state.
+ *
+ * \param otherState The second state.
+ *
+ * \return YES if lexing from either state gives the same tokens.
+ */
+BOOL PLPythonLexerStateEqual(PLPythonLexerState state, PLPythonLexerState otherState);
+
+/**
+ * \brief Lex a line of Python source.
+ *
+ * \details The lexer is a single pass over the characters of the line, with
+ *          no allocation, and may be called from any thread.
+ *
+ * \param characters The characters of the line, without its line feed.
+ *
+ * \param length The number of characters.
+ *
+ * \param state The state at the start of the line.
+ *
+ * \param tokens An array of at least `length` tokens, filled with the tokens of
+ *               the line, or NULL to only compute the state.
+ *
+ * \param tokenCount Set to the number of tokens, if `tokens` is not NULL.
+ *
+ * \return The state at the start of the next line.
+ */
+PLPythonLexerState PLPythonLexLine(const unichar * characters, NSUInteger length, PLPythonLexerState state, PLPythonToken * tokens, NSUInteger * tokenCount);
@@ -0,0 +1,357 @@
+/**
+ * \file PLPythonLexer.m
+ *
+ * \brief Liasis Python IDE Python lexer.
+ *
+ * \details This file includes the line by line lexer of Python source used to
+ *          highlight documents.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLPythonLexer.h"
+
+const uint8_t PLPythonLexerStateUnknown = 1 << 0;
+
+const PLPythonLexerState PLPythonLexerInitialState = {PLPythonStringNone, 0, 0};
+
+/**
+ * \brief The length of the longest keyword.
+ */
+static const NSUInteger PLPythonKeywordMaximumLength = 8;
+
+/**
+ * \brief The keywords of Python, sorted.
+ */
+static const char * const PLPythonKeywords[] = {
+        "and", "as", "assert", "async", "await", "break", "class", "continue",
+        "def", "del", "elif", "else", "except", "exec", "finally", "for",
+        "from", "global", "if", "import", "in", "is", "lambda", "nonlocal",
+        "not", "or", "pass", "print", "raise", "return", "try", "while",
+        "with", "yield"
+};
+
+/**
+ * \brief The built in constants of Python, sorted.
+ */
+static const char * const PLPythonBuiltinConstants[] = {
+        "False", "None", "True"
+};
+
+BOOL PLPythonLexerStateEqual(PLPythonLexerState state, PLPythonLexerState otherState)
+{
+        return ((state.flags | otherState.flags) & PLPythonLexerStateUnknown) == 0 &&
+               state.string == otherState.string &&
+               state.nesting == otherState.nesting;
+}
+
+/**
+ * \brief Return if a character may start an identifier.
+ *
+ * \details Characters outside ASCII are taken as letters.
+ */
+static inline BOOL PLPythonIsIdentifierStart(unichar character)
+{
+        return character == '_' || (unichar)((character | 0x20) - 'a') < 26 || character >= 0x80;
+}
+
+/**
+ * \brief Return if a character is a decimal digit.
+ */
+static inline BOOL PLPythonIsDigit(unichar character)
+{
+        return (unichar)(character - '0') < 10;
+}
+
+/**
+ * \brief Return if a character may continue an identifier or a number.
+ */
+static inline BOOL PLPythonIsIdentifierCharacter(unichar character)
+{
+        return PLPythonIsIdentifierStart(character) || PLPythonIsDigit(character);
+}
+
+/**
+ * \brief Copy a word into a C string if it is short enough to be a keyword.
+ *
+ * \param characters The characters of the word.
+ *
+ * \param length The number of characters.
+ *
+ * \param word A buffer of `PLPythonKeywordMaximumLength + 1` characters.
+ *
+ * \return YES if the word was copied.
+ */
+static BOOL PLPythonCopyWord(const unichar * characters, NSUInteger length, char * word)
+{
+        NSUInteger index = 0;
+        BOOL copied = NO;
+
+        if (length > PLPythonKeywordMaximumLength) {
+                goto exit;
+        }
+        for (index = 0; index < length; index++) {
+                if (characters[index] >= 0x80) {
+                        goto exit;
+                }
+                word[index] = (char)characters[index];
+        }
+        word[length] = '\0';
+        copied = YES;
+
+exit:
+        return copied;
+}
+
+/**
+ * \brief Return if a word is in a sorted table.
+ */
+static BOOL PLPythonWordIsInTable(const char * word, const char * const * table, NSUInteger count)
+{
+        NSUInteger low = 0, high = count, middle = 0;
+        int order = 1;
+
+        while (low < high && order != 0) {
+                middle = low + (high - low) / 2;
+                order = strcmp(word, table[middle]);
+                if (order < 0) {
+                        high = middle;
+                } else if (order > 0) {
+                        low = middle + 1;
+                }
+        }
+        return order == 0;
+}
+
+/**
+ * \brief Return if an identifier followed by a quote is a string prefix.
+ *
+ * \details Prefixes are one or two of the letters r, b, u, and f.
+ */
+static BOOL PLPythonIsStringPrefix(const unichar * characters, NSUInteger length)
+{
+        NSUInteger index = 0;
+        BOOL prefix = (length == 1 || length == 2);
+
+        for (index = 0; index < length && prefix; index++) {
+                switch (characters[index] | 0x20) {
+                        case 'r':
+                        case 'b':
+                        case 'u':
+                        case 'f':
+                                break;
+                        default:
+                                prefix = NO;
+                                break;
+                }
+        }
+        return prefix;
+}
+
+/**
+ * \brief Scan the characters of a string up to and including its closing
+ *        quotes.
+ *
+ * \details A backslash escapes the next character, in raw strings too. A
+ *          single quoted string that is not closed continues on the next line
+ *          only if the line ends with a backslash.
+ *
+ * \param characters The characters of the line.
+ *
+ * \param length The number of characters.
+ *
+ * \param index The index of the first character of the string after its
+ *              opening quotes, set to the index following the string.
+ *
+ * \param kind The kind of the string.
+ *
+ * \return The string the next line starts in.
+ */
+static PLPythonStringKind PLPythonScanString(const unichar * characters, NSUInteger length, NSUInteger * index, PLPythonStringKind kind)
+{
+        BOOL triple = (kind == PLPythonStringTripleSingleQuote || kind == PLPythonStringTripleDoubleQuote);
+        unichar quote = (kind == PLPythonStringSingleQuote || kind == PLPythonStringTripleSingleQuote) ? '\'' : '"';
+        NSUInteger location = *index;
+        PLPythonStringKind continued = kind;
+
+        while (location < length) {
+                if (characters[location] == '\\') {
+                        location += 2;
+                } else if (characters[location] == quote &&
+                           (triple == NO || (location + 2 < length && characters[location + 1] == quote && characters[location + 2] == quote))) {
+                        location += triple ? 3 : 1;
+                        continued = PLPythonStringNone;
+                        goto exit;
+                } else {
+                        location++;
+                }
+        }
+        if (triple == NO && location == length) {
+                continued = PLPythonStringNone;
+        }
+
+exit:
+        *index = MIN(location, length);
+        return continued;
+}
+
+/**
+ * \brief Scan a string from its opening quotes.
+ *
+ * \param characters The characters of the line.
+ *
+ * \param length The number of characters.
+ *
+ * \param index The index of the opening quote, set to the index following the
+ *              string.
+ *
+ * \param tokenKind Set to the kind of the token of the string.
+ *
+ * \return The string the next line starts in.
+ */
+static PLPythonStringKind PLPythonScanOpenedString(const unichar * characters, NSUInteger length, NSUInteger * index, PLPythonTokenKind * tokenKind)
+{
+        unichar quote = characters[*index];
+        BOOL triple = (*index + 2 < length && characters[*index + 1] == quote && characters[*index + 2] == quote);
+        PLPythonStringKind kind = PLPythonStringNone;
+
+        if (triple) {
+                kind = (quote == '\'') ? PLPythonStringTripleSingleQuote : PLPythonStringTripleDoubleQuote;
+                *index += 3;
+                *tokenKind = PLPythonTokenDocstring;
+        } else {
+                kind = (quote == '\'') ? PLPythonStringSingleQuote : PLPythonStringDoubleQuote;
+                *index += 1;
+                *tokenKind = PLPythonTokenString;
+        }
+        return PLPythonScanString(characters, length, index, kind);
+}
+
+/**
+ * \brief Scan a number.
+ *
+ * \details The digits, letters, underscores, and points following the first
+ *          digit are taken, and signs following the exponent of a decimal
+ *          number.
+ *
+ * \return The index following the number.
+ */
+static NSUInteger PLPythonScanNumber(const unichar * characters, NSUInteger length, NSUInteger index)
+{
+        BOOL hexadecimal = (index + 1 < length && characters[index] == '0' && (characters[index + 1] | 0x20) == 'x');
+        unichar character = 0;
+
+        while (index < length) {
+                character = characters[index];
+                if (PLPythonIsIdentifierCharacter(character) || character == '.') {
+                        index++;
+                } else if ((character == '+' || character == '-') && hexadecimal == NO && (characters[index - 1] | 0x20) == 'e') {
+                        index++;
+                } else {
+                        break;
+                }
+        }
+        return index;
+}
+
+/**
+ * \brief Append a token if the caller asked for tokens.
+ */
+static inline void PLPythonAddToken(PLPythonToken * tokens, NSUInteger * count, NSUInteger start, NSUInteger end, PLPythonTokenKind kind)
+{
+        if (tokens && end > start) {
+                tokens[*count] = (PLPythonToken){start, end - start, kind};
+                (*count)++;
+        }
+}
+
+PLPythonLexerState PLPythonLexLine(const unichar * characters, NSUInteger length, PLPythonLexerState state, PLPythonToken * tokens, NSUInteger * tokenCount)
+{
+        NSUInteger index = 0, start = 0, count = 0;
+        PLPythonTokenKind kind = PLPythonTokenString, nameKind = PLPythonTokenKindCount, definitionKind = PLPythonTokenKindCount;
+        char word[PLPythonKeywordMaximumLength + 1];
+        unichar character = 0;
+
+        state.flags = 0;
+        if (state.string != PLPythonStringNone) {
+                kind = (state.string == PLPythonStringTripleSingleQuote || state.string == PLPythonStringTripleDoubleQuote) ? PLPythonTokenDocstring : PLPythonTokenString;
+                state.string = PLPythonScanString(characters, length, &index, state.string);
+                PLPythonAddToken(tokens, &count, 0, index, kind);
+        }
+        while (index < length) {
+                character = characters[index];
+                start = index;
+                if (character == ' ' || character == '\t') {
+                        index++;
+                        continue;
+                }
+                definitionKind = nameKind;
+                nameKind = PLPythonTokenKindCount;
+                if (character == '#') {
+                        index = length;
+                        PLPythonAddToken(tokens, &count, start, index, PLPythonTokenComment);
+                } else if (character == '\'' || character == '"') {
+                        state.string = PLPythonScanOpenedString(characters, length, &index, &kind);
+                        PLPythonAddToken(tokens, &count, start, index, kind);
+                } else if (PLPythonIsDigit(character) || (character == '.' && index + 1 < length && PLPythonIsDigit(characters[index + 1]))) {
+                        index = PLPythonScanNumber(characters, length, index);
+                        PLPythonAddToken(tokens, &count, start, index, PLPythonTokenNumber);
+                } else if (PLPythonIsIdentifierStart(character)) {
+                        while (index < length && PLPythonIsIdentifierCharacter(characters[index])) {
+                                index++;
+                        }
+                        if (index < length && (characters[index] == '\'' || characters[index] == '"') &&
+                            PLPythonIsStringPrefix(characters + start, index - start)) {
+                                state.string = PLPythonScanOpenedString(characters, length, &index, &kind);
+                                PLPythonAddToken(tokens, &count, start, index, kind);
+                        } else if (definitionKind != PLPythonTokenKindCount) {
+                                PLPythonAddToken(tokens, &count, start, index, definitionKind);
+                        } else if (PLPythonCopyWord(characters + start, index - start, word)) {
+                                if (PLPythonWordIsInTable(word, PLPythonKeywords, sizeof(PLPythonKeywords) / sizeof(PLPythonKeywords[0]))) {
+                                        PLPythonAddToken(tokens, &count, start, index, PLPythonTokenKeyword);
+                                        if (strcmp(word, "def") == 0) {
+                                                nameKind = PLPythonTokenFunctionName;
+                                        } else if (strcmp(word, "class") == 0) {
+                                                nameKind = PLPythonTokenClassName;
+                                        }
+                                } else if (PLPythonWordIsInTable(word, PLPythonBuiltinConstants, sizeof(PLPythonBuiltinConstants) / sizeof(PLPythonBuiltinConstants[0]))) {
+                                        PLPythonAddToken(tokens, &count, start, index, PLPythonTokenBuiltinConstant);
+                                }
+                        }
+                } else {
+                        if (character == '(' || character == '[' || character == '{') {
+                                if (state.nesting < UINT16_MAX) {
+                                        state.nesting++;
+                                }
+                        } else if (character == ')' || character == ']' || character == '}') {
+                                if (state.nesting > 0) {
+                                        state.nesting--;
+                                }
+                        }
+                        index++;
+                }
+        }
+        if (tokens) {
+                *tokenCount = count;
+        }
+        return state;
+}
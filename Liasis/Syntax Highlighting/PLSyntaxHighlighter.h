@@ -0,0 +1,163 @@
+/**
+ * \file PLSyntaxHighlighter.h
+ *
+ * \brief Liasis Python IDE syntax highlighter.
+ *
+ * \details This file includes the incremental highlighter coloring the Python
+ *          source of a text view.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+
+/**
+ * \brief The number of characters lexed by one pass in the background.
+ */
+extern const NSUInteger PLSyntaxHighlighterWindowLength;
+
+/**
+ * \brief A line of a highlighted text.
+ */
+struct PLSyntaxLine;
+
+/**
+ * \class PLSyntaxHighlighter \headerfile \headerfile
+ *
+ * \brief Colors the Python source of a text view, relexing only what an edit
+ *        changes.
+ *
+ * \details The highlighter caches the `PLPythonLexerState` at the start of
+ *          each line. An edit only updates the lines around it, and the lines
+ *          are relexed from the edited line until the state at the start of a
+ *          line is the cached one, past the lines edited since the last pass.
+ *          Typing inside a line therefore relexes that line, however long the
+ *          text, while opening a triple quoted string relexes until it closes.
+ *
+ *          The lines are kept in a gap buffer whose gap follows the edits.
+ *          Lines before the gap record their start, and lines after it their
+ *          distance from the end of the text, so an edit does not shift the
+ *          lines after it.
+ *
+ *          Lexing runs on a background queue, against an immutable copy of at
+ *          most `PLSyntaxHighlighterWindowLength` characters, and is coalesced
+ *          so the edits of one pass of the run loop are lexed once. A pass
+ *          whose text was edited meanwhile is dropped and started again. Only
+ *          the lines in the visible rectangle are colored, with temporary
+ *          attributes of the layout manager, which leave the text storage and
+ *          the undo stack untouched; other lines are colored when scrolled
+ *          into view. The colors are those of `PLThemeTable`.
+ *
+ *          A highlighter must be used from the main thread.
+ */
+@interface PLSyntaxHighlighter : NSObject
+{
+        /**
+         * \brief The highlighted text view, or nil once detached.
+         */
+        NSTextView * textView;
+
+        /**
+         * \brief The lines of the text, with the gap.
+         */
+        struct PLSyntaxLine * lines;
+
+        /**
+         * \brief The number of lines `lines` can hold.
+         */
+        NSUInteger lineCapacity;
+
+        /**
+         * \brief The index of the first line of the gap.
+         */
+        NSUInteger gapStart;
+
+        /**
+         * \brief The index following the last line of the gap.
+         */
+        NSUInteger gapEnd;
+
+        /**
+         * \brief The length of the text.
+         */
+        NSUInteger textLength;
+
+        /**
+         * \brief The first line whose state may be stale, or `NSNotFound`.
+         */
+        NSUInteger dirtyFrom;
+
+        /**
+         * \brief The line from which lexing may stop at a cached state.
+         */
+        NSUInteger dirtyUntil;
+
+        /**
+         * \brief Incremented by each edit, so a pass lexing older text is
+         *        dropped.
+         */
+        NSUInteger generation;
+
+        /**
+         * \brief YES while a pass is scheduled.
+         */
+        BOOL passScheduled;
+
+        /**
+         * \brief YES while a pass is lexing in the background.
+         */
+        BOOL passRunning;
+
+        /**
+         * \brief The serial queue lexing in the background.
+         */
+        dispatch_queue_t queue;
+
+        /**
+         * \brief The number of edits since the last finished pass.
+         */
+        NSUInteger pendingEdits;
+
+        /**
+         * \brief The time spent updating the lines for those edits, in
+         *        seconds.
+         */
+        CFTimeInterval pendingUpdateTime;
+}
+
+/**
+ * \brief Create a highlighter and start highlighting a text view.
+ *
+ * \param aTextView The text view of a Python document.
+ *
+ * \return A highlighter on the autorelease pool.
+ */
++(instancetype)highlighterWithTextView:(NSTextView *)aTextView;
+
+/**
+ * \brief Stop highlighting and remove the colors from the text view.
+ *
+ * \details Called when the text view's tab is unloaded or closed.
+ */
+-(void)detach;
+
+@end
@@ -0,0 +1,675 @@
+/**
+ * \file PLSyntaxHighlighter.m
+ *
+ * \brief Liasis Python IDE syntax highlighter.
+ *
+ * \details This file includes the incremental highlighter coloring the Python
+ *          source of a text view.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <QuartzCore/QuartzCore.h>
+#import "PLSyntaxHighlighter.h"
+#import "PLUserDefaults.h"
+#import "PLPythonLexer.h"
+#import "PLThemeTable.h"
+
+const NSUInteger PLSyntaxHighlighterWindowLength = 64 * 1024;
+
+/**
+ * \brief The number of lines allocated when the line buffer first grows.
+ */
+static const NSUInteger PLSyntaxHighlighterInitialLineCapacity = 1024;
+
+/**
+ * \brief The theme color of each token kind.
+ */
+static const PLThemeColor PLSyntaxHighlighterTokenColors[PLPythonTokenKindCount] = {
+        [PLPythonTokenComment] = PLThemeColorComment,
+        [PLPythonTokenString] = PLThemeColorString,
+        [PLPythonTokenDocstring] = PLThemeColorDocstring,
+        [PLPythonTokenNumber] = PLThemeColorNumber,
+        [PLPythonTokenKeyword] = PLThemeColorKeyword,
+        [PLPythonTokenBuiltinConstant] = PLThemeColorBuiltinConstant,
+        [PLPythonTokenClassName] = PLThemeColorClassName,
+        [PLPythonTokenFunctionName] = PLThemeColorFunctionName
+};
+
+/**
+ * \brief A line of a highlighted text.
+ */
+struct PLSyntaxLine {
+        /**
+         * \brief The index of the first character of the line before the gap,
+         *        or its distance from the end of the text after the gap.
+         */
+        NSUInteger start;
+
+        /**
+         * \brief The state of the lexer at the start of the line.
+         */
+        PLPythonLexerState state;
+
+        /**
+         * \brief YES if the line is colored for its current text and state.
+         */
+        BOOL colored;
+};
+
+typedef struct PLSyntaxLine PLSyntaxLine;
+
+/**
+ * \brief Lex a window of lines.
+ *
+ * \details Lexing stops at the end of the window, or at the first line from
+ *          `untilLine` whose state is its cached state.
+ *
+ * \param text The text of the lines, separated by line feeds.
+ *
+ * \param location The index of the text in the document.
+ *
+ * \param firstLine The line number of the first line.
+ *
+ * \param lineCount The number of lines.
+ *
+ * \param untilLine The line from which lexing may stop at a cached state.
+ *
+ * \param visibleLines The lines whose tokens are returned.
+ *
+ * \param states The cached states at the start of the lines and of the line
+ *               following them, replaced by the lexed states.
+ *
+ * \param tokens An array large enough for the tokens of the visible lines,
+ *               filled with them at their location in the document.
+ *
+ * \param tokenCount Set to the number of tokens.
+ *
+ * \param converged Set to YES if lexing stopped at a cached state.
+ *
+ * \return The number of lines lexed.
+ */
+static NSUInteger PLSyntaxHighlighterLexLines(NSString * text, NSUInteger location, NSUInteger firstLine, NSUInteger lineCount, NSUInteger untilLine, NSRange visibleLines,
+                                              PLPythonLexerState * states, PLPythonToken * tokens, NSUInteger * tokenCount, BOOL * converged)
+{
+        NSUInteger length = [text length], lineStart = 0, lineEnd = 0, index = 0, lexedLines = 0, lineTokenCount = 0, token = 0;
+        unichar * characters = malloc(MAX(length, 1) * sizeof(unichar));
+        PLPythonToken * lineTokens = NULL;
+        PLPythonLexerState state;
+
+        [text getCharacters:characters range:NSMakeRange(0, length)];
+        *tokenCount = 0;
+        *converged = NO;
+        for (index = 0; index < lineCount && *converged == NO; index++) {
+                lineEnd = lineStart;
+                while (lineEnd < length && characters[lineEnd] != '\n') {
+                        lineEnd++;
+                }
+                lineTokens = NSLocationInRange(firstLine + index, visibleLines) ? tokens + *tokenCount : NULL;
+                state = PLPythonLexLine(characters + lineStart, lineEnd - lineStart, states[index], lineTokens, &lineTokenCount);
+                if (lineTokens) {
+                        for (token = 0; token < lineTokenCount; token++) {
+                                lineTokens[token].location += location + lineStart;
+                        }
+                        *tokenCount += lineTokenCount;
+                }
+                *converged = (firstLine + index + 1 >= untilLine && PLPythonLexerStateEqual(state, states[index + 1]));
+                states[index + 1] = state;
+                lineStart = lineEnd + 1;
+                lexedLines++;
+        }
+        free(characters);
+        return lexedLines;
+}
+
+@implementation PLSyntaxHighlighter
+
+#pragma mark - Object Lifecycle
+
+/**
+ * \brief Initialize a highlighter and start highlighting a text view.
+ *
+ * \details The text is scanned for its lines, which are then lexed in the
+ *          background from the first.
+ *
+ * \param aTextView The text view of a Python document.
+ *
+ * \return The initialized highlighter.
+ */
+-(instancetype)initWithTextView:(NSTextView *)aTextView
+{
+        NSClipView * clipView = nil;
+
+        self = [super init];
+        if (self) {
+                textView = [aTextView retain];
+                textLength = [[textView textStorage] length];
+                queue = dispatch_queue_create("org.liasis.syntaxhighlighter.lex", DISPATCH_QUEUE_SERIAL);
+                [self insertLineWithStart:0];
+                [self lineAtIndex:0]->state = PLPythonLexerInitialState;
+                [self insertLinesInRange:NSMakeRange(0, textLength)];
+                dirtyFrom = 0;
+                dirtyUntil = [self lineCount];
+
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(textStorageDidProcessEditing:)
+                                                             name:NSTextStorageDidProcessEditingNotification
+                                                           object:[textView textStorage]];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(themeTableDidChange:)
+                                                             name:PLThemeTableDidChangeNotification
+                                                           object:nil];
+                clipView = [[textView enclosingScrollView] contentView];
+                if (clipView) {
+                        [clipView setPostsBoundsChangedNotifications:YES];
+                        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                                 selector:@selector(visibleRectDidChange:)
+                                                                     name:NSViewBoundsDidChangeNotification
+                                                                   object:clipView];
+                        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                                 selector:@selector(visibleRectDidChange:)
+                                                                     name:NSViewFrameDidChangeNotification
+                                                                   object:clipView];
+                }
+                [self schedulePass];
+        }
+        return self;
+}
+
++(instancetype)highlighterWithTextView:(NSTextView *)aTextView
+{
+        return [[[self alloc] initWithTextView:aTextView] autorelease];
+}
+
+-(void)dealloc
+{
+        [self detach];
+        free(lines);
+        dispatch_release(queue);
+        [super dealloc];
+}
+
+-(void)detach
+{
+        if (textView == nil) {
+                goto exit;
+        }
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [[textView layoutManager] removeTemporaryAttribute:NSForegroundColorAttributeName
+                                         forCharacterRange:NSMakeRange(0, [[textView textStorage] length])];
+        [textView release];
+        textView = nil;
+
+exit:
+        return;
+}
+
+#pragma mark - Lines
+
+/**
+ * \brief Return the number of lines.
+ *
+ * \return One more than the number of line feeds of the text.
+ */
+-(NSUInteger)lineCount
+{
+        return lineCapacity - (gapEnd - gapStart);
+}
+
+/**
+ * \brief Return a line.
+ *
+ * \param index The line number, less than the number of lines.
+ *
+ * \return A pointer to the line, valid until the lines are next changed.
+ */
+-(PLSyntaxLine *)lineAtIndex:(NSUInteger)index
+{
+        return (index < gapStart) ? &lines[index] : &lines[index + gapEnd - gapStart];
+}
+
+/**
+ * \brief Return the index of the first character of a line.
+ *
+ * \param index The line number, less than the number of lines.
+ *
+ * \return The index of the character.
+ */
+-(NSUInteger)startOfLine:(NSUInteger)index
+{
+        return (index < gapStart) ? lines[index].start : textLength - lines[index + gapEnd - gapStart].start;
+}
+
+/**
+ * \brief Return the index following the last character of a line, before its
+ *        line feed.
+ *
+ * \param index The line number, less than the number of lines.
+ *
+ * \return The index of the line feed, or the length of the text for the last
+ *         line.
+ */
+-(NSUInteger)endOfLine:(NSUInteger)index
+{
+        return (index + 1 < [self lineCount]) ? [self startOfLine:index + 1] - 1 : textLength;
+}
+
+/**
+ * \brief Return the line containing a character.
+ *
+ * \param location The index of the character, up to the length of the text.
+ *
+ * \return The line number.
+ */
+-(NSUInteger)lineForLocation:(NSUInteger)location
+{
+        NSUInteger low = 0, high = [self lineCount], middle = 0;
+
+        while (high - low > 1) {
+                middle = low + (high - low) / 2;
+                if ([self startOfLine:middle] <= location) {
+                        low = middle;
+                } else {
+                        high = middle;
+                }
+        }
+        return low;
+}
+
+/**
+ * \brief Move the gap before a line.
+ *
+ * \details The lines crossed by the gap switch between recording their start
+ *          and their distance from the end of the text.
+ *
+ * \param index The line number, up to the number of lines.
+ */
+-(void)moveGapToIndex:(NSUInteger)index
+{
+        while (gapStart > index) {
+                gapStart--;
+                gapEnd--;
+                lines[gapEnd] = lines[gapStart];
+                lines[gapEnd].start = textLength - lines[gapEnd].start;
+        }
+        while (gapStart < index) {
+                lines[gapStart] = lines[gapEnd];
+                lines[gapStart].start = textLength - lines[gapStart].start;
+                gapStart++;
+                gapEnd++;
+        }
+}
+
+/**
+ * \brief Insert a line at the gap, growing the buffer if the gap is empty.
+ *
+ * \param start The index of the first character of the line.
+ */
+-(void)insertLineWithStart:(NSUInteger)start
+{
+        NSUInteger capacity = 0, tail = lineCapacity - gapEnd;
+
+        if (gapStart == gapEnd) {
+                capacity = MAX(2 * lineCapacity, PLSyntaxHighlighterInitialLineCapacity);
+                lines = realloc(lines, capacity * sizeof(PLSyntaxLine));
+                memmove(lines + capacity - tail, lines + gapEnd, tail * sizeof(PLSyntaxLine));
+                gapEnd = capacity - tail;
+                lineCapacity = capacity;
+        }
+        lines[gapStart].start = start;
+        lines[gapStart].state = (PLPythonLexerState){PLPythonStringNone, PLPythonLexerStateUnknown, 0};
+        lines[gapStart].colored = NO;
+        gapStart++;
+}
+
+/**
+ * \brief Insert a line at the gap for each line feed of a range of the text.
+ *
+ * \param range The range of the text.
+ *
+ * \return The number of lines inserted.
+ */
+-(NSUInteger)insertLinesInRange:(NSRange)range
+{
+        NSString * string = [[textView textStorage] string];
+        unichar characters[4096];
+        NSUInteger location = range.location, length = 0, index = 0, count = 0;
+
+        while (location < NSMaxRange(range)) {
+                length = MIN(sizeof(characters) / sizeof(characters[0]), NSMaxRange(range) - location);
+                [string getCharacters:characters range:NSMakeRange(location, length)];
+                for (index = 0; index < length; index++) {
+                        if (characters[index] == '\n') {
+                                [self insertLineWithStart:location + index + 1];
+                                count++;
+                        }
+                }
+                location += length;
+        }
+        return count;
+}
+
+/**
+ * \brief Return the lines in the visible rectangle of the text view.
+ *
+ * \return The range of line numbers.
+ */
+-(NSRange)visibleLineRange
+{
+        NSLayoutManager * layoutManager = [textView layoutManager];
+        NSRange glyphRange, characterRange;
+        NSUInteger firstLine = 0, lastLine = 0;
+
+        glyphRange = [layoutManager glyphRangeForBoundingRect:[textView visibleRect] inTextContainer:[textView textContainer]];
+        characterRange = [layoutManager characterRangeForGlyphRange:glyphRange actualGlyphRange:NULL];
+        firstLine = [self lineForLocation:MIN(characterRange.location, textLength)];
+        lastLine = [self lineForLocation:MIN(NSMaxRange(characterRange), textLength)];
+        return NSMakeRange(firstLine, lastLine - firstLine + 1);
+}
+
+#pragma mark - Editing
+
+/**
+ * \brief Update the lines after the text was edited.
+ *
+ * \details The lines whose line feed was replaced are removed, a line is
+ *          inserted for each inserted line feed, and the lines from the edited
+ *          line to the inserted ones are marked to be lexed.
+ *
+ * \param notification The `NSTextStorageDidProcessEditingNotification`
+ *                     notification.
+ */
+-(void)textStorageDidProcessEditing:(NSNotification *)notification
+{
+        NSTextStorage * textStorage = [notification object];
+        NSRange editedRange = [textStorage editedRange];
+        NSUInteger replacedEnd = 0, line = 0, removedLines = 0, addedLines = 0;
+        CFTimeInterval startTime = CACurrentMediaTime();
+
+        if (([textStorage editedMask] & NSTextStorageEditedCharacters) == 0) {
+                goto exit;
+        }
+        replacedEnd = NSMaxRange(editedRange) - [textStorage changeInLength];
+        line = [self lineForLocation:editedRange.location];
+        [self moveGapToIndex:line + 1];
+        while (gapEnd < lineCapacity && textLength - lines[gapEnd].start <= replacedEnd) {
+                gapEnd++;
+                removedLines++;
+        }
+        textLength = [textStorage length];
+        [self lineAtIndex:line]->colored = NO;
+        addedLines = [self insertLinesInRange:editedRange];
+
+        if (dirtyFrom == NSNotFound) {
+                dirtyUntil = line + addedLines + 1;
+        } else if (dirtyUntil > line + removedLines) {
+                dirtyUntil = dirtyUntil - removedLines + addedLines;
+        } else if (dirtyUntil > line) {
+                dirtyUntil = line + addedLines + 1;
+        }
+        dirtyUntil = MAX(dirtyUntil, line + addedLines + 1);
+        dirtyFrom = MIN(dirtyFrom, line);
+        generation++;
+        pendingEdits++;
+        pendingUpdateTime += CACurrentMediaTime() - startTime;
+        [self schedulePass];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Recolor the visible lines with the colors of the new theme.
+ *
+ * \param notification The `PLThemeTableDidChangeNotification` notification.
+ */
+-(void)themeTableDidChange:(NSNotification *)notification
+{
+        NSUInteger index = 0, lineCount = [self lineCount];
+
+        for (index = 0; index < lineCount; index++) {
+                [self lineAtIndex:index]->colored = NO;
+        }
+        [self schedulePass];
+}
+
+/**
+ * \brief Color the lines scrolled into view.
+ *
+ * \param notification The notification of the clip view.
+ */
+-(void)visibleRectDidChange:(NSNotification *)notification
+{
+        [self schedulePass];
+}
+
+#pragma mark - Highlighting
+
+/**
+ * \brief Start a pass when the run loop is next free, unless one is scheduled
+ *        or running.
+ */
+-(void)schedulePass
+{
+        if (passScheduled || passRunning || textView == nil) {
+                goto exit;
+        }
+        passScheduled = YES;
+        dispatch_async(dispatch_get_main_queue(), ^{
+                passScheduled = NO;
+                [self startPass];
+        });
+
+exit:
+        return;
+}
+
+/**
+ * \brief Lex the next window of lines in the background.
+ *
+ * \details The window starts at the first line marked to be lexed, or at the
+ *          first visible line that is not colored if it comes before. Lexing
+ *          may stop at a cached state once past the lines edited since the
+ *          last pass and the visible lines that are not colored.
+ */
+-(void)startPass
+{
+        NSUInteger lineCount = [self lineCount], firstLine = dirtyFrom, untilLine = 0, lastLine = 0, index = 0;
+        NSUInteger firstUncolored = NSNotFound, lastUncolored = NSNotFound, location = 0, tokenCapacity = 0;
+        NSUInteger passGeneration = generation;
+        NSRange visibleLines, windowVisibleLines;
+        PLPythonLexerState * states = NULL;
+        PLPythonToken * tokens = NULL;
+        PLSyntaxLine * line = NULL;
+        NSString * text = nil;
+
+        if (textView == nil || passRunning) {
+                goto exit;
+        }
+        visibleLines = [self visibleLineRange];
+        for (index = visibleLines.location; index < NSMaxRange(visibleLines); index++) {
+                line = [self lineAtIndex:index];
+                if (line->colored == NO && (line->state.flags & PLPythonLexerStateUnknown) == 0) {
+                        firstUncolored = MIN(firstUncolored, index);
+                        lastUncolored = index;
+                }
+        }
+        firstLine = MIN(dirtyFrom, firstUncolored);
+        if (firstLine == NSNotFound) {
+                goto exit;
+        }
+        untilLine = (dirtyFrom == NSNotFound) ? 0 : dirtyUntil;
+        if (lastUncolored != NSNotFound) {
+                untilLine = MAX(untilLine, lastUncolored + 1);
+        }
+
+        /* Take the whole lines starting in the window */
+        location = [self startOfLine:firstLine];
+        if (location + PLSyntaxHighlighterWindowLength >= textLength) {
+                lastLine = lineCount;
+        } else {
+                lastLine = MAX([self lineForLocation:location + PLSyntaxHighlighterWindowLength], firstLine + 1);
+        }
+        text = [[[textView textStorage] string] substringWithRange:NSMakeRange(location, [self endOfLine:lastLine - 1] - location)];
+        states = malloc((lastLine - firstLine + 1) * sizeof(PLPythonLexerState));
+        for (index = firstLine; index <= lastLine; index++) {
+                states[index - firstLine] = (index < lineCount) ? [self lineAtIndex:index]->state : (PLPythonLexerState){PLPythonStringNone, PLPythonLexerStateUnknown, 0};
+        }
+        windowVisibleLines = NSIntersectionRange(visibleLines, NSMakeRange(firstLine, lastLine - firstLine));
+        if (windowVisibleLines.length > 0) {
+                tokenCapacity = [self endOfLine:NSMaxRange(windowVisibleLines) - 1] - [self startOfLine:windowVisibleLines.location];
+        }
+        tokens = malloc(MAX(tokenCapacity, 1) * sizeof(PLPythonToken));
+
+        passRunning = YES;
+        dispatch_async(queue, ^{
+                CFTimeInterval lexTime = CACurrentMediaTime();
+                NSUInteger lexedLines = 0, tokenCount = 0;
+                BOOL converged = NO;
+
+                lexedLines = PLSyntaxHighlighterLexLines(text, location, firstLine, lastLine - firstLine, untilLine, windowVisibleLines,
+                                                         states, tokens, &tokenCount, &converged);
+                lexTime = CACurrentMediaTime() - lexTime;
+                dispatch_async(dispatch_get_main_queue(), ^{
+                        [self finishPassFromLine:firstLine
+                                      lexedLines:lexedLines
+                                          states:states
+                                       converged:converged
+                                          tokens:tokens
+                                      tokenCount:tokenCount
+                                    visibleLines:windowVisibleLines
+                                      generation:passGeneration
+                                         lexTime:lexTime];
+                        free(states);
+                        free(tokens);
+                });
+        });
+
+exit:
+        return;
+}
+
+/**
+ * \brief Store the states lexed by a pass and color the visible lines it
+ *        lexed.
+ *
+ * \details The pass is dropped if the text was edited since it started. A line
+ *          whose state changed is marked not colored. Another pass is
+ *          scheduled if lines remain to be lexed.
+ *
+ * \param firstLine The first line lexed.
+ *
+ * \param lexedLines The number of lines lexed.
+ *
+ * \param states The states at the start of the lines lexed and of the line
+ *               following them.
+ *
+ * \param converged YES if the last state lexed was the cached one.
+ *
+ * \param tokens The tokens of the visible lines lexed.
+ *
+ * \param tokenCount The number of tokens.
+ *
+ * \param visibleLines The visible lines of the window.
+ *
+ * \param passGeneration The generation of the text lexed.
+ *
+ * \param lexTime The time spent lexing, in seconds.
+ */
+-(void)finishPassFromLine:(NSUInteger)firstLine
+               lexedLines:(NSUInteger)lexedLines
+                   states:(const PLPythonLexerState *)states
+                converged:(BOOL)converged
+                   tokens:(const PLPythonToken *)tokens
+               tokenCount:(NSUInteger)tokenCount
+             visibleLines:(NSRange)visibleLines
+               generation:(NSUInteger)passGeneration
+                  lexTime:(CFTimeInterval)lexTime
+{
+        CFTimeInterval startTime = CACurrentMediaTime();
+        NSLayoutManager * layoutManager = [textView layoutManager];
+        PLThemeTable * themeTable = [PLThemeTable sharedThemeTable];
+        NSUInteger lineCount = [self lineCount], index = 0;
+        NSRange coloredLines, coloredRange;
+        PLSyntaxLine * line = NULL;
+
+        passRunning = NO;
+        if (textView == nil) {
+                goto exit;
+        }
+        if (passGeneration != generation) {
+                [self schedulePass];
+                goto exit;
+        }
+        for (index = 1; index <= lexedLines && firstLine + index < lineCount; index++) {
+                line = [self lineAtIndex:firstLine + index];
+                if (PLPythonLexerStateEqual(line->state, states[index]) == NO) {
+                        line->state = states[index];
+                        line->colored = NO;
+                }
+        }
+        if (converged || firstLine + lexedLines >= lineCount) {
+                dirtyFrom = NSNotFound;
+        } else if (dirtyFrom != NSNotFound) {
+                /* The lines after the window no longer follow from its states */
+                dirtyFrom = MAX(dirtyFrom, firstLine + lexedLines);
+                dirtyUntil = MAX(dirtyUntil, dirtyFrom + 1);
+        }
+
+        /* Color the visible lines lexed */
+        coloredLines = NSIntersectionRange(visibleLines, NSMakeRange(firstLine, lexedLines));
+        if (coloredLines.length > 0) {
+                coloredRange.location = [self startOfLine:coloredLines.location];
+                coloredRange.length = [self endOfLine:NSMaxRange(coloredLines) - 1] - coloredRange.location;
+                [layoutManager removeTemporaryAttribute:NSForegroundColorAttributeName forCharacterRange:coloredRange];
+                for (index = 0; index < tokenCount; index++) {
+                        [layoutManager addTemporaryAttribute:NSForegroundColorAttributeName
+                                                       value:[themeTable color:PLSyntaxHighlighterTokenColors[tokens[index].kind]]
+                                           forCharacterRange:NSMakeRange(tokens[index].location, tokens[index].length)];
+                }
+                for (index = coloredLines.location; index < NSMaxRange(coloredLines); index++) {
+                        [self lineAtIndex:index]->colored = YES;
+                }
+        }
+
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Syntax highlighting: %.1f us for %lu edits (%.1f us updating lines, %.1f us lexing %lu of %lu lines, %.1f us coloring %lu lines)",
+                      (pendingUpdateTime + lexTime + CACurrentMediaTime() - startTime) * 1e6,
+                      (unsigned long)pendingEdits,
+                      pendingUpdateTime * 1e6,
+                      lexTime * 1e6,
+                      (unsigned long)lexedLines,
+                      (unsigned long)lineCount,
+                      (CACurrentMediaTime() - startTime) * 1e6,
+                      (unsigned long)coloredLines.length);
+        }
+        pendingEdits = 0;
+        pendingUpdateTime = 0.0;
+        if (dirtyFrom != NSNotFound || coloredLines.length > 0) {
+                [self schedulePass];
+        }
+
+exit:
+        return;
+}
+
+@end
@@ -33,6 +33,100 @@
 
 @class PLTabBarItemLayer;
 
+/**
+ * \brief Counters of the work done drawing the chrome of tab items.
+ *
+ * \see PLTabBarItemLayer
+ */
+typedef struct {
+        /**
+         * \brief The number of chrome images drawn.
+         */
+        NSUInteger imagesRendered;
+
+        /**
+         * \brief The number of chrome images taken from the cache.
+         */
+        NSUInteger imagesReused;
+
+        /**
+         * \brief The number of tab shape paths created.
+         */
+        NSUInteger pathsCreated;
+
+        /**
+         * \brief The time spent drawing chrome images, in seconds.
+         */
+        CFTimeInterval renderTime;
+} PLTabBarRenderStatistics;
+
+/**
+ * \brief Posted once at the end of each batch of changes to the tabs of a
+ *        `PLTabBar`.
+ *
+ * \details The notification object is the `PLTabBar`. The userInfo dictionary
+ *          holds the `PLTabBarChangeSet` describing the batch under
+ *          `PLTabBarChangeSetKey`.
+ */
+extern NSString * const PLTabBarDidChangeNotification;
+
+/**
+ * \brief The key of the `PLTabBarChangeSet` in the userInfo dictionary of a
+ *        `PLTabBarDidChangeNotification`.
+ */
+extern NSString * const PLTabBarChangeSetKey;
+
+/**
+ * \class PLTabBarChangeSet \headerfile \headerfile
+ *
+ * \brief Describes the tabs added, removed, and moved in one batch of changes
+ *        to a `PLTabBar`.
+ */
+@interface PLTabBarChangeSet : NSObject
+{
+        /**
+         * \brief The tab items added, in the order they were added.
+         */
+        NSMutableArray * insertedItems;
+
+        /**
+         * \brief The tab items removed, in the order they were removed.
+         */
+        NSMutableArray * removedItems;
+
+        /**
+         * \brief The tab items moved, in the order they were moved.
+         */
+        NSMutableArray * movedItems;
+}
+
+/**
+ * \brief The tab items added, in the order they were added.
+ */
+@property (readonly) NSArray * insertedItems;
+
+/**
+ * \brief The tab items removed, in the order they were removed.
+ */
+@property (readonly) NSArray * removedItems;
+
+/**
+ * \brief The tab items moved, in the order they were moved.
+ */
+@property (readonly) NSArray * movedItems;
+
+/**
+ * \brief The indexes whose tab item may have changed.
+ *
+ * \details Indexes are those of the tab bar after the batch. The range may
+ *          extend past the last tab when tabs were removed.
+ */
+@property (readonly) NSRange changedRange;
+
+@end
+
+#pragma mark -
+
 /**
  * \class PLTabBar \headerfile \headerfile
  *
@@ -40,14 +134,23 @@
  *
  * \details This class stores all tab items in the order they should appear in
  *          the tab bar. Each tab item is mapped to a view controller whose
- *          view should be displayed when the tab is active. Additionally, this
- *          class supports mapping a tracking area to a tab item.
+ *          view should be displayed when the tab is active.
+ *
+ *          The tab items are the only store: each item records its index and
+ *          view controller, and the tab bar keeps them in one array. Looking up
+ *          the index or view controller of an item is O(1), and the tab bar
+ *          can be enumerated with fast enumeration without copying it. Each
+ *          item is given an identifier when added that never changes.
+ *
+ *          Changes made inside `performBatchUpdates:` are posted as a single
+ *          `PLTabBarDidChangeNotification`, so observers lay out the tab bar
+ *          once per batch. A change made outside of a batch is its own batch.
  *
  *          Note: items in the tab bar are distinct from one another, but the
  *          associated view controllers are not required to be distinct (i.e.
  *          multiple tabs could use the same view controller).
  */
-@interface PLTabBar : NSObject
+@interface PLTabBar : NSObject <NSFastEnumeration>
 {
         /**
          * \brief The mutable array of all tab bar items in the order they
@@ -56,23 +159,26 @@
         NSMutableArray * tabItemArray;
 
         /**
-         * \brief The mapping of all tab bar items mapped to the associated tab
-         *        subview controller that is displayed when the tab bar item is
-         *        made active.
+         * \brief The changes of the current batch, or nil outside of a batch.
          */
-        NSMapTable * tabItems;
-        
+        PLTabBarChangeSet * pendingChangeSet;
+
         /**
-         * \brief The mapping of all tab bar item names mapped to the associated
-         *        tracking area.
+         * \brief The number of nested `performBatchUpdates:` calls running.
          */
-        NSMapTable * trackingAreas;
+        NSUInteger batchDepth;
 }
 
 /**
  * \brief An array of all tab bar items.
+ *
+ * \details Returns the tab bar's own array rather than a copy, so it changes
+ *          as tabs are added, removed, and moved. Copy it to keep a snapshot,
+ *          and do not change the tab bar while enumerating it. Loops should
+ *          use fast enumeration on the tab bar itself, or `countOfTabItems`
+ *          and `objectInTabItemsAtIndex:`.
  */
-@property (retain, readonly) NSArray * tabItems;
+@property (readonly) NSArray * tabItems;
 
 /**
  * \brief The active tab bar item.
@@ -81,6 +187,16 @@
 
 #pragma mark - Adding, Removing, and Moving Tab Items
 
+/**
+ * \brief Group changes to the tab bar into one batch.
+ *
+ * \details Batches may be nested; the notification is posted when the
+ *          outermost batch ends, and only if the tabs changed.
+ *
+ * \param updates A block adding, removing, or moving tab items.
+ */
+-(void)performBatchUpdates:(void (^)(void))updates;
+
 /**
  * \brief Add a tab item to the tab bar.
  *
@@ -108,7 +224,8 @@
  *
  * \details This method removes `item` and inserts it at the new index, pushing
  *          all following tabs up one index. Raises an exception if `item` is
- *          nil or `index` is out of bounds of the `tabItems` array.
+ *          not in the tab bar or `index` is out of bounds of the `tabItems`
+ *          array.
  *
  * \param item The tab item to move.
  *
@@ -116,6 +233,17 @@
  */
 -(void)moveTabItem:(PLTabBarItemLayer *)item toIndex:(NSUInteger)index;
 
+/**
+ * \brief Replace the view controller associated with a tab item.
+ *
+ * \details Does nothing if `item` is not in the tab bar.
+ *
+ * \param viewController The new view controller. Must not be nil.
+ *
+ * \param item The tab item.
+ */
+-(void)setViewController:(NSViewController <PLTabSubviewController> *)viewController forTabItem:(PLTabBarItemLayer *)item;
+
 #pragma mark - Querying Tab Items
 
 /**
@@ -140,48 +268,23 @@
 /**
  * \brief Return the tab item at an index in the tab bar.
  *
+ * \details The indexed accessor of `tabItems`.
+ *
  * \param index The index.
  *
  * \return The tab item at `index`. Raises an exception if `index` it outside
  *         the bounds of the tab bar.
  */
--(PLTabBarItemLayer *)tabItemAtIndex:(NSUInteger)index;
+-(PLTabBarItemLayer *)objectInTabItemsAtIndex:(NSUInteger)index;
 
 /**
  * \brief Return the number of tabs in the tab bar.
  *
- * \return The number of tabs in the tab bar.
- */
--(NSUInteger)numberOfTabs;
-
-#pragma mark - Tracking Areas
-
-/**
- * \brief Return the tracking area associated with a tab item.
- *
- * \param item The tab item.
- *
- * \return The tracking area associated with a tab item or nil if `item` is not
- *         in the tab bar.
- *
- * \see setTrackingArea:forTabItem:
- */
--(NSTrackingArea *)trackingAreaForTabItem:(PLTabBarItemLayer *)item;
-
-/**
- * \brief Set the tracking area for a tab item.
- *
- * \details Tab bar items are represented as `CALayer` objects. Therefore, if
- *          you are interested in tracking mouse movements over a tab item, set
- *          a `NSTrackingArea` associated with the tab item.
- *
- * \param trackingArea The tracking area.
- *
- * \param item The tab item.
+ * \details The count accessor of `tabItems`.
  *
- * \see trackingAreaForTabItem:
+ * \return The number of tabs in the tab bar.
  */
--(void)setTrackingArea:(NSTrackingArea *)trackingArea forTabItem:(PLTabBarItemLayer *)item;
+-(NSUInteger)countOfTabItems;
 
 @end
 
@@ -196,24 +299,43 @@
  * \details This class adds a series of sublayers to design itself as a tab. It
  *          provides methods to set the tab's title and support for adding
  *          gradient colors as the tab color. Use the `containsPoint:` method to
- *          determine if a point lies within its masked area. Provides a
+ *          determine if a point lies within its shape. Provides a
  *          `pointInCloseButton:` method to determine if a point falls within
  *          its sublayer representing a close button.
+ *
+ *          The tab's shape, fill, and shadow are drawn into a bitmap at the
+ *          backing scale of its window, which is shared by all tabs of the
+ *          same size and colors, as is the path of the shape. Since inactive
+ *          tabs share one gradient, a tab bar of any number of tabs draws
+ *          about two chrome images per tab width.
  */
 @interface PLTabBarItemLayer : CALayer
 {
         /**
-         * \brief The background layer, masked to the tab path.
+         * \brief The layer showing the tab's chrome image: its filled shape
+         *        and shadow.
+         *
+         * \details The layer extends past the tab's bounds to make room for
+         *          the shadow.
          */
-        CAGradientLayer * backgroundLayer;
+        CALayer * chromeLayer;
         
         /**
-         * \brief The shadow layer.
-         *
-         * \details The `shadowPath` is the same path used to mask the
-         *          `backgroundLayer`.
+         * \brief The path of the tab's shape for its current size, shared
+         *        with other tabs of that size.
          */
-        CAShapeLayer * shadowLayer;
+        CGPathRef shapePath;
+        
+        /**
+         * \brief The solid color of the tab, or NULL if it uses a gradient.
+         */
+        CGColorRef chromeColor;
+        
+        /**
+         * \brief The gradient colors of the tab, or nil if it uses a solid
+         *        color.
+         */
+        NSArray * chromeColors;
         
         /**
          * \brief The layer used for the tab's title.
@@ -224,8 +346,23 @@
          * \brief The layer used to represent a close tab button.
          */
         CAShapeLayer * closeButtonLayer;
+        
+        /**
+         * \brief The bar along the bottom of the tab showing the progress of
+         *        a save.
+         */
+        CALayer * progressLayer;
 }
 
+/**
+ * \brief The identifier of the tab.
+ *
+ * \details Given by the first `PLTabBar` the tab is added to. It is unique
+ *          for the lifetime of the application and never changes, even when
+ *          the tab moves. Zero until the tab is added to a tab bar.
+ */
+@property (readonly) NSUInteger identifier;
+
 /**
  * \brief The tab's title.
  */
@@ -235,7 +372,7 @@
  * \brief The solid color used for the tab's background.
  *
  * \details This property is analogous to the `CALayer` `backgroundColor`
- *          property, but use this instead as it will respect the tab's mask
+ *          property, but use this instead as it will respect the tab's
  *          shape. If a gradient is preferred, use the `colors` property
  *          instead, which will set this property to nil.
  *
@@ -271,6 +408,29 @@
  */
 @property (nonatomic, assign) BOOL closeButtonHighlighted;
 
+/**
+ * \brief The progress of the save of the tab's document, from 0 to 1, or a
+ *        negative number if the document is not being saved.
+ *
+ * \details Shown as a thin bar along the bottom of the tab. Defaults to -1.
+ */
+@property (nonatomic, assign) CGFloat progress;
+
+/**
+ * \brief Return the work done drawing tab chrome since the statistics were
+ *        last reset.
+ *
+ * \details Must only be used from the main thread.
+ *
+ * \return The counters of all tab items.
+ */
++(PLTabBarRenderStatistics)renderStatistics;
+
+/**
+ * \brief Reset the counters returned by `renderStatistics`.
+ */
++(void)resetRenderStatistics;
+
 /**
  * \brief Determine if a point lies within the tab item's close button.
  *
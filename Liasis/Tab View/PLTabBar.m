@@ -30,6 +30,134 @@
 
 #import "PLTabBar.h"
 
+NSString * const PLTabBarDidChangeNotification = @"PLTabBarDidChangeNotification";
+
+NSString * const PLTabBarChangeSetKey = @"PLTabBarChangeSetKey";
+
+/**
+ * \brief The bookkeeping `PLTabBar` keeps in each of its tab items.
+ */
+@interface PLTabBarItemLayer ()
+
+/**
+ * \brief The tab bar containing the tab, or nil. Not retained.
+ */
+@property (assign) PLTabBar * tabBar;
+
+/**
+ * \brief The index of the tab in `tabBar`.
+ */
+@property (assign) NSUInteger tabIndex;
+
+/**
+ * \brief The view controller of the tab, retained while the tab is in a tab
+ *        bar.
+ */
+@property (retain) NSViewController <PLTabSubviewController> * tabViewController;
+
+@property (readwrite) NSUInteger identifier;
+
+@end
+
+/**
+ * \brief The methods `PLTabBar` uses to record the changes of a batch.
+ */
+@interface PLTabBarChangeSet ()
+
+-(BOOL)isEmpty;
+
+-(void)addChangedRange:(NSRange)range;
+
+-(void)addInsertedItem:(PLTabBarItemLayer *)item;
+
+-(void)addRemovedItem:(PLTabBarItemLayer *)item;
+
+-(void)addMovedItem:(PLTabBarItemLayer *)item;
+
+@end
+
+#pragma mark -
+
+@implementation PLTabBarChangeSet
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                insertedItems = [[NSMutableArray alloc] init];
+                removedItems = [[NSMutableArray alloc] init];
+                movedItems = [[NSMutableArray alloc] init];
+                _changedRange = NSMakeRange(NSNotFound, 0);
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        [insertedItems release];
+        [removedItems release];
+        [movedItems release];
+        [super dealloc];
+}
+
+-(NSArray *)insertedItems
+{
+        return insertedItems;
+}
+
+-(NSArray *)removedItems
+{
+        return removedItems;
+}
+
+-(NSArray *)movedItems
+{
+        return movedItems;
+}
+
+/**
+ * \brief Determine if the change set records any change.
+ *
+ * \return YES if no tab item was added, removed, or moved.
+ */
+-(BOOL)isEmpty
+{
+        return [insertedItems count] == 0 && [removedItems count] == 0 && [movedItems count] == 0;
+}
+
+/**
+ * \brief Record that the tab items in a range of indexes may have changed.
+ *
+ * \param range The range of indexes.
+ */
+-(void)addChangedRange:(NSRange)range
+{
+        if (_changedRange.location == NSNotFound) {
+                _changedRange = range;
+        } else {
+                _changedRange = NSUnionRange(_changedRange, range);
+        }
+}
+
+-(void)addInsertedItem:(PLTabBarItemLayer *)item
+{
+        [insertedItems addObject:item];
+}
+
+-(void)addRemovedItem:(PLTabBarItemLayer *)item
+{
+        [removedItems addObject:item];
+}
+
+-(void)addMovedItem:(PLTabBarItemLayer *)item
+{
+        [movedItems addObject:item];
+}
+
+@end
+
+#pragma mark -
+
 @implementation PLTabBar
 
 #pragma mark - Object Lifecycle
@@ -39,8 +167,6 @@
         self = [super init];
         if (self) {
                 tabItemArray = [[NSMutableArray alloc] init];
-                tabItems = [[NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory] retain];
-                trackingAreas = [[NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory] retain];
         }
         return self;
 }
@@ -48,9 +174,12 @@
 -(void)dealloc
 {
         self.activeTab = nil;
+        for (PLTabBarItemLayer * item in tabItemArray) {
+                item.tabBar = nil;
+                item.tabViewController = nil;
+        }
         [tabItemArray release];
-        [tabItems release];
-        [trackingAreas release];
+        [pendingChangeSet release];
         [super dealloc];
 }
 
@@ -58,74 +187,381 @@
 
 -(NSArray *)tabItems
 {
-        return [NSArray arrayWithArray:tabItemArray];
+        return tabItemArray;
+}
+
+-(NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id [])buffer count:(NSUInteger)len
+{
+        return [tabItemArray countByEnumeratingWithState:state objects:buffer count:len];
+}
+
+#pragma mark - Batches
+
+-(void)performBatchUpdates:(void (^)(void))updates
+{
+        PLTabBarChangeSet * changeSet = nil;
+
+        if (batchDepth == 0) {
+                pendingChangeSet = [[PLTabBarChangeSet alloc] init];
+        }
+        batchDepth++;
+        updates();
+        batchDepth--;
+        if (batchDepth > 0) {
+                goto exit;
+        }
+
+        changeSet = [pendingChangeSet autorelease];
+        pendingChangeSet = nil;
+        if ([changeSet isEmpty] == NO) {
+                [[NSNotificationCenter defaultCenter] postNotificationName:PLTabBarDidChangeNotification
+                                                                    object:self
+                                                                  userInfo:@{PLTabBarChangeSetKey: changeSet}];
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Update the index of the tab items in a range of indexes.
+ *
+ * \param range The range of indexes.
+ */
+-(void)reindexTabItemsInRange:(NSRange)range
+{
+        NSUInteger index = 0;
+
+        for (index = range.location; index < NSMaxRange(range); index++) {
+                [[tabItemArray objectAtIndex:index] setTabIndex:index];
+        }
 }
 
 #pragma mark - Adding, Removing, and Moving Tab Items
 
 -(void)addTabItem:(PLTabBarItemLayer *)item withViewController:(NSViewController <PLTabSubviewController> *)viewController
 {
-        if ([tabItemArray containsObject:item] == NO) {
-                [tabItemArray addObject:item];
-                [tabItems setObject:viewController forKey:item];
+        static NSUInteger nextIdentifier = 1;
+
+        if (item.tabBar) {
+                goto exit;
         }
+        [self performBatchUpdates:^{
+                if (item.identifier == 0) {
+                        item.identifier = nextIdentifier++;
+                }
+                item.tabBar = self;
+                item.tabIndex = [tabItemArray count];
+                item.tabViewController = viewController;
+                [tabItemArray addObject:item];
+                [pendingChangeSet addInsertedItem:item];
+                [pendingChangeSet addChangedRange:NSMakeRange(item.tabIndex, 1)];
+        }];
+
+exit:
+        return;
 }
 
 -(void)removeTabItem:(PLTabBarItemLayer *)item
 {
-        [tabItemArray removeObject:item];
-        [tabItems removeObjectForKey:item];
-        [trackingAreas removeObjectForKey:item];
+        if (item.tabBar != self) {
+                goto exit;
+        }
+        [self performBatchUpdates:^{
+                NSUInteger index = item.tabIndex;
+
+                [item retain];
+                [tabItemArray removeObjectAtIndex:index];
+                [self reindexTabItemsInRange:NSMakeRange(index, [tabItemArray count] - index)];
+                item.tabBar = nil;
+                item.tabViewController = nil;
+                [pendingChangeSet addRemovedItem:item];
+                [pendingChangeSet addChangedRange:NSMakeRange(index, [tabItemArray count] - index)];
+                [item release];
+        }];
+
+exit:
+        return;
 }
 
 -(void)moveTabItem:(PLTabBarItemLayer *)item toIndex:(NSUInteger)index
 {
-        [item retain];
-        [tabItemArray removeObject:item];
-        [tabItemArray insertObject:item atIndex:index];
-        [item release];
+        if (item.tabBar != self || index >= [tabItemArray count]) {
+                [NSException raise:NSRangeException format:@"Cannot move tab item to index %lu of %lu.", (unsigned long)index, (unsigned long)[tabItemArray count]];
+        }
+        [self performBatchUpdates:^{
+                NSUInteger oldIndex = item.tabIndex;
+                NSRange range = NSMakeRange(MIN(oldIndex, index), MAX(oldIndex, index) - MIN(oldIndex, index) + 1);
+
+                [item retain];
+                [tabItemArray removeObjectAtIndex:oldIndex];
+                [tabItemArray insertObject:item atIndex:index];
+                [item release];
+                [self reindexTabItemsInRange:range];
+                [pendingChangeSet addMovedItem:item];
+                [pendingChangeSet addChangedRange:range];
+        }];
+}
+
+-(void)setViewController:(NSViewController <PLTabSubviewController> *)viewController forTabItem:(PLTabBarItemLayer *)item
+{
+        if (item.tabBar == self) {
+                item.tabViewController = viewController;
+        }
 }
 
 #pragma mark - Querying Tab Items
 
 -(NSViewController <PLTabSubviewController> *)viewControllerForTabItem:(PLTabBarItemLayer *)item
 {
-        return [tabItems objectForKey:item];
+        NSViewController <PLTabSubviewController> * viewController = nil;
+
+        if (item.tabBar == self) {
+                viewController = item.tabViewController;
+        }
+        return viewController;
 }
 
 -(NSUInteger)indexOfTabItem:(PLTabBarItemLayer *)item
 {
-        return [tabItemArray indexOfObject:item];
+        NSUInteger index = NSNotFound;
+
+        if (item.tabBar == self) {
+                index = item.tabIndex;
+        }
+        return index;
 }
 
--(PLTabBarItemLayer *)tabItemAtIndex:(NSUInteger)index
+-(PLTabBarItemLayer *)objectInTabItemsAtIndex:(NSUInteger)index
 {
         return [tabItemArray objectAtIndex:index];
 }
 
--(NSUInteger)numberOfTabs
+-(NSUInteger)countOfTabItems
 {
         return [tabItemArray count];
 }
 
-#pragma mark - Tracking Areas
+@end
+
+#pragma mark -
+
+
+@implementation PLTabBarItemLayer
+
+#pragma mark - Chrome Cache
+
+/**
+ * \brief The width of the margin around the tab chrome image that leaves room
+ *        for the tab's shadow.
+ */
+static const CGFloat PLTabBarItemShadowMargin = 3.0f;
+
+/**
+ * \brief The counters reported by `renderStatistics`.
+ */
+static PLTabBarRenderStatistics PLTabBarItemRenderStatistics = {0, 0, 0, 0.0};
 
--(NSTrackingArea *)trackingAreaForTabItem:(PLTabBarItemLayer *)item
+/**
+ * \brief Create the path of the tab's shape.
+ *
+ * \details The path starts and ends at the bottom corners of `size`:
+ *
+ *           p2------------p3
+ *          /                \
+ *         /                  \
+ * p0----p1                    p4----p5
+ *
+ * \param size The size of the tab.
+ *
+ * \return The path, which the caller must release.
+ */
+static CGPathRef PLTabBarItemCreatePath(CGSize size)
 {
-        return [trackingAreas objectForKey:item];
+        CGMutablePathRef path;
+        CGFloat endLength, xEdgeOffset, bottomRadius, topRadius;
+        CGFloat x0, x1, x2, x3, y0, y1;
+        NSPoint p0, p1, p2, p3, p4, p5;
+        
+        /* Define the tab's corner radii and its six vertices */
+        endLength = 5.0f;  // x length between points p0-p1 and p4-p5
+        xEdgeOffset = 8.0f;  // x length between points p1-p2 and p3-p4
+        bottomRadius = 6.0f;  // radius of arc at points p1 and p4
+        topRadius = 7.0f;  // radius of arc at points p2 and p3
+        
+        x0 = 0.0f;
+        x1 = endLength;
+        x2 = size.width - endLength;
+        x3 = size.width;
+        y0 = 0.0f;
+        y1 = size.height - 4.0f;
+        
+        p0 = NSMakePoint(x0, y0);
+        p1 = NSMakePoint(x1, y0);
+        p2 = NSMakePoint(x1 + xEdgeOffset, y1);
+        p3 = NSMakePoint(x2 - xEdgeOffset, y1);
+        p4 = NSMakePoint(x2, y0);
+        p5 = NSMakePoint(x3, y0);
+        
+        path = CGPathCreateMutable();
+        CGPathMoveToPoint(path, NULL, p0.x, p0.y);
+        CGPathAddArcToPoint(path, NULL, p1.x, p1.y, p2.x, p2.y, bottomRadius);
+        CGPathAddArcToPoint(path, NULL, p2.x, p2.y, p3.x, p3.y, topRadius);
+        CGPathAddArcToPoint(path, NULL, p3.x, p3.y, p4.x, p4.y, topRadius);
+        CGPathAddArcToPoint(path, NULL, p4.x, p4.y, p5.x, p5.y, bottomRadius);
+        return path;
 }
 
--(void)setTrackingArea:(NSTrackingArea *)trackingArea forTabItem:(PLTabBarItemLayer *)item
+/**
+ * \brief Return the path of the tab's shape for a size, shared by all tabs of
+ *        that size.
+ *
+ * \param size The size of the tab.
+ *
+ * \return The cached path, or a new path added to the cache.
+ */
++(CGPathRef)pathForSize:(CGSize)size
 {
-        [trackingAreas setObject:trackingArea forKey:item];
+        static NSCache * pathCache = nil;
+        static dispatch_once_t onceToken;
+        NSValue * key = [NSValue valueWithSize:size];
+        CGPathRef path = NULL;
+        
+        dispatch_once(&onceToken, ^{
+                pathCache = [[NSCache alloc] init];
+                [pathCache setCountLimit:32];
+        });
+        path = (CGPathRef)[pathCache objectForKey:key];
+        if (path == NULL) {
+                path = PLTabBarItemCreatePath(size);
+                [pathCache setObject:(id)path forKey:key];
+                [(id)path autorelease];
+                PLTabBarItemRenderStatistics.pathsCreated++;
+        }
+        return path;
 }
 
-@end
+/**
+ * \brief Draw the tab's chrome into a bitmap.
+ *
+ * \details The chrome is the tab's shape filled with a solid color or a
+ *          vertical gradient, and its shadow. The bitmap is larger than the
+ *          tab by `PLTabBarItemShadowMargin` on every side.
+ *
+ * \param path The path of the tab's shape.
+ *
+ * \param size The size of the tab.
+ *
+ * \param scale The number of pixels per point.
+ *
+ * \param fillColors The colors of the gradient, from bottom to top, or an
+ *                   array of one solid color.
+ *
+ * \return The image, which the caller must release, or NULL if it could not
+ *         be drawn.
+ */
+static CGImageRef PLTabBarItemCreateChromeImage(CGPathRef path, CGSize size, CGFloat scale, NSArray * fillColors)
+{
+        CGColorSpaceRef colorSpace = NULL;
+        CGContextRef context = NULL;
+        CGGradientRef gradient = NULL;
+        CGColorRef shadowColor = NULL;
+        CGImageRef image = NULL;
+        size_t width = 0, height = 0;
+        
+        width = (size_t)ceil((size.width + 2 * PLTabBarItemShadowMargin) * scale);
+        height = (size_t)ceil((size.height + 2 * PLTabBarItemShadowMargin) * scale);
+        colorSpace = CGColorSpaceCreateDeviceRGB();
+        context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedFirst);
+        if (context == NULL || [fillColors count] == 0) {
+                goto exit;
+        }
+        CGContextScaleCTM(context, scale, scale);
+        CGContextTranslateCTM(context, PLTabBarItemShadowMargin, PLTabBarItemShadowMargin);
+        
+        /* Draw the shadow under the shape */
+        shadowColor = CGColorCreateGenericGray(0.0f, 0.4f);
+        CGContextSaveGState(context);
+        CGContextSetShadowWithColor(context, CGSizeMake(0.0f, 1.0f), 3.0f, shadowColor);
+        CGContextSetFillColorWithColor(context, (CGColorRef)[fillColors objectAtIndex:0]);
+        CGContextAddPath(context, path);
+        CGContextFillPath(context);
+        CGContextRestoreGState(context);
+        CGColorRelease(shadowColor);
+        
+        /* Fill the shape over its shadow */
+        if ([fillColors count] > 1) {
+                gradient = CGGradientCreateWithColors(colorSpace, (CFArrayRef)fillColors, NULL);
+                CGContextAddPath(context, path);
+                CGContextClip(context);
+                CGContextDrawLinearGradient(context, gradient, CGPointMake(0.0f, 0.0f), CGPointMake(0.0f, size.height), 0);
+                CGGradientRelease(gradient);
+        }
+        image = CGBitmapContextCreateImage(context);
+        
+exit:
+        CGContextRelease(context);
+        CGColorSpaceRelease(colorSpace);
+        return image;
+}
 
-#pragma mark -
+/**
+ * \brief Return the chrome image for a tab, shared by all tabs with the same
+ *        size, scale, and colors.
+ *
+ * \param path The path of the tab's shape for `size`.
+ *
+ * \param size The size of the tab.
+ *
+ * \param scale The number of pixels per point.
+ *
+ * \param fillColors The colors of the gradient, from bottom to top, or an
+ *                   array of one solid color.
+ *
+ * \return The cached image, a new image added to the cache, or NULL if it
+ *         could not be drawn.
+ */
++(CGImageRef)chromeImageWithPath:(CGPathRef)path size:(CGSize)size scale:(CGFloat)scale fillColors:(NSArray *)fillColors
+{
+        static NSCache * imageCache = nil;
+        static dispatch_once_t onceToken;
+        NSArray * key = nil;
+        CGImageRef image = NULL;
+        CFTimeInterval startTime = 0.0;
+        
+        dispatch_once(&onceToken, ^{
+                imageCache = [[NSCache alloc] init];
+                [imageCache setCountLimit:64];
+        });
+        key = @[[NSValue valueWithSize:size], @(scale), fillColors];
+        image = (CGImageRef)[imageCache objectForKey:key];
+        if (image) {
+                PLTabBarItemRenderStatistics.imagesReused++;
+                goto exit;
+        }
+        
+        startTime = CACurrentMediaTime();
+        image = PLTabBarItemCreateChromeImage(path, size, scale, fillColors);
+        if (image) {
+                [imageCache setObject:(id)image forKey:key];
+                [(id)image autorelease];
+        }
+        PLTabBarItemRenderStatistics.imagesRendered++;
+        PLTabBarItemRenderStatistics.renderTime += CACurrentMediaTime() - startTime;
+        
+exit:
+        return image;
+}
 
++(PLTabBarRenderStatistics)renderStatistics
+{
+        return PLTabBarItemRenderStatistics;
+}
 
-@implementation PLTabBarItemLayer
++(void)resetRenderStatistics
+{
+        memset(&PLTabBarItemRenderStatistics, 0, sizeof(PLTabBarItemRenderStatistics));
+}
 
 #pragma mark - Object Lifecycle
 
@@ -144,14 +580,14 @@
         self = [super init];
         if (self) {
                 titleLayer = [[CATextLayer layer] retain];
-                backgroundLayer = [[CAGradientLayer layer] retain];
-                shadowLayer = [[CAShapeLayer layer] retain];
+                chromeLayer = [[CALayer layer] retain];
                 closeButtonLayer = [[PLTabBarItemLayer createCloseButtonLayer] retain];
+                progressLayer = [[CALayer layer] retain];
                 
-                /* Configure the shadow layer */
-                shadowLayer.shadowOpacity = 0.4f;
-                shadowLayer.shadowOffset = CGSizeMake(0.0f, 1.0f);
-                shadowLayer.shadowRadius = 1.5f;
+                /* Configure the chrome layer */
+                chromeLayer.contentsScale = [[NSScreen mainScreen] backingScaleFactor];
+                chromeLayer.delegate = self;
+                chromeLayer.actions = @{@"contents": [NSNull null]};
                 
                 /* Configure the title layer */
                 foregroundColor = CGColorCreateGenericGray(0.0f, 1.0f);
@@ -173,11 +609,18 @@
                 closeButtonLayer.hidden = YES;
                 self.closeButtonHighlighted = NO;
                 
+                /* Configure the progress layer */
+                foregroundColor = CGColorCreateGenericGray(0.0f, 0.35f);
+                progressLayer.backgroundColor = foregroundColor;
+                progressLayer.hidden = YES;
+                CGColorRelease(foregroundColor);
+                _progress = -1.0f;
+                
                 /* Add all sublayers */
-                [self addSublayer:shadowLayer];
-                [self addSublayer:backgroundLayer];
+                [self addSublayer:chromeLayer];
                 [self addSublayer:titleLayer];
                 [self addSublayer:closeButtonLayer];
+                [self addSublayer:progressLayer];
         }
         return self;
 }
@@ -223,10 +666,14 @@
  */
 -(void)dealloc
 {
-        [backgroundLayer release];
+        [_tabViewController release];
+        [chromeLayer release];
         [titleLayer release];
-        [shadowLayer release];
         [closeButtonLayer release];
+        [progressLayer release];
+        [chromeColors release];
+        CGColorRelease(chromeColor);
+        CGPathRelease(shapePath);
         [super dealloc];
 }
 
@@ -236,8 +683,9 @@
  * \brief Delegate method to tell layers to inherit contents scale of windows.
  *
  * \details This method is called when a tab item is moved to a new window with
- *          a possibly different contents scale. It is currently used by the
- *          `titleLayer` to update its `contentsScale` property.
+ *          a possibly different contents scale. It is used by the `titleLayer`
+ *          and the `chromeLayer` to update their `contentsScale` property. The
+ *          chrome is drawn again at the new scale.
  *
  * \param layer The layer moving to a new window.
  *
@@ -249,6 +697,9 @@
  */
 -(BOOL)layer:(CALayer *)layer shouldInheritContentsScale:(CGFloat)newScale fromWindow:(NSWindow *)window
 {
+        if (layer == chromeLayer && newScale != chromeLayer.contentsScale) {
+                [self setNeedsLayout];
+        }
         return YES;
 }
 
@@ -257,72 +708,63 @@
 /**
  * \brief Set the layout of all tab item sublayers.
  *
- * \details This method define the mask that creates the tab's shape
- *          and its shadow using the `CGPath` functions. It does nothing if
- *          `layer` is not a `PLTabBarItemLayer`.
+ * \details This method takes the path of the tab's shape for its size and the
+ *          chrome image drawn with that path, its colors, and the contents
+ *          scale of `chromeLayer` from the caches shared by all tabs, so only
+ *          the first tab of each size and color draws anything. Drawing the
+ *          shadow and the shape into the image avoids masking and the
+ *          offscreen passes it needs when compositing.
  */
 -(void)layoutSublayers
 {
-        CAShapeLayer * maskLayer = nil;
-        CGMutablePathRef path;
-        CGFloat endLength, xEdgeOffset, bottomRadius, topRadius;
-        CGFloat x0, x1, x2, x3, y0, y1;
-        NSPoint p0, p1, p2, p3, p4, p5;
-        
-        /* Define the tab's corner radii and its six vertices:
-         *
-         *           p2------------p3
-         *          /                \
-         *         /                  \
-         * p0----p1                    p4----p5
-         *
-         */
-        endLength = 5.0f;  // x length between points p0-p1 and p4-p5
-        xEdgeOffset = 8.0f;  // x length between points p1-p2 and p3-p4
-        bottomRadius = 6.0f;  // radius of arc at points p1 and p4
-        topRadius = 7.0f;  // radius of arc at points p2 and p3
+        CGPathRef path = NULL;
+        CGImageRef image = NULL;
+        NSArray * fillColors = nil;
+        CGSize size = self.bounds.size;
         
-        x0 = NSMinX(self.bounds);
-        x1 = NSMinX(self.bounds) + endLength;
-        x2 = NSMaxX(self.bounds) - endLength;
-        x3 = NSMaxX(self.bounds);
-        y0 = NSMinY(self.bounds);
-        y1 = NSMaxY(self.bounds) - 4.0f;
+        path = [PLTabBarItemLayer pathForSize:size];
+        CGPathRetain(path);
+        CGPathRelease(shapePath);
+        shapePath = path;
         
-        p0 = NSMakePoint(x0, y0);
-        p1 = NSMakePoint(x1, y0);
-        p2 = NSMakePoint(x1 + xEdgeOffset, y1);
-        p3 = NSMakePoint(x2 - xEdgeOffset, y1);
-        p4 = NSMakePoint(x2, y0);
-        p5 = NSMakePoint(x3, y0);
-        
-        /* Make the tab path and mask the layers */
-        path = CGPathCreateMutable();
-        CGPathMoveToPoint(path, NULL, p0.x, p0.y);
-        CGPathAddArcToPoint(path, NULL, p1.x, p1.y, p2.x, p2.y, bottomRadius);
-        CGPathAddArcToPoint(path, NULL, p2.x, p2.y, p3.x, p3.y, topRadius);
-        CGPathAddArcToPoint(path, NULL, p3.x, p3.y, p4.x, p4.y, topRadius);
-        CGPathAddArcToPoint(path, NULL, p4.x, p4.y, p5.x, p5.y, bottomRadius);
-        
-        maskLayer = [CAShapeLayer layer];
-        maskLayer.path = path;
+        if (chromeColors) {
+                fillColors = chromeColors;
+        } else if (chromeColor) {
+                fillColors = @[(id)chromeColor];
+        }
+        if (fillColors && size.width > 0.0f && size.height > 0.0f) {
+                image = [PLTabBarItemLayer chromeImageWithPath:path
+                                                          size:size
+                                                         scale:chromeLayer.contentsScale
+                                                    fillColors:fillColors];
+        }
         
         [CATransaction begin];
         [CATransaction setDisableActions:YES];
-        backgroundLayer.mask = maskLayer;
-        shadowLayer.shadowPath = path;
-        shadowLayer.frame = self.bounds;
-        backgroundLayer.frame = self.bounds;
+        chromeLayer.contents = (id)image;
+        chromeLayer.frame = CGRectInset(self.bounds, -PLTabBarItemShadowMargin, -PLTabBarItemShadowMargin);
         titleLayer.frame = CGRectMake(NSMaxX(closeButtonLayer.frame) + 1.0f,
                                       self.frame.origin.y + 4.0f,
                                       self.frame.size.width - 2 * (NSMaxX(closeButtonLayer.frame) + 1.0f),
                                       self.frame.size.height - 12.0f);
         [CATransaction commit];
+        [self layoutProgressLayer];
+}
+
+/**
+ * \brief Size the progress bar to the progress, between the slanted edges of
+ *        the tab.
+ */
+-(void)layoutProgressLayer
+{
+        CGFloat inset = NSMaxX(closeButtonLayer.frame) - 8.0f;
+        CGFloat width = MAX(self.bounds.size.width - 2 * inset, 0.0f);
         
-        CGPathRelease(path);
-        
-exit:
-        return;
+        [CATransaction begin];
+        [CATransaction setDisableActions:YES];
+        progressLayer.hidden = (_progress < 0.0f);
+        progressLayer.frame = CGRectMake(inset, 1.0f, width * MIN(MAX(_progress, 0.0f), 1.0f), 2.0f);
+        [CATransaction commit];
 }
 
 #pragma mark - Hit Testing
@@ -339,7 +781,7 @@ exit:
  */
 -(BOOL)containsPoint:(CGPoint)point
 {
-        return CGPathContainsPoint(shadowLayer.shadowPath, NULL, point, false);
+        return shapePath && CGPathContainsPoint(shapePath, NULL, point, false);
 }
 
 -(BOOL)pointInCloseButton:(CGPoint)point
@@ -365,24 +807,35 @@ exit:
 
 -(CGColorRef)color
 {
-        return backgroundLayer.backgroundColor;
+        return chromeColor;
 }
 
 -(void)setColor:(CGColorRef)color
 {
-        backgroundLayer.colors = nil;
-        backgroundLayer.backgroundColor = color;
+        if (chromeColors || color != chromeColor) {
+                CGColorRetain(color);
+                CGColorRelease(chromeColor);
+                chromeColor = color;
+                [chromeColors release];
+                chromeColors = nil;
+                [self setNeedsLayout];
+        }
 }
 
 -(NSArray *)colors
 {
-        return backgroundLayer.colors;
+        return chromeColors;
 }
 
 -(void)setColors:(NSArray *)colors
 {
-        backgroundLayer.backgroundColor = nil;
-        backgroundLayer.colors = colors;
+        if (chromeColor || [colors isEqualToArray:chromeColors] == NO) {
+                CGColorRelease(chromeColor);
+                chromeColor = NULL;
+                [chromeColors release];
+                chromeColors = [colors copy];
+                [self setNeedsLayout];
+        }
 }
 
 -(BOOL)closeButtonHidden
@@ -411,4 +864,10 @@ exit:
         _closeButtonHighlighted = closeButtonHighlighted;
 }
 
+-(void)setProgress:(CGFloat)progress
+{
+        _progress = progress;
+        [self layoutProgressLayer];
+}
+
 @end
@@ -0,0 +1,146 @@
+/**
+ * \file PLTabBarLayout.h
+ *
+ * \brief Liasis Python IDE tab bar layout.
+ *
+ * \details This file includes the object that calculates the frames of the
+ *          tab items in a tab bar and finds the tab items at a location.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief The maximum width of a tab item.
+ */
+extern const CGFloat PLTabItemMaxWidth;
+
+/**
+ * \brief The width by which each tab item overlaps the previous one.
+ */
+extern const CGFloat PLTabItemOverlap;
+
+/**
+ * \class PLTabBarLayout \headerfile \headerfile
+ *
+ * \brief Calculates the frames of the tab items in a tab bar.
+ *
+ * \details Tabs share one width, at most `PLTabItemMaxWidth`, chosen so that
+ *          all tabs fit the tab bar. Each tab is placed slightly offset from
+ *          the left edge of the bar and overlapping the previous tab by
+ *          `PLTabItemOverlap`.
+ *
+ *          The frames are kept in a flat array indexed by the position of the
+ *          tab in the bar. Since the frame of a tab only depends on its index
+ *          and the shared width, laying out the bar again only calculates the
+ *          frames of new indexes unless the width changed. The origins of the
+ *          frames increase with their index, so the tabs at a location are
+ *          found by binary search.
+ */
+@interface PLTabBarLayout : NSObject
+{
+        /**
+         * \brief The frame of each tab, in the order of the tab bar.
+         */
+        NSRect * frames;
+
+        /**
+         * \brief The number of frames laid out.
+         */
+        NSUInteger count;
+
+        /**
+         * \brief The number of frames `frames` can hold.
+         */
+        NSUInteger capacity;
+
+        /**
+         * \brief The size of the tab bar last laid out.
+         */
+        NSSize barSize;
+
+        /**
+         * \brief The width the frames were last laid out with, before it was
+         *        rounded down to whole points.
+         */
+        CGFloat unroundedTabWidth;
+}
+
+/**
+ * \brief The number of frames laid out.
+ */
+@property (readonly) NSUInteger count;
+
+/**
+ * \brief The width shared by all tabs.
+ */
+@property (readonly) CGFloat tabWidth;
+
+/**
+ * \brief Lay out tabs in a tab bar.
+ *
+ * \param tabCount The number of tabs.
+ *
+ * \param size The size of the tab bar.
+ *
+ * \return The first index whose frame changed, or `NSNotFound` if the frames
+ *         of all `tabCount` tabs are unchanged. The frames of every index
+ *         following the returned one may have changed.
+ */
+-(NSUInteger)layoutTabCount:(NSUInteger)tabCount inBarOfSize:(NSSize)size;
+
+/**
+ * \brief Return the frame of the tab at an index.
+ *
+ * \param index The index of the tab. Raises an exception if `index` is not
+ *              less than `count`.
+ *
+ * \return The frame of the tab in the coordinate system of the tab bar.
+ */
+-(NSRect)frameAtIndex:(NSUInteger)index;
+
+/**
+ * \brief Return the index of the first tab whose frame starts after a
+ *        location.
+ *
+ * \param x A horizontal location in the coordinate system of the tab bar.
+ *
+ * \return The index of the first tab whose origin is greater than `x`, or
+ *         `count` if there is none.
+ */
+-(NSUInteger)indexOfFirstTabAfterLocation:(CGFloat)x;
+
+/**
+ * \brief Return the indexes of the tabs whose frames contain a location.
+ *
+ * \details Because tabs overlap, a location may be within the frames of more
+ *          than one tab.
+ *
+ * \param x A horizontal location in the coordinate system of the tab bar.
+ *
+ * \return The range of indexes of the tabs whose frames span `x`, with a
+ *         length of zero if there is none.
+ */
+-(NSRange)rangeOfTabsAtLocation:(CGFloat)x;
+
+@end
@@ -0,0 +1,172 @@
+/**
+ * \file PLTabBarLayout.m
+ *
+ * \brief Liasis Python IDE tab bar layout.
+ *
+ * \details This file includes the object that calculates the frames of the
+ *          tab items in a tab bar and finds the tab items at a location.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLTabBarLayout.h"
+
+const CGFloat PLTabItemMaxWidth = 200.0f;
+
+const CGFloat PLTabItemOverlap = 13.0f;
+
+@implementation PLTabBarLayout
+
+#pragma mark - Object Lifecycle
+
+-(void)dealloc
+{
+        free(frames);
+        [super dealloc];
+}
+
+#pragma mark - Properties
+
+-(NSUInteger)count
+{
+        return count;
+}
+
+-(CGFloat)tabWidth
+{
+        CGFloat width = 0.0f;
+
+        if (count > 0) {
+                width = frames[0].size.width;
+        }
+        return width;
+}
+
+#pragma mark - Layout
+
+/**
+ * \brief Make room for a number of frames.
+ *
+ * \details Raises an `NSMallocException` if the memory cannot be allocated.
+ *
+ * \param tabCount The number of frames.
+ */
+-(void)reserveCapacity:(NSUInteger)tabCount
+{
+        NSUInteger newCapacity = MAX(capacity, 16);
+        NSRect * newFrames = NULL;
+
+        if (tabCount <= capacity) {
+                goto exit;
+        }
+        while (newCapacity < tabCount) {
+                newCapacity *= 2;
+        }
+        newFrames = realloc(frames, newCapacity * sizeof(NSRect));
+        if (newFrames == NULL) {
+                [NSException raise:NSMallocException format:@"Could not allocate the frames of %lu tabs.", (unsigned long)tabCount];
+        }
+        frames = newFrames;
+        capacity = newCapacity;
+
+exit:
+        return;
+}
+
+/**
+ * \brief Calculate the frames of the tabs.
+ *
+ * \details The tabs are as wide as `PLTabItemMaxWidth`, or narrower so that
+ *          they fit the tab bar next to the add buttons, which are as wide as
+ *          the bar is high. Tabs never get so narrow that a tab is entirely
+ *          overlapped by the next one, so very many tabs overflow the bar
+ *          instead.
+ */
+-(NSUInteger)layoutTabCount:(NSUInteger)tabCount inBarOfSize:(NSSize)size
+{
+        NSUInteger firstChangedIndex = NSNotFound, index = 0;
+        CGFloat width = PLTabItemMaxWidth, space = 0.0f;
+        NSRect tabRect = NSZeroRect;
+
+        if (tabCount > 0) {
+                space = (size.width - size.height) / tabCount;
+                width = MIN(width, space);
+        }
+        width = MAX(width, PLTabItemOverlap + 1.0f);
+
+        [self reserveCapacity:tabCount];
+        if (NSEqualSizes(size, barSize) && count > 0 && unroundedTabWidth == width) {
+                index = count;
+        }
+        barSize = size;
+        unroundedTabWidth = width;
+        for (; index < tabCount; index++) {
+                tabRect = NSMakeRect(floorf(1.0f + index * (width - PLTabItemOverlap)),
+                                     0.0f,
+                                     floorf(width),
+                                     floorf(size.height - 3.0f));
+                if (firstChangedIndex == NSNotFound && (index >= count || NSEqualRects(tabRect, frames[index]) == NO)) {
+                        firstChangedIndex = index;
+                }
+                frames[index] = tabRect;
+        }
+        count = tabCount;
+        return firstChangedIndex;
+}
+
+-(NSRect)frameAtIndex:(NSUInteger)index
+{
+        if (index >= count) {
+                [NSException raise:NSRangeException format:@"Index %lu beyond bounds of %lu tabs.", (unsigned long)index, (unsigned long)count];
+        }
+        return frames[index];
+}
+
+#pragma mark - Locating Tabs
+
+-(NSUInteger)indexOfFirstTabAfterLocation:(CGFloat)x
+{
+        NSUInteger low = 0, high = count, middle = 0;
+
+        while (low < high) {
+                middle = low + (high - low) / 2;
+                if (frames[middle].origin.x > x) {
+                        high = middle;
+                } else {
+                        low = middle + 1;
+                }
+        }
+        return low;
+}
+
+-(NSRange)rangeOfTabsAtLocation:(CGFloat)x
+{
+        NSUInteger first = 0, last = 0;
+
+        if (count > 0) {
+                first = [self indexOfFirstTabAfterLocation:x - frames[0].size.width];
+                last = [self indexOfFirstTabAfterLocation:x];
+        }
+        return NSMakeRange(first, last > first ? last - first : 0);
+}
+
+@end
@@ -0,0 +1,234 @@
+/**
+ * \file PLTabPlaceholderViewController.h
+ *
+ * \brief Liasis Python IDE tab placeholder.
+ *
+ * \details This file includes the lightweight view controller standing in for
+ *          an add on's view controller until its tab is activated.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+#import <LiasisKit/LiasisKit.h>
+#import "PLDocumentLoader.h"
+#import "PLEditJournal.h"
+
+/**
+ * \brief Posted on the main thread when a placeholder finishes loading its
+ *        document in the background, whether or not it succeeded.
+ *
+ * \details The notification object is the placeholder.
+ */
+extern NSString * const PLTabPlaceholderDidFinishLoadingNotification;
+
+/**
+ * \class PLTabPlaceholderViewController \headerfile \headerfile
+ *
+ * \brief Stands in for the view controller of a tab that has not been
+ *        activated, or that was unloaded.
+ *
+ * \details A placeholder holds only what is needed to display the tab and to
+ *          create the real view controller later: the add on, the document,
+ *          and the title. The document is retained, so a tab that is unloaded
+ *          back to a placeholder keeps its document and the state stored in
+ *          it.
+ *
+ *          A placeholder restored from a session snapshot only holds the URL
+ *          of its document until `loadDocument` is called, so restored windows
+ *          show their tabs before any document has been read. Placeholders
+ *          also keep the selection and scroll position of their text, which
+ *          are applied to the view controller that replaces them.
+ *
+ *          `loadDocumentInBackground` reads and decodes the file on the
+ *          shared `PLDocumentLoader` first, keeping the decoded text, encoding
+ *          and line ending for the tab view controller, which shows that text
+ *          unless the document was already open with unsaved changes, and
+ *          saves the document with that encoding and line ending. Until then
+ *          the placeholder's view shows that the document is loading. The
+ *          document itself is only opened when the tab is first shown.
+ *
+ *          `PLTabViewController` replaces a placeholder with the view
+ *          controller returned by `createViewController` when its tab is
+ *          activated. Placeholders never hold edited documents, so there is
+ *          nothing to save.
+ */
+@interface PLTabPlaceholderViewController : NSViewController <PLTabSubviewController>
+{
+        /**
+         * \brief The URL of the document to load, for placeholders created
+         *        before their document was loaded.
+         */
+        NSURL * fileURL;
+
+        /**
+         * \brief The background load of the document, or nil if the document
+         *        is not loading.
+         */
+        PLDocumentLoad * documentLoad;
+}
+
+/**
+ * \brief The add on whose view controller the placeholder stands in for.
+ */
+@property (retain, readonly) NSBundle * addOn;
+
+/**
+ * \brief The document of the tab, or nil for a tab without a document or
+ *        whose document has not been loaded.
+ */
+@property (retain, readonly) id document;
+
+/**
+ * \brief The URL of the tab's document, or nil for a tab without a document.
+ */
+@property (readonly) NSURL * fileURL;
+
+/**
+ * \brief The selected range of the tab's text, with a location of `NSNotFound`
+ *        if there is none to restore.
+ */
+@property NSRange selectedRange;
+
+/**
+ * \brief The origin of the visible rectangle of the tab's scrolled text.
+ */
+@property NSPoint scrollPosition;
+
+/**
+ * \brief The text read and decoded by the background load, with line feed
+ *        line endings, or nil if the document was not loaded in the
+ *        background.
+ */
+@property (retain, readonly) NSString * loadedText;
+
+/**
+ * \brief The encoding of the document's file, detected by the background
+ *        load.
+ */
+@property (readonly) NSStringEncoding encoding;
+
+/**
+ * \brief The line ending of the document's file, found by the background
+ *        load, or nil if the document was not loaded in the background.
+ */
+@property (retain, readonly) NSString * lineEnding;
+
+/**
+ * \brief YES while the document is loading in the background.
+ */
+@property (readonly, getter=isLoading) BOOL loading;
+
+/**
+ * \brief The error that made the last background load fail, or nil.
+ */
+@property (retain, readonly) NSError * loadingError;
+
+/**
+ * \brief YES if the tab view controller should present `loadingError` when
+ *        the background load fails, rather than only log it.
+ */
+@property BOOL presentsLoadingError;
+
+/**
+ * \brief The recovered journal to replay into the document when the tab is
+ *        loaded, or nil to look one up by the document's URL.
+ */
+@property (retain) PLEditJournal * editJournal;
+
+/**
+ * \brief Create a placeholder.
+ *
+ * \details The title is the document's file name, or the add on's tab subview
+ *          name if there is no document.
+ *
+ * \param addOn The add on. Its principal class must conform to the
+ *              `PLAddOnExtension` protocol.
+ *
+ * \param aDocument The document of the tab, or nil.
+ *
+ * \return A placeholder on the autorelease pool.
+ */
++(instancetype)placeholderWithAddOn:(NSBundle *)addOn document:(id)aDocument;
+
+/**
+ * \brief Create a placeholder for a document that has not been loaded.
+ *
+ * \details The title is the last path component of the URL until the document
+ *          is loaded.
+ *
+ * \param addOn The add on. Its principal class must conform to the
+ *              `PLAddOnExtension` protocol.
+ *
+ * \param fileURL The URL of the tab's document.
+ *
+ * \return A placeholder on the autorelease pool.
+ *
+ * \see loadDocument
+ */
++(instancetype)placeholderWithAddOn:(NSBundle *)addOn fileURL:(NSURL *)fileURL;
+
+/**
+ * \brief Load the document at `fileURL` through `PLDocumentManager`.
+ *
+ * \details Does nothing if the document has been loaded. If the document
+ *          could not be opened, `loadingError` is set. Must be called on the
+ *          main thread.
+ *
+ * \return YES if the placeholder holds a document afterwards.
+ */
+-(BOOL)loadDocument;
+
+/**
+ * \brief Start loading the document at `fileURL` in the background.
+ *
+ * \details Does nothing if the document or its text has been loaded or is
+ *          loading. When the file has been read and decoded, its text,
+ *          encoding and line ending are kept in `loadedText`, `encoding` and
+ *          `lineEnding`, and a `PLTabPlaceholderDidFinishLoadingNotification`
+ *          is posted. The document is not opened until `loadDocument` or
+ *          `createViewController` is called.
+ *
+ * \return YES if the document is loading afterwards.
+ */
+-(BOOL)loadDocumentInBackground;
+
+/**
+ * \brief Cancel loading the document in the background.
+ *
+ * \details No notification is posted for a cancelled load.
+ */
+-(void)cancelLoadingDocument;
+
+/**
+ * \brief Create the add on's view controller for the document.
+ *
+ * \details The document is loaded first if needed. The view controller's
+ *          view is not loaded.
+ *
+ * \return A view controller on the autorelease pool, or nil if the add on's
+ *         principal class does not conform to `PLAddOnExtension` or the
+ *         document could not be loaded.
+ */
+-(NSViewController <PLAddOnExtension> *)createViewController;
+
+@end
@@ -0,0 +1,268 @@
+/**
+ * \file PLTabPlaceholderViewController.m
+ *
+ * \brief Liasis Python IDE tab placeholder.
+ *
+ * \details This file includes the lightweight view controller standing in for
+ *          an add on's view controller until its tab is activated.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLTabPlaceholderViewController.h"
+
+NSString * const PLTabPlaceholderDidFinishLoadingNotification = @"PLTabPlaceholderDidFinishLoadingNotification";
+
+@implementation PLTabPlaceholderViewController
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)initWithAddOn:(NSBundle *)addOn document:(id)aDocument fileURL:(NSURL *)aFileURL
+{
+        self = [super initWithNibName:nil bundle:nil];
+        if (self) {
+                _addOn = [addOn retain];
+                _document = [aDocument retain];
+                fileURL = [aFileURL copy];
+                _selectedRange = NSMakeRange(NSNotFound, 0);
+                _scrollPosition = NSZeroPoint;
+                if (aDocument) {
+                        [self setTitle:[aDocument filename]];
+                } else if (aFileURL) {
+                        [self setTitle:[aFileURL lastPathComponent]];
+                } else if ([[addOn principalClass] conformsToProtocol:@protocol(PLAddOnExtension)]) {
+                        [self setTitle:[[addOn principalClass] tabSubviewName]];
+                }
+        }
+        return self;
+}
+
++(instancetype)placeholderWithAddOn:(NSBundle *)addOn document:(id)aDocument
+{
+        return [[[self alloc] initWithAddOn:addOn document:aDocument fileURL:nil] autorelease];
+}
+
++(instancetype)placeholderWithAddOn:(NSBundle *)addOn fileURL:(NSURL *)aFileURL
+{
+        return [[[self alloc] initWithAddOn:addOn document:nil fileURL:aFileURL] autorelease];
+}
+
+-(void)dealloc
+{
+        [self cancelLoadingDocument];
+        [_loadingError release];
+        [_loadedText release];
+        [_lineEnding release];
+        [_editJournal release];
+        [_addOn release];
+        [_document release];
+        [fileURL release];
+        [super dealloc];
+}
+
+#pragma mark - Document
+
+-(NSURL *)fileURL
+{
+        return _document ? [_document fileURL] : fileURL;
+}
+
+-(BOOL)loadDocument
+{
+        [self cancelLoadingDocument];
+        if (_document == nil && fileURL) {
+                _document = [[[PLDocumentManager sharedDocumentManager] documentForURL:fileURL] retain];
+                if (_document) {
+                        [self setTitle:[_document filename]];
+                        [[NSNotificationCenter defaultCenter] postNotificationName:PLTabSubviewTitleDidChangeNotification
+                                                                            object:self];
+                } else if (_loadingError == nil) {
+                        _loadingError = [[NSError errorWithDomain:PLLiasisErrorDomain
+                                                             code:PLErrorCodeModal
+                                                         userInfo:@{NSLocalizedDescriptionKey: @"File could not be opened.",
+                                                                    NSURLErrorKey: fileURL}] retain];
+                }
+        }
+        return _document != nil;
+}
+
+-(BOOL)isLoading
+{
+        return documentLoad != nil;
+}
+
+-(BOOL)loadDocumentInBackground
+{
+        __block PLTabPlaceholderViewController * blockSelf = self;
+
+        if (_document || _loadedText || fileURL == nil || documentLoad) {
+                goto exit;
+        }
+        [_loadingError release];
+        _loadingError = nil;
+        documentLoad = [[[PLDocumentLoader sharedLoader] loadDocumentAtURL:fileURL completionHandler:^(PLDocumentLoad * load) {
+                [blockSelf documentLoadDidFinish:load];
+        }] retain];
+
+exit:
+        return documentLoad != nil;
+}
+
+/**
+ * \brief Keep the decoded text, encoding and line ending of a finished load
+ *        for the tab view controller.
+ *
+ * \details `PLDocumentManager` only opens documents by reading their URL, so
+ *          the document is not opened here, on the main thread, for every tab
+ *          that finishes loading. It is opened by `createViewController` when
+ *          the tab is first shown, and is the document already open in
+ *          another tab if there is one.
+ *
+ * \param load The finished load.
+ */
+-(void)documentLoadDidFinish:(PLDocumentLoad *)load
+{
+        [documentLoad release];
+        documentLoad = nil;
+        if (load.error) {
+                _loadingError = [load.error retain];
+                goto exit;
+        }
+        [_loadedText release];
+        _loadedText = [load.text retain];
+        [_lineEnding release];
+        _lineEnding = [load.lineEnding retain];
+        _encoding = load.encoding;
+
+exit:
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLTabPlaceholderDidFinishLoadingNotification
+                                                            object:self];
+}
+
+-(void)cancelLoadingDocument
+{
+        [documentLoad cancel];
+        [documentLoad release];
+        documentLoad = nil;
+}
+
+/**
+ * \brief Use an empty view, with a spinning progress indicator while the
+ *        document is loading.
+ *
+ * \details The view is only displayed when the tab of a loading document is
+ *          activated.
+ */
+-(void)loadView
+{
+        NSView * view = [[[NSView alloc] initWithFrame:NSMakeRect(0.0f, 0.0f, 64.0f, 64.0f)] autorelease];
+        NSProgressIndicator * progressIndicator = nil;
+
+        if ([self isLoading]) {
+                progressIndicator = [[[NSProgressIndicator alloc] initWithFrame:NSMakeRect(16.0f, 16.0f, 32.0f, 32.0f)] autorelease];
+                [progressIndicator setStyle:NSProgressIndicatorSpinningStyle];
+                [progressIndicator setDisplayedWhenStopped:NO];
+                [progressIndicator setAutoresizingMask:NSViewMinXMargin | NSViewMaxXMargin | NSViewMinYMargin | NSViewMaxYMargin];
+                [view addSubview:progressIndicator];
+                [progressIndicator startAnimation:self];
+        }
+        [view setAutoresizingMask:NSViewWidthSizable | NSViewHeightSizable];
+        [self setView:view];
+}
+
+-(NSViewController <PLAddOnExtension> *)createViewController
+{
+        Class controllerClass = [self.addOn principalClass];
+        NSViewController <PLAddOnExtension> * viewController = nil;
+
+        if ([controllerClass conformsToProtocol:@protocol(PLAddOnExtension)] == NO) {
+                NSLog(@"Error: view controller must conform to the PLAddOnExtension protocol.");
+                goto exit;
+        }
+        if (fileURL && [self loadDocument] == NO) {
+                NSLog(@"Error: the document at %@ could not be loaded.", [fileURL path]);
+                goto exit;
+        }
+        if (self.document)
+                viewController = [controllerClass viewControllerWithDocument:self.document];
+        else
+                viewController = [controllerClass viewController];
+
+exit:
+        return viewController;
+}
+
+#pragma mark - Tab Subview Controller
+
+/**
+ * \brief Let the add on decide if the tab may close.
+ *
+ * \details The add on's view controller is created without loading its view
+ *          and asked in the placeholder's place, so closing a tab that was
+ *          never activated releases its document the same way as closing any
+ *          other tab. A tab whose document has not been loaded always closes.
+ *
+ * \return YES if the tab may close.
+ */
+-(BOOL)tabSubviewShouldClose:(id)sender
+{
+        NSViewController <PLAddOnExtension> * viewController = nil;
+        BOOL shouldClose = YES;
+
+        if (fileURL && _document == nil) {
+                goto exit;
+        }
+        viewController = [self createViewController];
+        if (viewController) {
+                shouldClose = [viewController tabSubviewShouldClose:sender];
+        }
+
+exit:
+        return shouldClose;
+}
+
+/**
+ * \brief Does nothing, as placeholders never hold edited documents.
+ */
+-(IBAction)saveFile:(id)sender
+{
+        return;
+}
+
+/**
+ * \brief Does nothing, as placeholders never hold edited documents.
+ */
+-(IBAction)saveFileAs:(id)sender
+{
+        return;
+}
+
+/**
+ * \brief Does nothing; the view controller created for the tab is updated
+ *        when it replaces the placeholder.
+ */
+-(void)updateThemeManager
+{
+        return;
+}
+
+@end
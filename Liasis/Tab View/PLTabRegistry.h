@@ -0,0 +1,150 @@
+/**
+ * \file PLTabRegistry.h
+ *
+ * \brief Liasis Python IDE tab registry.
+ *
+ * \details This file includes the application wide index of the tabs showing
+ *          each file.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+#import <LiasisKit/LiasisKit.h>
+
+@class PLTabViewController;
+
+/**
+ * \class PLTabRegistry \headerfile \headerfile
+ *
+ * \brief Maps files to the tabs showing them in every window.
+ *
+ * \details Each tab is registered under two keys: the standardized path of its
+ *          file, and the device and inode of the file. Looking up a URL first
+ *          tries its path, which needs no file system access, and then the
+ *          identity of the file, so symbolic links, hard links, and paths
+ *          differing only in case on a case-insensitive volume find the same
+ *          tab. A file replaced by an atomic save keeps being found by its
+ *          path, but gets a new inode, so the identity key of a tab goes
+ *          stale when its file is replaced. A tab found by identity is only
+ *          returned if its own file still has that identity; otherwise it is
+ *          registered again under the current identity of its file, so a
+ *          freed inode reused by another file never finds it.
+ *
+ *          `PLTabViewController` registers its tabs when they are added,
+ *          their document's URL changes, or their document is saved, and
+ *          removes them when they close. Lookups by path cost a hash of the
+ *          path; lookups by identity cost one more `stat` for each tab found,
+ *          however many windows and tabs are open.
+ *
+ *          The registry must only be used from the main thread.
+ */
+@interface PLTabRegistry : NSObject
+{
+        /**
+         * \brief The tab items registered under each key, as arrays in
+         *        registration order.
+         */
+        NSMutableDictionary * tabItemsByKey;
+
+        /**
+         * \brief The keys of each registered tab item.
+         */
+        NSMapTable * keysByTabItem;
+
+        /**
+         * \brief The URL each tab item was registered under.
+         */
+        NSMapTable * fileURLsByTabItem;
+
+        /**
+         * \brief The tab view controller of each registered tab item.
+         *
+         * \details Tab view controllers are not retained; they remove their
+         *          tab items before they are deallocated.
+         */
+        NSMapTable * tabViewControllersByTabItem;
+}
+
+/**
+ * \brief The shared tab registry.
+ *
+ * \return The tab registry of the application.
+ */
++(instancetype)sharedRegistry;
+
+/**
+ * \brief The key identifying the file at a URL regardless of the path used to
+ *        reach it.
+ *
+ * \param fileURL A file URL.
+ *
+ * \return The device and inode of the file, or nil if the file does not exist.
+ */
++(NSString *)fileIdentityKeyForURL:(NSURL *)fileURL;
+
+/**
+ * \brief Register a tab under the URL of its document.
+ *
+ * \details Replaces any earlier registration of the tab. Registering a tab
+ *          again under the same URL updates the identity of its file, which
+ *          changes when the file is replaced.
+ *
+ * \param fileURL The URL of the document, or nil to remove the tab.
+ *
+ * \param tabItem The tab item.
+ *
+ * \param tabViewController The tab view controller containing the tab.
+ */
+-(void)setFileURL:(NSURL *)fileURL forTabItem:(PLTabBarItemLayer *)tabItem inTabViewController:(PLTabViewController *)tabViewController;
+
+/**
+ * \brief Remove a tab.
+ *
+ * \details Does nothing if the tab is not registered.
+ *
+ * \param tabItem The tab item.
+ */
+-(void)removeTabItem:(PLTabBarItemLayer *)tabItem;
+
+/**
+ * \brief Return the first tab showing a file.
+ *
+ * \param fileURL The URL of the file.
+ *
+ * \param tabViewController The tab view controller to search, or nil to
+ *                          search all of them.
+ *
+ * \return The first registered tab item showing the file, or nil.
+ */
+-(PLTabBarItemLayer *)tabItemForURL:(NSURL *)fileURL inTabViewController:(PLTabViewController *)tabViewController;
+
+/**
+ * \brief Return the tab view controller containing a registered tab.
+ *
+ * \param tabItem The tab item.
+ *
+ * \return The tab view controller, or nil if the tab is not registered.
+ */
+-(PLTabViewController *)tabViewControllerForTabItem:(PLTabBarItemLayer *)tabItem;
+
+@end
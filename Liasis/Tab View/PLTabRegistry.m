@@ -0,0 +1,249 @@
+/**
+ * \file PLTabRegistry.m
+ *
+ * \brief Liasis Python IDE tab registry.
+ *
+ * \details This file includes the application wide index of the tabs showing
+ *          each file.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLTabRegistry.h"
+#include <sys/stat.h>
+
+@implementation PLTabRegistry
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                tabItemsByKey = [[NSMutableDictionary alloc] init];
+                keysByTabItem = [[NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory] retain];
+                fileURLsByTabItem = [[NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory] retain];
+                tabViewControllersByTabItem = [[NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory
+                                                                     valueOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsObjectPointerPersonality] retain];
+        }
+        return self;
+}
+
++(instancetype)sharedRegistry
+{
+        static PLTabRegistry * sharedRegistry = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedRegistry = [[self alloc] init];
+        });
+        return sharedRegistry;
+}
+
+-(void)dealloc
+{
+        [tabItemsByKey release];
+        [keysByTabItem release];
+        [fileURLsByTabItem release];
+        [tabViewControllersByTabItem release];
+        [super dealloc];
+}
+
+#pragma mark - Keys
+
+/**
+ * \brief The key of the standardized path of a URL.
+ *
+ * \param fileURL A file URL.
+ *
+ * \return The key, or nil if `fileURL` is not a file URL.
+ */
++(NSString *)pathKeyForURL:(NSURL *)fileURL
+{
+        NSString * key = nil;
+
+        if ([fileURL isFileURL]) {
+                key = [@"path:" stringByAppendingString:[[fileURL path] stringByStandardizingPath]];
+        }
+        return key;
+}
+
++(NSString *)fileIdentityKeyForURL:(NSURL *)fileURL
+{
+        NSString * key = nil;
+        struct stat fileStat;
+
+        if ([fileURL isFileURL] && stat([[fileURL path] fileSystemRepresentation], &fileStat) == 0) {
+                key = [NSString stringWithFormat:@"inode:%llx:%llx",
+                       (unsigned long long)fileStat.st_dev,
+                       (unsigned long long)fileStat.st_ino];
+        }
+        return key;
+}
+
+#pragma mark - Registering Tabs
+
+-(void)setFileURL:(NSURL *)fileURL forTabItem:(PLTabBarItemLayer *)tabItem inTabViewController:(PLTabViewController *)tabViewController
+{
+        NSMutableArray * keys = [NSMutableArray array];
+        NSMutableArray * tabItems = nil;
+        NSString * key = nil;
+
+        [self removeTabItem:tabItem];
+        if (tabItem == nil || tabViewController == nil) {
+                goto exit;
+        }
+
+        key = [[self class] pathKeyForURL:fileURL];
+        if (key == nil) {
+                goto exit;
+        }
+        [keys addObject:key];
+        key = [[self class] fileIdentityKeyForURL:fileURL];
+        if (key) {
+                [keys addObject:key];
+        }
+
+        for (key in keys) {
+                tabItems = [tabItemsByKey objectForKey:key];
+                if (tabItems == nil) {
+                        tabItems = [NSMutableArray array];
+                        [tabItemsByKey setObject:tabItems forKey:key];
+                }
+                [tabItems addObject:tabItem];
+        }
+        [keysByTabItem setObject:keys forKey:tabItem];
+        [fileURLsByTabItem setObject:fileURL forKey:tabItem];
+        [tabViewControllersByTabItem setObject:tabViewController forKey:tabItem];
+
+exit:
+        return;
+}
+
+-(void)removeTabItem:(PLTabBarItemLayer *)tabItem
+{
+        NSMutableArray * tabItems = nil;
+
+        if (tabItem == nil) {
+                goto exit;
+        }
+        for (NSString * key in [keysByTabItem objectForKey:tabItem]) {
+                tabItems = [tabItemsByKey objectForKey:key];
+                [tabItems removeObjectIdenticalTo:tabItem];
+                if ([tabItems count] == 0) {
+                        [tabItemsByKey removeObjectForKey:key];
+                }
+        }
+        [keysByTabItem removeObjectForKey:tabItem];
+        [fileURLsByTabItem removeObjectForKey:tabItem];
+        [tabViewControllersByTabItem removeObjectForKey:tabItem];
+
+exit:
+        return;
+}
+
+#pragma mark - Querying Tabs
+
+/**
+ * \brief Return the first tab registered under a key.
+ *
+ * \param key The key.
+ *
+ * \param tabViewController The tab view controller to search, or nil to
+ *                          search all of them.
+ *
+ * \return The tab item, or nil.
+ */
+-(PLTabBarItemLayer *)tabItemForKey:(NSString *)key inTabViewController:(PLTabViewController *)tabViewController
+{
+        PLTabBarItemLayer * tabItem = nil;
+
+        for (PLTabBarItemLayer * item in [tabItemsByKey objectForKey:key]) {
+                if (tabViewController == nil || [tabViewControllersByTabItem objectForKey:item] == tabViewController) {
+                        tabItem = item;
+                        break;
+                }
+        }
+        return tabItem;
+}
+
+/**
+ * \brief Return the first tab registered under a file identity key whose
+ *        file still has that identity.
+ *
+ * \details Tabs whose files were replaced since they were registered are
+ *          registered again under the current identity of their files.
+ *
+ * \param key The file identity key.
+ *
+ * \param tabViewController The tab view controller to search, or nil to
+ *                          search all of them.
+ *
+ * \return The tab item, or nil.
+ */
+-(PLTabBarItemLayer *)tabItemForFileIdentityKey:(NSString *)key inTabViewController:(PLTabViewController *)tabViewController
+{
+        PLTabBarItemLayer * tabItem = nil;
+        NSURL * registeredURL = nil;
+
+        for (PLTabBarItemLayer * item in [[[tabItemsByKey objectForKey:key] copy] autorelease]) {
+                if (tabViewController && [tabViewControllersByTabItem objectForKey:item] != tabViewController) {
+                        continue;
+                }
+                registeredURL = [[[fileURLsByTabItem objectForKey:item] retain] autorelease];
+                if ([key isEqualToString:[[self class] fileIdentityKeyForURL:registeredURL]] == NO) {
+                        [self setFileURL:registeredURL
+                              forTabItem:item
+                     inTabViewController:[tabViewControllersByTabItem objectForKey:item]];
+                        continue;
+                }
+                tabItem = item;
+                break;
+        }
+        return tabItem;
+}
+
+-(PLTabBarItemLayer *)tabItemForURL:(NSURL *)fileURL inTabViewController:(PLTabViewController *)tabViewController
+{
+        PLTabBarItemLayer * tabItem = nil;
+        NSString * key = [[self class] pathKeyForURL:fileURL];
+
+        if (key == nil) {
+                goto exit;
+        }
+        tabItem = [self tabItemForKey:key inTabViewController:tabViewController];
+        if (tabItem == nil) {
+                key = [[self class] fileIdentityKeyForURL:fileURL];
+                if (key) {
+                        tabItem = [self tabItemForFileIdentityKey:key inTabViewController:tabViewController];
+                }
+        }
+
+exit:
+        return tabItem;
+}
+
+-(PLTabViewController *)tabViewControllerForTabItem:(PLTabBarItemLayer *)tabItem
+{
+        return [tabViewControllersByTabItem objectForKey:tabItem];
+}
+
+@end
@@ -30,8 +30,20 @@
 #import <Cocoa/Cocoa.h>
 #import <LiasisKit/LiasisKit.h>
 #import "PLTabBar.h"
+#import "PLEditJournal.h"
+#import "PLSyntaxHighlighter.h"
+#import "PLTabBarLayout.h"
 #import "PLTabBarView.h"
 #import "PLTabSubview.h"
+#import "PLSessionWindow.h"
+
+/**
+ * \brief Posted when tabs are added, removed, moved, or activated, or when the
+ *        title of a tab changes.
+ *
+ * \details The notification object is the `PLTabViewController`.
+ */
+extern NSString * const PLTabViewControllerTabsDidChangeNotification;
 
 /**
  * \class PLTabViewController \headerfile \headerfile
@@ -44,6 +56,20 @@
  *          bar items, each with a unique identifier string. The identifier
  *          strings serve as keys for a dictionary, thus linking the tabs with
  *          the tab subview controllers.
+ *
+ *          Tabs of add ons are added as `PLTabPlaceholderViewController`
+ *          placeholders, and the add on's view controller is only created when
+ *          the tab is first activated. Background tabs that have not been
+ *          active recently are unloaded back to placeholders, keeping their
+ *          documents, so only a bounded number of add on view controllers
+ *          exist however many files are open.
+ *
+ *          The edits of the text view of each loaded tab are recorded in a
+ *          `PLEditJournal` until its document is saved or closed. When a tab
+ *          loads a document left with unsaved edits by a crash, the edits are
+ *          replayed before the tab is shown. The text view of each loaded tab
+ *          of a Python document is colored by a `PLSyntaxHighlighter`, and
+ *          only lays out the text it shows.
  */
 @interface PLTabViewController : NSViewController <PLThemeable, PLTabBarViewDelegate> {
         /**
@@ -58,6 +84,28 @@
         
         PLTabBar * tabBar;
 
+        /**
+         * \brief The frames of the tab items in `tabBar`.
+         */
+        PLTabBarLayout * tabBarLayout;
+
+        /**
+         * \brief The tracking area covering the whole tab bar, used to show
+         *        the close button of the tab under the mouse.
+         */
+        NSTrackingArea * tabBarTrackingArea;
+
+        /**
+         * \brief The tab item showing its close button because the mouse is
+         *        over it, or nil.
+         */
+        PLTabBarItemLayer * hoveredTabItem;
+
+        /**
+         * \brief The tab item being dragged, or nil.
+         */
+        PLTabBarItemLayer * draggedTabItem;
+
         /**
          * \brief An NSButton object used to display the button for adding a
          *        default tab by sending a message to the addTab: private method.
@@ -89,6 +137,78 @@
          * \details Setting this value updates the color of the active tab.
          */
         NSColor * activeTabColor;
+
+        /**
+         * \brief The tab items that have been active, least recently active
+         *        first.
+         */
+        NSMutableArray * recentTabItems;
+
+        /**
+         * \brief The loaded background tab items whose view controllers have
+         *        not been updated since the theme changed.
+         */
+        NSMutableSet * staleThemeTabItems;
+
+        /**
+         * \brief The font last passed to `updateFont:`, applied to view
+         *        controllers added afterwards.
+         */
+        NSFont * tabSubviewFont;
+
+        /**
+         * \brief The loaded background tab items still to be updated with
+         *        `tabSubviewFont`, in the order they are updated.
+         */
+        NSMutableArray * staleFontTabItems;
+
+        /**
+         * \brief The number of tabs updated since the font last changed.
+         */
+        NSUInteger fontChangeTabCount;
+
+        /**
+         * \brief The time at which the font last changed.
+         */
+        CFAbsoluteTime fontChangeStartTime;
+
+        /**
+         * \brief The `PLEditJournal` of each loaded tab with a text view, by
+         *        the identifier of its tab item.
+         */
+        NSMutableDictionary * editJournals;
+
+        /**
+         * \brief The `PLSyntaxHighlighter` of each loaded tab of a Python
+         *        document, by the identifier of its tab item.
+         */
+        NSMutableDictionary * syntaxHighlighters;
+
+        /**
+         * \brief The line number to select in each tab once it is loaded, by
+         *        the identifier of its tab item.
+         */
+        NSMutableDictionary * pendingSelectedLines;
+
+        /**
+         * \brief The encoding of the file of each tab whose document was
+         *        read by the `PLDocumentLoader`, by the identifier of its tab
+         *        item.
+         */
+        NSMutableDictionary * fileEncodings;
+
+        /**
+         * \brief The line ending of the file of each tab whose document was
+         *        read by the `PLDocumentLoader`, by the identifier of its tab
+         *        item.
+         */
+        NSMutableDictionary * fileLineEndings;
+
+        /**
+         * \brief The number of edits of the text of each tab saved since it
+         *        was loaded, by the text storage of its text view.
+         */
+        NSMapTable * editGenerations;
 }
 
 /**
@@ -159,6 +279,83 @@
  */
 -(void)addTabWithAddOn:(NSBundle *)addOn withDocument:(id)aDocument;
 
+/**
+ * \brief Add a tab for an add on and a document, optionally in the background.
+ *
+ * \details The tab is added with a placeholder. The add on's view controller
+ *          is created, as described in `addTabWithAddOn:withDocument:`, when
+ *          the tab is first activated, so tabs added in the background cost
+ *          little until they are shown. The tab is activated anyway if there
+ *          is no active tab.
+ *
+ * \param addOn The add on.
+ *
+ * \param aDocument The document used by the add on.
+ *
+ * \param activate YES to make the new tab the active tab.
+ *
+ * \see addTabWithAddOn:withDocument:
+ */
+-(void)addTabWithAddOn:(NSBundle *)addOn withDocument:(id)aDocument activate:(BOOL)activate;
+
+/**
+ * \brief Add a tab with a view controller that is not provided by an add on.
+ *
+ * \details The view controller is added the same way as the view controllers
+ *          of add ons, and its tab becomes the active tab. Used for tabs owned
+ *          by the application itself, such as the project search results.
+ *
+ * \param viewController The view controller of the tab.
+ *
+ * \see addTabWithAddOn:withDocument:
+ */
+-(void)addTabWithViewController:(NSViewController <PLTabSubviewController> *)viewController;
+
+/**
+ * \brief Add a tab with a view controller, optionally in the background.
+ *
+ * \param viewController The view controller of the tab.
+ *
+ * \param activate YES to make the new tab the active tab. The tab is activated
+ *                 anyway if there is no active tab.
+ *
+ * \see addTabWithViewController:
+ */
+-(void)addTabWithViewController:(NSViewController <PLTabSubviewController> *)viewController activate:(BOOL)activate;
+
+/**
+ * \brief Add a tab for the document at a URL, loading it in the background.
+ *
+ * \details The tab is added at once with a placeholder showing that its
+ *          document is loading, and the file is read and decoded by the shared
+ *          `PLDocumentLoader`. The document is opened when the load finishes,
+ *          and the add on's view controller is created then if the tab is
+ *          active, showing the loaded text. The encoding and line ending
+ *          found by the load are kept for the tab's saves. If the load fails, the tab is removed and the error is
+ *          presented. Closing the tab first cancels the load.
+ *
+ * \param addOn The add on. Its principal class must conform to the
+ *              `PLAddOnExtension` protocol.
+ *
+ * \param fileURL The URL of the document.
+ *
+ * \param activate YES to make the new tab the active tab.
+ *
+ * \return YES if the tab was added.
+ */
+-(BOOL)addTabWithAddOn:(NSBundle *)addOn fileURL:(NSURL *)fileURL activate:(BOOL)activate;
+
+/**
+ * \brief Add a background tab with an untitled document recovered from the
+ *        journal of an earlier launch.
+ *
+ * \details The tab uses the default add on and is loaded at once, so its
+ *          recovered edits show as unsaved changes.
+ *
+ * \param journal The recovered journal of the untitled document.
+ */
+-(void)addTabWithRecoveredJournal:(PLEditJournal *)journal;
+
 /**
  * \brief Method used to programattically set the active tab. 
  *
@@ -170,6 +367,12 @@
  *          This method does nothing if `tabName` already corresponds to the
  *          active tab or if no tabs are identified by `tabName`.
  *
+ *          If the tab holds a placeholder, the add on's view controller is
+ *          created first, unless its document is still loading, in which case
+ *          the placeholder is shown until the document is ready. Afterwards,
+ *          the least recently active background tabs are unloaded if too many
+ *          tabs are loaded.
+ *
  * \param tabItem The tab item to make active.
  */
 -(void)setActiveTab:(PLTabBarItemLayer *)tabItem;
@@ -208,6 +411,45 @@
  */
 -(void)setTabWithURLActive:(NSURL *)fileURL;
 
+/**
+ * \brief Check if the tab view contains a tab with a view controller.
+ *
+ * \param viewController The view controller.
+ *
+ * \return YES if one of the tabs is managed by `viewController`.
+ */
+-(BOOL)containsTabWithViewController:(NSViewController *)viewController;
+
+/**
+ * \brief Set the active tab to the one managed by a view controller.
+ *
+ * \details Does nothing if no tabs are managed by `viewController`.
+ *
+ * \param viewController The view controller.
+ */
+-(void)setTabWithViewControllerActive:(NSViewController *)viewController;
+
+/**
+ * \brief Select a line of the text of the tab containing a document.
+ *
+ * \details If the tab is not loaded yet, the line is selected when it is.
+ *          Does nothing if no tabs contain the document at `fileURL`.
+ *
+ * \param line The number of the line, starting at 1.
+ *
+ * \param fileURL The URL of the document.
+ */
+-(void)selectLine:(NSUInteger)line ofTabWithURL:(NSURL *)fileURL;
+
+/**
+ * \brief The name selected, or under the insertion point, in the text of the
+ *        active tab.
+ *
+ * \return The name, or nil if the active tab has no text view or no name is
+ *         selected.
+ */
+-(NSString *)selectedNameOfActiveTab;
+
 /**
  * \brief Method used to close all tabs and determine if all the tabs have been
  *        succesfully closed.
@@ -222,19 +464,64 @@
  */
 -(BOOL)shouldCloseAllTabs;
 
+#pragma mark - Session
+
+/**
+ * \brief The tabs to record in a session snapshot.
+ *
+ * \details Only tabs whose documents are saved to a file are recorded. The
+ *          selection and scroll position are read from the first `NSTextView`
+ *          in the view of each loaded tab, and from the placeholder of each
+ *          unloaded tab.
+ *
+ * \param activeTabIndex On return, the index of the active tab in the returned
+ *                       array, or `NSNotFound` if it is not recorded.
+ *
+ * \return An array of `PLSessionTab` objects in tab bar order.
+ */
+-(NSArray *)sessionTabsWithActiveTabIndex:(NSUInteger *)activeTabIndex;
+
+/**
+ * \brief Add the tabs of a restored session.
+ *
+ * \details The tabs are added at once with their placeholders, and the tab at
+ *          `activeTabIndex` is activated while its document is still loading.
+ *          The documents are loaded in the background, starting with the
+ *          active tab. Tabs whose documents cannot be loaded are removed.
+ *
+ * \param placeholders The `PLTabPlaceholderViewController` objects of the
+ *                     tabs, created with `placeholderWithAddOn:fileURL:`.
+ *
+ * \param activeTabIndex The index of the tab to load and activate first, or
+ *                       `NSNotFound` to start with the first tab.
+ */
+-(void)addTabsWithPlaceholders:(NSArray *)placeholders activeTabIndex:(NSUInteger)activeTabIndex;
+
 #pragma mark - Open, Save, and Close
 
 /**
  * \brief Save the active tab.
  *
- * \details This method sends a `saveFile:` action message to the subview
- *          controller of the active tab. The `saveFile:` method is part of the
- *          `PLTabSubviewController` protocol.
+ * \details If the active tab has a text view and its document has a file,
+ *          a snapshot of its text is saved in the background by the
+ *          `PLDocumentSaver`, in the encoding and line ending of the file,
+ *          with the progress shown on the tab. Subview controllers conforming
+ *          to `PLDocumentSaving` create the save themselves. Otherwise, this
+ *          method sends the subview controller a `saveFile:` action message,
+ *          which is part of the `PLTabSubviewController` protocol.
  *
  * \see PLTabSubviewController
  */
 -(void)saveActiveTab;
 
+/**
+ * \brief Save the edited documents of all tabs.
+ *
+ * \details The documents are saved as one batch of the `PLDocumentSaver`, in
+ *          the same way as `saveActiveTab`.
+ */
+-(void)saveAllTabs;
+
 /**
  * \brief Save As the active tab.
  *
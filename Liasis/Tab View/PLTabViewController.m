@@ -27,14 +27,234 @@
  */
 
 #import "PLTabViewController.h"
+#import "PLAddOnLoader.h"
+#import "PLDocumentSaver.h"
+#import "PLPieceTableTextStorage.h"
+#import "PLTabPlaceholderViewController.h"
+#import "PLLargeFileViewController.h"
+#import "PLTabRegistry.h"
+#import "PLThemeTable.h"
+#import "PLUserDefaults.h"
 
-const CGFloat PLTabItemMaxWidth = 200.0f;
+/**
+ * \brief The maximum number of tabs whose add on view controllers are kept
+ *        loaded while in the background.
+ */
+static const NSUInteger PLTabViewControllerMaximumLoadedTabs = 8;
+
+/**
+ * \brief The length of text from which a tab's text view only lays out its
+ *        text as it is scrolled to, rather than in the background.
+ */
+static const NSUInteger PLTabViewControllerBackgroundLayoutLength = 1024 * 1024;
+
+NSString * const PLTabViewControllerTabsDidChangeNotification = @"PLTabViewControllerTabsDidChangeNotification";
+
+/**
+ * \brief Find the first text view in a view hierarchy.
+ *
+ * \param view The root of the view hierarchy.
+ *
+ * \return The first `NSTextView` in a depth first search, or nil.
+ */
+static NSTextView * PLTabViewControllerTextView(NSView * view)
+{
+        NSTextView * textView = nil;
+
+        if ([view isKindOfClass:[NSTextView class]]) {
+                textView = (NSTextView *)view;
+                goto exit;
+        }
+        for (NSView * subview in [view subviews]) {
+                textView = PLTabViewControllerTextView(subview);
+                if (textView) {
+                        break;
+                }
+        }
+
+exit:
+        return textView;
+}
+
+/**
+ * \brief Read the selection and scroll position of the text of a tab.
+ *
+ * \param viewController The view controller of the tab. Its view is not
+ *                       loaded by this function.
+ *
+ * \param selectedRange On return, the selected range of the text.
+ *
+ * \param scrollPosition On return, the origin of the visible rectangle of the
+ *                       text.
+ *
+ * \return YES if the view controller's view is loaded and contains a text view.
+ */
+static BOOL PLTabViewControllerGetTextState(NSViewController * viewController, NSRange * selectedRange, NSPoint * scrollPosition)
+{
+        NSTextView * textView = nil;
+        BOOL found = NO;
+
+        if ([viewController isViewLoaded] == NO) {
+                goto exit;
+        }
+        textView = PLTabViewControllerTextView([viewController view]);
+        if (textView == nil) {
+                goto exit;
+        }
+        *selectedRange = [textView selectedRange];
+        *scrollPosition = [[[textView enclosingScrollView] contentView] bounds].origin;
+        found = YES;
+
+exit:
+        return found;
+}
+
+/**
+ * \brief Restore the selection and scroll position of the text of a tab.
+ *
+ * \details The selection is clamped to the length of the text, which may have
+ *          changed on disk since it was recorded.
+ *
+ * \param viewController The view controller of the tab.
+ *
+ * \param selectedRange The selected range, or a range with a location of
+ *                      `NSNotFound` to leave the text unchanged.
+ *
+ * \param scrollPosition The origin of the visible rectangle of the text.
+ */
+static void PLTabViewControllerSetTextState(NSViewController * viewController, NSRange selectedRange, NSPoint scrollPosition)
+{
+        NSTextView * textView = nil;
+        NSScrollView * scrollView = nil;
+        NSUInteger length = 0;
+
+        if (selectedRange.location == NSNotFound) {
+                goto exit;
+        }
+        textView = PLTabViewControllerTextView([viewController view]);
+        if (textView == nil) {
+                goto exit;
+        }
+        length = [[textView string] length];
+        selectedRange.location = MIN(selectedRange.location, length);
+        selectedRange.length = MIN(selectedRange.length, length - selectedRange.location);
+        [textView setSelectedRange:selectedRange];
+        scrollView = [textView enclosingScrollView];
+        [[scrollView contentView] scrollToPoint:scrollPosition];
+        [scrollView reflectScrolledClipView:[scrollView contentView]];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Select a line of the text of a tab and scroll it into view.
+ *
+ * \param viewController The view controller of the tab.
+ *
+ * \param line The number of the line, starting at 1. Lines past the end of
+ *             the text select the end.
+ *
+ * \return YES if the view controller has a text view.
+ */
+static BOOL PLTabViewControllerSelectLine(NSViewController * viewController, NSUInteger line)
+{
+        NSTextView * textView = PLTabViewControllerTextView([viewController view]);
+        NSString * string = [textView string];
+        NSUInteger length = [string length], index = 0, lineNumber = 0;
+        NSRange lineRange = NSMakeRange(0, 0);
+
+        if (textView == nil) {
+                goto exit;
+        }
+        for (lineNumber = 1; lineNumber < line && index < length; lineNumber++) {
+                index = NSMaxRange([string lineRangeForRange:NSMakeRange(index, 0)]);
+        }
+        lineRange = [string lineRangeForRange:NSMakeRange(index, 0)];
+        [textView setSelectedRange:lineRange];
+        [textView scrollRangeToVisible:lineRange];
+
+exit:
+        return textView != nil;
+}
+
+/**
+ * \brief Find the first character visible in the text of a tab.
+ *
+ * \param viewController The view controller of the tab. Its view is not
+ *                       loaded by this function.
+ *
+ * \return The index of the character at the top left of the visible
+ *         rectangle of the text, or `NSNotFound` if the view controller's
+ *         view is not loaded or contains no text view.
+ */
+static NSUInteger PLTabViewControllerGetScrollAnchor(NSViewController * viewController)
+{
+        NSTextView * textView = nil;
+        NSLayoutManager * layoutManager = nil;
+        NSRect visibleRect = NSZeroRect;
+        NSPoint anchorPoint = NSZeroPoint;
+        NSUInteger anchor = NSNotFound, glyphIndex = 0;
+
+        if ([viewController isViewLoaded] == NO) {
+                goto exit;
+        }
+        textView = PLTabViewControllerTextView([viewController view]);
+        if (textView == nil || [[textView string] length] == 0) {
+                goto exit;
+        }
+        layoutManager = [textView layoutManager];
+        visibleRect = [textView visibleRect];
+        anchorPoint = NSMakePoint(NSMinX(visibleRect) - [textView textContainerOrigin].x,
+                                  NSMinY(visibleRect) - [textView textContainerOrigin].y);
+        glyphIndex = [layoutManager glyphIndexForPoint:anchorPoint inTextContainer:[textView textContainer]];
+        anchor = [layoutManager characterIndexForGlyphAtIndex:glyphIndex];
+
+exit:
+        return anchor;
+}
 
 /**
- * \brief The key used in the `NSTrackingArea` `userData` dictionary that maps
- *        to the associated tab item.
+ * \brief Scroll the text of a tab so that a character is at the top of the
+ *        visible rectangle.
+ *
+ * \details Only lays out the text up to the anchor, so the rest of the text
+ *          of a background tab is laid out when it is next displayed.
+ *
+ * \param viewController The view controller of the tab.
+ *
+ * \param anchor The index of the character, or `NSNotFound` to leave the
+ *               text unchanged.
  */
-NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
+static void PLTabViewControllerSetScrollAnchor(NSViewController * viewController, NSUInteger anchor)
+{
+        NSTextView * textView = nil;
+        NSScrollView * scrollView = nil;
+        NSLayoutManager * layoutManager = nil;
+        NSRange glyphRange = NSMakeRange(0, 0);
+        NSRect lineRect = NSZeroRect;
+        NSUInteger length = 0;
+
+        if (anchor == NSNotFound) {
+                goto exit;
+        }
+        textView = PLTabViewControllerTextView([viewController view]);
+        length = [[textView string] length];
+        if (textView == nil || length == 0) {
+                goto exit;
+        }
+        layoutManager = [textView layoutManager];
+        glyphRange = [layoutManager glyphRangeForCharacterRange:NSMakeRange(MIN(anchor, length - 1), 1)
+                                           actualCharacterRange:NULL];
+        lineRect = [layoutManager lineFragmentRectForGlyphAtIndex:glyphRange.location effectiveRange:NULL];
+        scrollView = [textView enclosingScrollView];
+        [[scrollView contentView] scrollToPoint:NSMakePoint([[scrollView contentView] bounds].origin.x,
+                                                            NSMinY(lineRect) + [textView textContainerOrigin].y)];
+        [scrollView reflectScrolledClipView:[scrollView contentView]];
+
+exit:
+        return;
+}
 
 @implementation PLTabViewController
 
@@ -55,6 +275,25 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
         self = [super initWithNibName:nibNameOrNil bundle:nibBundleOrNil];
         if (self) {
                 tabBar = [[PLTabBar alloc] init];
+                tabBarLayout = [[PLTabBarLayout alloc] init];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(tabBarDidChange:)
+                                                             name:PLTabBarDidChangeNotification
+                                                           object:tabBar];
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(placeholderDidFinishLoading:)
+                                                             name:PLTabPlaceholderDidFinishLoadingNotification
+                                                           object:nil];
+                recentTabItems = [[NSMutableArray alloc] init];
+                staleThemeTabItems = [[NSMutableSet alloc] init];
+                staleFontTabItems = [[NSMutableArray alloc] init];
+                editJournals = [[NSMutableDictionary alloc] init];
+                syntaxHighlighters = [[NSMutableDictionary alloc] init];
+                pendingSelectedLines = [[NSMutableDictionary alloc] init];
+                fileEncodings = [[NSMutableDictionary alloc] init];
+                fileLineEndings = [[NSMutableDictionary alloc] init];
+                editGenerations = [[NSMapTable mapTableWithKeyOptions:(NSMapTableStrongMemory | NSMapTableObjectPointerPersonality)
+                                                         valueOptions:NSMapTableStrongMemory] retain];
                 activeTabColor = [[NSColor whiteColor] retain];
                 activeTabSubview = nil;
                 [tabBarView setPostsFrameChangedNotifications:YES];
@@ -90,6 +329,11 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
         addSubviewPopUp = [self createPopUpButton];
         [addSubviewButton setFrame:buttonFrame];
         [addSubviewPopUp setFrame:popUpFrame];
+        tabBarTrackingArea = [[NSTrackingArea alloc] initWithRect:NSZeroRect
+                                                          options:NSTrackingMouseMoved | NSTrackingMouseEnteredAndExited | NSTrackingActiveAlways | NSTrackingInVisibleRect
+                                                            owner:self
+                                                         userInfo:nil];
+        [tabBarView addTrackingArea:tabBarTrackingArea];
         [[tabBarView layer] addSublayer:tabBarBackgroundLayer];
         [tabBarView addSubview:addSubviewButton];
         [tabBarView addSubview:addSubviewPopUp];
@@ -105,10 +349,30 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
         [activeTabSubview removeFromSuperview];
         [activeTabSubview release];
 
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
+        for (PLTabBarItemLayer * item in tabBar) {
+                [[PLTabRegistry sharedRegistry] removeTabItem:item];
                 [item removeFromSuperlayer];
         }
         [tabBar release];
+        [tabBarLayout release];
+        [tabBarView removeTrackingArea:tabBarTrackingArea];
+        [tabBarTrackingArea release];
+        [recentTabItems release];
+        [staleThemeTabItems release];
+        [staleFontTabItems release];
+        for (PLEditJournal * journal in [editJournals objectEnumerator]) {
+                [journal discard];
+        }
+        [editJournals release];
+        for (PLSyntaxHighlighter * highlighter in [syntaxHighlighters objectEnumerator]) {
+                [highlighter detach];
+        }
+        [syntaxHighlighters release];
+        [pendingSelectedLines release];
+        [fileEncodings release];
+        [fileLineEndings release];
+        [editGenerations release];
+        [tabSubviewFont release];
         [activeTabColor release];
         [tabBarBackgroundLayer removeFromSuperlayer];
         [tabBarBackgroundLayer release];
@@ -119,16 +383,111 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
 
 #pragma mark - Theme Manager Methods
 
+/**
+ * \brief Update the font of the view controllers of the tabs.
+ *
+ * \details Only the active tab is visible, so it is updated right away. The
+ *          other loaded tabs are queued in `staleFontTabItems`, most recently
+ *          active first, and updated one per pass of the run loop so that
+ *          events are handled in between. A queued tab that becomes active is
+ *          updated at once. Unloaded tabs get the font when they are loaded.
+ *
+ *          Each tab keeps the character at the top of its visible text in view
+ *          across the change.
+ *
+ *          If the `PLUserDefaultLogPerformance` user default is YES, the time
+ *          taken to update the active tab and all tabs is logged.
+ *
+ * \param font The new font.
+ */
 -(void)updateFont:(NSFont *)font
 {
         NSViewController <PLTabSubviewController> * viewController = nil;
-        
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
+
+        [font retain];
+        [tabSubviewFont release];
+        tabSubviewFont = font;
+        fontChangeStartTime = CFAbsoluteTimeGetCurrent();
+        fontChangeTabCount = 0;
+        [staleFontTabItems removeAllObjects];
+        if (tabBar.activeTab) {
+                [self updateFontOfTabItem:tabBar.activeTab];
+        }
+        for (PLTabBarItemLayer * item in [recentTabItems reverseObjectEnumerator]) {
                 viewController = [tabBar viewControllerForTabItem:item];
-                if ([viewController respondsToSelector:@selector(updateFont:)]) {
-                        [viewController updateFont:font];
+                if (item != tabBar.activeTab &&
+                    [viewController isKindOfClass:[PLTabPlaceholderViewController class]] == NO &&
+                    [viewController respondsToSelector:@selector(updateFont:)]) {
+                        [staleFontTabItems addObject:item];
                 }
         }
+        for (PLTabBarItemLayer * item in tabBar) {
+                viewController = [tabBar viewControllerForTabItem:item];
+                if (item != tabBar.activeTab &&
+                    [recentTabItems containsObject:item] == NO &&
+                    [viewController isKindOfClass:[PLTabPlaceholderViewController class]] == NO &&
+                    [viewController respondsToSelector:@selector(updateFont:)]) {
+                        [staleFontTabItems addObject:item];
+                }
+        }
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Font changed to %@ %.1f: active tab updated in %.2f ms, %lu background tabs queued",
+                      [font fontName],
+                      [font pointSize],
+                      (CFAbsoluteTimeGetCurrent() - fontChangeStartTime) * 1000.0,
+                      (unsigned long)[staleFontTabItems count]);
+        }
+        [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                                 selector:@selector(updateFontOfNextStaleTab)
+                                                   object:nil];
+        if ([staleFontTabItems count] > 0) {
+                [self performSelector:@selector(updateFontOfNextStaleTab) withObject:nil afterDelay:0.0];
+        }
+}
+
+/**
+ * \brief Apply `tabSubviewFont` to the view controller of a tab, keeping the
+ *        same text in view.
+ *
+ * \param tabItem The tab item.
+ */
+-(void)updateFontOfTabItem:(PLTabBarItemLayer *)tabItem
+{
+        NSViewController <PLTabSubviewController> * viewController = [tabBar viewControllerForTabItem:tabItem];
+        NSUInteger anchor = NSNotFound;
+
+        [staleFontTabItems removeObject:tabItem];
+        if (tabSubviewFont == nil || [viewController respondsToSelector:@selector(updateFont:)] == NO) {
+                goto exit;
+        }
+        anchor = PLTabViewControllerGetScrollAnchor(viewController);
+        [viewController updateFont:tabSubviewFont];
+        PLTabViewControllerSetScrollAnchor(viewController, anchor);
+        fontChangeTabCount++;
+
+exit:
+        return;
+}
+
+/**
+ * \brief Update the first tab of `staleFontTabItems` and schedule the next.
+ */
+-(void)updateFontOfNextStaleTab
+{
+        if ([staleFontTabItems count] == 0) {
+                goto exit;
+        }
+        [self updateFontOfTabItem:[staleFontTabItems objectAtIndex:0]];
+        if ([staleFontTabItems count] > 0) {
+                [self performSelector:@selector(updateFontOfNextStaleTab) withObject:nil afterDelay:0.0];
+        } else if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                NSLog(@"Font applied to %lu tabs in %.2f ms",
+                      (unsigned long)fontChangeTabCount,
+                      (CFAbsoluteTimeGetCurrent() - fontChangeStartTime) * 1000.0);
+        }
+
+exit:
+        return;
 }
 
 /**
@@ -141,20 +500,30 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
  *          tab subviews that are loaded must be view extensions, conforming to
  *          the `PLAddOnViewExtension` protocol.
  *
+ *          Only the active tab subview is visible, so only its controller is
+ *          updated right away. The other loaded tabs are marked in
+ *          `staleThemeTabItems` and updated when they become active. Unloaded
+ *          tabs are updated when they are loaded.
+ *
  * \see PLAddOnExtension
  */
 -(void)updateThemeManager
 {
         NSViewController <PLTabSubviewController> * viewController = nil;
-        NSColor * backgroundColor = [[PLThemeManager defaultThemeManager] getThemeProperty:PLThemeManagerBackground
-                                                                                 fromGroup:PLThemeManagerSettings];
+        NSColor * backgroundColor = [[PLThemeTable sharedThemeTable] color:PLThemeColorBackground];
+
         [activeTabColor release];
         activeTabColor = [backgroundColor retain];
         [self updateTabColors];
         [tabSubview setBackgroundColor:backgroundColor];
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
+        for (PLTabBarItemLayer * item in tabBar) {
                 viewController = [tabBar viewControllerForTabItem:item];
-                [viewController updateThemeManager];
+                if (item == tabBar.activeTab) {
+                        [viewController updateThemeManager];
+                        [staleThemeTabItems removeObject:item];
+                } else if ([viewController isKindOfClass:[PLTabPlaceholderViewController class]] == NO) {
+                        [staleThemeTabItems addObject:item];
+                }
         }
 }
 
@@ -166,7 +535,7 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
  */
 -(void)updateTabColors
 {
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
+        for (PLTabBarItemLayer * item in tabBar) {
                 if (item == tabBar.activeTab) {
                         item.color = [activeTabColor CGColor];
                 } else {
@@ -180,9 +549,9 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
 /**
  * \brief Notification method when the tab bar's frame changes.
  *
- * \details Update its background layer's frame and recalculate all tab view
- *          item frames when it's `tabBarView` whose frame changes, not its
- *          subviews.
+ * \details Update its background layer's frame and reposition the tab items
+ *          whose frames changed when it's `tabBarView` whose frame changes, not
+ *          its subviews.
  *
  * \param notification The `NSViewFrameDidChangeNotification` object.
  */
@@ -193,81 +562,76 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
                 [CATransaction setDisableActions:YES];
                 tabBarBackgroundLayer.frame = [tabBarView bounds];
                 [CATransaction commit];
-                [self positionTabBarItemsWithAnimation:NO];
+                [self positionTabBarItemsFromIndex:[tabBar countOfTabItems] animate:NO];
         }
 }
 
 /**
- * \brief Method to update the tab layout.
+ * \brief Notification method when tabs are added to, removed from, or moved
+ *        in the tab bar.
  *
- * \details This method is used to calculate the layout for the tabs that are
- *          displayed in the tab bar. Tabs are placed slightly offset from the
- *          left edge and overlapping previous tabs.
+ * \details Reposition the tab items whose index changed, once for each batch
+ *          of changes. While a tab is dragged, the tabs it displaces are
+ *          animated into place and the dragged tab is left under the mouse;
+ *          the tabs are reported as changed when the drag ends.
  *
- * \return An array of `NSValue`-wrapped `NSRect` representing the frame of each
- *         tab item in the order they appear in the tab bar.
+ * \param notification The `PLTabBarDidChangeNotification` object.
  */
--(NSArray *)calculateTabViewItems
-{
-        NSMutableArray * itemFrames = nil;
-        NSSize tabSize;
-        NSRect tabRect, barRect;
-        CGFloat space = 0.0f;
-        __block NSPoint location;
-
-        barRect = NSMakeRect(0.0f, 0.0f, [tabBarView frame].size.width, [tabBarView frame].size.height);
-        tabSize = NSMakeSize(PLTabItemMaxWidth, barRect.size.height - 3.0f);
-        space = (barRect.size.width - [tabBarView frame].size.height) / [tabBar numberOfTabs];
-        if (isnan(space) == NO)
-                tabSize.width = MIN(tabSize.width, space);
-        
-        /* Calculate the frames of all tab items.
-         * The starting location is offset from the left edge.
-         */
-        location = NSMakePoint(barRect.origin.x + 1.0f, barRect.origin.y);
-        itemFrames = [NSMutableArray array];
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
-                tabRect = NSMakeRect(floorf(location.x),
-                                     floorf(location.y),
-                                     floorf(tabSize.width),
-                                     floorf(tabSize.height));
-                location.x += tabSize.width - 13.0f;  // overlap previous tab
-                [itemFrames addObject:[NSValue valueWithRect:tabRect]];
-        }
-        return [NSArray arrayWithArray:itemFrames];
+-(void)tabBarDidChange:(NSNotification *)notification
+{
+        PLTabBarChangeSet * changeSet = [[notification userInfo] objectForKey:PLTabBarChangeSetKey];
+
+        [self positionTabBarItemsInRange:changeSet.changedRange
+                           excludingItem:draggedTabItem
+                                 animate:(draggedTabItem != nil)];
+        if (draggedTabItem == nil) {
+                [self tabsDidChange];
+        }
 }
 
 /**
- * \brief Convenience method to update the position of all tab items.
+ * \brief Update the position of the tab items in a range of indexes.
  *
- * \details This method adds a tracking area for the positioned tab and removes
- *          its old one. Finally, it updates the close button visibility of all
- *          tabs by determining the mouse location when this method was called.
- *          This allows for correct close button visibility if the mouse is
- *          stationary inside the tab bar and a new tab item appears at its
- *          location.
+ * \details This method lays out `tabBarLayout` for the current tabs first. If
+ *          that changed the frames of tabs before `range`, such as when the tab
+ *          width changed, all tabs from the first changed one are positioned
+ *          as well. Tab items whose size changed lay out their sublayers right
+ *          away. Finally, it updates the close button visibility by determining
+ *          the mouse location when this method was called. This allows for
+ *          correct close button visibility if the mouse is stationary inside
+ *          the tab bar and a new tab item appears at its location.
  *
- * \param item The tab item to position.
+ *          If the `PLUserDefaultLogPerformance` user default is YES, the
+ *          pass is committed to Core Animation right away and its cost is
+ *          logged, including the tab chrome drawn by the tab items.
  *
- * \param itemFrames An array of `NSValue`-wrapped `NSRect`s specifying the
- *                   frame of each tab item in the same order as those in
- *                   `tabBarArray`. Same as the array returned by
- *                   `calculateTabViewItems`.
+ * \param range The range of indexes of the tab items to position.
  *
- * \param animate YES if positioning the items should be animated.
+ * \param excludedItem A tab item to leave where it is, or nil.
  *
- * \see calculateTabViewItems
+ * \param animate YES if positioning the items should be animated.
  */
--(void)positionTabBarItem:(PLTabBarItemLayer *)item withItemFrames:(NSArray *)itemFrames animate:(BOOL)animate
+-(void)positionTabBarItemsInRange:(NSRange)range excludingItem:(PLTabBarItemLayer *)excludedItem animate:(BOOL)animate
 {
-        NSTrackingArea * trackingArea = nil;
-        NSUInteger itemIndex = NSNotFound;
+        PLTabBarItemLayer * item = nil;
+        NSUInteger numberOfTabs = 0, firstChangedIndex = NSNotFound, index = 0, positionedCount = 0;
+        NSRect itemFrame = NSZeroRect;
+        BOOL resized = NO, logRendering = NO;
         NSPoint locationInWindow = NSZeroPoint, locationInView = NSZeroPoint;
+        CFTimeInterval startTime = 0.0;
+        PLTabBarRenderStatistics statistics = {0, 0, 0, 0.0};
+
+        logRendering = [[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance];
+        if (logRendering) {
+                [PLTabBarItemLayer resetRenderStatistics];
+                startTime = CACurrentMediaTime();
+        }
+        numberOfTabs = [tabBar countOfTabItems];
+        firstChangedIndex = [tabBarLayout layoutTabCount:numberOfTabs inBarOfSize:[tabBarView frame].size];
+        if (firstChangedIndex < numberOfTabs) {
+                range = NSUnionRange(range, NSMakeRange(firstChangedIndex, numberOfTabs - firstChangedIndex));
+        }
 
-        itemIndex = [tabBar indexOfTabItem:item];
-        if (itemIndex == NSNotFound)
-                goto exit;
-        
         [CATransaction begin];
         if (animate) {
                 [CATransaction setAnimationDuration:0.2];
@@ -275,70 +639,87 @@ NSString * const PLTabTrackingAreaTabItemKey = @"PLTabTrackingAreaTabItemKey";
         } else {
                 [CATransaction setDisableActions:YES];
         }
-        [item setFrame:[[itemFrames objectAtIndex:itemIndex] rectValue]];
+        for (index = range.location; index < NSMaxRange(range) && index < numberOfTabs; index++) {
+                item = [tabBar objectInTabItemsAtIndex:index];
+                itemFrame = [tabBarLayout frameAtIndex:index];
+                if (item != excludedItem && NSEqualRects(itemFrame, [item frame]) == NO) {
+                        resized = (NSEqualSizes(itemFrame.size, [item frame].size) == NO);
+                        [item setFrame:itemFrame];
+                        positionedCount++;
+                        
+                        /* Lay out the sublayers of resized items now so their
+                         * masked area is current for hit testing below.
+                         */
+                        if (resized) {
+                                [item layoutSublayers];
+                        }
+                }
+        }
         [CATransaction commit];
-        
-        /* Configure tracking area */
-        trackingArea = [[NSTrackingArea alloc] initWithRect:[[itemFrames objectAtIndex:itemIndex] rectValue]
-                                                    options:NSTrackingMouseMoved | NSTrackingMouseEnteredAndExited | NSTrackingActiveAlways
-                                                      owner:self
-                                                   userInfo:@{PLTabTrackingAreaTabItemKey: item}];
-        [tabBarView removeTrackingArea:[tabBar trackingAreaForTabItem:item]];
-        [tabBarView addTrackingArea:trackingArea];
-        [tabBar setTrackingArea:trackingArea forTabItem:item];
-        [trackingArea release];
-
-        /* Set close button visibility.
-         * Ensure that the item has laid out its sublayers first. Without this,
-         * closing a tab with the mouse over the tab bar will not cause the new
-         * tab under the mouse to have its close button visible.
-         */
+
+        /* Set close button visibility */
         locationInWindow = [[tabBarView window] convertRectFromScreen:NSMakeRect([NSEvent mouseLocation].x, [NSEvent mouseLocation].y, 0, 0)].origin;
         locationInView = [tabBarView convertPoint:locationInWindow fromView:nil];
-        [item layoutSublayers];
         [self updateTabCloseButtonWithPoint:locationInView];
-        
-exit:
-        return;
+
+        if (logRendering) {
+                [CATransaction flush];
+                statistics = [PLTabBarItemLayer renderStatistics];
+                NSLog(@"Tab bar: positioned %lu of %lu tabs in %.2f ms; drew %lu tab images in %.2f ms, reused %lu, created %lu paths.",
+                      (unsigned long)positionedCount,
+                      (unsigned long)numberOfTabs,
+                      (CACurrentMediaTime() - startTime) * 1000.0,
+                      (unsigned long)statistics.imagesRendered,
+                      statistics.renderTime * 1000.0,
+                      (unsigned long)statistics.imagesReused,
+                      (unsigned long)statistics.pathsCreated);
+        }
 }
 
 /**
- * \brief Convenience method to update the position of one tab item.
+ * \brief Convenience method to update the position of the tab items from an
+ *        index onwards.
+ *
+ * \details Tab items before `index` are positioned too if their frames
+ *          changed, so passing the number of tabs positions only the items
+ *          whose frames changed.
  *
- * \details This method calls `calculateTabViewItems` and sets the frame of
- *          all tab items in `tabBarArray`.
+ * \param index The index of the first tab item to position.
  *
  * \param animate YES if positioning the items should be animated.
  *
- * \see calculateTabViewItems
+ * \see positionTabBarItemsInRange:excludingItem:animate:
  */
--(void)positionTabBarItemsWithAnimation:(BOOL)animate
+-(void)positionTabBarItemsFromIndex:(NSUInteger)index animate:(BOOL)animate
 {
-        NSArray * itemFrames = [self calculateTabViewItems];
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
-                [self positionTabBarItem:item
-                          withItemFrames:itemFrames
+        NSUInteger numberOfTabs = [tabBar countOfTabItems];
+
+        index = MIN(index, numberOfTabs);
+        [self positionTabBarItemsInRange:NSMakeRange(index, numberOfTabs - index)
+                           excludingItem:nil
                                  animate:animate];
-        }
 }
 
 /**
- * \brief Convenience method to update the tab layout of one tab item.
+ * \brief Convenience method to update the position of one tab item.
  *
- * \details This method will call `calculateTabViewItems` and use when sending
- *          the `positionTabBarItem:withItemFrames:animate` method.
+ * \details Does nothing if `item` is not in the tab bar.
  *
- * \param item The `PLTabBarItemView` to position.
+ * \param item The `PLTabBarItemLayer` to position.
  *
  * \param animate YES positioning the items should be animated.
  *
- * \see calculateTabViewItems
+ * \see positionTabBarItemsInRange:excludingItem:animate:
  */
 -(void)positionTabBarItem:(PLTabBarItemLayer *)item animate:(BOOL)animate
 {
-        [self positionTabBarItem:item
-                  withItemFrames:[self calculateTabViewItems]
-                         animate:animate];
+        NSUInteger index = [tabBar indexOfTabItem:item];
+
+        if (index != NSNotFound) {
+                [self positionTabBarItemsInRange:NSMakeRange(index, 1)
+                                   excludingItem:nil
+                                         animate:animate];
+        }
 }
 
 #pragma mark - Mouse Events
@@ -346,8 +727,10 @@ exit:
 /**
  * \brief Return the tab bar item at a point.
  *
- * \details If multiple tab bar items are overlapping at the point, return the
- *          frontmost one by sorting by the item's `zPosition`.
+ * \details Only the tab items whose frames in `tabBarLayout` span the point
+ *          are tested, which are found by binary search. If multiple tab bar
+ *          items are overlapping at the point, return the frontmost one by
+ *          comparing the items' `zPosition`.
  *
  * \param point An `NSPoint` in the coordinate system of `tabBarView`.
  *
@@ -356,24 +739,31 @@ exit:
  */
 -(PLTabBarItemLayer *)tabBarItemForPoint:(NSPoint)point
 {
-        NSArray * itemsWithPoint = nil, * sortDescriptors = nil;
+        PLTabBarItemLayer * item = nil, * frontmostItem = nil;
         NSPoint locationInLayer = NSZeroPoint;
+        NSRange candidates = NSMakeRange(0, 0);
+        NSUInteger index = 0;
         
         locationInLayer = [tabBarView convertPointToLayer:point];
-        itemsWithPoint = [tabBar.tabItems objectsAtIndexes:[tabBar.tabItems indexesOfObjectsPassingTest:^BOOL(PLTabBarItemLayer * item, NSUInteger idx, BOOL * stop) {
-                return [item containsPoint:[[tabBarView layer] convertPoint:locationInLayer toLayer:item]];
-        }]];
-
-        sortDescriptors = @[[NSSortDescriptor sortDescriptorWithKey:@"zPosition" ascending:YES]];
-        return [[itemsWithPoint sortedArrayUsingDescriptors:sortDescriptors] lastObject];
+        candidates = [tabBarLayout rangeOfTabsAtLocation:point.x];
+        for (index = candidates.location; index < NSMaxRange(candidates) && index < [tabBar countOfTabItems]; index++) {
+                item = [tabBar objectInTabItemsAtIndex:index];
+                if ((frontmostItem == nil || item.zPosition >= frontmostItem.zPosition) &&
+                    [item containsPoint:[[tabBarView layer] convertPoint:locationInLayer toLayer:item]]) {
+                        frontmostItem = item;
+                }
+        }
+        return frontmostItem;
 }
 
 /**
  * \brief Update the visibility of the close button for all tabs.
  *
  * \details The tab item that contains `point` will have its close button
- *          visible. All others will hide their close button. If `point` is also
- *          within the close button frame, the close button will be highlighted.
+ *          visible. Only `hoveredTabItem` can be showing its close button, so
+ *          it hides its close button if it is another tab item. If `point` is
+ *          also within the close button frame, the close button will be
+ *          highlighted.
  *
  * \param point An `NSPoint` in the coordinate system of `tabBarView`.
  */
@@ -384,13 +774,11 @@ exit:
 
         /* Update close button visibility */
         itemInPoint = [self tabBarItemForPoint:point];
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
-                if (item == itemInPoint) {
-                        item.closeButtonHidden = NO;
-                } else {
-                        item.closeButtonHidden= YES;
-                }
+        if (itemInPoint != hoveredTabItem) {
+                hoveredTabItem.closeButtonHidden = YES;
+                hoveredTabItem = itemInPoint;
         }
+        itemInPoint.closeButtonHidden = NO;
         
         /* Update close button highlighting */
         pointInLayer = [tabBarView convertPointToLayer:point];
@@ -454,18 +842,19 @@ exit:
  *          in the tab bar and place the `hiddenTabItem` there. To do so, this
  *          method first compares its new x-position to its initial x-position
  *          to determine which direction it moved, then:
- *              - If moving right, find the first tab after the dragging tab's
- *                original index (enumerating in reverse) where the dragging
- *                tab's midpoint has passed the tab's origin.
+ *              - If moving right, find the last tab after the dragging tab's
+ *                original index where the dragging tab's end has passed the
+ *                tab's midpoint.
  *              - If moving left, find the first tab before the dragging tab's
  *                original index where the dragging tab's origin has passed the
  *                tab's midpoint.
- *          A minor buffer region is added around the tab's midpoint so that
- *          hovering over the midpoint does not cause rapid tab switching.
- *          If the dragging tab has moved outside of its original position,
- *          reorder the `hiddenTabItem` in `tabBarArray` and use the
- *          `positionTabBarItem:animate:` method to refresh the tab positions.
- *          On mouse up, replace the `hiddenTabItem` with the tab being dragged.
+ *          Both are found by binary search in `tabBarLayout`. A minor buffer
+ *          region is added around the tab's midpoint so that hovering over the
+ *          midpoint does not cause rapid tab switching. If the dragging tab has
+ *          moved outside of its original position, reorder the `hiddenTabItem`
+ *          in `tabBarArray` and reposition the tabs between the old and new
+ *          index. On mouse up, replace the `hiddenTabItem` with the tab being
+ *          dragged.
  *
  * \param theEvent Object encapsulating information about the mouse dragged
  *                 event.
@@ -475,9 +864,8 @@ exit:
         BOOL shouldPerform = NO;
         NSPoint locationInView = NSZeroPoint;
         PLTabBarItemLayer * clickedItem = nil;
-        NSUInteger clickedItemIndex = 0;
-        CGFloat clickedItemOriginX = 0.0f;
-        __block NSUInteger clickedItemNewIndex = NSNotFound;
+        NSUInteger clickedItemIndex = 0, clickedItemNewIndex = NSNotFound, index = 0;
+        CGFloat clickedItemOriginX = 0.0f, tabWidth = 0.0f;
         
         /* Find clicked tab item */
         locationInView = [tabBarView convertPoint:[theEvent locationInWindow] fromView:nil];
@@ -488,6 +876,7 @@ exit:
         }
         clickedItemIndex = [tabBar indexOfTabItem:clickedItem];
         clickedItemOriginX = [clickedItem frame].origin.x;
+        draggedTabItem = clickedItem;
         
         /* Use mouse-tracking loop to drag clicked tab item until mouseUp */
         while ([theEvent type] != NSLeftMouseUp) {
@@ -501,43 +890,37 @@ exit:
                 [CATransaction commit];
                 
                 /* Determine where the dragging tab would be inserted */
+                tabWidth = [tabBarLayout tabWidth];
                 if ([clickedItem frame].origin.x > clickedItemOriginX) {
                         /* Moving right */
-                        [tabBar.tabItems enumerateObjectsWithOptions:NSEnumerationReverse usingBlock:^(PLTabBarItemLayer * item, NSUInteger idx, BOOL * stop) {
-                                if (idx <= clickedItemIndex) {
-                                        *stop = YES;
-                                } else if (NSMaxX([clickedItem frame]) > [item frame].origin.x + [item frame].size.width * 0.55) {
-                                        clickedItemNewIndex = idx;
-                                        *stop = YES;
-                                }
-                        }];
+                        index = [tabBarLayout indexOfFirstTabAfterLocation:NSMaxX([clickedItem frame]) - tabWidth * 0.55];
+                        if (index > clickedItemIndex + 1) {
+                                clickedItemNewIndex = index - 1;
+                        }
                 } else {
                         /* Moving left */
-                        [tabBar.tabItems enumerateObjectsUsingBlock:^(PLTabBarItemLayer * item, NSUInteger idx, BOOL * stop) {
-                                if (idx >= clickedItemIndex) {
-                                        *stop = YES;
-                                } else if (NSMinX([clickedItem frame]) < [item frame].origin.x + [item frame].size.width * 0.45) {
-                                        clickedItemNewIndex = idx;
-                                        *stop = YES;
-                                }
-                        }];
+                        index = [tabBarLayout indexOfFirstTabAfterLocation:NSMinX([clickedItem frame]) - tabWidth * 0.45];
+                        if (index < clickedItemIndex) {
+                                clickedItemNewIndex = index;
+                        }
                 }
                 
                 /* Reorder hidden tab if needed */
                 if (clickedItemNewIndex != NSNotFound) {
-                        /* Move replaced tab into position */
+                        /* Move replaced tabs into position */
                         [tabBar moveTabItem:clickedItem toIndex:clickedItemNewIndex];
-                        [self positionTabBarItem:[tabBar tabItemAtIndex:clickedItemIndex] animate:YES];
                         
                         /* Reset properties of the clicked tab to match that of the hidden tab */
-                        clickedItemOriginX = [[[self calculateTabViewItems] objectAtIndex:clickedItemNewIndex] rectValue].origin.x;
+                        clickedItemOriginX = [tabBarLayout frameAtIndex:clickedItemNewIndex].origin.x;
                         clickedItemIndex = clickedItemNewIndex;
                         clickedItemNewIndex = NSNotFound;
                 }
         }
         
         /* After mouse-up, insert the clicked tab */
+        draggedTabItem = nil;
         [self positionTabBarItem:clickedItem animate:YES];
+        [self tabsDidChange];
         
 exit:
         return shouldPerform;
@@ -547,13 +930,12 @@ exit:
  * \brief Ensure that the close button is visible in tab items containing the
  *        mouse.
  *
- * \details This method is called by the tracking areas that cover each tab
- *          item. It is used instead of `mouseEntered:` in order to respect the
+ * \details This method is called by the tracking area that covers the tab
+ *          bar. It is used instead of `mouseEntered:` in order to respect the
  *          non-rectangular masked area of the tab. This method will also hide
- *          the close button when the mouse exits through a masked edge, but
- *          remains in the tracking area. The `mouseExited:` method handles
- *          hiding the close button when the mouse exits through an unmasked
- *          edge (i.e. the bottom of the tab).
+ *          the close button when the mouse leaves a tab but remains in the
+ *          tab bar. The `mouseExited:` method handles hiding the close button
+ *          when the mouse leaves the tab bar.
  *
  * \param theEvent Object encapsulating information about the mouse moved event.
  *
@@ -595,16 +977,12 @@ exit:
 }
 
 /**
- * \brief Hide the close button when the mouse exits a tracking area.
- *
- * \details This method uses the sends the `userData` message to `theEvent` to
- *          determine the tab associated with the tracking area and sets its
- *          `closeButtonHidden` property to YES.
+ * \brief Hide the close button when the mouse exits the tab bar.
  *
- *          This method is used to hide the close button when the mouse exits
- *          through an unmasked edge of the tab. The `mouseMoved:` method will
- *          have already hidden the close button if the mouse exits through a
- *          masked edge.
+ * \details This method sets the `closeButtonHidden` property of
+ *          `hoveredTabItem` to YES. The `mouseMoved:` method will have already
+ *          hidden the close button if the mouse left the tab while still in the
+ *          tab bar.
  *
  * \param theEvent Object encapsulating information about the mouse exit event.
  *
@@ -614,12 +992,8 @@ exit:
  */
 -(void)mouseExited:(NSEvent *)theEvent
 {
-        NSDictionary * userData = nil;
-        PLTabBarItemLayer * item = nil;
-
-        userData = [theEvent userData];
-        item = [userData objectForKey:PLTabTrackingAreaTabItemKey];
-        item.closeButtonHidden = YES;
+        hoveredTabItem.closeButtonHidden = YES;
+        hoveredTabItem = nil;
 }
 
 #pragma mark - Button Creation and Actions
@@ -722,6 +1096,16 @@ bail:
 
 #pragma mark - Notifications
 
+/**
+ * \brief Update the window after the saved state of the active tab's document
+ *        changed.
+ *
+ * \details A document that became saved may have been saved by its add on,
+ *          replacing its file, so the tab is registered again as well.
+ *
+ * \param aNotification The `PLTabSubviewDocumentChangedSavedSateNotification`,
+ *                      or nil.
+ */
 -(void)documentSavedStateChanged:(NSNotification *)aNotification
 {
         BOOL isUnsaved = NO;
@@ -731,6 +1115,9 @@ bail:
         document = [tabSubviewController document];
         isUnsaved = [[PLDocumentManager sharedDocumentManager] documentIsEdited:document];
         [[[self view] window] setDocumentEdited:isUnsaved];
+        if (aNotification && isUnsaved == NO && tabBar.activeTab) {
+                [self registerTabItem:tabBar.activeTab];
+        }
 }
 
 /**
@@ -747,6 +1134,7 @@ bail:
 {
         PLAddOnManager * manager = [PLAddOnManager defaultManager];
         Class <PLAddOnExtension> aClass;
+        [[PLAddOnLoader sharedLoader] loadDeferredAddOns];
         [addSubviewPopUp removeAllItems];
         [addSubviewPopUp addItemWithTitle:@""];
         for (NSBundle * viewExtension in [manager extensionBundles]) {
@@ -766,17 +1154,68 @@ bail:
 {
         NSViewController * subviewController = [aNotification object];
         
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
+        for (PLTabBarItemLayer * item in tabBar) {
                 if ([tabBar viewControllerForTabItem:item] == subviewController) {
                         item.title = [subviewController title];
+                        [self registerTabItem:item];
                         if (item == tabBar.activeTab) {
                                 [self updateWindowTitle];
                         }
+                        [self tabsDidChange];
                         break;
                 }
         }
 }
 
+/**
+ * \brief Respond to a placeholder of this tab view finishing loading its
+ *        document.
+ *
+ * \details A tab whose document could not be loaded is removed. Otherwise, if
+ *          the tab is active, or there is no active tab, the add on's view
+ *          controller replaces the placeholder.
+ *
+ * \param notification The `PLTabPlaceholderDidFinishLoadingNotification`.
+ */
+-(void)placeholderDidFinishLoading:(NSNotification *)notification
+{
+        PLTabPlaceholderViewController * placeholder = [[[notification object] retain] autorelease];
+        PLTabBarItemLayer * tabItem = [self tabItemForViewController:placeholder];
+
+        if (tabItem == nil) {
+                goto exit;
+        }
+        if (placeholder.loadingError) {
+                [self removeTabItem:tabItem withLoadingErrorOfPlaceholder:placeholder];
+        } else if (tabItem == tabBar.activeTab || tabBar.activeTab == nil) {
+                [self setActiveTab:tabItem];
+        } else if ([[PLEditJournalManager sharedJournalManager] hasJournalForFileURL:placeholder.fileURL]) {
+                [self loadTabItem:tabItem];
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Remove a tab whose document could not be loaded.
+ *
+ * \details The loading error is presented if the placeholder presents it.
+ *
+ * \param tabItem The tab item.
+ *
+ * \param placeholder The placeholder of the tab, which has a `loadingError`.
+ */
+-(void)removeTabItem:(PLTabBarItemLayer *)tabItem withLoadingErrorOfPlaceholder:(PLTabPlaceholderViewController *)placeholder
+{
+        [[placeholder retain] autorelease];
+        NSLog(@"Error: the document at %@ could not be loaded.", [placeholder.fileURL path]);
+        [self removeTab:tabItem];
+        if (placeholder.presentsLoadingError) {
+                [[self view] presentError:placeholder.loadingError];
+        }
+}
+
 -(void)activeSubviewChangedSavedState:(NSNotification *)aNotification
 {
         BOOL isUnsaved = NO;
@@ -789,7 +1228,7 @@ bail:
 
 -(NSUInteger)numberOfTabs
 {
-        return [tabBar numberOfTabs];
+        return [tabBar countOfTabItems];
 }
 
 -(void)addDefaultTab
@@ -806,77 +1245,587 @@ bail:
 
 -(void)addTabWithAddOn:(NSBundle *)addOn withDocument:(id)aDocument
 {
-        NSViewController <PLAddOnExtension> * viewController = nil;
-        PLTabBarItemLayer * item = nil;
-        CABasicAnimation * tabAnimation = nil;
-        Class controllerClass = Nil;
+        [self addTabWithAddOn:addOn withDocument:aDocument activate:YES];
+}
 
-        /* Add the subview controller */
-        controllerClass = [addOn principalClass];
-        if ([controllerClass conformsToProtocol:@protocol(PLAddOnExtension)] == NO) {
+-(void)addTabWithAddOn:(NSBundle *)addOn withDocument:(id)aDocument activate:(BOOL)activate
+{
+        if ([[addOn principalClass] conformsToProtocol:@protocol(PLAddOnExtension)] == NO) {
                 NSLog(@"Error: view controller must conform to the PLAddOnExtension protocol.");
                 /* Error Report Here */
                 goto exit;
         }
-        if (aDocument)
-                viewController = [controllerClass viewControllerWithDocument:aDocument];
-        else
-                viewController = [controllerClass viewController];
-        [viewController updateThemeManager];
-        [[NSNotificationCenter defaultCenter] addObserver:self
-                                                 selector:@selector(updateTitle:)
-                                                     name:PLTabSubviewTitleDidChangeNotification
-                                                   object:viewController];
-
-        /* Add the tab item */
-        item = [PLTabBarItemLayer layer];
-        item.title = [viewController title];
-        [tabBar addTabItem:item withViewController:viewController];
-        [[tabBarView layer] addSublayer:item];
-        [self positionTabBarItemsWithAnimation:NO];
-        [self setActiveTab:item];
-        
-        /* Animate the tab into the tab bar if it's not the first one */
-        if ([tabBar numberOfTabs] > 1) {
-                tabAnimation = [CABasicAnimation animationWithKeyPath:@"transform.translation"];
-                tabAnimation.duration = 0.15f;
-                tabAnimation.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
-                tabAnimation.fromValue = [NSValue valueWithPoint:NSMakePoint(item.bounds.origin.x, item.bounds.origin.y - item.bounds.size.height)];
-                tabAnimation.toValue = [NSValue valueWithPoint:item.bounds.origin];
-                [item addAnimation:tabAnimation forKey:@"translation"];
-        }
+        [self addTabWithViewController:[PLTabPlaceholderViewController placeholderWithAddOn:addOn document:aDocument]
+                              activate:activate];
 
 exit:
         return;
 }
 
-/**
- * \brief Remove a tab and its subview controller.
- *
- * \details Sets the active tab to the next tab in the bar unless it's already
- *          at the end, in which case the previous tab becomes the active tab.
- *          Sets the active tab to nil if it was the last tab. Removes the tab
- *          item, its tracking area, and the subview controller. If `tabItem` is
- *          does not exist in the tab bar, do nothing.
- *
- * \param tabItem The tab item to be removed.
- */
--(void)removeTab:(PLTabBarItemLayer *)tabItem
+-(BOOL)addTabWithAddOn:(NSBundle *)addOn fileURL:(NSURL *)fileURL activate:(BOOL)activate
 {
-        NSViewController <PLTabSubviewController> * subviewController = nil;
-        
-        subviewController = [tabBar viewControllerForTabItem:tabItem];
-        if (subviewController == nil) {
+        PLTabPlaceholderViewController * placeholder = nil;
+        BOOL added = NO;
+
+        if ([[addOn principalClass] conformsToProtocol:@protocol(PLAddOnExtension)] == NO) {
+                NSLog(@"Error: view controller must conform to the PLAddOnExtension protocol.");
                 goto exit;
         }
-        [[NSNotificationCenter defaultCenter] removeObserver:self
-                                                        name:PLTabSubviewTitleDidChangeNotification
-                                                      object:subviewController];
+        placeholder = [PLTabPlaceholderViewController placeholderWithAddOn:addOn fileURL:fileURL];
+        placeholder.presentsLoadingError = YES;
+        [placeholder loadDocumentInBackground];
+        [self addTabWithViewController:placeholder activate:activate];
+        added = YES;
 
-        if (tabItem == tabBar.activeTab) {
-                if ([tabBar numberOfTabs] == 1) {
+exit:
+        return added;
+}
+
+-(void)addTabWithRecoveredJournal:(PLEditJournal *)journal
+{
+        NSBundle * addOn = [[PLAddOnManager defaultManager] defaultAddOnBundle];
+        PLTabPlaceholderViewController * placeholder = nil;
+        PLTabBarItemLayer * tabItem = nil;
+
+        if (addOn == nil) {
+                [journal discard];
+                goto exit;
+        }
+        placeholder = [PLTabPlaceholderViewController placeholderWithAddOn:addOn document:nil];
+        placeholder.editJournal = journal;
+        [self addTabWithViewController:placeholder activate:NO];
+        tabItem = [self tabItemForViewController:placeholder];
+        if (tabItem) {
+                [self loadTabItem:tabItem];
+        }
+
+exit:
+        return;
+}
+
+-(void)addTabWithViewController:(NSViewController <PLTabSubviewController> *)viewController
+{
+        [self addTabWithViewController:viewController activate:YES];
+}
+
+-(void)addTabWithViewController:(NSViewController <PLTabSubviewController> *)viewController activate:(BOOL)activate
+{
+        PLTabBarItemLayer * item = nil;
+        CABasicAnimation * tabAnimation = nil;
+
+        item = [self insertTabItemWithViewController:viewController];
+        if (activate || tabBar.activeTab == nil) {
+                [self setActiveTab:item];
+        } else {
+                [self updateTabColors];
+        }
+        
+        /* Animate the tab into the tab bar if it's not the first one */
+        if ([tabBar countOfTabItems] > 1) {
+                tabAnimation = [CABasicAnimation animationWithKeyPath:@"transform.translation"];
+                tabAnimation.duration = 0.15f;
+                tabAnimation.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
+                tabAnimation.fromValue = [NSValue valueWithPoint:NSMakePoint(item.bounds.origin.x, item.bounds.origin.y - item.bounds.size.height)];
+                tabAnimation.toValue = [NSValue valueWithPoint:item.bounds.origin];
+                [item addAnimation:tabAnimation forKey:@"translation"];
+        }
+}
+
+/**
+ * \brief Add a tab item for a view controller at the end of the tab bar,
+ *        without positioning or activating it.
+ *
+ * \param viewController The view controller of the tab.
+ *
+ * \return The new tab item.
+ */
+-(PLTabBarItemLayer *)insertTabItemWithViewController:(NSViewController <PLTabSubviewController> *)viewController
+{
+        PLTabBarItemLayer * item = [PLTabBarItemLayer layer];
+
+        [self prepareTabSubviewController:viewController];
+        item.title = [viewController title];
+        [[tabBarView layer] addSublayer:item];
+        [tabBar addTabItem:item withViewController:viewController];
+        [self registerTabItem:item];
+        return item;
+}
+
+/**
+ * \brief Register a tab in the shared `PLTabRegistry` under the URL of its
+ *        document.
+ *
+ * \details Called when the tab is added and whenever its title changes, which
+ *          is when the URL of its document may have changed.
+ *
+ * \param tabItem The tab item.
+ */
+-(void)registerTabItem:(PLTabBarItemLayer *)tabItem
+{
+        [[PLTabRegistry sharedRegistry] setFileURL:[self fileURLForTabItem:tabItem]
+                                        forTabItem:tabItem
+                               inTabViewController:self];
+}
+
+/**
+ * \brief Post a `PLTabViewControllerTabsDidChangeNotification`.
+ */
+-(void)tabsDidChange
+{
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLTabViewControllerTabsDidChangeNotification
+                                                            object:self];
+}
+
+/**
+ * \brief Set up a view controller that was just added to the tab bar.
+ *
+ * \details Apply the theme and font, and observe the view controller's title.
+ *
+ * \param viewController The view controller.
+ */
+-(void)prepareTabSubviewController:(NSViewController <PLTabSubviewController> *)viewController
+{
+        [viewController updateThemeManager];
+        if (tabSubviewFont && [viewController respondsToSelector:@selector(updateFont:)]) {
+                [viewController updateFont:tabSubviewFont];
+        }
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(updateTitle:)
+                                                     name:PLTabSubviewTitleDidChangeNotification
+                                                   object:viewController];
+}
+
+/**
+ * \brief Replace the placeholder of a tab with its add on's view controller.
+ *
+ * \details If the document of the tab could not be opened, the tab is
+ *          removed.
+ *
+ * \param tabItem The tab item whose view controller is a placeholder.
+ *
+ * \return The add on's view controller, or nil if it could not be created.
+ */
+-(NSViewController <PLTabSubviewController> *)loadTabItem:(PLTabBarItemLayer *)tabItem
+{
+        PLTabPlaceholderViewController * placeholder = (PLTabPlaceholderViewController *)[tabBar viewControllerForTabItem:tabItem];
+        NSViewController <PLAddOnExtension> * viewController = nil;
+
+        viewController = [placeholder createViewController];
+        if (viewController == nil) {
+                if (placeholder.loadingError) {
+                        [self removeTabItem:tabItem withLoadingErrorOfPlaceholder:placeholder];
+                }
+                goto exit;
+        }
+        [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                        name:PLTabSubviewTitleDidChangeNotification
+                                                      object:placeholder];
+        [tabBar setViewController:viewController forTabItem:tabItem];
+        [self prepareTabSubviewController:viewController];
+        tabItem.title = [viewController title];
+        [self installTextStorageOfTabItem:tabItem placeholder:placeholder];
+        [self configureTextLayoutOfTabItem:tabItem];
+        PLTabViewControllerSetTextState(viewController, placeholder.selectedRange, placeholder.scrollPosition);
+        [self attachEditJournalToTabItem:tabItem recoveredJournal:placeholder.editJournal];
+        [self attachSyntaxHighlighterToTabItem:tabItem];
+        if ([pendingSelectedLines objectForKey:@(tabItem.identifier)]) {
+                PLTabViewControllerSelectLine(viewController, [[pendingSelectedLines objectForKey:@(tabItem.identifier)] unsignedIntegerValue]);
+                [pendingSelectedLines removeObjectForKey:@(tabItem.identifier)];
+        }
+
+exit:
+        return viewController;
+}
+
+/**
+ * \brief Give the text view of a loaded tab a `PLPieceTableTextStorage`.
+ *
+ * \details `PLDocumentManager` only opens documents by URL, so the add on's
+ *          view controller holds the text its document read again. If the
+ *          document was loaded in the background, the storage is created from
+ *          the loaded text instead, which shares the pieces of a memory mapped
+ *          file, and the encoding and line ending found by the load are
+ *          recorded for the tab's saves. If there was no load, or the document
+ *          was already open with unsaved changes, it is created from the text
+ *          view's text, which is the document's current text.
+ *
+ *          A document holding the text view's storage must share the new
+ *          one, or its saves would write the replaced text. The new storage
+ *          is handed to a document that takes it with `setTextStorage:`, and
+ *          the text view of a document that holds its storage but cannot take
+ *          another keeps its storage. Every layout manager of the replaced
+ *          storage moves to the new one, so tabs showing the same document
+ *          keep showing the same text.
+ *
+ *          The text takes the attributes of the start of the replaced
+ *          storage, and the storage takes its delegate. The storage is
+ *          installed before the tab's journal and syntax highlighter are
+ *          attached, so they observe the new storage and the replaced text is
+ *          not recorded as an edit.
+ *
+ * \param tabItem The tab item, whose view controller is the add on's.
+ *
+ * \param placeholder The placeholder being replaced.
+ */
+-(void)installTextStorageOfTabItem:(PLTabBarItemLayer *)tabItem placeholder:(PLTabPlaceholderViewController *)placeholder
+{
+        NSTextView * textView = PLTabViewControllerTextView([[tabBar viewControllerForTabItem:tabItem] view]);
+        NSTextStorage * oldTextStorage = [textView textStorage];
+        PLPieceTableTextStorage * textStorage = nil;
+        id document = placeholder.document;
+        NSString * text = placeholder.loadedText;
+        NSDictionary * attributes = nil;
+        BOOL documentHoldsTextStorage = NO;
+
+        if (text) {
+                fileEncodings[@(tabItem.identifier)] = @(placeholder.encoding);
+                fileLineEndings[@(tabItem.identifier)] = placeholder.lineEnding;
+        }
+        if (oldTextStorage == nil || [oldTextStorage isKindOfClass:[PLPieceTableTextStorage class]]) {
+                goto exit;
+        }
+        documentHoldsTextStorage = ([document respondsToSelector:@selector(textStorage)] && [document textStorage] == oldTextStorage);
+        if (documentHoldsTextStorage && [document respondsToSelector:@selector(setTextStorage:)] == NO) {
+                goto exit;
+        }
+        if (text == nil || [[PLDocumentManager sharedDocumentManager] documentIsEdited:document]) {
+                text = [oldTextStorage string];
+        }
+        if ([oldTextStorage length] > 0) {
+                attributes = [oldTextStorage attributesAtIndex:0 effectiveRange:NULL];
+        } else {
+                attributes = [textView typingAttributes];
+        }
+        textStorage = [[[PLPieceTableTextStorage alloc] initWithString:text attributes:attributes] autorelease];
+        [textStorage setDelegate:[oldTextStorage delegate]];
+        [[oldTextStorage retain] autorelease];
+        [[textView layoutManager] replaceTextStorage:textStorage];
+        if (documentHoldsTextStorage) {
+                [document performSelector:@selector(setTextStorage:) withObject:textStorage];
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Let the text view of a loaded tab lay out only the text it shows.
+ *
+ * \details With non-contiguous layout, the layout manager lays out the
+ *          visible lines and estimates the height of the rest, refining it as
+ *          it is laid out, so a large document is interactive without laying
+ *          out all of its text, and scrolling to any position only lays out the
+ *          lines there. Above `PLTabViewControllerBackgroundLayoutLength`
+ *          characters, background layout is turned off too, so the lines that
+ *          are never shown are never laid out.
+ *
+ *          The text view belongs to the add on, so this is all the tab view
+ *          controller configures of its layout. The estimated line heights,
+ *          prefix sums and cached line layouts of `PLLargeFileView` only serve
+ *          the large file viewer.
+ *
+ *          If the `PLUserDefaultLogPerformance` user default is YES, the time
+ *          to lay out the visible text is logged.
+ *
+ * \param tabItem The tab item.
+ */
+-(void)configureTextLayoutOfTabItem:(PLTabBarItemLayer *)tabItem
+{
+        NSTextView * textView = PLTabViewControllerTextView([[tabBar viewControllerForTabItem:tabItem] view]);
+        NSLayoutManager * layoutManager = [textView layoutManager];
+        NSUInteger length = [[textView textStorage] length];
+        CFTimeInterval startTime = 0.0;
+
+        if (layoutManager == nil) {
+                goto exit;
+        }
+        [layoutManager setAllowsNonContiguousLayout:YES];
+        if (length > PLTabViewControllerBackgroundLayoutLength) {
+                [layoutManager setBackgroundLayoutEnabled:NO];
+        }
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultLogPerformance]) {
+                startTime = CACurrentMediaTime();
+                [layoutManager ensureLayoutForBoundingRect:[textView visibleRect] inTextContainer:[textView textContainer]];
+                NSLog(@"Text layout: %@ laid out its visible text in %.2f ms, %lu characters",
+                      tabItem.title,
+                      (CACurrentMediaTime() - startTime) * 1000.0,
+                      (unsigned long)length);
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Start recording the edits of a loaded tab in a journal.
+ *
+ * \details A recovered journal, given or left for the tab's file by an
+ *          earlier launch, is replayed into the text view first and then
+ *          continued. A journal that cannot be replayed is discarded, and the
+ *          tab starts a new one. Tabs without a text view have no journal.
+ *
+ * \param tabItem The tab item.
+ *
+ * \param recoveredJournal The recovered journal of the tab, or nil to look
+ *                         one up by the URL of its document.
+ */
+-(void)attachEditJournalToTabItem:(PLTabBarItemLayer *)tabItem recoveredJournal:(PLEditJournal *)recoveredJournal
+{
+        NSViewController <PLTabSubviewController> * viewController = [tabBar viewControllerForTabItem:tabItem];
+        NSTextView * textView = PLTabViewControllerTextView([viewController view]);
+        NSURL * fileURL = [self fileURLForTabItem:tabItem];
+        PLEditJournal * journal = recoveredJournal;
+
+        if (journal == nil) {
+                journal = [[PLEditJournalManager sharedJournalManager] claimJournalForFileURL:fileURL];
+        }
+        if (textView == nil) {
+                [journal discard];
+                goto exit;
+        }
+        if (journal && [journal replayIntoTextView:textView] == NO) {
+                [journal discard];
+                journal = nil;
+        }
+        if (journal == nil) {
+                journal = [PLEditJournal journalWithFileURL:fileURL];
+        }
+        [journal attachToTextView:textView viewController:viewController];
+        if (journal) {
+                editJournals[@(tabItem.identifier)] = journal;
+        }
+
+exit:
+        return;
+}
+
+/**
+ * \brief Start coloring the text of a loaded tab of a Python document.
+ *
+ * \details Documents whose file has a `py` or `pyw` extension, and untitled
+ *          documents, are highlighted. Tabs without a text view are not.
+ *
+ * \param tabItem The tab item.
+ */
+-(void)attachSyntaxHighlighterToTabItem:(PLTabBarItemLayer *)tabItem
+{
+        NSTextView * textView = PLTabViewControllerTextView([[tabBar viewControllerForTabItem:tabItem] view]);
+        NSURL * fileURL = [self fileURLForTabItem:tabItem];
+        NSString * extension = [[fileURL pathExtension] lowercaseString];
+
+        if (textView == nil || (fileURL && [@[@"py", @"pyw"] containsObject:extension] == NO)) {
+                goto exit;
+        }
+        syntaxHighlighters[@(tabItem.identifier)] = [PLSyntaxHighlighter highlighterWithTextView:textView];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Stop coloring the text of a tab.
+ *
+ * \param tabItem The tab item.
+ */
+-(void)detachSyntaxHighlighterOfTabItem:(PLTabBarItemLayer *)tabItem
+{
+        [syntaxHighlighters[@(tabItem.identifier)] detach];
+        [syntaxHighlighters removeObjectForKey:@(tabItem.identifier)];
+}
+
+/**
+ * \brief Stop recording the edits of a tab and remove its journal.
+ *
+ * \param tabItem The tab item.
+ */
+-(void)discardEditJournalOfTabItem:(PLTabBarItemLayer *)tabItem
+{
+        [editJournals[@(tabItem.identifier)] discard];
+        [editJournals removeObjectForKey:@(tabItem.identifier)];
+}
+
+/**
+ * \brief Start counting the edits of the text of a tab.
+ *
+ * \details A save takes the count with its snapshot, and the document is
+ *          marked saved only if the count is the same when the save finishes,
+ *          which is cheaper than comparing the text. Tabs showing the same
+ *          text storage share its count.
+ *
+ * \param textView The text view of the tab.
+ */
+-(void)countEditsOfTextView:(NSTextView *)textView
+{
+        NSTextStorage * textStorage = [textView textStorage];
+
+        if (textStorage == nil || [editGenerations objectForKey:textStorage]) {
+                goto exit;
+        }
+        [editGenerations setObject:@0 forKey:textStorage];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(textOfTabDidChange:)
+                                                     name:NSTextStorageDidProcessEditingNotification
+                                                   object:textStorage];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Stop counting the edits of the text of a tab being unloaded or
+ *        removed, unless another loaded tab shows the same text storage.
+ *
+ * \param tabItem The tab item.
+ *
+ * \param textView The text view of the tab, or nil.
+ */
+-(void)stopCountingEditsOfTabItem:(PLTabBarItemLayer *)tabItem textView:(NSTextView *)textView
+{
+        NSTextStorage * textStorage = [textView textStorage];
+        NSViewController <PLTabSubviewController> * viewController = nil;
+
+        if (textStorage == nil || [editGenerations objectForKey:textStorage] == nil) {
+                goto exit;
+        }
+        for (PLTabBarItemLayer * item in tabBar) {
+                viewController = [tabBar viewControllerForTabItem:item];
+                if (item != tabItem &&
+                    [viewController isKindOfClass:[PLTabPlaceholderViewController class]] == NO &&
+                    [viewController isViewLoaded] &&
+                    [PLTabViewControllerTextView([viewController view]) textStorage] == textStorage) {
+                        goto exit;
+                }
+        }
+        [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                        name:NSTextStorageDidProcessEditingNotification
+                                                      object:textStorage];
+        [editGenerations removeObjectForKey:textStorage];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Count an edit of the text of a tab.
+ *
+ * \param notification The `NSTextStorageDidProcessEditingNotification`.
+ */
+-(void)textOfTabDidChange:(NSNotification *)notification
+{
+        NSTextStorage * textStorage = [notification object];
+
+        if (([textStorage editedMask] & NSTextStorageEditedCharacters) == 0) {
+                goto exit;
+        }
+        [editGenerations setObject:@([[editGenerations objectForKey:textStorage] unsignedIntegerValue] + 1) forKey:textStorage];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Replace the view controller of a background tab with a placeholder.
+ *
+ * \details Only tabs of add ons whose documents have no unsaved changes are
+ *          unloaded. The placeholder keeps the document and the selection and
+ *          scroll position of its text, so the tab loads with the same
+ *          document and text position when it is activated again.
+ *
+ * \param tabItem The tab item.
+ *
+ * \return YES if the tab was unloaded.
+ */
+-(BOOL)unloadTabItem:(PLTabBarItemLayer *)tabItem
+{
+        NSViewController <PLTabSubviewController> * viewController = [tabBar viewControllerForTabItem:tabItem];
+        PLTabPlaceholderViewController * placeholder = nil;
+        NSBundle * addOn = [NSBundle bundleForClass:[viewController class]];
+        id document = [viewController document];
+        NSRange selectedRange = NSMakeRange(NSNotFound, 0);
+        NSPoint scrollPosition = NSZeroPoint;
+        BOOL unloaded = NO;
+
+        if (tabItem == tabBar.activeTab ||
+            [viewController isKindOfClass:[PLTabPlaceholderViewController class]] ||
+            document == nil ||
+            addOn == [NSBundle mainBundle] ||
+            [[PLDocumentManager sharedDocumentManager] documentIsEdited:document]) {
+                goto exit;
+        }
+        placeholder = [PLTabPlaceholderViewController placeholderWithAddOn:addOn document:document];
+        [placeholder setTitle:[viewController title]];
+        if (PLTabViewControllerGetTextState(viewController, &selectedRange, &scrollPosition)) {
+                placeholder.selectedRange = selectedRange;
+                placeholder.scrollPosition = scrollPosition;
+        }
+        [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                        name:PLTabSubviewTitleDidChangeNotification
+                                                      object:viewController];
+        [tabBar setViewController:placeholder forTabItem:tabItem];
+        [staleThemeTabItems removeObject:tabItem];
+        [staleFontTabItems removeObject:tabItem];
+        [self stopCountingEditsOfTabItem:tabItem textView:PLTabViewControllerTextView([viewController view])];
+        [self discardEditJournalOfTabItem:tabItem];
+        [self detachSyntaxHighlighterOfTabItem:tabItem];
+        unloaded = YES;
+
+exit:
+        return unloaded;
+}
+
+/**
+ * \brief Unload the least recently active background tabs while more than
+ *        `PLTabViewControllerMaximumLoadedTabs` tabs are loaded.
+ */
+-(void)unloadLeastRecentlyUsedTabs
+{
+        NSUInteger loadedCount = 0;
+
+        for (PLTabBarItemLayer * item in tabBar) {
+                if ([[tabBar viewControllerForTabItem:item] isKindOfClass:[PLTabPlaceholderViewController class]] == NO) {
+                        loadedCount++;
+                }
+        }
+        for (PLTabBarItemLayer * item in [[recentTabItems copy] autorelease]) {
+                if (loadedCount <= PLTabViewControllerMaximumLoadedTabs) {
+                        break;
+                }
+                if ([self unloadTabItem:item]) {
+                        loadedCount--;
+                }
+        }
+}
+
+/**
+ * \brief Remove a tab and its subview controller.
+ *
+ * \details Sets the active tab to the next tab in the bar unless it's already
+ *          at the end, in which case the previous tab becomes the active tab.
+ *          Sets the active tab to nil if it was the last tab. Removes the tab
+ *          item and the subview controller. If `tabItem` is does not exist in
+ *          the tab bar, do nothing.
+ *
+ * \param tabItem The tab item to be removed.
+ */
+-(void)removeTab:(PLTabBarItemLayer *)tabItem
+{
+        NSViewController <PLTabSubviewController> * subviewController = nil;
+        
+        subviewController = [tabBar viewControllerForTabItem:tabItem];
+        if (subviewController == nil) {
+                goto exit;
+        }
+        [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                        name:PLTabSubviewTitleDidChangeNotification
+                                                      object:subviewController];
+        if ([subviewController isKindOfClass:[PLTabPlaceholderViewController class]]) {
+                [(PLTabPlaceholderViewController *)subviewController cancelLoadingDocument];
+        }
+
+        if (tabItem == tabBar.activeTab) {
+                if ([tabBar countOfTabItems] == 1) {
                         [self setActiveTab:nil];
-                } else if ([tabBar indexOfTabItem:tabItem] == [tabBar numberOfTabs] - 1) {
+                } else if ([tabBar indexOfTabItem:tabItem] == [tabBar countOfTabItems] - 1) {
                         [self selectPreviousTab];
                 } else {
                         [self selectNextTab];
@@ -884,10 +1833,23 @@ exit:
         }
         
         /* Remove the tab item */
-        [tabBarView removeTrackingArea:[tabBar trackingAreaForTabItem:tabItem]];
-        [tabBar removeTabItem:tabItem];
+        if ([subviewController isKindOfClass:[PLTabPlaceholderViewController class]] == NO && [subviewController isViewLoaded]) {
+                [self stopCountingEditsOfTabItem:tabItem textView:PLTabViewControllerTextView([subviewController view])];
+        }
+        [[PLTabRegistry sharedRegistry] removeTabItem:tabItem];
+        [self discardEditJournalOfTabItem:tabItem];
+        [self detachSyntaxHighlighterOfTabItem:tabItem];
+        [pendingSelectedLines removeObjectForKey:@(tabItem.identifier)];
+        [fileEncodings removeObjectForKey:@(tabItem.identifier)];
+        [fileLineEndings removeObjectForKey:@(tabItem.identifier)];
+        [recentTabItems removeObject:tabItem];
+        [staleThemeTabItems removeObject:tabItem];
+        [staleFontTabItems removeObject:tabItem];
+        if (tabItem == hoveredTabItem) {
+                hoveredTabItem = nil;
+        }
         [tabItem removeFromSuperlayer];
-        [self positionTabBarItemsWithAnimation:NO];
+        [tabBar removeTabItem:tabItem];
 
 exit:
         return;
@@ -896,12 +1858,30 @@ exit:
 -(void)setActiveTab:(PLTabBarItemLayer *)tabItem
 {
         NSViewController <PLTabSubviewController> * viewController = nil;
+        PLTabBarItemLayer * item = nil;
+        NSUInteger index = 0;
+        BOOL isPlaceholder = NO;
         NSNotificationCenter * defaultCenter = [NSNotificationCenter defaultCenter];
 
         viewController = [tabBar viewControllerForTabItem:tabItem];
-        if (tabItem && (tabItem == tabBar.activeTab || viewController == nil)) {
+        isPlaceholder = [viewController isKindOfClass:[PLTabPlaceholderViewController class]];
+        if (tabItem && (viewController == nil ||
+                        (tabItem == tabBar.activeTab && (isPlaceholder == NO || [(PLTabPlaceholderViewController *)viewController isLoading])))) {
                 goto exit;
         }
+        if (isPlaceholder && [(PLTabPlaceholderViewController *)viewController loadDocumentInBackground] == NO) {
+                viewController = [self loadTabItem:tabItem];
+                if (viewController == nil) {
+                        goto exit;
+                }
+        }
+        if ([staleThemeTabItems containsObject:tabItem]) {
+                [viewController updateThemeManager];
+                [staleThemeTabItems removeObject:tabItem];
+        }
+        if ([staleFontTabItems containsObject:tabItem]) {
+                [self updateFontOfTabItem:tabItem];
+        }
         
         /* Setup new view controller */
         [defaultCenter removeObserver:self
@@ -930,16 +1910,25 @@ exit:
         /* Reorder tabs and update their background color */
         [CATransaction begin];
         [CATransaction setDisableActions:YES];
-        [tabBar.tabItems enumerateObjectsUsingBlock:^(PLTabBarItemLayer * item, NSUInteger idx, BOOL * stop) {
+        for (index = 0; index < [tabBar countOfTabItems]; index++) {
+                item = [tabBar objectInTabItemsAtIndex:index];
                 if (item == tabBar.activeTab) {
-                        item.zPosition = [tabBar numberOfTabs];
+                        item.zPosition = [tabBar countOfTabItems];
                 } else {
-                        item.zPosition = [tabBar numberOfTabs] - idx - 1;
+                        item.zPosition = [tabBar countOfTabItems] - index - 1;
                 }
-        }];
+        }
         [CATransaction commit];
         [self updateTabColors];
 
+        /* Keep only the most recently active tabs loaded */
+        [recentTabItems removeObject:tabItem];
+        if (tabItem) {
+                [recentTabItems addObject:tabItem];
+        }
+        [self unloadLeastRecentlyUsedTabs];
+        [self tabsDidChange];
+
 exit:
         return;
 }
@@ -948,17 +1937,17 @@ exit:
 {
         NSUInteger activeTabIndex = 0, nextTabIndex = 0;
         
-        if ([tabBar numberOfTabs] == 0) {
+        if ([tabBar countOfTabItems] == 0) {
                 goto exit;
         }
         
-        activeTabIndex = [tabBar.tabItems indexOfObject:tabBar.activeTab];
-        if (activeTabIndex == [tabBar numberOfTabs] - 1) {
+        activeTabIndex = [tabBar indexOfTabItem:tabBar.activeTab];
+        if (activeTabIndex == [tabBar countOfTabItems] - 1) {
                 nextTabIndex = 0;
         } else {
                 nextTabIndex = activeTabIndex + 1;
         }
-        [self setActiveTab:[tabBar tabItemAtIndex:nextTabIndex]];
+        [self setActiveTab:[tabBar objectInTabItemsAtIndex:nextTabIndex]];
 
 exit:
         return;
@@ -968,17 +1957,17 @@ exit:
 {
         NSUInteger activeTabIndex = 0, previousTabIndex = 0;
         
-        if ([tabBar numberOfTabs] == 0) {
+        if ([tabBar countOfTabItems] == 0) {
                 goto exit;
         }
         
-        activeTabIndex = [tabBar.tabItems indexOfObject:tabBar.activeTab];
+        activeTabIndex = [tabBar indexOfTabItem:tabBar.activeTab];
         if (activeTabIndex == 0) {
-                previousTabIndex = [tabBar numberOfTabs] - 1;
+                previousTabIndex = [tabBar countOfTabItems] - 1;
         } else {
                 previousTabIndex = activeTabIndex - 1;
         }
-        [self setActiveTab:[tabBar tabItemAtIndex:previousTabIndex]];
+        [self setActiveTab:[tabBar objectInTabItemsAtIndex:previousTabIndex]];
 
 exit:
         return;
@@ -988,8 +1977,9 @@ exit:
 {
         BOOL shouldCloseAllTabs = YES;
         while (shouldCloseAllTabs == YES) {
-                if (tabBar.activeTab == nil)
+                if (tabBar.activeTab == nil) {
                         break;
+                }
                 shouldCloseAllTabs = [[tabBar viewControllerForTabItem:tabBar.activeTab] tabSubviewShouldClose:self];
                 if (shouldCloseAllTabs == YES) {
                         [self removeTab:tabBar.activeTab];
@@ -1000,20 +1990,75 @@ exit:
 
 #pragma mark - Documents
 
+/**
+ * \brief Return the URL of the document of a tab.
+ *
+ * \details The URL of a placeholder is known before its document is loaded,
+ *          and a large file viewer shows a file without a document.
+ *
+ * \param tabItem The tab item.
+ *
+ * \return The URL of the document, or nil if the tab has no document or the
+ *         document has not been saved to a file.
+ */
+-(NSURL *)fileURLForTabItem:(PLTabBarItemLayer *)tabItem
+{
+        NSViewController <PLTabSubviewController> * viewController = [tabBar viewControllerForTabItem:tabItem];
+        NSURL * fileURL = nil;
+
+        if ([viewController isKindOfClass:[PLTabPlaceholderViewController class]]) {
+                fileURL = [(PLTabPlaceholderViewController *)viewController fileURL];
+        } else if ([viewController isKindOfClass:[PLLargeFileViewController class]]) {
+                fileURL = [(PLLargeFileViewController *)viewController fileURL];
+        } else {
+                fileURL = [[viewController document] fileURL];
+        }
+        return fileURL;
+}
+
 /**
  * \brief Return the tab item containing a document at a particular URL.
  *
+ * \details Looked up in the shared `PLTabRegistry`, so paths reaching the same
+ *          file through links or in a different case find the tab as well.
+ *
  * \param fileURL The URL of the document.
  *
  * \return The `PLTabBarItemLayer` whose associated view controller contains
  *         the document at `fileURL` or nil if no tabs do.
  */
 -(PLTabBarItemLayer *)tabItemForURL:(NSURL *)fileURL
+{
+        return [[PLTabRegistry sharedRegistry] tabItemForURL:fileURL inTabViewController:self];
+}
+
+-(BOOL)containsTabWithURL:(NSURL *)fileURL
+{
+        return [self tabItemForURL:fileURL] != nil;
+}
+
+-(void)setTabWithURLActive:(NSURL *)fileURL
+{
+        PLTabBarItemLayer * tabItem = [self tabItemForURL:fileURL];
+        if (tabItem) {
+                [self setActiveTab:tabItem];
+        }
+}
+
+/**
+ * \brief Return the tab item managed by a view controller.
+ *
+ * \param viewController The view controller.
+ *
+ * \return The `PLTabBarItemLayer` of `viewController` or nil if no tabs are
+ *         managed by it.
+ */
+-(PLTabBarItemLayer *)tabItemForViewController:(NSViewController *)viewController
 {
         PLTabBarItemLayer * tabItem = nil;
-        
-        for (PLTabBarItemLayer * item in tabBar.tabItems) {
-                if ([fileURL isEqualTo:[[[tabBar viewControllerForTabItem:item] document] fileURL]]) {
+
+        for (PLTabBarItemLayer * item in tabBar) {
+                if ([tabBar viewControllerForTabItem:item] == viewController) {
                         tabItem = item;
                         break;
                 }
@@ -1021,19 +2066,122 @@ exit:
         return tabItem;
 }
 
--(BOOL)containsTabWithURL:(NSURL *)fileURL
+-(BOOL)containsTabWithViewController:(NSViewController *)viewController
 {
-        return [self tabItemForURL:fileURL] != nil;
+        return [self tabItemForViewController:viewController] != nil;
 }
 
--(void)setTabWithURLActive:(NSURL *)fileURL
+-(void)setTabWithViewControllerActive:(NSViewController *)viewController
 {
-        PLTabBarItemLayer * tabItem = [self tabItemForURL:fileURL];
+        PLTabBarItemLayer * tabItem = [self tabItemForViewController:viewController];
         if (tabItem) {
                 [self setActiveTab:tabItem];
         }
 }
 
+-(void)selectLine:(NSUInteger)line ofTabWithURL:(NSURL *)fileURL
+{
+        PLTabBarItemLayer * tabItem = [self tabItemForURL:fileURL];
+        NSViewController * viewController = [tabBar viewControllerForTabItem:tabItem];
+
+        if (tabItem == nil) {
+                goto exit;
+        }
+        if ([viewController isKindOfClass:[PLTabPlaceholderViewController class]] ||
+            PLTabViewControllerSelectLine(viewController, line) == NO) {
+                [pendingSelectedLines setObject:@(line) forKey:@(tabItem.identifier)];
+        }
+
+exit:
+        return;
+}
+
+-(NSString *)selectedNameOfActiveTab
+{
+        NSTextView * textView = PLTabViewControllerTextView([[tabBar viewControllerForTabItem:tabBar.activeTab] view]);
+        NSCharacterSet * nameCharacters = [NSCharacterSet characterSetWithCharactersInString:@"_"];
+        NSString * string = [textView string], * name = nil;
+        NSRange range = [textView selectedRange];
+        NSUInteger start = 0, end = 0;
+
+        if (textView == nil) {
+                goto exit;
+        }
+        if (range.length == 0) {
+                nameCharacters = [[nameCharacters mutableCopy] autorelease];
+                [(NSMutableCharacterSet *)nameCharacters formUnionWithCharacterSet:[NSCharacterSet alphanumericCharacterSet]];
+                for (start = range.location; start > 0 && [nameCharacters characterIsMember:[string characterAtIndex:start - 1]]; start--);
+                for (end = range.location; end < [string length] && [nameCharacters characterIsMember:[string characterAtIndex:end]]; end++);
+                range = NSMakeRange(start, end - start);
+        }
+        if (range.length > 0) {
+                name = [[string substringWithRange:range] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+        }
+
+exit:
+        return [name length] > 0 ? name : nil;
+}
+
+#pragma mark - Session
+
+-(NSArray *)sessionTabsWithActiveTabIndex:(NSUInteger *)activeTabIndex
+{
+        NSMutableArray * tabs = [NSMutableArray array];
+        NSViewController <PLTabSubviewController> * viewController = nil;
+        PLTabPlaceholderViewController * placeholder = nil;
+        PLSessionTab * tab = nil;
+        NSURL * fileURL = nil;
+        NSRange selectedRange = NSMakeRange(NSNotFound, 0);
+        NSPoint scrollPosition = NSZeroPoint;
+
+        *activeTabIndex = NSNotFound;
+        for (PLTabBarItemLayer * item in tabBar) {
+                fileURL = [self fileURLForTabItem:item];
+                if ([fileURL isFileURL] == NO) {
+                        continue;
+                }
+                tab = [PLSessionTab tabWithFileURL:fileURL];
+                viewController = [tabBar viewControllerForTabItem:item];
+                if ([viewController isKindOfClass:[PLTabPlaceholderViewController class]]) {
+                        placeholder = (PLTabPlaceholderViewController *)viewController;
+                        tab.selectedRange = placeholder.selectedRange;
+                        tab.scrollPosition = placeholder.scrollPosition;
+                } else if (PLTabViewControllerGetTextState(viewController, &selectedRange, &scrollPosition)) {
+                        tab.selectedRange = selectedRange;
+                        tab.scrollPosition = scrollPosition;
+                }
+                if (item == tabBar.activeTab) {
+                        *activeTabIndex = [tabs count];
+                }
+                [tabs addObject:tab];
+        }
+        return tabs;
+}
+
+-(void)addTabsWithPlaceholders:(NSArray *)placeholders activeTabIndex:(NSUInteger)activeTabIndex
+{
+        PLTabPlaceholderViewController * activePlaceholder = nil;
+
+        if ([placeholders count] == 0) {
+                goto exit;
+        }
+        [tabBar performBatchUpdates:^{
+                for (PLTabPlaceholderViewController * placeholder in placeholders) {
+                        [self insertTabItemWithViewController:placeholder];
+                }
+        }];
+
+        activePlaceholder = [placeholders objectAtIndex:(activeTabIndex < [placeholders count] ? activeTabIndex : 0)];
+        [activePlaceholder loadDocumentInBackground];
+        for (PLTabPlaceholderViewController * placeholder in placeholders) {
+                [placeholder loadDocumentInBackground];
+        }
+        [self setActiveTab:[self tabItemForViewController:activePlaceholder]];
+
+exit:
+        return;
+}
+
 #pragma mark - Responder Chain
 
 /**
@@ -1051,10 +2199,178 @@ exit:
 
 -(void)saveActiveTab
 {
-        NSViewController <PLTabSubviewController> * subviewController = nil;
+        if (tabBar.activeTab) {
+                [self saveTabItems:@[tabBar.activeTab]];
+        }
+}
 
-        subviewController = [tabBar viewControllerForTabItem:tabBar.activeTab];
-        [subviewController saveFile:self];
+-(void)saveAllTabs
+{
+        NSMutableArray * tabItems = [NSMutableArray array];
+        PLDocument<PLDocumentSubclass> * document = nil;
+        PLTabBarItemLayer * tabItem = nil;
+
+        for (tabItem in tabBar) {
+                document = [[tabBar viewControllerForTabItem:tabItem] document];
+                if (document && [[PLDocumentManager sharedDocumentManager] documentIsEdited:document]) {
+                        [tabItems addObject:tabItem];
+                }
+        }
+        [self saveTabItems:tabItems];
+}
+
+/**
+ * \brief Create a save of the document of a tab.
+ *
+ * \details Subview controllers conforming to `PLDocumentSaving` create their
+ *          own saves. For the others, the save takes a snapshot of the text
+ *          view's string, which is constant time for a
+ *          `PLPieceTableTextStorage`, with the encoding and line ending found
+ *          when the document was loaded, or UTF-8 and line feeds, and the
+ *          edits of the text view are counted from then on.
+ *
+ * \param tabItem The tab item.
+ *
+ * \return The save, or nil if the tab is not loaded, has no text view, or
+ *         its document has no file.
+ */
+-(PLDocumentSave *)documentSaveOfTabItem:(PLTabBarItemLayer *)tabItem
+{
+        NSViewController <PLTabSubviewController> * subviewController = [tabBar viewControllerForTabItem:tabItem];
+        NSTextView * textView = nil;
+        NSURL * fileURL = nil;
+        NSNumber * encoding = nil;
+        PLDocumentSave * save = nil;
+
+        if ([subviewController conformsToProtocol:@protocol(PLDocumentSaving)]) {
+                save = [(id <PLDocumentSaving>)subviewController documentSave];
+                goto exit;
+        }
+        if ([subviewController isKindOfClass:[PLTabPlaceholderViewController class]] || [subviewController isViewLoaded] == NO) {
+                goto exit;
+        }
+        textView = PLTabViewControllerTextView([subviewController view]);
+        fileURL = [[subviewController document] fileURL];
+        if (textView == nil || fileURL == nil) {
+                goto exit;
+        }
+        [self countEditsOfTextView:textView];
+        encoding = fileEncodings[@(tabItem.identifier)];
+        save = [PLDocumentSave saveWithText:[[[textView string] copy] autorelease]
+                                    fileURL:fileURL
+                                   encoding:encoding ? [encoding unsignedIntegerValue] : NSUTF8StringEncoding
+                                 lineEnding:fileLineEndings[@(tabItem.identifier)]];
+
+exit:
+        return save;
+}
+
+/**
+ * \brief Return the count of edits of the text of a tab.
+ *
+ * \param textView The text view of the tab, or nil.
+ *
+ * \return The count, or `NSNotFound` if the edits of the text view are not
+ *         counted.
+ */
+-(NSUInteger)editGenerationOfTextView:(NSTextView *)textView
+{
+        NSNumber * editGeneration = [textView textStorage] ? [editGenerations objectForKey:[textView textStorage]] : nil;
+
+        return editGeneration ? [editGeneration unsignedIntegerValue] : NSNotFound;
+}
+
+/**
+ * \brief Mark the document of a tab saved once its save has been written.
+ *
+ * \details Subview controllers conforming to `PLDocumentSaving` are sent
+ *          `documentSaveDidFinish:`. For the others, the document is marked
+ *          unedited if its text has not been edited since the snapshot was
+ *          taken and it responds to `updateChangeCount:`, as
+ *          `PLDocumentManager` offers no way to mark it saved. A
+ *          `PLTabSubviewDocumentChangedSavedSateNotification` is posted
+ *          either way, updating the window and the tab's edit journal.
+ *
+ * \param tabItem The tab item.
+ *
+ * \param save The finished save, which succeeded.
+ *
+ * \param editGeneration The count of edits of the tab's text when the
+ *                       snapshot of the save was taken.
+ */
+-(void)documentOfTabItem:(PLTabBarItemLayer *)tabItem didFinishSave:(PLDocumentSave *)save editGeneration:(NSUInteger)editGeneration
+{
+        NSViewController <PLTabSubviewController> * subviewController = [tabBar viewControllerForTabItem:tabItem];
+        NSTextView * textView = nil;
+        id document = [subviewController document];
+
+        if ([subviewController conformsToProtocol:@protocol(PLDocumentSaving)]) {
+                [(id <PLDocumentSaving>)subviewController documentSaveDidFinish:save];
+                goto exit;
+        }
+        if ([subviewController isViewLoaded]) {
+                textView = PLTabViewControllerTextView([subviewController view]);
+        }
+        if ([self editGenerationOfTextView:textView] == editGeneration && [document respondsToSelector:@selector(updateChangeCount:)]) {
+                [document updateChangeCount:NSChangeCleared];
+        }
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLTabSubviewDocumentChangedSavedSateNotification
+                                                            object:subviewController];
+
+exit:
+        return;
+}
+
+/**
+ * \brief Save the documents of tabs as one batch.
+ *
+ * \details The documents of tabs with a save from `documentSaveOfTabItem:`
+ *          are saved by the `PLDocumentSaver`, showing the progress of each
+ *          save on its tab and presenting the error of a failed save. The
+ *          other subview controllers are sent `saveFile:`.
+ *
+ *          The journal of a tab starts over once per save. When the document
+ *          is marked unedited, the journal starts over on the
+ *          `PLTabSubviewDocumentChangedSavedSateNotification` that follows,
+ *          so it is only rebased here if the document was edited during the
+ *          save.
+ *
+ * \param tabItems The tab items.
+ */
+-(void)saveTabItems:(NSArray *)tabItems
+{
+        PLDocumentSaver * saver = [PLDocumentSaver sharedSaver];
+
+        [saver performBatchSaves:^{
+                PLDocumentSave * save = nil;
+                PLTabBarItemLayer * tabItem = nil;
+                NSUInteger editGeneration = 0;
+
+                for (tabItem in tabItems) {
+                        save = [self documentSaveOfTabItem:tabItem];
+                        if (save == nil) {
+                                [[tabBar viewControllerForTabItem:tabItem] saveFile:self];
+                                continue;
+                        }
+                        editGeneration = [self editGenerationOfTextView:PLTabViewControllerTextView([[tabBar viewControllerForTabItem:tabItem] view])];
+                        tabItem.progress = 0.0f;
+                        save.progressHandler = ^(PLDocumentSave * runningSave, double progress) {
+                                tabItem.progress = progress;
+                        };
+                        save.completionHandler = ^(PLDocumentSave * finishedSave) {
+                                tabItem.progress = -1.0f;
+                                if (finishedSave.error) {
+                                        [[self view] presentError:finishedSave.error];
+                                } else {
+                                        [self documentOfTabItem:tabItem didFinishSave:finishedSave editGeneration:editGeneration];
+                                        if ([[PLDocumentManager sharedDocumentManager] documentIsEdited:[[tabBar viewControllerForTabItem:tabItem] document]]) {
+                                                [editJournals[@(tabItem.identifier)] rebase];
+                                        }
+                                }
+                        };
+                        [saver saveDocument:save];
+                }
+        }];
 }
 
 -(void)saveAsActiveTab
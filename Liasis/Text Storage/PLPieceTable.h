@@ -0,0 +1,229 @@
+/**
+ * \file PLPieceTable.h
+ *
+ * \brief Liasis Python IDE piece table.
+ *
+ * \details This file includes the piece table holding the text of a document
+ *          and the immutable strings it returns as snapshots of the text.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * \brief The largest number of bytes of a file held by one piece.
+ */
+extern const NSUInteger PLPieceTableChunkLength;
+
+/**
+ * \brief The number of characters of each block of the append buffer.
+ */
+extern const NSUInteger PLPieceTableBlockLength;
+
+/**
+ * \brief A node of the tree of pieces.
+ */
+struct PLPieceNode;
+
+/**
+ * \class PLPieceTableString \headerfile \headerfile
+ *
+ * \brief The text of a `PLPieceTable`.
+ *
+ * \details A snapshot shares the tree of pieces of its table at the time it
+ *          was taken, so taking one is constant time and costs no copy of the
+ *          text. Snapshots are immutable and may be read from any thread,
+ *          which lets highlighting, linting, and saving read a consistent
+ *          version of the text while it is edited.
+ *
+ *          The string returned by `-[PLPieceTable string]` is the one
+ *          exception: it always reflects the current text, and must be read
+ *          on the thread editing the table. Copying it returns a snapshot.
+ *
+ *          Lines are separated by line feeds. Both line lookups take
+ *          logarithmic time in the number of pieces.
+ */
+@interface PLPieceTableString : NSString
+{
+        /**
+         * \brief The root of the tree of pieces.
+         */
+        struct PLPieceNode * root;
+
+        /**
+         * \brief The buffers the pieces refer to, kept alive by the string.
+         */
+        NSArray * buffers;
+
+        /**
+         * \brief YES if the string is the live string of its table.
+         */
+        BOOL live;
+}
+
+/**
+ * \brief Return the number of lines.
+ *
+ * \return One more than the number of line feeds.
+ */
+-(NSUInteger)lineCount;
+
+/**
+ * \brief Return the index of the first character of a line.
+ *
+ * \param line The line number, starting at 0.
+ *
+ * \return The index, or `NSNotFound` if the text has fewer lines.
+ */
+-(NSUInteger)indexOfLine:(NSUInteger)line;
+
+/**
+ * \brief Return the line containing a character.
+ *
+ * \param index The index of the character, up to the length of the text.
+ *
+ * \return The line number, starting at 0.
+ */
+-(NSUInteger)lineForIndex:(NSUInteger)index;
+
+@end
+
+/**
+ * \class PLPieceTable \headerfile \headerfile
+ *
+ * \brief Stores text as a sequence of pieces of read only buffers.
+ *
+ * \details The text is never moved when it is edited. Inserted characters are
+ *          appended to an append buffer, which grows by blocks of
+ *          `PLPieceTableBlockLength` characters that never move, and the
+ *          pieces referring to the original file and the append buffer are
+ *          kept in a persistent balanced tree. An edit splits and joins the
+ *          tree along one path in logarithmic time, sharing the rest of the
+ *          tree with the snapshots taken before it. Each node records the
+ *          length and line feeds of its subtree, which maps offsets to lines
+ *          and back.
+ *
+ *          A table created from a memory mapped UTF-8 file keeps the file
+ *          mapped as the source of its original pieces. Chunks of the file
+ *          that are ASCII without carriage returns refer to the mapping
+ *          directly. Other chunks are decoded, with their line endings
+ *          normalized to line feeds, into buffers of their own. Pieces never
+ *          hold more than `PLPieceTableChunkLength` bytes of the file or one
+ *          block of the append buffer, bounding the scans for line feeds
+ *          within a piece.
+ *
+ *          A table must be edited on one thread at a time.
+ */
+@interface PLPieceTable : NSObject
+{
+        /**
+         * \brief The root of the tree of pieces.
+         */
+        struct PLPieceNode * root;
+
+        /**
+         * \brief The mapped file, the decoded chunks, and the blocks of the
+         *        append buffer.
+         */
+        NSMutableArray * buffers;
+
+        /**
+         * \brief The block of the append buffer being filled.
+         */
+        unichar * appendBlock;
+
+        /**
+         * \brief The number of characters used in `appendBlock`.
+         */
+        NSUInteger appendBlockLength;
+
+        /**
+         * \brief The live string of the table.
+         */
+        PLPieceTableString * string;
+
+        /**
+         * \brief The snapshot of the current text, or nil if not taken since
+         *        the last edit.
+         */
+        PLPieceTableString * snapshot;
+}
+
+/**
+ * \brief Initialize a table with a string.
+ *
+ * \details Initializing with a snapshot of another table shares its pieces
+ *          and takes constant time.
+ *
+ * \param aString The initial text.
+ *
+ * \return The initialized table.
+ */
+-(instancetype)initWithString:(NSString *)aString;
+
+/**
+ * \brief Initialize a table with the contents of a UTF-8 file.
+ *
+ * \param data The contents of the file, usually memory mapped.
+ *
+ * \param preambleLength The length of the byte order mark, skipped.
+ *
+ * \return The initialized table, or nil if the file is not valid UTF-8.
+ */
+-(instancetype)initWithUTF8Data:(NSData *)data preambleLength:(NSUInteger)preambleLength;
+
+/**
+ * \brief The length of the text.
+ */
+@property (readonly) NSUInteger length;
+
+/**
+ * \brief The live string of the table.
+ *
+ * \details The string changes as the table is edited. Copy it to take a
+ *          snapshot.
+ */
+@property (readonly) PLPieceTableString * string;
+
+/**
+ * \brief Return a snapshot of the text.
+ *
+ * \details The snapshot is cached until the next edit.
+ *
+ * \return An immutable string sharing the pieces of the table.
+ */
+-(PLPieceTableString *)snapshot;
+
+/**
+ * \brief Replace characters of the text.
+ *
+ * \details Runs in time logarithmic in the number of pieces and linear in the
+ *          length of `aString`, whatever the length of the text.
+ *
+ * \param range The range of characters replaced.
+ *
+ * \param aString The characters replacing them.
+ */
+-(void)replaceCharactersInRange:(NSRange)range withString:(NSString *)aString;
+
+@end
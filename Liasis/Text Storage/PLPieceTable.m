@@ -0,0 +1,762 @@
+/**
+ * \file PLPieceTable.m
+ *
+ * \brief Liasis Python IDE piece table.
+ *
+ * \details This file includes the piece table holding the text of a document
+ *          and the immutable strings it returns as snapshots of the text.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLPieceTable.h"
+#import <libkern/OSAtomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+const NSUInteger PLPieceTableChunkLength = 64 * 1024;
+
+const NSUInteger PLPieceTableBlockLength = 64 * 1024;
+
+#pragma mark - Pieces
+
+/**
+ * \brief A run of characters in one buffer.
+ *
+ * \details Narrow pieces refer to ASCII bytes of the mapped file, and wide
+ *          pieces to UTF-16 characters of a decoded chunk or of the append
+ *          buffer.
+ */
+typedef struct PLPiece {
+        const void * characters;
+        NSUInteger length;
+        NSUInteger lineFeeds;
+        BOOL narrow;
+} PLPiece;
+
+/**
+ * \brief A node of the persistent tree of pieces.
+ *
+ * \details Nodes are immutable once created and shared between the table and
+ *          its snapshots, so they are reference counted atomically.
+ */
+typedef struct PLPieceNode {
+        struct PLPieceNode * left;
+        struct PLPieceNode * right;
+        PLPiece piece;
+        NSUInteger length;
+        NSUInteger lineFeeds;
+        int32_t height;
+        volatile int32_t retainCount;
+} PLPieceNode;
+
+/**
+ * \brief Return a character of a piece.
+ */
+static inline unichar PLPieceCharacterAtIndex(const PLPiece * piece, NSUInteger index)
+{
+        return piece->narrow ? ((const uint8_t *)piece->characters)[index] : ((const unichar *)piece->characters)[index];
+}
+
+/**
+ * \brief Count the line feeds in a range of a piece.
+ */
+static NSUInteger PLPieceCountLineFeeds(const PLPiece * piece, NSUInteger location, NSUInteger length)
+{
+        const uint8_t * bytes = (const uint8_t *)piece->characters + location;
+        const unichar * characters = (const unichar *)piece->characters + location;
+        NSUInteger index = 0, count = 0;
+
+        if (piece->narrow) {
+                for (index = 0; index < length; index++) {
+                        count += (bytes[index] == '\n');
+                }
+        } else {
+                for (index = 0; index < length; index++) {
+                        count += (characters[index] == '\n');
+                }
+        }
+        return count;
+}
+
+/**
+ * \brief Return the index in a piece following its nth line feed.
+ *
+ * \param lineFeed The line feed, starting at 1.
+ */
+static NSUInteger PLPieceIndexAfterLineFeed(const PLPiece * piece, NSUInteger lineFeed)
+{
+        NSUInteger index = 0;
+
+        for (index = 0; index < piece->length; index++) {
+                if (PLPieceCharacterAtIndex(piece, index) == '\n' && --lineFeed == 0) {
+                        index++;
+                        break;
+                }
+        }
+        return index;
+}
+
+/**
+ * \brief Split a piece in two.
+ *
+ * \details The line feeds are only counted in the shorter half.
+ */
+static void PLPieceSplit(const PLPiece * piece, NSUInteger index, PLPiece * prefix, PLPiece * suffix)
+{
+        NSUInteger width = piece->narrow ? sizeof(uint8_t) : sizeof(unichar);
+
+        *prefix = *piece;
+        *suffix = *piece;
+        prefix->length = index;
+        suffix->characters = (const uint8_t *)piece->characters + index * width;
+        suffix->length = piece->length - index;
+        if (index <= piece->length / 2) {
+                prefix->lineFeeds = PLPieceCountLineFeeds(piece, 0, index);
+                suffix->lineFeeds = piece->lineFeeds - prefix->lineFeeds;
+        } else {
+                suffix->lineFeeds = PLPieceCountLineFeeds(piece, index, piece->length - index);
+                prefix->lineFeeds = piece->lineFeeds - suffix->lineFeeds;
+        }
+}
+
+#pragma mark - Tree
+
+static inline int32_t PLPieceNodeHeight(const PLPieceNode * node)
+{
+        return node ? node->height : 0;
+}
+
+static inline NSUInteger PLPieceNodeLength(const PLPieceNode * node)
+{
+        return node ? node->length : 0;
+}
+
+static inline NSUInteger PLPieceNodeLineFeeds(const PLPieceNode * node)
+{
+        return node ? node->lineFeeds : 0;
+}
+
+static inline PLPieceNode * PLPieceNodeRetain(PLPieceNode * node)
+{
+        if (node) {
+                OSAtomicIncrement32Barrier(&node->retainCount);
+        }
+        return node;
+}
+
+static void PLPieceNodeRelease(PLPieceNode * node)
+{
+        if (node && OSAtomicDecrement32Barrier(&node->retainCount) == 0) {
+                PLPieceNodeRelease(node->left);
+                PLPieceNodeRelease(node->right);
+                free(node);
+        }
+}
+
+/**
+ * \brief Create a node, taking ownership of its children.
+ */
+static PLPieceNode * PLPieceNodeCreate(PLPiece piece, PLPieceNode * left, PLPieceNode * right)
+{
+        PLPieceNode * node = malloc(sizeof(PLPieceNode));
+
+        node->left = left;
+        node->right = right;
+        node->piece = piece;
+        node->length = PLPieceNodeLength(left) + piece.length + PLPieceNodeLength(right);
+        node->lineFeeds = PLPieceNodeLineFeeds(left) + piece.lineFeeds + PLPieceNodeLineFeeds(right);
+        node->height = 1 + MAX(PLPieceNodeHeight(left), PLPieceNodeHeight(right));
+        node->retainCount = 1;
+        return node;
+}
+
+/**
+ * \brief Take the children and piece of a node, releasing the node.
+ */
+static void PLPieceNodeExpose(PLPieceNode * node, PLPieceNode ** left, PLPiece * piece, PLPieceNode ** right)
+{
+        *left = PLPieceNodeRetain(node->left);
+        *right = PLPieceNodeRetain(node->right);
+        *piece = node->piece;
+        PLPieceNodeRelease(node);
+}
+
+static PLPieceNode * PLPieceNodeRotateLeft(PLPieceNode * node)
+{
+        PLPieceNode * a = NULL, * right = NULL, * b = NULL, * c = NULL;
+        PLPiece piece, rightPiece;
+
+        PLPieceNodeExpose(node, &a, &piece, &right);
+        PLPieceNodeExpose(right, &b, &rightPiece, &c);
+        return PLPieceNodeCreate(rightPiece, PLPieceNodeCreate(piece, a, b), c);
+}
+
+static PLPieceNode * PLPieceNodeRotateRight(PLPieceNode * node)
+{
+        PLPieceNode * left = NULL, * a = NULL, * b = NULL, * c = NULL;
+        PLPiece piece, leftPiece;
+
+        PLPieceNodeExpose(node, &left, &piece, &c);
+        PLPieceNodeExpose(left, &a, &leftPiece, &b);
+        return PLPieceNodeCreate(leftPiece, a, PLPieceNodeCreate(piece, b, c));
+}
+
+static PLPieceNode * PLPieceNodeJoinRight(PLPieceNode * left, PLPiece piece, PLPieceNode * right)
+{
+        PLPieceNode * ll = NULL, * lr = NULL, * tree = NULL;
+        PLPiece leftPiece;
+        int32_t height = 0;
+
+        PLPieceNodeExpose(left, &ll, &leftPiece, &lr);
+        if (PLPieceNodeHeight(lr) <= PLPieceNodeHeight(right) + 1) {
+                tree = PLPieceNodeCreate(piece, lr, right);
+                if (tree->height <= PLPieceNodeHeight(ll) + 1) {
+                        return PLPieceNodeCreate(leftPiece, ll, tree);
+                }
+                return PLPieceNodeRotateLeft(PLPieceNodeCreate(leftPiece, ll, PLPieceNodeRotateRight(tree)));
+        }
+        tree = PLPieceNodeJoinRight(lr, piece, right);
+        height = tree->height;
+        tree = PLPieceNodeCreate(leftPiece, ll, tree);
+        return (height <= PLPieceNodeHeight(ll) + 1) ? tree : PLPieceNodeRotateLeft(tree);
+}
+
+static PLPieceNode * PLPieceNodeJoinLeft(PLPieceNode * left, PLPiece piece, PLPieceNode * right)
+{
+        PLPieceNode * rl = NULL, * rr = NULL, * tree = NULL;
+        PLPiece rightPiece;
+        int32_t height = 0;
+
+        PLPieceNodeExpose(right, &rl, &rightPiece, &rr);
+        if (PLPieceNodeHeight(rl) <= PLPieceNodeHeight(left) + 1) {
+                tree = PLPieceNodeCreate(piece, left, rl);
+                if (tree->height <= PLPieceNodeHeight(rr) + 1) {
+                        return PLPieceNodeCreate(rightPiece, tree, rr);
+                }
+                return PLPieceNodeRotateRight(PLPieceNodeCreate(rightPiece, PLPieceNodeRotateLeft(tree), rr));
+        }
+        tree = PLPieceNodeJoinLeft(left, piece, rl);
+        height = tree->height;
+        tree = PLPieceNodeCreate(rightPiece, tree, rr);
+        return (height <= PLPieceNodeHeight(rr) + 1) ? tree : PLPieceNodeRotateRight(tree);
+}
+
+/**
+ * \brief Join two trees with a piece between them, taking ownership of both.
+ */
+static PLPieceNode * PLPieceNodeJoin(PLPieceNode * left, PLPiece piece, PLPieceNode * right)
+{
+        if (PLPieceNodeHeight(left) > PLPieceNodeHeight(right) + 1) {
+                return PLPieceNodeJoinRight(left, piece, right);
+        }
+        if (PLPieceNodeHeight(right) > PLPieceNodeHeight(left) + 1) {
+                return PLPieceNodeJoinLeft(left, piece, right);
+        }
+        return PLPieceNodeCreate(piece, left, right);
+}
+
+/**
+ * \brief Remove the last piece of a tree, taking ownership of the tree.
+ */
+static PLPieceNode * PLPieceNodeSplitLast(PLPieceNode * node, PLPiece * lastPiece)
+{
+        PLPieceNode * left = NULL, * right = NULL;
+        PLPiece piece;
+
+        PLPieceNodeExpose(node, &left, &piece, &right);
+        if (right == NULL) {
+                *lastPiece = piece;
+                return left;
+        }
+        return PLPieceNodeJoin(left, piece, PLPieceNodeSplitLast(right, lastPiece));
+}
+
+/**
+ * \brief Concatenate two trees, taking ownership of both.
+ */
+static PLPieceNode * PLPieceNodeConcatenate(PLPieceNode * left, PLPieceNode * right)
+{
+        PLPiece piece;
+
+        if (left == NULL) {
+                return right;
+        }
+        if (right == NULL) {
+                return left;
+        }
+        left = PLPieceNodeSplitLast(left, &piece);
+        return PLPieceNodeJoin(left, piece, right);
+}
+
+/**
+ * \brief Split a tree at a character index, taking ownership of the tree.
+ *
+ * \details A piece containing the index is split in two.
+ */
+static void PLPieceNodeSplit(PLPieceNode * node, NSUInteger index, PLPieceNode ** left, PLPieceNode ** right)
+{
+        PLPieceNode * l = NULL, * r = NULL, * middle = NULL;
+        PLPiece piece, prefix, suffix;
+        NSUInteger leftLength = 0;
+
+        if (node == NULL) {
+                *left = NULL;
+                *right = NULL;
+                return;
+        }
+        PLPieceNodeExpose(node, &l, &piece, &r);
+        leftLength = PLPieceNodeLength(l);
+        if (index <= leftLength) {
+                PLPieceNodeSplit(l, index, left, &middle);
+                *right = PLPieceNodeJoin(middle, piece, r);
+        } else if (index >= leftLength + piece.length) {
+                PLPieceNodeSplit(r, index - leftLength - piece.length, &middle, right);
+                *left = PLPieceNodeJoin(l, piece, middle);
+        } else {
+                PLPieceSplit(&piece, index - leftLength, &prefix, &suffix);
+                *left = PLPieceNodeJoin(l, prefix, NULL);
+                *right = PLPieceNodeJoin(NULL, suffix, r);
+        }
+}
+
+static unichar PLPieceNodeCharacterAtIndex(const PLPieceNode * node, NSUInteger index)
+{
+        NSUInteger leftLength = 0;
+
+        while (node) {
+                leftLength = PLPieceNodeLength(node->left);
+                if (index < leftLength) {
+                        node = node->left;
+                        continue;
+                }
+                index -= leftLength;
+                if (index < node->piece.length) {
+                        return PLPieceCharacterAtIndex(&node->piece, index);
+                }
+                index -= node->piece.length;
+                node = node->right;
+        }
+        return 0;
+}
+
+static void PLPieceNodeGetCharacters(const PLPieceNode * node, unichar * buffer, NSUInteger location, NSUInteger length)
+{
+        const uint8_t * bytes = NULL;
+        NSUInteger leftLength = 0, count = 0, index = 0;
+
+        while (node && length > 0) {
+                leftLength = PLPieceNodeLength(node->left);
+                if (location < leftLength) {
+                        count = MIN(length, leftLength - location);
+                        PLPieceNodeGetCharacters(node->left, buffer, location, count);
+                        buffer += count;
+                        location += count;
+                        length -= count;
+                        continue;
+                }
+                location -= leftLength;
+                if (location < node->piece.length) {
+                        count = MIN(length, node->piece.length - location);
+                        if (node->piece.narrow) {
+                                bytes = (const uint8_t *)node->piece.characters + location;
+                                for (index = 0; index < count; index++) {
+                                        buffer[index] = bytes[index];
+                                }
+                        } else {
+                                memcpy(buffer, (const unichar *)node->piece.characters + location, count * sizeof(unichar));
+                        }
+                        buffer += count;
+                        location += count;
+                        length -= count;
+                }
+                location -= node->piece.length;
+                node = node->right;
+        }
+}
+
+static NSUInteger PLPieceNodeIndexOfLine(const PLPieceNode * node, NSUInteger line)
+{
+        NSUInteger index = 0, leftLineFeeds = 0;
+
+        if (line == 0) {
+                return 0;
+        }
+        while (node) {
+                leftLineFeeds = PLPieceNodeLineFeeds(node->left);
+                if (line <= leftLineFeeds) {
+                        node = node->left;
+                        continue;
+                }
+                line -= leftLineFeeds;
+                index += PLPieceNodeLength(node->left);
+                if (line <= node->piece.lineFeeds) {
+                        return index + PLPieceIndexAfterLineFeed(&node->piece, line);
+                }
+                line -= node->piece.lineFeeds;
+                index += node->piece.length;
+                node = node->right;
+        }
+        return NSNotFound;
+}
+
+static NSUInteger PLPieceNodeLineForIndex(const PLPieceNode * node, NSUInteger index)
+{
+        NSUInteger line = 0, leftLength = 0;
+
+        while (node) {
+                leftLength = PLPieceNodeLength(node->left);
+                if (index < leftLength) {
+                        node = node->left;
+                        continue;
+                }
+                index -= leftLength;
+                line += PLPieceNodeLineFeeds(node->left);
+                if (index < node->piece.length) {
+                        return line + PLPieceCountLineFeeds(&node->piece, 0, index);
+                }
+                index -= node->piece.length;
+                line += node->piece.lineFeeds;
+                node = node->right;
+        }
+        return line;
+}
+
+#pragma mark - String
+
+@implementation PLPieceTableString
+
+/**
+ * \brief Initialize a string sharing a tree of pieces.
+ *
+ * \param aRoot The root of the tree, retained by the string.
+ *
+ * \param theBuffers The buffers the pieces refer to.
+ *
+ * \param isLive YES for the live string of a table.
+ *
+ * \return The initialized string.
+ */
+-(instancetype)initWithRoot:(PLPieceNode *)aRoot buffers:(NSArray *)theBuffers live:(BOOL)isLive
+{
+        self = [super init];
+        if (self) {
+                root = PLPieceNodeRetain(aRoot);
+                buffers = [theBuffers retain];
+                live = isLive;
+        }
+        return self;
+}
+
+-(void)dealloc
+{
+        PLPieceNodeRelease(root);
+        [buffers release];
+        [super dealloc];
+}
+
+/**
+ * \brief Replace the tree of the live string of a table after an edit.
+ *
+ * \param aRoot The root of the new tree.
+ */
+-(void)setRoot:(PLPieceNode *)aRoot
+{
+        PLPieceNodeRetain(aRoot);
+        PLPieceNodeRelease(root);
+        root = aRoot;
+}
+
+-(PLPieceNode *)root
+{
+        return root;
+}
+
+-(NSArray *)buffers
+{
+        return buffers;
+}
+
+/**
+ * \brief Return a snapshot of the string.
+ *
+ * \return The string itself, or a new snapshot for the live string.
+ */
+-(id)copyWithZone:(NSZone *)zone
+{
+        if (live) {
+                return [[PLPieceTableString alloc] initWithRoot:root buffers:buffers live:NO];
+        }
+        return [self retain];
+}
+
+#pragma mark - Primitives
+
+-(NSUInteger)length
+{
+        return PLPieceNodeLength(root);
+}
+
+-(unichar)characterAtIndex:(NSUInteger)index
+{
+        if (index >= PLPieceNodeLength(root)) {
+                [NSException raise:NSRangeException format:@"Index %lu out of bounds; string length %lu", (unsigned long)index, (unsigned long)PLPieceNodeLength(root)];
+        }
+        return PLPieceNodeCharacterAtIndex(root, index);
+}
+
+-(void)getCharacters:(unichar *)buffer range:(NSRange)range
+{
+        if (NSMaxRange(range) > PLPieceNodeLength(root)) {
+                [NSException raise:NSRangeException format:@"Range %@ out of bounds; string length %lu", NSStringFromRange(range), (unsigned long)PLPieceNodeLength(root)];
+        }
+        PLPieceNodeGetCharacters(root, buffer, range.location, range.length);
+}
+
+#pragma mark - Lines
+
+-(NSUInteger)lineCount
+{
+        return PLPieceNodeLineFeeds(root) + 1;
+}
+
+-(NSUInteger)indexOfLine:(NSUInteger)line
+{
+        return PLPieceNodeIndexOfLine(root, line);
+}
+
+-(NSUInteger)lineForIndex:(NSUInteger)index
+{
+        return PLPieceNodeLineForIndex(root, MIN(index, PLPieceNodeLength(root)));
+}
+
+@end
+
+#pragma mark - Table
+
+@implementation PLPieceTable
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        return [self initWithString:@""];
+}
+
+-(instancetype)initWithString:(NSString *)aString
+{
+        self = [super init];
+        if (self) {
+                buffers = [[NSMutableArray alloc] init];
+                if ([aString isKindOfClass:[PLPieceTableString class]]) {
+                        root = PLPieceNodeRetain([(PLPieceTableString *)aString root]);
+                        [buffers addObjectsFromArray:[(PLPieceTableString *)aString buffers]];
+                } else {
+                        root = [self treeWithString:aString];
+                }
+                string = [[PLPieceTableString alloc] initWithRoot:root buffers:buffers live:YES];
+        }
+        return self;
+}
+
+-(instancetype)initWithUTF8Data:(NSData *)data preambleLength:(NSUInteger)preambleLength
+{
+        const uint8_t * bytes = [data bytes];
+        NSUInteger length = [data length], offset = preambleLength, end = 0, index = 0;
+        NSUInteger carriageReturns = 0, nonASCII = 0;
+        NSMutableString * decoded = nil;
+        NSMutableData * block = nil;
+        PLPiece piece;
+
+        self = [super init];
+        if (self == nil) {
+                goto exit;
+        }
+        buffers = [[NSMutableArray alloc] initWithObjects:data, nil];
+        while (offset < length) {
+                end = MIN(offset + PLPieceTableChunkLength, length);
+                while (end < length && end > offset + 1 && (bytes[end] & 0xC0) == 0x80) {
+                        end--;
+                }
+                if (end < length && end > offset + 1 && bytes[end - 1] == '\r' && bytes[end] == '\n') {
+                        end--;
+                }
+                piece.characters = bytes + offset;
+                piece.length = end - offset;
+                piece.lineFeeds = 0;
+                piece.narrow = YES;
+                carriageReturns = 0;
+                nonASCII = 0;
+                for (index = offset; index < end; index++) {
+                        piece.lineFeeds += (bytes[index] == '\n');
+                        carriageReturns += (bytes[index] == '\r');
+                        nonASCII |= bytes[index];
+                }
+                if (carriageReturns > 0 || (nonASCII & 0x80)) {
+                        decoded = [[NSMutableString alloc] initWithBytes:bytes + offset length:end - offset encoding:NSUTF8StringEncoding];
+                        if (decoded == nil) {
+                                [self release];
+                                self = nil;
+                                goto exit;
+                        }
+                        [decoded replaceOccurrencesOfString:@"\r\n" withString:@"\n" options:NSLiteralSearch range:NSMakeRange(0, [decoded length])];
+                        [decoded replaceOccurrencesOfString:@"\r" withString:@"\n" options:NSLiteralSearch range:NSMakeRange(0, [decoded length])];
+                        block = [NSMutableData dataWithLength:[decoded length] * sizeof(unichar)];
+                        [decoded getCharacters:[block mutableBytes] range:NSMakeRange(0, [decoded length])];
+                        [buffers addObject:block];
+                        piece.characters = [block mutableBytes];
+                        piece.length = [decoded length];
+                        piece.lineFeeds = PLPieceCountLineFeeds(&piece, 0, piece.length);
+                        piece.narrow = NO;
+                        [decoded release];
+                }
+                if (piece.length > 0) {
+                        root = PLPieceNodeJoin(root, piece, NULL);
+                }
+                offset = end;
+        }
+        string = [[PLPieceTableString alloc] initWithRoot:root buffers:buffers live:YES];
+
+exit:
+        return self;
+}
+
+-(void)dealloc
+{
+        PLPieceNodeRelease(root);
+        [buffers release];
+        [string release];
+        [snapshot release];
+        [super dealloc];
+}
+
+#pragma mark - Text
+
+-(NSUInteger)length
+{
+        return PLPieceNodeLength(root);
+}
+
+-(PLPieceTableString *)snapshot
+{
+        if (snapshot == nil) {
+                snapshot = [[PLPieceTableString alloc] initWithRoot:root buffers:buffers live:NO];
+        }
+        return snapshot;
+}
+
+/**
+ * \brief Append characters to the append buffer and build a tree of their
+ *        pieces.
+ *
+ * \details A new block is started when the current one is full, so no piece
+ *          spans two blocks.
+ *
+ * \param aString The characters.
+ *
+ * \return The root of the tree, or NULL if the string is empty.
+ */
+-(PLPieceNode *)treeWithString:(NSString *)aString
+{
+        PLPieceNode * tree = NULL;
+        NSMutableData * block = nil;
+        NSUInteger length = [aString length], location = 0, count = 0;
+        PLPiece piece;
+
+        while (location < length) {
+                if (appendBlock == NULL || appendBlockLength == PLPieceTableBlockLength) {
+                        block = [NSMutableData dataWithLength:PLPieceTableBlockLength * sizeof(unichar)];
+                        [buffers addObject:block];
+                        appendBlock = [block mutableBytes];
+                        appendBlockLength = 0;
+                }
+                count = MIN(length - location, PLPieceTableBlockLength - appendBlockLength);
+                [aString getCharacters:appendBlock + appendBlockLength range:NSMakeRange(location, count)];
+                piece.characters = appendBlock + appendBlockLength;
+                piece.length = count;
+                piece.narrow = NO;
+                piece.lineFeeds = PLPieceCountLineFeeds(&piece, 0, count);
+                tree = PLPieceNodeJoin(tree, piece, NULL);
+                appendBlockLength += count;
+                location += count;
+        }
+        return tree;
+}
+
+/**
+ * \brief Insert characters, extending the piece before them if it ends where
+ *        they are appended, as it does while typing.
+ *
+ * \param aString The characters.
+ *
+ * \param index The index to insert them at.
+ */
+-(void)insertString:(NSString *)aString atIndex:(NSUInteger)index
+{
+        PLPieceNode * left = NULL, * right = NULL;
+        NSUInteger length = [aString length];
+        PLPiece lastPiece, appended;
+        BOOL extended = NO;
+
+        PLPieceNodeSplit(root, index, &left, &right);
+        if (left && appendBlock && appendBlockLength > 0 && length <= PLPieceTableBlockLength - appendBlockLength) {
+                left = PLPieceNodeSplitLast(left, &lastPiece);
+                if (lastPiece.narrow == NO && (const unichar *)lastPiece.characters + lastPiece.length == appendBlock + appendBlockLength) {
+                        [aString getCharacters:appendBlock + appendBlockLength range:NSMakeRange(0, length)];
+                        appended.characters = appendBlock + appendBlockLength;
+                        appended.length = length;
+                        appended.narrow = NO;
+                        lastPiece.length += length;
+                        lastPiece.lineFeeds += PLPieceCountLineFeeds(&appended, 0, length);
+                        appendBlockLength += length;
+                        extended = YES;
+                }
+                left = PLPieceNodeJoin(left, lastPiece, NULL);
+        }
+        if (extended == NO) {
+                left = PLPieceNodeConcatenate(left, [self treeWithString:aString]);
+        }
+        root = PLPieceNodeConcatenate(left, right);
+}
+
+-(void)replaceCharactersInRange:(NSRange)range withString:(NSString *)aString
+{
+        PLPieceNode * left = NULL, * middle = NULL, * right = NULL;
+
+        if (NSMaxRange(range) > PLPieceNodeLength(root)) {
+                [NSException raise:NSRangeException format:@"Range %@ out of bounds; string length %lu", NSStringFromRange(range), (unsigned long)PLPieceNodeLength(root)];
+        }
+        if (range.length > 0) {
+                PLPieceNodeSplit(root, range.location, &left, &middle);
+                PLPieceNodeSplit(middle, range.length, &middle, &right);
+                PLPieceNodeRelease(middle);
+                root = PLPieceNodeConcatenate(left, right);
+        }
+        if ([aString length] > 0) {
+                [self insertString:aString atIndex:range.location];
+        }
+        [string setRoot:root];
+        [snapshot release];
+        snapshot = nil;
+}
+
+@end
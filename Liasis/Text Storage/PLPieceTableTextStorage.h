@@ -0,0 +1,89 @@
+/**
+ * \file PLPieceTableTextStorage.h
+ *
+ * \brief Liasis Python IDE piece table text storage.
+ *
+ * \details This file includes the text storage keeping its characters in a
+ *          piece table.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+#import "PLPieceTable.h"
+
+/**
+ * \brief A node of the tree of attribute runs.
+ */
+struct PLAttributeRunNode;
+
+/**
+ * \class PLPieceTableTextStorage \headerfile \headerfile
+ *
+ * \brief A text storage keeping its characters in a `PLPieceTable`.
+ *
+ * \details Editing the text never moves the characters after the edit, so
+ *          typing near the start of a large file or replacing every match
+ *          costs time in the size of each edit rather than of the file.
+ *
+ *          `string` is the live string of the table. Copying it is how
+ *          background work takes a snapshot of the text, which is constant
+ *          time and shares the characters with the storage.
+ *
+ *          Attributes are kept in a balanced tree of runs. Each run records
+ *          its length rather than its location, and each node the length of
+ *          its subtree, so an edit splits and joins the tree along one path
+ *          in time logarithmic in the number of runs, leaving the runs after
+ *          it untouched.
+ */
+@interface PLPieceTableTextStorage : NSTextStorage
+{
+        /**
+         * \brief The characters.
+         */
+        PLPieceTable * pieceTable;
+
+        /**
+         * \brief The root of the tree of attribute runs, covering the text,
+         *        or NULL if the text is empty.
+         */
+        struct PLAttributeRunNode * runs;
+}
+
+/**
+ * \brief Create a text storage with the text of a `PLPieceTableString`.
+ *
+ * \details The storage shares the pieces of the string, so creating it from a
+ *          memory mapped file does not read the file.
+ *
+ * \param aString The text, which need not be a `PLPieceTableString`.
+ *
+ * \return A text storage on the autorelease pool.
+ */
++(instancetype)textStorageWithString:(NSString *)aString;
+
+/**
+ * \brief The piece table holding the characters.
+ */
+@property (readonly) PLPieceTable * pieceTable;
+
+@end
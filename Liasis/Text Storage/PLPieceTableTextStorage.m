@@ -0,0 +1,492 @@
+/**
+ * \file PLPieceTableTextStorage.m
+ *
+ * \brief Liasis Python IDE piece table text storage.
+ *
+ * \details This file includes the text storage keeping its characters in a
+ *          piece table.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLPieceTableTextStorage.h"
+#include <stdlib.h>
+
+#pragma mark - Attribute Runs
+
+/**
+ * \brief A run of characters with the same attributes.
+ */
+typedef struct PLAttributeRun {
+        NSUInteger length;
+        NSDictionary * attributes;
+} PLAttributeRun;
+
+/**
+ * \brief A node of the balanced tree of attribute runs.
+ *
+ * \details Nodes are owned by one storage, and own the attributes of their
+ *          run.
+ */
+typedef struct PLAttributeRunNode {
+        struct PLAttributeRunNode * left;
+        struct PLAttributeRunNode * right;
+        PLAttributeRun run;
+        NSUInteger length;
+        int32_t height;
+} PLAttributeRunNode;
+
+static inline int32_t PLAttributeRunNodeHeight(const PLAttributeRunNode * node)
+{
+        return node ? node->height : 0;
+}
+
+static inline NSUInteger PLAttributeRunNodeLength(const PLAttributeRunNode * node)
+{
+        return node ? node->length : 0;
+}
+
+/**
+ * \brief Check if a run has attributes equal to a dictionary.
+ */
+static inline BOOL PLAttributeRunHasAttributes(const PLAttributeRun * run, NSDictionary * attributes)
+{
+        return run->attributes == attributes || [run->attributes isEqualToDictionary:attributes];
+}
+
+/**
+ * \brief Free a tree and release the attributes of its runs.
+ */
+static void PLAttributeRunNodeDestroy(PLAttributeRunNode * node)
+{
+        if (node) {
+                PLAttributeRunNodeDestroy(node->left);
+                PLAttributeRunNodeDestroy(node->right);
+                [node->run.attributes release];
+                free(node);
+        }
+}
+
+/**
+ * \brief Create a node, taking ownership of its children and the attributes of
+ *        its run.
+ */
+static PLAttributeRunNode * PLAttributeRunNodeCreate(PLAttributeRun run, PLAttributeRunNode * left, PLAttributeRunNode * right)
+{
+        PLAttributeRunNode * node = malloc(sizeof(PLAttributeRunNode));
+
+        node->left = left;
+        node->right = right;
+        node->run = run;
+        node->length = PLAttributeRunNodeLength(left) + run.length + PLAttributeRunNodeLength(right);
+        node->height = 1 + MAX(PLAttributeRunNodeHeight(left), PLAttributeRunNodeHeight(right));
+        return node;
+}
+
+/**
+ * \brief Take the children and run of a node, freeing the node.
+ */
+static void PLAttributeRunNodeExpose(PLAttributeRunNode * node, PLAttributeRunNode ** left, PLAttributeRun * run, PLAttributeRunNode ** right)
+{
+        *left = node->left;
+        *right = node->right;
+        *run = node->run;
+        free(node);
+}
+
+static PLAttributeRunNode * PLAttributeRunNodeRotateLeft(PLAttributeRunNode * node)
+{
+        PLAttributeRunNode * a = NULL, * right = NULL, * b = NULL, * c = NULL;
+        PLAttributeRun run, rightRun;
+
+        PLAttributeRunNodeExpose(node, &a, &run, &right);
+        PLAttributeRunNodeExpose(right, &b, &rightRun, &c);
+        return PLAttributeRunNodeCreate(rightRun, PLAttributeRunNodeCreate(run, a, b), c);
+}
+
+static PLAttributeRunNode * PLAttributeRunNodeRotateRight(PLAttributeRunNode * node)
+{
+        PLAttributeRunNode * left = NULL, * a = NULL, * b = NULL, * c = NULL;
+        PLAttributeRun run, leftRun;
+
+        PLAttributeRunNodeExpose(node, &left, &run, &c);
+        PLAttributeRunNodeExpose(left, &a, &leftRun, &b);
+        return PLAttributeRunNodeCreate(leftRun, a, PLAttributeRunNodeCreate(run, b, c));
+}
+
+static PLAttributeRunNode * PLAttributeRunNodeJoinRight(PLAttributeRunNode * left, PLAttributeRun run, PLAttributeRunNode * right)
+{
+        PLAttributeRunNode * ll = NULL, * lr = NULL, * tree = NULL;
+        PLAttributeRun leftRun;
+        int32_t height = 0;
+
+        PLAttributeRunNodeExpose(left, &ll, &leftRun, &lr);
+        if (PLAttributeRunNodeHeight(lr) <= PLAttributeRunNodeHeight(right) + 1) {
+                tree = PLAttributeRunNodeCreate(run, lr, right);
+                if (tree->height <= PLAttributeRunNodeHeight(ll) + 1) {
+                        return PLAttributeRunNodeCreate(leftRun, ll, tree);
+                }
+                return PLAttributeRunNodeRotateLeft(PLAttributeRunNodeCreate(leftRun, ll, PLAttributeRunNodeRotateRight(tree)));
+        }
+        tree = PLAttributeRunNodeJoinRight(lr, run, right);
+        height = tree->height;
+        tree = PLAttributeRunNodeCreate(leftRun, ll, tree);
+        return (height <= PLAttributeRunNodeHeight(ll) + 1) ? tree : PLAttributeRunNodeRotateLeft(tree);
+}
+
+static PLAttributeRunNode * PLAttributeRunNodeJoinLeft(PLAttributeRunNode * left, PLAttributeRun run, PLAttributeRunNode * right)
+{
+        PLAttributeRunNode * rl = NULL, * rr = NULL, * tree = NULL;
+        PLAttributeRun rightRun;
+        int32_t height = 0;
+
+        PLAttributeRunNodeExpose(right, &rl, &rightRun, &rr);
+        if (PLAttributeRunNodeHeight(rl) <= PLAttributeRunNodeHeight(left) + 1) {
+                tree = PLAttributeRunNodeCreate(run, left, rl);
+                if (tree->height <= PLAttributeRunNodeHeight(rr) + 1) {
+                        return PLAttributeRunNodeCreate(rightRun, tree, rr);
+                }
+                return PLAttributeRunNodeRotateRight(PLAttributeRunNodeCreate(rightRun, PLAttributeRunNodeRotateLeft(tree), rr));
+        }
+        tree = PLAttributeRunNodeJoinLeft(left, run, rl);
+        height = tree->height;
+        tree = PLAttributeRunNodeCreate(rightRun, tree, rr);
+        return (height <= PLAttributeRunNodeHeight(rr) + 1) ? tree : PLAttributeRunNodeRotateRight(tree);
+}
+
+/**
+ * \brief Join two trees with a run between them, taking ownership of both.
+ */
+static PLAttributeRunNode * PLAttributeRunNodeJoin(PLAttributeRunNode * left, PLAttributeRun run, PLAttributeRunNode * right)
+{
+        if (PLAttributeRunNodeHeight(left) > PLAttributeRunNodeHeight(right) + 1) {
+                return PLAttributeRunNodeJoinRight(left, run, right);
+        }
+        if (PLAttributeRunNodeHeight(right) > PLAttributeRunNodeHeight(left) + 1) {
+                return PLAttributeRunNodeJoinLeft(left, run, right);
+        }
+        return PLAttributeRunNodeCreate(run, left, right);
+}
+
+/**
+ * \brief Remove the first run of a tree, taking ownership of the tree.
+ */
+static PLAttributeRunNode * PLAttributeRunNodeSplitFirst(PLAttributeRunNode * node, PLAttributeRun * firstRun)
+{
+        PLAttributeRunNode * left = NULL, * right = NULL;
+        PLAttributeRun run;
+
+        PLAttributeRunNodeExpose(node, &left, &run, &right);
+        if (left == NULL) {
+                *firstRun = run;
+                return right;
+        }
+        return PLAttributeRunNodeJoin(PLAttributeRunNodeSplitFirst(left, firstRun), run, right);
+}
+
+/**
+ * \brief Remove the last run of a tree, taking ownership of the tree.
+ */
+static PLAttributeRunNode * PLAttributeRunNodeSplitLast(PLAttributeRunNode * node, PLAttributeRun * lastRun)
+{
+        PLAttributeRunNode * left = NULL, * right = NULL;
+        PLAttributeRun run;
+
+        PLAttributeRunNodeExpose(node, &left, &run, &right);
+        if (right == NULL) {
+                *lastRun = run;
+                return left;
+        }
+        return PLAttributeRunNodeJoin(left, run, PLAttributeRunNodeSplitLast(right, lastRun));
+}
+
+/**
+ * \brief Join two trees with a run between them, merging the run with the
+ *        neighbouring runs that have equal attributes.
+ *
+ * \details Takes ownership of both trees and the attributes of the run.
+ */
+static PLAttributeRunNode * PLAttributeRunNodeJoinMerging(PLAttributeRunNode * left, PLAttributeRun run, PLAttributeRunNode * right)
+{
+        const PLAttributeRunNode * node = NULL;
+        PLAttributeRun neighbour;
+
+        node = left;
+        while (node && node->right) {
+                node = node->right;
+        }
+        if (node && PLAttributeRunHasAttributes(&node->run, run.attributes)) {
+                left = PLAttributeRunNodeSplitLast(left, &neighbour);
+                run.length += neighbour.length;
+                [neighbour.attributes release];
+        }
+        node = right;
+        while (node && node->left) {
+                node = node->left;
+        }
+        if (node && PLAttributeRunHasAttributes(&node->run, run.attributes)) {
+                right = PLAttributeRunNodeSplitFirst(right, &neighbour);
+                run.length += neighbour.length;
+                [neighbour.attributes release];
+        }
+        return PLAttributeRunNodeJoin(left, run, right);
+}
+
+/**
+ * \brief Concatenate two trees, merging the runs where they meet if their
+ *        attributes are equal, taking ownership of both.
+ */
+static PLAttributeRunNode * PLAttributeRunNodeConcatenate(PLAttributeRunNode * left, PLAttributeRunNode * right)
+{
+        PLAttributeRun run;
+
+        if (left == NULL) {
+                return right;
+        }
+        if (right == NULL) {
+                return left;
+        }
+        left = PLAttributeRunNodeSplitLast(left, &run);
+        return PLAttributeRunNodeJoinMerging(left, run, right);
+}
+
+/**
+ * \brief Split a tree at a character index, taking ownership of the tree.
+ *
+ * \details A run containing the index is split in two with the same
+ *          attributes.
+ */
+static void PLAttributeRunNodeSplit(PLAttributeRunNode * node, NSUInteger index, PLAttributeRunNode ** left, PLAttributeRunNode ** right)
+{
+        PLAttributeRunNode * l = NULL, * r = NULL, * middle = NULL;
+        PLAttributeRun run, prefix, suffix;
+        NSUInteger leftLength = 0;
+
+        if (node == NULL) {
+                *left = NULL;
+                *right = NULL;
+                return;
+        }
+        PLAttributeRunNodeExpose(node, &l, &run, &r);
+        leftLength = PLAttributeRunNodeLength(l);
+        if (index <= leftLength) {
+                PLAttributeRunNodeSplit(l, index, left, &middle);
+                *right = PLAttributeRunNodeJoin(middle, run, r);
+        } else if (index >= leftLength + run.length) {
+                PLAttributeRunNodeSplit(r, index - leftLength - run.length, &middle, right);
+                *left = PLAttributeRunNodeJoin(l, run, middle);
+        } else {
+                prefix.length = index - leftLength;
+                prefix.attributes = run.attributes;
+                suffix.length = run.length - prefix.length;
+                suffix.attributes = [run.attributes retain];
+                *left = PLAttributeRunNodeJoin(l, prefix, NULL);
+                *right = PLAttributeRunNodeJoin(NULL, suffix, r);
+        }
+}
+
+/**
+ * \brief Find the run containing a character.
+ *
+ * \param location The index of the character, less than the length of the
+ *                 tree.
+ *
+ * \param runLocation Set to the location of the first character of the run.
+ *
+ * \return The node of the run.
+ */
+static const PLAttributeRunNode * PLAttributeRunNodeFind(const PLAttributeRunNode * node, NSUInteger location, NSUInteger * runLocation)
+{
+        NSUInteger start = 0, leftLength = 0;
+
+        while (node) {
+                leftLength = PLAttributeRunNodeLength(node->left);
+                if (location < leftLength) {
+                        node = node->left;
+                        continue;
+                }
+                location -= leftLength;
+                start += leftLength;
+                if (location < node->run.length) {
+                        break;
+                }
+                location -= node->run.length;
+                start += node->run.length;
+                node = node->right;
+        }
+        *runLocation = start;
+        return node;
+}
+
+#pragma mark -
+
+@implementation PLPieceTableTextStorage
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        return [self initWithString:@"" attributes:nil];
+}
+
+-(instancetype)initWithString:(NSString *)aString
+{
+        return [self initWithString:aString attributes:nil];
+}
+
+-(instancetype)initWithString:(NSString *)aString attributes:(NSDictionary *)attributes
+{
+        PLAttributeRun run;
+
+        self = [super init];
+        if (self) {
+                pieceTable = [[PLPieceTable alloc] initWithString:aString];
+                if ([pieceTable length] > 0) {
+                        run.length = [pieceTable length];
+                        run.attributes = attributes ? [attributes copy] : [[NSDictionary alloc] init];
+                        runs = PLAttributeRunNodeCreate(run, NULL, NULL);
+                }
+        }
+        return self;
+}
+
++(instancetype)textStorageWithString:(NSString *)aString
+{
+        return [[[self alloc] initWithString:aString attributes:nil] autorelease];
+}
+
+-(void)dealloc
+{
+        PLAttributeRunNodeDestroy(runs);
+        [pieceTable release];
+        [super dealloc];
+}
+
+#pragma mark - Attribute Runs
+
+/**
+ * \brief Replace the runs of a range of characters with one run.
+ *
+ * \details The run is merged with its neighbours if their attributes are
+ *          equal, so no two neighbouring runs ever have equal attributes.
+ *
+ * \param range The range of characters whose runs are removed.
+ *
+ * \param run The run replacing them, or a run of length 0 for none. The
+ *            storage takes ownership of its attributes.
+ */
+-(void)replaceRunsInRange:(NSRange)range withRun:(PLAttributeRun)run
+{
+        PLAttributeRunNode * left = NULL, * middle = NULL, * right = NULL;
+
+        PLAttributeRunNodeSplit(runs, range.location, &left, &right);
+        PLAttributeRunNodeSplit(right, range.length, &middle, &right);
+        PLAttributeRunNodeDestroy(middle);
+        if (run.length > 0) {
+                runs = PLAttributeRunNodeJoinMerging(left, run, right);
+        } else {
+                [run.attributes release];
+                runs = PLAttributeRunNodeConcatenate(left, right);
+        }
+}
+
+#pragma mark - Primitives
+
+-(NSString *)string
+{
+        return [pieceTable string];
+}
+
+-(PLPieceTable *)pieceTable
+{
+        return pieceTable;
+}
+
+-(NSDictionary *)attributesAtIndex:(NSUInteger)location effectiveRange:(NSRangePointer)range
+{
+        NSUInteger length = [pieceTable length], runLocation = 0;
+        const PLAttributeRunNode * node = NULL;
+
+        if (location >= length) {
+                [NSException raise:NSRangeException format:@"Location %lu out of bounds; string length %lu", (unsigned long)location, (unsigned long)length];
+        }
+        node = PLAttributeRunNodeFind(runs, location, &runLocation);
+        if (range) {
+                *range = NSMakeRange(runLocation, node->run.length);
+        }
+        return node->run.attributes;
+}
+
+/**
+ * \brief Replace characters, giving the new characters the attributes of the
+ *        first replaced character, or of the character before them if none
+ *        are replaced.
+ *
+ * \param range The range of characters replaced.
+ *
+ * \param aString The characters replacing them.
+ */
+-(void)replaceCharactersInRange:(NSRange)range withString:(NSString *)aString
+{
+        NSUInteger length = [pieceTable length], insertedLength = [aString length], runLocation = 0;
+        NSDictionary * attributes = nil;
+        PLAttributeRun run;
+
+        if (NSMaxRange(range) > length) {
+                [NSException raise:NSRangeException format:@"Range %@ out of bounds; string length %lu", NSStringFromRange(range), (unsigned long)length];
+        }
+        if (runs) {
+                if (range.location < length && (range.length > 0 || range.location == 0)) {
+                        attributes = PLAttributeRunNodeFind(runs, range.location, &runLocation)->run.attributes;
+                } else {
+                        attributes = PLAttributeRunNodeFind(runs, range.location - 1, &runLocation)->run.attributes;
+                }
+        }
+        run.length = insertedLength;
+        run.attributes = attributes ? [attributes retain] : [[NSDictionary alloc] init];
+        [self replaceRunsInRange:range withRun:run];
+
+        [pieceTable replaceCharactersInRange:range withString:aString];
+        [self edited:NSTextStorageEditedCharacters range:range changeInLength:(NSInteger)insertedLength - (NSInteger)range.length];
+}
+
+-(void)setAttributes:(NSDictionary *)attributes range:(NSRange)range
+{
+        NSUInteger length = [pieceTable length];
+        PLAttributeRun run;
+
+        if (NSMaxRange(range) > length) {
+                [NSException raise:NSRangeException format:@"Range %@ out of bounds; string length %lu", NSStringFromRange(range), (unsigned long)length];
+        }
+        if (range.length == 0) {
+                goto exit;
+        }
+        run.length = range.length;
+        run.attributes = attributes ? [attributes copy] : [[NSDictionary alloc] init];
+        [self replaceRunsInRange:range withRun:run];
+        [self edited:NSTextStorageEditedAttributes range:range changeInLength:0];
+
+exit:
+        return;
+}
+
+@end
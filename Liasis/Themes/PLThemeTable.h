@@ -0,0 +1,174 @@
+/**
+ * \file PLThemeTable.h
+ *
+ * \brief Liasis Python IDE compiled theme table.
+ *
+ * \details This file includes the table of resolved theme colors shared by the
+ *          views of the application.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <Cocoa/Cocoa.h>
+#import <LiasisKit/LiasisKit.h>
+
+/**
+ * \brief Posted at most once per pass of the run loop after the theme changed.
+ *
+ * \details The notification object is the `PLThemeTable`. Any number of
+ *          `PLThemeManagerDidChange` notifications posted while handling one
+ *          event are coalesced into one.
+ */
+extern NSString * const PLThemeTableDidChangeNotification;
+
+/**
+ * \brief The colors resolved by a `PLThemeTable`.
+ */
+typedef NS_ENUM(NSUInteger, PLThemeColor) {
+        /**
+         * \brief The background color of the settings group.
+         */
+        PLThemeColorBackground = 0,
+
+        /**
+         * \brief The foreground color of the settings group.
+         */
+        PLThemeColorForeground,
+
+        /**
+         * \brief The selection color of the settings group.
+         */
+        PLThemeColorSelection,
+
+        /**
+         * \brief The color of text drawn over the selection color.
+         */
+        PLThemeColorSelectionText,
+
+        /**
+         * \brief The foreground color of the Comment group.
+         */
+        PLThemeColorComment,
+
+        /**
+         * \brief The foreground color of the String group.
+         */
+        PLThemeColorString,
+
+        /**
+         * \brief The foreground color of the Docstring group.
+         */
+        PLThemeColorDocstring,
+
+        /**
+         * \brief The foreground color of the Number group.
+         */
+        PLThemeColorNumber,
+
+        /**
+         * \brief The foreground color of the Keyword group.
+         */
+        PLThemeColorKeyword,
+
+        /**
+         * \brief The foreground color of the Built-in constant group.
+         */
+        PLThemeColorBuiltinConstant,
+
+        /**
+         * \brief The foreground color of the Class name group.
+         */
+        PLThemeColorClassName,
+
+        /**
+         * \brief The foreground color of the Function name group.
+         */
+        PLThemeColorFunctionName,
+
+        /**
+         * \brief The number of colors in the table.
+         */
+        PLThemeColorCount
+};
+
+/**
+ * \class PLThemeTable \headerfile \headerfile
+ *
+ * \brief A flat table of the colors and gradients of the current theme.
+ *
+ * \details `PLThemeManager` resolves each property by looking up its group and
+ *          name in the theme. The table asks for every property the
+ *          application draws with once per theme, and stores the results in an
+ *          array indexed by `PLThemeColor`, so drawing code, which may run for
+ *          every row of a view, only indexes the array.
+ *
+ *          The syntax colors fall back to the foreground color when the theme
+ *          has no color for their group.
+ *
+ *          The table is compiled lazily on its first use after the theme
+ *          changed. Views should observe `PLThemeTableDidChangeNotification`
+ *          instead of `PLThemeManagerDidChange`.
+ *
+ *          The table must only be used from the main thread.
+ */
+@interface PLThemeTable : NSObject
+{
+        /**
+         * \brief The resolved colors, indexed by `PLThemeColor`.
+         */
+        NSColor * colors[PLThemeColorCount];
+
+        /**
+         * \brief The gradient used to highlight selections.
+         */
+        NSGradient * selectionGradient;
+
+        /**
+         * \brief YES when the theme changed since the table was compiled.
+         */
+        BOOL stale;
+}
+
+/**
+ * \brief The shared theme table.
+ *
+ * \return The theme table of the application.
+ */
++(instancetype)sharedThemeTable;
+
+/**
+ * \brief Return a color of the current theme.
+ *
+ * \param color The color. Must be less than `PLThemeColorCount`.
+ *
+ * \return The resolved color.
+ */
+-(NSColor *)color:(PLThemeColor)color;
+
+/**
+ * \brief Return the gradient used to highlight selections.
+ *
+ * \return The resolved gradient.
+ */
+-(NSGradient *)selectionGradient;
+
+@end
@@ -0,0 +1,160 @@
+/**
+ * \file PLThemeTable.m
+ *
+ * \brief Liasis Python IDE compiled theme table.
+ *
+ * \details This file includes the table of resolved theme colors shared by the
+ *          views of the application.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import "PLThemeTable.h"
+
+NSString * const PLThemeTableDidChangeNotification = @"PLThemeTableDidChangeNotification";
+
+@implementation PLThemeTable
+
+#pragma mark - Object Lifecycle
+
+-(instancetype)init
+{
+        self = [super init];
+        if (self) {
+                stale = YES;
+                [[NSNotificationCenter defaultCenter] addObserver:self
+                                                         selector:@selector(themeManagerDidChange:)
+                                                             name:PLThemeManagerDidChange
+                                                           object:nil];
+        }
+        return self;
+}
+
++(instancetype)sharedThemeTable
+{
+        static PLThemeTable * sharedThemeTable = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+                sharedThemeTable = [[self alloc] init];
+        });
+        return sharedThemeTable;
+}
+
+-(void)dealloc
+{
+        NSUInteger index = 0;
+
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        for (index = 0; index < PLThemeColorCount; index++) {
+                [colors[index] release];
+        }
+        [selectionGradient release];
+        [super dealloc];
+}
+
+#pragma mark - Compiling
+
+/**
+ * \brief Mark the table stale and post one
+ *        `PLThemeTableDidChangeNotification` when the run loop is next free.
+ *
+ * \param notification The `PLThemeManagerDidChange` notification.
+ */
+-(void)themeManagerDidChange:(NSNotification *)notification
+{
+        stale = YES;
+        [[NSNotificationQueue defaultQueue] enqueueNotification:[NSNotification notificationWithName:PLThemeTableDidChangeNotification
+                                                                                              object:self]
+                                                   postingStyle:NSPostASAP
+                                                   coalesceMask:(NSNotificationCoalescingOnName | NSNotificationCoalescingOnSender)
+                                                       forModes:nil];
+}
+
+/**
+ * \brief Set a color of the table.
+ *
+ * \param color The color to set.
+ *
+ * \param value The resolved color.
+ */
+-(void)setColor:(PLThemeColor)color toValue:(NSColor *)value
+{
+        [value retain];
+        [colors[color] release];
+        colors[color] = value;
+}
+
+/**
+ * \brief Resolve every property of the table from `PLThemeManager` if the
+ *        theme changed since it was last compiled.
+ */
+-(void)compileIfNeeded
+{
+        static NSString * const syntaxGroups[] = {
+                [PLThemeColorComment] = @"Comment",
+                [PLThemeColorString] = @"String",
+                [PLThemeColorDocstring] = @"Docstring",
+                [PLThemeColorNumber] = @"Number",
+                [PLThemeColorKeyword] = @"Keyword",
+                [PLThemeColorBuiltinConstant] = @"Built-in constant",
+                [PLThemeColorClassName] = @"Class name",
+                [PLThemeColorFunctionName] = @"Function name",
+        };
+        PLThemeManager * themeManager = nil;
+        NSColor * syntaxColor = nil;
+        PLThemeColor color = PLThemeColorComment;
+
+        if (stale == NO) {
+                goto exit;
+        }
+        themeManager = [PLThemeManager defaultThemeManager];
+        [self setColor:PLThemeColorBackground toValue:[themeManager getThemeProperty:PLThemeManagerBackground fromGroup:PLThemeManagerSettings]];
+        [self setColor:PLThemeColorForeground toValue:[themeManager getThemeProperty:PLThemeManagerForeground fromGroup:PLThemeManagerSettings]];
+        [self setColor:PLThemeColorSelection toValue:[themeManager getThemeProperty:PLThemeManagerSelection fromGroup:PLThemeManagerSettings]];
+        [self setColor:PLThemeColorSelectionText toValue:[NSColor colorWithInvertedRedGreenBlueComponents:colors[PLThemeColorSelection]]];
+        for (color = PLThemeColorComment; color < PLThemeColorCount; color++) {
+                syntaxColor = [themeManager getThemeProperty:PLThemeManagerForeground fromGroup:syntaxGroups[color]];
+                [self setColor:color toValue:syntaxColor ?: colors[PLThemeColorForeground]];
+        }
+        [selectionGradient release];
+        selectionGradient = [[themeManager selectionGradient] retain];
+        stale = NO;
+
+exit:
+        return;
+}
+
+#pragma mark - Querying
+
+-(NSColor *)color:(PLThemeColor)color
+{
+        [self compileIfNeeded];
+        return colors[color];
+}
+
+-(NSGradient *)selectionGradient
+{
+        [self compileIfNeeded];
+        return selectionGradient;
+}
+
+@end
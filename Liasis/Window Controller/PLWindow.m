@@ -25,9 +25,24 @@
  */
 
 #import "PLWindow.h"
+#import "PLLaunchTimeline.h"
 
 @implementation PLWindow
 
+/**
+ * \brief Record the first key down event of the application in the launch
+ *        timeline.
+ *
+ * \param theEvent The event to dispatch.
+ */
+-(void)sendEvent:(NSEvent *)theEvent
+{
+        if ([theEvent type] == NSKeyDown && [[PLLaunchTimeline sharedTimeline] isRecording]) {
+                [[PLLaunchTimeline sharedTimeline] recordFirstKeystroke];
+        }
+        [super sendEvent:theEvent];
+}
+
 /**
  * \brief Forward first responder status to the delegate if its delegate is an
  *        `NSResponder`.
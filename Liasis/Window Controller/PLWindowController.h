@@ -31,6 +31,11 @@
 #import "PLTabViewController.h"
 #import "PLFileBrowserViewController.h"
 #import "PLSplitViewController.h"
+#import "PLOpenQuicklyWindowController.h"
+#import "PLProjectSearchViewController.h"
+#import "PLSymbolIndex.h"
+#import "PLAddOnLoader.h"
+#import "PLSessionWindow.h"
 
 /**
  * \class PLWindowController \headerfile \headerfile
@@ -57,6 +62,24 @@
          * \brief The file browser view controller.
          */
         PLFileBrowserViewController <PLThemeable> * fileBrowserViewController;
+
+        /**
+         * \brief The Open Quickly panel controller, created when the panel is
+         *        first shown.
+         */
+        PLOpenQuicklyWindowController * openQuicklyWindowController;
+
+        /**
+         * \brief The view controller of the project search tab, created when
+         *        the tab is first shown.
+         */
+        PLProjectSearchViewController * projectSearchViewController;
+
+        /**
+         * \brief The project directory whose shared indexes the window is a
+         *        client of, or nil.
+         */
+        NSString * indexedDirectoryPath;
 }
 
 /**
@@ -86,18 +109,36 @@
 /**
  * \brief Open a document.
  *
- * \details Uses `PLDocumentManager` to open the document. If the document is
- *          already open and the user requests that tabs contain unique
- *          documents, switch to that tab containing it. Otherwise, open it
- *          with the tab bundle registered for the file type. Presents an
- *          `NSError` if opening was not successful.
+ * \details If the document is already open and the user requests that tabs
+ *          contain unique documents, switch to that tab containing it.
+ *          Otherwise, add a tab for the add on registered for the file type,
+ *          which shows that the document is loading while the file is read in
+ *          the background. Files of at least `PLUserDefaultLargeFileThreshold`
+ *          bytes are shown read only in a `PLLargeFileViewController` tab
+ *          instead. Presents an `NSError` if the tab could not be added or,
+ *          later, if the document could not be loaded.
  *
  * \param fileURL The file URL to open.
  *
- * \return YES if opening was successful.
+ * \return YES if the document's tab was found or added.
  */
 -(BOOL)openDocumentWithURL:(NSURL *)fileURL;
 
+/**
+ * \brief Open a document, optionally in a background tab.
+ *
+ * \details Like `openDocumentWithURL:`, except that if `inBackground` is YES
+ *          the active tab does not change. Background tabs create their add
+ *          on's view controller only when first activated.
+ *
+ * \param fileURL The file URL to open.
+ *
+ * \param inBackground YES to leave the active tab unchanged.
+ *
+ * \return YES if the document's tab was found or added.
+ */
+-(BOOL)openDocumentWithURL:(NSURL *)fileURL inBackground:(BOOL)inBackground;
+
 /**
  * \brief Save the document of the active tab.
  */
@@ -108,12 +149,51 @@
  */
 -(void)saveAsDocument;
 
+/**
+ * \brief Save the edited documents of all tabs.
+ */
+-(void)saveAllDocuments;
+
+/**
+ * \brief Add a background tab with an untitled document recovered from the
+ *        journal of an earlier launch.
+ *
+ * \param journal The recovered journal of the untitled document.
+ */
+-(void)addTabWithRecoveredJournal:(PLEditJournal *)journal;
+
 /**
  * \brief Close the document of the active tab, closing the window too if it is
  *        the last tab.
  */
 -(void)closeDocument;
 
+/**
+ * \brief Show the Open Quickly panel for the file browser's root directory.
+ *
+ * \details Files chosen in the panel are opened with `openDocumentWithURL:`.
+ */
+-(void)openQuickly;
+
+/**
+ * \brief Show the project search tab for the file browser's root directory.
+ *
+ * \details The tab is added the first time and made active afterwards. Files
+ *          of the matches opened in the tab are opened with
+ *          `openDocumentWithURL:`.
+ */
+-(void)findInProject;
+
+/**
+ * \brief Open the definition of the name selected in the active tab.
+ *
+ * \details The name is looked up in the symbol index of the file browser's
+ *          root directory, and the document of its first definition is opened
+ *          with `openDocumentWithURL:` and the line selected. Beeps if there is
+ *          no name or it is not defined in the project.
+ */
+-(void)jumpToDefinition;
+
 #pragma mark - Tabs
 
 /**
@@ -133,4 +213,32 @@
  */
 -(void)selectPreviousTab;
 
+#pragma mark - Session
+
+/**
+ * \brief Capture the state of the window for a session snapshot.
+ *
+ * \details The state is captured again by `PLSessionManager` whenever tabs
+ *          change, the file browser's root directory or expanded items
+ *          change, or the window is moved, resized, or resigns key window.
+ *
+ * \return The frame, file browser state, and tabs of the window.
+ */
+-(PLSessionWindow *)sessionWindow;
+
+/**
+ * \brief Restore the state of a window from a session snapshot.
+ *
+ * \details The window's frame and file browser are restored at once. Its tabs
+ *          are added with placeholders, and their documents are loaded in the
+ *          background, starting with the active tab. Large files are shown in
+ *          viewer tabs added after them. Tabs of files that no longer exist
+ *          are skipped.
+ *
+ * \param sessionWindow The recorded window.
+ *
+ * \see addTabsWithPlaceholders:activeTabIndex:
+ */
+-(void)restoreSessionWindow:(PLSessionWindow *)sessionWindow;
+
 @end
@@ -27,15 +27,31 @@
  */
 
 #import "PLWindowController.h"
+#import "PLSessionManager.h"
+#import "PLThemeTable.h"
+#import "PLTabPlaceholderViewController.h"
+#import "PLLargeFileViewController.h"
+#import "PLCompletionService.h"
 
 /* TODO: use constraints for split view and remove min size of window */
 
+/**
+ * \brief The narrowest width of the file browser, in average characters of
+ *        the application font.
+ */
+static const CGFloat PLWindowControllerFileBrowserMinimumCharacters = 22.0;
+
+/**
+ * \brief The narrowest width of the file browser for any font.
+ */
+static const CGFloat PLWindowControllerFileBrowserAbsoluteMinimumWidth = 180.0;
+
 @implementation PLWindowController
 
 /**
  * \brief Initialize the window controller.
  *
- * \details Observe the `PLThemeManagerDidChange` notification.
+ * \details Observe the `PLThemeTableDidChangeNotification` notification.
  *
  * \param window The window object to manage.
  *
@@ -47,8 +63,8 @@
         if (self) {
                 [[NSNotificationCenter defaultCenter] addObserver:self
                                                          selector:@selector(updateThemeManager)
-                                                             name:PLThemeManagerDidChange
-                                                           object:nil];
+                                                             name:PLThemeTableDidChangeNotification
+                                                           object:[PLThemeTable sharedThemeTable]];
                 [self updateThemeManager];
         }
         return self;
@@ -59,14 +75,58 @@
         return [[[self alloc] initWithWindowNibName:@"PLWindowController"] autorelease];
 }
 
+/**
+ * \brief Return the minimum width of the file browser for a font.
+ *
+ * \details The width fits `PLWindowControllerFileBrowserMinimumCharacters`
+ *          average characters of the font, and at least
+ *          `PLWindowControllerFileBrowserAbsoluteMinimumWidth`. Widths are
+ *          cached per font, since every window asks for one when it loads and
+ *          again whenever the font changes. Must be called on the main thread.
+ *
+ * \param font The font, or nil for the system font.
+ *
+ * \return The minimum width.
+ */
++(CGFloat)fileBrowserMinimumWidthForFont:(NSFont *)font
+{
+        static NSMutableDictionary * widthsByFont = nil;
+        static dispatch_once_t onceToken;
+        NSString * sample = @"abcdefghijklmnopqrstuvwxyz";
+        NSNumber * width = nil;
+        CGFloat characterWidth = 0.0;
+
+        dispatch_once(&onceToken, ^{
+                widthsByFont = [[NSMutableDictionary alloc] init];
+        });
+        if (font == nil) {
+                font = [NSFont systemFontOfSize:[NSFont systemFontSize]];
+        }
+        width = [widthsByFont objectForKey:font];
+        if (width == nil) {
+                characterWidth = [sample sizeWithAttributes:@{NSFontAttributeName: font}].width / [sample length];
+                width = @(MAX(PLWindowControllerFileBrowserAbsoluteMinimumWidth,
+                              ceil(characterWidth * PLWindowControllerFileBrowserMinimumCharacters)));
+                [widthsByFont setObject:width forKey:font];
+        }
+        return [width doubleValue];
+}
+
 /**
  * \brief Release all view controllers.
  */
 -(void)dealloc
 {
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
         [tabViewController release];
         [fileBrowserViewController release];
         [splitViewController release];
+        [openQuicklyWindowController close];
+        [openQuicklyWindowController release];
+        [projectSearchViewController release];
+        [PLProjectIndex releaseIndexForDirectoryAtPath:indexedDirectoryPath];
+        [PLSymbolIndex releaseIndexForDirectoryAtPath:indexedDirectoryPath];
+        [indexedDirectoryPath release];
         [super dealloc];
 }
 
@@ -94,7 +154,7 @@
         [[self window] setContentView:[splitViewController view]];
 
         /* Set up split view file browser width */
-        fileBrowserAbsoluteMinimumWidth = 180.0;  /* !! should be a function of font width when we have a global font */
+        fileBrowserAbsoluteMinimumWidth = [[self class] fileBrowserMinimumWidthForFont:nil];
         fileBrowserRelativeMaximumWidth = 0.5;
         [splitViewController setMinimumSidebarAbsoluteWidth:fileBrowserAbsoluteMinimumWidth];
         [splitViewController setMaximumSidebarRelativeWidth:fileBrowserRelativeMaximumWidth];
@@ -102,6 +162,50 @@
         fileBrowserViewFrame.size.width = fileBrowserAbsoluteMinimumWidth;
         [[fileBrowserViewController view] setFrame:fileBrowserViewFrame];
         [[splitViewController view] addSubview:[tabViewController view]];
+
+        /* Record changes in the session snapshot */
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(sessionStateDidChange:)
+                                                     name:PLTabViewControllerTabsDidChangeNotification
+                                                   object:tabViewController];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(sessionStateDidChange:)
+                                                     name:PLFileBrowserViewControllerDidChangeStateNotification
+                                                   object:fileBrowserViewController];
+
+        /* Open the persisted indexes so Open Quickly, Jump to Definition, and completion are ready at once */
+        if ([PLProjectIndex hasPersistentIndexForDirectoryAtPath:[self projectDirectoryPath]]) {
+                [PLProjectIndex indexForDirectoryAtPath:[self projectDirectoryPath]];
+        }
+        if ([PLSymbolIndex hasPersistentIndexForDirectoryAtPath:[self projectDirectoryPath]]) {
+                [PLSymbolIndex indexForDirectoryAtPath:[self projectDirectoryPath]];
+                [[PLCompletionService sharedService] prepareForDirectoryAtPath:[self projectDirectoryPath]];
+        }
+}
+
+/**
+ * \brief The root directory of the file browser, whose shared indexes the
+ *        window is registered as a client of.
+ *
+ * \details When the root changes, the window registers with the indexes of
+ *          the new root and releases those of the previous one, so the indexes
+ *          of a directory are evicted once no window shows it.
+ *
+ * \return The root directory of the file browser.
+ */
+-(NSString *)projectDirectoryPath
+{
+        NSString * directoryPath = [fileBrowserViewController directoryRootPath];
+
+        if (directoryPath != nil && [directoryPath isEqualToString:indexedDirectoryPath] == NO) {
+                [PLProjectIndex retainIndexForDirectoryAtPath:directoryPath];
+                [PLSymbolIndex retainIndexForDirectoryAtPath:directoryPath];
+                [PLProjectIndex releaseIndexForDirectoryAtPath:indexedDirectoryPath];
+                [PLSymbolIndex releaseIndexForDirectoryAtPath:indexedDirectoryPath];
+                [indexedDirectoryPath release];
+                indexedDirectoryPath = [directoryPath copy];
+        }
+        return directoryPath;
 }
 
 #pragma mark - Opening and Saving Documents
@@ -113,31 +217,54 @@
 
 -(BOOL)openDocumentWithURL:(NSURL *)fileURL
 {
-        PLDocument <PLDocumentSubclass> * document = nil;
-        NSBundle * defaultAddOnBundle = [[PLAddOnManager defaultManager] defaultAddOnBundle];
+        return [self openDocumentWithURL:fileURL inBackground:NO];
+}
+
+-(BOOL)openDocumentWithURL:(NSURL *)fileURL inBackground:(BOOL)inBackground
+{
         BOOL successful = YES;
         NSString * fileType = [[fileURL path] pathExtension];
-        
-        document = [[PLDocumentManager sharedDocumentManager] documentForURL:fileURL];
-        if (document == nil) {
-                successful = NO;
+
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultUniqueDocuments] && [tabViewController containsTabWithURL:fileURL]) {
+                if (inBackground == NO) {
+                        [tabViewController setTabWithURLActive:fileURL];
+                }
+        } else if ([PLLargeFileViewController shouldViewFileAtURL:fileURL]) {
+                [tabViewController addTabWithViewController:[PLLargeFileViewController viewControllerWithURL:fileURL]
+                                                   activate:(inBackground == NO)];
+        } else {
+                successful = [tabViewController addTabWithAddOn:[self addOnForFileType:fileType]
+                                                        fileURL:fileURL
+                                                       activate:(inBackground == NO)];
+        }
+        if (successful == NO) {
                 [self presentError:[NSError errorWithDomain:PLLiasisErrorDomain
                                                        code:PLErrorCodeModal
                                                    userInfo:@{NSLocalizedDescriptionKey: @"File could not be opened."}]];
-                goto exit;
         }
+        return successful;
+}
 
-        if ([[NSUserDefaults standardUserDefaults] boolForKey:PLUserDefaultUniqueDocuments] && [tabViewController containsTabWithURL:fileURL]) {
-                [tabViewController setTabWithURLActive:fileURL];
-        } else if ([[[PLAddOnManager defaultManager] allowedFileTypesForAddOn:defaultAddOnBundle] containsObject:fileType]){
-                [tabViewController addTabWithAddOn:defaultAddOnBundle
-                                      withDocument:document];
-        } else {
-                [tabViewController addTabWithAddOn:[[PLAddOnManager defaultManager] defaultAddOnForFileType:fileType]
-                                      withDocument:document];
+/**
+ * \brief The add on opening documents of a file type.
+ *
+ * \details The default add on is used if it allows the file type. Otherwise,
+ *          the deferred add ons are loaded and the add on registered for the
+ *          file type is used.
+ *
+ * \param fileType The path extension of the document.
+ *
+ * \return The add on bundle.
+ */
+-(NSBundle *)addOnForFileType:(NSString *)fileType
+{
+        NSBundle * addOn = [[PLAddOnManager defaultManager] defaultAddOnBundle];
+
+        if ([[[PLAddOnManager defaultManager] allowedFileTypesForAddOn:addOn] containsObject:fileType] == NO) {
+                [[PLAddOnLoader sharedLoader] loadDeferredAddOns];
+                addOn = [[PLAddOnManager defaultManager] defaultAddOnForFileType:fileType];
         }
-exit:
-        return successful;
+        return addOn;
 }
 
 -(void)saveDocument
@@ -150,6 +277,16 @@ exit:
         [tabViewController saveAsActiveTab];
 }
 
+-(void)saveAllDocuments
+{
+        [tabViewController saveAllTabs];
+}
+
+-(void)addTabWithRecoveredJournal:(PLEditJournal *)journal
+{
+        [tabViewController addTabWithRecoveredJournal:journal];
+}
+
 -(void)closeDocument
 {
         if ([tabViewController numberOfTabs] > 1) {
@@ -159,6 +296,64 @@ exit:
         }
 }
 
+-(void)openQuickly
+{
+        __block PLWindowController * blockSelf = self;
+
+        if (openQuicklyWindowController == nil) {
+                openQuicklyWindowController = [[PLOpenQuicklyWindowController windowController] retain];
+                [openQuicklyWindowController setOpenDocumentHandler:^(NSURL * fileURL) {
+                        [blockSelf openDocumentWithURL:fileURL];
+                }];
+        }
+        [openQuicklyWindowController showWithProjectIndex:[PLProjectIndex indexForDirectoryAtPath:[self projectDirectoryPath]]
+                                         relativeToWindow:[self window]];
+}
+
+-(void)findInProject
+{
+        __block PLWindowController * blockSelf = self;
+
+        if (projectSearchViewController == nil) {
+                projectSearchViewController = [[PLProjectSearchViewController viewControllerWithDirectoryPath:[fileBrowserViewController directoryRootPath]] retain];
+                [projectSearchViewController setOpenDocumentHandler:^(NSURL * fileURL) {
+                        [blockSelf openDocumentWithURL:fileURL];
+                }];
+        } else {
+                projectSearchViewController.directoryPath = [fileBrowserViewController directoryRootPath];
+        }
+        if ([tabViewController containsTabWithViewController:projectSearchViewController]) {
+                [tabViewController setTabWithViewControllerActive:projectSearchViewController];
+        } else {
+                [tabViewController addTabWithViewController:projectSearchViewController];
+        }
+        [[self window] makeFirstResponder:projectSearchViewController];
+}
+
+-(void)jumpToDefinition
+{
+        NSString * name = [tabViewController selectedNameOfActiveTab];
+        PLSymbolLocation * definition = nil;
+        NSURL * fileURL = nil;
+
+        if (name == nil) {
+                NSBeep();
+                goto exit;
+        }
+        definition = [[[PLSymbolIndex indexForDirectoryAtPath:[self projectDirectoryPath]] definitionsOfSymbolNamed:name maximumCount:1] firstObject];
+        if (definition == nil) {
+                NSBeep();
+                goto exit;
+        }
+        fileURL = [NSURL fileURLWithPath:definition.path];
+        if ([self openDocumentWithURL:fileURL]) {
+                [tabViewController selectLine:definition.line ofTabWithURL:fileURL];
+        }
+
+exit:
+        return;
+}
+
 #pragma mark - Tabs
 
 -(NSUInteger)numberOfTabs
@@ -176,10 +371,128 @@ exit:
         [tabViewController selectPreviousTab];
 }
 
+#pragma mark - Session
+
+-(PLSessionWindow *)sessionWindow
+{
+        PLSessionWindow * sessionWindow = [PLSessionWindow window];
+        NSUInteger activeTabIndex = NSNotFound;
+
+        sessionWindow.frame = [[self window] frame];
+        sessionWindow.directoryRootPath = [fileBrowserViewController directoryRootPath];
+        sessionWindow.expandedPaths = [fileBrowserViewController expandedPaths];
+        sessionWindow.tabs = [tabViewController sessionTabsWithActiveTabIndex:&activeTabIndex];
+        sessionWindow.activeTabIndex = activeTabIndex;
+        return sessionWindow;
+}
+
+-(void)restoreSessionWindow:(PLSessionWindow *)sessionWindow
+{
+        NSMutableArray * placeholders = [NSMutableArray array];
+        NSMutableArray * largeFileViewers = [NSMutableArray array];
+        PLTabPlaceholderViewController * placeholder = nil;
+        PLLargeFileViewController * largeFileViewer = nil, * activeLargeFileViewer = nil;
+        PLSessionTab * tab = nil;
+        NSBundle * addOn = nil;
+        NSUInteger index = 0, activeTabIndex = NSNotFound;
+        BOOL isDirectory = NO;
+
+        if (NSIsEmptyRect(sessionWindow.frame) == NO) {
+                [[self window] setFrame:[[self window] constrainFrameRect:sessionWindow.frame toScreen:[[self window] screen]]
+                                display:NO];
+        }
+        if ([[NSFileManager defaultManager] fileExistsAtPath:sessionWindow.directoryRootPath isDirectory:&isDirectory] && isDirectory) {
+                [fileBrowserViewController setDirectoryRootPath:sessionWindow.directoryRootPath];
+                [fileBrowserViewController expandItemsAtPaths:sessionWindow.expandedPaths];
+        }
+
+        for (index = 0; index < [sessionWindow.tabs count]; index++) {
+                tab = [sessionWindow.tabs objectAtIndex:index];
+                if ([[NSFileManager defaultManager] fileExistsAtPath:[tab.fileURL path]] == NO) {
+                        continue;
+                }
+                if ([PLLargeFileViewController shouldViewFileAtURL:tab.fileURL]) {
+                        largeFileViewer = [PLLargeFileViewController viewControllerWithURL:tab.fileURL];
+                        if (index == sessionWindow.activeTabIndex) {
+                                activeLargeFileViewer = largeFileViewer;
+                        }
+                        [largeFileViewers addObject:largeFileViewer];
+                        continue;
+                }
+                addOn = [self addOnForFileType:[[tab.fileURL path] pathExtension]];
+                if (addOn == nil) {
+                        continue;
+                }
+                placeholder = [PLTabPlaceholderViewController placeholderWithAddOn:addOn fileURL:tab.fileURL];
+                placeholder.selectedRange = tab.selectedRange;
+                placeholder.scrollPosition = tab.scrollPosition;
+                if (index == sessionWindow.activeTabIndex) {
+                        activeTabIndex = [placeholders count];
+                }
+                [placeholders addObject:placeholder];
+        }
+        [tabViewController addTabsWithPlaceholders:placeholders activeTabIndex:activeTabIndex];
+        for (largeFileViewer in largeFileViewers) {
+                [tabViewController addTabWithViewController:largeFileViewer activate:(largeFileViewer == activeLargeFileViewer)];
+        }
+}
+
+/**
+ * \brief Record the window in the session snapshot after its tabs or file
+ *        browser changed.
+ *
+ * \details A change of the file browser may be a new root directory, so the
+ *          window also moves its registration to the indexes of the new root.
+ *
+ * \param notification The `PLTabViewControllerTabsDidChangeNotification` or
+ *                     `PLFileBrowserViewControllerDidChangeStateNotification`.
+ */
+-(void)sessionStateDidChange:(NSNotification *)notification
+{
+        if ([notification object] == fileBrowserViewController) {
+                [self projectDirectoryPath];
+        }
+        [[PLSessionManager sharedSessionManager] windowControllerDidChange:self];
+}
+
+/**
+ * \brief Record the new frame of the window in the session snapshot.
+ *
+ * \param notification The `NSWindowDidMoveNotification`.
+ */
+-(void)windowDidMove:(NSNotification *)notification
+{
+        [[PLSessionManager sharedSessionManager] windowControllerDidChange:self];
+}
+
+/**
+ * \brief Record the new frame of the window in the session snapshot.
+ *
+ * \param notification The `NSWindowDidResizeNotification`.
+ */
+-(void)windowDidResize:(NSNotification *)notification
+{
+        [[PLSessionManager sharedSessionManager] windowControllerDidChange:self];
+}
+
+/**
+ * \brief Record the selection and scroll position of the window's tabs in the
+ *        session snapshot when the user leaves the window.
+ *
+ * \param notification The `NSWindowDidResignKeyNotification`.
+ */
+-(void)windowDidResignKey:(NSNotification *)notification
+{
+        [[PLSessionManager sharedSessionManager] windowControllerDidChange:self];
+}
+
 #pragma mark - Themeable
 
 /**
  * \brief Update the themes of both the tab view and file browser view.
+ *
+ * \details Called once per pass of the run loop however many times the theme
+ *          changed. The tab view only updates its active tab right away.
  */
 -(void)updateThemeManager
 {
@@ -189,12 +502,16 @@ exit:
 
 /**
  * \brief Update the font of both the tab view and file browser view, if they
- *        respond to the message.
+ *        respond to the message, and the minimum width of the file browser.
+ *
+ * \details The tab view updates the font of its active tab before returning
+ *          and of its background tabs later.
  *
  * \param font The new font.
  */
 -(void)updateFont:(NSFont *)font
 {
+        [splitViewController setMinimumSidebarAbsoluteWidth:[[self class] fileBrowserMinimumWidthForFont:font]];
         if ([tabViewController respondsToSelector:@selector(updateFont:)]) {
                 [tabViewController updateFont:font];
         }
@@ -0,0 +1,154 @@
+/**
+ * \file PLAddOnLoaderTests.m
+ * \brief Unit tests for the deferred loading of built in add ons.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Jason Lomnitz.
+ * \author Danny Nicklas.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLAddOnLoader.h"
+#import "PLPythonRuntime.h"
+
+/**
+ * \brief A loader recording the add ons it loads instead of loading them.
+ */
+@interface PLTestAddOnLoader : PLAddOnLoader
+
+@property (retain) NSMutableArray * loadedNames;
+
+@end
+
+@implementation PLTestAddOnLoader
+
+-(void)dealloc
+{
+        [_loadedNames release];
+        [super dealloc];
+}
+
+-(void)loadAddOnNamed:(NSString *)name
+{
+        if (self.loadedNames == nil) {
+                self.loadedNames = [NSMutableArray array];
+        }
+        [self.loadedNames addObject:name];
+}
+
+@end
+
+@interface PLAddOnLoaderTests : XCTestCase
+{
+        NSString * plugInsPath;
+        PLTestAddOnLoader * loader;
+}
+
+@end
+
+@implementation PLAddOnLoaderTests
+
+-(void)setUp
+{
+        NSArray * builtInAddOns = nil;
+
+        [super setUp];
+        plugInsPath = [[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]] retain];
+        [self writeAddOnNamed:@"Declared.plugin" infoDictionary:@{PLAddOnNeededAtLaunchKey: @YES, PLAddOnRequiresPythonKey: @NO}];
+        builtInAddOns = @[@{PLAddOnNameKey: @"Editor.plugin", PLAddOnNeededAtLaunchKey: @YES},
+                          @{PLAddOnNameKey: @"Introspector.plugin", PLAddOnRequiresPythonKey: @YES},
+                          @{PLAddOnNameKey: @"Viewer.plugin"},
+                          @{PLAddOnNameKey: @"Interpreter.plugin", PLAddOnRequiresPythonKey: @YES},
+                          @{PLAddOnNeededAtLaunchKey: @YES},
+                          @{PLAddOnNameKey: @"Declared.plugin", PLAddOnNeededAtLaunchKey: @NO, PLAddOnRequiresPythonKey: @YES}];
+        loader = [[PLTestAddOnLoader alloc] initWithBuiltInAddOns:builtInAddOns plugInsPath:plugInsPath];
+}
+
+-(void)tearDown
+{
+        [loader release];
+        [[NSFileManager defaultManager] removeItemAtPath:plugInsPath error:NULL];
+        [plugInsPath release];
+        [super tearDown];
+}
+
+/**
+ * \brief Write an add on bundle containing only an Info.plist.
+ */
+-(void)writeAddOnNamed:(NSString *)name infoDictionary:(NSDictionary *)infoDictionary
+{
+        NSString * contentsPath = [[plugInsPath stringByAppendingPathComponent:name] stringByAppendingPathComponent:@"Contents"];
+        NSMutableDictionary * info = [NSMutableDictionary dictionaryWithDictionary:infoDictionary];
+
+        [info setObject:[@"org.liasis.tests." stringByAppendingString:[name stringByDeletingPathExtension]] forKey:@"CFBundleIdentifier"];
+        [[NSFileManager defaultManager] createDirectoryAtPath:contentsPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        XCTAssertTrue([info writeToFile:[contentsPath stringByAppendingPathComponent:@"Info.plist"] atomically:NO]);
+}
+
+-(void)testOnlyAddOnsNeededAtLaunchLoadAtLaunch
+{
+        [loader loadAddOnsNeededAtLaunch];
+
+        /* The bundle's own Info.plist overrides the application's entry */
+        XCTAssertEqualObjects(loader.loadedNames, (@[@"Editor.plugin", @"Declared.plugin"]));
+        XCTAssertFalse([loader areDeferredAddOnsLoaded]);
+}
+
+-(void)testDeferredAddOnsWithoutPythonLoadFirst
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:30.0];
+
+        [loader loadAddOnsNeededAtLaunch];
+        loader.loadedNames = nil;
+        [loader beginLoadingDeferredAddOns];
+        XCTAssertEqualObjects([loader.loadedNames firstObject], @"Viewer.plugin");
+
+        while ([loader areDeferredAddOnsLoaded] == NO && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        XCTAssertTrue([[PLPythonRuntime sharedRuntime] isReady]);
+        XCTAssertEqualObjects(loader.loadedNames, (@[@"Viewer.plugin", @"Introspector.plugin", @"Interpreter.plugin"]));
+}
+
+-(void)testLoadingDeferredAddOnsOnFirstUseLoadsEachOnce
+{
+        [loader loadDeferredAddOns];
+
+        XCTAssertTrue([loader areDeferredAddOnsLoaded]);
+        XCTAssertEqualObjects(loader.loadedNames, (@[@"Introspector.plugin", @"Viewer.plugin", @"Interpreter.plugin"]));
+
+        /* Neither a second use nor a pending background load loads them again */
+        [loader loadDeferredAddOns];
+        [loader beginLoadingDeferredAddOns];
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        XCTAssertEqual([loader.loadedNames count], (NSUInteger)3);
+}
+
+-(void)testFirstUseAfterBackgroundStartLoadsTheRest
+{
+        [loader beginLoadingDeferredAddOns];
+        [loader loadDeferredAddOns];
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+        XCTAssertTrue([loader areDeferredAddOnsLoaded]);
+        XCTAssertEqualObjects(loader.loadedNames, (@[@"Viewer.plugin", @"Introspector.plugin", @"Interpreter.plugin"]));
+}
+
+@end
@@ -0,0 +1,450 @@
+/**
+ * \file PLCompletionServiceTests.m
+ * \brief Unit tests and benchmarks of the completion tries, rankings, and
+ *        service.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLCompletionService.h"
+#import "PLSymbolIndex+Private.h"
+
+/**
+ * \brief The project directory of the symbol index installed by the tests. It
+ *        is never read.
+ */
+static NSString * const PLCompletionServiceTestRoot = @"/PLCompletionServiceTests/project";
+
+/**
+ * \brief The flag of a symbol in an unindented statement.
+ */
+static const uint8_t PLCompletionServiceTestTopLevel = 1;
+
+/**
+ * \brief The number of random names and prefixes of the oracle test.
+ */
+static const NSUInteger PLCompletionServiceTestNameCount = 3000;
+static const NSUInteger PLCompletionServiceTestPrefixCount = 300;
+
+/**
+ * \brief The number of names of the benchmark project.
+ */
+static const NSUInteger PLCompletionServiceTestProjectNameCount = 100000;
+
+/**
+ * \brief The number of requests of each run of the benchmark.
+ */
+static const NSUInteger PLCompletionServiceTestRequestCount = 200;
+
+/**
+ * \brief The time allowed for the first results of 99% of the benchmark
+ *        requests, a frame, in seconds.
+ */
+static const CFTimeInterval PLCompletionServiceTestLatencyBudget = 0.016;
+
+/**
+ * \brief The time allowed for tries to be built and requests answered, in
+ *        seconds.
+ */
+static const NSTimeInterval PLCompletionServiceTestTimeout = 30.0;
+
+@interface PLCompletionServiceTests : XCTestCase
+{
+        /**
+         * \brief The service under test, separate from the shared service.
+         */
+        PLCompletionService * service;
+}
+
+@end
+
+@implementation PLCompletionServiceTests
+
+-(void)setUp
+{
+        [super setUp];
+        service = [[PLCompletionService alloc] init];
+}
+
+-(void)tearDown
+{
+        [service cancelCurrentRequest];
+        [PLSymbolIndex releaseIndexForDirectoryAtPath:PLCompletionServiceTestRoot];
+        [service release];
+        service = nil;
+        [super tearDown];
+}
+
+/**
+ * \brief Return a random name of a few letters, differing in case, and
+ *        underscores, so that many names share prefixes.
+ */
+-(NSString *)randomName
+{
+        const char alphabet[] = "aAbBc_";
+        char name[9];
+        NSUInteger length = 1 + random() % 8, i = 0;
+
+        for (i = 0; i < length; i++) {
+                name[i] = alphabet[random() % (sizeof(alphabet) - 1)];
+        }
+        name[length] = '\0';
+        return [NSString stringWithUTF8String:name];
+}
+
+/**
+ * \brief The names of completions.
+ */
+-(NSArray *)namesOfCompletions:(NSArray *)completions
+{
+        return [completions valueForKey:@"name"];
+}
+
+/**
+ * \brief Run the main run loop until a condition holds or the timeout passes.
+ */
+-(BOOL)waitUntil:(BOOL (^)(void))condition
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:PLCompletionServiceTestTimeout];
+
+        while (!condition() && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+        }
+        return condition();
+}
+
+/**
+ * \brief Make a symbol index the shared index of the test project, prepare
+ *        the service for it, and wait for the trie of its names.
+ */
+-(void)installIndexOfBuilder:(PLSymbolIndexBuilder *)builder
+{
+        PLSymbolIndex * index = [[[PLSymbolIndex alloc] initWithDirectoryPath:PLCompletionServiceTestRoot] autorelease];
+        PLCompletionService * preparedService = service;
+
+        [index setSnapshot:[[[PLSymbolIndexSnapshot alloc] initWithData:[builder dataWithLastEventIdentifier:0 eventHistoryIdentifier:nil]
+                                                               rootPath:PLCompletionServiceTestRoot] autorelease]];
+        [[PLSymbolIndex sharedIndexes] setObject:index forKey:PLCompletionServiceTestRoot];
+        [PLSymbolIndex retainIndexForDirectoryAtPath:PLCompletionServiceTestRoot];
+        [service prepareForDirectoryAtPath:PLCompletionServiceTestRoot];
+        XCTAssertTrue([self waitUntil:^BOOL{
+                @synchronized(preparedService) {
+                        return [[preparedService valueForKey:@"projectTries"] objectForKey:PLCompletionServiceTestRoot] != nil;
+                }
+        }]);
+}
+
+/**
+ * \brief Request completions of some text and wait for the first results.
+ *
+ * \return The completions, or nil if none arrived in time.
+ */
+-(NSArray *)firstCompletionsOfText:(NSString *)text inDirectoryAtPath:(NSString *)directoryPath
+{
+        __block NSArray * firstCompletions = nil;
+
+        [service requestCompletionsOfText:text inDirectoryAtPath:directoryPath maximumCount:10 handler:^(NSArray * completions, BOOL partial, BOOL final) {
+                if (firstCompletions == nil) {
+                        firstCompletions = [completions retain];
+                }
+        }];
+        [self waitUntil:^BOOL{
+                return firstCompletions != nil;
+        }];
+        return [firstCompletions autorelease];
+}
+
+/**
+ * \brief Wait for the trie of the keywords, builtins, and modules.
+ */
+-(void)waitForBaseTrie
+{
+        PLCompletionService * builtService = service;
+
+        XCTAssertTrue([self waitUntil:^BOOL{
+                @synchronized(builtService) {
+                        return [builtService valueForKey:@"baseTrie"] != nil;
+                }
+        }]);
+}
+
+#pragma mark - Rankings
+
+-(void)testRankingPrefersExactCaseAndShorterNames
+{
+        PLCompletionRanking * ranking = [PLCompletionRanking rankingWithPrefix:@"Sp" capacity:10 deadline:DBL_MAX];
+        NSArray * completions = nil;
+
+        XCTAssertTrue([ranking offerNames:@[@"spam", @"Spam", @"Spamalot", @"eggs", @"s"] source:PLCompletionSourceProject weight:100]);
+        completions = [ranking completions];
+        XCTAssertEqualObjects([self namesOfCompletions:completions], (@[@"Spam", @"Spamalot", @"spam"]));
+        XCTAssertEqual([completions[0] score], (NSUInteger)(100 + 64 + 30));
+        XCTAssertEqual([completions[1] score], (NSUInteger)(100 + 64 + 26));
+        XCTAssertEqual([completions[2] score], (NSUInteger)(100 + 30));
+        XCTAssertFalse([ranking isPartial]);
+}
+
+-(void)testRankingKeepsANameOnceWithItsBestScore
+{
+        PLCompletionRanking * ranking = [PLCompletionRanking rankingWithPrefix:@"x" capacity:2 deadline:DBL_MAX];
+        NSArray * completions = nil;
+
+        [ranking offerNames:@[@"x_project"] source:PLCompletionSourceProject weight:300];
+        [ranking offerNames:@[@"x_project"] source:PLCompletionSourceNamespace weight:400];
+        [ranking offerNames:@[@"x_project"] source:PLCompletionSourceBuiltin weight:10];
+        [ranking offerNames:@[@"x_low"] source:PLCompletionSourceBuiltin weight:50];
+        [ranking offerNames:@[@"x_lower"] source:PLCompletionSourceBuiltin weight:1];
+        completions = [ranking completions];
+        XCTAssertEqualObjects([self namesOfCompletions:completions], (@[@"x_project", @"x_low"]));
+        XCTAssertEqual([completions[0] source], PLCompletionSourceNamespace);
+        XCTAssertEqual([ranking minimumScore], [completions[1] score]);
+}
+
+-(void)testRankingStopsAtItsDeadlineOrWhenCancelled
+{
+        PLCompletionRanking * ranking = [PLCompletionRanking rankingWithPrefix:@"" capacity:10 deadline:CACurrentMediaTime() - 1.0];
+        NSMutableArray * names = [NSMutableArray array];
+        NSUInteger i = 0;
+
+        for (i = 0; i < 1000; i++) {
+                [names addObject:[NSString stringWithFormat:@"name%lu", (unsigned long)i]];
+        }
+        XCTAssertFalse([ranking offerNames:names source:PLCompletionSourceProject weight:100]);
+        XCTAssertTrue([ranking isPartial]);
+        XCTAssertFalse([ranking isCancelled]);
+
+        ranking = [PLCompletionRanking rankingWithPrefix:@"" capacity:10 deadline:DBL_MAX];
+        [ranking cancel];
+        XCTAssertTrue([ranking shouldStop]);
+        XCTAssertFalse([ranking offerNames:names source:PLCompletionSourceProject weight:100]);
+        XCTAssertFalse([ranking isPartial]);
+}
+
+#pragma mark - Tries
+
+-(void)testTrieRanksLikeOfferingEveryName
+{
+        PLCompletionTrieBuilder * builder = [PLCompletionTrieBuilder builder];
+        NSMutableDictionary * weights = [NSMutableDictionary dictionary];
+        PLCompletionTrie * trie = nil;
+        PLCompletionRanking * ranking = nil, * oracle = nil;
+        NSArray * completions = nil, * expectedCompletions = nil;
+        NSString * name = nil, * prefix = nil;
+        NSUInteger i = 0, weight = 0, capacity = 0, cutoff = 0;
+
+        srandom(5);
+        for (i = 0; i < PLCompletionServiceTestNameCount; i++) {
+                name = [self randomName];
+                weight = random() % 400;
+                [builder addName:[name UTF8String] length:strlen([name UTF8String]) source:PLCompletionSourceProject weight:weight];
+                weights[name] = @(MAX(weight, [weights[name] unsignedIntegerValue]));
+        }
+        trie = [builder trie];
+        XCTAssertEqual([trie count], [weights count]);
+
+        for (i = 0; i < PLCompletionServiceTestPrefixCount; i++) {
+                name = [self randomName];
+                prefix = [name substringToIndex:MIN(random() % 4, [name length])];
+                capacity = 1 + random() % 20;
+                ranking = [PLCompletionRanking rankingWithPrefix:prefix capacity:capacity deadline:DBL_MAX];
+                oracle = [PLCompletionRanking rankingWithPrefix:prefix capacity:capacity deadline:DBL_MAX];
+                XCTAssertTrue([trie rankCompletionsWithRanking:ranking]);
+                for (name in weights) {
+                        [oracle offerNames:@[name] source:PLCompletionSourceProject weight:[weights[name] unsignedIntegerValue]];
+                }
+                completions = [ranking completions];
+                expectedCompletions = [oracle completions];
+
+                /* Names tied with the last one kept may differ, their scores may not */
+                XCTAssertEqualObjects([completions valueForKey:@"score"], [expectedCompletions valueForKey:@"score"], @"Prefix %@", prefix);
+                cutoff = [[expectedCompletions lastObject] score];
+                XCTAssertEqualObjects([self namesOfCompletions:[completions filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"score > %lu", (unsigned long)cutoff]]],
+                                      [self namesOfCompletions:[expectedCompletions filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"score > %lu", (unsigned long)cutoff]]],
+                                      @"Prefix %@", prefix);
+        }
+}
+
+-(void)testTrieIgnoresNamesItCannotStore
+{
+        PLCompletionTrieBuilder * builder = [PLCompletionTrieBuilder builder];
+        NSString * longName = [@"" stringByPaddingToLength:256 withString:@"n" startingAtIndex:0];
+        PLCompletionRanking * ranking = [PLCompletionRanking rankingWithPrefix:@"" capacity:10 deadline:DBL_MAX];
+        PLCompletionTrie * trie = nil;
+
+        [builder addName:"" length:0 source:PLCompletionSourceProject weight:1];
+        [builder addName:[longName UTF8String] length:256 source:PLCompletionSourceProject weight:1];
+        [builder addName:"nul\0name" length:8 source:PLCompletionSourceProject weight:1];
+        [builder addName:"kept" length:4 source:PLCompletionSourceProject weight:1];
+        trie = [builder trie];
+        XCTAssertEqual([trie count], (NSUInteger)1);
+        XCTAssertTrue([trie rankCompletionsWithRanking:ranking]);
+        XCTAssertEqualObjects([self namesOfCompletions:[ranking completions]], (@[@"kept"]));
+}
+
+#pragma mark - Service
+
+-(void)testKeywordsAndBuiltinsAreCompleted
+{
+        NSArray * completions = nil;
+
+        [self waitForBaseTrie];
+        completions = [self firstCompletionsOfText:@"whi" inDirectoryAtPath:nil];
+        XCTAssertEqualObjects([[completions firstObject] name], @"while");
+        XCTAssertEqual([[completions firstObject] source], PLCompletionSourceKeyword);
+
+        /* A builtin in the case typed ranks above a keyword */
+        completions = [self firstCompletionsOfText:@"Tr" inDirectoryAtPath:nil];
+        XCTAssertEqualObjects([[completions firstObject] name], @"True");
+        XCTAssertTrue([[self namesOfCompletions:completions] containsObject:@"try"]);
+}
+
+-(void)testProjectNamesAreCompletedUntilTheIndexIsEvicted
+{
+        PLSymbolIndexBuilder * builder = [[[PLSymbolIndexBuilder alloc] initWithRootPath:PLCompletionServiceTestRoot] autorelease];
+        uint32_t fileIndex = 0;
+        NSArray * completions = nil;
+
+        fileIndex = [builder addFileAtPath:@"a.py" contentHash:0 modificationTime:0 size:0];
+        [builder addSymbolNamed:"spam_handler" length:12 fileIndex:fileIndex line:1 kind:PLPythonSymbolFunction flags:PLCompletionServiceTestTopLevel];
+        [builder addSymbolNamed:"spam_helper" length:11 fileIndex:fileIndex line:4 kind:PLPythonSymbolFunction flags:0];
+        [builder addSymbolNamed:"_spam_hidden" length:12 fileIndex:fileIndex line:9 kind:PLPythonSymbolFunction flags:PLCompletionServiceTestTopLevel];
+        fileIndex = [builder addFileAtPath:@"b.py" contentHash:0 modificationTime:0 size:0];
+        [builder addSymbolNamed:"spam_handler" length:12 fileIndex:fileIndex line:2 kind:PLPythonSymbolReference flags:0];
+        [self waitForBaseTrie];
+        [self installIndexOfBuilder:builder];
+
+        completions = [self firstCompletionsOfText:@"spam_h" inDirectoryAtPath:PLCompletionServiceTestRoot];
+        XCTAssertEqualObjects([self namesOfCompletions:completions], (@[@"spam_handler", @"spam_helper"]));
+        XCTAssertEqual([[completions firstObject] source], PLCompletionSourceProject);
+        XCTAssertEqualObjects([[[self firstCompletionsOfText:@"_sp" inDirectoryAtPath:PLCompletionServiceTestRoot] firstObject] name], @"_spam_hidden");
+
+        /* The last client closing the project drops its trie */
+        [PLSymbolIndex releaseIndexForDirectoryAtPath:PLCompletionServiceTestRoot];
+        @synchronized(service) {
+                XCTAssertNil([[service valueForKey:@"projectTries"] objectForKey:PLCompletionServiceTestRoot]);
+        }
+        XCTAssertFalse([[service valueForKey:@"preparedDirectories"] containsObject:PLCompletionServiceTestRoot]);
+}
+
+-(void)testCancelledAndSupersededRequestsAreNotAnswered
+{
+        __block NSUInteger cancelledCount = 0, supersededCount = 0;
+        NSArray * completions = nil;
+
+        [self waitForBaseTrie];
+        [service requestCompletionsOfText:@"im" inDirectoryAtPath:nil maximumCount:10 handler:^(NSArray * results, BOOL partial, BOOL final) {
+                cancelledCount++;
+        }];
+        [service cancelCurrentRequest];
+        [service requestCompletionsOfText:@"fo" inDirectoryAtPath:nil maximumCount:10 handler:^(NSArray * results, BOOL partial, BOOL final) {
+                supersededCount++;
+        }];
+        completions = [self firstCompletionsOfText:@"ret" inDirectoryAtPath:nil];
+        XCTAssertEqualObjects([[completions firstObject] name], @"return");
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+        XCTAssertEqual(cancelledCount, (NSUInteger)0);
+        XCTAssertEqual(supersededCount, (NSUInteger)0);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Request completions of random one to three letter prefixes in a
+ *        project of 100,000 names, reporting the median and 99th percentile
+ *        latency of the first results.
+ *
+ * \details The latency is measured as the editor sees it, from the request to
+ *          its handler being called on the main thread.
+ */
+-(void)testFirstResultsLatencyPerformance
+{
+        PLSymbolIndexBuilder * builder = [[[PLSymbolIndexBuilder alloc] initWithRootPath:PLCompletionServiceTestRoot] autorelease];
+        const char * const syllables[] = {"get", "set", "load", "save", "user", "item", "parse", "value", "index", "cache", "path", "node"};
+        const NSUInteger syllableCount = sizeof(syllables) / sizeof(syllables[0]);
+        NSMutableArray * latencies = [NSMutableArray array];
+        __block NSUInteger partialCount = 0;
+        char name[64];
+        NSUInteger i = 0;
+        uint32_t fileIndex = 0;
+        int length = 0;
+
+        srandom(6);
+        for (i = 0; i < PLCompletionServiceTestProjectNameCount; i++) {
+                if (i % 100 == 0) {
+                        fileIndex = [builder addFileAtPath:[NSString stringWithFormat:@"module%lu.py", (unsigned long)i / 100] contentHash:i modificationTime:0 size:0];
+                }
+                length = snprintf(name, sizeof(name), "%s_%s%lu",
+                                  syllables[random() % syllableCount], syllables[random() % syllableCount], (unsigned long)i);
+                [builder addSymbolNamed:name
+                                 length:length
+                              fileIndex:fileIndex
+                                   line:(uint32_t)(i % 100 + 1)
+                                   kind:(uint8_t)(random() % 3)
+                                  flags:(random() % 2) ? PLCompletionServiceTestTopLevel : 0];
+        }
+        [self waitForBaseTrie];
+        [self installIndexOfBuilder:builder];
+
+        [self measureBlock:^{
+                NSUInteger request = 0;
+
+                for (request = 0; request < PLCompletionServiceTestRequestCount; request++) {
+                        char prefix[4] = {0};
+                        NSUInteger prefixLength = 1 + random() % 3, j = 0;
+                        __block CFTimeInterval latency = 0.0;
+                        CFTimeInterval startTime = 0.0;
+
+                        for (j = 0; j < prefixLength; j++) {
+                                prefix[j] = (char)('a' + random() % 26);
+                        }
+                        startTime = CACurrentMediaTime();
+                        [service requestCompletionsOfText:[NSString stringWithUTF8String:prefix]
+                                        inDirectoryAtPath:PLCompletionServiceTestRoot
+                                             maximumCount:10
+                                                  handler:^(NSArray * completions, BOOL partial, BOOL final) {
+                                                          if (latency == 0.0) {
+                                                                  latency = CACurrentMediaTime() - startTime;
+                                                                  partialCount += partial;
+                                                          }
+                                                  }];
+                        [self waitUntil:^BOOL{
+                                return latency != 0.0;
+                        }];
+                        [latencies addObject:@(latency)];
+                }
+        }];
+        [latencies sortUsingSelector:@selector(compare:)];
+        NSLog(@"Completion service: p50 %.2f ms, p99 %.2f ms over %lu requests in %lu names, %lu partial",
+              [latencies[[latencies count] / 2] doubleValue] * 1000.0,
+              [latencies[[latencies count] * 99 / 100] doubleValue] * 1000.0,
+              (unsigned long)[latencies count],
+              (unsigned long)PLCompletionServiceTestProjectNameCount,
+              (unsigned long)partialCount);
+
+#if defined(__OPTIMIZE__)
+        XCTAssertLessThan([latencies[[latencies count] * 99 / 100] doubleValue], PLCompletionServiceTestLatencyBudget);
+#endif
+}
+
+@end
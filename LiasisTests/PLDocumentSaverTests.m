@@ -0,0 +1,223 @@
+/**
+ * \file PLDocumentSaverTests.m
+ * \brief Unit tests for the saves of documents to their files.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLDocumentSaver.h"
+#include <sys/stat.h>
+
+@interface PLDocumentSaverTests : XCTestCase
+{
+        NSString * directoryPath;
+        PLDocumentSaver * saver;
+        NSMutableArray * finishedSaves;
+}
+
+@end
+
+@implementation PLDocumentSaverTests
+
+-(void)setUp
+{
+        [super setUp];
+        directoryPath = [[[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]
+                          stringByResolvingSymlinksInPath] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        saver = [[PLDocumentSaver alloc] init];
+        finishedSaves = [[NSMutableArray alloc] init];
+}
+
+-(void)tearDown
+{
+        [saver waitUntilAllSavesAreFinished];
+        [saver release];
+        [finishedSaves release];
+        [[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+        [directoryPath release];
+        [super tearDown];
+}
+
+-(NSString *)pathForName:(NSString *)name
+{
+        return [directoryPath stringByAppendingPathComponent:name];
+}
+
+-(void)writeFileNamed:(NSString *)name text:(NSString *)text
+{
+        XCTAssertTrue([text writeToFile:[self pathForName:name] atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+}
+
+-(NSString *)textOfFileNamed:(NSString *)name
+{
+        return [NSString stringWithContentsOfFile:[self pathForName:name] encoding:NSUTF8StringEncoding error:NULL];
+}
+
+-(ino_t)inodeOfFileNamed:(NSString *)name
+{
+        struct stat status;
+
+        XCTAssertEqual(lstat([[self pathForName:name] fileSystemRepresentation], &status), 0);
+        return status.st_ino;
+}
+
+/**
+ * \brief Save text to a file of the test directory and wait for the save to
+ *        finish.
+ *
+ * \return The finished save.
+ */
+-(PLDocumentSave *)saveText:(NSString *)text toFileNamed:(NSString *)name encoding:(NSStringEncoding)encoding lineEnding:(NSString *)lineEnding
+{
+        PLDocumentSave * save = [PLDocumentSave saveWithText:text
+                                                     fileURL:[NSURL fileURLWithPath:[self pathForName:name]]
+                                                    encoding:encoding
+                                                  lineEnding:lineEnding];
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+
+        save.completionHandler = ^(PLDocumentSave * finishedSave) {
+                [finishedSaves addObject:finishedSave];
+        };
+        [saver saveDocument:save];
+        while ([finishedSaves containsObject:save] == NO && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        XCTAssertTrue([finishedSaves containsObject:save]);
+        return save;
+}
+
+-(void)testSaveReplacesTheFileWithTheEncodingAndLineEnding
+{
+        NSData * data = nil;
+        PLDocumentSave * save = nil;
+        ino_t inode = 0;
+
+        [self writeFileNamed:@"module.py" text:@"old\n"];
+        inode = [self inodeOfFileNamed:@"module.py"];
+        save = [self saveText:@"first\nsecond\n" toFileNamed:@"module.py" encoding:NSUTF16BigEndianStringEncoding lineEnding:@"\r\n"];
+
+        XCTAssertNil(save.error);
+        data = [NSData dataWithContentsOfFile:[self pathForName:@"module.py"]];
+        XCTAssertEqualObjects(data, [@"\uFEFFfirst\r\nsecond\r\n" dataUsingEncoding:NSUTF16BigEndianStringEncoding]);
+        XCTAssertNotEqual([self inodeOfFileNamed:@"module.py"], inode);
+
+        /* No temporary file is left behind */
+        XCTAssertEqualObjects([[NSFileManager defaultManager] contentsOfDirectoryAtPath:directoryPath error:NULL], @[@"module.py"]);
+}
+
+-(void)testNewFileTakesTheCreationMask
+{
+        mode_t creationMask = umask(0);
+        NSDictionary * attributes = nil;
+
+        umask(creationMask);
+        XCTAssertNil([self saveText:@"new\n" toFileNamed:@"new.py" encoding:NSUTF8StringEncoding lineEnding:nil].error);
+
+        XCTAssertEqualObjects([self textOfFileNamed:@"new.py"], @"new\n");
+        attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:[self pathForName:@"new.py"] error:NULL];
+        XCTAssertEqual((mode_t)[attributes filePosixPermissions], (mode_t)(0666 & ~creationMask));
+}
+
+-(void)testSymbolicLinkIsKept
+{
+        NSDictionary * attributes = nil;
+
+        [self writeFileNamed:@"module.py" text:@"old\n"];
+        XCTAssertTrue([[NSFileManager defaultManager] createSymbolicLinkAtPath:[self pathForName:@"link.py"]
+                                                           withDestinationPath:[self pathForName:@"module.py"]
+                                                                         error:NULL]);
+        XCTAssertNil([self saveText:@"new\n" toFileNamed:@"link.py" encoding:NSUTF8StringEncoding lineEnding:nil].error);
+
+        attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:[self pathForName:@"link.py"] error:NULL];
+        XCTAssertEqualObjects([attributes fileType], NSFileTypeSymbolicLink);
+        XCTAssertEqualObjects([self textOfFileNamed:@"module.py"], @"new\n");
+        XCTAssertEqualObjects([self textOfFileNamed:@"link.py"], @"new\n");
+}
+
+-(void)testHardLinkedFileIsWrittenInPlace
+{
+        ino_t inode = 0;
+
+        [self writeFileNamed:@"module.py" text:@"a longer old text\n"];
+        XCTAssertTrue([[NSFileManager defaultManager] linkItemAtPath:[self pathForName:@"module.py"]
+                                                              toPath:[self pathForName:@"hardlink.py"]
+                                                               error:NULL]);
+        inode = [self inodeOfFileNamed:@"module.py"];
+        XCTAssertNil([self saveText:@"new\n" toFileNamed:@"module.py" encoding:NSUTF8StringEncoding lineEnding:nil].error);
+
+        XCTAssertEqual([self inodeOfFileNamed:@"module.py"], inode);
+        XCTAssertEqualObjects([self textOfFileNamed:@"module.py"], @"new\n");
+        XCTAssertEqualObjects([self textOfFileNamed:@"hardlink.py"], @"new\n");
+}
+
+-(void)testTextThatCannotBeEncodedLeavesTheFile
+{
+        PLDocumentSave * save = nil;
+
+        [self writeFileNamed:@"module.py" text:@"old\n"];
+        save = [self saveText:@"café\n" toFileNamed:@"module.py" encoding:NSASCIIStringEncoding lineEnding:nil];
+        XCTAssertNotNil(save.error);
+        XCTAssertEqualObjects([self textOfFileNamed:@"module.py"], @"old\n");
+
+        /* Nor a hard linked file, which would be written in place */
+        XCTAssertTrue([[NSFileManager defaultManager] linkItemAtPath:[self pathForName:@"module.py"]
+                                                              toPath:[self pathForName:@"hardlink.py"]
+                                                               error:NULL]);
+        save = [self saveText:@"café\n" toFileNamed:@"module.py" encoding:NSASCIIStringEncoding lineEnding:nil];
+        XCTAssertNotNil(save.error);
+        XCTAssertEqualObjects([self textOfFileNamed:@"module.py"], @"old\n");
+}
+
+-(void)testBatchedSavesAreWrittenTogether
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+        NSUInteger index = 0;
+
+        [saver performBatchSaves:^{
+                NSUInteger saveIndex = 0;
+
+                for (saveIndex = 0; saveIndex < 4; saveIndex++) {
+                        PLDocumentSave * save = [PLDocumentSave saveWithText:[NSString stringWithFormat:@"%lu\n", (unsigned long)saveIndex]
+                                                                     fileURL:[NSURL fileURLWithPath:[self pathForName:[NSString stringWithFormat:@"%lu.py", (unsigned long)saveIndex]]]
+                                                                    encoding:NSUTF8StringEncoding
+                                                                  lineEnding:nil];
+                        save.completionHandler = ^(PLDocumentSave * finishedSave) {
+                                [finishedSaves addObject:finishedSave];
+                        };
+                        [saver saveDocument:save];
+                }
+        }];
+        while ([finishedSaves count] < 4 && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+
+        XCTAssertEqual([finishedSaves count], (NSUInteger)4);
+        for (index = 0; index < 4; index++) {
+                XCTAssertNil([finishedSaves[index] error]);
+                XCTAssertEqualObjects([self textOfFileNamed:[NSString stringWithFormat:@"%lu.py", (unsigned long)index]],
+                                      ([NSString stringWithFormat:@"%lu\n", (unsigned long)index]));
+        }
+}
+
+@end
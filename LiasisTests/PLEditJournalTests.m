@@ -0,0 +1,301 @@
+/**
+ * \file PLEditJournalTests.m
+ * \brief Unit tests and benchmarks of the edit journal.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLEditJournal.h"
+
+/**
+ * \brief The text of the document's file.
+ */
+static NSString * const PLEditJournalTestFileText = @"import os\n\ndef main():\n    print(os.getcwd())\n";
+
+/**
+ * \brief The offset of the end offset in the header of a journal file, after
+ *        its magic and version.
+ */
+static const unsigned long long PLEditJournalTestEndOffset = 8;
+
+/**
+ * \brief The number of lines of the benchmark document.
+ */
+static const NSUInteger PLEditJournalTestLineCount = 100000;
+
+@interface PLEditJournal (Testing)
+
+-(void)compact;
+
+@end
+
+@interface PLEditJournalTests : XCTestCase
+{
+        NSURL * fileURL;
+        NSMutableArray * journals;
+}
+
+@end
+
+@implementation PLEditJournalTests
+
+-(void)setUp
+{
+        NSString * filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+
+        [super setUp];
+        fileURL = [[NSURL fileURLWithPath:[filePath stringByAppendingPathExtension:@"py"]] retain];
+        XCTAssertTrue([PLEditJournalTestFileText writeToURL:fileURL atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+        journals = [[NSMutableArray alloc] init];
+}
+
+-(void)tearDown
+{
+        for (PLEditJournal * journal in journals) {
+                [journal discard];
+        }
+        [journals release];
+        [[NSFileManager defaultManager] removeItemAtURL:fileURL error:NULL];
+        [fileURL release];
+        [super tearDown];
+}
+
+/**
+ * \brief Create a text view holding a text.
+ */
+-(NSTextView *)textViewWithString:(NSString *)string
+{
+        NSTextView * textView = [[[NSTextView alloc] initWithFrame:NSMakeRect(0.0f, 0.0f, 400.0f, 300.0f)] autorelease];
+
+        [textView setString:string];
+        return textView;
+}
+
+/**
+ * \brief Create a journal attached to a text view, discarded by `tearDown`.
+ */
+-(PLEditJournal *)journalAttachedToTextView:(NSTextView *)textView fileURL:(NSURL *)aFileURL
+{
+        PLEditJournal * journal = [PLEditJournal journalWithFileURL:aFileURL];
+
+        XCTAssertNotNil(journal);
+        [journal attachToTextView:textView viewController:nil];
+        [journals addObject:journal];
+        return journal;
+}
+
+/**
+ * \brief Open the file of a journal as if the application had stopped.
+ *
+ * \details The journal file is shared with the original journal, which is
+ *          still mapped, as it would be by the page cache after a crash.
+ */
+-(PLEditJournal *)recoveredJournalOfJournal:(PLEditJournal *)journal
+{
+        PLEditJournal * recoveredJournal = [PLEditJournal journalWithContentsOfFile:[journal valueForKey:@"path"]];
+
+        XCTAssertNotNil(recoveredJournal);
+        XCTAssertTrue([recoveredJournal isRecovered]);
+        return recoveredJournal;
+}
+
+/**
+ * \brief Make random edits of a text view's text.
+ */
+-(void)makeEditsOfTextView:(NSTextView *)textView count:(NSUInteger)count
+{
+        NSArray * words = @[@"", @"x", @"return ", @"\n    ", @"\U0001F40D", @"é"];
+        NSTextStorage * textStorage = [textView textStorage];
+        NSUInteger edit = 0, location = 0;
+
+        for (edit = 0; edit < count; edit++) {
+                location = random() % ([textStorage length] + 1);
+                if (edit % 50 == 0) {
+                        /* Edits grouped by the text storage are one record */
+                        [textStorage beginEditing];
+                        [textStorage replaceCharactersInRange:NSMakeRange(location, 0) withString:@"pass"];
+                        [textStorage replaceCharactersInRange:NSMakeRange(0, MIN([textStorage length], 2)) withString:@""];
+                        [textStorage endEditing];
+                } else {
+                        [textStorage replaceCharactersInRange:NSMakeRange(location, random() % ([textStorage length] - location + 1) % 3)
+                                                   withString:words[random() % [words count]]];
+                }
+        }
+}
+
+/**
+ * \brief Wait for a compaction to finish.
+ */
+-(void)waitForCompactionOfJournal:(PLEditJournal *)journal
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+
+        while ([[journal valueForKey:@"compacting"] boolValue] && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        XCTAssertFalse([[journal valueForKey:@"compacting"] boolValue]);
+}
+
+#pragma mark - Recovery
+
+-(void)testEditsAreReplayedIntoTheFileText
+{
+        NSTextView * textView = [self textViewWithString:PLEditJournalTestFileText];
+        NSTextView * recoveredTextView = [self textViewWithString:PLEditJournalTestFileText];
+        PLEditJournal * journal = [self journalAttachedToTextView:textView fileURL:fileURL];
+        PLEditJournal * recoveredJournal = nil;
+
+        srandom(5);
+        [self makeEditsOfTextView:textView count:2000];
+        recoveredJournal = [self recoveredJournalOfJournal:journal];
+        XCTAssertEqualObjects([[recoveredJournal fileURL] URLByStandardizingPath], [fileURL URLByStandardizingPath]);
+        XCTAssertTrue([recoveredJournal replayIntoTextView:recoveredTextView]);
+        XCTAssertEqualObjects([recoveredTextView string], [textView string]);
+        XCTAssertGreaterThan([[PLEditJournalManager sharedJournalManager] statistics].appends, (NSUInteger)0);
+}
+
+-(void)testUntitledEditsAreReplayedIntoEmptyText
+{
+        NSTextView * textView = [self textViewWithString:@""];
+        NSTextView * recoveredTextView = [self textViewWithString:@""];
+        PLEditJournal * journal = [self journalAttachedToTextView:textView fileURL:nil];
+        PLEditJournal * recoveredJournal = nil;
+
+        srandom(6);
+        [self makeEditsOfTextView:textView count:500];
+        recoveredJournal = [self recoveredJournalOfJournal:journal];
+        XCTAssertNil([recoveredJournal fileURL]);
+        XCTAssertTrue([recoveredJournal replayIntoTextView:recoveredTextView]);
+        XCTAssertEqualObjects([recoveredTextView string], [textView string]);
+}
+
+-(void)testEditsOfAChangedFileAreNotReplayed
+{
+        NSTextView * textView = [self textViewWithString:PLEditJournalTestFileText];
+        NSTextView * recoveredTextView = [self textViewWithString:@"print('changed')\n"];
+        PLEditJournal * journal = [self journalAttachedToTextView:textView fileURL:fileURL];
+
+        [[textView textStorage] replaceCharactersInRange:NSMakeRange(0, 0) withString:@"#!/usr/bin/env python\n"];
+        XCTAssertTrue([@"print('changed')\n" writeToURL:fileURL atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+        XCTAssertFalse([[self recoveredJournalOfJournal:journal] replayIntoTextView:recoveredTextView]);
+        XCTAssertEqualObjects([recoveredTextView string], @"print('changed')\n");
+}
+
+-(void)testTornRecordIsIgnored
+{
+        NSTextView * textView = [self textViewWithString:PLEditJournalTestFileText];
+        NSTextView * recoveredTextView = [self textViewWithString:PLEditJournalTestFileText];
+        PLEditJournal * journal = [self journalAttachedToTextView:textView fileURL:fileURL];
+        NSString * textBeforeLastEdit = nil;
+        NSFileHandle * fileHandle = nil;
+        uint64_t end = 0;
+        uint8_t lastByte = 0;
+
+        [[textView textStorage] replaceCharactersInRange:NSMakeRange(0, 6) withString:@"from"];
+        textBeforeLastEdit = [[[textView string] copy] autorelease];
+
+        /* Four characters fill the record without padding, so its last byte is checksummed */
+        [[textView textStorage] replaceCharactersInRange:NSMakeRange(5, 0) withString:@"sys,"];
+        fileHandle = [NSFileHandle fileHandleForUpdatingAtPath:[journal valueForKey:@"path"]];
+        [fileHandle seekToFileOffset:PLEditJournalTestEndOffset];
+        [[fileHandle readDataOfLength:sizeof(end)] getBytes:&end length:sizeof(end)];
+        [fileHandle seekToFileOffset:end - 1];
+        [[fileHandle readDataOfLength:1] getBytes:&lastByte length:1];
+        lastByte ^= 0xFF;
+        [fileHandle seekToFileOffset:end - 1];
+        [fileHandle writeData:[NSData dataWithBytes:&lastByte length:1]];
+        [fileHandle closeFile];
+
+        XCTAssertTrue([[self recoveredJournalOfJournal:journal] replayIntoTextView:recoveredTextView]);
+        XCTAssertEqualObjects([recoveredTextView string], textBeforeLastEdit);
+}
+
+#pragma mark - Compaction
+
+-(void)testCompactedJournalsReplayWithoutTheirFile
+{
+        NSTextView * textView = [self textViewWithString:PLEditJournalTestFileText];
+        NSTextView * recoveredTextView = [self textViewWithString:@"print('changed')\n"];
+        PLEditJournal * journal = [self journalAttachedToTextView:textView fileURL:fileURL];
+
+        srandom(7);
+        [self makeEditsOfTextView:textView count:500];
+        [journal compact];
+        [self waitForCompactionOfJournal:journal];
+        [self makeEditsOfTextView:textView count:100];
+
+        /* The compacted journal starts from its own copy of the text */
+        XCTAssertTrue([@"print('changed')\n" writeToURL:fileURL atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+        XCTAssertTrue([[self recoveredJournalOfJournal:journal] replayIntoTextView:recoveredTextView]);
+        XCTAssertEqualObjects([recoveredTextView string], [textView string]);
+
+        /* Appends during a compaction are carried over to the new file */
+        [journal compact];
+        [[textView textStorage] replaceCharactersInRange:NSMakeRange(0, 0) withString:@"# appended meanwhile\n"];
+        [self waitForCompactionOfJournal:journal];
+        recoveredTextView = [self textViewWithString:@""];
+        XCTAssertTrue([[self recoveredJournalOfJournal:journal] replayIntoTextView:recoveredTextView]);
+        XCTAssertEqualObjects([recoveredTextView string], [textView string]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Type into a 100,000 line document, reporting the time each
+ *        keystroke spends appending to the journal.
+ */
+-(void)testAppendingKeystrokesPerformance
+{
+        NSMutableString * text = [NSMutableString string];
+        NSTextView * textView = nil;
+        PLEditJournalManager * manager = [PLEditJournalManager sharedJournalManager];
+        PLEditJournalStatistics startStatistics = [manager statistics], statistics;
+        NSUInteger line = 0;
+
+        for (line = 0; line < PLEditJournalTestLineCount; line++) {
+                [text appendString:@"        self.value = compute(self.value)\n"];
+        }
+        textView = [self textViewWithString:text];
+        [self journalAttachedToTextView:textView fileURL:fileURL];
+
+        [self measureBlock:^{
+                NSTextStorage * textStorage = [textView textStorage];
+                NSUInteger index = 0, location = [textStorage length] / 2;
+
+                for (index = 0; index < 1000; index++) {
+                        [textStorage replaceCharactersInRange:NSMakeRange(location + index, 0) withString:@"x"];
+                }
+                [textStorage replaceCharactersInRange:NSMakeRange(location, 1000) withString:@""];
+        }];
+        statistics = [manager statistics];
+        NSLog(@"Edit journal: %.2f us per keystroke, longest %.2f us",
+              (statistics.appendTime - startStatistics.appendTime) / 1e3 / (statistics.appends - startStatistics.appends),
+              statistics.longestAppendTime / 1e3);
+#if defined(__OPTIMIZE__)
+        XCTAssertLessThan((statistics.appendTime - startStatistics.appendTime) / (statistics.appends - startStatistics.appends),
+                          PLEditJournalAppendBudget);
+#endif
+}
+
+@end
@@ -0,0 +1,181 @@
+/**
+ * \file PLFileBrowserIconCacheTests.m
+ * \brief Unit tests for the file browser icon cache.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLFileBrowserIconCache.h"
+
+@interface PLFileBrowserIconCacheTests : XCTestCase
+{
+        NSString * rootPath;
+        PLFileBrowserIconCache * iconCache;
+        NSUInteger notificationCount;
+}
+
+@end
+
+@implementation PLFileBrowserIconCacheTests
+
+-(void)setUp
+{
+        [super setUp];
+        rootPath = [[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:[rootPath stringByAppendingPathComponent:@"first"]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:NULL];
+        [[NSFileManager defaultManager] createDirectoryAtPath:[rootPath stringByAppendingPathComponent:@"second"]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:NULL];
+        iconCache = [[PLFileBrowserIconCache alloc] init];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(iconCacheDidLoadIcons:)
+                                                     name:PLFileBrowserIconCacheDidLoadIconsNotification
+                                                   object:iconCache];
+}
+
+-(void)tearDown
+{
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [iconCache release];
+        [[NSFileManager defaultManager] removeItemAtPath:rootPath error:NULL];
+        [rootPath release];
+        [super tearDown];
+}
+
+-(void)iconCacheDidLoadIcons:(NSNotification *)notification
+{
+        notificationCount++;
+}
+
+/**
+ * \brief Look up an icon until the cache answers with a loaded icon.
+ *
+ * \return The loaded icon, or the placeholder if it did not load in time.
+ */
+-(NSImage *)loadedIconForPath:(NSString *)path isDirectory:(BOOL)isDirectory
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+        NSUInteger hitCount = [iconCache hitCount];
+        NSImage * icon = [iconCache iconForPath:path isDirectory:isDirectory];
+
+        while ([iconCache hitCount] == hitCount && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+                icon = [iconCache iconForPath:path isDirectory:isDirectory];
+        }
+        return icon;
+}
+
+-(void)testMissReturnsPlaceholderAndLoadsInBackground
+{
+        NSString * path = [rootPath stringByAppendingPathComponent:@"module.py"];
+        NSImage * placeholder = [iconCache iconForPath:path isDirectory:NO];
+        NSImage * icon = nil;
+
+        XCTAssertNotNil(placeholder);
+        XCTAssertEqual([iconCache missCount], (NSUInteger)1);
+        XCTAssertEqual([iconCache hitCount], (NSUInteger)0);
+
+        icon = [self loadedIconForPath:path isDirectory:NO];
+        XCTAssertNotNil(icon);
+        XCTAssertNotEqual(icon, placeholder);
+        XCTAssertEqual([iconCache hitCount], (NSUInteger)1);
+        XCTAssertGreaterThan(notificationCount, (NSUInteger)0);
+}
+
+-(void)testIconsAreRasterizedAtBackingScale
+{
+        NSImage * icon = [self loadedIconForPath:[rootPath stringByAppendingPathComponent:@"module.py"] isDirectory:NO];
+        NSInteger pixelWidth = (NSInteger)ceil(PLFileBrowserIconCacheIconWidth * [[NSScreen mainScreen] backingScaleFactor]);
+        NSImageRep * representation = nil;
+
+        XCTAssertEqual([icon size].width, PLFileBrowserIconCacheIconWidth);
+        XCTAssertEqual([icon size].height, PLFileBrowserIconCacheIconWidth);
+        XCTAssertEqual([[icon representations] count], (NSUInteger)1);
+        representation = [[icon representations] firstObject];
+        XCTAssertTrue([representation isKindOfClass:[NSBitmapImageRep class]]);
+        XCTAssertEqual([representation pixelsWide], pixelWidth);
+        XCTAssertEqual([representation pixelsHigh], pixelWidth);
+}
+
+-(void)testFilesShareIconsByType
+{
+        NSImage * firstIcon = [self loadedIconForPath:[rootPath stringByAppendingPathComponent:@"first.py"] isDirectory:NO];
+        NSUInteger missCount = [iconCache missCount];
+        NSImage * secondIcon = [iconCache iconForPath:[rootPath stringByAppendingPathComponent:@"SECOND.PY"] isDirectory:NO];
+        NSImage * textIcon = [self loadedIconForPath:[rootPath stringByAppendingPathComponent:@"notes.txt"] isDirectory:NO];
+
+        XCTAssertEqual(secondIcon, firstIcon);
+        XCTAssertEqual([iconCache missCount], missCount + 1);
+        XCTAssertNotEqual(textIcon, firstIcon);
+}
+
+-(void)testPlainFoldersShareIcon
+{
+        NSImage * firstIcon = [self loadedIconForPath:[rootPath stringByAppendingPathComponent:@"first"] isDirectory:YES];
+        NSImage * secondIcon = [self loadedIconForPath:[rootPath stringByAppendingPathComponent:@"second"] isDirectory:YES];
+
+        XCTAssertEqual(secondIcon, firstIcon);
+}
+
+-(void)testStandardFoldersKeepTheirOwnIcon
+{
+        NSImage * plainIcon = [self loadedIconForPath:[rootPath stringByAppendingPathComponent:@"first"] isDirectory:YES];
+        NSImage * homeIcon = [self loadedIconForPath:NSHomeDirectory() isDirectory:YES];
+
+        XCTAssertNotNil(homeIcon);
+        XCTAssertNotEqual(homeIcon, plainIcon);
+}
+
+-(void)testRemoveAllIconsReturnsPlaceholdersAgain
+{
+        NSString * path = [rootPath stringByAppendingPathComponent:@"module.py"];
+        NSImage * icon = [self loadedIconForPath:path isDirectory:NO];
+        NSUInteger missCount = [iconCache missCount];
+
+        [iconCache removeAllIcons];
+
+        XCTAssertNotEqual([iconCache iconForPath:path isDirectory:NO], icon);
+        XCTAssertEqual([iconCache missCount], missCount + 1);
+}
+
+-(void)testConcurrentMissesLoadOnce
+{
+        NSUInteger index = 0;
+
+        for (index = 0; index < 100; index++) {
+                [iconCache iconForPath:[rootPath stringByAppendingPathComponent:[NSString stringWithFormat:@"%lu.py", (unsigned long)index]]
+                           isDirectory:NO];
+        }
+        XCTAssertEqual([iconCache missCount], (NSUInteger)100);
+        [self loadedIconForPath:[rootPath stringByAppendingPathComponent:@"module.py"] isDirectory:NO];
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+        /* A single load of the file type posts a single, coalesced notification */
+        XCTAssertEqual(notificationCount, (NSUInteger)1);
+}
+
+@end
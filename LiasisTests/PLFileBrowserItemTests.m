@@ -0,0 +1,242 @@
+/**
+ * \file PLFileBrowserItemTests.m
+ * \brief Unit tests for the file browser items and their directory cache.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLFileBrowserItem.h"
+#import "PLFileBrowserDirectoryCache.h"
+
+@interface PLFileBrowserItemTests : XCTestCase
+{
+        NSString * rootPath;
+}
+
+@end
+
+@implementation PLFileBrowserItemTests
+
+-(void)setUp
+{
+        [super setUp];
+        rootPath = [[[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]
+                     stringByStandardizingPath] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:[rootPath stringByAppendingPathComponent:@"package"]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:NULL];
+        [self writeFileNamed:@"module.py"];
+        [self writeFileNamed:@"notes.txt"];
+        [self writeFileNamed:@".hidden.py"];
+}
+
+-(void)tearDown
+{
+        [[PLFileBrowserDirectoryCache sharedDirectoryCache] removeContentsOfDirectoryAtPath:rootPath];
+        [[NSFileManager defaultManager] removeItemAtPath:rootPath error:NULL];
+        [rootPath release];
+        [super tearDown];
+}
+
+-(void)writeFileNamed:(NSString *)name
+{
+        XCTAssertTrue([@"x = 1\n" writeToFile:[rootPath stringByAppendingPathComponent:name]
+                                   atomically:NO
+                                     encoding:NSUTF8StringEncoding
+                                        error:NULL]);
+}
+
+/**
+ * \brief Run the main run loop, which delivers the batches, until the children
+ *        of an item have a given count.
+ */
+-(NSArray *)childNodesOfItem:(PLFileBrowserItem *)item waitingForCount:(NSUInteger)count
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+
+        while ([[item childNodes] count] != count && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        return [item childNodes];
+}
+
+/**
+ * \brief Run the main run loop long enough for pending batches to arrive.
+ */
+-(void)drainMainLoop
+{
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+}
+
+-(NSSet *)namesOfItems:(NSArray *)items
+{
+        return [NSSet setWithArray:[items valueForKey:@"representedObject"]];
+}
+
+-(void)testChildrenAreDirectoriesAndPythonFiles
+{
+        PLFileBrowserItem * root = [PLFileBrowserItem treeNodeWithPath:rootPath isDirectory:YES];
+        NSArray * children = [self childNodesOfItem:root waitingForCount:2];
+
+        XCTAssertEqualObjects([self namesOfItems:children], ([NSSet setWithObjects:@"module.py", @"package", nil]));
+        for (PLFileBrowserItem * child in children) {
+                XCTAssertEqual(child.isDirectory, [[child representedObject] isEqualToString:@"package"]);
+                XCTAssertEqualObjects(child.fullPath, [rootPath stringByAppendingPathComponent:[child representedObject]]);
+        }
+        XCTAssertTrue([root hasLoadedChildNodes]);
+}
+
+-(void)testFileItemsHaveNoChildren
+{
+        PLFileBrowserItem * file = [PLFileBrowserItem treeNodeWithPath:[rootPath stringByAppendingPathComponent:@"module.py"]
+                                                           isDirectory:NO];
+
+        XCTAssertTrue([file isLeaf]);
+        XCTAssertNil([file childNodes]);
+        XCTAssertFalse([file hasLoadedChildNodes]);
+}
+
+-(void)testCacheHoldsRecordsRatherThanItems
+{
+        PLFileBrowserItem * root = [PLFileBrowserItem treeNodeWithPath:rootPath isDirectory:YES];
+        NSArray * records = nil;
+
+        [self childNodesOfItem:root waitingForCount:2];
+        records = [[PLFileBrowserDirectoryCache sharedDirectoryCache] cachedContentsOfDirectoryAtPath:rootPath];
+
+        XCTAssertEqual([records count], (NSUInteger)2);
+        for (id record in records) {
+                XCTAssertTrue([record isKindOfClass:[PLFileBrowserDirectoryRecord class]]);
+        }
+}
+
+-(void)testTreesDoNotShareItems
+{
+        PLFileBrowserItem * firstRoot = [PLFileBrowserItem treeNodeWithPath:rootPath isDirectory:YES];
+        PLFileBrowserItem * secondRoot = [PLFileBrowserItem treeNodeWithPath:rootPath isDirectory:YES];
+        NSArray * firstChildren = [self childNodesOfItem:firstRoot waitingForCount:2];
+        NSArray * secondChildren = nil;
+
+        /* The second tree is built from the cached listing */
+        secondChildren = [[[secondRoot childNodes] copy] autorelease];
+        XCTAssertEqualObjects([self namesOfItems:secondChildren], [self namesOfItems:firstChildren]);
+        for (PLFileBrowserItem * child in secondChildren) {
+                XCTAssertEqual([firstChildren indexOfObjectIdenticalTo:child], (NSUInteger)NSNotFound);
+        }
+
+        /* Loading the children of one tree leaves the other tree untouched */
+        for (PLFileBrowserItem * child in firstChildren) {
+                if (child.isDirectory) {
+                        [child childNodes];
+                        XCTAssertTrue([child hasLoadedChildNodes]);
+                }
+        }
+        for (PLFileBrowserItem * child in secondChildren) {
+                XCTAssertFalse([child hasLoadedChildNodes]);
+        }
+}
+
+-(void)testCurrentListingIsPublished
+{
+        PLFileBrowserItem * firstRoot = [PLFileBrowserItem treeNodeWithPath:rootPath isDirectory:YES];
+        __block NSUInteger batchCount = 0;
+        __block NSArray * publishedRecords = nil;
+
+        [self childNodesOfItem:firstRoot waitingForCount:2];
+        [[PLFileBrowserDirectoryCache sharedDirectoryCache] loadContentsOfDirectoryAtPath:rootPath batchHandler:^(NSArray * records, BOOL firstBatch, BOOL lastBatch) {
+                XCTAssertTrue(firstBatch);
+                XCTAssertTrue(lastBatch);
+                batchCount++;
+                publishedRecords = [records retain];
+        }];
+        [self drainMainLoop];
+
+        XCTAssertEqual(batchCount, (NSUInteger)1);
+        XCTAssertEqual([publishedRecords count], (NSUInteger)2);
+        [publishedRecords release];
+}
+
+-(void)testNewTreeGetsChildrenWhenCachedListingIsEmpty
+{
+        NSString * emptyPath = [rootPath stringByAppendingPathComponent:@"package"];
+        PLFileBrowserItem * firstItem = [PLFileBrowserItem treeNodeWithPath:emptyPath isDirectory:YES];
+        PLFileBrowserItem * secondItem = nil;
+
+        /* Cache an empty listing, then fill the directory after its mtime */
+        [firstItem childNodes];
+        [self drainMainLoop];
+        XCTAssertEqual([[firstItem childNodes] count], (NSUInteger)0);
+        [@"x = 1\n" writeToFile:[emptyPath stringByAppendingPathComponent:@"child.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+
+        secondItem = [PLFileBrowserItem treeNodeWithPath:emptyPath isDirectory:YES];
+        XCTAssertEqualObjects([self namesOfItems:[self childNodesOfItem:secondItem waitingForCount:1]], [NSSet setWithObject:@"child.py"]);
+        [[PLFileBrowserDirectoryCache sharedDirectoryCache] removeContentsOfDirectoryAtPath:emptyPath];
+}
+
+-(void)testReloadKeepsUnchangedItems
+{
+        PLFileBrowserItem * root = [PLFileBrowserItem treeNodeWithPath:rootPath isDirectory:YES];
+        NSArray * children = [[[self childNodesOfItem:root waitingForCount:2] copy] autorelease];
+        NSArray * reloadedChildren = nil;
+
+        [self writeFileNamed:@"added.py"];
+        [[NSFileManager defaultManager] removeItemAtPath:[rootPath stringByAppendingPathComponent:@"module.py"] error:NULL];
+        [root reloadChildNodes];
+        [self drainMainLoop];
+        reloadedChildren = [self childNodesOfItem:root waitingForCount:2];
+
+        XCTAssertEqualObjects([self namesOfItems:reloadedChildren], ([NSSet setWithObjects:@"added.py", @"package", nil]));
+        for (PLFileBrowserItem * child in children) {
+                if ([[child representedObject] isEqualToString:@"package"]) {
+                        XCTAssertNotEqual([reloadedChildren indexOfObjectIdenticalTo:child], (NSUInteger)NSNotFound);
+                }
+        }
+}
+
+-(void)testOverlappingLoadsDoNotDuplicateChildren
+{
+        PLFileBrowserItem * root = [PLFileBrowserItem treeNodeWithPath:rootPath isDirectory:YES];
+
+        /* A rescan starts before the batches of the first load arrive */
+        XCTAssertEqual([[root childNodes] count], (NSUInteger)0);
+        [root reloadChildNodes];
+        [self drainMainLoop];
+
+        XCTAssertEqual([[self childNodesOfItem:root waitingForCount:2] count], (NSUInteger)2);
+        XCTAssertEqualObjects([self namesOfItems:[root childNodes]], ([NSSet setWithObjects:@"module.py", @"package", nil]));
+}
+
+-(void)testLoadedDescendantAtPath
+{
+        PLFileBrowserItem * root = [PLFileBrowserItem treeNodeWithPath:rootPath isDirectory:YES];
+        NSString * modulePath = [rootPath stringByAppendingPathComponent:@"module.py"];
+
+        XCTAssertEqual([root loadedDescendantAtPath:rootPath], root);
+        XCTAssertNil([root loadedDescendantAtPath:modulePath]);
+        [self childNodesOfItem:root waitingForCount:2];
+        XCTAssertEqualObjects([[root loadedDescendantAtPath:modulePath] fullPath], modulePath);
+        XCTAssertNil([root loadedDescendantAtPath:NSTemporaryDirectory()]);
+}
+
+@end
@@ -0,0 +1,295 @@
+/**
+ * \file PLFileSystemWatcherTests.m
+ * \brief Unit tests for the file system watcher and its native backend.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Jason Lomnitz.
+ * \author Danny Nicklas.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLFileSystemWatcher.h"
+
+#if !defined(__linux__)
+#import "PLFSEventsFileSystemWatcher.h"
+#endif
+
+/**
+ * \brief The coalescing latency of the watchers under test, in seconds.
+ */
+static const NSTimeInterval PLFileSystemWatcherTestLatency = 0.2;
+
+#if !defined(__linux__)
+
+@interface PLFSEventsFileSystemWatcher (Testing)
+
+-(void)handleEventPaths:(char **)eventPaths
+                  flags:(const FSEventStreamEventFlags *)eventFlags
+            identifiers:(const FSEventStreamEventId *)eventIdentifiers
+                  count:(size_t)count;
+
+@end
+
+#endif
+
+@interface PLFileSystemWatcherTests : XCTestCase
+{
+        NSString * rootPath;
+        NSMutableArray * batches;
+        PLFileSystemWatcherEventHandler eventHandler;
+}
+
+@end
+
+@implementation PLFileSystemWatcherTests
+
+-(void)setUp
+{
+        [super setUp];
+
+        /* Not standardized, so the native backend sees a path with symbolic links */
+        rootPath = [[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:rootPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        batches = [[NSMutableArray alloc] init];
+        eventHandler = [^(NSSet * changedDirectories, NSSet * rescannedDirectories) {
+                [batches addObject:@[changedDirectories, rescannedDirectories]];
+        } copy];
+}
+
+-(void)tearDown
+{
+        [eventHandler release];
+        [batches release];
+        [[NSFileManager defaultManager] removeItemAtPath:rootPath error:NULL];
+        [rootPath release];
+        [super tearDown];
+}
+
+/**
+ * \brief Run the main run loop, which delivers the batches.
+ */
+-(void)runMainLoopForInterval:(NSTimeInterval)interval
+{
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:interval]];
+}
+
+/**
+ * \brief Run the main run loop until a number of batches were delivered, then
+ *        for another latency, so extra batches would be noticed.
+ */
+-(void)waitForBatchCount:(NSUInteger)count
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+
+        while ([batches count] < count && [timeout timeIntervalSinceNow] > 0) {
+                [self runMainLoopForInterval:0.01];
+        }
+        [self runMainLoopForInterval:PLFileSystemWatcherTestLatency * 2];
+}
+
+/**
+ * \brief The union of the changed directories of every batch.
+ */
+-(NSSet *)allChangedDirectories
+{
+        NSMutableSet * changedDirectories = [NSMutableSet set];
+
+        for (NSArray * batch in batches) {
+                [changedDirectories unionSet:batch[0]];
+        }
+        return changedDirectories;
+}
+
+#pragma mark - Paths
+
+-(void)testPathIsWithinDirectory
+{
+        XCTAssertTrue(PLPathIsWithinDirectory(@"/a/b", @"/a/b"));
+        XCTAssertTrue(PLPathIsWithinDirectory(@"/a/b/c.py", @"/a/b"));
+        XCTAssertTrue(PLPathIsWithinDirectory(@"/a/b/c.py", @"/a/b/"));
+        XCTAssertTrue(PLPathIsWithinDirectory(@"/a", @"/"));
+        XCTAssertFalse(PLPathIsWithinDirectory(@"/a/bc", @"/a/b"));
+        XCTAssertFalse(PLPathIsWithinDirectory(@"/a", @"/a/b"));
+}
+
+#pragma mark - Coalescing
+
+-(void)testChangesFromAnyThreadAreCoalesced
+{
+        PLFileSystemWatcher * watcher = [[PLFileSystemWatcher alloc] initWithPath:rootPath
+                                                                          latency:PLFileSystemWatcherTestLatency
+                                                                     eventHandler:eventHandler];
+        NSString * packagePath = [rootPath stringByAppendingPathComponent:@"package"];
+
+        XCTAssertTrue([watcher start]);
+        dispatch_apply(100, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+                [watcher addChangedDirectory:(index % 2 ? rootPath : packagePath) recursive:NO];
+        });
+        [self waitForBatchCount:1];
+
+        XCTAssertEqual([batches count], (NSUInteger)1);
+        XCTAssertEqualObjects([batches firstObject][0], ([NSSet setWithObjects:rootPath, packagePath, nil]));
+        XCTAssertEqual([[batches firstObject][1] count], (NSUInteger)0);
+        [watcher stop];
+        [watcher release];
+}
+
+-(void)testRescanSubsumesChangesBelowIt
+{
+        PLFileSystemWatcher * watcher = [[PLFileSystemWatcher alloc] initWithPath:rootPath
+                                                                          latency:PLFileSystemWatcherTestLatency
+                                                                     eventHandler:eventHandler];
+        NSString * packagePath = [rootPath stringByAppendingPathComponent:@"package"];
+        NSString * siblingPath = [rootPath stringByAppendingPathComponent:@"sibling"];
+
+        XCTAssertTrue([watcher start]);
+        [watcher addChangedDirectory:[packagePath stringByAppendingPathComponent:@"sub"] recursive:NO];
+        [watcher addChangedDirectory:siblingPath recursive:NO];
+        [watcher addChangedDirectory:packagePath recursive:YES];
+        [self waitForBatchCount:1];
+
+        XCTAssertEqual([batches count], (NSUInteger)1);
+        XCTAssertEqualObjects([batches firstObject][0], [NSSet setWithObject:siblingPath]);
+        XCTAssertEqualObjects([batches firstObject][1], [NSSet setWithObject:packagePath]);
+        [watcher stop];
+        [watcher release];
+}
+
+-(void)testStoppedWatcherDeliversNothing
+{
+        PLFileSystemWatcher * watcher = [[PLFileSystemWatcher alloc] initWithPath:rootPath
+                                                                          latency:PLFileSystemWatcherTestLatency
+                                                                     eventHandler:eventHandler];
+
+        XCTAssertTrue([watcher start]);
+        [watcher addChangedDirectory:rootPath recursive:NO];
+        [watcher stop];
+        XCTAssertFalse(watcher.isRunning);
+        [self runMainLoopForInterval:PLFileSystemWatcherTestLatency * 3];
+
+        XCTAssertEqual([batches count], (NSUInteger)0);
+        [watcher release];
+}
+
+#pragma mark - Native Backend
+
+-(void)testNativeWatcherReportsChangesByWatchedPath
+{
+        PLFileSystemWatcher * watcher = [PLFileSystemWatcher watcherWithPath:rootPath
+                                                                     latency:PLFileSystemWatcherTestLatency
+                                                                eventHandler:eventHandler];
+
+        XCTAssertTrue([watcher start]);
+        [self runMainLoopForInterval:PLFileSystemWatcherTestLatency];
+        [@"x = 1" writeToFile:[rootPath stringByAppendingPathComponent:@"module.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+        [self waitForBatchCount:1];
+        [watcher stop];
+
+        XCTAssertGreaterThan([batches count], (NSUInteger)0);
+        XCTAssertTrue([[self allChangedDirectories] containsObject:rootPath]);
+}
+
+-(void)testNativeWatcherStopsReporting
+{
+        PLFileSystemWatcher * watcher = [PLFileSystemWatcher watcherWithPath:rootPath
+                                                                     latency:PLFileSystemWatcherTestLatency
+                                                                eventHandler:eventHandler];
+
+        XCTAssertTrue([watcher start]);
+        [self runMainLoopForInterval:PLFileSystemWatcherTestLatency];
+        [watcher stop];
+        [@"x = 1" writeToFile:[rootPath stringByAppendingPathComponent:@"module.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+        [self runMainLoopForInterval:PLFileSystemWatcherTestLatency * 3];
+
+        XCTAssertEqual([batches count], (NSUInteger)0);
+}
+
+-(void)testNativeWatcherRestarts
+{
+        PLFileSystemWatcher * watcher = [PLFileSystemWatcher watcherWithPath:rootPath
+                                                                     latency:PLFileSystemWatcherTestLatency
+                                                                eventHandler:eventHandler];
+
+        XCTAssertTrue([watcher start]);
+        [watcher stop];
+        XCTAssertTrue([watcher start]);
+        [self runMainLoopForInterval:PLFileSystemWatcherTestLatency];
+        [@"x = 1" writeToFile:[rootPath stringByAppendingPathComponent:@"module.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+        [self waitForBatchCount:1];
+        [watcher stop];
+
+        XCTAssertTrue([[self allChangedDirectories] containsObject:rootPath]);
+}
+
+#if !defined(__linux__)
+
+#pragma mark - FSEvents
+
+-(void)testFSEventsTranslatesResolvedPaths
+{
+        PLFSEventsFileSystemWatcher * watcher = [[PLFSEventsFileSystemWatcher alloc] initWithPath:rootPath
+                                                                                          latency:PLFileSystemWatcherTestLatency
+                                                                                     eventHandler:eventHandler];
+        char resolvedPath[PATH_MAX], packagePath[PATH_MAX], outsidePath[PATH_MAX];
+        char * eventPaths[] = {packagePath, outsidePath};
+        FSEventStreamEventFlags eventFlags[] = {kFSEventStreamEventFlagNone, kFSEventStreamEventFlagNone};
+        FSEventStreamEventId eventIdentifiers[] = {1, 2};
+
+        XCTAssertTrue([watcher start]);
+        XCTAssertTrue(realpath([rootPath fileSystemRepresentation], resolvedPath) != NULL);
+        snprintf(packagePath, sizeof(packagePath), "%s/package/", resolvedPath);
+        snprintf(outsidePath, sizeof(outsidePath), "%s-outside", resolvedPath);
+        [watcher handleEventPaths:eventPaths flags:eventFlags identifiers:eventIdentifiers count:2];
+        [self waitForBatchCount:1];
+
+        XCTAssertEqual([batches count], (NSUInteger)1);
+        XCTAssertEqualObjects([batches firstObject][0], [NSSet setWithObject:[rootPath stringByAppendingPathComponent:@"package"]]);
+        XCTAssertEqual([watcher lastEventIdentifier], (uint64_t)2);
+        [watcher stop];
+        [watcher release];
+}
+
+-(void)testFSEventsDroppedEventsAreRescans
+{
+        PLFSEventsFileSystemWatcher * watcher = [[PLFSEventsFileSystemWatcher alloc] initWithPath:rootPath
+                                                                                          latency:PLFileSystemWatcherTestLatency
+                                                                                     eventHandler:eventHandler];
+        char resolvedPath[PATH_MAX];
+        char * eventPaths[] = {resolvedPath, resolvedPath, resolvedPath};
+        FSEventStreamEventFlags eventFlags[] = {kFSEventStreamEventFlagMustScanSubDirs,
+                                                kFSEventStreamEventFlagRootChanged,
+                                                kFSEventStreamEventFlagHistoryDone};
+        FSEventStreamEventId eventIdentifiers[] = {1, 2, 3};
+
+        XCTAssertTrue([watcher start]);
+        XCTAssertTrue(realpath([rootPath fileSystemRepresentation], resolvedPath) != NULL);
+        [watcher handleEventPaths:eventPaths flags:eventFlags identifiers:eventIdentifiers count:3];
+        [self waitForBatchCount:1];
+
+        XCTAssertEqual([batches count], (NSUInteger)1);
+        XCTAssertEqual([[batches firstObject][0] count], (NSUInteger)0);
+        XCTAssertEqualObjects([batches firstObject][1], [NSSet setWithObject:rootPath]);
+        [watcher stop];
+        [watcher release];
+}
+
+#endif
+
+@end
@@ -0,0 +1,193 @@
+/**
+ * \file PLInotifyFileSystemWatcherTests.m
+ * \brief Unit tests for the inotify file system watcher.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Jason Lomnitz.
+ * \author Danny Nicklas.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLInotifyFileSystemWatcher.h"
+
+#if defined(__linux__)
+
+#include <sys/inotify.h>
+
+/**
+ * \brief The coalescing latency of the watchers under test, in seconds.
+ */
+static const NSTimeInterval PLInotifyTestLatency = 0.2;
+
+@interface PLInotifyFileSystemWatcher (Testing)
+
+-(void)handleEvent:(const struct inotify_event *)event;
+
+@end
+
+@interface PLInotifyFileSystemWatcherTests : XCTestCase
+{
+        NSString * rootPath;
+        NSMutableArray * batches;
+        PLInotifyFileSystemWatcher * watcher;
+}
+
+@end
+
+@implementation PLInotifyFileSystemWatcherTests
+
+-(void)setUp
+{
+        [super setUp];
+        rootPath = [[[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]
+                     stringByStandardizingPath] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:rootPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        batches = [[NSMutableArray alloc] init];
+        watcher = [[PLInotifyFileSystemWatcher alloc] initWithPath:rootPath
+                                                           latency:PLInotifyTestLatency
+                                                      eventHandler:^(NSSet * changedDirectories, NSSet * rescannedDirectories) {
+                                                              [batches addObject:@[changedDirectories, rescannedDirectories]];
+                                                      }];
+        XCTAssertTrue([watcher start]);
+
+        /* The watches are added asynchronously on the watcher's queue */
+        [self runMainLoopForInterval:PLInotifyTestLatency];
+}
+
+-(void)tearDown
+{
+        [watcher stop];
+        [watcher release];
+        [batches release];
+        [[NSFileManager defaultManager] removeItemAtPath:rootPath error:NULL];
+        [rootPath release];
+        [super tearDown];
+}
+
+/**
+ * \brief Run the main run loop, which delivers the batches.
+ */
+-(void)runMainLoopForInterval:(NSTimeInterval)interval
+{
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:interval]];
+}
+
+/**
+ * \brief Run the main run loop until a number of batches were delivered, then
+ *        for another latency, so extra batches would be noticed.
+ */
+-(void)waitForBatchCount:(NSUInteger)count
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+
+        while ([batches count] < count && [timeout timeIntervalSinceNow] > 0) {
+                [self runMainLoopForInterval:0.01];
+        }
+        [self runMainLoopForInterval:PLInotifyTestLatency * 2];
+}
+
+-(void)testBurstIsDeliveredInOneBatch
+{
+        NSString * subdirectoryPath = [rootPath stringByAppendingPathComponent:@"package"];
+
+        [@"a" writeToFile:[rootPath stringByAppendingPathComponent:@"a.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+        [[NSFileManager defaultManager] createDirectoryAtPath:subdirectoryPath withIntermediateDirectories:NO attributes:nil error:NULL];
+        [[NSFileManager defaultManager] moveItemAtPath:[rootPath stringByAppendingPathComponent:@"a.py"]
+                                                toPath:[rootPath stringByAppendingPathComponent:@"b.py"]
+                                                 error:NULL];
+        [[NSFileManager defaultManager] removeItemAtPath:[rootPath stringByAppendingPathComponent:@"b.py"] error:NULL];
+        [self waitForBatchCount:1];
+
+        XCTAssertEqual([batches count], (NSUInteger)1);
+        XCTAssertEqualObjects([batches firstObject][0], [NSSet setWithObject:rootPath]);
+        XCTAssertEqualObjects([batches firstObject][1], [NSSet setWithObject:subdirectoryPath]);
+}
+
+-(void)testChangesInNewDirectoriesAreWatched
+{
+        NSString * subdirectoryPath = [rootPath stringByAppendingPathComponent:@"package"];
+        NSString * filePath = [subdirectoryPath stringByAppendingPathComponent:@"module.py"];
+
+        [[NSFileManager defaultManager] createDirectoryAtPath:subdirectoryPath withIntermediateDirectories:NO attributes:nil error:NULL];
+        [self waitForBatchCount:1];
+        [batches removeAllObjects];
+
+        [@"x = 1" writeToFile:filePath atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+        [[NSFileManager defaultManager] moveItemAtPath:filePath toPath:[filePath stringByAppendingString:@".bak"] error:NULL];
+        [[NSFileManager defaultManager] removeItemAtPath:[filePath stringByAppendingString:@".bak"] error:NULL];
+        [self waitForBatchCount:1];
+
+        XCTAssertEqual([batches count], (NSUInteger)1);
+        XCTAssertEqualObjects([batches firstObject][0], [NSSet setWithObject:subdirectoryPath]);
+        XCTAssertEqual([[batches firstObject][1] count], (NSUInteger)0);
+}
+
+-(void)testHiddenEntriesAreIgnored
+{
+        [@"a" writeToFile:[rootPath stringByAppendingPathComponent:@".hidden"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+        [self runMainLoopForInterval:PLInotifyTestLatency * 3];
+
+        XCTAssertEqual([batches count], (NSUInteger)0);
+}
+
+-(void)testOverflowRescansRoot
+{
+        struct inotify_event overflow;
+
+        memset(&overflow, 0, sizeof(overflow));
+        overflow.wd = -1;
+        overflow.mask = IN_Q_OVERFLOW;
+        [@"a" writeToFile:[rootPath stringByAppendingPathComponent:@"a.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+        [watcher handleEvent:&overflow];
+        [self waitForBatchCount:1];
+
+        XCTAssertEqual([batches count], (NSUInteger)1);
+        XCTAssertEqual([[batches firstObject][0] count], (NSUInteger)0);
+        XCTAssertEqualObjects([batches firstObject][1], [NSSet setWithObject:rootPath]);
+}
+
+-(void)testStopWhileWatchesAreAdded
+{
+        NSString * directoryPath = nil;
+        NSUInteger index;
+
+        for (index = 0; index < 200; index++) {
+                directoryPath = [rootPath stringByAppendingPathComponent:[NSString stringWithFormat:@"package%lu", (unsigned long)index]];
+                [[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:NO attributes:nil error:NULL];
+        }
+        [self waitForBatchCount:1];
+        [batches removeAllObjects];
+
+        /* Each restart walks the tree on the event queue while stop closes the descriptor */
+        for (index = 0; index < 20; index++) {
+                [watcher stop];
+                XCTAssertTrue([watcher start]);
+        }
+        [self runMainLoopForInterval:PLInotifyTestLatency];
+        [@"a" writeToFile:[directoryPath stringByAppendingPathComponent:@"a.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+        [self waitForBatchCount:1];
+
+        XCTAssertEqual([batches count], (NSUInteger)1);
+        XCTAssertEqualObjects([batches firstObject][0], [NSSet setWithObject:directoryPath]);
+}
+
+@end
+
+#endif
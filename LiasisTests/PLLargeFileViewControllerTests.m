@@ -0,0 +1,252 @@
+/**
+ * \file PLLargeFileViewControllerTests.m
+ * \brief Unit tests for the view controller of the large file viewer.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLLargeFileViewController.h"
+#import "PLThemeTable.h"
+
+/**
+ * \brief The number of lines of the test file.
+ */
+static const NSUInteger PLLargeFileViewControllerTestLineCount = 1000;
+
+/**
+ * \brief A large file viewer exposing its index and views.
+ */
+@interface PLTestLargeFileViewController : PLLargeFileViewController
+
+-(PLLineIndex *)testLineIndex;
+
+-(PLLargeFileView *)testFileView;
+
+-(NSSearchField *)testSearchField;
+
+-(NSTextField *)testStatusField;
+
+@end
+
+@implementation PLTestLargeFileViewController
+
+-(PLLineIndex *)testLineIndex
+{
+        return lineIndex;
+}
+
+-(PLLargeFileView *)testFileView
+{
+        return fileView;
+}
+
+-(NSSearchField *)testSearchField
+{
+        return searchField;
+}
+
+-(NSTextField *)testStatusField
+{
+        return statusField;
+}
+
+@end
+
+@interface PLLargeFileViewControllerTests : XCTestCase
+{
+        NSString * directoryPath;
+        NSURL * fileURL;
+        PLTestLargeFileViewController * viewController;
+}
+
+@end
+
+@implementation PLLargeFileViewControllerTests
+
+-(void)setUp
+{
+        NSMutableString * text = [NSMutableString string];
+        NSUInteger line = 0;
+
+        [super setUp];
+        directoryPath = [[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        fileURL = [[NSURL fileURLWithPath:[directoryPath stringByAppendingPathComponent:@"data.csv"]] retain];
+
+        /* Lines 100 and 700 hold the only occurrences of "needle" */
+        for (line = 0; line < PLLargeFileViewControllerTestLineCount; line++) {
+                [text appendFormat:@"%lu,%@\n", (unsigned long)line, (line == 100 || line == 700) ? @"needle" : @"hay"];
+        }
+        XCTAssertTrue([text writeToURL:fileURL atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+        viewController = [[PLTestLargeFileViewController viewControllerWithURL:fileURL] retain];
+}
+
+-(void)tearDown
+{
+        [viewController tabSubviewShouldClose:nil];
+        [viewController release];
+        [[NSUserDefaults standardUserDefaults] removeObjectForKey:PLUserDefaultLargeFileThreshold];
+        [[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+        [fileURL release];
+        [directoryPath release];
+        [super tearDown];
+}
+
+/**
+ * \brief Load the view of the viewer and wait until its index is complete.
+ */
+-(void)loadCompleteIndex
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+
+        [viewController view];
+        while ([[viewController testLineIndex] isComplete] == NO && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+        XCTAssertTrue([[viewController testLineIndex] isComplete]);
+}
+
+/**
+ * \brief Search for the string in the search field and wait for the result.
+ */
+-(void)findNext
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+
+        [viewController findNext:nil];
+        while ([[[viewController testStatusField] stringValue] isEqualToString:@"Searching…"] && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+}
+
+-(void)testFilesFromTheThresholdAreViewed
+{
+        XCTAssertFalse([PLLargeFileViewController shouldViewFileAtURL:fileURL]);
+
+        [[NSUserDefaults standardUserDefaults] setObject:@1024 forKey:PLUserDefaultLargeFileThreshold];
+        XCTAssertTrue([PLLargeFileViewController shouldViewFileAtURL:fileURL]);
+        [[NSUserDefaults standardUserDefaults] setObject:@(1024 * 1024) forKey:PLUserDefaultLargeFileThreshold];
+        XCTAssertFalse([PLLargeFileViewController shouldViewFileAtURL:fileURL]);
+        XCTAssertFalse([PLLargeFileViewController shouldViewFileAtURL:[NSURL fileURLWithPath:[directoryPath stringByAppendingPathComponent:@"missing.csv"]]]);
+}
+
+-(void)testViewShowsTheIndexedFileWithoutADocument
+{
+        XCTAssertEqualObjects([viewController title], @"data.csv");
+        XCTAssertEqualObjects(viewController.fileURL, fileURL);
+        XCTAssertNil([viewController document]);
+
+        /* The file is only mapped when the view is loaded */
+        XCTAssertNil([viewController testLineIndex]);
+        [self loadCompleteIndex];
+
+        XCTAssertEqual([[viewController testFileView] lineIndex], [viewController testLineIndex]);
+        XCTAssertEqual([[viewController testLineIndex] lineCount], PLLargeFileViewControllerTestLineCount);
+        XCTAssertTrue([[[viewController testStatusField] stringValue] hasPrefix:@"1000 lines"]);
+        XCTAssertTrue([[[viewController testStatusField] stringValue] hasSuffix:@"read only"]);
+}
+
+-(void)testFileThatCannotBeMappedIsReported
+{
+        [viewController release];
+        viewController = [[PLTestLargeFileViewController viewControllerWithURL:[NSURL fileURLWithPath:[directoryPath stringByAppendingPathComponent:@"missing.csv"]]] retain];
+        [viewController view];
+
+        XCTAssertNil([viewController testLineIndex]);
+        XCTAssertTrue([[[viewController testStatusField] stringValue] hasPrefix:@"The file could not be mapped"]);
+
+        /* Searching without an index does nothing */
+        [[viewController testSearchField] setStringValue:@"needle"];
+        [viewController findNext:nil];
+        XCTAssertTrue([[[viewController testStatusField] stringValue] hasPrefix:@"The file could not be mapped"]);
+}
+
+-(void)testSearchesHighlightEachMatchInTurn
+{
+        [self loadCompleteIndex];
+        XCTAssertEqual([[viewController testFileView] highlightedLine], (NSUInteger)NSNotFound);
+        [[viewController testSearchField] setStringValue:@"needle"];
+
+        [self findNext];
+        XCTAssertEqual([[viewController testFileView] highlightedLine], (NSUInteger)100);
+        XCTAssertEqualObjects([[viewController testStatusField] stringValue], @"Line 101");
+
+        /* The next search starts after the match */
+        [self findNext];
+        XCTAssertEqual([[viewController testFileView] highlightedLine], (NSUInteger)700);
+        XCTAssertEqualObjects([[viewController testStatusField] stringValue], @"Line 701");
+
+        /* The search wraps around to the start of the file */
+        [self findNext];
+        XCTAssertEqual([[viewController testFileView] highlightedLine], (NSUInteger)100);
+
+        [[viewController testSearchField] setStringValue:@"thimble"];
+        [self findNext];
+        XCTAssertEqualObjects([[viewController testStatusField] stringValue], @"Not found");
+        XCTAssertEqual([[viewController testFileView] highlightedLine], (NSUInteger)100);
+}
+
+-(void)testEmptySearchDoesNothing
+{
+        [self loadCompleteIndex];
+        [[viewController testSearchField] setStringValue:@""];
+        [viewController findNext:nil];
+
+        XCTAssertFalse([[[viewController testStatusField] stringValue] isEqualToString:@"Searching…"]);
+        XCTAssertEqual([[viewController testFileView] highlightedLine], (NSUInteger)NSNotFound);
+}
+
+-(void)testFontAndThemeReachTheFileView
+{
+        NSFont * font = [NSFont userFixedPitchFontOfSize:17.0f];
+        PLThemeTable * themeTable = [PLThemeTable sharedThemeTable];
+
+        /* A font given before the view is loaded is kept for it */
+        [viewController updateFont:font];
+        [viewController view];
+        XCTAssertEqualObjects([[viewController testFileView] font], font);
+
+        font = [NSFont userFixedPitchFontOfSize:9.0f];
+        [viewController updateFont:font];
+        XCTAssertEqualObjects([[viewController testFileView] font], font);
+
+        [viewController updateThemeManager];
+        XCTAssertEqualObjects([[viewController testFileView] textColor], [themeTable color:PLThemeColorForeground]);
+        XCTAssertEqualObjects([[viewController testFileView] backgroundColor], [themeTable color:PLThemeColorBackground]);
+        XCTAssertEqualObjects([[viewController testFileView] highlightColor], [themeTable color:PLThemeColorSelection]);
+}
+
+-(void)testClosingTheTabStopsTheSearch
+{
+        [self loadCompleteIndex];
+        [[viewController testSearchField] setStringValue:@"needle"];
+        [viewController findNext:nil];
+        XCTAssertTrue([viewController tabSubviewShouldClose:nil]);
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+        XCTAssertEqualObjects([[viewController testStatusField] stringValue], @"Searching…");
+        XCTAssertEqual([[viewController testFileView] highlightedLine], (NSUInteger)NSNotFound);
+}
+
+@end
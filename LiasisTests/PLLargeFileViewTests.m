@@ -0,0 +1,409 @@
+/**
+ * \file PLLargeFileViewTests.m
+ * \brief Unit tests and benchmarks of the line index, line heights, layout
+ *        cache, and view of the large file viewer.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLLargeFileView.h"
+
+/**
+ * \brief The number of lines of the benchmark fixture.
+ */
+static const NSUInteger PLLargeFileViewTestLineCount = 200000;
+
+/**
+ * \brief The number of heights of the height tree test.
+ */
+static const NSUInteger PLLargeFileViewTestHeightCount = 5000;
+
+@interface PLLargeFileViewTests : XCTestCase
+{
+        NSString * directoryPath;
+}
+
+@end
+
+@implementation PLLargeFileViewTests
+
+-(void)setUp
+{
+        [super setUp];
+        directoryPath = [[[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]
+                          stringByStandardizingPath] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+-(void)tearDown
+{
+        [[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+        [directoryPath release];
+        [super tearDown];
+}
+
+/**
+ * \brief Write a file to the test directory and index it to completion.
+ *
+ * \return The complete index.
+ */
+-(PLLineIndex *)completeIndexOfData:(NSData *)data name:(NSString *)name
+{
+        NSURL * fileURL = [NSURL fileURLWithPath:[directoryPath stringByAppendingPathComponent:name]];
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:30.0];
+        PLLineIndex * lineIndex = nil;
+
+        XCTAssertTrue([data writeToURL:fileURL atomically:NO]);
+        lineIndex = [PLLineIndex lineIndexWithContentsOfURL:fileURL error:NULL];
+        XCTAssertNotNil(lineIndex);
+        [lineIndex buildInBackground];
+        while ([lineIndex isComplete] == NO && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        XCTAssertTrue([lineIndex isComplete]);
+        return lineIndex;
+}
+
+/**
+ * \brief Return the text of the benchmark fixture, a generated Python module.
+ */
+-(NSData *)fixtureData
+{
+        NSMutableData * data = [NSMutableData dataWithCapacity:PLLargeFileViewTestLineCount * 48];
+        NSString * line = nil;
+        NSUInteger index = 0;
+
+        for (index = 0; index < PLLargeFileViewTestLineCount; index++) {
+                switch (index % 4) {
+                case 0:
+                        line = [NSString stringWithFormat:@"def function_%lu(value):\n", (unsigned long)index];
+                        break;
+                case 1:
+                        line = @"    \"\"\"Return the value, scaled and offset by the constants of the module.\"\"\"\n";
+                        break;
+                case 2:
+                        line = @"    return value * SCALE + OFFSET\n";
+                        break;
+                default:
+                        line = @"\n";
+                        break;
+                }
+                [data appendData:[line dataUsingEncoding:NSUTF8StringEncoding]];
+        }
+        return data;
+}
+
+/**
+ * \brief Create a large file view of an index, in a scroll view of a window
+ *        that is not ordered in.
+ */
+-(PLLargeFileView *)viewOfLineIndex:(PLLineIndex *)lineIndex window:(NSWindow **)window
+{
+        NSScrollView * scrollView = nil;
+        PLLargeFileView * view = nil;
+
+        *window = [[[NSWindow alloc] initWithContentRect:NSMakeRect(0.0f, 0.0f, 800.0f, 600.0f)
+                                               styleMask:NSTitledWindowMask
+                                                 backing:NSBackingStoreBuffered
+                                                   defer:YES] autorelease];
+        [*window setReleasedWhenClosed:NO];
+        scrollView = [[[NSScrollView alloc] initWithFrame:[[*window contentView] bounds]] autorelease];
+        [scrollView setHasVerticalScroller:YES];
+        view = [[[PLLargeFileView alloc] initWithFrame:NSMakeRect(0.0f, 0.0f, [scrollView contentSize].width, [scrollView contentSize].height)] autorelease];
+        [scrollView setDocumentView:view];
+        [*window setContentView:scrollView];
+        view.lineIndex = lineIndex;
+        return view;
+}
+
+/**
+ * \brief Draw the visible rectangle of a view into a bitmap.
+ */
+-(void)drawVisibleRectOfView:(NSView *)view
+{
+        NSRect visibleRect = [view visibleRect];
+        NSBitmapImageRep * bitmap = [view bitmapImageRepForCachingDisplayInRect:visibleRect];
+
+        [view cacheDisplayInRect:visibleRect toBitmapImageRep:bitmap];
+}
+
+#pragma mark - Line Index
+
+-(void)testLinesAreFoundAcrossStrides
+{
+        NSUInteger lineCount = 3 * PLLineIndexStride + 5, line = 0, length = 0;
+        NSUInteger sampledLines[] = {0, 1, PLLineIndexStride - 1, PLLineIndexStride, PLLineIndexStride + 1, 2 * PLLineIndexStride + 7, lineCount - 1};
+        NSMutableArray * lines = [NSMutableArray array];
+        NSMutableData * data = [NSMutableData data];
+        unsigned long long * offsets = malloc(lineCount * sizeof(unsigned long long));
+        PLLineIndex * lineIndex = nil;
+        NSUInteger sample = 0;
+
+        /* Every third line ends with a carriage return, the last with nothing */
+        for (line = 0; line < lineCount; line++) {
+                offsets[line] = [data length];
+                [lines addObject:[NSString stringWithFormat:@"line %lu", (unsigned long)line]];
+                [data appendData:[lines[line] dataUsingEncoding:NSUTF8StringEncoding]];
+                if (line + 1 < lineCount) {
+                        [data appendBytes:(line % 3 == 0) ? "\r\n" : "\n" length:(line % 3 == 0) ? 2 : 1];
+                }
+        }
+        lineIndex = [self completeIndexOfData:data name:@"strides.py"];
+        XCTAssertEqual([lineIndex lineCount], lineCount);
+        XCTAssertEqual([lineIndex length], (unsigned long long)[data length]);
+        XCTAssertEqual([lineIndex progress], 1.0);
+
+        for (sample = 0; sample < sizeof(sampledLines) / sizeof(sampledLines[0]); sample++) {
+                line = sampledLines[sample];
+                XCTAssertEqual([lineIndex offsetOfLine:line], offsets[line], @"Line %lu", (unsigned long)line);
+                XCTAssertEqualObjects([lineIndex linesInRange:NSMakeRange(line, 1)], @[lines[line]]);
+                XCTAssertEqual([lineIndex getLengths:&length ofLinesInRange:NSMakeRange(line, 1)], (NSUInteger)1);
+                XCTAssertEqual(length, [lines[line] length]);
+                XCTAssertEqual([lineIndex lineContainingOffset:offsets[line]], line);
+                XCTAssertEqual([lineIndex lineContainingOffset:offsets[line] + length], line);
+        }
+        XCTAssertEqualObjects([lineIndex linesInRange:NSMakeRange(PLLineIndexStride - 2, 4)],
+                              [lines subarrayWithRange:NSMakeRange(PLLineIndexStride - 2, 4)]);
+        XCTAssertEqualObjects([lineIndex linesInRange:NSMakeRange(lineCount - 1, 10)], @[[lines lastObject]]);
+        XCTAssertEqual([lineIndex offsetOfLine:lineCount], PLLineIndexNotFound);
+        free(offsets);
+}
+
+-(void)testLongAndInvalidLinesAreCutAndDecoded
+{
+        NSMutableData * data = [NSMutableData data];
+        const char latin1Line[] = {'c', 'a', 'f', (char)0xE9, '\n'};
+        PLLineIndex * lineIndex = nil;
+        NSArray * lines = nil;
+        NSUInteger lengths[2];
+
+        [data appendData:[[@"" stringByPaddingToLength:PLLineIndexMaximumLineLength + 100 withString:@"a" startingAtIndex:0]
+                          dataUsingEncoding:NSUTF8StringEncoding]];
+        [data appendBytes:"\n" length:1];
+        [data appendBytes:latin1Line length:sizeof(latin1Line)];
+        lineIndex = [self completeIndexOfData:data name:@"long.py"];
+
+        /* The line feed ending the file does not start another line */
+        XCTAssertEqual([lineIndex lineCount], (NSUInteger)2);
+        lines = [lineIndex linesInRange:NSMakeRange(0, 2)];
+        XCTAssertEqual([lines[0] length], PLLineIndexMaximumLineLength);
+        XCTAssertEqualObjects(lines[1], @"café");
+        XCTAssertEqual([lineIndex getLengths:lengths ofLinesInRange:NSMakeRange(0, 2)], (NSUInteger)2);
+        XCTAssertEqual(lengths[0], PLLineIndexMaximumLineLength);
+        XCTAssertEqual(lengths[1], (NSUInteger)4);
+
+        lineIndex = [self completeIndexOfData:[NSData data] name:@"empty.py"];
+        XCTAssertEqual([lineIndex lineCount], (NSUInteger)0);
+        XCTAssertEqualObjects([lineIndex linesInRange:NSMakeRange(0, 1)], @[]);
+}
+
+-(void)testSearchWrapsAroundToTheStart
+{
+        PLLineIndex * lineIndex = [self completeIndexOfData:[@"import os\nneedle = 1\nprint(needle)\n" dataUsingEncoding:NSUTF8StringEncoding]
+                                                       name:@"search.py"];
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+        __block unsigned long long firstMatch = 0, wrappedMatch = 0, missingMatch = 0;
+        __block NSUInteger handlerCount = 0;
+
+        [lineIndex findString:@"needle" fromOffset:11 completionHandler:^(unsigned long long matchOffset) {
+                firstMatch = matchOffset;
+                handlerCount++;
+        }];
+        while (handlerCount < 1 && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        [lineIndex findString:@"needle" fromOffset:28 completionHandler:^(unsigned long long matchOffset) {
+                wrappedMatch = matchOffset;
+                handlerCount++;
+        }];
+        while (handlerCount < 2 && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        [lineIndex findString:@"haystack" fromOffset:0 completionHandler:^(unsigned long long matchOffset) {
+                missingMatch = matchOffset;
+                handlerCount++;
+        }];
+        while (handlerCount < 3 && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        XCTAssertEqual(handlerCount, (NSUInteger)3);
+        XCTAssertEqual(firstMatch, 27ULL);
+        XCTAssertEqual(wrappedMatch, 10ULL);
+        XCTAssertEqual(missingMatch, PLLineIndexNotFound);
+}
+
+#pragma mark - Line Heights
+
+-(void)testHeightTreeMatchesPrefixSums
+{
+        PLLineHeightTree * tree = [[[PLLineHeightTree alloc] init] autorelease];
+        CGFloat * heights = malloc(PLLargeFileViewTestHeightCount * sizeof(CGFloat));
+        CGFloat offset = 0.0f;
+        NSUInteger index = 0, change = 0;
+
+        srandom(22);
+        for (index = 0; index < PLLargeFileViewTestHeightCount; index++) {
+                heights[index] = 1 + random() % 40;
+                [tree appendHeight:heights[index]];
+        }
+        for (change = 0; change < 1000; change++) {
+                index = random() % PLLargeFileViewTestHeightCount;
+                heights[index] = 1 + random() % 40;
+                [tree setHeight:heights[index] atIndex:index];
+        }
+
+        /* The heights are whole numbers, so the sums are exact */
+        XCTAssertEqual([tree count], PLLargeFileViewTestHeightCount);
+        for (index = 0; index < PLLargeFileViewTestHeightCount; index++) {
+                XCTAssertEqual([tree offsetOfIndex:index], offset, @"Index %lu", (unsigned long)index);
+                XCTAssertEqual([tree heightAtIndex:index], heights[index]);
+                XCTAssertEqual([tree indexAtOffset:offset], index);
+                XCTAssertEqual([tree indexAtOffset:offset + heights[index] - 0.5f], index);
+                offset += heights[index];
+        }
+        XCTAssertEqual([tree totalHeight], offset);
+        XCTAssertEqual([tree offsetOfIndex:PLLargeFileViewTestHeightCount], offset);
+        XCTAssertEqual([tree indexAtOffset:-1.0f], (NSUInteger)0);
+        XCTAssertEqual([tree indexAtOffset:offset + 100.0f], PLLargeFileViewTestHeightCount - 1);
+
+        [tree removeAllHeights];
+        XCTAssertEqual([tree count], (NSUInteger)0);
+        XCTAssertEqual([tree totalHeight], (CGFloat)0.0f);
+        XCTAssertEqual([tree indexAtOffset:10.0f], (NSUInteger)0);
+        free(heights);
+}
+
+#pragma mark - Layout Cache
+
+-(void)testLayoutCacheEvictsTheLeastRecentlyUsed
+{
+        PLLineLayoutCache * cache = [PLLineLayoutCache cacheWithCapacity:3];
+
+        [cache setLayout:@[@"1"] ofLine:1];
+        [cache setLayout:@[@"2"] ofLine:2];
+        [cache setLayout:@[@"3"] ofLine:3];
+        XCTAssertEqualObjects([cache layoutOfLine:1], @[@"1"]);
+        [cache setLayout:@[@"4"] ofLine:4];
+        XCTAssertNil([cache layoutOfLine:2]);
+        XCTAssertEqualObjects([cache layoutOfLine:3], @[@"3"]);
+        XCTAssertEqualObjects([cache layoutOfLine:4], @[@"4"]);
+        XCTAssertEqualObjects([cache layoutOfLine:1], @[@"1"]);
+
+        /* Replacing a layout marks it used and evicts nothing */
+        [cache setLayout:@[@"3b"] ofLine:3];
+        [cache setLayout:@[@"5"] ofLine:5];
+        XCTAssertNil([cache layoutOfLine:4]);
+        XCTAssertEqualObjects([cache layoutOfLine:3], @[@"3b"]);
+        XCTAssertEqual(cache.hits, (NSUInteger)5);
+        XCTAssertEqual(cache.misses, (NSUInteger)2);
+
+        [cache removeAllLayouts];
+        XCTAssertNil([cache layoutOfLine:1]);
+}
+
+#pragma mark - View
+
+-(void)testScrollingToALineShowsIt
+{
+        PLLineIndex * lineIndex = [self completeIndexOfData:[self fixtureData] name:@"scroll.py"];
+        NSWindow * window = nil;
+        PLLargeFileView * view = [self viewOfLineIndex:lineIndex window:&window];
+        NSFont * font = [view font];
+        CGFloat lineHeight = ceil([font ascender] - [font descender] + [font leading]);
+        NSUInteger line = PLLargeFileViewTestLineCount * 3 / 4, visibleRows = 0;
+
+        /* Every line of the fixture fits in one row */
+        [view updateSize];
+        visibleRows = (NSUInteger)ceil(NSHeight([view visibleRect]) / lineHeight) + 1;
+        XCTAssertEqualWithAccuracy(NSHeight([view frame]), PLLargeFileViewTestLineCount * lineHeight, lineHeight);
+
+        [view scrollLineToVisible:line];
+        [self drawVisibleRectOfView:view];
+        [view scrollLineToVisible:line];
+        XCTAssertLessThanOrEqual([view firstVisibleLine], line);
+        XCTAssertGreaterThan([view firstVisibleLine] + visibleRows, line);
+
+        [view scrollLineToVisible:0];
+        XCTAssertEqual([view firstVisibleLine], (NSUInteger)0);
+        [window close];
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Open a 200,000 line module and scroll to positions across it,
+ *        reporting the time until the first screen is drawn and the time per
+ *        scrolled screen.
+ *
+ * \details The time to interactive covers mapping the file, indexing it until
+ *          the first screen of lines is found, and drawing them. The view is
+ *          drawn into a bitmap, so this measures layout rather than
+ *          compositing.
+ */
+-(void)testOpeningAndScrollingALargeFilePerformance
+{
+        NSURL * fileURL = [NSURL fileURLWithPath:[directoryPath stringByAppendingPathComponent:@"fixture.py"]];
+        __block CFTimeInterval openingTime = 0.0, scrollingTime = 0.0;
+        __block NSUInteger openedCount = 0, scrolledCount = 0;
+
+        XCTAssertTrue([[self fixtureData] writeToURL:fileURL atomically:NO]);
+        srandom(22);
+
+        [self measureBlock:^{
+                CFTimeInterval startTime = CACurrentMediaTime();
+                NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:30.0];
+                PLLineIndex * lineIndex = [PLLineIndex lineIndexWithContentsOfURL:fileURL error:NULL];
+                NSWindow * window = nil;
+                PLLargeFileView * view = nil;
+                NSUInteger scroll = 0;
+
+                [lineIndex buildInBackground];
+                view = [self viewOfLineIndex:lineIndex window:&window];
+                while ([lineIndex lineCount] < 100 && [timeout timeIntervalSinceNow] > 0) {
+                        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.0005]];
+                }
+                [view updateSize];
+                [self drawVisibleRectOfView:view];
+                openingTime += CACurrentMediaTime() - startTime;
+                openedCount++;
+
+                while ([lineIndex isComplete] == NO && [timeout timeIntervalSinceNow] > 0) {
+                        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+                }
+                [view updateSize];
+                startTime = CACurrentMediaTime();
+                for (scroll = 0; scroll < 100; scroll++) {
+                        [view scrollLineToVisible:random() % PLLargeFileViewTestLineCount];
+                        [self drawVisibleRectOfView:view];
+                }
+                scrollingTime += CACurrentMediaTime() - startTime;
+                scrolledCount += 100;
+                [lineIndex cancel];
+                [window close];
+        }];
+        NSLog(@"Large file view: %.2f ms to the first screen, %.2f ms per scrolled screen of %lu lines",
+              openingTime * 1000.0 / openedCount, scrollingTime * 1000.0 / scrolledCount, (unsigned long)PLLargeFileViewTestLineCount);
+}
+
+@end
@@ -0,0 +1,205 @@
+/**
+ * \file PLLaunchTimelineTests.m
+ * \brief Unit tests for the launch timeline.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Jason Lomnitz.
+ * \author Danny Nicklas.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLLaunchTimeline.h"
+
+/**
+ * \brief A timeline writing its log to a temporary file.
+ */
+@interface PLTestLaunchTimeline : PLLaunchTimeline
+
+@property (copy) NSString * testLogPath;
+
+@end
+
+@implementation PLTestLaunchTimeline
+
+-(void)dealloc
+{
+        [_testLogPath release];
+        [super dealloc];
+}
+
+-(NSString *)logPath
+{
+        return self.testLogPath;
+}
+
+@end
+
+@interface PLLaunchTimelineTests : XCTestCase
+{
+        NSString * logPath;
+        PLTestLaunchTimeline * timeline;
+}
+
+@end
+
+@implementation PLLaunchTimelineTests
+
+-(void)setUp
+{
+        [super setUp];
+        logPath = [[[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]
+                    stringByAppendingPathComponent:@"LaunchTimeline.jsonl"] retain];
+        timeline = [[PLTestLaunchTimeline alloc] init];
+        timeline.testLogPath = logPath;
+}
+
+-(void)tearDown
+{
+        [timeline release];
+        [[NSFileManager defaultManager] removeItemAtPath:[logPath stringByDeletingLastPathComponent] error:NULL];
+        [logPath release];
+        [super tearDown];
+}
+
+/**
+ * \brief Wait for the log to be written in the background and parse it.
+ *
+ * \return The timeline of each line of the log.
+ */
+-(NSArray *)loggedTimelinesWithCount:(NSUInteger)count
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+        NSMutableArray * timelines = [NSMutableArray array];
+        NSString * contents = nil;
+
+        do {
+                [timelines removeAllObjects];
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+                contents = [NSString stringWithContentsOfFile:logPath encoding:NSUTF8StringEncoding error:NULL];
+                for (NSString * line in [contents componentsSeparatedByString:@"\n"]) {
+                        if ([line length] > 0) {
+                                [timelines addObject:[NSJSONSerialization JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding]
+                                                                                     options:0
+                                                                                       error:NULL]];
+                        }
+                }
+        } while ([timelines count] < count && [timeout timeIntervalSinceNow] > 0);
+        return timelines;
+}
+
+-(void)testPhasesAreTimedSinceProcessStart
+{
+        NSDictionary * entry = nil;
+
+        [timeline beginPhase:@"phase"];
+        usleep(2000);
+        [timeline endPhase:@"phase"];
+
+        XCTAssertEqual([[timeline recordedEntries] count], (NSUInteger)1);
+        entry = [[timeline recordedEntries] firstObject];
+        XCTAssertEqualObjects(entry[@"name"], @"phase");
+        XCTAssertEqualObjects(entry[@"mainThread"], @YES);
+        XCTAssertGreaterThan([entry[@"start"] doubleValue], 0.0);
+        XCTAssertGreaterThanOrEqual([entry[@"end"] doubleValue] - [entry[@"start"] doubleValue], 2.0);
+}
+
+-(void)testEventsHaveEqualStartAndEnd
+{
+        NSDictionary * entry = nil;
+
+        [timeline recordEvent:@"event"];
+        entry = [[timeline recordedEntries] firstObject];
+
+        XCTAssertEqualObjects(entry[@"name"], @"event");
+        XCTAssertEqualObjects(entry[@"start"], entry[@"end"]);
+}
+
+-(void)testEntriesKeepStartOrderAndThread
+{
+        NSArray * entries = nil;
+
+        [timeline beginPhase:@"outer"];
+        dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                [timeline beginPhase:@"background"];
+                [timeline endPhase:@"background"];
+        });
+        [timeline endPhase:@"outer"];
+        [timeline endPhase:@"never begun"];
+        entries = [timeline recordedEntries];
+
+        XCTAssertEqualObjects([entries valueForKey:@"name"], (@[@"outer", @"background"]));
+        XCTAssertEqualObjects(entries[0][@"mainThread"], @YES);
+        XCTAssertEqualObjects(entries[1][@"mainThread"], @NO);
+        XCTAssertLessThanOrEqual([entries[0][@"start"] doubleValue], [entries[1][@"start"] doubleValue]);
+        XCTAssertGreaterThanOrEqual([entries[0][@"end"] doubleValue], [entries[1][@"end"] doubleValue]);
+}
+
+-(void)testFirstKeystrokeCompletesAndWritesTimeline
+{
+        NSArray * timelines = nil;
+        NSDictionary * written = nil;
+
+        [timeline beginPhase:@"nib"];
+        [timeline endPhase:@"nib"];
+        [timeline recordFirstKeystroke];
+        XCTAssertFalse([timeline isRecording]);
+
+        /* Nothing is recorded or written after recording stopped */
+        [timeline recordEvent:@"late"];
+        [timeline recordFirstKeystroke];
+        [timeline stopRecording];
+        XCTAssertEqual([[timeline recordedEntries] count], (NSUInteger)2);
+
+        timelines = [self loggedTimelinesWithCount:1];
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        XCTAssertEqual([[self loggedTimelinesWithCount:1] count], (NSUInteger)1);
+        written = [timelines firstObject];
+        XCTAssertEqualObjects(written[@"version"], @1);
+        XCTAssertEqualObjects(written[@"complete"], @YES);
+        XCTAssertEqualObjects([written[@"entries"] valueForKey:@"name"], (@[@"nib", @"first keystroke"]));
+}
+
+-(void)testStoppingWithoutKeystrokeIsIncomplete
+{
+        NSDictionary * written = nil;
+
+        [timeline beginPhase:@"unfinished"];
+        [timeline stopRecording];
+        written = [[self loggedTimelinesWithCount:1] firstObject];
+
+        XCTAssertEqualObjects(written[@"complete"], @NO);
+        XCTAssertEqualObjects([written[@"entries"] valueForKey:@"name"], @[@"unfinished"]);
+        XCTAssertNil([written[@"entries"] firstObject][@"end"]);
+}
+
+-(void)testTimelinesAreAppended
+{
+        PLTestLaunchTimeline * nextTimeline = [[PLTestLaunchTimeline alloc] init];
+
+        nextTimeline.testLogPath = logPath;
+        [timeline stopRecording];
+        XCTAssertEqual([[self loggedTimelinesWithCount:1] count], (NSUInteger)1);
+        [nextTimeline recordFirstKeystroke];
+
+        XCTAssertEqual([[self loggedTimelinesWithCount:2] count], (NSUInteger)2);
+        [nextTimeline release];
+}
+
+@end
@@ -0,0 +1,354 @@
+/**
+ * \file PLModuleIndexTests.m
+ * \brief Unit tests and benchmarks of the module index.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLModuleIndex.h"
+
+/**
+ * \brief The user default holding the environment of the last index, which
+ *        an update overwrites.
+ */
+static NSString * const PLModuleIndexTestEnvironmentDefault = @"PLModuleIndexEnvironment";
+
+/**
+ * \brief The number of packages, and of modules in each, of the benchmark
+ *        path entry.
+ */
+static const NSUInteger PLModuleIndexTestPackageCount = 200;
+static const NSUInteger PLModuleIndexTestModuleCount = 20;
+
+/**
+ * \brief The time allowed to update the benchmark index when nothing changed,
+ *        in seconds.
+ */
+static const CFTimeInterval PLModuleIndexTestUnchangedUpdateBudget = 0.05;
+
+@interface PLModuleIndex (Testing)
+
++(NSString *)indexFilePathForEnvironmentHash:(uint64_t)environmentHash;
+
+-(void)setSnapshot:(PLModuleIndexSnapshot *)newSnapshot;
+
+-(PLModuleIndexSnapshot *)snapshotOfEnvironmentHash:(uint64_t)environmentHash;
+
+-(void)updateWithPaths:(NSArray *)paths environmentHash:(uint64_t)environmentHash;
+
+@end
+
+@interface PLModuleIndexTests : XCTestCase
+{
+        /**
+         * \brief The directory holding the path entries of the test.
+         */
+        NSString * directoryPath;
+
+        /**
+         * \brief The environment hash of the indexes of the test, so their
+         *        files are apart from the application's.
+         */
+        uint64_t environmentHash;
+
+        /**
+         * \brief The environment default before the test.
+         */
+        id savedEnvironment;
+}
+
+@end
+
+@implementation PLModuleIndexTests
+
+-(void)setUp
+{
+        [super setUp];
+        directoryPath = [[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]] retain];
+        environmentHash = ((uint64_t)arc4random() << 32) | arc4random();
+        savedEnvironment = [[[NSUserDefaults standardUserDefaults] objectForKey:PLModuleIndexTestEnvironmentDefault] retain];
+}
+
+-(void)tearDown
+{
+        if (savedEnvironment) {
+                [[NSUserDefaults standardUserDefaults] setObject:savedEnvironment forKey:PLModuleIndexTestEnvironmentDefault];
+        } else {
+                [[NSUserDefaults standardUserDefaults] removeObjectForKey:PLModuleIndexTestEnvironmentDefault];
+        }
+        [[NSFileManager defaultManager] removeItemAtPath:[PLModuleIndex indexFilePathForEnvironmentHash:environmentHash] error:NULL];
+        [[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+        [savedEnvironment release];
+        [directoryPath release];
+        [super tearDown];
+}
+
+/**
+ * \brief Write a file below the test directory, creating its directories.
+ */
+-(void)writeFile:(NSString *)relativePath contents:(NSString *)contents
+{
+        NSString * path = [directoryPath stringByAppendingPathComponent:relativePath];
+
+        XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                                                withIntermediateDirectories:YES
+                                                                 attributes:nil
+                                                                      error:NULL]);
+        XCTAssertTrue([contents writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+}
+
+/**
+ * \brief Move the modification time of a directory below the test directory
+ *        forward, as adding or removing a file would, whatever the resolution
+ *        of the file system's times.
+ */
+-(void)touchDirectory:(NSString *)relativePath
+{
+        NSString * path = [directoryPath stringByAppendingPathComponent:relativePath];
+        NSDate * modificationDate = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:NULL] fileModificationDate];
+
+        XCTAssertTrue([[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate: [modificationDate dateByAddingTimeInterval:10.0]}
+                                                       ofItemAtPath:path
+                                                              error:NULL]);
+}
+
+/**
+ * \brief The full path of a path below the test directory.
+ */
+-(NSString *)fullPath:(NSString *)relativePath
+{
+        return [directoryPath stringByAppendingPathComponent:relativePath];
+}
+
+/**
+ * \brief Write a path entry of modules, packages, and namespace packages.
+ */
+-(void)writeSitePackages
+{
+        [self writeFile:@"site/alpha.py" contents:@"def run():\n    pass\n\nclass Config:\n    pass\n\n_private = 1\n"];
+        [self writeFile:@"site/beta.cpython-34m.so" contents:@""];
+        [self writeFile:@"site/gamma.pyc" contents:@""];
+        [self writeFile:@"site/gamma.py" contents:@"VALUE = 2\n"];
+        [self writeFile:@"site/.hidden.py" contents:@""];
+        [self writeFile:@"site/not-a-module.py" contents:@""];
+        [self writeFile:@"site/__pycache__/alpha.cpython-34.pyc" contents:@""];
+        [self writeFile:@"site/pkg/__init__.py" contents:@"VERSION = 1\n"];
+        [self writeFile:@"site/pkg/sub.py" contents:@"def helper():\n    pass\n"];
+        [self writeFile:@"site/pkg/inner/__init__.py" contents:@""];
+        [self writeFile:@"site/pkg/data/readme.py" contents:@""];
+        [self writeFile:@"site/ns/mod.py" contents:@""];
+}
+
+#pragma mark - Scanning
+
+-(void)testModulesPackagesAndNamespacePackagesAreFound
+{
+        PLModuleIndex * index = [[[PLModuleIndex alloc] init] autorelease];
+
+        [self writeSitePackages];
+        [index updateWithPaths:@[[self fullPath:@"site"]] environmentHash:environmentHash];
+        XCTAssertTrue([index isReady]);
+        for (NSString * moduleName in @[@"alpha", @"beta", @"gamma", @"pkg", @"pkg.sub", @"pkg.inner", @"ns", @"ns.mod"]) {
+                XCTAssertTrue([index hasModuleNamed:moduleName], @"%@", moduleName);
+        }
+
+        /* Directories without an __init__ inside a regular package are not packages */
+        XCTAssertFalse([index hasModuleNamed:@"pkg.data"]);
+        XCTAssertFalse([index hasModuleNamed:@"pkg.data.readme"]);
+        XCTAssertFalse([index hasModuleNamed:@"not-a-module"]);
+        XCTAssertFalse([index hasModuleNamed:@".hidden"]);
+        XCTAssertEqual([index numberOfModules], (NSUInteger)8);
+
+        /* A source is preferred to a compiled file */
+        XCTAssertEqualObjects([index pathOfModuleNamed:@"gamma"], [self fullPath:@"site/gamma.py"]);
+        XCTAssertEqualObjects([index pathOfModuleNamed:@"beta"], [self fullPath:@"site/beta.cpython-34m.so"]);
+        XCTAssertEqualObjects([index pathOfModuleNamed:@"pkg"], [self fullPath:@"site/pkg/__init__.py"]);
+        XCTAssertEqualObjects([index pathOfModuleNamed:@"ns"], [self fullPath:@"site/ns"]);
+        XCTAssertNil([index pathOfModuleNamed:@"missing"]);
+}
+
+-(void)testModulesAreQueriedByPrefixAndMembers
+{
+        PLModuleIndex * index = [[[PLModuleIndex alloc] init] autorelease];
+        __block NSUInteger enumeratedCount = 0;
+
+        [self writeSitePackages];
+        [index updateWithPaths:@[[self fullPath:@"site"]] environmentHash:environmentHash];
+        XCTAssertEqualObjects([index modulesWithPrefix:@"pkg" maximumCount:10], (@[@"pkg", @"pkg.inner", @"pkg.sub"]));
+        XCTAssertEqualObjects([index modulesWithPrefix:@"pkg" maximumCount:2], (@[@"pkg", @"pkg.inner"]));
+        XCTAssertEqual([[index modulesWithPrefix:@"Pkg" maximumCount:10] count], (NSUInteger)0);
+
+        /* Public top level names, then submodules, but not their own submodules */
+        XCTAssertEqualObjects([NSSet setWithArray:[index membersOfModuleNamed:@"alpha"]], ([NSSet setWithArray:@[@"run", @"Config"]]));
+        XCTAssertEqualObjects([index membersOfModuleNamed:@"pkg"], (@[@"VERSION", @"inner", @"sub"]));
+        XCTAssertEqualObjects([index membersOfModuleNamed:@"ns"], (@[@"mod"]));
+        XCTAssertEqual([[index membersOfModuleNamed:@"missing"] count], (NSUInteger)0);
+
+        [index enumerateModuleNamesUsingBlock:^(const char * name, size_t length) {
+                enumeratedCount++;
+        }];
+        XCTAssertEqual(enumeratedCount, [index numberOfModules]);
+}
+
+-(void)testTheFirstPathEntryOfAModuleWins
+{
+        PLModuleIndex * index = [[[PLModuleIndex alloc] init] autorelease];
+
+        [self writeFile:@"first/shared.py" contents:@"FIRST = 1\n"];
+        [self writeFile:@"second/shared.py" contents:@"SECOND = 2\n"];
+        [self writeFile:@"second/only.py" contents:@""];
+        [index updateWithPaths:@[[self fullPath:@"first"], [self fullPath:@"second"]] environmentHash:environmentHash];
+        XCTAssertEqualObjects([index pathOfModuleNamed:@"shared"], [self fullPath:@"first/shared.py"]);
+        XCTAssertEqualObjects([index membersOfModuleNamed:@"shared"], (@[@"FIRST"]));
+        XCTAssertEqualObjects([index pathOfModuleNamed:@"only"], [self fullPath:@"second/only.py"]);
+}
+
+#pragma mark - Index Files
+
+-(void)testIndexIsPersistedAndReloaded
+{
+        PLModuleIndex * index = [[[PLModuleIndex alloc] init] autorelease], * reopenedIndex = [[[PLModuleIndex alloc] init] autorelease];
+        NSString * indexFilePath = [PLModuleIndex indexFilePathForEnvironmentHash:environmentHash];
+        PLModuleIndexSnapshot * persistedSnapshot = nil;
+        NSMutableData * corruptData = nil;
+
+        [self writeSitePackages];
+        [index updateWithPaths:@[[self fullPath:@"site"]] environmentHash:environmentHash];
+        XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:indexFilePath]);
+        XCTAssertEqualObjects([[NSUserDefaults standardUserDefaults] stringForKey:PLModuleIndexTestEnvironmentDefault],
+                              ([NSString stringWithFormat:@"%016llx", environmentHash]));
+
+        /* The file is queryable without scanning */
+        persistedSnapshot = [reopenedIndex snapshotOfEnvironmentHash:environmentHash];
+        XCTAssertNotNil(persistedSnapshot);
+        XCTAssertFalse([reopenedIndex isReady]);
+        [reopenedIndex setSnapshot:persistedSnapshot];
+        XCTAssertEqual([reopenedIndex numberOfModules], [index numberOfModules]);
+        XCTAssertEqualObjects([reopenedIndex pathOfModuleNamed:@"pkg.sub"], [self fullPath:@"site/pkg/sub.py"]);
+        XCTAssertEqualObjects([reopenedIndex membersOfModuleNamed:@"pkg"], [index membersOfModuleNamed:@"pkg"]);
+
+        /* Another environment's file, or a truncated one, is not used */
+        XCTAssertNil([reopenedIndex snapshotOfEnvironmentHash:environmentHash + 1]);
+        corruptData = [NSMutableData dataWithContentsOfFile:indexFilePath];
+        [corruptData setLength:[corruptData length] - 1];
+        XCTAssertTrue([corruptData writeToFile:indexFilePath atomically:YES]);
+        XCTAssertNil([reopenedIndex snapshotOfEnvironmentHash:environmentHash]);
+}
+
+-(void)testOnlyChangedDirectoriesAreRead
+{
+        PLModuleIndex * index = [[[PLModuleIndex alloc] init] autorelease];
+        NSString * indexFilePath = [PLModuleIndex indexFilePathForEnvironmentHash:environmentHash];
+        NSArray * paths = nil;
+        id snapshot = nil;
+        NSDate * writeDate = nil;
+
+        [self writeSitePackages];
+        paths = @[[self fullPath:@"site"]];
+        [index updateWithPaths:paths environmentHash:environmentHash];
+        snapshot = [index valueForKey:@"snapshot"];
+        writeDate = [[[NSFileManager defaultManager] attributesOfItemAtPath:indexFilePath error:NULL] fileModificationDate];
+
+        /* Nothing changed, so neither the index nor its file is replaced */
+        [index updateWithPaths:paths environmentHash:environmentHash];
+        XCTAssertEqual([index valueForKey:@"snapshot"], snapshot);
+        XCTAssertEqualObjects([[[NSFileManager defaultManager] attributesOfItemAtPath:indexFilePath error:NULL] fileModificationDate], writeDate);
+
+        /*
+         * Rewriting a file in place leaves its directory's time alone, so its
+         * names are copied from the previous index while a package gaining a
+         * module is read again.
+         */
+        [self writeFile:@"site/alpha.py" contents:@"def renamed():\n    pass\n"];
+        [self writeFile:@"site/pkg/extra.py" contents:@""];
+        [self touchDirectory:@"site/pkg"];
+        [index updateWithPaths:paths environmentHash:environmentHash];
+        XCTAssertNotEqual([index valueForKey:@"snapshot"], snapshot);
+        XCTAssertTrue([index hasModuleNamed:@"pkg.extra"]);
+        XCTAssertTrue([index hasModuleNamed:@"pkg.inner"]);
+        XCTAssertEqualObjects([NSSet setWithArray:[index membersOfModuleNamed:@"alpha"]], ([NSSet setWithArray:@[@"run", @"Config"]]));
+
+        /* Once the directory's time changes, the file is read again */
+        [self touchDirectory:@"site"];
+        [index updateWithPaths:paths environmentHash:environmentHash];
+        XCTAssertEqualObjects([index membersOfModuleNamed:@"alpha"], (@[@"renamed"]));
+        XCTAssertTrue([index hasModuleNamed:@"pkg.extra"]);
+
+        /* A path entry removed from sys.path takes its modules with it */
+        [self writeFile:@"other/omega.py" contents:@""];
+        [index updateWithPaths:@[[self fullPath:@"other"]] environmentHash:environmentHash];
+        XCTAssertTrue([index hasModuleNamed:@"omega"]);
+        XCTAssertFalse([index hasModuleNamed:@"alpha"]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Scan a path entry of 200 packages of 20 modules, then update it with
+ *        nothing changed, reporting the time of each.
+ *
+ * \details The update after a launch is the common case, and should only
+ *          stat the directories.
+ */
+-(void)testUpdatingAnUnchangedIndexPerformance
+{
+        PLModuleIndex * index = [[[PLModuleIndex alloc] init] autorelease];
+        NSMutableArray * durations = [NSMutableArray array];
+        NSArray * paths = nil;
+        CFTimeInterval startTime = 0.0, scanTime = 0.0;
+        __block CFTimeInterval updateTime = 0.0;
+        __block NSUInteger updateCount = 0;
+        NSUInteger package = 0, module = 0;
+
+        for (package = 0; package < PLModuleIndexTestPackageCount; package++) {
+                [self writeFile:[NSString stringWithFormat:@"site/package%lu/__init__.py", (unsigned long)package] contents:@"from .module0 import *\n"];
+                for (module = 0; module < PLModuleIndexTestModuleCount; module++) {
+                        [self writeFile:[NSString stringWithFormat:@"site/package%lu/module%lu.py", (unsigned long)package, (unsigned long)module]
+                               contents:@"import os\n\nclass Handler(object):\n    def run(self):\n        return os.getcwd()\n\nDEFAULT = Handler()\n"];
+                }
+        }
+        paths = @[[self fullPath:@"site"]];
+        startTime = CACurrentMediaTime();
+        [index updateWithPaths:paths environmentHash:environmentHash];
+        scanTime = CACurrentMediaTime() - startTime;
+        XCTAssertEqual([index numberOfModules], PLModuleIndexTestPackageCount * (PLModuleIndexTestModuleCount + 1));
+
+        [self measureBlock:^{
+                CFTimeInterval updateStartTime = CACurrentMediaTime();
+
+                [index updateWithPaths:paths environmentHash:environmentHash];
+                [durations addObject:@(CACurrentMediaTime() - updateStartTime)];
+                updateTime += CACurrentMediaTime() - updateStartTime;
+                updateCount++;
+        }];
+        NSLog(@"Module index: scanned %lu modules in %.2f ms, updated them unchanged in %.2f ms",
+              (unsigned long)[index numberOfModules], scanTime * 1000.0, updateTime * 1000.0 / updateCount);
+
+#if defined(__OPTIMIZE__)
+        [durations sortUsingSelector:@selector(compare:)];
+        XCTAssertLessThan([[durations objectAtIndex:[durations count] / 2] doubleValue], PLModuleIndexTestUnchangedUpdateBudget);
+#endif
+}
+
+@end
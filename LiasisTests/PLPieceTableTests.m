@@ -0,0 +1,254 @@
+/**
+ * \file PLPieceTableTests.m
+ * \brief Unit tests and benchmarks of the piece table.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLPieceTable.h"
+
+/**
+ * \brief The number of random edits of the oracle test.
+ */
+static const NSUInteger PLPieceTableTestEditCount = 20000;
+
+/**
+ * \brief The number of lines of the benchmark text, about 50 MB of UTF-16.
+ */
+static const NSUInteger PLPieceTableTestLineCount = 1000000;
+
+/**
+ * \brief A character outside the Basic Multilingual Plane, stored as a
+ *        surrogate pair.
+ */
+static NSString * const PLPieceTableTestSurrogatePair = @"\U0001F40D";
+
+@interface PLPieceTableTests : XCTestCase
+
+@end
+
+@implementation PLPieceTableTests
+
+/**
+ * \brief Return a random string of ASCII, accented letters, line feeds, and
+ *        surrogate pairs.
+ */
+-(NSString *)randomStringWithMaximumLength:(NSUInteger)maximumLength
+{
+        NSArray * alphabet = @[@"a", @"b", @" ", @"\n", @"é", PLPieceTableTestSurrogatePair];
+        NSMutableString * string = [NSMutableString string];
+
+        while ([string length] < maximumLength) {
+                [string appendString:alphabet[random() % [alphabet count]]];
+                if (random() % 4 == 0) {
+                        break;
+                }
+        }
+        return string;
+}
+
+/**
+ * \brief Assert that the text and lines of a table match an oracle.
+ */
+-(void)assertString:(PLPieceTableString *)string equalsOracle:(NSString *)oracle
+{
+        NSUInteger length = [oracle length], index = 0, line = 0, lineStart = 0;
+
+        XCTAssertEqual([string length], length);
+        XCTAssertEqualObjects(string, oracle);
+        for (index = 0; index < length; index++) {
+                if (index == lineStart) {
+                        XCTAssertEqual([string indexOfLine:line], lineStart, @"Line %lu", (unsigned long)line);
+                }
+                XCTAssertEqual([string lineForIndex:index], line, @"Index %lu", (unsigned long)index);
+                if ([oracle characterAtIndex:index] == '\n') {
+                        line++;
+                        lineStart = index + 1;
+                }
+        }
+        XCTAssertEqual([string lineForIndex:length], line);
+        XCTAssertEqual([string lineCount], line + 1);
+        XCTAssertEqual([string indexOfLine:line], lineStart);
+        XCTAssertEqual([string indexOfLine:line + 1], (NSUInteger)NSNotFound);
+}
+
+#pragma mark - Editing
+
+-(void)testRandomEditsMatchAMutableString
+{
+        PLPieceTable * table = [[[PLPieceTable alloc] initWithString:@"def main():\n    pass\n"] autorelease];
+        NSMutableString * oracle = [NSMutableString stringWithString:@"def main():\n    pass\n"];
+        NSString * insertedString = nil;
+        NSUInteger edit = 0, location = 0, length = 0;
+
+        srandom(3);
+        for (edit = 0; edit < PLPieceTableTestEditCount; edit++) {
+                location = random() % ([oracle length] + 1);
+                length = (random() % 3 == 0) ? random() % ([oracle length] - location + 1) % 16 : 0;
+                insertedString = (random() % 5 == 0) ? @"" : [self randomStringWithMaximumLength:12];
+                [table replaceCharactersInRange:NSMakeRange(location, length) withString:insertedString];
+                [oracle replaceCharactersInRange:NSMakeRange(location, length) withString:insertedString];
+                if (edit % 1000 == 0) {
+                        [self assertString:[table string] equalsOracle:oracle];
+                }
+        }
+        [self assertString:[table string] equalsOracle:oracle];
+        XCTAssertThrows([table replaceCharactersInRange:NSMakeRange([oracle length], 1) withString:@""]);
+}
+
+-(void)testSurrogatePairsSurviveSplitsAndBlockBoundaries
+{
+        PLPieceTable * table = [[[PLPieceTable alloc] init] autorelease];
+        NSMutableString * oracle = [NSMutableString string];
+        NSString * filler = [@"" stringByPaddingToLength:PLPieceTableBlockLength - 1 withString:@"x" startingAtIndex:0];
+        NSUInteger pairIndex = 0;
+
+        /* The pair is the last character of one block and the first of the next */
+        [table replaceCharactersInRange:NSMakeRange(0, 0) withString:filler];
+        [oracle appendString:filler];
+        [table replaceCharactersInRange:NSMakeRange([oracle length], 0) withString:PLPieceTableTestSurrogatePair];
+        [oracle appendString:PLPieceTableTestSurrogatePair];
+        XCTAssertEqualObjects([table string], oracle);
+        XCTAssertEqual([[table string] rangeOfComposedCharacterSequenceAtIndex:PLPieceTableBlockLength].location, PLPieceTableBlockLength - 1);
+
+        /* Typing between the halves of a pair, then deleting what was typed */
+        pairIndex = [oracle length] - 2;
+        [table replaceCharactersInRange:NSMakeRange(pairIndex + 1, 0) withString:@"\n"];
+        [oracle replaceCharactersInRange:NSMakeRange(pairIndex + 1, 0) withString:@"\n"];
+        [self assertString:[table string] equalsOracle:oracle];
+        [table replaceCharactersInRange:NSMakeRange(pairIndex + 1, 1) withString:@""];
+        [oracle replaceCharactersInRange:NSMakeRange(pairIndex + 1, 1) withString:@""];
+        [self assertString:[table string] equalsOracle:oracle];
+        XCTAssertEqual([[table string] rangeOfComposedCharacterSequenceAtIndex:pairIndex + 1].length, (NSUInteger)2);
+
+        /* Deleting the whole pair */
+        [table replaceCharactersInRange:NSMakeRange(pairIndex, 2) withString:@""];
+        [oracle replaceCharactersInRange:NSMakeRange(pairIndex, 2) withString:@""];
+        [self assertString:[table string] equalsOracle:oracle];
+}
+
+-(void)testSnapshotsKeepTheirText
+{
+        PLPieceTable * table = [[[PLPieceTable alloc] initWithString:@"first\nsecond\n"] autorelease];
+        PLPieceTableString * snapshot = [[[table snapshot] retain] autorelease];
+        PLPieceTableString * copiedSnapshot = [[[table string] copy] autorelease];
+        PLPieceTable * sharingTable = nil;
+
+        XCTAssertEqual([table snapshot], snapshot);
+        [table replaceCharactersInRange:NSMakeRange(0, 5) withString:@"1st"];
+        XCTAssertEqualObjects(snapshot, @"first\nsecond\n");
+        XCTAssertEqualObjects(copiedSnapshot, @"first\nsecond\n");
+        XCTAssertEqualObjects([table string], @"1st\nsecond\n");
+        XCTAssertNotEqual([table snapshot], snapshot);
+        XCTAssertEqual([[snapshot copy] autorelease], snapshot);
+
+        /* A table created from a snapshot shares its pieces and edits separately */
+        sharingTable = [[[PLPieceTable alloc] initWithString:snapshot] autorelease];
+        [sharingTable replaceCharactersInRange:NSMakeRange(6, 6) withString:@"2nd"];
+        XCTAssertEqualObjects([sharingTable string], @"first\n2nd\n");
+        XCTAssertEqualObjects(snapshot, @"first\nsecond\n");
+}
+
+#pragma mark - Files
+
+-(void)testUTF8DataIsDecodedAcrossChunks
+{
+        NSMutableString * expected = [NSMutableString string];
+        NSMutableData * data = [NSMutableData data];
+        NSString * filler = [@"" stringByPaddingToLength:PLPieceTableChunkLength - 2 withString:@"y" startingAtIndex:0];
+        const uint8_t byteOrderMark[] = {0xEF, 0xBB, 0xBF};
+        PLPieceTable * table = nil;
+        NSUInteger paddingLength = 0;
+
+        /* A four byte character straddling the end of the first chunk */
+        [data appendBytes:byteOrderMark length:sizeof(byteOrderMark)];
+        [data appendData:[filler dataUsingEncoding:NSUTF8StringEncoding]];
+        [data appendData:[PLPieceTableTestSurrogatePair dataUsingEncoding:NSUTF8StringEncoding]];
+        [expected appendString:filler];
+        [expected appendString:PLPieceTableTestSurrogatePair];
+
+        /* A carriage return and line feed straddling the end of the second */
+        paddingLength = 2 * PLPieceTableChunkLength - [data length];
+        [data appendData:[[filler substringToIndex:paddingLength] dataUsingEncoding:NSUTF8StringEncoding]];
+        [expected appendString:[filler substringToIndex:paddingLength]];
+        [data appendBytes:"\r\nold mac\rend\n" length:14];
+        [expected appendString:@"\nold mac\nend\n"];
+
+        table = [[[PLPieceTable alloc] initWithUTF8Data:data preambleLength:sizeof(byteOrderMark)] autorelease];
+        XCTAssertNotNil(table);
+        [self assertString:[table string] equalsOracle:expected];
+}
+
+-(void)testInvalidUTF8DataIsRejected
+{
+        const uint8_t bytes[] = {'a', 0xC3, 0x28, '\n'};
+
+        XCTAssertNil([[[PLPieceTable alloc] initWithUTF8Data:[NSData dataWithBytes:bytes length:sizeof(bytes)] preambleLength:0] autorelease]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Type near the top of a 50 MB file, then replace a word on each of
+ *        its last 10,000 lines as a replace all would, reporting the time per
+ *        edit.
+ */
+-(void)testEditingNearTheTopOfALargeFilePerformance
+{
+        NSMutableString * text = [NSMutableString stringWithCapacity:PLPieceTableTestLineCount * 25];
+        __block CFTimeInterval typingTime = 0.0, replacingTime = 0.0;
+        __block NSUInteger typedCount = 0, replacedCount = 0;
+        NSUInteger line = 0;
+
+        for (line = 0; line < PLPieceTableTestLineCount; line++) {
+                [text appendString:@"    value = compute(x)\n"];
+        }
+
+        [self measureBlock:^{
+                PLPieceTable * table = [[PLPieceTable alloc] initWithString:text];
+                PLPieceTableString * string = [table string];
+                CFTimeInterval startTime = CACurrentMediaTime();
+                NSUInteger index = 0, lineNumber = 0;
+
+                for (index = 0; index < 1000; index++) {
+                        [table replaceCharactersInRange:NSMakeRange(4 + index, 0) withString:@"v"];
+                }
+                typingTime += CACurrentMediaTime() - startTime;
+                typedCount += 1000;
+
+                /* Replace all, from the end so earlier matches keep their indexes */
+                startTime = CACurrentMediaTime();
+                for (lineNumber = [string lineCount] - 2; lineNumber > [string lineCount] - 10002; lineNumber--) {
+                        [table replaceCharactersInRange:NSMakeRange([string indexOfLine:lineNumber] + 12, 7) withString:@"evaluate"];
+                }
+                replacingTime += CACurrentMediaTime() - startTime;
+                replacedCount += 10000;
+                XCTAssertEqual([string lineCount], PLPieceTableTestLineCount + 1);
+                [table release];
+        }];
+        NSLog(@"Piece table: %.2f us per keystroke, %.2f us per replacement in %lu lines",
+              typingTime * 1e6 / typedCount, replacingTime * 1e6 / replacedCount, (unsigned long)PLPieceTableTestLineCount);
+}
+
+@end
@@ -0,0 +1,225 @@
+/**
+ * \file PLPieceTableTextStorageTests.m
+ * \brief Unit tests and benchmarks of the piece table text storage.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLPieceTableTextStorage.h"
+
+/**
+ * \brief The attribute the tests style runs with.
+ */
+static NSString * const PLPieceTableTextStorageTestStyle = @"PLPieceTableTextStorageTestStyle";
+
+/**
+ * \brief The number of random edits of the oracle test.
+ */
+static const NSUInteger PLPieceTableTextStorageTestEditCount = 5000;
+
+/**
+ * \brief The number of lines of the benchmark text.
+ */
+static const NSUInteger PLPieceTableTextStorageTestLineCount = 100000;
+
+@interface PLPieceTableTextStorageTests : XCTestCase
+
+@end
+
+@implementation PLPieceTableTextStorageTests
+
+/**
+ * \brief Return the attributes of a style.
+ */
+-(NSDictionary *)attributesOfStyle:(NSUInteger)style
+{
+        return (style == 0) ? @{} : @{PLPieceTableTextStorageTestStyle: @(style)};
+}
+
+/**
+ * \brief Assert that the text and attribute runs of a storage match an
+ *        oracle, and that no two neighbouring runs have equal attributes.
+ */
+-(void)assertStorage:(PLPieceTableTextStorage *)storage equalsOracle:(NSAttributedString *)oracle
+{
+        NSUInteger length = [oracle length], location = 0;
+        NSDictionary * attributes = nil;
+        NSRange range, oracleRange;
+
+        XCTAssertEqualObjects([storage string], [oracle string]);
+        while (location < length) {
+                attributes = [storage attributesAtIndex:location effectiveRange:&range];
+                XCTAssertEqualObjects(attributes, [oracle attributesAtIndex:location longestEffectiveRange:&oracleRange inRange:NSMakeRange(0, length)]);
+                XCTAssertTrue(NSEqualRanges(range, oracleRange), @"Run %@ instead of %@", NSStringFromRange(range), NSStringFromRange(oracleRange));
+                XCTAssertEqual(range.location, location);
+                if (range.length == 0) {
+                        break;
+                }
+                location = NSMaxRange(range);
+        }
+        XCTAssertThrows([storage attributesAtIndex:length effectiveRange:NULL]);
+}
+
+#pragma mark - Attribute Runs
+
+-(void)testRandomEditsKeepAttributeRunsInStep
+{
+        PLPieceTableTextStorage * storage = [PLPieceTableTextStorage textStorageWithString:@"class Spam:\n    pass\n"];
+        NSMutableAttributedString * oracle = [[[NSMutableAttributedString alloc] initWithString:@"class Spam:\n    pass\n"] autorelease];
+        NSArray * words = @[@"", @"x", @"def", @" ", @"\n", @"return None\n"];
+        NSString * word = nil;
+        NSUInteger edit = 0, location = 0, length = 0, style = 0;
+
+        srandom(4);
+        for (edit = 0; edit < PLPieceTableTextStorageTestEditCount; edit++) {
+                location = random() % ([oracle length] + 1);
+                length = random() % ([oracle length] - location + 1) % 24;
+                style = random() % 4;
+                switch (random() % 3) {
+                case 0:
+                        word = words[random() % [words count]];
+                        [storage replaceCharactersInRange:NSMakeRange(location, length % 4) withString:word];
+                        [oracle replaceCharactersInRange:NSMakeRange(location, length % 4) withString:word];
+                        break;
+                case 1:
+                        [storage setAttributes:[self attributesOfStyle:style] range:NSMakeRange(location, length)];
+                        [oracle setAttributes:[self attributesOfStyle:style] range:NSMakeRange(location, length)];
+                        break;
+                default:
+                        [storage addAttribute:NSToolTipAttributeName value:@(style) range:NSMakeRange(location, length)];
+                        [oracle addAttribute:NSToolTipAttributeName value:@(style) range:NSMakeRange(location, length)];
+                        break;
+                }
+                if (edit % 250 == 0) {
+                        [self assertStorage:storage equalsOracle:oracle];
+                }
+        }
+        [self assertStorage:storage equalsOracle:oracle];
+}
+
+-(void)testInsertedTextTakesTheAttributesOfItsNeighbour
+{
+        PLPieceTableTextStorage * storage = [PLPieceTableTextStorage textStorageWithString:@"abc"];
+        NSUInteger length = 0;
+
+        [storage setAttributes:[self attributesOfStyle:1] range:NSMakeRange(0, 1)];
+        [storage setAttributes:[self attributesOfStyle:2] range:NSMakeRange(1, 2)];
+
+        /* The first character inserted at the start, the one before otherwise */
+        [storage replaceCharactersInRange:NSMakeRange(0, 0) withString:@"<"];
+        [storage replaceCharactersInRange:NSMakeRange([storage length], 0) withString:@">"];
+        XCTAssertEqualObjects([storage attributesAtIndex:0 effectiveRange:NULL], [self attributesOfStyle:1]);
+        XCTAssertEqualObjects([storage attributesAtIndex:[storage length] - 1 effectiveRange:NULL], [self attributesOfStyle:2]);
+
+        /* The first replaced character */
+        [storage replaceCharactersInRange:NSMakeRange(1, 2) withString:@"xyz"];
+        XCTAssertEqualObjects([[storage string] substringWithRange:NSMakeRange(0, 5)], @"<xyzc");
+        XCTAssertEqualObjects([storage attributesAtIndex:3 effectiveRange:NULL], [self attributesOfStyle:1]);
+
+        /* No attributes once the text has been emptied */
+        length = [storage length];
+        [storage replaceCharactersInRange:NSMakeRange(0, length) withString:@""];
+        [storage replaceCharactersInRange:NSMakeRange(0, 0) withString:@"new"];
+        XCTAssertEqualObjects([storage attributesAtIndex:0 effectiveRange:NULL], @{});
+}
+
+#pragma mark - Text
+
+-(void)testStorageSharesThePiecesOfASnapshot
+{
+        PLPieceTable * table = [[[PLPieceTable alloc] initWithString:@"import os\n"] autorelease];
+        PLPieceTableString * snapshot = [table snapshot];
+        PLPieceTableTextStorage * storage = [PLPieceTableTextStorage textStorageWithString:snapshot];
+        NSString * storageSnapshot = nil;
+
+        XCTAssertEqualObjects([storage string], @"import os\n");
+        storageSnapshot = [[[storage string] copy] autorelease];
+        XCTAssertTrue([storageSnapshot isKindOfClass:[PLPieceTableString class]]);
+        [storage replaceCharactersInRange:NSMakeRange(7, 2) withString:@"sys"];
+        XCTAssertEqualObjects([storage string], @"import sys\n");
+        XCTAssertEqualObjects(storageSnapshot, @"import os\n");
+        XCTAssertEqualObjects(snapshot, @"import os\n");
+        XCTAssertEqual([[storage pieceTable] string], [storage string]);
+}
+
+-(void)testTextViewEditsTheInstalledStorage
+{
+        NSTextView * textView = [[[NSTextView alloc] initWithFrame:NSMakeRect(0.0f, 0.0f, 400.0f, 300.0f)] autorelease];
+        PLPieceTableTextStorage * storage = [PLPieceTableTextStorage textStorageWithString:@"print(x)\n"];
+
+        [[textView layoutManager] replaceTextStorage:storage];
+        XCTAssertEqual([textView textStorage], (NSTextStorage *)storage);
+        [textView setSelectedRange:NSMakeRange(6, 1)];
+        [textView insertText:@"value"];
+        XCTAssertEqualObjects([storage string], @"print(value)\n");
+        XCTAssertEqualObjects([textView string], @"print(value)\n");
+        XCTAssertEqual([[textView layoutManager] numberOfGlyphs], [storage length]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Type near the top of a 100,000 line file highlighted in several
+ *        runs per line, reporting the time per keystroke.
+ *
+ * \details The 300,000 runs after the keystrokes are never touched, so the
+ *          time per keystroke should not grow with the file.
+ */
+-(void)testTypingInAHighlightedFilePerformance
+{
+        NSMutableString * text = [NSMutableString string];
+        PLPieceTableTextStorage * storage = nil;
+        __block CFTimeInterval typingTime = 0.0;
+        __block NSUInteger typedCount = 0;
+        NSUInteger line = 0;
+
+        for (line = 0; line < PLPieceTableTextStorageTestLineCount; line++) {
+                [text appendString:@"    return self.value  # cached\n"];
+        }
+        storage = [PLPieceTableTextStorage textStorageWithString:text];
+        [storage beginEditing];
+        for (line = 0; line < PLPieceTableTextStorageTestLineCount; line++) {
+                [storage setAttributes:[self attributesOfStyle:1] range:NSMakeRange(line * 32 + 4, 6)];
+                [storage setAttributes:[self attributesOfStyle:2] range:NSMakeRange(line * 32 + 11, 4)];
+                [storage setAttributes:[self attributesOfStyle:3] range:NSMakeRange(line * 32 + 23, 8)];
+        }
+        [storage endEditing];
+
+        [self measureBlock:^{
+                CFTimeInterval startTime = CACurrentMediaTime();
+                NSUInteger index = 0;
+
+                for (index = 0; index < 1000; index++) {
+                        [storage replaceCharactersInRange:NSMakeRange(4, 0) withString:@"r"];
+                }
+                [storage replaceCharactersInRange:NSMakeRange(4, 1000) withString:@""];
+                typingTime += CACurrentMediaTime() - startTime;
+                typedCount += 1000;
+        }];
+        XCTAssertEqualObjects([storage string], text);
+        NSLog(@"Piece table text storage: %.2f us per keystroke in %lu lines",
+              typingTime * 1e6 / typedCount, (unsigned long)PLPieceTableTextStorageTestLineCount);
+}
+
+@end
@@ -0,0 +1,238 @@
+/**
+ * \file PLProjectIndexTests.m
+ * \brief Unit tests and benchmarks of the project index.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Jason Lomnitz.
+ * \author Danny Nicklas.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLProjectIndex+Private.h"
+
+/**
+ * \brief The root of the indexes under test. It is never read.
+ */
+static NSString * const PLProjectIndexTestRoot = @"/PLProjectIndexTests/project";
+
+/**
+ * \brief The sizes of the header and records of the index file format.
+ */
+static const size_t PLProjectIndexTestHeaderSize = 80;
+static const size_t PLProjectIndexTestDirectorySize = 16;
+
+/**
+ * \brief The time allowed to rank the benchmark index for one keystroke, in
+ *        seconds.
+ */
+static const CFTimeInterval PLProjectIndexTestKeystrokeBudget = 0.016;
+
+@interface PLProjectIndexTests : XCTestCase
+
+@end
+
+@implementation PLProjectIndexTests
+
+/**
+ * \brief Build index data of relative file paths.
+ */
+-(NSData *)indexDataWithPaths:(NSArray *)relativePaths
+{
+        PLProjectIndexBuilder * builder = [[[PLProjectIndexBuilder alloc] initWithRootPath:PLProjectIndexTestRoot] autorelease];
+        const char * name = NULL;
+
+        for (NSString * relativePath in relativePaths) {
+                name = [[relativePath lastPathComponent] fileSystemRepresentation];
+                [builder addFileNamed:name
+                               length:strlen(name)
+                       directoryIndex:[builder indexOfDirectoryAtPath:[relativePath stringByDeletingLastPathComponent]]
+                        characterMask:0];
+        }
+        return [builder dataWithLastEventIdentifier:0 eventHistoryIdentifier:nil];
+}
+
+/**
+ * \brief Create an index that is never opened or watched, searching relative
+ *        file paths.
+ */
+-(PLProjectIndex *)indexWithPaths:(NSArray *)relativePaths
+{
+        PLProjectIndex * index = [[[PLProjectIndex alloc] initWithDirectoryPath:PLProjectIndexTestRoot] autorelease];
+
+        [index setSnapshot:[[[PLProjectIndexSnapshot alloc] initWithData:[self indexDataWithPaths:relativePaths]
+                                                                rootPath:PLProjectIndexTestRoot] autorelease]];
+        return index;
+}
+
+/**
+ * \brief The full path of a relative path.
+ */
+-(NSString *)fullPath:(NSString *)relativePath
+{
+        return [PLProjectIndexTestRoot stringByAppendingPathComponent:relativePath];
+}
+
+#pragma mark - Scoring
+
+-(void)testNameMatchesRankAboveDirectoryMatches
+{
+        PLProjectIndex * index = [self indexWithPaths:@[@"user/readme.md", @"docs/nausea_error.txt", @"src/models/user.py"]];
+        NSArray * paths = [index pathsMatchingQuery:@"user" maximumCount:10];
+
+        XCTAssertEqual([paths count], (NSUInteger)3);
+        XCTAssertEqualObjects([paths firstObject], [self fullPath:@"src/models/user.py"]);
+        XCTAssertEqualObjects([paths lastObject], [self fullPath:@"user/readme.md"]);
+}
+
+-(void)testWordStartsAndShorterNamesRankFirst
+{
+        PLProjectIndex * index = [self indexWithPaths:@[@"a/project_index_tests.m", @"a/pxlix.m", @"a/PLProjectIndex.m"]];
+        NSArray * paths = [index pathsMatchingQuery:@"pi" maximumCount:10];
+
+        XCTAssertEqualObjects(paths, (@[[self fullPath:@"a/PLProjectIndex.m"],
+                                        [self fullPath:@"a/project_index_tests.m"],
+                                        [self fullPath:@"a/pxlix.m"]]));
+}
+
+-(void)testQueriesIgnoreCaseAndSpaces
+{
+        PLProjectIndex * index = [self indexWithPaths:@[@"Liasis/PLTabBar.m"]];
+
+        XCTAssertEqualObjects([index pathsMatchingQuery:@"TAB bar" maximumCount:1], @[[self fullPath:@"Liasis/PLTabBar.m"]]);
+        XCTAssertEqual([[index pathsMatchingQuery:@"tabz" maximumCount:1] count], (NSUInteger)0);
+        XCTAssertEqual([[index pathsMatchingQuery:@"" maximumCount:1] count], (NSUInteger)0);
+}
+
+-(void)testTopMatchesAreKeptAcrossChunks
+{
+        NSMutableArray * relativePaths = [NSMutableArray array];
+        NSMutableArray * expectedPaths = [NSMutableArray array];
+        NSMutableString * name = nil;
+        NSUInteger i = 0, length = 0;
+
+        /* Names starting with the query score by length alone, shorter first, ties in index order */
+        srandom(1);
+        for (i = 0; i < 50000; i++) {
+                name = [NSMutableString stringWithString:@"x"];
+                for (length = random() % 40; length > 0; length--) {
+                        [name appendString:@"a"];
+                }
+                [relativePaths addObject:[NSString stringWithFormat:@"d%lu/%@%lu.py", (unsigned long)(i % 97), name, (unsigned long)i]];
+        }
+        [expectedPaths addObjectsFromArray:relativePaths];
+        [expectedPaths sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(NSString * first, NSString * second) {
+                NSUInteger firstLength = [[first lastPathComponent] length], secondLength = [[second lastPathComponent] length];
+
+                return (firstLength < secondLength) ? NSOrderedAscending : (firstLength > secondLength) ? NSOrderedDescending : NSOrderedSame;
+        }];
+        for (i = 0; i < 20; i++) {
+                [expectedPaths replaceObjectAtIndex:i withObject:[self fullPath:[expectedPaths objectAtIndex:i]]];
+        }
+
+        XCTAssertEqualObjects([[self indexWithPaths:relativePaths] pathsMatchingQuery:@"x" maximumCount:20],
+                              [expectedPaths subarrayWithRange:NSMakeRange(0, 20)]);
+}
+
+#pragma mark - File Format
+
+-(void)testValidIndexDataIsAccepted
+{
+        NSData * indexData = [self indexDataWithPaths:@[@"a/b.py", @"c.py"]];
+
+        XCTAssertNotNil([[[PLProjectIndexSnapshot alloc] initWithData:indexData rootPath:PLProjectIndexTestRoot] autorelease]);
+}
+
+-(void)testIndexOfAnotherRootIsRejected
+{
+        NSData * indexData = [self indexDataWithPaths:@[@"a/b.py"]];
+
+        XCTAssertNil([[[PLProjectIndexSnapshot alloc] initWithData:indexData rootPath:@"/PLProjectIndexTests/other"] autorelease]);
+}
+
+-(void)testTruncatedIndexDataIsRejected
+{
+        NSData * indexData = [self indexDataWithPaths:@[@"a/b.py"]];
+        NSUInteger length = 0;
+
+        for (length = 0; length < [indexData length]; length += 7) {
+                XCTAssertNil([[[PLProjectIndexSnapshot alloc] initWithData:[indexData subdataWithRange:NSMakeRange(0, length)]
+                                                                  rootPath:PLProjectIndexTestRoot] autorelease]);
+        }
+}
+
+-(void)testCorruptIndexDataIsRejected
+{
+        NSMutableData * indexData = [[[self indexDataWithPaths:@[@"a/b.py"]] mutableCopy] autorelease];
+        uint32_t * words = [indexData mutableBytes];
+        uint32_t magic = words[0], outOfRange = UINT32_MAX - 1;
+
+        /* Magic */
+        words[0] = 0;
+        XCTAssertNil([[[PLProjectIndexSnapshot alloc] initWithData:indexData rootPath:PLProjectIndexTestRoot] autorelease]);
+        words[0] = magic;
+
+        /* Version */
+        words[1]++;
+        XCTAssertNil([[[PLProjectIndexSnapshot alloc] initWithData:indexData rootPath:PLProjectIndexTestRoot] autorelease]);
+        words[1]--;
+
+        /* The name offset of the only file, after the header and the one directory */
+        [indexData replaceBytesInRange:NSMakeRange(PLProjectIndexTestHeaderSize + PLProjectIndexTestDirectorySize + sizeof(uint32_t), sizeof(uint32_t))
+                             withBytes:&outOfRange];
+        XCTAssertNil([[[PLProjectIndexSnapshot alloc] initWithData:indexData rootPath:PLProjectIndexTestRoot] autorelease]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Rank 500,000 paths for a keystroke, which must fit in a frame.
+ */
+-(void)testRankingHalfAMillionPathsPerformance
+{
+        NSMutableArray * relativePaths = [NSMutableArray arrayWithCapacity:500000];
+        NSArray * components = @[@"src", @"lib", @"tests", @"models", @"views", @"utils", @"core", @"api", @"docs", @"build"];
+        NSArray * stems = @[@"index", @"project", @"window", @"controller", @"parser", @"search", @"layout", @"render", @"cache", @"file"];
+        NSMutableArray * durations = [NSMutableArray array];
+        PLProjectIndex * index = nil;
+        NSUInteger i = 0;
+
+        srandom(2);
+        for (i = 0; i < 500000; i++) {
+                [relativePaths addObject:[NSString stringWithFormat:@"%@/%@/%@%lu/%@_%@%lu.py",
+                                          components[random() % 10], components[random() % 10], components[random() % 10],
+                                          (unsigned long)(i % 503), stems[random() % 10], stems[random() % 10], (unsigned long)i]];
+        }
+        index = [self indexWithPaths:relativePaths];
+        XCTAssertEqual([index numberOfFiles], (NSUInteger)500000);
+
+        [self measureBlock:^{
+                CFTimeInterval startTime = CACurrentMediaTime();
+
+                XCTAssertGreaterThan([[index pathsMatchingQuery:@"prjidx" maximumCount:50] count], (NSUInteger)0);
+                [durations addObject:@(CACurrentMediaTime() - startTime)];
+        }];
+#if defined(__OPTIMIZE__)
+        [durations sortUsingSelector:@selector(compare:)];
+        XCTAssertLessThan([[durations objectAtIndex:[durations count] / 2] doubleValue], PLProjectIndexTestKeystrokeBudget);
+#endif
+}
+
+@end
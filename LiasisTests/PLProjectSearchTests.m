@@ -0,0 +1,281 @@
+/**
+ * \file PLProjectSearchTests.m
+ * \brief Unit tests and a throughput benchmark of the project search.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLProjectSearch.h"
+
+/**
+ * \brief The number of directories and files per directory of the benchmark
+ *        tree, and the size of each file in bytes.
+ */
+static const NSUInteger PLProjectSearchTestDirectoryCount = 8;
+static const NSUInteger PLProjectSearchTestFileCount = 16;
+static const NSUInteger PLProjectSearchTestFileSize = 1024 * 1024;
+
+@interface PLProjectSearchTests : XCTestCase
+{
+        NSString * rootPath;
+}
+
+@end
+
+@implementation PLProjectSearchTests
+
+-(void)setUp
+{
+        [super setUp];
+        rootPath = [[[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]
+                     stringByStandardizingPath] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:rootPath withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+-(void)tearDown
+{
+        [[NSFileManager defaultManager] removeItemAtPath:rootPath error:NULL];
+        [rootPath release];
+        [super tearDown];
+}
+
+/**
+ * \brief Write a file below the root, creating its directory.
+ */
+-(void)writeData:(NSData *)data toRelativePath:(NSString *)relativePath
+{
+        NSString * path = [rootPath stringByAppendingPathComponent:relativePath];
+
+        [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:NULL];
+        XCTAssertTrue([data writeToFile:path atomically:NO]);
+}
+
+-(void)writeString:(NSString *)string toRelativePath:(NSString *)relativePath
+{
+        [self writeData:[string dataUsingEncoding:NSUTF8StringEncoding] toRelativePath:relativePath];
+}
+
+/**
+ * \brief Run a search to completion.
+ *
+ * \return The search, whose matches were added to `matches` ordered by path
+ *         and line number.
+ */
+-(PLProjectSearch *)runSearchForPattern:(NSString *)pattern options:(PLProjectSearchOptions)options matches:(NSMutableArray *)matches
+{
+        PLProjectSearch * search = [PLProjectSearch searchWithDirectoryPath:rootPath pattern:pattern options:options error:NULL];
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:60.0];
+        __block BOOL finished = NO;
+
+        XCTAssertNotNil(search);
+        [search startWithResultHandler:^(NSArray * batch, BOOL searchFinished) {
+                [matches addObjectsFromArray:batch];
+                finished = searchFinished;
+        }];
+        while (finished == NO && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        XCTAssertTrue(finished);
+        [matches sortUsingComparator:^NSComparisonResult(PLProjectSearchMatch * first, PLProjectSearchMatch * second) {
+                NSComparisonResult result = [first.path compare:second.path];
+
+                if (result == NSOrderedSame) {
+                        result = [@(first.lineNumber) compare:@(second.lineNumber)];
+                }
+                return result;
+        }];
+        return search;
+}
+
+#pragma mark - Matching
+
+-(void)testLiteralMatchesReportLinesAndRanges
+{
+        NSMutableArray * matches = [NSMutableArray array];
+        PLProjectSearchMatch * match = nil;
+
+        [self writeString:@"x = 1\r\nname = needle\r\n\r\nneedle()\nlast needle" toRelativePath:@"module.py"];
+        [self runSearchForPattern:@"needle" options:0 matches:matches];
+
+        XCTAssertEqual([matches count], (NSUInteger)3);
+        match = matches[0];
+        XCTAssertEqualObjects(match.path, [rootPath stringByAppendingPathComponent:@"module.py"]);
+        XCTAssertEqual(match.lineNumber, (NSUInteger)2);
+        XCTAssertEqualObjects(match.lineText, @"name = needle");
+        XCTAssertEqual(match.matchRange.location, (NSUInteger)7);
+        XCTAssertEqual(match.matchRange.length, (NSUInteger)6);
+        XCTAssertEqual([matches[1] lineNumber], (NSUInteger)4);
+        XCTAssertEqual([matches[2] lineNumber], (NSUInteger)5);
+        XCTAssertEqualObjects([matches[2] lineText], @"last needle");
+}
+
+-(void)testLiteralIsFoundAtEveryVectorOffset
+{
+        NSMutableArray * matches = [NSMutableArray array];
+        NSMutableString * contents = [NSMutableString string];
+        NSUInteger offset = 0;
+
+        /* Each line places the literal at another offset from the vector loads, ending in the scalar tail */
+        for (offset = 0; offset < 48; offset++) {
+                [contents appendFormat:@"%@%@\n", [@"" stringByPaddingToLength:offset withString:@"e" startingAtIndex:0],
+                 (offset % 2) ? @"NeedLe" : @"needle"];
+        }
+        [contents appendString:@"needl"];
+        [self writeString:contents toRelativePath:@"offsets.py"];
+
+        [self runSearchForPattern:@"needle" options:0 matches:matches];
+        XCTAssertEqual([matches count], (NSUInteger)24);
+
+        [matches removeAllObjects];
+        [self runSearchForPattern:@"NEEDLE" options:PLProjectSearchCaseInsensitive matches:matches];
+        XCTAssertEqual([matches count], (NSUInteger)48);
+        for (offset = 0; offset < [matches count]; offset++) {
+                XCTAssertEqual([matches[offset] lineNumber], offset + 1);
+                XCTAssertEqual([matches[offset] matchRange].location, offset);
+        }
+}
+
+-(void)testRegularExpressionsConfirmCandidateLines
+{
+        NSMutableArray * matches = [NSMutableArray array];
+
+        [self writeString:@"def run(self):\n    # def is a keyword\ndef  stop():\nclass Task:\n" toRelativePath:@"task.py"];
+
+        [self runSearchForPattern:@"def\\s+\\w+\\(" options:PLProjectSearchRegularExpression matches:matches];
+        XCTAssertEqual([matches count], (NSUInteger)2);
+        XCTAssertEqual([matches[0] lineNumber], (NSUInteger)1);
+        XCTAssertEqual([matches[1] lineNumber], (NSUInteger)3);
+        XCTAssertEqual([matches[1] matchRange].length, (NSUInteger)10);
+
+        /* Alternation has no required literal, so every line is matched */
+        [matches removeAllObjects];
+        [self runSearchForPattern:@"class|keyword" options:PLProjectSearchRegularExpression matches:matches];
+        XCTAssertEqual([matches count], (NSUInteger)2);
+        XCTAssertEqual([matches[0] lineNumber], (NSUInteger)2);
+        XCTAssertEqual([matches[1] lineNumber], (NSUInteger)4);
+}
+
+-(void)testEscapedCodePointsAreNotRequiredLiterals
+{
+        NSMutableArray * matches = [NSMutableArray array];
+
+        [self writeString:@"x = 'ABC'\ny = '\u00e9t\u00e9'\nz = 'A1'\n41BC\n\001BC\n" toRelativePath:@"escapes.py"];
+
+        /* Each pattern matches a single line, which has none of the escape's operand */
+        for (NSString * pattern in @[@"\\x41BC", @"\\x{41}BC", @"\\0101BC", @"\\u0041BC", @"\\U00000041BC",
+                                     @"\\N{LATIN CAPITAL LETTER A}BC", @"\\u00e9t\\u00e9", @"\\cABC", @"\\QA\\E1"]) {
+                [matches removeAllObjects];
+                [self runSearchForPattern:pattern options:PLProjectSearchRegularExpression matches:matches];
+                XCTAssertEqual([matches count], (NSUInteger)1, @"%@", pattern);
+        }
+
+        [matches removeAllObjects];
+        [self runSearchForPattern:@"\\x41BC" options:PLProjectSearchRegularExpression matches:matches];
+        XCTAssertEqual([[matches firstObject] lineNumber], (NSUInteger)1);
+        XCTAssertEqual([[matches firstObject] matchRange].location, (NSUInteger)5);
+}
+
+-(void)testOptionalNonASCIICharacterIsNotRequired
+{
+        NSMutableArray * matches = [NSMutableArray array];
+
+        [self writeString:@"x = 'caf'\ny = 'caf\u00e9'\nz = 'abcx'\n" toRelativePath:@"accents.py"];
+
+        /* Every byte of the optional character is left out of the required literal */
+        [self runSearchForPattern:@"caf\u00e9?" options:PLProjectSearchRegularExpression matches:matches];
+        XCTAssertEqual([matches count], (NSUInteger)2);
+        XCTAssertEqual([matches[0] lineNumber], (NSUInteger)1);
+        XCTAssertEqual([matches[1] lineNumber], (NSUInteger)2);
+
+        [matches removeAllObjects];
+        [self runSearchForPattern:@"abc\u00e9*x" options:PLProjectSearchRegularExpression matches:matches];
+        XCTAssertEqual([matches count], (NSUInteger)1);
+        XCTAssertEqual([matches[0] lineNumber], (NSUInteger)3);
+}
+
+-(void)testInvalidRegularExpressionIsRejected
+{
+        NSError * error = nil;
+
+        XCTAssertNil([PLProjectSearch searchWithDirectoryPath:rootPath pattern:@"(" options:PLProjectSearchRegularExpression error:&error]);
+        XCTAssertNotNil(error);
+}
+
+-(void)testBinariesAndIgnoredDirectoriesAreSkipped
+{
+        NSMutableArray * matches = [NSMutableArray array];
+        const char binary[] = "needle\0needle";
+
+        [self writeString:@"needle" toRelativePath:@"package/module.py"];
+        [self writeString:@"needle" toRelativePath:@".git/HEAD"];
+        [self writeString:@"needle" toRelativePath:@".hidden.py"];
+        [self writeString:@"needle" toRelativePath:@"__pycache__/module.py"];
+        [self writeString:@"needle" toRelativePath:@"node_modules/index.js"];
+        [self writeString:@"needle" toRelativePath:@"package.egg-info/PKG-INFO"];
+        [self writeData:[NSData dataWithBytes:binary length:sizeof(binary)] toRelativePath:@"module.so"];
+
+        [self runSearchForPattern:@"needle" options:0 matches:matches];
+        XCTAssertEqual([matches count], (NSUInteger)1);
+        XCTAssertEqualObjects([matches[0] path], [rootPath stringByAppendingPathComponent:@"package/module.py"]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Search a synthetic tree for a rare literal and report the throughput
+ *        in GB/s.
+ */
+-(void)testSearchThroughputPerformance
+{
+        NSString * line = @"        result = self.compute(value, options=None)  # keep the cache warm\n";
+        NSMutableData * contents = [NSMutableData dataWithCapacity:PLProjectSearchTestFileSize];
+        NSData * lineData = [line dataUsingEncoding:NSUTF8StringEncoding];
+        __block double bestThroughput = 0.0;
+        NSUInteger directory = 0, file = 0;
+
+        while ([contents length] + [lineData length] <= PLProjectSearchTestFileSize) {
+                [contents appendData:lineData];
+        }
+        for (directory = 0; directory < PLProjectSearchTestDirectoryCount; directory++) {
+                for (file = 0; file < PLProjectSearchTestFileCount; file++) {
+                        [self writeData:contents toRelativePath:[NSString stringWithFormat:@"package%lu/module%lu.py",
+                                                                 (unsigned long)directory, (unsigned long)file]];
+                }
+        }
+        [self writeString:@"raise RareSentinelError()" toRelativePath:@"package0/rare.py"];
+
+        [self measureBlock:^{
+                NSMutableArray * matches = [NSMutableArray array];
+                PLProjectSearch * search = [self runSearchForPattern:@"RareSentinel" options:0 matches:matches];
+
+                XCTAssertEqual([matches count], (NSUInteger)1);
+                XCTAssertEqual([search numberOfFilesSearched], PLProjectSearchTestDirectoryCount * PLProjectSearchTestFileCount + 1);
+                bestThroughput = MAX(bestThroughput, [search throughput]);
+        }];
+        NSLog(@"Project search throughput: %.2f GB/s", bestThroughput / 1e9);
+}
+
+@end
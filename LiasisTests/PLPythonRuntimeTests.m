@@ -0,0 +1,152 @@
+/**
+ * \file PLPythonRuntimeTests.m
+ * \brief Unit tests for the embedded Python runtime.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Jason Lomnitz.
+ * \author Danny Nicklas.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLPythonRuntime.h"
+
+/**
+ * \brief The number of threads calling into the interpreter at once.
+ */
+static const size_t PLPythonRuntimeTestThreadCount = 8;
+
+/*
+ * The interpreter can only be initialized once per process, so only the shared
+ * runtime, which the application starts anyway, is ever started. Separate
+ * runtimes are only used before they start.
+ */
+@interface PLPythonRuntimeTests : XCTestCase
+
+@end
+
+@implementation PLPythonRuntimeTests
+
+-(void)runMainLoopForInterval:(NSTimeInterval)interval
+{
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:interval]];
+}
+
+-(void)testNewRuntimeIsStopped
+{
+        PLPythonRuntime * runtime = [[PLPythonRuntime alloc] init];
+
+        XCTAssertEqual(runtime.state, PLPythonRuntimeStateStopped);
+        XCTAssertFalse([runtime isReady]);
+        XCTAssertEqual([runtime initializationDuration], 0.0);
+        [runtime release];
+}
+
+-(void)testShutdownBeforeStartNeverStarts
+{
+        PLPythonRuntime * runtime = [[PLPythonRuntime alloc] init];
+        __block BOOL called = NO;
+
+        XCTAssertTrue([runtime shutdownBeforeDate:[NSDate date]]);
+        XCTAssertEqual(runtime.state, PLPythonRuntimeStateFinished);
+
+        [runtime start];
+        XCTAssertEqual(runtime.state, PLPythonRuntimeStateFinished);
+        XCTAssertFalse([runtime waitUntilReady]);
+        XCTAssertFalse([runtime performWithGIL:^{
+                called = YES;
+        }]);
+        [runtime whenReady:^{
+                called = YES;
+        }];
+        [self runMainLoopForInterval:0.1];
+
+        XCTAssertFalse(called);
+        XCTAssertFalse([runtime isReady]);
+        [runtime release];
+}
+
+-(void)testSharedRuntimeBecomesReady
+{
+        PLPythonRuntime * runtime = [PLPythonRuntime sharedRuntime];
+
+        XCTAssertTrue([runtime waitUntilReady]);
+        XCTAssertTrue([runtime isReady]);
+        XCTAssertEqual(runtime.state, PLPythonRuntimeStateReady);
+        XCTAssertGreaterThan([runtime initializationDuration], 0.0);
+}
+
+-(void)testWhenReadyCallsBackAsynchronouslyOnMainThread
+{
+        PLPythonRuntime * runtime = [PLPythonRuntime sharedRuntime];
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+        __block BOOL called = NO;
+
+        XCTAssertTrue([runtime waitUntilReady]);
+        [runtime whenReady:^{
+                XCTAssertTrue([NSThread isMainThread]);
+                called = YES;
+        }];
+
+        /* Already ready, but still called on a later pass of the main queue */
+        XCTAssertFalse(called);
+        while (called == NO && [timeout timeIntervalSinceNow] > 0) {
+                [self runMainLoopForInterval:0.01];
+        }
+        XCTAssertTrue(called);
+}
+
+-(void)testBlocksHoldingTheGILDoNotOverlap
+{
+        PLPythonRuntime * runtime = [PLPythonRuntime sharedRuntime];
+        __block NSUInteger activeCount = 0, overlapCount = 0, callCount = 0;
+
+        dispatch_apply(PLPythonRuntimeTestThreadCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+                NSUInteger i;
+
+                for (i = 0; i < 50; i++) {
+                        XCTAssertTrue([runtime performWithGIL:^{
+                                if (++activeCount > 1) {
+                                        overlapCount++;
+                                }
+                                usleep(100);
+                                callCount++;
+                                activeCount--;
+                        }]);
+                }
+        });
+
+        XCTAssertEqual(callCount, (NSUInteger)(PLPythonRuntimeTestThreadCount * 50));
+        XCTAssertEqual(overlapCount, (NSUInteger)0);
+}
+
+-(void)testGILCanBeAcquiredAgainWhileHeld
+{
+        PLPythonRuntime * runtime = [PLPythonRuntime sharedRuntime];
+        __block BOOL innerCalled = NO;
+
+        XCTAssertTrue([runtime performWithGIL:^{
+                XCTAssertTrue([runtime performWithGIL:^{
+                        innerCalled = YES;
+                }]);
+        }]);
+        XCTAssertTrue(innerCalled);
+}
+
+@end
@@ -0,0 +1,244 @@
+/**
+ * \file PLSessionManagerTests.m
+ * \brief Unit tests for the session snapshot.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Jason Lomnitz.
+ * \author Danny Nicklas.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLSessionManager.h"
+
+/**
+ * \brief The path of the snapshot of `PLTestSessionManager`.
+ */
+static NSString * PLTestSessionFilePath = nil;
+
+/**
+ * \brief A session manager writing its snapshot to a temporary file.
+ */
+@interface PLTestSessionManager : PLSessionManager
+
+@end
+
+@implementation PLTestSessionManager
+
++(NSString *)sessionFilePath
+{
+        return PLTestSessionFilePath;
+}
+
+@end
+
+/**
+ * \brief Stands in for a window controller, counting its captures.
+ */
+@interface PLTestSessionWindowController : NSObject
+
+@property (retain) PLSessionWindow * window;
+
+@property NSUInteger captureCount;
+
+@end
+
+@implementation PLTestSessionWindowController
+
+-(void)dealloc
+{
+        [_window release];
+        [super dealloc];
+}
+
+-(PLSessionWindow *)sessionWindow
+{
+        self.captureCount++;
+        return self.window;
+}
+
+@end
+
+@interface PLSessionManagerTests : XCTestCase
+{
+        PLTestSessionManager * sessionManager;
+        PLTestSessionWindowController * firstWindowController;
+        PLTestSessionWindowController * secondWindowController;
+}
+
+@end
+
+@implementation PLSessionManagerTests
+
+-(void)setUp
+{
+        PLSessionTab * tab = nil;
+
+        [super setUp];
+        PLTestSessionFilePath = [[[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]
+                                  stringByAppendingPathComponent:@"Session.plsession"] retain];
+        sessionManager = [[PLTestSessionManager alloc] init];
+
+        firstWindowController = [[PLTestSessionWindowController alloc] init];
+        firstWindowController.window = [PLSessionWindow window];
+        firstWindowController.window.frame = NSMakeRect(10.0f, 20.0f, 800.0f, 600.0f);
+        firstWindowController.window.directoryRootPath = @"/tmp/project";
+        firstWindowController.window.expandedPaths = @[@"/tmp/project/package", @"/tmp/project/package/tests"];
+        tab = [PLSessionTab tabWithFileURL:[NSURL fileURLWithPath:@"/tmp/project/main.py"]];
+        tab.selectedRange = NSMakeRange(42, 7);
+        tab.scrollPosition = NSMakePoint(0.0f, 1200.5f);
+        firstWindowController.window.tabs = @[tab, [PLSessionTab tabWithFileURL:[NSURL fileURLWithPath:@"/tmp/project/setup.py"]]];
+        firstWindowController.window.activeTabIndex = 1;
+
+        secondWindowController = [[PLTestSessionWindowController alloc] init];
+        secondWindowController.window = [PLSessionWindow window];
+        secondWindowController.window.frame = NSMakeRect(100.0f, 100.0f, 400.0f, 300.0f);
+        secondWindowController.window.directoryRootPath = @"/tmp/other";
+        secondWindowController.window.activeTabIndex = NSNotFound;
+}
+
+-(void)tearDown
+{
+        [sessionManager release];
+        [firstWindowController release];
+        [secondWindowController release];
+        [[NSFileManager defaultManager] removeItemAtPath:[PLTestSessionFilePath stringByDeletingLastPathComponent] error:NULL];
+        [PLTestSessionFilePath release];
+        PLTestSessionFilePath = nil;
+        [super tearDown];
+}
+
+-(void)addWindowControllers
+{
+        [sessionManager addWindowController:(PLWindowController *)firstWindowController];
+        [sessionManager addWindowController:(PLWindowController *)secondWindowController];
+}
+
+-(void)testRestoredWindowsMatchTheSnapshot
+{
+        NSArray * windows = nil;
+        PLSessionWindow * window = nil;
+        PLSessionTab * tab = nil;
+
+        [self addWindowControllers];
+        [sessionManager saveSession];
+        windows = [sessionManager restoredWindows];
+
+        XCTAssertEqual([windows count], (NSUInteger)2);
+        window = windows[0];
+        XCTAssertTrue(NSEqualRects(window.frame, firstWindowController.window.frame));
+        XCTAssertEqualObjects(window.directoryRootPath, @"/tmp/project");
+        XCTAssertEqualObjects(window.expandedPaths, firstWindowController.window.expandedPaths);
+        XCTAssertEqual(window.activeTabIndex, (NSUInteger)1);
+        XCTAssertEqual([window.tabs count], (NSUInteger)2);
+        tab = window.tabs[0];
+        XCTAssertEqualObjects([tab.fileURL path], @"/tmp/project/main.py");
+        XCTAssertEqual(tab.selectedRange.location, (NSUInteger)42);
+        XCTAssertEqual(tab.selectedRange.length, (NSUInteger)7);
+        XCTAssertEqual(tab.scrollPosition.y, (CGFloat)1200.5f);
+        XCTAssertEqual([window.tabs[1] selectedRange].location, (NSUInteger)NSNotFound);
+
+        window = windows[1];
+        XCTAssertEqualObjects(window.directoryRootPath, @"/tmp/other");
+        XCTAssertEqual([window.tabs count], (NSUInteger)0);
+        XCTAssertEqual(window.activeTabIndex, (NSUInteger)NSNotFound);
+}
+
+-(void)testOnlyChangedWindowsAreCapturedAgain
+{
+        NSDate * timeout = nil;
+
+        [self addWindowControllers];
+        [sessionManager saveSession];
+        XCTAssertEqual(firstWindowController.captureCount, (NSUInteger)1);
+        XCTAssertEqual(secondWindowController.captureCount, (NSUInteger)1);
+
+        /* Changes are coalesced into one save after a delay */
+        firstWindowController.window.directoryRootPath = @"/tmp/moved";
+        [sessionManager windowControllerDidChange:(PLWindowController *)firstWindowController];
+        [sessionManager windowControllerDidChange:(PLWindowController *)firstWindowController];
+        timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+        while (firstWindowController.captureCount == 1 && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+        }
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+        XCTAssertEqual(firstWindowController.captureCount, (NSUInteger)2);
+        XCTAssertEqual(secondWindowController.captureCount, (NSUInteger)1);
+
+        /* The snapshot is written in the background */
+        timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+        while ([[[sessionManager restoredWindows] firstObject] directoryRootPath] &&
+               [[[[sessionManager restoredWindows] firstObject] directoryRootPath] isEqualToString:@"/tmp/moved"] == NO &&
+               [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        XCTAssertEqualObjects([[[sessionManager restoredWindows] firstObject] directoryRootPath], @"/tmp/moved");
+        XCTAssertEqual([[sessionManager restoredWindows] count], (NSUInteger)2);
+}
+
+-(void)testRemovedWindowsAreNotRestored
+{
+        NSArray * windows = nil;
+
+        [self addWindowControllers];
+        [sessionManager removeWindowController:(PLWindowController *)firstWindowController];
+        [sessionManager saveSession];
+        windows = [sessionManager restoredWindows];
+
+        XCTAssertEqual([windows count], (NSUInteger)1);
+        XCTAssertEqualObjects([windows[0] directoryRootPath], @"/tmp/other");
+}
+
+-(void)testSuspendedManagerKeepsTheSnapshot
+{
+        [self addWindowControllers];
+        [sessionManager saveSession];
+        [sessionManager suspend];
+        [sessionManager removeWindowController:(PLWindowController *)firstWindowController];
+        [sessionManager saveSession];
+
+        XCTAssertEqual([[sessionManager restoredWindows] count], (NSUInteger)2);
+}
+
+-(void)testDamagedSnapshotRestoresTheWindowsBeforeTheDamage
+{
+        NSData * data = nil;
+
+        [self addWindowControllers];
+        [sessionManager saveSession];
+        data = [NSData dataWithContentsOfFile:PLTestSessionFilePath];
+        [[data subdataWithRange:NSMakeRange(0, [data length] - 8)] writeToFile:PLTestSessionFilePath atomically:NO];
+
+        XCTAssertEqual([[sessionManager restoredWindows] count], (NSUInteger)1);
+}
+
+-(void)testMissingOrForeignSnapshotRestoresNothing
+{
+        XCTAssertEqual([[sessionManager restoredWindows] count], (NSUInteger)0);
+
+        [[NSFileManager defaultManager] createDirectoryAtPath:[PLTestSessionFilePath stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:NULL];
+        [[@"not a session snapshot" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:PLTestSessionFilePath atomically:NO];
+        XCTAssertEqual([[sessionManager restoredWindows] count], (NSUInteger)0);
+}
+
+@end
@@ -0,0 +1,398 @@
+/**
+ * \file PLSymbolIndexTests.m
+ * \brief Unit tests and benchmarks of the symbol index.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLSymbolIndex+Private.h"
+
+/**
+ * \brief The root of the indexes built in memory. It is never read.
+ */
+static NSString * const PLSymbolIndexTestRoot = @"/PLSymbolIndexTests/project";
+
+/**
+ * \brief The flag of a symbol in an unindented statement.
+ */
+static const uint8_t PLSymbolIndexTestTopLevel = 1;
+
+/**
+ * \brief The number of files of the benchmark index.
+ */
+static const NSUInteger PLSymbolIndexTestFileCount = 20000;
+
+/**
+ * \brief The time allowed to answer one query of the benchmark index, in
+ *        seconds.
+ */
+static const CFTimeInterval PLSymbolIndexTestQueryBudget = 0.005;
+
+/**
+ * \brief The time allowed to index a directory on disk, in seconds.
+ */
+static const NSTimeInterval PLSymbolIndexTestIndexingTimeout = 30.0;
+
+@interface PLSymbolIndexTests : XCTestCase
+{
+        /**
+         * \brief The indexes the close notification was posted for.
+         */
+        NSMutableArray * closedIndexes;
+}
+
+@end
+
+@implementation PLSymbolIndexTests
+
+-(void)setUp
+{
+        [super setUp];
+        closedIndexes = [[NSMutableArray alloc] init];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(symbolIndexDidClose:)
+                                                     name:PLSymbolIndexDidCloseNotification
+                                                   object:nil];
+}
+
+-(void)tearDown
+{
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [closedIndexes release];
+        closedIndexes = nil;
+        [super tearDown];
+}
+
+-(void)symbolIndexDidClose:(NSNotification *)notification
+{
+        [closedIndexes addObject:[notification object]];
+}
+
+/**
+ * \brief Build index data of symbols.
+ *
+ * \param symbols The symbols, each an array of the relative path of its file,
+ *                its name, line, kind, and YES if it is top level. The
+ *                symbols of a file are added together, in the order the files
+ *                first appear.
+ */
+-(NSData *)indexDataWithSymbols:(NSArray *)symbols
+{
+        PLSymbolIndexBuilder * builder = [[[PLSymbolIndexBuilder alloc] initWithRootPath:PLSymbolIndexTestRoot] autorelease];
+        NSMutableArray * relativePaths = [NSMutableArray array];
+        const char * name = NULL;
+        uint32_t fileIndex = 0;
+
+        for (NSArray * symbol in symbols) {
+                if (![relativePaths containsObject:symbol[0]]) {
+                        [relativePaths addObject:symbol[0]];
+                }
+        }
+        for (NSString * relativePath in relativePaths) {
+                fileIndex = [builder addFileAtPath:relativePath contentHash:0 modificationTime:0 size:0];
+                for (NSArray * symbol in symbols) {
+                        if (![symbol[0] isEqualToString:relativePath]) {
+                                continue;
+                        }
+                        name = [symbol[1] UTF8String];
+                        [builder addSymbolNamed:name
+                                         length:strlen(name)
+                                      fileIndex:fileIndex
+                                           line:[symbol[2] unsignedIntValue]
+                                           kind:[symbol[3] unsignedCharValue]
+                                          flags:[symbol[4] boolValue] ? PLSymbolIndexTestTopLevel : 0];
+                }
+        }
+        return [builder dataWithLastEventIdentifier:0 eventHistoryIdentifier:nil];
+}
+
+/**
+ * \brief Create an index that is never opened or watched, searching symbols.
+ */
+-(PLSymbolIndex *)indexWithSymbols:(NSArray *)symbols
+{
+        PLSymbolIndex * index = [[[PLSymbolIndex alloc] initWithDirectoryPath:PLSymbolIndexTestRoot] autorelease];
+
+        [index setSnapshot:[[[PLSymbolIndexSnapshot alloc] initWithData:[self indexDataWithSymbols:symbols]
+                                                               rootPath:PLSymbolIndexTestRoot] autorelease]];
+        return index;
+}
+
+/**
+ * \brief The relative paths and lines of locations, as "path:line".
+ */
+-(NSArray *)descriptionsOfLocations:(NSArray *)locations
+{
+        NSMutableArray * descriptions = [NSMutableArray array];
+
+        for (PLSymbolLocation * location in locations) {
+                XCTAssertTrue([location.path hasPrefix:PLSymbolIndexTestRoot]);
+                [descriptions addObject:[NSString stringWithFormat:@"%@:%lu",
+                                         [location.path substringFromIndex:[PLSymbolIndexTestRoot length] + 1],
+                                         (unsigned long)location.line]];
+        }
+        return descriptions;
+}
+
+/**
+ * \brief Run the main run loop until a condition holds or the indexing
+ *        timeout passes.
+ */
+-(BOOL)waitUntil:(BOOL (^)(void))condition
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:PLSymbolIndexTestIndexingTimeout];
+
+        while (!condition() && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+        }
+        return condition();
+}
+
+#pragma mark - Queries
+
+-(void)testDefinitionsAreOrderedByKindThenTopLevel
+{
+        PLSymbolIndex * index = [self indexWithSymbols:@[@[@"a.py", @"spam", @3, @(PLPythonSymbolVariable), @YES],
+                                                         @[@"a.py", @"spam", @7, @(PLPythonSymbolFunction), @YES],
+                                                         @[@"b.py", @"spam", @10, @(PLPythonSymbolFunction), @NO],
+                                                         @[@"c.py", @"spam", @1, @(PLPythonSymbolClass), @YES],
+                                                         @[@"c.py", @"eggs", @2, @(PLPythonSymbolFunction), @NO]]];
+        NSArray * locations = [index definitionsOfSymbolNamed:@"spam" maximumCount:10];
+
+        XCTAssertTrue([index isReady]);
+        XCTAssertEqual([index numberOfFiles], (NSUInteger)3);
+        XCTAssertEqualObjects([self descriptionsOfLocations:locations], (@[@"c.py:1", @"a.py:7", @"b.py:10", @"a.py:3"]));
+        XCTAssertEqual([locations[0] kind], PLPythonSymbolClass);
+        XCTAssertTrue([locations[1] isTopLevel]);
+        XCTAssertFalse([locations[2] isTopLevel]);
+        XCTAssertEqualObjects([locations[3] name], @"spam");
+
+        /* The best definitions are kept when there are too many */
+        XCTAssertEqualObjects([self descriptionsOfLocations:[index definitionsOfSymbolNamed:@"spam" maximumCount:2]], (@[@"c.py:1", @"a.py:7"]));
+        XCTAssertEqual([[index definitionsOfSymbolNamed:@"ham" maximumCount:10] count], (NSUInteger)0);
+}
+
+-(void)testDefinitionsMatchTheCaseOfTheName
+{
+        PLSymbolIndex * index = [self indexWithSymbols:@[@[@"a.py", @"Spam", @1, @(PLPythonSymbolClass), @YES],
+                                                         @[@"b.py", @"spam", @4, @(PLPythonSymbolVariable), @YES],
+                                                         @[@"c.py", @"SPAM", @9, @(PLPythonSymbolVariable), @YES]]];
+
+        XCTAssertEqualObjects([self descriptionsOfLocations:[index definitionsOfSymbolNamed:@"Spam" maximumCount:10]], (@[@"a.py:1"]));
+        XCTAssertEqualObjects([self descriptionsOfLocations:[index definitionsOfSymbolNamed:@"spam" maximumCount:10]], (@[@"b.py:4"]));
+        XCTAssertEqualObjects([self descriptionsOfLocations:[index definitionsOfSymbolNamed:@"SPAM" maximumCount:10]], (@[@"c.py:9"]));
+        XCTAssertEqual([[index definitionsOfSymbolNamed:@"sPam" maximumCount:10] count], (NSUInteger)0);
+}
+
+-(void)testReferencesAndImportsAreKeptApartFromDefinitions
+{
+        PLSymbolIndex * index = [self indexWithSymbols:@[@[@"a.py", @"os.path", @1, @(PLPythonSymbolImport), @YES],
+                                                         @[@"a.py", @"join", @5, @(PLPythonSymbolReference), @NO],
+                                                         @[@"a.py", @"join", @8, @(PLPythonSymbolReference), @NO],
+                                                         @[@"b.py", @"join", @2, @(PLPythonSymbolFunction), @YES],
+                                                         @[@"b.py", @"join", @6, @(PLPythonSymbolReference), @NO],
+                                                         @[@"c.py", @"os.path", @3, @(PLPythonSymbolImport), @YES]]];
+
+        /* Only the first reference of a file is kept */
+        XCTAssertEqualObjects([self descriptionsOfLocations:[index referencesToSymbolNamed:@"join" maximumCount:10]], (@[@"a.py:5", @"b.py:6"]));
+        XCTAssertEqualObjects([self descriptionsOfLocations:[index definitionsOfSymbolNamed:@"join" maximumCount:10]], (@[@"b.py:2"]));
+        XCTAssertEqualObjects([self descriptionsOfLocations:[index importsOfModuleNamed:@"os.path" maximumCount:10]], (@[@"a.py:1", @"c.py:3"]));
+        XCTAssertEqual([[index definitionsOfSymbolNamed:@"os.path" maximumCount:10] count], (NSUInteger)0);
+        XCTAssertEqual([[index referencesToSymbolNamed:@"join" maximumCount:1] count], (NSUInteger)1);
+}
+
+-(void)testPrefixSearchIgnoresCase
+{
+        PLSymbolIndex * index = [self indexWithSymbols:@[@[@"a.py", @"Parser", @1, @(PLPythonSymbolClass), @YES],
+                                                         @[@"a.py", @"parse", @20, @(PLPythonSymbolFunction), @YES],
+                                                         @[@"b.py", @"parse_args", @3, @(PLPythonSymbolFunction), @YES],
+                                                         @[@"b.py", @"pars", @1, @(PLPythonSymbolVariable), @YES],
+                                                         @[@"b.py", @"parsing", @7, @(PLPythonSymbolReference), @NO],
+                                                         @[@"b.py", @"other", @9, @(PLPythonSymbolFunction), @YES]]];
+        NSArray * locations = [index definitionsWithPrefix:@"PARS" maximumCount:10];
+        NSMutableArray * names = [NSMutableArray array];
+
+        for (PLSymbolLocation * location in locations) {
+                [names addObject:location.name];
+        }
+        XCTAssertEqualObjects(names, (@[@"pars", @"parse", @"parse_args", @"Parser"]));
+        XCTAssertEqual([[index definitionsWithPrefix:@"pars" maximumCount:2] count], (NSUInteger)2);
+        XCTAssertEqual([[index definitionsWithPrefix:@"q" maximumCount:10] count], (NSUInteger)0);
+}
+
+-(void)testDefinedNamesAreEnumeratedWithTheirReferenceCounts
+{
+        PLSymbolIndex * index = [self indexWithSymbols:@[@[@"a.py", @"Spam", @1, @(PLPythonSymbolClass), @YES],
+                                                         @[@"a.py", @"helper", @2, @(PLPythonSymbolReference), @NO],
+                                                         @[@"b.py", @"Spam", @4, @(PLPythonSymbolReference), @NO],
+                                                         @[@"c.py", @"Spam", @6, @(PLPythonSymbolReference), @NO]]];
+        NSMutableDictionary * referenceCounts = [NSMutableDictionary dictionary];
+
+        [index enumerateDefinedNamesUsingBlock:^(const char * name, size_t length, PLPythonSymbolKind kind, BOOL topLevel, NSUInteger referenceCount) {
+                NSString * string = [[[NSString alloc] initWithBytes:name length:length encoding:NSUTF8StringEncoding] autorelease];
+
+                XCTAssertEqual(kind, PLPythonSymbolClass);
+                XCTAssertTrue(topLevel);
+                referenceCounts[string] = @(referenceCount);
+        }];
+        XCTAssertEqualObjects(referenceCounts, (@{@"Spam": @2}));
+}
+
+#pragma mark - Index Files
+
+-(void)testDataOfAnotherRootOrTruncatedDataIsRejected
+{
+        NSData * data = [self indexDataWithSymbols:@[@[@"a.py", @"spam", @1, @(PLPythonSymbolFunction), @YES]]];
+
+        XCTAssertNotNil([[[PLSymbolIndexSnapshot alloc] initWithData:data rootPath:PLSymbolIndexTestRoot] autorelease]);
+        XCTAssertNil([[[PLSymbolIndexSnapshot alloc] initWithData:data rootPath:@"/PLSymbolIndexTests/other"] autorelease]);
+        XCTAssertNil([[[PLSymbolIndexSnapshot alloc] initWithData:[data subdataWithRange:NSMakeRange(0, [data length] - 1)]
+                                                         rootPath:PLSymbolIndexTestRoot] autorelease]);
+        XCTAssertNil([[[PLSymbolIndexSnapshot alloc] initWithData:[data subdataWithRange:NSMakeRange(0, 8)]
+                                                         rootPath:PLSymbolIndexTestRoot] autorelease]);
+}
+
+#pragma mark - Sharing
+
+-(void)testLastReleaseEvictsAndClosesTheIndex
+{
+        NSString * directoryPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+        NSString * source = @"class Spam:\n    def eggs(self):\n        pass\n";
+        PLSymbolIndex * index = nil, * reopenedIndex = nil;
+        NSArray * locations = nil;
+
+        XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL]);
+        XCTAssertTrue([source writeToFile:[directoryPath stringByAppendingPathComponent:@"module.py"] atomically:YES encoding:NSUTF8StringEncoding error:NULL]);
+
+        /* Two windows of the same project share one index */
+        [PLSymbolIndex retainIndexForDirectoryAtPath:directoryPath];
+        [PLSymbolIndex retainIndexForDirectoryAtPath:directoryPath];
+        index = [[[PLSymbolIndex indexForDirectoryAtPath:directoryPath] retain] autorelease];
+        XCTAssertTrue([self waitUntil:^BOOL{
+                return [[index definitionsOfSymbolNamed:@"Spam" maximumCount:10] count] > 0;
+        }]);
+        locations = [index definitionsOfSymbolNamed:@"eggs" maximumCount:10];
+        XCTAssertEqual([locations count], (NSUInteger)1);
+        XCTAssertEqual([[locations firstObject] line], (NSUInteger)2);
+        XCTAssertFalse([[locations firstObject] isTopLevel]);
+        XCTAssertEqual([PLSymbolIndex indexForDirectoryAtPath:directoryPath], index);
+
+        /* The first window closing keeps the index */
+        [PLSymbolIndex releaseIndexForDirectoryAtPath:directoryPath];
+        XCTAssertEqual([PLSymbolIndex indexForDirectoryAtPath:directoryPath], index);
+        XCTAssertEqual([closedIndexes count], (NSUInteger)0);
+
+        /* The last one closes it, and the next window gets a new index */
+        [PLSymbolIndex releaseIndexForDirectoryAtPath:directoryPath];
+        XCTAssertEqualObjects(closedIndexes, (@[index]));
+        [PLSymbolIndex retainIndexForDirectoryAtPath:directoryPath];
+        reopenedIndex = [PLSymbolIndex indexForDirectoryAtPath:directoryPath];
+        XCTAssertNotEqual(reopenedIndex, index);
+        [PLSymbolIndex releaseIndexForDirectoryAtPath:directoryPath];
+        XCTAssertEqual([closedIndexes count], (NSUInteger)2);
+
+        /* Releasing a directory without clients does nothing */
+        [PLSymbolIndex releaseIndexForDirectoryAtPath:directoryPath];
+        XCTAssertEqual([closedIndexes count], (NSUInteger)2);
+
+        [[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+        [[NSFileManager defaultManager] removeItemAtPath:[PLSymbolIndex indexFilePathForDirectoryAtPath:directoryPath] error:NULL];
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Query an index of 20,000 files for definitions, references, and
+ *        completions, reporting the time per query.
+ *
+ * \details Every file defines a class and a method and references `self`, so
+ *          the reference query walks 20,000 entries of one name.
+ */
+-(void)testQueriesOfALargeIndexPerformance
+{
+        PLSymbolIndexBuilder * builder = [[[PLSymbolIndexBuilder alloc] initWithRootPath:PLSymbolIndexTestRoot] autorelease];
+        PLSymbolIndex * index = [[[PLSymbolIndex alloc] initWithDirectoryPath:PLSymbolIndexTestRoot] autorelease];
+        NSMutableArray * durations = [NSMutableArray array];
+        char name[64];
+        __block CFTimeInterval queryTime = 0.0;
+        __block NSUInteger queryCount = 0;
+        NSUInteger file = 0;
+        uint32_t fileIndex = 0;
+        int length = 0;
+
+        for (file = 0; file < PLSymbolIndexTestFileCount; file++) {
+                fileIndex = [builder addFileAtPath:[NSString stringWithFormat:@"package%lu/module%lu.py", (unsigned long)(file / 100), (unsigned long)file]
+                                       contentHash:file
+                                  modificationTime:0
+                                              size:0];
+                [builder addSymbolNamed:"os" length:2 fileIndex:fileIndex line:1 kind:PLPythonSymbolImport flags:PLSymbolIndexTestTopLevel];
+                length = snprintf(name, sizeof(name), "Model%lu", (unsigned long)file);
+                [builder addSymbolNamed:name length:length fileIndex:fileIndex line:3 kind:PLPythonSymbolClass flags:PLSymbolIndexTestTopLevel];
+                length = snprintf(name, sizeof(name), "handle_%lu", (unsigned long)(file % 5000));
+                [builder addSymbolNamed:name length:length fileIndex:fileIndex line:4 kind:PLPythonSymbolFunction flags:0];
+                length = snprintf(name, sizeof(name), "CONSTANT_%lu", (unsigned long)(file % 100));
+                [builder addSymbolNamed:name length:length fileIndex:fileIndex line:2 kind:PLPythonSymbolVariable flags:PLSymbolIndexTestTopLevel];
+                [builder addSymbolNamed:"self" length:4 fileIndex:fileIndex line:4 kind:PLPythonSymbolReference flags:0];
+                [builder addSymbolNamed:"value" length:5 fileIndex:fileIndex line:5 kind:PLPythonSymbolReference flags:0];
+        }
+        [index setSnapshot:[[[PLSymbolIndexSnapshot alloc] initWithData:[builder dataWithLastEventIdentifier:0 eventHistoryIdentifier:nil]
+                                                               rootPath:PLSymbolIndexTestRoot] autorelease]];
+        XCTAssertEqual([index numberOfFiles], PLSymbolIndexTestFileCount);
+
+        [self measureBlock:^{
+                NSDictionary * expectedCounts = @{@"handle_42": @4, @"Model19999": @1, @"CONSTANT_7": @50, @"missing": @0};
+                CFTimeInterval startTime = 0.0, duration = 0.0;
+                NSUInteger count = 0;
+
+                for (NSString * query in expectedCounts) {
+                        startTime = CACurrentMediaTime();
+                        count = [[index definitionsOfSymbolNamed:query maximumCount:50] count];
+                        duration = CACurrentMediaTime() - startTime;
+                        [durations addObject:@(duration)];
+                        queryTime += duration;
+                        XCTAssertEqual(count, [expectedCounts[query] unsignedIntegerValue], @"%@", query);
+                }
+                startTime = CACurrentMediaTime();
+                count = [[index definitionsWithPrefix:@"model1" maximumCount:50] count];
+                duration = CACurrentMediaTime() - startTime;
+                [durations addObject:@(duration)];
+                queryTime += duration;
+                XCTAssertEqual(count, (NSUInteger)50);
+                startTime = CACurrentMediaTime();
+                count = [[index referencesToSymbolNamed:@"self" maximumCount:100] count];
+                duration = CACurrentMediaTime() - startTime;
+                [durations addObject:@(duration)];
+                queryTime += duration;
+                XCTAssertEqual(count, (NSUInteger)100);
+                queryCount += [expectedCounts count] + 2;
+        }];
+        NSLog(@"Symbol index: %.1f us per query of %lu files", queryTime * 1e6 / queryCount, (unsigned long)PLSymbolIndexTestFileCount);
+
+#if defined(__OPTIMIZE__)
+        [durations sortUsingSelector:@selector(compare:)];
+        XCTAssertLessThan([[durations objectAtIndex:[durations count] / 2] doubleValue], PLSymbolIndexTestQueryBudget);
+#endif
+}
+
+@end
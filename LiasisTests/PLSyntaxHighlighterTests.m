@@ -0,0 +1,374 @@
+/**
+ * \file PLSyntaxHighlighterTests.m
+ * \brief Unit tests and benchmarks of the Python lexer and the incremental
+ *        syntax highlighter.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLSyntaxHighlighter.h"
+#import "PLPythonLexer.h"
+#import "PLThemeTable.h"
+
+/**
+ * \brief The number of random edits of the incremental test.
+ */
+static const NSUInteger PLSyntaxHighlighterTestEditCount = 400;
+
+/**
+ * \brief The number of lines of the benchmark text.
+ */
+static const NSUInteger PLSyntaxHighlighterTestLineCount = 100000;
+
+/**
+ * \brief A line of a highlighted text, as laid out by `PLSyntaxHighlighter.m`.
+ */
+struct PLSyntaxLine {
+        NSUInteger start;
+        PLPythonLexerState state;
+        BOOL colored;
+};
+
+@interface PLSyntaxHighlighter (Testing)
+
+-(NSUInteger)lineCount;
+-(struct PLSyntaxLine *)lineAtIndex:(NSUInteger)index;
+-(NSUInteger)startOfLine:(NSUInteger)index;
+
+@end
+
+@interface PLSyntaxHighlighterTests : XCTestCase
+{
+        NSWindow * window;
+        NSTextView * textView;
+}
+
+@end
+
+@implementation PLSyntaxHighlighterTests
+
+-(void)setUp
+{
+        NSScrollView * scrollView = nil;
+        NSSize contentSize;
+
+        [super setUp];
+        window = [[NSWindow alloc] initWithContentRect:NSMakeRect(0.0f, 0.0f, 600.0f, 400.0f)
+                                             styleMask:NSTitledWindowMask
+                                               backing:NSBackingStoreBuffered
+                                                 defer:YES];
+        [window setReleasedWhenClosed:NO];
+        scrollView = [[[NSScrollView alloc] initWithFrame:[[window contentView] bounds]] autorelease];
+        [scrollView setHasVerticalScroller:YES];
+        contentSize = [scrollView contentSize];
+        textView = [[NSTextView alloc] initWithFrame:NSMakeRect(0.0f, 0.0f, contentSize.width, contentSize.height)];
+        [textView setVerticallyResizable:YES];
+        [textView setMaxSize:NSMakeSize(FLT_MAX, FLT_MAX)];
+        [[textView textContainer] setContainerSize:NSMakeSize(contentSize.width, FLT_MAX)];
+        [[textView textContainer] setWidthTracksTextView:YES];
+        [scrollView setDocumentView:textView];
+        [window setContentView:scrollView];
+}
+
+-(void)tearDown
+{
+        [textView release];
+        [window close];
+        [window release];
+        [super tearDown];
+}
+
+/**
+ * \brief Replace the text of the text view.
+ */
+-(void)setText:(NSString *)text
+{
+        NSTextStorage * textStorage = [textView textStorage];
+
+        [textStorage replaceCharactersInRange:NSMakeRange(0, [textStorage length]) withString:text];
+}
+
+/**
+ * \brief Run the main run loop until a highlighter has no pass scheduled or
+ *        running and no line left to lex.
+ */
+-(void)waitForHighlighter:(PLSyntaxHighlighter *)highlighter
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:30.0];
+        BOOL idle = NO;
+
+        while (idle == NO && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.001]];
+                idle = ([[highlighter valueForKey:@"passScheduled"] boolValue] == NO &&
+                        [[highlighter valueForKey:@"passRunning"] boolValue] == NO &&
+                        [[highlighter valueForKey:@"dirtyFrom"] unsignedIntegerValue] == NSNotFound);
+        }
+        XCTAssertTrue(idle);
+}
+
+/**
+ * \brief Assert that the lines cached by a highlighter start where the lines
+ *        of the text view start, with the states of lexing the whole text.
+ */
+-(void)assertHighlighterMatchesAFullLex:(PLSyntaxHighlighter *)highlighter
+{
+        NSString * text = [[textView textStorage] string];
+        NSArray * textLines = [text componentsSeparatedByString:@"\n"];
+        PLPythonLexerState state = PLPythonLexerInitialState;
+        unichar * characters = NULL;
+        NSString * textLine = nil;
+        NSUInteger index = 0, lineStart = 0;
+
+        XCTAssertEqual([highlighter lineCount], [textLines count]);
+        if ([highlighter lineCount] != [textLines count]) {
+                goto exit;
+        }
+        for (index = 0; index < [textLines count]; index++) {
+                textLine = textLines[index];
+                XCTAssertEqual([highlighter startOfLine:index], lineStart, @"Line %lu", (unsigned long)index);
+                XCTAssertTrue(PLPythonLexerStateEqual([highlighter lineAtIndex:index]->state, state),
+                              @"Line %lu starts in string %d with nesting %d instead of string %d with nesting %d", (unsigned long)index,
+                              [highlighter lineAtIndex:index]->state.string, [highlighter lineAtIndex:index]->state.nesting, state.string, state.nesting);
+                characters = realloc(characters, MAX([textLine length], 1) * sizeof(unichar));
+                [textLine getCharacters:characters range:NSMakeRange(0, [textLine length])];
+                state = PLPythonLexLine(characters, [textLine length], state, NULL, NULL);
+                lineStart += [textLine length] + 1;
+        }
+        free(characters);
+
+exit:
+        return;
+}
+
+/**
+ * \brief Lex a line of text.
+ *
+ * \return The state at the start of the next line.
+ */
+-(PLPythonLexerState)lexLine:(NSString *)line state:(PLPythonLexerState)state tokens:(PLPythonToken *)tokens tokenCount:(NSUInteger *)tokenCount
+{
+        unichar characters[256];
+
+        [line getCharacters:characters range:NSMakeRange(0, [line length])];
+        return PLPythonLexLine(characters, [line length], state, tokens, tokenCount);
+}
+
+#pragma mark - Lexer
+
+-(void)testLexerReportsTheColoredTokensOfALine
+{
+        PLPythonToken tokens[64];
+        PLPythonLexerState state;
+        NSUInteger tokenCount = 0;
+
+        state = [self lexLine:@"def spam(x): return 0x1F  # done" state:PLPythonLexerInitialState tokens:tokens tokenCount:&tokenCount];
+        XCTAssertEqual(tokenCount, (NSUInteger)5);
+        XCTAssertEqual(tokens[0].kind, PLPythonTokenKeyword);
+        XCTAssertTrue(tokens[0].location == 0 && tokens[0].length == 3);
+        XCTAssertEqual(tokens[1].kind, PLPythonTokenFunctionName);
+        XCTAssertTrue(tokens[1].location == 4 && tokens[1].length == 4);
+        XCTAssertEqual(tokens[2].kind, PLPythonTokenKeyword);
+        XCTAssertTrue(tokens[2].location == 13 && tokens[2].length == 6);
+        XCTAssertEqual(tokens[3].kind, PLPythonTokenNumber);
+        XCTAssertTrue(tokens[3].location == 20 && tokens[3].length == 4);
+        XCTAssertEqual(tokens[4].kind, PLPythonTokenComment);
+        XCTAssertTrue(tokens[4].location == 26 && tokens[4].length == 6);
+        XCTAssertTrue(PLPythonLexerStateEqual(state, PLPythonLexerInitialState));
+
+        [self lexLine:@"x = rb'\\x00' if None else \"s\"" state:PLPythonLexerInitialState tokens:tokens tokenCount:&tokenCount];
+        XCTAssertEqual(tokenCount, (NSUInteger)5);
+        XCTAssertEqual(tokens[0].kind, PLPythonTokenString);
+        XCTAssertTrue(tokens[0].location == 4 && tokens[0].length == 8);
+        XCTAssertEqual(tokens[2].kind, PLPythonTokenBuiltinConstant);
+        XCTAssertEqual(tokens[4].kind, PLPythonTokenString);
+}
+
+-(void)testLexerStateCarriesStringsAndBracketsAcrossLines
+{
+        PLPythonToken tokens[64];
+        PLPythonLexerState state = PLPythonLexerInitialState;
+        NSUInteger tokenCount = 0;
+
+        state = [self lexLine:@"x = \"\"\"doc" state:state tokens:NULL tokenCount:NULL];
+        XCTAssertEqual(state.string, PLPythonStringTripleDoubleQuote);
+        state = [self lexLine:@"still 'doc' (" state:state tokens:tokens tokenCount:&tokenCount];
+        XCTAssertEqual(state.string, PLPythonStringTripleDoubleQuote);
+        XCTAssertEqual(state.nesting, (uint16_t)0);
+        XCTAssertEqual(tokenCount, (NSUInteger)1);
+        XCTAssertEqual(tokens[0].kind, PLPythonTokenDocstring);
+        XCTAssertTrue(tokens[0].location == 0 && tokens[0].length == 13);
+        state = [self lexLine:@"end\"\"\" + f(1, [2," state:state tokens:NULL tokenCount:NULL];
+        XCTAssertEqual(state.string, PLPythonStringNone);
+        XCTAssertEqual(state.nesting, (uint16_t)2);
+        state = [self lexLine:@"3])" state:state tokens:NULL tokenCount:NULL];
+        XCTAssertTrue(PLPythonLexerStateEqual(state, PLPythonLexerInitialState));
+
+        /* A single quoted string continues only after a backslash */
+        state = [self lexLine:@"s = 'abc\\" state:PLPythonLexerInitialState tokens:NULL tokenCount:NULL];
+        XCTAssertEqual(state.string, PLPythonStringSingleQuote);
+        state = [self lexLine:@"s = 'abc" state:PLPythonLexerInitialState tokens:NULL tokenCount:NULL];
+        XCTAssertEqual(state.string, PLPythonStringNone);
+
+        /* An unknown state equals no state, itself included */
+        state = (PLPythonLexerState){PLPythonStringNone, PLPythonLexerStateUnknown, 0};
+        XCTAssertFalse(PLPythonLexerStateEqual(state, state));
+}
+
+#pragma mark - Incremental Highlighting
+
+-(void)testRandomEditsLeaveTheStatesOfAFullLex
+{
+        NSTextStorage * textStorage = [textView textStorage];
+        NSMutableString * text = [NSMutableString string];
+        NSArray * words = @[@"\"\"\"", @"'", @"(", @")", @"\n", @"\\", @"x", @"# ", @"def f():\n", @"'''\n"];
+        PLSyntaxHighlighter * highlighter = nil;
+        NSUInteger edit = 0, line = 0, location = 0;
+
+        for (line = 0; line < 300; line++) {
+                [text appendString:(line % 7 == 0) ? @"    \"\"\"Docstring.\"\"\"\n" : @"    value = call(x, [1, 2])  # note\n"];
+        }
+        [self setText:text];
+        highlighter = [PLSyntaxHighlighter highlighterWithTextView:textView];
+        [self waitForHighlighter:highlighter];
+        [self assertHighlighterMatchesAFullLex:highlighter];
+
+        srandom(21);
+        for (edit = 0; edit < PLSyntaxHighlighterTestEditCount; edit++) {
+                location = random() % ([textStorage length] + 1);
+                [textStorage replaceCharactersInRange:NSMakeRange(location, random() % ([textStorage length] - location + 1) % 6)
+                                           withString:(random() % 4 == 0) ? @"" : words[random() % [words count]]];
+
+                /* Several edits per pass, as when typing faster than lexing */
+                if (edit % 8 == 0) {
+                        [self waitForHighlighter:highlighter];
+                        [self assertHighlighterMatchesAFullLex:highlighter];
+                }
+        }
+        [self waitForHighlighter:highlighter];
+        [self assertHighlighterMatchesAFullLex:highlighter];
+        [highlighter detach];
+}
+
+-(void)testOpeningATripleQuoteRelexesUntilItCloses
+{
+        NSTextStorage * textStorage = [textView textStorage];
+        NSMutableString * text = [NSMutableString string];
+        PLSyntaxHighlighter * highlighter = nil;
+        NSUInteger line = 0;
+
+        for (line = 0; line < 1000; line++) {
+                [text appendString:@"x = 1\n"];
+        }
+        [self setText:text];
+        highlighter = [PLSyntaxHighlighter highlighterWithTextView:textView];
+        [self waitForHighlighter:highlighter];
+
+        /* Every following line is now in the string */
+        [textStorage replaceCharactersInRange:NSMakeRange(10 * 6, 0) withString:@"\"\"\""];
+        [self waitForHighlighter:highlighter];
+        XCTAssertEqual([highlighter lineAtIndex:11]->state.string, PLPythonStringTripleDoubleQuote);
+        XCTAssertEqual([highlighter lineAtIndex:1000]->state.string, PLPythonStringTripleDoubleQuote);
+
+        /* Closing it at the start of line 20, which the first edit moved by three characters */
+        [textStorage replaceCharactersInRange:NSMakeRange(20 * 6 + 3, 0) withString:@"\"\"\""];
+        [self waitForHighlighter:highlighter];
+        XCTAssertEqual([highlighter lineAtIndex:20]->state.string, PLPythonStringTripleDoubleQuote);
+        XCTAssertEqual([highlighter lineAtIndex:21]->state.string, PLPythonStringNone);
+        XCTAssertEqual([highlighter lineAtIndex:1000]->state.string, PLPythonStringNone);
+        [self assertHighlighterMatchesAFullLex:highlighter];
+        [highlighter detach];
+}
+
+-(void)testVisibleLinesAreColoredUntilDetached
+{
+        PLThemeTable * themeTable = [PLThemeTable sharedThemeTable];
+        NSLayoutManager * layoutManager = [textView layoutManager];
+        PLSyntaxHighlighter * highlighter = nil;
+
+        [self setText:@"def spam():\n    return None\n"];
+        highlighter = [PLSyntaxHighlighter highlighterWithTextView:textView];
+        [self waitForHighlighter:highlighter];
+        XCTAssertTrue([highlighter lineAtIndex:0]->colored);
+        XCTAssertEqualObjects([layoutManager temporaryAttribute:NSForegroundColorAttributeName atCharacterIndex:0 effectiveRange:NULL],
+                              [themeTable color:PLThemeColorKeyword]);
+        XCTAssertEqualObjects([layoutManager temporaryAttribute:NSForegroundColorAttributeName atCharacterIndex:4 effectiveRange:NULL],
+                              [themeTable color:PLThemeColorFunctionName]);
+        XCTAssertEqualObjects([layoutManager temporaryAttribute:NSForegroundColorAttributeName atCharacterIndex:23 effectiveRange:NULL],
+                              [themeTable color:PLThemeColorBuiltinConstant]);
+        XCTAssertEqualObjects([[textView textStorage] attributesAtIndex:0 effectiveRange:NULL],
+                              [[textView textStorage] attributesAtIndex:23 effectiveRange:NULL]);
+
+        [highlighter detach];
+        XCTAssertNil([layoutManager temporaryAttribute:NSForegroundColorAttributeName atCharacterIndex:0 effectiveRange:NULL]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Type in the middle of a 100,000 line module, waiting for each
+ *        keystroke to be lexed and colored, reporting the time per keystroke.
+ *
+ * \details The text view is not ordered in, so this measures the highlighter
+ *          rather than drawing.
+ */
+-(void)testTypingInALargeModulePerformance
+{
+        NSTextStorage * textStorage = [textView textStorage];
+        NSMutableString * text = [NSMutableString string];
+        PLSyntaxHighlighter * highlighter = nil;
+        __block CFTimeInterval typingTime = 0.0;
+        __block NSUInteger typedCount = 0;
+        NSUInteger line = 0, location = 0;
+
+        for (line = 0; line < PLSyntaxHighlighterTestLineCount; line++) {
+                [text appendString:(line % 10 == 0) ? @"def method(self, value=None):\n" : @"    return self.value[1:] + 'x'  # cached\n"];
+        }
+        [self setText:text];
+        highlighter = [PLSyntaxHighlighter highlighterWithTextView:textView];
+        [self waitForHighlighter:highlighter];
+        location = [text length] / 2;
+        location = NSMaxRange([text lineRangeForRange:NSMakeRange(location, 0)]) + 4;
+        [textView scrollRangeToVisible:NSMakeRange(location, 0)];
+        [self waitForHighlighter:highlighter];
+
+        [self measureBlock:^{
+                CFTimeInterval startTime = CACurrentMediaTime();
+                NSUInteger index = 0;
+
+                for (index = 0; index < 100; index++) {
+                        [textStorage replaceCharactersInRange:NSMakeRange(location + index, 0) withString:@"v"];
+                        [self waitForHighlighter:highlighter];
+                }
+                typingTime += CACurrentMediaTime() - startTime;
+                typedCount += 100;
+                [textStorage replaceCharactersInRange:NSMakeRange(location, 100) withString:@""];
+                [self waitForHighlighter:highlighter];
+        }];
+        [self assertHighlighterMatchesAFullLex:highlighter];
+        [highlighter detach];
+        NSLog(@"Syntax highlighting: %.1f us per keystroke in %lu lines",
+              typingTime * 1e6 / typedCount, (unsigned long)PLSyntaxHighlighterTestLineCount);
+}
+
+@end
@@ -0,0 +1,165 @@
+/**
+ * \file PLTabBarItemLayerTests.m
+ * \brief Unit tests and benchmarks of the tab item chrome rendering.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLTabBar.h"
+
+/**
+ * \brief The number of tabs of the sharing test and the benchmark.
+ */
+static const NSUInteger PLTabBarItemLayerTestTabCount = 1000;
+
+@interface PLTabBarItemLayerTests : XCTestCase
+{
+        NSArray * gradientColors;
+}
+
+@end
+
+@implementation PLTabBarItemLayerTests
+
+-(void)setUp
+{
+        CGColorRef bottomColor = CGColorCreateGenericRGB(0.70f, 0.71f, 0.72f, 1.0f);
+        CGColorRef topColor = CGColorCreateGenericRGB(0.80f, 0.81f, 0.82f, 1.0f);
+
+        [super setUp];
+        gradientColors = [@[(id)bottomColor, (id)topColor] retain];
+        CGColorRelease(bottomColor);
+        CGColorRelease(topColor);
+        [PLTabBarItemLayer resetRenderStatistics];
+}
+
+-(void)tearDown
+{
+        [gradientColors release];
+        [super tearDown];
+}
+
+/**
+ * \brief Create tab items with the test gradient, laid out at a size.
+ *
+ * \details Each test uses an odd width that no other test uses, so the
+ *          shared caches start cold for it.
+ */
+-(NSArray *)tabItemsWithCount:(NSUInteger)count size:(CGSize)size
+{
+        NSMutableArray * items = [NSMutableArray arrayWithCapacity:count];
+        PLTabBarItemLayer * item = nil;
+        NSUInteger i = 0;
+
+        [CATransaction begin];
+        [CATransaction setDisableActions:YES];
+        for (i = 0; i < count; i++) {
+                item = [PLTabBarItemLayer layer];
+                item.colors = gradientColors;
+                item.frame = CGRectMake(i * (size.width - 13.0f), 0.0f, size.width, size.height);
+                [item layoutIfNeeded];
+                [items addObject:item];
+        }
+        [CATransaction commit];
+        return items;
+}
+
+#pragma mark - Shared Chrome
+
+-(void)testTabsOfOneSizeAndColorShareOneImageAndPath
+{
+        NSArray * items = [self tabItemsWithCount:PLTabBarItemLayerTestTabCount size:CGSizeMake(137.0f, 21.0f)];
+        PLTabBarRenderStatistics statistics = [PLTabBarItemLayer renderStatistics];
+        id contents = [[[items firstObject] sublayers][0] contents];
+
+        XCTAssertEqual(statistics.imagesRendered, (NSUInteger)1);
+        XCTAssertEqual(statistics.imagesReused, PLTabBarItemLayerTestTabCount - 1);
+        XCTAssertEqual(statistics.pathsCreated, (NSUInteger)1);
+        XCTAssertNotNil(contents);
+        XCTAssertEqual([[[items lastObject] sublayers][0] contents], contents);
+}
+
+-(void)testUnchangedColorsDoNotDrawAgain
+{
+        PLTabBarItemLayer * item = [[self tabItemsWithCount:1 size:CGSizeMake(139.0f, 21.0f)] firstObject];
+
+        item.colors = [[gradientColors copy] autorelease];
+        XCTAssertFalse([item needsLayout]);
+
+        item.color = (CGColorRef)gradientColors[0];
+        XCTAssertTrue([item needsLayout]);
+        [item layoutIfNeeded];
+        item.color = (CGColorRef)gradientColors[0];
+        XCTAssertFalse([item needsLayout]);
+        XCTAssertEqual([PLTabBarItemLayer renderStatistics].imagesRendered, (NSUInteger)2);
+}
+
+-(void)testHitTestingFollowsTheTabShape
+{
+        PLTabBarItemLayer * item = [[self tabItemsWithCount:1 size:CGSizeMake(141.0f, 21.0f)] firstObject];
+
+        XCTAssertTrue([item containsPoint:CGPointMake(70.0f, 8.0f)]);
+        XCTAssertFalse([item containsPoint:CGPointMake(2.0f, 15.0f)]);
+        XCTAssertFalse([item containsPoint:CGPointMake(139.0f, 15.0f)]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Resize 1,000 tabs through a range of widths, as when resizing a
+ *        window, committing each frame to Core Animation.
+ *
+ * \details The tabs are not in a window, so this measures the chrome and
+ *          layout work of each frame rather than compositing. The widths are
+ *          even, leaving the odd ones to the other tests.
+ */
+-(void)testResizingAThousandTabsPerformance
+{
+        NSArray * items = [self tabItemsWithCount:PLTabBarItemLayerTestTabCount size:CGSizeMake(143.0f, 21.0f)];
+        __block NSUInteger frameCount = 0;
+        __block CFTimeInterval totalTime = 0.0;
+
+        [self measureBlock:^{
+                CFTimeInterval startTime = 0.0;
+                CGFloat width = 0.0f;
+                NSUInteger i = 0;
+
+                for (width = 60.0f; width < 200.0f; width += 8.0f) {
+                        startTime = CACurrentMediaTime();
+                        [CATransaction begin];
+                        [CATransaction setDisableActions:YES];
+                        for (i = 0; i < [items count]; i++) {
+                                [items[i] setFrame:CGRectMake(i * (width - 13.0f), 0.0f, width, 21.0f)];
+                                [items[i] layoutIfNeeded];
+                        }
+                        [CATransaction commit];
+                        [CATransaction flush];
+                        totalTime += CACurrentMediaTime() - startTime;
+                        frameCount++;
+                }
+        }];
+        NSLog(@"Tab chrome: %.2f ms per frame of %lu tabs", totalTime * 1000.0 / frameCount, (unsigned long)[items count]);
+}
+
+@end
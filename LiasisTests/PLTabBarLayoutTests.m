@@ -0,0 +1,188 @@
+/**
+ * \file PLTabBarLayoutTests.m
+ * \brief Unit tests and benchmarks of the tab bar layout.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLTabBarLayout.h"
+
+/**
+ * \brief The size of the tab bar under test.
+ */
+static const NSSize PLTabBarLayoutTestBarSize = {1000.0f, 24.0f};
+
+/**
+ * \brief The number of tabs of the benchmark.
+ */
+static const NSUInteger PLTabBarLayoutTestTabCount = 1000;
+
+@interface PLTabBarLayoutTests : XCTestCase
+
+@end
+
+@implementation PLTabBarLayoutTests
+
+/**
+ * \brief Assert that two layouts have the same frames.
+ */
+-(void)assertLayout:(PLTabBarLayout *)layout equalsLayout:(PLTabBarLayout *)expectedLayout
+{
+        NSUInteger index = 0;
+
+        XCTAssertEqual([layout count], [expectedLayout count]);
+        for (index = 0; index < [layout count] && index < [expectedLayout count]; index++) {
+                XCTAssertTrue(NSEqualRects([layout frameAtIndex:index], [expectedLayout frameAtIndex:index]),
+                              @"Frame %lu is %@ instead of %@", (unsigned long)index,
+                              NSStringFromRect([layout frameAtIndex:index]), NSStringFromRect([expectedLayout frameAtIndex:index]));
+        }
+}
+
+/**
+ * \brief Create a layout of a number of tabs laid out at once.
+ */
+-(PLTabBarLayout *)layoutOfTabCount:(NSUInteger)tabCount size:(NSSize)size
+{
+        PLTabBarLayout * layout = [[[PLTabBarLayout alloc] init] autorelease];
+
+        [layout layoutTabCount:tabCount inBarOfSize:size];
+        return layout;
+}
+
+#pragma mark - Frames
+
+-(void)testTabsAreAsWideAsTheMaximumWhenTheyFit
+{
+        PLTabBarLayout * layout = [self layoutOfTabCount:3 size:PLTabBarLayoutTestBarSize];
+
+        XCTAssertEqual([layout tabWidth], PLTabItemMaxWidth);
+        XCTAssertEqual([layout frameAtIndex:0].origin.x, (CGFloat)1.0f);
+        XCTAssertEqual([layout frameAtIndex:1].origin.x, 1.0f + PLTabItemMaxWidth - PLTabItemOverlap);
+        XCTAssertEqual([layout frameAtIndex:2].size.height, PLTabBarLayoutTestBarSize.height - 3.0f);
+        XCTAssertThrows([layout frameAtIndex:3]);
+}
+
+-(void)testTabsShrinkToFitBesideTheAddButton
+{
+        PLTabBarLayout * layout = [self layoutOfTabCount:20 size:PLTabBarLayoutTestBarSize];
+
+        XCTAssertLessThan([layout tabWidth], PLTabItemMaxWidth);
+        XCTAssertLessThanOrEqual(NSMaxX([layout frameAtIndex:19]), PLTabBarLayoutTestBarSize.width - PLTabBarLayoutTestBarSize.height);
+}
+
+-(void)testTabsAreNeverHiddenByTheNextTab
+{
+        PLTabBarLayout * layout = [self layoutOfTabCount:PLTabBarLayoutTestTabCount size:PLTabBarLayoutTestBarSize];
+
+        XCTAssertGreaterThan([layout tabWidth], PLTabItemOverlap);
+        XCTAssertLessThan(NSMinX([layout frameAtIndex:0]), NSMinX([layout frameAtIndex:1]));
+}
+
+#pragma mark - Incremental Layout
+
+-(void)testIncrementalLayoutMatchesAFullLayout
+{
+        PLTabBarLayout * layout = [[[PLTabBarLayout alloc] init] autorelease];
+        NSUInteger tabCount = 0;
+
+        /* Grow and shrink in a bar whose width changes by fractions of a point per tab */
+        for (tabCount = 1; tabCount <= 300; tabCount++) {
+                [layout layoutTabCount:tabCount inBarOfSize:PLTabBarLayoutTestBarSize];
+                [self assertLayout:layout equalsLayout:[self layoutOfTabCount:tabCount size:PLTabBarLayoutTestBarSize]];
+        }
+        for (tabCount = 300; tabCount > 0; tabCount -= 7) {
+                [layout layoutTabCount:tabCount inBarOfSize:NSMakeSize(700.0f + tabCount, 24.0f)];
+                [self assertLayout:layout equalsLayout:[self layoutOfTabCount:tabCount size:NSMakeSize(700.0f + tabCount, 24.0f)]];
+        }
+}
+
+-(void)testOnlyChangedFramesAreReported
+{
+        PLTabBarLayout * layout = [self layoutOfTabCount:3 size:PLTabBarLayoutTestBarSize];
+
+        XCTAssertEqual([layout layoutTabCount:3 inBarOfSize:PLTabBarLayoutTestBarSize], (NSUInteger)NSNotFound);
+        XCTAssertEqual([layout layoutTabCount:4 inBarOfSize:PLTabBarLayoutTestBarSize], (NSUInteger)3);
+        XCTAssertEqual([layout layoutTabCount:2 inBarOfSize:PLTabBarLayoutTestBarSize], (NSUInteger)NSNotFound);
+        XCTAssertEqual([layout layoutTabCount:2 inBarOfSize:NSMakeSize(100.0f, 24.0f)], (NSUInteger)0);
+}
+
+#pragma mark - Hit Testing
+
+-(void)testHitTestingMatchesALinearScan
+{
+        PLTabBarLayout * layout = nil;
+        NSUInteger tabCounts[] = {0, 1, 2, 7, 64, PLTabBarLayoutTestTabCount};
+        NSUInteger i = 0, index = 0, first = 0, last = 0;
+        NSRange range;
+        CGFloat x = 0.0f;
+
+        for (i = 0; i < sizeof(tabCounts) / sizeof(tabCounts[0]); i++) {
+                layout = [self layoutOfTabCount:tabCounts[i] size:PLTabBarLayoutTestBarSize];
+                for (x = -20.0f; x < 16000.0f; x += 3.5f) {
+                        first = NSNotFound;
+                        last = 0;
+                        for (index = 0; index < tabCounts[i]; index++) {
+                                if (NSMinX([layout frameAtIndex:index]) <= x && x < NSMaxX([layout frameAtIndex:index])) {
+                                        first = MIN(first, index);
+                                        last = index + 1;
+                                }
+                        }
+                        range = [layout rangeOfTabsAtLocation:x];
+                        if (first == NSNotFound) {
+                                XCTAssertEqual(range.length, (NSUInteger)0, @"At %g of %lu tabs", x, (unsigned long)tabCounts[i]);
+                        } else {
+                                XCTAssertTrue(NSEqualRanges(range, NSMakeRange(first, last - first)),
+                                              @"At %g of %lu tabs: %@", x, (unsigned long)tabCounts[i], NSStringFromRange(range));
+                        }
+                        index = 0;
+                        while (index < tabCounts[i] && NSMinX([layout frameAtIndex:index]) <= x) {
+                                index++;
+                        }
+                        XCTAssertEqual([layout indexOfFirstTabAfterLocation:x], index);
+                }
+        }
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Resize a bar of 1,000 tabs, then drag the mouse across it.
+ */
+-(void)testLayoutAndHitTestingOfAThousandTabsPerformance
+{
+        [self measureBlock:^{
+                PLTabBarLayout * layout = [[[PLTabBarLayout alloc] init] autorelease];
+                NSUInteger hits = 0;
+                CGFloat width = 0.0f, x = 0.0f;
+
+                for (width = 600.0f; width < 1600.0f; width += 5.0f) {
+                        [layout layoutTabCount:PLTabBarLayoutTestTabCount inBarOfSize:NSMakeSize(width, 24.0f)];
+                }
+                for (x = 0.0f; x < NSMaxX([layout frameAtIndex:PLTabBarLayoutTestTabCount - 1]); x += 0.25f) {
+                        hits += [layout rangeOfTabsAtLocation:x].length;
+                }
+                XCTAssertGreaterThan(hits, (NSUInteger)0);
+        }];
+}
+
+@end
@@ -0,0 +1,198 @@
+/**
+ * \file PLTabBarTests.m
+ * \brief Unit tests and benchmarks of the tab bar model.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLTabBar.h"
+
+/**
+ * \brief The number of tabs of the batch tests and the benchmark.
+ */
+static const NSUInteger PLTabBarTestTabCount = 1000;
+
+@interface PLTabBarTests : XCTestCase
+{
+        PLTabBar * tabBar;
+        NSViewController <PLTabSubviewController> * viewController;
+        NSMutableArray * changeSets;
+}
+
+@end
+
+@implementation PLTabBarTests
+
+-(void)setUp
+{
+        [super setUp];
+        tabBar = [[PLTabBar alloc] init];
+        viewController = (NSViewController <PLTabSubviewController> *)[[NSViewController alloc] init];
+        changeSets = [[NSMutableArray alloc] init];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(tabBarDidChange:)
+                                                     name:PLTabBarDidChangeNotification
+                                                   object:tabBar];
+}
+
+-(void)tearDown
+{
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [changeSets release];
+        [viewController release];
+        [tabBar release];
+        [super tearDown];
+}
+
+-(void)tabBarDidChange:(NSNotification *)notification
+{
+        [changeSets addObject:[[notification userInfo] objectForKey:PLTabBarChangeSetKey]];
+}
+
+/**
+ * \brief Add tab items in one batch.
+ *
+ * \return The tab items added.
+ */
+-(NSArray *)addTabItemsWithCount:(NSUInteger)count
+{
+        NSMutableArray * items = [NSMutableArray arrayWithCapacity:count];
+        NSUInteger i = 0;
+
+        for (i = 0; i < count; i++) {
+                [items addObject:[PLTabBarItemLayer layer]];
+        }
+        [tabBar performBatchUpdates:^{
+                for (PLTabBarItemLayer * item in items) {
+                        [tabBar addTabItem:item withViewController:viewController];
+                }
+        }];
+        return items;
+}
+
+/**
+ * \brief Assert that every tab item knows its own index.
+ */
+-(void)assertIndexesAreCurrent
+{
+        NSUInteger index = 0;
+
+        for (PLTabBarItemLayer * item in tabBar) {
+                XCTAssertEqual([tabBar indexOfTabItem:item], index);
+                XCTAssertEqual([tabBar objectInTabItemsAtIndex:index], item);
+                index++;
+        }
+        XCTAssertEqual(index, [tabBar countOfTabItems]);
+}
+
+#pragma mark - Store
+
+-(void)testTabItemsAreNotCopied
+{
+        NSArray * tabItems = [tabBar tabItems];
+
+        [self addTabItemsWithCount:3];
+        XCTAssertEqual([tabBar tabItems], tabItems);
+        XCTAssertEqual([tabItems count], (NSUInteger)3);
+        XCTAssertEqual([tabBar countOfTabItems], (NSUInteger)3);
+}
+
+-(void)testIndexesAndIdentifiersFollowChanges
+{
+        NSArray * items = [self addTabItemsWithCount:10];
+        PLTabBarItemLayer * movedItem = items[2], * removedItem = items[5];
+        NSUInteger identifier = movedItem.identifier;
+
+        XCTAssertNotEqual(identifier, (NSUInteger)0);
+        [tabBar moveTabItem:movedItem toIndex:8];
+        [tabBar removeTabItem:removedItem];
+        [self assertIndexesAreCurrent];
+        XCTAssertEqual([tabBar indexOfTabItem:movedItem], (NSUInteger)7);
+        XCTAssertEqual([tabBar indexOfTabItem:removedItem], (NSUInteger)NSNotFound);
+        XCTAssertNil([tabBar viewControllerForTabItem:removedItem]);
+        XCTAssertEqual([tabBar viewControllerForTabItem:movedItem], viewController);
+        XCTAssertEqual(movedItem.identifier, identifier);
+        XCTAssertThrows([tabBar moveTabItem:movedItem toIndex:9]);
+}
+
+#pragma mark - Batches
+
+-(void)testBatchPostsOneChangeSet
+{
+        NSArray * items = [self addTabItemsWithCount:PLTabBarTestTabCount];
+        PLTabBarChangeSet * changeSet = nil;
+
+        XCTAssertEqual([changeSets count], (NSUInteger)1);
+        XCTAssertEqual([[[changeSets lastObject] insertedItems] count], PLTabBarTestTabCount);
+        XCTAssertTrue(NSEqualRanges([[changeSets lastObject] changedRange], NSMakeRange(0, PLTabBarTestTabCount)));
+
+        [tabBar performBatchUpdates:^{
+                [tabBar moveTabItem:items[10] toIndex:20];
+                [tabBar performBatchUpdates:^{
+                        [tabBar removeTabItem:items[500]];
+                }];
+                [tabBar removeTabItem:items[500]];
+        }];
+        XCTAssertEqual([changeSets count], (NSUInteger)2);
+        changeSet = [changeSets lastObject];
+        XCTAssertEqualObjects([changeSet movedItems], @[items[10]]);
+        XCTAssertEqualObjects([changeSet removedItems], @[items[500]]);
+        XCTAssertEqual([changeSet changedRange].location, (NSUInteger)10);
+        [self assertIndexesAreCurrent];
+}
+
+-(void)testEmptyBatchPostsNothing
+{
+        [tabBar performBatchUpdates:^{
+                [tabBar removeTabItem:[PLTabBarItemLayer layer]];
+        }];
+        XCTAssertEqual([changeSets count], (NSUInteger)0);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Open 1,000 tabs in one batch, drag one across all of them, and
+ *        enumerate the bar at every step as the tab view controller does.
+ */
+-(void)testDraggingAcrossAThousandTabsPerformance
+{
+        [self measureBlock:^{
+                PLTabBarItemLayer * draggedItem = nil;
+                NSUInteger index = 0, visited = 0;
+
+                [tabBar release];
+                tabBar = [[PLTabBar alloc] init];
+                draggedItem = [[self addTabItemsWithCount:PLTabBarTestTabCount] firstObject];
+                for (index = 1; index < PLTabBarTestTabCount; index++) {
+                        [tabBar moveTabItem:draggedItem toIndex:index];
+                        for (PLTabBarItemLayer * item in tabBar) {
+                                visited += (item == draggedItem);
+                        }
+                }
+                XCTAssertEqual(visited, PLTabBarTestTabCount - 1);
+                XCTAssertEqual([tabBar indexOfTabItem:draggedItem], PLTabBarTestTabCount - 1);
+        }];
+}
+
+@end
@@ -0,0 +1,165 @@
+/**
+ * \file PLTabPlaceholderViewControllerTests.m
+ * \brief Unit tests for the background loading of the documents of tab
+ *        placeholders.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLTabPlaceholderViewController.h"
+
+/**
+ * \brief A placeholder counting the times it opens its document.
+ */
+@interface PLTestCountingPlaceholderViewController : PLTabPlaceholderViewController
+
+@property NSUInteger loadDocumentCount;
+
+@end
+
+@implementation PLTestCountingPlaceholderViewController
+
+-(BOOL)loadDocument
+{
+        self.loadDocumentCount++;
+        return [super loadDocument];
+}
+
+@end
+
+@interface PLTabPlaceholderViewControllerTests : XCTestCase
+{
+        NSString * directoryPath;
+        NSUInteger finishCount;
+}
+
+@end
+
+@implementation PLTabPlaceholderViewControllerTests
+
+-(void)setUp
+{
+        [super setUp];
+        directoryPath = [[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(placeholderDidFinishLoading:)
+                                                     name:PLTabPlaceholderDidFinishLoadingNotification
+                                                   object:nil];
+}
+
+-(void)tearDown
+{
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+        [directoryPath release];
+        [super tearDown];
+}
+
+-(void)placeholderDidFinishLoading:(NSNotification *)notification
+{
+        finishCount++;
+}
+
+-(NSURL *)URLForName:(NSString *)name
+{
+        return [NSURL fileURLWithPath:[directoryPath stringByAppendingPathComponent:name]];
+}
+
+-(PLTestCountingPlaceholderViewController *)placeholderForName:(NSString *)name
+{
+        return [PLTestCountingPlaceholderViewController placeholderWithAddOn:[NSBundle bundleForClass:[self class]]
+                                                                     fileURL:[self URLForName:name]];
+}
+
+-(void)waitForPlaceholder:(PLTabPlaceholderViewController *)placeholder
+{
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+
+        while ([placeholder isLoading] && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+}
+
+-(void)testBackgroundLoadKeepsTheTextWithoutOpeningTheDocument
+{
+        PLTestCountingPlaceholderViewController * placeholder = [self placeholderForName:@"module.py"];
+
+        XCTAssertTrue([@"first\r\nsecond\r\n" writeToURL:[self URLForName:@"module.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+        XCTAssertTrue([placeholder loadDocumentInBackground]);
+        XCTAssertTrue([placeholder isLoading]);
+        [self waitForPlaceholder:placeholder];
+
+        XCTAssertEqual(finishCount, (NSUInteger)1);
+        XCTAssertNil(placeholder.loadingError);
+        XCTAssertEqualObjects(placeholder.loadedText, @"first\nsecond\n");
+        XCTAssertEqualObjects(placeholder.lineEnding, @"\r\n");
+        XCTAssertEqual(placeholder.encoding, (NSStringEncoding)NSUTF8StringEncoding);
+
+        /* The document is only opened when the tab is shown */
+        XCTAssertEqual(placeholder.loadDocumentCount, (NSUInteger)0);
+        XCTAssertNil(placeholder.document);
+        XCTAssertEqualObjects([placeholder.fileURL path], [[self URLForName:@"module.py"] path]);
+
+        /* The loaded text is not read again */
+        XCTAssertFalse([placeholder loadDocumentInBackground]);
+        XCTAssertFalse([placeholder isLoading]);
+}
+
+-(void)testMissingFileSetsTheLoadingError
+{
+        PLTestCountingPlaceholderViewController * placeholder = [self placeholderForName:@"missing.py"];
+
+        [placeholder loadDocumentInBackground];
+        [self waitForPlaceholder:placeholder];
+
+        XCTAssertEqual(finishCount, (NSUInteger)1);
+        XCTAssertNotNil(placeholder.loadingError);
+        XCTAssertNil(placeholder.loadedText);
+        XCTAssertEqual(placeholder.loadDocumentCount, (NSUInteger)0);
+}
+
+-(void)testDocumentThatCannotBeOpenedSetsTheLoadingError
+{
+        PLTestCountingPlaceholderViewController * placeholder = [self placeholderForName:@"missing.py"];
+
+        XCTAssertNil([placeholder createViewController]);
+        XCTAssertNotNil(placeholder.loadingError);
+        XCTAssertEqual(placeholder.loadDocumentCount, (NSUInteger)1);
+}
+
+-(void)testCancelledLoadDoesNotFinish
+{
+        PLTestCountingPlaceholderViewController * placeholder = [self placeholderForName:@"module.py"];
+
+        XCTAssertTrue([@"text" writeToURL:[self URLForName:@"module.py"] atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+        [placeholder loadDocumentInBackground];
+        [placeholder cancelLoadingDocument];
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+        XCTAssertFalse([placeholder isLoading]);
+        XCTAssertEqual(finishCount, (NSUInteger)0);
+        XCTAssertNil(placeholder.loadedText);
+}
+
+@end
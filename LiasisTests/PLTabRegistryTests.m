@@ -0,0 +1,152 @@
+/**
+ * \file PLTabRegistryTests.m
+ * \brief Unit tests for the lookup of tabs by file.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLTabRegistry.h"
+#import "PLTabBar.h"
+
+@interface PLTabRegistryTests : XCTestCase
+{
+        NSString * directoryPath;
+        PLTabRegistry * registry;
+        PLTabViewController * tabViewController;
+        PLTabBarItemLayer * tabItem;
+}
+
+@end
+
+@implementation PLTabRegistryTests
+
+-(void)setUp
+{
+        [super setUp];
+        directoryPath = [[[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]]
+                          stringByResolvingSymlinksInPath] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        registry = [[PLTabRegistry alloc] init];
+
+        /* The registry only compares tab view controllers by pointer */
+        tabViewController = (PLTabViewController *)[[NSObject alloc] init];
+        tabItem = [[PLTabBarItemLayer alloc] init];
+}
+
+-(void)tearDown
+{
+        [tabItem release];
+        [(NSObject *)tabViewController release];
+        [registry release];
+        [[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+        [directoryPath release];
+        [super tearDown];
+}
+
+-(NSURL *)URLForName:(NSString *)name
+{
+        return [NSURL fileURLWithPath:[directoryPath stringByAppendingPathComponent:name]];
+}
+
+-(void)writeFileNamed:(NSString *)name
+{
+        XCTAssertTrue([@"text" writeToURL:[self URLForName:name] atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+}
+
+/**
+ * \brief Replace a file the way an atomic save does, giving it a new inode.
+ */
+-(void)replaceFileNamed:(NSString *)name
+{
+        [self writeFileNamed:@".replacement"];
+        XCTAssertEqual(rename([[[self URLForName:@".replacement"] path] fileSystemRepresentation],
+                              [[[self URLForName:name] path] fileSystemRepresentation]), 0);
+}
+
+-(void)testTabIsFoundByPathAndLink
+{
+        [self writeFileNamed:@"module.py"];
+        [[NSFileManager defaultManager] createSymbolicLinkAtURL:[self URLForName:@"link.py"]
+                                     withDestinationURL:[self URLForName:@"module.py"]
+                                                  error:NULL];
+        [registry setFileURL:[self URLForName:@"module.py"] forTabItem:tabItem inTabViewController:tabViewController];
+
+        XCTAssertEqual([registry tabItemForURL:[self URLForName:@"./module.py"] inTabViewController:nil], tabItem);
+        XCTAssertEqual([registry tabItemForURL:[self URLForName:@"link.py"] inTabViewController:tabViewController], tabItem);
+        XCTAssertNil([registry tabItemForURL:[self URLForName:@"link.py"] inTabViewController:(PLTabViewController *)self]);
+        XCTAssertEqual([registry tabViewControllerForTabItem:tabItem], tabViewController);
+
+        [registry removeTabItem:tabItem];
+        XCTAssertNil([registry tabItemForURL:[self URLForName:@"module.py"] inTabViewController:nil]);
+}
+
+-(void)testRegisteringAgainAfterReplacementFindsTheNewFile
+{
+        [self writeFileNamed:@"module.py"];
+        [[NSFileManager defaultManager] createSymbolicLinkAtURL:[self URLForName:@"link.py"]
+                                     withDestinationURL:[self URLForName:@"module.py"]
+                                                  error:NULL];
+        [registry setFileURL:[self URLForName:@"module.py"] forTabItem:tabItem inTabViewController:tabViewController];
+        [self replaceFileNamed:@"module.py"];
+
+        /* Still found by path, and by link once registered again */
+        XCTAssertEqual([registry tabItemForURL:[self URLForName:@"module.py"] inTabViewController:nil], tabItem);
+        [registry setFileURL:[self URLForName:@"module.py"] forTabItem:tabItem inTabViewController:tabViewController];
+        XCTAssertEqual([registry tabItemForURL:[self URLForName:@"link.py"] inTabViewController:nil], tabItem);
+}
+
+-(void)testStaleIdentityDoesNotFindTheTab
+{
+        [self writeFileNamed:@"module.py"];
+        XCTAssertTrue([[NSFileManager defaultManager] linkItemAtURL:[self URLForName:@"module.py"]
+                                                              toURL:[self URLForName:@"hardlink.py"]
+                                                              error:NULL]);
+        [registry setFileURL:[self URLForName:@"module.py"] forTabItem:tabItem inTabViewController:tabViewController];
+        XCTAssertEqual([registry tabItemForURL:[self URLForName:@"hardlink.py"] inTabViewController:nil], tabItem);
+
+        /* The old inode now only belongs to the hard link, a different file
+         * from the tab's.
+         */
+        [self replaceFileNamed:@"module.py"];
+        XCTAssertNil([registry tabItemForURL:[self URLForName:@"hardlink.py"] inTabViewController:nil]);
+        XCTAssertEqual([registry tabItemForURL:[self URLForName:@"module.py"] inTabViewController:nil], tabItem);
+}
+
+-(void)testStaleTabIsRegisteredUnderItsNewIdentity
+{
+        [self writeFileNamed:@"module.py"];
+        XCTAssertTrue([[NSFileManager defaultManager] linkItemAtURL:[self URLForName:@"module.py"]
+                                                              toURL:[self URLForName:@"hardlink.py"]
+                                                              error:NULL]);
+        [registry setFileURL:[self URLForName:@"module.py"] forTabItem:tabItem inTabViewController:tabViewController];
+        [self replaceFileNamed:@"module.py"];
+        XCTAssertNil([registry tabItemForURL:[self URLForName:@"hardlink.py"] inTabViewController:nil]);
+
+        /* The failed lookup registered the tab under the new inode */
+        [[NSFileManager defaultManager] createSymbolicLinkAtURL:[self URLForName:@"link.py"]
+                                     withDestinationURL:[self URLForName:@"module.py"]
+                                                  error:NULL];
+        XCTAssertEqual([registry tabItemForURL:[self URLForName:@"link.py"] inTabViewController:nil], tabItem);
+}
+
+@end
@@ -0,0 +1,706 @@
+/**
+ * \file PLTabViewControllerTests.m
+ * \brief Unit tests for the loading and unloading of the tabs of the tab view
+ *        controller.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import <QuartzCore/QuartzCore.h>
+#import "PLTabViewController.h"
+#import "PLTabPlaceholderViewController.h"
+#import "PLPieceTableTextStorage.h"
+#import "PLDocumentSaver.h"
+
+/**
+ * \brief The number of tabs opened by the tests, more than the tab view
+ *        controller keeps loaded.
+ */
+static const NSUInteger PLTabViewControllerTestTabCount = 12;
+
+/**
+ * \brief The number of lines of the large document benchmark.
+ */
+static const NSUInteger PLTabViewControllerTestLargeLineCount = 200000;
+
+/**
+ * \brief The number of `PLTestTabSubviewController` instances created.
+ */
+static NSUInteger PLTestTabSubviewControllerCount = 0;
+
+/**
+ * \brief A document holding the text of a file in a temporary directory.
+ */
+@interface PLTestDocument : NSDocument
+
+@property (copy) NSString * text;
+
+-(NSString *)filename;
+
+@end
+
+@implementation PLTestDocument
+
+-(void)dealloc
+{
+        [_text release];
+        [super dealloc];
+}
+
+-(NSString *)filename
+{
+        return [[self fileURL] lastPathComponent];
+}
+
+@end
+
+/**
+ * \brief A document holding the text storage its view shows, which it cannot
+ *        replace.
+ */
+@interface PLTestStorageDocument : PLTestDocument
+{
+        NSTextStorage * textStorage;
+}
+
+-(NSTextStorage *)textStorage;
+
+@end
+
+@implementation PLTestStorageDocument
+
+-(void)dealloc
+{
+        [textStorage release];
+        [super dealloc];
+}
+
+-(NSTextStorage *)textStorage
+{
+        if (textStorage == nil) {
+                textStorage = [[NSTextStorage alloc] initWithString:self.text ? self.text : @""];
+        }
+        return textStorage;
+}
+
+@end
+
+/**
+ * \brief A document holding the text storage its view shows, which it can
+ *        replace.
+ */
+@interface PLTestSharedStorageDocument : PLTestStorageDocument
+
+-(void)setTextStorage:(NSTextStorage *)aTextStorage;
+
+@end
+
+@implementation PLTestSharedStorageDocument
+
+-(void)setTextStorage:(NSTextStorage *)aTextStorage
+{
+        [aTextStorage retain];
+        [textStorage release];
+        textStorage = aTextStorage;
+}
+
+@end
+
+/**
+ * \brief The add on view controller of the tests, showing the text of its
+ *        document in a scrolled text view.
+ *
+ * \details It is the principal class of the test bundle, so placeholders of
+ *          the test bundle create it.
+ */
+@interface PLTestTabSubviewController : NSViewController <PLAddOnExtension>
+
+@property (retain) PLTestDocument * document;
+
+@property (retain) NSFont * font;
+
+@property NSUInteger fontUpdateCount;
+
+@property NSUInteger themeUpdateCount;
+
+@end
+
+@implementation PLTestTabSubviewController
+
++(NSString *)tabSubviewName
+{
+        return @"Test";
+}
+
++(id)viewController
+{
+        return [self viewControllerWithDocument:nil];
+}
+
++(id)viewControllerWithDocument:(id)aDocument
+{
+        PLTestTabSubviewController * viewController = [[[self alloc] initWithNibName:nil bundle:nil] autorelease];
+
+        viewController.document = aDocument;
+        [viewController setTitle:aDocument ? [aDocument filename] : [self tabSubviewName]];
+        PLTestTabSubviewControllerCount++;
+        return viewController;
+}
+
+-(void)dealloc
+{
+        [_document release];
+        [_font release];
+        [super dealloc];
+}
+
+-(void)loadView
+{
+        NSScrollView * scrollView = [[[NSScrollView alloc] initWithFrame:NSMakeRect(0.0f, 0.0f, 400.0f, 300.0f)] autorelease];
+        NSTextView * textView = [[[NSTextView alloc] initWithFrame:NSMakeRect(0.0f, 0.0f, 400.0f, 300.0f)] autorelease];
+
+        if ([self.document isKindOfClass:[PLTestStorageDocument class]]) {
+                [[textView layoutManager] replaceTextStorage:[(PLTestStorageDocument *)self.document textStorage]];
+        } else {
+                [textView setString:self.document.text ? self.document.text : @""];
+        }
+        [scrollView setDocumentView:textView];
+        [self setView:scrollView];
+}
+
+-(NSTextView *)textView
+{
+        return [(NSScrollView *)[self view] documentView];
+}
+
+-(void)updateThemeManager
+{
+        self.themeUpdateCount++;
+}
+
+-(void)updateFont:(NSFont *)aFont
+{
+        self.font = aFont;
+        self.fontUpdateCount++;
+}
+
+-(BOOL)tabSubviewShouldClose:(id)sender
+{
+        return YES;
+}
+
+-(IBAction)saveFile:(id)sender
+{
+        return;
+}
+
+-(IBAction)saveFileAs:(id)sender
+{
+        return;
+}
+
+@end
+
+/**
+ * \brief A placeholder whose document stands in for the document
+ *        `PLDocumentManager` has open for its file.
+ */
+@interface PLTestOpenDocumentPlaceholderViewController : PLTabPlaceholderViewController
+
+@property (retain) PLTestDocument * openDocument;
+
+@property BOOL opened;
+
+@end
+
+@implementation PLTestOpenDocumentPlaceholderViewController
+
+-(void)dealloc
+{
+        [_openDocument release];
+        [super dealloc];
+}
+
+-(id)document
+{
+        return self.opened ? self.openDocument : nil;
+}
+
+-(BOOL)loadDocument
+{
+        [self cancelLoadingDocument];
+        self.opened = YES;
+        return self.openDocument != nil;
+}
+
+@end
+
+@interface PLTabViewController (Testing)
+
+-(void)updateFontOfNextStaleTab;
+
+-(void)saveTabItems:(NSArray *)tabItems;
+
+@end
+
+/**
+ * \brief A tab view controller exposing its tab bar.
+ */
+@interface PLTestTabViewController : PLTabViewController
+
+-(PLTabBar *)testTabBar;
+
+@end
+
+@implementation PLTestTabViewController
+
+-(PLTabBar *)testTabBar
+{
+        return tabBar;
+}
+
+@end
+
+@interface PLTabViewControllerTests : XCTestCase
+{
+        NSString * directoryPath;
+        PLTestTabViewController * tabViewController;
+        NSMutableArray * documents;
+}
+
+@end
+
+@implementation PLTabViewControllerTests
+
+-(void)setUp
+{
+        NSString * path = nil;
+        PLTestDocument * document = nil;
+        NSUInteger i = 0;
+
+        [super setUp];
+        directoryPath = [[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]] retain];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+        documents = [[NSMutableArray alloc] init];
+        for (i = 0; i < PLTabViewControllerTestTabCount; i++) {
+                path = [directoryPath stringByAppendingPathComponent:[NSString stringWithFormat:@"%lu.txt", (unsigned long)i]];
+                document = [[[PLTestDocument alloc] init] autorelease];
+                document.text = [NSString stringWithFormat:@"Document %lu\nsecond line\nthird line\n", (unsigned long)i];
+                [document.text writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+                [document setFileURL:[NSURL fileURLWithPath:path]];
+                [documents addObject:document];
+        }
+        tabViewController = [PLTestTabViewController tabViewController];
+        PLTestTabSubviewControllerCount = 0;
+}
+
+-(void)tearDown
+{
+        [tabViewController release];
+        [documents release];
+        [[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+        [directoryPath release];
+        [super tearDown];
+}
+
+-(NSBundle *)addOn
+{
+        return [NSBundle bundleForClass:[PLTestTabSubviewController class]];
+}
+
+/**
+ * \brief Add a background tab for each document.
+ *
+ * \details The first tab becomes active, as there is no active tab.
+ */
+-(void)addTabsOfDocuments
+{
+        for (PLTestDocument * document in documents) {
+                [tabViewController addTabWithAddOn:[self addOn] withDocument:document activate:NO];
+        }
+}
+
+-(NSViewController <PLTabSubviewController> *)viewControllerAtIndex:(NSUInteger)index
+{
+        PLTabBar * tabBar = [tabViewController testTabBar];
+
+        return [tabBar viewControllerForTabItem:[tabBar objectInTabItemsAtIndex:index]];
+}
+
+-(void)activateTabAtIndex:(NSUInteger)index
+{
+        PLTabBar * tabBar = [tabViewController testTabBar];
+
+        [tabViewController setActiveTab:[tabBar objectInTabItemsAtIndex:index]];
+}
+
+-(NSUInteger)loadedTabCount
+{
+        NSUInteger index = 0, count = 0;
+
+        for (index = 0; index < [tabViewController numberOfTabs]; index++) {
+                if ([[self viewControllerAtIndex:index] isKindOfClass:[PLTestTabSubviewController class]]) {
+                        count++;
+                }
+        }
+        return count;
+}
+
+/**
+ * \brief Show a tab of the first document, whose file was loaded in the
+ *        background.
+ *
+ * \param text The text of the document open for the file.
+ *
+ * \param edited Whether the open document has unsaved changes.
+ *
+ * \return The text view of the tab.
+ */
+-(NSTextView *)textViewOfBackgroundLoadedTabWithOpenText:(NSString *)text edited:(BOOL)edited
+{
+        PLTestOpenDocumentPlaceholderViewController * placeholder = nil;
+        NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:5.0];
+
+        placeholder = [PLTestOpenDocumentPlaceholderViewController placeholderWithAddOn:[self addOn] fileURL:[documents[0] fileURL]];
+        placeholder.openDocument = documents[0];
+        placeholder.openDocument.text = text;
+        if (edited) {
+                [placeholder.openDocument updateChangeCount:NSChangeDone];
+        }
+        [placeholder loadDocumentInBackground];
+        while ([placeholder isLoading] && [timeout timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        }
+        XCTAssertEqualObjects(placeholder.loadedText, @"Document 0\nsecond line\nthird line\n");
+        XCTAssertFalse(placeholder.opened);
+
+        [tabViewController addTabWithViewController:placeholder activate:YES];
+        XCTAssertTrue(placeholder.opened);
+        XCTAssertTrue([[self viewControllerAtIndex:0] isKindOfClass:[PLTestTabSubviewController class]]);
+        return [(PLTestTabSubviewController *)[self viewControllerAtIndex:0] textView];
+}
+
+-(void)testBackgroundLoadedTextIsShownForAnUnchangedDocument
+{
+        NSTextView * textView = [self textViewOfBackgroundLoadedTabWithOpenText:@"Read again" edited:NO];
+
+        XCTAssertEqualObjects([textView string], @"Document 0\nsecond line\nthird line\n");
+}
+
+-(void)testOpenDocumentWithUnsavedChangesShowsItsText
+{
+        NSTextView * textView = [self textViewOfBackgroundLoadedTabWithOpenText:@"Unsaved changes\n" edited:YES];
+
+        XCTAssertEqualObjects([textView string], @"Unsaved changes\n");
+}
+
+/**
+ * \brief Show a tab of a document holding the storage of its text view.
+ *
+ * \return The text view of the tab.
+ */
+-(NSTextView *)textViewOfTabOfStorageDocument:(PLTestStorageDocument *)document
+{
+        document.text = @"Document\n";
+        [document setFileURL:[documents[0] fileURL]];
+        [tabViewController addTabWithAddOn:[self addOn] withDocument:document activate:YES];
+        XCTAssertTrue([[self viewControllerAtIndex:0] isKindOfClass:[PLTestTabSubviewController class]]);
+        return [(PLTestTabSubviewController *)[self viewControllerAtIndex:0] textView];
+}
+
+-(void)testDocumentSharesTheTextStorageOfItsTab
+{
+        PLTestSharedStorageDocument * document = [[[PLTestSharedStorageDocument alloc] init] autorelease];
+        NSTextView * textView = [self textViewOfTabOfStorageDocument:document];
+
+        XCTAssertTrue([[textView textStorage] isKindOfClass:[PLPieceTableTextStorage class]]);
+        XCTAssertEqual([document textStorage], [textView textStorage]);
+
+        /* Edits in the tab are the document's text */
+        [textView insertText:@"Edited " replacementRange:NSMakeRange(0, 0)];
+        XCTAssertEqualObjects([[document textStorage] string], @"Edited Document\n");
+}
+
+-(void)testTextStorageIsKeptForADocumentThatCannotShareAnother
+{
+        PLTestStorageDocument * document = [[[PLTestStorageDocument alloc] init] autorelease];
+        NSTextView * textView = [self textViewOfTabOfStorageDocument:document];
+
+        XCTAssertFalse([[textView textStorage] isKindOfClass:[PLPieceTableTextStorage class]]);
+        XCTAssertEqual([document textStorage], [textView textStorage]);
+        XCTAssertEqualObjects([textView string], @"Document\n");
+}
+
+-(void)testBackgroundTabsAreNotLoadedUntilActivated
+{
+        NSViewController <PLTabSubviewController> * viewController = nil;
+
+        [self addTabsOfDocuments];
+
+        XCTAssertEqual([tabViewController numberOfTabs], PLTabViewControllerTestTabCount);
+        XCTAssertEqual(PLTestTabSubviewControllerCount, (NSUInteger)1);
+        XCTAssertTrue([[self viewControllerAtIndex:0] isKindOfClass:[PLTestTabSubviewController class]]);
+        viewController = [self viewControllerAtIndex:1];
+        XCTAssertTrue([viewController isKindOfClass:[PLTabPlaceholderViewController class]]);
+        XCTAssertEqual([viewController document], documents[1]);
+        XCTAssertEqualObjects([viewController title], @"1.txt");
+
+        [self activateTabAtIndex:1];
+        viewController = [self viewControllerAtIndex:1];
+        XCTAssertTrue([viewController isKindOfClass:[PLTestTabSubviewController class]]);
+        XCTAssertEqual([viewController document], documents[1]);
+        XCTAssertEqual(PLTestTabSubviewControllerCount, (NSUInteger)2);
+}
+
+-(void)testLeastRecentlyActiveTabsAreUnloadedKeepingTheirDocuments
+{
+        NSUInteger index = 0;
+
+        [self addTabsOfDocuments];
+        for (index = 0; index < PLTabViewControllerTestTabCount; index++) {
+                [self activateTabAtIndex:index];
+        }
+
+        XCTAssertEqual([self loadedTabCount], (NSUInteger)8);
+        for (index = 0; index < PLTabViewControllerTestTabCount; index++) {
+                XCTAssertEqual([[self viewControllerAtIndex:index] isKindOfClass:[PLTabPlaceholderViewController class]],
+                               (BOOL)(index < PLTabViewControllerTestTabCount - 8));
+                XCTAssertEqual([[self viewControllerAtIndex:index] document], documents[index]);
+        }
+
+        /* Activating an unloaded tab loads it and unloads the least recent */
+        [self activateTabAtIndex:0];
+        XCTAssertTrue([[self viewControllerAtIndex:0] isKindOfClass:[PLTestTabSubviewController class]]);
+        XCTAssertEqual([[self viewControllerAtIndex:0] document], documents[0]);
+        XCTAssertTrue([[self viewControllerAtIndex:PLTabViewControllerTestTabCount - 8] isKindOfClass:[PLTabPlaceholderViewController class]]);
+        XCTAssertEqual([self loadedTabCount], (NSUInteger)8);
+}
+
+-(void)testUnloadedTabKeepsItsSelection
+{
+        PLTestTabSubviewController * viewController = nil;
+        NSUInteger index = 0;
+
+        [self addTabsOfDocuments];
+        viewController = (PLTestTabSubviewController *)[self viewControllerAtIndex:0];
+        [[viewController textView] setSelectedRange:NSMakeRange(12, 6)];
+        for (index = 1; index < PLTabViewControllerTestTabCount; index++) {
+                [self activateTabAtIndex:index];
+        }
+        XCTAssertTrue([[self viewControllerAtIndex:0] isKindOfClass:[PLTabPlaceholderViewController class]]);
+        XCTAssertEqual([(PLTabPlaceholderViewController *)[self viewControllerAtIndex:0] selectedRange].location, (NSUInteger)12);
+
+        [self activateTabAtIndex:0];
+        viewController = (PLTestTabSubviewController *)[self viewControllerAtIndex:0];
+        XCTAssertEqual([[viewController textView] selectedRange].location, (NSUInteger)12);
+        XCTAssertEqual([[viewController textView] selectedRange].length, (NSUInteger)6);
+}
+
+-(void)testClosingActiveTabLoadsOnlyTheNextTab
+{
+        [self addTabsOfDocuments];
+        [tabViewController closeActiveTab];
+
+        XCTAssertEqual([tabViewController numberOfTabs], PLTabViewControllerTestTabCount - 1);
+        XCTAssertEqual(PLTestTabSubviewControllerCount, (NSUInteger)2);
+        XCTAssertTrue([[self viewControllerAtIndex:0] isKindOfClass:[PLTestTabSubviewController class]]);
+        XCTAssertEqual([[self viewControllerAtIndex:0] document], documents[1]);
+        XCTAssertTrue([[self viewControllerAtIndex:1] isKindOfClass:[PLTabPlaceholderViewController class]]);
+}
+
+-(void)testThemeIsAppliedToBackgroundTabsWhenActivated
+{
+        PLTestTabSubviewController * activeViewController = nil, * backgroundViewController = nil;
+        NSUInteger themeUpdateCount = 0;
+
+        [self addTabsOfDocuments];
+        [self activateTabAtIndex:1];
+        [self activateTabAtIndex:0];
+        activeViewController = (PLTestTabSubviewController *)[self viewControllerAtIndex:0];
+        backgroundViewController = (PLTestTabSubviewController *)[self viewControllerAtIndex:1];
+        themeUpdateCount = backgroundViewController.themeUpdateCount;
+
+        [tabViewController updateThemeManager];
+        [tabViewController updateThemeManager];
+        XCTAssertEqual(activeViewController.themeUpdateCount, themeUpdateCount + 2);
+        XCTAssertEqual(backgroundViewController.themeUpdateCount, themeUpdateCount);
+
+        /* Stale tabs are updated once, however many times the theme changed */
+        [self activateTabAtIndex:1];
+        XCTAssertEqual(backgroundViewController.themeUpdateCount, themeUpdateCount + 1);
+        [self activateTabAtIndex:0];
+        [self activateTabAtIndex:1];
+        XCTAssertEqual(backgroundViewController.themeUpdateCount, themeUpdateCount + 1);
+}
+
+-(void)testFontIsAppliedToTheActiveTabFirstAndTheOthersOneAtATime
+{
+        NSFont * font = [NSFont userFixedPitchFontOfSize:17.0f];
+        PLTestTabSubviewController * viewControllers[4];
+        NSUInteger index = 0;
+
+        [self addTabsOfDocuments];
+        for (index = 0; index < 4; index++) {
+                [self activateTabAtIndex:index];
+                viewControllers[index] = (PLTestTabSubviewController *)[self viewControllerAtIndex:index];
+        }
+
+        [tabViewController updateFont:font];
+        XCTAssertEqualObjects(viewControllers[3].font, font);
+        for (index = 0; index < 3; index++) {
+                XCTAssertNil(viewControllers[index].font);
+        }
+
+        /* The most recently active tab is updated first */
+        [tabViewController updateFontOfNextStaleTab];
+        XCTAssertEqualObjects(viewControllers[2].font, font);
+        XCTAssertNil(viewControllers[1].font);
+        XCTAssertNil(viewControllers[0].font);
+
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        for (index = 0; index < 4; index++) {
+                XCTAssertEqualObjects(viewControllers[index].font, font);
+                XCTAssertEqual(viewControllers[index].fontUpdateCount, (NSUInteger)1);
+        }
+
+        /* Unloaded tabs get the font when they are loaded */
+        [self activateTabAtIndex:4];
+        XCTAssertEqualObjects([(PLTestTabSubviewController *)[self viewControllerAtIndex:4] font], font);
+}
+
+-(void)testStaleTabIsRelaidOutBeforeItIsShown
+{
+        NSFont * font = [NSFont userFixedPitchFontOfSize:17.0f];
+        PLTestTabSubviewController * viewController = nil;
+
+        [self addTabsOfDocuments];
+        [self activateTabAtIndex:1];
+        [self activateTabAtIndex:2];
+        [self activateTabAtIndex:0];
+        [tabViewController updateFont:font];
+        viewController = (PLTestTabSubviewController *)[self viewControllerAtIndex:1];
+        XCTAssertNil(viewController.font);
+
+        [self activateTabAtIndex:1];
+        XCTAssertEqualObjects(viewController.font, font);
+        XCTAssertEqual(viewController.fontUpdateCount, (NSUInteger)1);
+
+        /* The tab is not updated again when its turn in the queue comes */
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        XCTAssertEqual(viewController.fontUpdateCount, (NSUInteger)1);
+        XCTAssertEqualObjects([(PLTestTabSubviewController *)[self viewControllerAtIndex:2] font], font);
+}
+
+/**
+ * \brief Save the edited document of the active first tab and wait for the
+ *        save to finish.
+ *
+ * \param text Text inserted into the tab after the save started, or nil.
+ */
+-(void)saveFirstTabInsertingText:(NSString *)text
+{
+        PLTestTabSubviewController * viewController = nil;
+
+        [self addTabsOfDocuments];
+        viewController = (PLTestTabSubviewController *)[self viewControllerAtIndex:0];
+        [viewController.document updateChangeCount:NSChangeDone];
+        [[viewController textView] insertText:@"# " replacementRange:NSMakeRange(0, 0)];
+        [tabViewController saveTabItems:@[[[tabViewController testTabBar] objectInTabItemsAtIndex:0]]];
+        if (text) {
+                [[viewController textView] insertText:text replacementRange:NSMakeRange(0, 0)];
+        }
+        [[PLDocumentSaver sharedSaver] waitUntilAllSavesAreFinished];
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        XCTAssertEqualObjects([NSString stringWithContentsOfURL:[documents[0] fileURL] encoding:NSUTF8StringEncoding error:NULL],
+                              @"# Document 0\nsecond line\nthird line\n");
+}
+
+-(void)testSavedDocumentIsMarkedUnedited
+{
+        [self saveFirstTabInsertingText:nil];
+
+        XCTAssertFalse([documents[0] isDocumentEdited]);
+}
+
+-(void)testDocumentEditedDuringItsSaveStaysEdited
+{
+        [self saveFirstTabInsertingText:@"Edited "];
+
+        XCTAssertTrue([documents[0] isDocumentEdited]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * \brief Open a tab of a 200,000 line module and scroll to positions across
+ *        it, reporting the time until the first screen is laid out and the
+ *        time per scrolled screen.
+ *
+ * \details This measures the layout of the editor's text view as configured
+ *          by the tab view controller, which only lays out the text it shows.
+ */
+-(void)testOpeningAndScrollingALargeDocumentPerformance
+{
+        NSMutableString * text = [NSMutableString stringWithCapacity:PLTabViewControllerTestLargeLineCount * 32];
+        __block CFTimeInterval openingTime = 0.0, scrollingTime = 0.0;
+        __block NSUInteger openedCount = 0, scrolledCount = 0;
+        NSUInteger line = 0;
+
+        for (line = 0; line < PLTabViewControllerTestLargeLineCount; line++) {
+                [text appendFormat:(line % 2) ? @"    return value * %lu\n" : @"def function_%lu(value):\n", (unsigned long)line];
+        }
+        [documents[0] setText:text];
+        srandom(22);
+
+        [self measureBlock:^{
+                CFTimeInterval startTime = CACurrentMediaTime();
+                PLTestTabViewController * largeTabViewController = [PLTestTabViewController tabViewController];
+                NSTextView * textView = nil;
+                NSLayoutManager * layoutManager = nil;
+                NSUInteger scroll = 0, length = [text length];
+
+                [largeTabViewController addTabWithAddOn:[self addOn] withDocument:documents[0] activate:YES];
+                textView = [(PLTestTabSubviewController *)[[largeTabViewController testTabBar] viewControllerForTabItem:
+                                                           [[largeTabViewController testTabBar] objectInTabItemsAtIndex:0]] textView];
+                layoutManager = [textView layoutManager];
+                [layoutManager ensureLayoutForBoundingRect:[textView visibleRect] inTextContainer:[textView textContainer]];
+                openingTime += CACurrentMediaTime() - startTime;
+                openedCount++;
+
+                /* Only the first screen has been laid out */
+                XCTAssertLessThan([layoutManager firstUnlaidCharacterIndex], length / 2);
+
+                startTime = CACurrentMediaTime();
+                for (scroll = 0; scroll < 100; scroll++) {
+                        [textView scrollRangeToVisible:NSMakeRange((NSUInteger)random() % length, 0)];
+                        [layoutManager ensureLayoutForBoundingRect:[textView visibleRect] inTextContainer:[textView textContainer]];
+                }
+                scrollingTime += CACurrentMediaTime() - startTime;
+                scrolledCount += 100;
+                [largeTabViewController release];
+        }];
+        NSLog(@"Editor tab: %.2f ms to the first screen, %.2f ms per scrolled screen of %lu lines",
+              openingTime * 1000.0 / openedCount, scrollingTime * 1000.0 / scrolledCount, (unsigned long)PLTabViewControllerTestLargeLineCount);
+}
+
+@end
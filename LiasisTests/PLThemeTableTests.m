@@ -0,0 +1,146 @@
+/**
+ * \file PLThemeTableTests.m
+ * \brief Unit tests for the compiled theme table.
+ *
+ * \copyright Copyright (C) 2012-2014 Jason Lomnitz and Danny Nicklas.
+ *
+ * This file is part of the Python Liasis IDE.
+ *
+ * The Python Liasis IDE is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The Python Liasis IDE is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Python Liasis IDE. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \author Danny Nicklas.
+ * \author Jason Lomnitz.
+ * \date 2012-2014.
+ */
+
+#import <XCTest/XCTest.h>
+#import "PLThemeTable.h"
+
+@interface PLThemeTable (Testing)
+
+-(void)setColor:(PLThemeColor)color toValue:(NSColor *)value;
+
+@end
+
+/**
+ * \brief A theme table counting the colors it resolves.
+ */
+@interface PLTestThemeTable : PLThemeTable
+
+@property NSUInteger resolvedColorCount;
+
+-(BOOL)isStale;
+
+@end
+
+@implementation PLTestThemeTable
+
+-(void)setColor:(PLThemeColor)color toValue:(NSColor *)value
+{
+        self.resolvedColorCount++;
+        [super setColor:color toValue:value];
+}
+
+-(BOOL)isStale
+{
+        return stale;
+}
+
+@end
+
+@interface PLThemeTableTests : XCTestCase
+{
+        PLTestThemeTable * themeTable;
+        NSUInteger notificationCount;
+}
+
+@end
+
+@implementation PLThemeTableTests
+
+-(void)setUp
+{
+        [super setUp];
+        themeTable = [[PLTestThemeTable alloc] init];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(themeTableDidChange:)
+                                                     name:PLThemeTableDidChangeNotification
+                                                   object:themeTable];
+}
+
+-(void)tearDown
+{
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
+        [themeTable release];
+        [super tearDown];
+}
+
+-(void)themeTableDidChange:(NSNotification *)notification
+{
+        notificationCount++;
+}
+
+-(void)testColorsMatchTheThemeManager
+{
+        PLThemeManager * themeManager = [PLThemeManager defaultThemeManager];
+        NSColor * comment = [themeManager getThemeProperty:PLThemeManagerForeground fromGroup:@"Comment"];
+        PLThemeColor color = PLThemeColorBackground;
+
+        XCTAssertEqualObjects([themeTable color:PLThemeColorBackground],
+                              [themeManager getThemeProperty:PLThemeManagerBackground fromGroup:PLThemeManagerSettings]);
+        XCTAssertEqualObjects([themeTable color:PLThemeColorForeground],
+                              [themeManager getThemeProperty:PLThemeManagerForeground fromGroup:PLThemeManagerSettings]);
+        XCTAssertEqualObjects([themeTable color:PLThemeColorComment], comment ?: [themeTable color:PLThemeColorForeground]);
+        XCTAssertEqualObjects([themeTable selectionGradient], [themeManager selectionGradient]);
+        for (color = PLThemeColorBackground; color < PLThemeColorCount; color++) {
+                XCTAssertNotNil([themeTable color:color]);
+        }
+}
+
+-(void)testTableIsCompiledOnceUntilTheThemeChanges
+{
+        XCTAssertTrue([themeTable isStale]);
+        XCTAssertEqual(themeTable.resolvedColorCount, (NSUInteger)0);
+
+        [themeTable color:PLThemeColorKeyword];
+        [themeTable color:PLThemeColorString];
+        [themeTable selectionGradient];
+        XCTAssertFalse([themeTable isStale]);
+        XCTAssertEqual(themeTable.resolvedColorCount, (NSUInteger)PLThemeColorCount);
+
+        /* A change only marks the table, which compiles on its next use */
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLThemeManagerDidChange object:nil];
+        XCTAssertTrue([themeTable isStale]);
+        XCTAssertEqual(themeTable.resolvedColorCount, (NSUInteger)PLThemeColorCount);
+        [themeTable color:PLThemeColorBackground];
+        XCTAssertEqual(themeTable.resolvedColorCount, (NSUInteger)(2 * PLThemeColorCount));
+}
+
+-(void)testChangesInOnePassAreCoalesced
+{
+        NSUInteger index = 0;
+
+        for (index = 0; index < 10; index++) {
+                [[NSNotificationCenter defaultCenter] postNotificationName:PLThemeManagerDidChange object:nil];
+        }
+        XCTAssertEqual(notificationCount, (NSUInteger)0);
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        XCTAssertEqual(notificationCount, (NSUInteger)1);
+
+        [[NSNotificationCenter defaultCenter] postNotificationName:PLThemeManagerDidChange object:nil];
+        [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        XCTAssertEqual(notificationCount, (NSUInteger)2);
+}
+
+@end